@@ -0,0 +1,189 @@
+/*
+  Non-interactive provisioning for the production line, driven by
+  extras/tools/provision.py over the serial port. The host sends a Begin
+  frame with the device id, the device locks the crypto chip if needed and
+  replies with the CSR of a new key. The host has the CSR signed and sends a
+  Cert frame with all the certificate fields, the device writes the device id
+  and the certificate in one go and replies with a Confirm frame holding the
+  signature of its key over SHA256(nonce | device id | serial number).
+  Any failure is reported with an Error frame naming the step.
+
+  The frame format is described in src/utility/provisioning/ProvisioningFrame.h.
+*/
+
+#include <ArduinoIoTCloud.h>
+#include <tls/utility/SHA256.h>
+#include <utility/provisioning/ProvisioningFrame.h>
+#include "ECCX08TLSConfig.h"
+
+ArduinoIoTCloudCertClass Certificate;
+CryptoUtil Crypto;
+ProvisioningFrame Frame;
+String DeviceId;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+}
+
+void loop() {
+  while (Serial.available()) {
+    ProvisioningFrame::Status const status = Frame.feed(Serial.read());
+    if (status == ProvisioningFrame::Status::Error) {
+      sendError("frame");
+    } else if (status == ProvisioningFrame::Status::Complete) {
+      if (Frame.type() == ProvisioningFrameType::Begin) {
+        onBegin();
+      } else if (Frame.type() == ProvisioningFrameType::Cert) {
+        onCert();
+      } else {
+        sendError("type");
+      }
+    }
+  }
+}
+
+void onBegin() {
+  if (!readField(ProvisioningField::DeviceId, DeviceId)) {
+    sendError("device id");
+    return;
+  }
+
+  if (!Crypto.begin()) {
+    sendError("crypto");
+    return;
+  }
+
+  if (!Crypto.locked()) {
+    if (!Crypto.writeConfiguration(DEFAULT_ECCX08_TLS_CONFIG) || !Crypto.lock()) {
+      sendError("lock");
+      return;
+    }
+  }
+
+  if (!Certificate.begin()) {
+    sendError("csr");
+    return;
+  }
+  Certificate.setSubjectCommonName(DeviceId);
+  if (!Crypto.buildCSR(Certificate, CryptoSlot::Key, true)) {
+    sendError("csr");
+    return;
+  }
+
+  uint8_t payload[ProvisioningFrame::MAX_PAYLOAD_SIZE];
+  size_t len = 0;
+  ProvisioningFrame::appendField(payload, sizeof(payload), len, ProvisioningField::Csr, Certificate.bytes(), Certificate.length());
+  sendFrame(ProvisioningFrameType::Csr, payload, len);
+}
+
+void onCert() {
+  String deviceId;
+  uint8_t const * serialNumber = nullptr;
+  uint8_t const * authorityKeyId = nullptr;
+  uint8_t const * signature = nullptr;
+  uint8_t const * nonce = nullptr;
+  size_t serialNumberLen = 0, authorityKeyIdLen = 0, signatureLen = 0, nonceLen = 0;
+  int issueYear = 0, issueMonth = 0, issueDay = 0, issueHour = 0, expireYears = 0;
+
+  bool const isComplete =
+    readField(ProvisioningField::DeviceId, deviceId) && (deviceId == DeviceId) &&
+    readField(ProvisioningField::IssueYear, issueYear) &&
+    readField(ProvisioningField::IssueMonth, issueMonth) &&
+    readField(ProvisioningField::IssueDay, issueDay) &&
+    readField(ProvisioningField::IssueHour, issueHour) &&
+    readField(ProvisioningField::ExpireYears, expireYears) &&
+    Frame.field(ProvisioningField::SerialNumber, serialNumber, serialNumberLen) && (serialNumberLen == CERT_SERIAL_NUMBER_LENGTH) &&
+    Frame.field(ProvisioningField::AuthorityKeyId, authorityKeyId, authorityKeyIdLen) && (authorityKeyIdLen == CERT_AUTHORITY_KEY_ID_LENGTH) &&
+    Frame.field(ProvisioningField::Signature, signature, signatureLen) && (signatureLen == CERT_SIGNATURE_LENGTH) &&
+    Frame.field(ProvisioningField::Nonce, nonce, nonceLen);
+  if (!isComplete) {
+    sendError("fields");
+    return;
+  }
+
+  if (!Crypto.writeDeviceId(DeviceId, CryptoSlot::DeviceId)) {
+    sendError("device id");
+    return;
+  }
+
+  if (!Certificate.begin()) {
+    sendError("cert");
+    return;
+  }
+  Certificate.setSubjectCommonName(DeviceId);
+  Certificate.setIssuerCountryName("US");
+  Certificate.setIssuerOrganizationName("Arduino LLC US");
+  Certificate.setIssuerOrganizationalUnitName("IT");
+  Certificate.setIssuerCommonName("Arduino");
+  Certificate.setSignature(signature, signatureLen);
+  Certificate.setAuthorityKeyId(authorityKeyId, authorityKeyIdLen);
+  Certificate.setSerialNumber(serialNumber, serialNumberLen);
+  Certificate.setIssueYear(issueYear);
+  Certificate.setIssueMonth(issueMonth);
+  Certificate.setIssueDay(issueDay);
+  Certificate.setIssueHour(issueHour);
+  Certificate.setExpireYears(expireYears);
+
+  if (!Crypto.buildCert(Certificate, CryptoSlot::Key) || !Crypto.writeCert(Certificate, CryptoSlot::CompressedCertificate)) {
+    sendError("cert");
+    return;
+  }
+
+  /* Proves that the key of the CSR signs for the device which stored the certificate */
+  byte hash[SHA256::HASH_SIZE];
+  SHA256 sha256;
+  sha256.begin();
+  sha256.update(nonce, nonceLen);
+  sha256.update(reinterpret_cast<uint8_t const *>(DeviceId.c_str()), DeviceId.length());
+  sha256.update(serialNumber, serialNumberLen);
+  sha256.finalize(hash);
+
+  byte confirmation[CERT_SIGNATURE_LENGTH];
+  if (!Crypto.ecSign(CryptoSlot::Key, hash, confirmation)) {
+    sendError("sign");
+    return;
+  }
+
+  uint8_t payload[ProvisioningFrame::FIELD_HEADER_SIZE + CERT_SIGNATURE_LENGTH];
+  size_t len = 0;
+  ProvisioningFrame::appendField(payload, sizeof(payload), len, ProvisioningField::Signature, confirmation, sizeof(confirmation));
+  sendFrame(ProvisioningFrameType::Confirm, payload, len);
+}
+
+bool readField(ProvisioningField const id, String & value) {
+  uint8_t const * data = nullptr;
+  size_t len = 0;
+  if (!Frame.field(id, data, len)) {
+    return false;
+  }
+  value = "";
+  for (size_t i = 0; i < len; i++) {
+    value += static_cast<char>(data[i]);
+  }
+  return value.length() > 0;
+}
+
+bool readField(ProvisioningField const id, int & value) {
+  uint8_t const * data = nullptr;
+  size_t len = 0;
+  if (!Frame.field(id, data, len) || (len != 2)) {
+    return false;
+  }
+  value = data[0] | (data[1] << 8);
+  return true;
+}
+
+void sendFrame(ProvisioningFrameType const type, uint8_t const * payload, size_t const len) {
+  static uint8_t out[ProvisioningFrame::MAX_FRAME_SIZE];
+  size_t const size = ProvisioningFrame::encode(type, payload, len, out, sizeof(out));
+  Serial.write(out, size);
+  Serial.flush();
+}
+
+void sendError(char const * step) {
+  uint8_t payload[32];
+  size_t len = 0;
+  ProvisioningFrame::appendField(payload, sizeof(payload), len, ProvisioningField::Error, reinterpret_cast<uint8_t const *>(step), strlen(step));
+  sendFrame(ProvisioningFrameType::Error, payload, len);
+}
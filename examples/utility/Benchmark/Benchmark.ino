@@ -0,0 +1,145 @@
+/*
+  This sketch measures the cost of ArduinoCloud.update() on the board it runs on.
+
+  Every 10 seconds it prints the number of calls of update(), their average
+  and longest duration in microseconds and the free memory. All boards use
+  the same thing (see thingProperties.h) which changes every second, so that
+  the results of different boards can be compared.
+
+  If the library is built with AIOT_CONFIG_PROFILING_ENABLED it also prints
+  the duration of update() in each state of the connection and of encoding,
+  decoding and sending messages, connecting to the broker including the TLS
+  handshake, synchronising the time and hashing the firmware image, e.g.
+
+    arduino-cli compile --build-property "compiler.cpp.extra_flags=-DAIOT_CONFIG_PROFILING_ENABLED=1" ...
+
+  The durations are measured with micros(), the resolution is 1 us on most boards.
+
+  IMPORTANT:
+  This sketch works with WiFi, GSM, NB and Ethernet enabled boards supported by Arduino IoT Cloud.
+*/
+
+#include "arduino_secrets.h"
+#include "thingProperties.h"
+
+#if defined(ARDUINO_ARCH_MBED)
+  #include <malloc.h>
+#elif defined(ARDUINO_ARCH_SAMD)
+  extern "C" char * sbrk(int incr);
+#endif
+
+static unsigned long const REPORT_INTERVAL_ms = 10 * 1000;
+static unsigned long const CHANGE_INTERVAL_ms = 1000;
+
+static unsigned long report_tick = 0;
+static unsigned long change_tick = 0;
+static unsigned long update_cnt = 0;
+static unsigned long update_total_us = 0;
+static unsigned long update_max_us = 0;
+
+void setup() {
+  /* Initialize serial and wait up to 5 seconds for port to open */
+  Serial.begin(115200);
+  for(unsigned long const serialBeginTime = millis(); !Serial && (millis() - serialBeginTime < 5000); ) { }
+
+  initProperties();
+
+  ArduinoCloud.begin(ArduinoIoTPreferredConnection);
+
+  setDebugMessageLevel(DBG_INFO);
+  ArduinoCloud.printDebugInfo();
+}
+
+void loop() {
+  unsigned long const start_us = micros();
+  ArduinoCloud.update();
+  unsigned long const duration_us = micros() - start_us;
+
+  update_cnt++;
+  update_total_us += duration_us;
+  if (duration_us > update_max_us)
+    update_max_us = duration_us;
+
+  if (millis() - change_tick >= CHANGE_INTERVAL_ms) {
+    change_tick = millis();
+    changeProperties();
+  }
+
+  if (millis() - report_tick >= REPORT_INTERVAL_ms) {
+    report_tick = millis();
+    printReport();
+    update_cnt = 0;
+    update_total_us = 0;
+    update_max_us = 0;
+#ifdef HAS_PROFILING
+    ArduinoCloud.resetProfile();
+#endif
+  }
+}
+
+void changeProperties() {
+  counter_0++;
+  counter_1 += 2;
+  counter_2 += 3;
+  value_0 += 0.5f;
+  value_1 += 1.5f;
+  value_2 += 2.5f;
+  temperature = value_0;
+}
+
+void printDurations(char const * name, unsigned long const cnt, unsigned long const total_us, unsigned long const max_us) {
+  char line[96];
+  snprintf(line, sizeof(line), "%-22s %8lu calls %10lu us avg %10lu us max", name, cnt, cnt ? (total_us / cnt) : 0, max_us);
+  Serial.println(line);
+}
+
+void printMemory() {
+#if defined(ARDUINO_ARCH_ESP32)
+  Serial.print("Free heap: ");
+  Serial.print(ESP.getFreeHeap());
+  Serial.print(" bytes, free stack of loop(): ");
+  Serial.print(uxTaskGetStackHighWaterMark(NULL));
+  Serial.println(" bytes");
+#elif defined(ARDUINO_ARCH_ESP8266)
+  Serial.print("Free heap: ");
+  Serial.print(ESP.getFreeHeap());
+  Serial.print(" bytes, free stack: ");
+  Serial.print(ESP.getFreeContStack());
+  Serial.println(" bytes");
+#elif defined(ARDUINO_ARCH_MBED)
+  struct mallinfo const info = mallinfo();
+  Serial.print("Used heap: ");
+  Serial.print(info.uordblks);
+  Serial.print(" bytes, free stack of the main thread: ");
+  Serial.print(osThreadGetStackSpace(osThreadGetId()));
+  Serial.println(" bytes");
+#elif defined(ARDUINO_ARCH_SAMD)
+  /* Heap and stack grow towards each other */
+  char top;
+  Serial.print("Free memory between heap and stack: ");
+  Serial.print(&top - sbrk(0));
+  Serial.println(" bytes");
+#endif
+}
+
+void printReport() {
+  Serial.println("***** ArduinoCloud.update() *****");
+  printDurations("update()", update_cnt, update_total_us, update_max_us);
+
+#ifdef HAS_PROFILING
+  UpdateProfile const & profile = ArduinoCloud.getProfile();
+  for (uint8_t s = 0; s < UpdateProfile::STATE_CNT; s++) {
+    ProfileCounter const & counter = profile.state(s);
+    if (counter.count())
+      printDurations(ArduinoIoTCloudTCP::getStateName(s), counter.count(), counter.totalMicros(), counter.maxMicros());
+  }
+  for (uint8_t s = 0; s < UpdateProfile::SECTION_CNT; s++) {
+    ProfileSection const section = static_cast<ProfileSection>(s);
+    ProfileCounter const & counter = profile.section(section);
+    if (counter.count())
+      printDurations(UpdateProfile::sectionName(section), counter.count(), counter.totalMicros(), counter.maxMicros());
+  }
+#endif
+
+  printMemory();
+}
@@ -0,0 +1,50 @@
+#if defined(BOARD_HAS_WIFI)
+#elif defined(BOARD_HAS_GSM)
+#elif defined(BOARD_HAS_NB)
+#elif defined(BOARD_HAS_ETHERNET)
+#else
+  #error "Please check Arduino IoT Cloud supported boards list: https://github.com/arduino-libraries/ArduinoIoTCloud/#what"
+#endif
+
+#if defined(BOARD_ESP)
+  #define BOARD_ID "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx"
+#endif
+
+/* The same thing on every board, so that the results can be compared */
+bool switch_0;
+int counter_0;
+int counter_1;
+int counter_2;
+float value_0;
+float value_1;
+float value_2;
+String message;
+CloudColoredLight light;
+CloudTemperatureSensor temperature;
+
+void initProperties() {
+#if defined(BOARD_ESP)
+  ArduinoCloud.setBoardId(BOARD_ID);
+  ArduinoCloud.setSecretDeviceKey(SECRET_DEVICE_KEY);
+#endif
+  ArduinoCloud.addProperty(switch_0, Permission::ReadWrite);
+  ArduinoCloud.addProperty(counter_0, Permission::Read).publishOnChange(0);
+  ArduinoCloud.addProperty(counter_1, Permission::Read).publishOnChange(0);
+  ArduinoCloud.addProperty(counter_2, Permission::Read).publishOnChange(0);
+  ArduinoCloud.addProperty(value_0, Permission::Read).publishOnChange(0);
+  ArduinoCloud.addProperty(value_1, Permission::Read).publishOnChange(0);
+  ArduinoCloud.addProperty(value_2, Permission::Read).publishOnChange(0);
+  ArduinoCloud.addProperty(message, Permission::ReadWrite);
+  ArduinoCloud.addProperty(light, Permission::ReadWrite);
+  ArduinoCloud.addProperty(temperature, Permission::Read).publishEvery(1);
+}
+
+#if defined(BOARD_HAS_ETHERNET)
+  EthernetConnectionHandler ArduinoIoTPreferredConnection(SECRET_OPTIONAL_IP, SECRET_OPTIONAL_DNS, SECRET_OPTIONAL_GATEWAY, SECRET_OPTIONAL_NETMASK);
+#elif defined(BOARD_HAS_WIFI)
+  WiFiConnectionHandler ArduinoIoTPreferredConnection(SECRET_SSID, SECRET_PASS);
+#elif defined(BOARD_HAS_GSM)
+  GSMConnectionHandler ArduinoIoTPreferredConnection(SECRET_PIN, SECRET_APN, SECRET_LOGIN, SECRET_PASS);
+#elif defined(BOARD_HAS_NB)
+  NBConnectionHandler ArduinoIoTPreferredConnection(SECRET_PIN, SECRET_APN, SECRET_LOGIN, SECRET_PASS);
+#endif
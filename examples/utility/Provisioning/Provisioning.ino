@@ -59,16 +59,14 @@ void setup() {
     while (1);
   }
 
-  String csr = Certificate.getCSRPEM();
+  Serial.println("Generated CSR is:");
+  Serial.println();
 
-  if (!csr) {
+  if (!Certificate.printCSRPEM(Serial)) {
     Serial.println("Error generating CSR!");
     while (1);
   }
-
-  Serial.println("Generated CSR is:");
   Serial.println();
-  Serial.println(csr);
 
   String issueYear              = promptAndReadLine("Please enter the issue year of the certificate (2000 - 2031): ");
   String issueMonth             = promptAndReadLine("Please enter the issue month of the certificate (1 - 12): ");
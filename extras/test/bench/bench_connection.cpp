@@ -0,0 +1,169 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <SimDevice.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static unsigned int  const RUN_CNT             = 20;
+static unsigned long const CONNECT_TIMEOUT_ms  = 10 * 60 * 1000UL;
+static unsigned long const OUTAGE_ms           = 60 * 1000UL;
+static unsigned long const SATURATION_RUN_ms   = 30 * 1000UL;
+
+struct Profile
+{
+  char const * name;
+  SimLinkConfig link;
+};
+
+/*                                      rtt   loss  bandwidth  buffer   tls    phy  nat */
+static Profile const PROFILES[] =
+{
+  {"ethernet",                        {  10, 0.00f,         0,   2048,    0,     0,   0}},
+  {"wifi",                            {  50, 0.01f,    250000,   2048,  300,  2000,   0}},
+  {"cellular",                        { 300, 0.02f,     20000,   2048,  300, 10000,   0}},
+  {"lossy",                           { 150, 0.10f,     16000,   2048,  300,  2000,   0}},
+};
+
+/**************************************************************************************
+   SKETCH
+ **************************************************************************************/
+
+static int counter = 0;
+
+/* Without the default throttling of 2 Hz the property is sent on each change */
+static void setupCounter()
+{
+  counter = 0;
+  ArduinoCloud.addProperty(counter, Permission::ReadWrite).publishOnChange(0);
+}
+
+/* Changes the property on every loop so that there always is something to send */
+static void countEveryLoop()
+{
+  counter++;
+}
+
+/**************************************************************************************
+   BENCHMARKS
+ **************************************************************************************/
+
+/* Durations in ms of all runs */
+class Samples
+{
+public:
+
+  void add(double const ms) { _ms.push_back(ms); }
+
+  void print(char const * name)
+  {
+    if (_ms.empty())
+      return;
+    std::sort(_ms.begin(), _ms.end());
+    double sum = 0.0;
+    for (double const ms : _ms)
+      sum += ms;
+    printf("  %-22s mean %8.0f ms  median %8.0f ms  max %8.0f ms", name, sum / _ms.size(), _ms[_ms.size() / 2], _ms.back());
+    if (_failed > 0)
+      printf("  (%u timed out)", _failed);
+    printf("\n");
+  }
+
+  void fail() { _failed++; }
+
+private:
+
+  std::vector<double> _ms;
+  unsigned int _failed = 0;
+};
+
+/* The clock may have run on past the sync while the device slept */
+static double elapsed_ms(uint64_t const since_us)
+{
+  return static_cast<double>(SimDevice::lastSyncTime() - since_us) / 1000.0;
+}
+
+static void benchmark(Profile const & profile)
+{
+  Samples connect, reconnect, outage;
+  unsigned int refused = 0;
+
+  for (unsigned int run = 0; run < RUN_CNT; run++)
+  {
+    uint32_t const seed = 1 + run;
+
+    /* From power up to the last values being received */
+    SimDevice::begin(profile.link, seed);
+    if (!SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms)) {
+      connect.fail();
+      continue;
+    }
+    connect.add(elapsed_ms(0));
+
+    /* The connection is reset and noticed right away */
+    SimDevice::run(5000);
+    uint64_t const drop_us = SimNet.now();
+    SimNet.drop();
+    if (SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms))
+      reconnect.add(elapsed_ms(drop_us));
+    else
+      reconnect.fail();
+
+    /* The broker is unavailable for a while, timed from its return */
+    SimDevice::run(5000);
+    SimCloud.clearStats();
+    SimCloud.setAvailable(false);
+    SimNet.drop();
+    SimDevice::run(OUTAGE_ms);
+    refused += SimCloud.stats().refused;
+    SimCloud.setAvailable(true);
+    uint64_t const back_us = SimNet.now();
+    if (SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms))
+      outage.add(elapsed_ms(back_us));
+    else
+      outage.fail();
+  }
+
+  /* A property changing faster than it can be sent */
+  SimDevice::begin(profile.link, 1, setupCounter);
+  bool const saturation_connected = SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms);
+  SimDevice::setLoop(countEveryLoop);
+  SimCloud.clearStats();
+  SimDevice::run(SATURATION_RUN_ms);
+  SimBrokerStats const & stats = SimCloud.stats();
+
+  printf("%s: rtt %lu ms, loss %.0f%%, %lu B/s, %u runs\n", profile.name, profile.link.rtt_ms, profile.link.loss * 100.0f, profile.link.bandwidth_Bps, RUN_CNT);
+  connect.print("time to connected");
+  reconnect.print("reconnect after drop");
+  outage.print("connect after outage");
+  printf("  %-22s %8.1f per outage of %lu s\n", "refused attempts", static_cast<double>(refused) / RUN_CNT, OUTAGE_ms / 1000);
+  if (saturation_connected && (stats.data_messages > 0))
+    printf("  %-22s %8.1f msg/s %8.0f B/s  latency mean %6.0f ms  max %6.0f ms\n", "saturation",
+           stats.data_messages * 1000.0 / SATURATION_RUN_ms, stats.data_bytes * 1000.0 / SATURATION_RUN_ms,
+           stats.data_latency_sum_us / 1000.0 / stats.data_messages, stats.data_latency_max_us / 1000.0);
+  else
+    printf("  %-22s no messages\n", "saturation");
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+int main()
+{
+  for (Profile const & profile : PROFILES)
+    benchmark(profile);
+  return 0;
+}
@@ -0,0 +1,298 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <util/AllocationTestUtil.h>
+
+#include <PropertyContainer.h>
+#include <CBOREncoder.h>
+#include <CBORDecoder.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+/* Same as the MQTT payload buffer of the TCP connection */
+static size_t        const MESSAGE_SIZE        = 256;
+static unsigned long const MIN_RUN_TIME_us     = 200000;
+static unsigned int  const MIN_PASS_CNT        = 10;
+static size_t        const STACK_PAINT_SIZE    = 32 * 1024;
+static uint8_t       const STACK_PAINT_PATTERN = 0xA5;
+
+/**************************************************************************************
+   STACK MEASUREMENT
+ **************************************************************************************/
+
+/* Both functions are called from the same frame, hence their regions
+ * overlap the stack used by what is called in between them.
+ */
+__attribute__((noinline)) static void paintStack()
+{
+  uint8_t region[STACK_PAINT_SIZE];
+  volatile uint8_t * const paint = region;
+  for (size_t i = 0; i < STACK_PAINT_SIZE; i++)
+    paint[i] = STACK_PAINT_PATTERN;
+}
+
+/* Reading the region left behind by paintStack() is the whole point */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((noinline)) static size_t usedStack()
+{
+  volatile uint8_t region[STACK_PAINT_SIZE];
+  size_t i = 0;
+  for (; (i < STACK_PAINT_SIZE) && (region[i] == STACK_PAINT_PATTERN); i++) { }
+  return STACK_PAINT_SIZE - i;
+}
+#pragma GCC diagnostic pop
+
+/**************************************************************************************
+   THING
+ **************************************************************************************/
+
+/* A thing with a realistic mix of primitive and composite properties */
+class Thing
+{
+public:
+
+  Thing(size_t const property_cnt)
+  {
+    for (size_t i = 0; i < property_cnt; i++)
+    {
+      Property * p = nullptr;
+      switch (i % 7)
+      {
+        case 0: p = new CloudInt();          break;
+        case 1: p = new CloudFloat();        break;
+        case 2: p = new CloudBool();         break;
+        case 3: p = new CloudString();       break;
+        case 4: p = new CloudColoredLight(); break;
+        case 5: p = new CloudSchedule();     break;
+        case 6: p = new CloudTelevision();   break;
+      }
+      _property.emplace_back(p);
+      char name[16];
+      snprintf(name, sizeof(name), "property_%u", static_cast<unsigned int>(i));
+      addPropertyToContainer(container, *p, String(name), Permission::ReadWrite);
+    }
+  }
+
+  /* Changes every property so all of them have to be sent */
+  void change(unsigned int const pass)
+  {
+    for (size_t i = 0; i < _property.size(); i++)
+    {
+      Property * p = _property[i].get();
+      int const v = static_cast<int>(pass + i);
+      char str[16];
+      snprintf(str, sizeof(str), "value %d", v);
+      switch (i % 7)
+      {
+        case 0: *static_cast<CloudInt *>(p) = v;                                                   break;
+        case 1: *static_cast<CloudFloat *>(p) = v * 0.5f;                                          break;
+        case 2: *static_cast<CloudBool *>(p) = (v % 2) == 0;                                       break;
+        case 3: *static_cast<CloudString *>(p) = String(str);                                      break;
+        case 4: *static_cast<CloudColoredLight *>(p) = ColoredLight((v % 2) == 0, v % 360, 50, 80); break;
+        case 5: *static_cast<CloudSchedule *>(p) = Schedule(v, v + 60, 30, 0x1FF);                 break;
+        case 6: static_cast<CloudTelevision *>(p)->setVolume(v % 100);                             break;
+      }
+    }
+  }
+
+  PropertyContainer container;
+
+private:
+
+  std::vector<std::unique_ptr<Property>> _property;
+};
+
+/**************************************************************************************
+   BENCHMARKS
+ **************************************************************************************/
+
+typedef std::vector<std::vector<uint8_t>> Messages;
+
+struct Result
+{
+  double us_per_msg;
+  double mb_per_s;
+  double allocs_per_msg;
+  size_t stack;
+};
+
+static unsigned long elapsed_us(std::chrono::steady_clock::time_point const start)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Changes all properties past the minimum time between updates of each */
+static void prepare(Thing & thing, unsigned int const pass)
+{
+  set_millis(pass * 1000UL);
+  thing.change(pass);
+}
+
+/* Encodes all changed properties into as many messages as needed,
+ * returns the number of bytes encoded.
+ */
+static size_t encodeAll(Thing & thing, size_t & message_cnt, Messages * messages = nullptr)
+{
+  size_t bytes = 0;
+  unsigned int property_index = 0;
+  for (size_t i = 0; i < (thing.container.size() * 2); i++)
+  {
+    uint8_t buf[MESSAGE_SIZE];
+    int bytes_encoded = 0;
+    if ((CBOREncoder::encode(thing.container, buf, sizeof(buf), bytes_encoded, property_index) != CborNoError) || (bytes_encoded == 0))
+      break;
+    bytes += bytes_encoded;
+    message_cnt++;
+    if (messages)
+      messages->emplace_back(buf, buf + bytes_encoded);
+  }
+  return bytes;
+}
+
+static size_t encodeStack(Thing & thing)
+{
+  uint8_t buf[MESSAGE_SIZE];
+  int bytes_encoded = 0;
+  unsigned int property_index = 0;
+  paintStack();
+  CBOREncoder::encode(thing.container, buf, sizeof(buf), bytes_encoded, property_index);
+  return usedStack();
+}
+
+static size_t decodeStack(Thing & thing, std::vector<uint8_t> const & message)
+{
+  paintStack();
+  CBORDecoder::decode(thing.container, message.data(), message.size());
+  return usedStack();
+}
+
+static void benchmark(size_t const property_cnt, Result & encode, Result & decode)
+{
+  Thing thing(property_cnt);
+  size_t message_cnt = 0;
+  prepare(thing, 1);
+  encodeAll(thing, message_cnt);
+
+  /* Encode */
+  Messages messages;
+  message_cnt = 0;
+  prepare(thing, 2);
+  size_t const message_bytes = encodeAll(thing, message_cnt, &messages);
+
+  size_t encode_allocation_cnt = 0;
+  unsigned int pass = 3;
+  unsigned int encode_pass_cnt = 0;
+  unsigned long encode_us = 0;
+  size_t encode_msg_cnt = 0;
+  size_t encode_bytes = 0;
+  do {
+    prepare(thing, pass++);
+    auto const start = std::chrono::steady_clock::now();
+    {
+      AllocationCounter counter;
+      encode_bytes += encodeAll(thing, encode_msg_cnt);
+      encode_allocation_cnt += counter.count();
+    }
+    encode_us += elapsed_us(start);
+    encode_pass_cnt++;
+  } while ((encode_us < MIN_RUN_TIME_us) || (encode_pass_cnt < MIN_PASS_CNT));
+  prepare(thing, pass++);
+  size_t const encode_stack = encodeStack(thing);
+
+  /* Decode the messages into a thing of the same shape */
+  Thing cloud(property_cnt);
+  size_t decode_allocation_cnt = 0;
+  unsigned int decode_pass_cnt = 0;
+  auto const decode_start = std::chrono::steady_clock::now();
+  unsigned long decode_us = 0;
+  do {
+    {
+      AllocationCounter counter;
+      for (auto const & m : messages)
+        CBORDecoder::decode(cloud.container, m.data(), m.size());
+      decode_allocation_cnt += counter.count();
+    }
+    decode_pass_cnt++;
+    decode_us = elapsed_us(decode_start);
+  } while ((decode_us < MIN_RUN_TIME_us) || (decode_pass_cnt < MIN_PASS_CNT));
+  size_t const decode_stack = decodeStack(cloud, messages.front());
+
+  double const decode_msg_cnt = static_cast<double>(decode_pass_cnt) * messages.size();
+  double const decode_bytes = static_cast<double>(decode_pass_cnt) * message_bytes;
+
+  encode = {static_cast<double>(encode_us) / encode_msg_cnt, static_cast<double>(encode_bytes) / encode_us, static_cast<double>(encode_allocation_cnt) / encode_msg_cnt, encode_stack};
+  decode = {decode_us / decode_msg_cnt, decode_bytes / decode_us, static_cast<double>(decode_allocation_cnt) / decode_msg_cnt, decode_stack};
+
+  printf("%4u properties: %3u messages, %5u bytes per pass\n", static_cast<unsigned int>(property_cnt), static_cast<unsigned int>(messages.size()), static_cast<unsigned int>(message_bytes));
+  printf("  encode: %8.2f us/msg %7.2f MB/s %6.2f allocs/msg %6u bytes stack\n", encode.us_per_msg, encode.mb_per_s, encode.allocs_per_msg, static_cast<unsigned int>(encode.stack));
+  printf("  decode: %8.2f us/msg %7.2f MB/s %6.2f allocs/msg %6u bytes stack\n", decode.us_per_msg, decode.mb_per_s, decode.allocs_per_msg, static_cast<unsigned int>(decode.stack));
+}
+
+/* Same layout as the "bench" section of extras/test/baseline.json */
+static void writeResult(FILE * out, char const * name, Result const & result)
+{
+  fprintf(out, "      \"%s\": {\"us_per_msg\": %.3f, \"mb_per_s\": %.3f, \"allocs_per_msg\": %.3f, \"stack\": %u}",
+          name, result.us_per_msg, result.mb_per_s, result.allocs_per_msg, static_cast<unsigned int>(result.stack));
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+/* benchArduinoIoTCloud [--json results.json], the results are compared
+ * against the baseline by extras/tools/budget.py.
+ */
+int main(int argc, char ** argv)
+{
+  char const * json_file = nullptr;
+  if ((argc == 3) && (strcmp(argv[1], "--json") == 0)) {
+    json_file = argv[2];
+  } else if (argc != 1) {
+    fprintf(stderr, "Usage: %s [--json results.json]\n", argv[0]);
+    return 1;
+  }
+
+  static size_t const PROPERTY_CNT[] = {10, 50, 200};
+  static size_t const RESULT_CNT = sizeof(PROPERTY_CNT) / sizeof(PROPERTY_CNT[0]);
+  Result encode[RESULT_CNT], decode[RESULT_CNT];
+  for (size_t i = 0; i < RESULT_CNT; i++)
+    benchmark(PROPERTY_CNT[i], encode[i], decode[i]);
+
+  if (json_file)
+  {
+    FILE * out = fopen(json_file, "w");
+    if (!out) {
+      fprintf(stderr, "Cannot write %s\n", json_file);
+      return 1;
+    }
+    fprintf(out, "{\n");
+    for (size_t i = 0; i < RESULT_CNT; i++)
+    {
+      fprintf(out, "  \"%u\": {\n", static_cast<unsigned int>(PROPERTY_CNT[i]));
+      writeResult(out, "encode", encode[i]);
+      fprintf(out, ",\n");
+      writeResult(out, "decode", decode[i]);
+      fprintf(out, "\n  }%s\n", (i + 1 < RESULT_CNT) ? "," : "");
+    }
+    fprintf(out, "}\n");
+    fclose(out);
+  }
+  return 0;
+}
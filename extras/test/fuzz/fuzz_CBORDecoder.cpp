@@ -0,0 +1,92 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <CBORDecoder.h>
+#include "types/CloudLocation.h"
+#include "types/CloudSchedule.h"
+#include "types/automation/CloudColoredLight.h"
+#include "types/automation/CloudTelevision.h"
+
+/**************************************************************************************
+   HELPER
+ **************************************************************************************/
+
+/* The names match the seed corpus which is taken from test_decode.cpp */
+class Thing
+{
+public:
+
+  Thing()
+  {
+    addPropertyToContainer(container, bool_test,  "bool_test",  Permission::ReadWrite);
+    addPropertyToContainer(container, int_test,   "int_test",   Permission::ReadWrite);
+    addPropertyToContainer(container, float_test, "float_test", Permission::ReadWrite);
+    addPropertyToContainer(container, str_test,   "str_test",   Permission::ReadWrite);
+    addPropertyToContainer(container, test,       "test",       Permission::ReadWrite, 1);
+    addPropertyToContainer(container, light,      "light",      Permission::ReadWrite);
+    addPropertyToContainer(container, location,   "location",   Permission::ReadWrite);
+    addPropertyToContainer(container, schedule,   "schedule",   Permission::ReadWrite);
+    addPropertyToContainer(container, tv,         "tv",         Permission::ReadWrite);
+  }
+
+  PropertyContainer container;
+  CloudBool bool_test;
+  CloudInt int_test;
+  CloudFloat float_test;
+  CloudString str_test;
+  CloudColoredLight test;
+  CloudColoredLight light;
+  CloudLocation location;
+  CloudSchedule schedule;
+  CloudTelevision tv;
+};
+
+static void decodeInChunks(uint8_t const * data, size_t size, size_t const chunk_size, bool const is_sync_message)
+{
+  Thing thing;
+  CBORDecoder decoder(thing.container, is_sync_message);
+  while (size > 0)
+  {
+    size_t available = 0;
+    uint8_t * buf = decoder.writeBuffer(available);
+    size_t bytes = (available < chunk_size) ? available : chunk_size;
+    bytes = (bytes < size) ? bytes : size;
+    memcpy(buf, data, bytes);
+    if (!decoder.commit(bytes))
+      return;
+    data += bytes;
+    size -= bytes;
+  }
+}
+
+/**************************************************************************************
+   FUZZ TARGET
+ **************************************************************************************/
+
+/* The input is a plain message, so that any message can serve as a seed.
+ * It is decoded at once and in chunks whose size is derived from the input
+ * size, both as a regular and as a sync message.
+ */
+extern "C" int LLVMFuzzerTestOneInput(uint8_t const * data, size_t size)
+{
+  size_t const chunk_size = 1 + (size % 61);
+
+  for (bool const is_sync_message : {false, true})
+  {
+    {
+      Thing thing;
+      CBORDecoder::decode(thing.container, data, size, is_sync_message);
+    }
+    decodeInChunks(data, size, chunk_size, is_sync_message);
+  }
+
+  return 0;
+}
@@ -0,0 +1,81 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+/**************************************************************************************
+   EXTERN
+ **************************************************************************************/
+
+extern "C" int LLVMFuzzerTestOneInput(uint8_t const * data, size_t size);
+
+/**************************************************************************************
+   HELPER
+ **************************************************************************************/
+
+static bool runFile(std::string const & path)
+{
+  FILE * file = fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+
+  std::vector<uint8_t> input;
+  uint8_t buf[4096];
+  size_t bytes = 0;
+  while ((bytes = fread(buf, 1, sizeof(buf), file)) > 0)
+    input.insert(input.end(), buf, buf + bytes);
+  fclose(file);
+
+  LLVMFuzzerTestOneInput(input.data(), input.size());
+  return true;
+}
+
+static size_t runPath(std::string const & path)
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+    return 0;
+  if (!S_ISDIR(st.st_mode))
+    return runFile(path) ? 1 : 0;
+
+  size_t cnt = 0;
+  DIR * dir = opendir(path.c_str());
+  if (!dir)
+    return 0;
+  for (struct dirent * entry = readdir(dir); entry; entry = readdir(dir))
+  {
+    if (entry->d_name[0] == '.')
+      continue;
+    cnt += runPath(path + "/" + entry->d_name);
+  }
+  closedir(dir);
+  return cnt;
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+/* Replays a corpus through the fuzz target when no fuzzing engine is
+ * available, e.g. with GCC: fuzzCBORDecoder <file or directory>...
+ */
+int main(int argc, char ** argv)
+{
+  size_t cnt = 0;
+  for (int i = 1; i < argc; i++)
+    cnt += runPath(argv[i]);
+
+  printf("%u inputs replayed\n", static_cast<unsigned int>(cnt));
+  return (cnt > 0) ? 0 : 1;
+}
@@ -9,6 +9,9 @@
    INCLUDE
  ******************************************************************************/
 
+#include <stdint.h>
+#include <string.h>
+
 #include <string>
 
 /******************************************************************************
@@ -16,6 +19,7 @@
  ******************************************************************************/
 
 typedef std::string String;
+typedef uint8_t byte;
 
 /******************************************************************************
    FUNCTION PROTOTYPES
@@ -23,5 +27,11 @@ typedef std::string String;
 
 void          set_millis(unsigned long const millis);
 unsigned long millis();
+void          set_micros(unsigned long const micros);
+unsigned long micros();
+uint16_t      word(uint8_t const h, uint8_t const l);
+void          randomSeed(unsigned long const seed);
+long          random(long const min, long const max);
+int           analogRead(uint8_t const pin);
 
 #endif /* TEST_ARDUINO_H_ */
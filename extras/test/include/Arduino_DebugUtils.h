@@ -0,0 +1,38 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_ARDUINO_DEBUG_UTILS_H_
+#define TEST_ARDUINO_DEBUG_UTILS_H_
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static int const DBG_NONE    = -1;
+static int const DBG_ERROR   =  0;
+static int const DBG_WARNING =  1;
+static int const DBG_INFO    =  2;
+static int const DBG_DEBUG   =  3;
+static int const DBG_VERBOSE =  4;
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* The unit tests check the results instead of the messages, which are dropped */
+class Arduino_DebugUtils
+{
+public:
+
+  inline void setDebugLevel(int const) { }
+  inline void print(int const, char const *, ...) { }
+};
+
+/******************************************************************************
+   GLOBAL VARIABLES
+ ******************************************************************************/
+
+static Arduino_DebugUtils Debug;
+
+#endif /* TEST_ARDUINO_DEBUG_UTILS_H_ */
@@ -0,0 +1,40 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef INCLUDE_ALLOCATION_TESTUTIL_H_
+#define INCLUDE_ALLOCATION_TESTUTIL_H_
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <stddef.h>
+
+/**************************************************************************************
+   CLASS DECLARATION
+ **************************************************************************************/
+
+/* Counts the heap allocations done by the calling thread while in scope.
+ * malloc(), calloc() and realloc() are interposed, so both operator new and
+ * the C allocations done by tinycbor are seen. Scopes do not nest.
+ */
+class AllocationCounter
+{
+public:
+
+  AllocationCounter();
+  ~AllocationCounter();
+
+  void reset();
+
+  /* Number of allocations, a realloc() counts as one */
+  size_t count() const;
+  /* High-water mark of the bytes allocated within this scope and not yet freed */
+  size_t peakBytes() const;
+  /* Bytes allocated within this scope and not yet freed */
+  size_t liveBytes() const;
+
+};
+
+#endif /* INCLUDE_ALLOCATION_TESTUTIL_H_ */
@@ -0,0 +1,53 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef INCLUDE_CLOCK_TESTUTIL_H_
+#define INCLUDE_CLOCK_TESTUTIL_H_
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <stdint.h>
+
+#include <functional>
+
+/**************************************************************************************
+   CLASS DECLARATION
+ **************************************************************************************/
+
+/* The single time base of the host build. millis(), micros(), getTime() of the
+ * properties and thereby the RTC, the rate limits, the keep alive and the retry
+ * ticks all derive from it, so that they never disagree and a test can run
+ * hours of device time within milliseconds. set_millis() and set_micros() of
+ * the Arduino stub set it as well.
+ */
+class VirtualClock
+{
+public:
+
+  /* Restarts the device at t = 0, with the POSIX time unknown if 0 */
+  static void reset(unsigned long const epoch = 0);
+
+  /* Microseconds since the device has been started */
+  static uint64_t now();
+  /* Jumps to the given time, also backwards. The POSIX time jumps along. */
+  static void set(uint64_t const time_us);
+  /* Lets time pass, it never goes backwards */
+  static void advanceTo(uint64_t const time_us);
+  static void advance(unsigned long const ms);
+  static void advanceMicros(uint64_t const us);
+
+  /* POSIX time, 0 until set or given to reset() as on a device before the
+   * first sync. It advances with now() from then on.
+   */
+  static unsigned long getTime();
+  static void setTime(unsigned long const epoch);
+
+  /* Runs 'poll' every 'step_ms' (> 0) until 'ms' have passed, as the loop of a sketch */
+  static void run(unsigned long const ms, unsigned long const step_ms, std::function<void()> poll);
+
+};
+
+#endif /* INCLUDE_CLOCK_TESTUTIL_H_ */
@@ -0,0 +1,99 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_SIM_ARDUINO_MQTT_CLIENT_H_
+#define TEST_SIM_ARDUINO_MQTT_CLIENT_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stdint.h>
+
+#include <Arduino.h>
+#include <Client.h>
+
+#include <SimBroker.h>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+#define MQTT_CONNECTION_REFUSED            -2
+#define MQTT_CONNECTION_TIMEOUT            -1
+#define MQTT_SUCCESS                        0
+#define MQTT_UNACCEPTABLE_PROTOCOL_VERSION  1
+#define MQTT_IDENTIFIER_REJECTED            2
+#define MQTT_SERVER_UNAVAILABLE             3
+#define MQTT_BAD_USER_NAME_OR_PASSWORD      4
+#define MQTT_NOT_AUTHORIZED                 5
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* The subset of ArduinoMqttClient used by ArduinoIoTCloudTCP, talking to
+ * SimBroker. As in the library connect(), subscribe() and unsubscribe()
+ * block until they are acknowledged or time out and meanwhile deliver the
+ * messages which arrive. Writes block while the send buffer is full.
+ */
+class MqttClient
+{
+public:
+
+  typedef void(*MessageCallback)(int);
+
+  MqttClient(Client * client);
+
+  inline void setClient(Client & client) { _client = &client; }
+  inline void onMessage(MessageCallback callback) { _on_message = callback; }
+  inline void setId(char const * /* id */) { }
+  inline void setUsernamePassword(String const & /* username */, String const & /* password */) { }
+  inline void setKeepAliveInterval(unsigned long const interval) { _keep_alive_interval = interval; }
+  inline void setConnectionTimeout(unsigned long const timeout) { _connection_timeout = timeout; }
+
+  int  connect(char const * host, uint16_t port);
+  inline int connectError() const { return _connect_error; }
+  int  connected();
+  void stop();
+  void poll();
+  /* Number of calls of poll() of all clients */
+  static inline unsigned long pollCount() { return _poll_cnt; }
+
+  int subscribe(String const & topic, uint8_t qos = 0);
+  int unsubscribe(String const & topic);
+  inline int subscribe(char const * topic, uint8_t qos = 0) { return subscribe(String(topic), qos); }
+  inline int unsubscribe(char const * topic) { return unsubscribe(String(topic)); }
+
+  int    beginMessage(String const & topic, unsigned long size, bool retain = false, uint8_t qos = 0, bool dup = false);
+  inline int beginMessage(char const * topic, unsigned long size, bool retain = false, uint8_t qos = 0, bool dup = false) { return beginMessage(String(topic), size, retain, qos, dup); }
+  size_t write(uint8_t const * buf, size_t size);
+  int    endMessage();
+
+  inline String messageTopic() const { return _rx.topic; }
+  inline int messageDup() const { return _rx.dup ? 1 : 0; }
+  int read(uint8_t * buf, size_t size);
+
+private:
+
+  static unsigned long _poll_cnt;
+
+  Client * _client;
+  MessageCallback _on_message;
+  unsigned long _keep_alive_interval;
+  unsigned long _last_ping_tick;
+  unsigned long _connection_timeout;
+  int _connect_error;
+  bool _connected;
+  uint32_t _session;
+  SimPacket _tx;
+  SimPacket _rx;
+  size_t _rx_pos;
+
+  void request(SimPacketType const type, String const & topic);
+  bool waitFor(SimPacketType const type, SimPacket & reply);
+  void dispatch(SimPacket & packet);
+};
+
+#endif /* TEST_SIM_ARDUINO_MQTT_CLIENT_H_ */
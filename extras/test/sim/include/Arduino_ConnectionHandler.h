@@ -0,0 +1,72 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_SIM_ARDUINO_CONNECTION_HANDLER_H_
+#define TEST_SIM_ARDUINO_CONNECTION_HANDLER_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <Arduino_DebugUtils.h>
+#include <Client.h>
+#include <Udp.h>
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+enum class NetworkConnectionState : unsigned int
+{
+  INIT          = 0,
+  CONNECTING    = 1,
+  CONNECTED     = 2,
+  DISCONNECTING = 3,
+  DISCONNECTED  = 4,
+  CLOSED        = 5,
+  ERROR         = 6
+};
+
+enum class NetworkAdapter
+{
+  WIFI,
+  ETHERNET,
+  NB,
+  GSM,
+  LORA,
+  CATM1,
+  CELL
+};
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Connected once the network interface of SimNetwork has been up for the
+ * configured time to connect.
+ */
+class ConnectionHandler
+{
+public:
+
+  ConnectionHandler();
+
+  NetworkConnectionState check();
+  inline NetworkConnectionState getStatus() const { return _status; }
+  inline NetworkAdapter getInterface() const { return NetworkAdapter::WIFI; }
+  /* No time from the network operator, NTP has to be used */
+  inline unsigned long getTime() { return 0; }
+
+  inline Client & getClient() { return _client; }
+  inline UDP & getUDP() { return _udp; }
+
+private:
+
+  NetworkConnectionState _status;
+  Client _client;
+  UDP _udp;
+};
+
+#endif /* TEST_SIM_ARDUINO_CONNECTION_HANDLER_H_ */
@@ -0,0 +1,44 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_SIM_ARDUINO_DEBUG_UTILS_H_
+#define TEST_SIM_ARDUINO_DEBUG_UTILS_H_
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static int const DBG_NONE    = -1;
+static int const DBG_ERROR   =  0;
+static int const DBG_WARNING =  1;
+static int const DBG_INFO    =  2;
+static int const DBG_DEBUG   =  3;
+static int const DBG_VERBOSE =  4;
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Prints the messages up to the debug level, prefixed by the simulated time */
+class Arduino_DebugUtils
+{
+public:
+
+  Arduino_DebugUtils();
+
+  inline void setDebugLevel(int const level) { _level = level; }
+  void print(int const level, char const * fmt, ...);
+
+private:
+
+  int _level;
+};
+
+/******************************************************************************
+   EXTERN DECLARATION
+ ******************************************************************************/
+
+extern Arduino_DebugUtils Debug;
+
+#endif /* TEST_SIM_ARDUINO_DEBUG_UTILS_H_ */
@@ -0,0 +1,65 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_SIM_CLIENT_H_
+#define TEST_SIM_CLIENT_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+class IPAddress
+{
+public:
+
+  IPAddress() : _addr{0, 0, 0, 0} { }
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _addr{a, b, c, d} { }
+
+  inline bool operator == (IPAddress const & other) const { return (_addr[0] == other._addr[0]) && (_addr[1] == other._addr[1]) && (_addr[2] == other._addr[2]) && (_addr[3] == other._addr[3]); }
+
+private:
+
+  uint8_t _addr[4];
+};
+
+class Print
+{
+public:
+
+  virtual ~Print() { }
+
+  virtual size_t write(uint8_t) { return 0; }
+  virtual size_t write(const uint8_t *, size_t) { return 0; }
+};
+
+/* The interface of Arduino's Client. The TCP connection is modelled by
+ * SimNetwork, the client handed from the connection handler to the MQTT
+ * client does nothing itself.
+ */
+class Client : public Print
+{
+public:
+
+  virtual int connect(IPAddress, uint16_t) { return 0; }
+  virtual int connect(const char *, uint16_t) { return 0; }
+  virtual size_t write(uint8_t) override { return 0; }
+  virtual size_t write(const uint8_t *, size_t) override { return 0; }
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual int read(uint8_t *, size_t) { return -1; }
+  virtual int peek() { return -1; }
+  virtual void flush() { }
+  virtual void stop() { }
+  virtual uint8_t connected() { return 0; }
+  virtual operator bool() { return false; }
+};
+
+#endif /* TEST_SIM_CLIENT_H_ */
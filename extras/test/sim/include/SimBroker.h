@@ -0,0 +1,173 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_SIM_BROKER_H_
+#define TEST_SIM_BROKER_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stdint.h>
+
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <SimNetwork.h>
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+enum class SimPacketType
+{
+  Connect,
+  ConnAck,
+  Subscribe,
+  SubAck,
+  Unsubscribe,
+  UnsubAck,
+  Publish,
+  PingReq,
+  PingResp,
+};
+
+struct SimPacket
+{
+  SimPacketType type;
+  uint32_t session;
+  uint64_t sent_us;
+  uint64_t arrival_us;
+  int code;
+  /* Set on a publish which is delivered again */
+  bool dup;
+  std::string topic;
+  std::vector<uint8_t> payload;
+};
+
+struct SimBrokerStats
+{
+  unsigned int connects;
+  unsigned int refused;
+  unsigned int subscribes;
+  unsigned int unsubscribes;
+  unsigned int device_messages;
+  unsigned int last_value_requests;
+  unsigned int timezone_requests;
+  unsigned int pings;
+  /* Requests for the last values and messages on the data topic of other things */
+  unsigned int gateway_last_value_requests;
+  unsigned int gateway_data_messages;
+  /* Messages on the thing data topic */
+  unsigned int data_messages;
+  size_t data_bytes;
+  uint64_t data_latency_sum_us;
+  uint64_t data_latency_max_us;
+  uint64_t last_data_arrival_us;
+};
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* The cloud end of the connection. It acknowledges the MQTT requests of the
+ * device, sends the thing id once the device topic is subscribed and answers
+ * the requests for the last values and the time zone with the time zone
+ * information. Messages
+ * published by the device are processed once they arrive, i.e. run() is
+ * called before the device looks for messages of the broker.
+ */
+class SimBroker
+{
+public:
+
+  /* Overhead of the MQTT fixed and variable header of a packet */
+  static size_t const PACKET_OVERHEAD = 4;
+
+  SimBroker();
+
+  void reset(char const * device_id, char const * thing_id);
+  /* The broker refuses connections with MQTT_SERVER_UNAVAILABLE while unavailable */
+  inline void setAvailable(bool const available) { _available = available; }
+  /* Connections to an unreachable endpoint time out */
+  inline void setReachable(std::string const & host, bool const reachable) { if (reachable) _unreachable.erase(host); else _unreachable.insert(host); }
+  inline bool isReachable(std::string const & host) const { return _unreachable.count(host) == 0; }
+  /* While not answering the requests for the last values are only counted */
+  inline void setAnswerLastValues(bool const answer) { _answer_last_values = answer; }
+  /* While not answering the requests for the time zone are only counted */
+  inline void setAnswerTimezone(bool const answer) { _answer_timezone = answer; }
+  /* Time zone offset sent on the request of the last values or the time zone */
+  inline void setTimeZone(int const offset, unsigned long const valid_for_s) { _tz_offset = offset; _tz_valid_for_s = valid_for_s; }
+
+  /* Sent by the device at the current time */
+  void send(SimPacket packet);
+  /* Returns the oldest packet for the device which has arrived by now */
+  bool receive(uint32_t const session, SimPacket & packet);
+  void run();
+  /* Time of the next packet arriving at either end, UINT64_MAX if there is none */
+  uint64_t nextEvent() const;
+  /* Time of the next packet arriving at the device, UINT64_MAX if there is none */
+  uint64_t nextDownlink() const;
+  /* Publishes a new value of an integer property to the device now, as a user
+   * of the dashboard would, by default of the thing the device is attached to.
+   */
+  void writeProperty(std::string const & name, int const value, std::string const & thing_id = "");
+  /* Attaches the device to a thing, possibly the one it is attached to
+   * already, and sends it the thing id now.
+   */
+  void attachThing(std::string const & thing_id);
+  /* Publishes a new value of a binary or integer device property to the device now */
+  void writeDeviceProperty(std::string const & name, std::vector<uint8_t> const & value);
+  void writeDeviceProperty(std::string const & name, int const value);
+  /* Publishes the last message to the device again now with the DUP flag set,
+   * as the broker does with QoS 1 when it has not received the PUBACK.
+   */
+  void redeliver();
+
+  inline SimBrokerStats const & stats() const { return _stats; }
+  inline void clearStats() { _stats = SimBrokerStats(); }
+
+  std::string deviceTopicIn () const { return "/a/d/" + _device_id + "/e/i"; }
+  std::string deviceTopicOut() const { return "/a/d/" + _device_id + "/e/o"; }
+  std::string shadowTopicIn () const { return "/a/t/" + _thing_id + "/shadow/i"; }
+  std::string shadowTopicOut() const { return "/a/t/" + _thing_id + "/shadow/o"; }
+  std::string dataTopicIn   () const { return "/a/t/" + _thing_id + "/e/i"; }
+  std::string dataTopicOut  () const { return "/a/t/" + _thing_id + "/e/o"; }
+
+private:
+
+  std::string _device_id;
+  std::string _thing_id;
+  bool _available;
+  bool _answer_last_values;
+  bool _answer_timezone;
+  std::set<std::string> _unreachable;
+  int _tz_offset;
+  unsigned long _tz_valid_for_s;
+  std::deque<SimPacket> _uplink;
+  std::deque<SimPacket> _downlink;
+  std::set<std::string> _subscriptions;
+  SimPacket _last_publish;
+  SimBrokerStats _stats;
+
+  void handle(SimPacket const & packet);
+  static bool isThingTopic(std::string const & topic, std::string const & suffix);
+  void reply(SimPacket const & request, SimPacketType const type, int const code);
+  void publish(uint64_t const send_us, uint32_t const session, std::string const & topic, std::vector<uint8_t> const & payload);
+  std::vector<uint8_t> encodeThingId() const;
+  std::vector<uint8_t> encodeLastValues(uint64_t const time_us) const;
+  std::vector<uint8_t> encodeTimezone(uint64_t const time_us) const;
+  std::vector<uint8_t> encodeProperty(std::string const & name, int const value) const;
+  std::vector<uint8_t> encodeProperty(std::string const & name, std::vector<uint8_t> const & value) const;
+};
+
+/******************************************************************************
+   EXTERN DECLARATION
+ ******************************************************************************/
+
+extern SimBroker SimCloud;
+
+#endif /* TEST_SIM_BROKER_H_ */
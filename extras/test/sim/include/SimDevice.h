@@ -0,0 +1,76 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_SIM_DEVICE_H_
+#define TEST_SIM_DEVICE_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <ArduinoIoTCloud.h>
+
+#include <SimBroker.h>
+#include <SimNetwork.h>
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+typedef void(*SimSketchFunc)(void);
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Runs ArduinoCloud as a sketch would, against SimBroker over SimNetwork.
+ * Between two calls of update() the clock advances by the loop period. A
+ * sketch without a loop sleeps up to the next packet or the time returned by
+ * nextUpdateIn().
+ */
+class SimDevice
+{
+public:
+
+  static char const DEVICE_ID[];
+  static char const THING_ID[];
+
+  /* Builds ArduinoCloud and TimeService anew and calls begin(). The
+   * properties of the thing are to be added by setup().
+   */
+  static void begin(SimLinkConfig const & link, uint32_t const seed, SimSketchFunc setup = nullptr, unsigned long const loop_ms = 1);
+  /* Runs update() and loop() once, then advances the clock */
+  static void step();
+  /* Steps for the given time */
+  static void run(unsigned long const ms);
+  /* Steps until the last values have been received, returns false on timeout */
+  static bool runUntilConnected(unsigned long const timeout_ms);
+
+  static inline void setLoop(SimSketchFunc loop) { _loop = loop; }
+  /* Calls notifyDataReady() once a packet of the broker has arrived, as the
+   * receive interrupt of a network interface would. As a driver attached to
+   * a running connection it signals once right away, there may be data.
+   */
+  static void setDataReadySignal(bool const enabled);
+  /* Increments each time the last values are received */
+  static inline unsigned int syncCount() { return _sync_cnt; }
+  static inline unsigned int disconnectCount() { return _disconnect_cnt; }
+  /* Time in us at which the last values were received */
+  static inline uint64_t lastSyncTime() { return _last_sync_us; }
+
+private:
+
+  static ConnectionHandler _connection;
+  static SimSketchFunc _loop;
+  static unsigned long _loop_ms;
+  static bool _data_ready_signal;
+  static unsigned int _sync_cnt;
+  static unsigned int _disconnect_cnt;
+  static uint64_t _last_sync_us;
+
+  static void onSync();
+  static void onDisconnect();
+};
+
+#endif /* TEST_SIM_DEVICE_H_ */
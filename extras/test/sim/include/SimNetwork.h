@@ -0,0 +1,121 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_SIM_NETWORK_H_
+#define TEST_SIM_NETWORK_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+struct SimLinkConfig
+{
+  /* Round trip time between the device and the broker */
+  unsigned long rtt_ms;
+  /* Probability that a TCP segment is lost and has to be retransmitted */
+  float loss;
+  /* Bytes per second in either direction, 0 for an unlimited link */
+  unsigned long bandwidth_Bps;
+  /* Bytes the device may have queued on the link before a write blocks */
+  size_t send_buffer;
+  /* Time spent by the device on the TLS handshake besides the round trips */
+  unsigned long tls_compute_ms;
+  /* Time taken by the network interface to (re)connect */
+  unsigned long phy_connect_ms;
+  /* Idle time after which a NAT on the way forgets the connection, 0 for none */
+  unsigned long nat_timeout_ms;
+};
+
+enum class SimDirection
+{
+  Uplink,   /* Device to broker */
+  Downlink, /* Broker to device */
+};
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Virtual clock and TCP link between the device and the broker. Time only
+ * advances when told to, so that a scenario takes the same course on every
+ * run and minutes of connection time are simulated in milliseconds. Each
+ * message is delayed by half the round trip, the time needed to transmit it
+ * at the link bandwidth behind the messages queued before it, and a
+ * retransmission timeout for every lost segment.
+ */
+class SimNetwork
+{
+public:
+
+  static size_t        const SEGMENT_SIZE = 1460;
+  static unsigned long const MIN_RTO_ms   = 200;
+
+  SimNetwork();
+
+  void reset(SimLinkConfig const & config, uint32_t const seed);
+  inline SimLinkConfig const & config() const { return _config; }
+
+  /* Advances the VirtualClock behind millis(), micros() and the RTC */
+  void advance(unsigned long const ms);
+  void advanceTo(uint64_t const time_us);
+  inline uint64_t now() const { return _now_us; }
+  inline unsigned long nowMillis() const { return static_cast<unsigned long>(_now_us / 1000); }
+  /* POSIX time of the simulated world, as served by the NTP server */
+  unsigned long epoch() const;
+
+  /* Returns when a message of 'bytes' sent at 'send_us' arrives, messages
+   * in one direction arrive in the order they have been sent.
+   */
+  uint64_t transmit(SimDirection const dir, size_t const bytes, uint64_t const send_us);
+  /* Datagrams are sent right away and not retransmitted, returns false if lost */
+  bool datagram(SimDirection const dir, size_t const bytes, uint64_t const send_us, uint64_t & arrival_us);
+  /* Time until the messages queued by the sender have left */
+  uint64_t backlog(SimDirection const dir) const;
+
+  /* The connection is lost, the device notices after detect_ms, e.g. once
+   * the keep alive expires. Messages still on the way are lost.
+   */
+  void drop(unsigned long const detect_ms = 0);
+  /* A new connection is opened, e.g. it gets a NAT mapping of its own */
+  void open();
+  /* Identifies the connection, it changes whenever it is dropped */
+  inline uint32_t session() const { return _session; }
+  inline uint64_t dropDetectedAt() const { return _drop_detect_us; }
+
+  /* Takes the network interface down, e.g. the access point is lost */
+  void setPhyUp(bool const up);
+  inline bool isPhyUp() const { return _phy_up; }
+  inline uint64_t phyUpSince() const { return _phy_up_us; }
+
+private:
+
+  SimLinkConfig _config;
+  uint64_t _now_us;
+  uint64_t _link_free_us[2];
+  uint64_t _last_arrival_us[2];
+  uint64_t _last_activity_us;
+  uint32_t _rand_state;
+  uint32_t _session;
+  uint64_t _drop_detect_us;
+  bool _phy_up;
+  uint64_t _phy_up_us;
+  unsigned long _epoch_base;
+
+  bool isLost();
+};
+
+/******************************************************************************
+   EXTERN DECLARATION
+ ******************************************************************************/
+
+extern SimNetwork SimNet;
+
+#endif /* TEST_SIM_NETWORK_H_ */
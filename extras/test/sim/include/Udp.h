@@ -0,0 +1,47 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+#ifndef TEST_SIM_UDP_H_
+#define TEST_SIM_UDP_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Talks to the NTP server on the other end of SimNetwork. Datagrams are lost
+ * at the loss rate of the link and not retransmitted. Polling for a reply
+ * costs a millisecond, as a busy wait on the reply would on the device.
+ */
+class UDP
+{
+public:
+
+  UDP();
+
+  uint8_t begin(uint16_t port);
+  int     beginPacket(char const * host, uint16_t port);
+  size_t  write(uint8_t const * buf, size_t size);
+  int     endPacket();
+  int     parsePacket();
+  int     read(uint8_t * buf, size_t size);
+  void    stop();
+
+  /* Number of requests sent to the NTP server */
+  inline unsigned int requests() const { return _requests; }
+
+private:
+
+  bool _is_reply_pending;
+  uint64_t _reply_arrival_us;
+  unsigned int _requests;
+};
+
+#endif /* TEST_SIM_UDP_H_ */
@@ -0,0 +1,257 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <ArduinoMqttClient.h>
+
+#include <string.h>
+
+#include <algorithm>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+/* Bytes exchanged by the TCP handshake and the TLS handshake, the second
+ * round trip carries the certificate chain of the broker.
+ */
+static size_t const HANDSHAKE_BYTES[][2] =
+{
+  {  64,   64},
+  { 320, 4096},
+  { 420,  128},
+};
+
+/******************************************************************************
+   STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+unsigned long MqttClient::_poll_cnt = 0;
+
+/******************************************************************************
+   CTOR/DTOR
+ ******************************************************************************/
+
+MqttClient::MqttClient(Client * client)
+: _client{client}
+, _on_message{nullptr}
+, _keep_alive_interval{60 * 1000UL}
+, _last_ping_tick{0}
+, _connection_timeout{30 * 1000UL}
+, _connect_error{MQTT_SUCCESS}
+, _connected{false}
+, _session{0}
+, _tx()
+, _rx()
+, _rx_pos{0}
+{
+
+}
+
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+int MqttClient::connect(char const * host, uint16_t /* port */)
+{
+  _connected = false;
+  if (!_client || !SimNet.isPhyUp())
+  {
+    _connect_error = MQTT_CONNECTION_REFUSED;
+    return 0;
+  }
+  if (!SimCloud.isReachable(host))
+  {
+    SimNet.advance(_connection_timeout);
+    _connect_error = MQTT_CONNECTION_TIMEOUT;
+    return 0;
+  }
+
+  _session = SimNet.session();
+  SimNet.open();
+  for (auto const & bytes : HANDSHAKE_BYTES)
+  {
+    uint64_t const reply_us = SimNet.transmit(SimDirection::Uplink, bytes[0], SimNet.now());
+    SimNet.advanceTo(SimNet.transmit(SimDirection::Downlink, bytes[1], reply_us));
+  }
+  SimNet.advance(SimNet.config().tls_compute_ms);
+  if (_session != SimNet.session())
+  {
+    _connect_error = MQTT_CONNECTION_REFUSED;
+    return 0;
+  }
+
+  _connected = true;
+  request(SimPacketType::Connect, "");
+  SimPacket reply;
+  if (!waitFor(SimPacketType::ConnAck, reply))
+  {
+    _connected = false;
+    _connect_error = MQTT_CONNECTION_TIMEOUT;
+    return 0;
+  }
+  if (reply.code != MQTT_SUCCESS)
+  {
+    stop();
+    _connect_error = reply.code;
+    return 0;
+  }
+
+  _connect_error = MQTT_SUCCESS;
+  _last_ping_tick = millis();
+  return 1;
+}
+
+int MqttClient::connected()
+{
+  /* A lost connection goes unnoticed until the drop is detected */
+  if (_connected && (_session != SimNet.session()) && (SimNet.now() >= SimNet.dropDetectedAt()))
+    _connected = false;
+  return _connected;
+}
+
+void MqttClient::stop()
+{
+  if (_connected && (_session == SimNet.session()))
+    SimNet.drop();
+  _connected = false;
+}
+
+void MqttClient::poll()
+{
+  _poll_cnt++;
+
+  /* As the library it pings once the interval has passed since its last ping */
+  if (connected() && (_keep_alive_interval > 0) && ((millis() - _last_ping_tick) >= _keep_alive_interval))
+  {
+    request(SimPacketType::PingReq, "");
+    _last_ping_tick = millis();
+  }
+
+  SimPacket packet;
+  while (connected() && SimCloud.receive(_session, packet))
+  {
+    if (packet.type == SimPacketType::Publish)
+      dispatch(packet);
+  }
+}
+
+int MqttClient::subscribe(String const & topic, uint8_t /* qos */)
+{
+  if (!connected())
+    return 0;
+
+  request(SimPacketType::Subscribe, topic);
+  SimPacket reply;
+  return waitFor(SimPacketType::SubAck, reply) ? 1 : 0;
+}
+
+int MqttClient::unsubscribe(String const & topic)
+{
+  if (!connected())
+    return 0;
+
+  request(SimPacketType::Unsubscribe, topic);
+  SimPacket reply;
+  return waitFor(SimPacketType::UnsubAck, reply) ? 1 : 0;
+}
+
+int MqttClient::beginMessage(String const & topic, unsigned long size, bool /* retain */, uint8_t /* qos */, bool /* dup */)
+{
+  if (!connected())
+    return 0;
+
+  _tx = SimPacket();
+  _tx.type = SimPacketType::Publish;
+  _tx.topic = topic;
+  _tx.payload.reserve(size);
+  return 1;
+}
+
+size_t MqttClient::write(uint8_t const * buf, size_t size)
+{
+  _tx.payload.insert(_tx.payload.end(), buf, buf + size);
+  return size;
+}
+
+int MqttClient::endMessage()
+{
+  if (!connected())
+    return 0;
+
+  /* The write blocks until the send buffer has room for the message */
+  SimLinkConfig const & config = SimNet.config();
+  if (config.bandwidth_Bps > 0)
+  {
+    uint64_t const buffered_us = static_cast<uint64_t>(config.send_buffer) * 1000000 / config.bandwidth_Bps;
+    uint64_t const backlog_us = SimNet.backlog(SimDirection::Uplink);
+    if (backlog_us > buffered_us)
+      SimNet.advanceTo(SimNet.now() + backlog_us - buffered_us);
+  }
+
+  _tx.session = _session;
+  SimCloud.send(std::move(_tx));
+  return 1;
+}
+
+int MqttClient::read(uint8_t * buf, size_t size)
+{
+  size_t const bytes = std::min(size, _rx.payload.size() - _rx_pos);
+  memcpy(buf, _rx.payload.data() + _rx_pos, bytes);
+  _rx_pos += bytes;
+  return static_cast<int>(bytes);
+}
+
+/******************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void MqttClient::request(SimPacketType const type, String const & topic)
+{
+  SimPacket packet;
+  packet.type = type;
+  packet.session = _session;
+  packet.code = 0;
+  packet.dup = false;
+  packet.topic = topic;
+  SimCloud.send(std::move(packet));
+}
+
+bool MqttClient::waitFor(SimPacketType const type, SimPacket & reply)
+{
+  uint64_t const deadline_us = SimNet.now() + static_cast<uint64_t>(_connection_timeout) * 1000;
+
+  for (;;)
+  {
+    SimPacket packet;
+    while (SimCloud.receive(_session, packet))
+    {
+      if (packet.type == type)
+      {
+        reply = std::move(packet);
+        return true;
+      }
+      if (packet.type == SimPacketType::Publish)
+        dispatch(packet);
+    }
+
+    if (!connected() || (SimNet.now() >= deadline_us))
+      return false;
+
+    /* Nothing happens until the next packet arrives */
+    uint64_t const next_us = std::max(SimCloud.nextEvent(), SimNet.now() + 1);
+    SimNet.advanceTo(std::min(next_us, deadline_us));
+  }
+}
+
+void MqttClient::dispatch(SimPacket & packet)
+{
+  _rx = std::move(packet);
+  _rx_pos = 0;
+  if (_on_message)
+    _on_message(static_cast<int>(_rx.payload.size()));
+}
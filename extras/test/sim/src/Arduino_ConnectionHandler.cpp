@@ -0,0 +1,116 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino_ConnectionHandler.h>
+
+#include <string.h>
+
+#include <SimNetwork.h>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static size_t const NTP_PACKET_SIZE = 48;
+/* Payload plus the IP and UDP headers */
+static size_t const NTP_DATAGRAM_SIZE = NTP_PACKET_SIZE + 28;
+static unsigned long const SECONDS_FROM_1900_TO_1970 = 2208988800UL;
+
+/******************************************************************************
+   CTOR/DTOR
+ ******************************************************************************/
+
+ConnectionHandler::ConnectionHandler()
+: _status{NetworkConnectionState::INIT}
+, _client()
+, _udp()
+{
+
+}
+
+UDP::UDP()
+: _is_reply_pending{false}
+, _reply_arrival_us{0}
+, _requests{0}
+{
+
+}
+
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+NetworkConnectionState ConnectionHandler::check()
+{
+  if (!SimNet.isPhyUp())
+    _status = NetworkConnectionState::DISCONNECTED;
+  else if ((SimNet.now() - SimNet.phyUpSince()) < static_cast<uint64_t>(SimNet.config().phy_connect_ms) * 1000)
+    _status = NetworkConnectionState::CONNECTING;
+  else
+    _status = NetworkConnectionState::CONNECTED;
+  return _status;
+}
+
+uint8_t UDP::begin(uint16_t /* port */)
+{
+  return 1;
+}
+
+int UDP::beginPacket(char const * /* host */, uint16_t /* port */)
+{
+  return 1;
+}
+
+size_t UDP::write(uint8_t const * /* buf */, size_t size)
+{
+  return size;
+}
+
+int UDP::endPacket()
+{
+  _requests++;
+  _is_reply_pending = false;
+  if (!SimNet.isPhyUp())
+    return 0;
+
+  uint64_t request_arrival_us = 0;
+  if (!SimNet.datagram(SimDirection::Uplink, NTP_DATAGRAM_SIZE, SimNet.now(), request_arrival_us))
+    return 1;
+  _is_reply_pending = SimNet.datagram(SimDirection::Downlink, NTP_DATAGRAM_SIZE, request_arrival_us, _reply_arrival_us);
+  return 1;
+}
+
+int UDP::parsePacket()
+{
+  if (_is_reply_pending && (_reply_arrival_us <= SimNet.now()))
+    return NTP_PACKET_SIZE;
+
+  SimNet.advance(1);
+  return 0;
+}
+
+int UDP::read(uint8_t * buf, size_t size)
+{
+  if (!_is_reply_pending || (size < NTP_PACKET_SIZE))
+    return 0;
+
+  /* Only the transmit timestamp is evaluated */
+  unsigned long const secs_since_1900 = SimNet.epoch() + SECONDS_FROM_1900_TO_1970;
+  memset(buf, 0, NTP_PACKET_SIZE);
+  buf[40] = static_cast<uint8_t>(secs_since_1900 >> 24);
+  buf[41] = static_cast<uint8_t>(secs_since_1900 >> 16);
+  buf[42] = static_cast<uint8_t>(secs_since_1900 >>  8);
+  buf[43] = static_cast<uint8_t>(secs_since_1900);
+  _is_reply_pending = false;
+  return NTP_PACKET_SIZE;
+}
+
+void UDP::stop()
+{
+  _is_reply_pending = false;
+}
@@ -0,0 +1,47 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino_DebugUtils.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <SimNetwork.h>
+
+/******************************************************************************
+   CTOR/DTOR
+ ******************************************************************************/
+
+Arduino_DebugUtils::Arduino_DebugUtils()
+: _level{DBG_NONE}
+{
+
+}
+
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void Arduino_DebugUtils::print(int const level, char const * fmt, ...)
+{
+  if (level > _level)
+    return;
+
+  printf("[%9lu] ", SimNet.nowMillis());
+  va_list args;
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+  printf("\n");
+}
+
+/******************************************************************************
+   EXTERN DEFINITION
+ ******************************************************************************/
+
+Arduino_DebugUtils Debug;
@@ -0,0 +1,379 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <SimBroker.h>
+
+#include <algorithm>
+
+#include <cbor/lib/tinycbor/cbor-lib.h>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+/* See ArduinoMqttClient */
+static int const MQTT_CONNACK_ACCEPTED           = 0;
+static int const MQTT_CONNACK_SERVER_UNAVAILABLE = 3;
+
+/* See CborIntegerMapKey */
+static int const CBOR_KEY_NAME         = 0;
+static int const CBOR_KEY_VALUE        = 2;
+static int const CBOR_KEY_STRING_VALUE = 3;
+static int const CBOR_KEY_DATA_VALUE   = 8;
+
+/* [{0: "r:m", 3: "getLastValues"}], see ArduinoIoTCloudTCP::requestLastValue */
+static uint8_t const CBOR_REQUEST_LAST_VALUE_MSG[] = { 0x81, 0xA2, 0x00, 0x63, 0x72, 0x3A, 0x6D, 0x03, 0x6D, 0x67, 0x65, 0x74, 0x4C, 0x61, 0x73, 0x74, 0x56, 0x61, 0x6C, 0x75, 0x65, 0x73 };
+/* [{0: "r:m", 3: "getTimezone"}], see ArduinoIoTCloudTCP::requestTimezone */
+static uint8_t const CBOR_REQUEST_TIMEZONE_MSG[] = { 0x81, 0xA2, 0x00, 0x63, 0x72, 0x3A, 0x6D, 0x03, 0x6B, 0x67, 0x65, 0x74, 0x54, 0x69, 0x6D, 0x65, 0x7A, 0x6F, 0x6E, 0x65 };
+
+/******************************************************************************
+   CTOR/DTOR
+ ******************************************************************************/
+
+SimBroker::SimBroker()
+: _device_id{""}
+, _thing_id{""}
+, _available{true}
+, _answer_last_values{true}
+, _answer_timezone{true}
+, _tz_offset{3600}
+, _tz_valid_for_s{30 * 24 * 60 * 60UL}
+, _stats()
+{
+
+}
+
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void SimBroker::reset(char const * device_id, char const * thing_id)
+{
+  _device_id = device_id;
+  _thing_id = thing_id;
+  _available = true;
+  _answer_last_values = true;
+  _answer_timezone = true;
+  _tz_offset = 3600;
+  _tz_valid_for_s = 30 * 24 * 60 * 60UL;
+  _uplink.clear();
+  _downlink.clear();
+  _subscriptions.clear();
+  _last_publish = SimPacket();
+  _unreachable.clear();
+  _stats = SimBrokerStats();
+}
+
+void SimBroker::send(SimPacket packet)
+{
+  size_t const bytes = PACKET_OVERHEAD + packet.topic.size() + packet.payload.size();
+  packet.sent_us = SimNet.now();
+  packet.arrival_us = SimNet.transmit(SimDirection::Uplink, bytes, packet.sent_us);
+  _uplink.push_back(std::move(packet));
+}
+
+bool SimBroker::receive(uint32_t const session, SimPacket & packet)
+{
+  run();
+
+  /* Whatever was on the way on a dropped connection is lost */
+  while (!_downlink.empty() && (_downlink.front().session != session))
+    _downlink.pop_front();
+
+  if (_downlink.empty() || (_downlink.front().arrival_us > SimNet.now()))
+    return false;
+
+  packet = std::move(_downlink.front());
+  _downlink.pop_front();
+  return true;
+}
+
+void SimBroker::run()
+{
+  while (!_uplink.empty() && (_uplink.front().arrival_us <= SimNet.now()))
+  {
+    SimPacket const packet = std::move(_uplink.front());
+    _uplink.pop_front();
+    if (packet.session == SimNet.session())
+      handle(packet);
+  }
+}
+
+uint64_t SimBroker::nextEvent() const
+{
+  uint64_t next_us = UINT64_MAX;
+  if (!_uplink.empty())
+    next_us = std::min(next_us, _uplink.front().arrival_us);
+  if (!_downlink.empty())
+    next_us = std::min(next_us, _downlink.front().arrival_us);
+  return next_us;
+}
+
+uint64_t SimBroker::nextDownlink() const
+{
+  return _downlink.empty() ? UINT64_MAX : _downlink.front().arrival_us;
+}
+
+void SimBroker::writeProperty(std::string const & name, int const value, std::string const & thing_id)
+{
+  std::string const topic = thing_id.empty() ? dataTopicIn() : ("/a/t/" + thing_id + "/e/i");
+  publish(SimNet.now(), SimNet.session(), topic, encodeProperty(name, value));
+}
+
+void SimBroker::attachThing(std::string const & thing_id)
+{
+  _thing_id = thing_id;
+  publish(SimNet.now(), SimNet.session(), deviceTopicIn(), encodeThingId());
+}
+
+void SimBroker::writeDeviceProperty(std::string const & name, std::vector<uint8_t> const & value)
+{
+  publish(SimNet.now(), SimNet.session(), deviceTopicIn(), encodeProperty(name, value));
+}
+
+void SimBroker::writeDeviceProperty(std::string const & name, int const value)
+{
+  publish(SimNet.now(), SimNet.session(), deviceTopicIn(), encodeProperty(name, value));
+}
+
+void SimBroker::redeliver()
+{
+  if (_last_publish.topic.empty())
+    return;
+
+  SimPacket packet = _last_publish;
+  packet.session = SimNet.session();
+  packet.sent_us = SimNet.now();
+  packet.arrival_us = SimNet.transmit(SimDirection::Downlink, PACKET_OVERHEAD + packet.topic.size() + packet.payload.size(), packet.sent_us);
+  packet.dup = true;
+  _downlink.push_back(std::move(packet));
+}
+
+/******************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void SimBroker::handle(SimPacket const & packet)
+{
+  switch (packet.type)
+  {
+  case SimPacketType::Connect:
+    if (!_available)
+    {
+      _stats.refused++;
+      reply(packet, SimPacketType::ConnAck, MQTT_CONNACK_SERVER_UNAVAILABLE);
+      return;
+    }
+    _stats.connects++;
+    _subscriptions.clear();
+    reply(packet, SimPacketType::ConnAck, MQTT_CONNACK_ACCEPTED);
+    return;
+
+  case SimPacketType::Subscribe:
+    _stats.subscribes++;
+    _subscriptions.insert(packet.topic);
+    reply(packet, SimPacketType::SubAck, 0);
+    /* The device configuration is sent as soon as the device listens for it */
+    if (packet.topic == deviceTopicIn())
+      publish(packet.arrival_us, packet.session, packet.topic, encodeThingId());
+    return;
+
+  case SimPacketType::Unsubscribe:
+    _stats.unsubscribes++;
+    _subscriptions.erase(packet.topic);
+    reply(packet, SimPacketType::UnsubAck, 0);
+    return;
+
+  case SimPacketType::Publish:
+    if (packet.topic == deviceTopicOut())
+    {
+      bool const is_timezone_request = (packet.payload.size() == sizeof(CBOR_REQUEST_TIMEZONE_MSG)) &&
+                                       std::equal(packet.payload.begin(), packet.payload.end(), CBOR_REQUEST_TIMEZONE_MSG);
+      if (is_timezone_request)
+      {
+        _stats.timezone_requests++;
+        if (_answer_timezone)
+          publish(packet.arrival_us, packet.session, deviceTopicIn(), encodeTimezone(packet.arrival_us));
+      }
+      else
+      {
+        _stats.device_messages++;
+      }
+    }
+    else if (packet.topic == shadowTopicOut())
+    {
+      bool const is_last_value_request = (packet.payload.size() == sizeof(CBOR_REQUEST_LAST_VALUE_MSG)) &&
+                                         std::equal(packet.payload.begin(), packet.payload.end(), CBOR_REQUEST_LAST_VALUE_MSG);
+      if (is_last_value_request)
+      {
+        _stats.last_value_requests++;
+        if (_answer_last_values)
+          publish(packet.arrival_us, packet.session, shadowTopicIn(), encodeLastValues(packet.arrival_us));
+      }
+    }
+    else if (packet.topic == dataTopicOut())
+    {
+      uint64_t const latency_us = packet.arrival_us - packet.sent_us;
+      _stats.data_messages++;
+      _stats.data_bytes += packet.payload.size();
+      _stats.data_latency_sum_us += latency_us;
+      _stats.data_latency_max_us = std::max(_stats.data_latency_max_us, latency_us);
+      _stats.last_data_arrival_us = packet.arrival_us;
+    }
+    else if (isThingTopic(packet.topic, "/shadow/o"))
+    {
+      /* A thing behind the device acting as a gateway, which has no values yet */
+      static std::vector<uint8_t> const NO_LAST_VALUES = {0x80};
+      _stats.gateway_last_value_requests++;
+      std::string const reply_topic = packet.topic.substr(0, packet.topic.size() - 1) + "i";
+      if (_answer_last_values)
+        publish(packet.arrival_us, packet.session, reply_topic, NO_LAST_VALUES);
+    }
+    else if (isThingTopic(packet.topic, "/e/o"))
+    {
+      _stats.gateway_data_messages++;
+    }
+    return;
+
+  case SimPacketType::PingReq:
+    _stats.pings++;
+    reply(packet, SimPacketType::PingResp, 0);
+    return;
+
+  case SimPacketType::ConnAck:
+  case SimPacketType::SubAck:
+  case SimPacketType::UnsubAck:
+  case SimPacketType::PingResp:
+    return;
+  }
+}
+
+bool SimBroker::isThingTopic(std::string const & topic, std::string const & suffix)
+{
+  static std::string const PREFIX = "/a/t/";
+  return (topic.size() > PREFIX.size() + suffix.size()) &&
+         (topic.compare(0, PREFIX.size(), PREFIX) == 0) &&
+         (topic.compare(topic.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+void SimBroker::reply(SimPacket const & request, SimPacketType const type, int const code)
+{
+  SimPacket packet;
+  packet.type = type;
+  packet.session = request.session;
+  packet.sent_us = request.arrival_us;
+  packet.arrival_us = SimNet.transmit(SimDirection::Downlink, PACKET_OVERHEAD, packet.sent_us);
+  packet.code = code;
+  packet.dup = false;
+  _downlink.push_back(std::move(packet));
+}
+
+void SimBroker::publish(uint64_t const send_us, uint32_t const session, std::string const & topic, std::vector<uint8_t> const & payload)
+{
+  if (_subscriptions.find(topic) == _subscriptions.end())
+    return;
+
+  SimPacket packet;
+  packet.type = SimPacketType::Publish;
+  packet.session = session;
+  packet.sent_us = send_us;
+  packet.arrival_us = SimNet.transmit(SimDirection::Downlink, PACKET_OVERHEAD + topic.size() + payload.size(), send_us);
+  packet.code = 0;
+  packet.dup = false;
+  packet.topic = topic;
+  packet.payload = payload;
+  _last_publish = packet;
+  _downlink.push_back(std::move(packet));
+}
+
+std::vector<uint8_t> SimBroker::encodeThingId() const
+{
+  /* [{0: "thing_id", 3: <thing id>}] */
+  uint8_t buf[128];
+  CborEncoder encoder, array, map;
+  cbor_encoder_init(&encoder, buf, sizeof(buf), 0);
+  cbor_encoder_create_array(&encoder, &array, 1);
+  cbor_encoder_create_map(&array, &map, 2);
+  cbor_encode_int(&map, CBOR_KEY_NAME);
+  cbor_encode_text_stringz(&map, "thing_id");
+  cbor_encode_int(&map, CBOR_KEY_STRING_VALUE);
+  cbor_encode_text_stringz(&map, _thing_id.c_str());
+  cbor_encoder_close_container(&array, &map);
+  cbor_encoder_close_container(&encoder, &array);
+  return std::vector<uint8_t>(buf, buf + cbor_encoder_get_buffer_size(&encoder, buf));
+}
+
+std::vector<uint8_t> SimBroker::encodeLastValues(uint64_t const time_us) const
+{
+  /* The thing has no other properties the cloud keeps values of */
+  return encodeTimezone(time_us);
+}
+
+std::vector<uint8_t> SimBroker::encodeTimezone(uint64_t const time_us) const
+{
+  /* [{0: "tz_offset", 2: <offset>}, {0: "tz_dst_until", 2: <time>}] */
+  unsigned long const epoch = SimNet.epoch() - static_cast<unsigned long>((SimNet.now() - std::min(SimNet.now(), time_us)) / 1000000);
+  uint8_t buf[128];
+  CborEncoder encoder, array, map;
+  cbor_encoder_init(&encoder, buf, sizeof(buf), 0);
+  cbor_encoder_create_array(&encoder, &array, 2);
+  cbor_encoder_create_map(&array, &map, 2);
+  cbor_encode_int(&map, CBOR_KEY_NAME);
+  cbor_encode_text_stringz(&map, "tz_offset");
+  cbor_encode_int(&map, CBOR_KEY_VALUE);
+  cbor_encode_int(&map, _tz_offset);
+  cbor_encoder_close_container(&array, &map);
+  cbor_encoder_create_map(&array, &map, 2);
+  cbor_encode_int(&map, CBOR_KEY_NAME);
+  cbor_encode_text_stringz(&map, "tz_dst_until");
+  cbor_encode_int(&map, CBOR_KEY_VALUE);
+  cbor_encode_uint(&map, epoch + _tz_valid_for_s);
+  cbor_encoder_close_container(&array, &map);
+  cbor_encoder_close_container(&encoder, &array);
+  return std::vector<uint8_t>(buf, buf + cbor_encoder_get_buffer_size(&encoder, buf));
+}
+
+std::vector<uint8_t> SimBroker::encodeProperty(std::string const & name, int const value) const
+{
+  /* [{0: <name>, 2: <value>}] */
+  uint8_t buf[128];
+  CborEncoder encoder, array, map;
+  cbor_encoder_init(&encoder, buf, sizeof(buf), 0);
+  cbor_encoder_create_array(&encoder, &array, 1);
+  cbor_encoder_create_map(&array, &map, 2);
+  cbor_encode_int(&map, CBOR_KEY_NAME);
+  cbor_encode_text_stringz(&map, name.c_str());
+  cbor_encode_int(&map, CBOR_KEY_VALUE);
+  cbor_encode_int(&map, value);
+  cbor_encoder_close_container(&array, &map);
+  cbor_encoder_close_container(&encoder, &array);
+  return std::vector<uint8_t>(buf, buf + cbor_encoder_get_buffer_size(&encoder, buf));
+}
+
+std::vector<uint8_t> SimBroker::encodeProperty(std::string const & name, std::vector<uint8_t> const & value) const
+{
+  /* [{0: <name>, 8: <value>}] */
+  uint8_t buf[256];
+  CborEncoder encoder, array, map;
+  cbor_encoder_init(&encoder, buf, sizeof(buf), 0);
+  cbor_encoder_create_array(&encoder, &array, 1);
+  cbor_encoder_create_map(&array, &map, 2);
+  cbor_encode_int(&map, CBOR_KEY_NAME);
+  cbor_encode_text_stringz(&map, name.c_str());
+  cbor_encode_int(&map, CBOR_KEY_DATA_VALUE);
+  cbor_encode_byte_string(&map, value.data(), value.size());
+  cbor_encoder_close_container(&array, &map);
+  cbor_encoder_close_container(&encoder, &array);
+  return std::vector<uint8_t>(buf, buf + cbor_encoder_get_buffer_size(&encoder, buf));
+}
+
+/******************************************************************************
+   EXTERN DEFINITION
+ ******************************************************************************/
+
+SimBroker SimCloud;
@@ -0,0 +1,123 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <SimDevice.h>
+
+#include <new>
+#include <algorithm>
+
+/******************************************************************************
+   STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+char const SimDevice::DEVICE_ID[] = "5f4f0c1a-9bd4-4c8f-8d0e-6c7e5a1b2c3d";
+char const SimDevice::THING_ID[]  = "a3b5c7d9-1e2f-4a6b-8c0d-2e4f6a8b0c1e";
+
+ConnectionHandler SimDevice::_connection;
+SimSketchFunc SimDevice::_loop = nullptr;
+unsigned long SimDevice::_loop_ms = 1;
+bool SimDevice::_data_ready_signal = false;
+unsigned int SimDevice::_sync_cnt = 0;
+unsigned int SimDevice::_disconnect_cnt = 0;
+uint64_t SimDevice::_last_sync_us = 0;
+
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void SimDevice::begin(SimLinkConfig const & link, uint32_t const seed, SimSketchFunc setup, unsigned long const loop_ms)
+{
+  SimNet.reset(link, seed);
+  SimCloud.reset(DEVICE_ID, THING_ID);
+
+  /* Either is a global of the library, as on the device they start from scratch */
+  ArduinoCloud.~ArduinoIoTCloudTCP();
+  TimeService.~TimeServiceClass();
+  new (&TimeService) TimeServiceClass();
+  new (&ArduinoCloud) ArduinoIoTCloudTCP();
+  new (&_connection) ConnectionHandler();
+
+  _loop = nullptr;
+  _loop_ms = loop_ms;
+  _data_ready_signal = false;
+  _sync_cnt = 0;
+  _disconnect_cnt = 0;
+  _last_sync_us = 0;
+
+  if (setup)
+    setup();
+
+  ArduinoCloud.setDeviceId(DEVICE_ID);
+  ArduinoCloud.addCallback(ArduinoIoTCloudEvent::SYNC, onSync);
+  ArduinoCloud.addCallback(ArduinoIoTCloudEvent::DISCONNECT, onDisconnect);
+  ArduinoCloud.begin(_connection, false);
+}
+
+void SimDevice::step()
+{
+  if (_data_ready_signal && (SimCloud.nextDownlink() <= SimNet.now()))
+    ArduinoCloud.notifyDataReady();
+
+  ArduinoCloud.update();
+  if (_loop)
+    _loop();
+
+  /* A sketch with a loop runs it every period. Without one the device
+   * sleeps while there is nothing to do, but wakes up for the next packet.
+   */
+  uint64_t const now_us = SimNet.now();
+  uint64_t const loop_us = static_cast<uint64_t>(_loop_ms) * 1000;
+  if (_loop)
+  {
+    SimNet.advanceTo(now_us + loop_us);
+    return;
+  }
+  uint64_t const next_event_us = SimCloud.nextEvent();
+  uint64_t wait_us = static_cast<uint64_t>(ArduinoCloud.nextUpdateIn()) * 1000;
+  if (next_event_us != UINT64_MAX)
+    wait_us = std::min(wait_us, (next_event_us > now_us) ? (next_event_us - now_us) : 0);
+  SimNet.advanceTo(now_us + std::max(wait_us, loop_us));
+}
+
+void SimDevice::setDataReadySignal(bool const enabled)
+{
+  _data_ready_signal = enabled;
+  if (enabled)
+    ArduinoCloud.notifyDataReady();
+}
+
+void SimDevice::run(unsigned long const ms)
+{
+  uint64_t const end_us = SimNet.now() + static_cast<uint64_t>(ms) * 1000;
+  while (SimNet.now() < end_us)
+    step();
+}
+
+bool SimDevice::runUntilConnected(unsigned long const timeout_ms)
+{
+  unsigned int const sync_cnt = _sync_cnt;
+  uint64_t const end_us = SimNet.now() + static_cast<uint64_t>(timeout_ms) * 1000;
+  while ((_sync_cnt == sync_cnt) && (SimNet.now() < end_us))
+    step();
+  return (_sync_cnt != sync_cnt);
+}
+
+/******************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void SimDevice::onSync()
+{
+  _sync_cnt++;
+  _last_sync_us = SimNet.now();
+}
+
+void SimDevice::onDisconnect()
+{
+  _disconnect_cnt++;
+}
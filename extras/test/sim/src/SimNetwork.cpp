@@ -0,0 +1,186 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <SimNetwork.h>
+
+#include <time.h>
+
+#include <algorithm>
+
+#include <Arduino.h>
+
+#include <util/ClockTestUtil.h>
+
+/******************************************************************************
+   CONSTANTS
+ ******************************************************************************/
+
+static SimLinkConfig const DEFAULT_LINK_CONFIG =
+{
+  50,   /* rtt_ms         */
+  0.0f, /* loss           */
+  0,    /* bandwidth_Bps  */
+  2048, /* send_buffer    */
+  0,    /* tls_compute_ms */
+  0,    /* phy_connect_ms */
+  0,    /* nat_timeout_ms */
+};
+
+/******************************************************************************
+   STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t        const SimNetwork::SEGMENT_SIZE;
+unsigned long const SimNetwork::MIN_RTO_ms;
+
+/******************************************************************************
+   CTOR/DTOR
+ ******************************************************************************/
+
+SimNetwork::SimNetwork()
+: _config(DEFAULT_LINK_CONFIG)
+, _now_us{0}
+, _link_free_us{0, 0}
+, _last_arrival_us{0, 0}
+, _last_activity_us{0}
+, _rand_state{1}
+, _session{0}
+, _drop_detect_us{0}
+, _phy_up{true}
+, _phy_up_us{0}
+, _epoch_base{static_cast<unsigned long>(::time(nullptr))}
+{
+
+}
+
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void SimNetwork::reset(SimLinkConfig const & config, uint32_t const seed)
+{
+  _config = config;
+  _now_us = 0;
+  _link_free_us[0] = _link_free_us[1] = 0;
+  _last_arrival_us[0] = _last_arrival_us[1] = 0;
+  _last_activity_us = 0;
+  _rand_state = (seed != 0) ? seed : 1;
+  _session++;
+  _drop_detect_us = 0;
+  _phy_up = true;
+  _phy_up_us = 0;
+  VirtualClock::reset(_epoch_base);
+}
+
+void SimNetwork::advance(unsigned long const ms)
+{
+  advanceTo(_now_us + static_cast<uint64_t>(ms) * 1000);
+}
+
+void SimNetwork::advanceTo(uint64_t const time_us)
+{
+  _now_us = std::max(_now_us, time_us);
+  VirtualClock::advanceTo(_now_us);
+}
+
+unsigned long SimNetwork::epoch() const
+{
+  return VirtualClock::getTime();
+}
+
+uint64_t SimNetwork::transmit(SimDirection const dir, size_t const bytes, uint64_t const send_us)
+{
+  size_t const d = static_cast<size_t>(dir);
+
+  /* The NAT has forgotten an idle connection, the peer answers with a reset */
+  if ((_config.nat_timeout_ms > 0) && ((send_us - _last_activity_us) > static_cast<uint64_t>(_config.nat_timeout_ms) * 1000))
+    drop(_config.rtt_ms);
+  _last_activity_us = std::max(_last_activity_us, send_us);
+
+  /* Serialised behind the bytes queued before */
+  uint64_t const start_us = std::max(send_us, _link_free_us[d]);
+  uint64_t const tx_us = (_config.bandwidth_Bps > 0) ? (static_cast<uint64_t>(bytes) * 1000000 / _config.bandwidth_Bps) : 0;
+  _link_free_us[d] = start_us + tx_us;
+
+  /* Every lost segment is retransmitted after a timeout which doubles on each loss */
+  uint64_t const rto_us = static_cast<uint64_t>(std::max(MIN_RTO_ms, 2 * _config.rtt_ms)) * 1000;
+  uint64_t retransmit_us = 0;
+  size_t const segments = (bytes + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+  for (size_t s = 0; s < std::max(segments, static_cast<size_t>(1)); s++)
+  {
+    uint64_t rto = rto_us;
+    uint64_t segment_retransmit_us = 0;
+    while (isLost())
+    {
+      segment_retransmit_us += rto;
+      rto *= 2;
+    }
+    retransmit_us = std::max(retransmit_us, segment_retransmit_us);
+  }
+
+  uint64_t const arrival_us = _link_free_us[d] + static_cast<uint64_t>(_config.rtt_ms) * 500 + retransmit_us;
+  _last_arrival_us[d] = std::max(_last_arrival_us[d], arrival_us);
+  return _last_arrival_us[d];
+}
+
+bool SimNetwork::datagram(SimDirection const dir, size_t const bytes, uint64_t const send_us, uint64_t & arrival_us)
+{
+  uint64_t const tx_us = (_config.bandwidth_Bps > 0) ? (static_cast<uint64_t>(bytes) * 1000000 / _config.bandwidth_Bps) : 0;
+  arrival_us = std::max(send_us, _link_free_us[static_cast<size_t>(dir)]) + tx_us + static_cast<uint64_t>(_config.rtt_ms) * 500;
+  return !isLost();
+}
+
+uint64_t SimNetwork::backlog(SimDirection const dir) const
+{
+  uint64_t const link_free_us = _link_free_us[static_cast<size_t>(dir)];
+  return (link_free_us > _now_us) ? (link_free_us - _now_us) : 0;
+}
+
+void SimNetwork::drop(unsigned long const detect_ms)
+{
+  _session++;
+  _drop_detect_us = _now_us + static_cast<uint64_t>(detect_ms) * 1000;
+  _link_free_us[0] = _link_free_us[1] = _now_us;
+  _last_arrival_us[0] = _last_arrival_us[1] = _now_us;
+}
+
+void SimNetwork::open()
+{
+  _last_activity_us = _now_us;
+}
+
+void SimNetwork::setPhyUp(bool const up)
+{
+  if (up && !_phy_up)
+    _phy_up_us = _now_us;
+  if (!up && _phy_up)
+    drop();
+  _phy_up = up;
+}
+
+/******************************************************************************
+   PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool SimNetwork::isLost()
+{
+  if (_config.loss <= 0.0f)
+    return false;
+
+  /* xorshift32, the scenario replays identically for the same seed */
+  _rand_state ^= _rand_state << 13;
+  _rand_state ^= _rand_state >> 17;
+  _rand_state ^= _rand_state << 5;
+  return (static_cast<float>(_rand_state) / 4294967296.0f) < _config.loss;
+}
+
+/******************************************************************************
+   EXTERN DEFINITION
+ ******************************************************************************/
+
+SimNetwork SimNet;
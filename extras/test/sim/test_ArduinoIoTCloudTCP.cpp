@@ -0,0 +1,952 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <SimDevice.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static unsigned long const CONNECT_TIMEOUT_ms = 120 * 1000UL;
+
+static SimLinkConfig const LAN_LINK   = { 20, 0.00f,     0, 2048,   0,    0,      0};
+static SimLinkConfig const LOSSY_LINK = {150, 0.05f, 16000, 2048, 300, 2000,      0};
+static SimLinkConfig const NAT_LINK   = { 20, 0.00f,     0, 2048,   0,    0, 300000};
+
+/**************************************************************************************
+   SKETCH
+ **************************************************************************************/
+
+static int counter = 0;
+
+static void setupCounter()
+{
+  counter = 0;
+  ArduinoCloud.addProperty(counter, Permission::ReadWrite);
+}
+
+static void countEverySecond()
+{
+  counter = static_cast<int>(millis() / 1000);
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The device connects to the cloud", "[ArduinoIoTCloudTCP]")
+{
+  WHEN("the link is fast")
+  {
+    SimDevice::begin(LAN_LINK, 1);
+    REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+
+    THEN("it is connected within a few round trips")
+    {
+      /* TCP, TLS, MQTT connect, three subscriptions and the last values,
+       * the NTP reply is received meanwhile.
+       */
+      REQUIRE(SimDevice::lastSyncTime() < 11 * LAN_LINK.rtt_ms * 1000);
+      REQUIRE(ArduinoCloud.connected());
+      REQUIRE(ArduinoCloud.getThingId() == SimDevice::THING_ID);
+      REQUIRE(SimCloud.stats().connects == 1);
+      REQUIRE(SimCloud.stats().device_messages == 1);
+      REQUIRE(SimCloud.stats().last_value_requests == 1);
+      /* The simulated client does not resume TLS sessions */
+      REQUIRE(ArduinoCloud.lastTlsHandshake() == TlsHandshake::Full);
+    }
+
+    THEN("the heap is locked from then on")
+    {
+      SimDevice::run(1000);
+      REQUIRE(StaticArena::isHeapLocked());
+    }
+
+    THEN("its time advances by the millisecond")
+    {
+      uint64_t const time_ms = ArduinoCloud.getInternalTimeMillis();
+      unsigned long const tick = millis();
+      REQUIRE(time_ms / 1000 >= ArduinoCloud.getInternalTime() - 1);
+      /* The device sleeps meanwhile, possibly for longer */
+      SimDevice::run(250);
+      REQUIRE(ArduinoCloud.getInternalTimeMillis() - time_ms == millis() - tick);
+    }
+  }
+
+  WHEN("segments are lost on a slow link")
+  {
+    SimDevice::begin(LOSSY_LINK, 7);
+    THEN("it connects nonetheless")
+    {
+      REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+      REQUIRE(ArduinoCloud.connected());
+    }
+  }
+
+  WHEN("the same scenario is run twice")
+  {
+    SimDevice::begin(LOSSY_LINK, 42);
+    REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+    uint64_t const first_us = SimDevice::lastSyncTime();
+    SimDevice::begin(LOSSY_LINK, 42);
+    REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+
+    THEN("it takes the same course")
+    {
+      REQUIRE(SimDevice::lastSyncTime() == first_us);
+    }
+  }
+}
+
+SCENARIO("The device sends its properties to the cloud", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupCounter);
+  SimDevice::setLoop(countEverySecond);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  SimCloud.clearStats();
+
+  WHEN("the property changes once per second for 10 s")
+  {
+    SimDevice::run(10 * 1000UL);
+    THEN("each change is received by the broker")
+    {
+      REQUIRE(SimCloud.stats().data_messages >= 9);
+      REQUIRE(SimCloud.stats().data_messages <= 11);
+    }
+  }
+}
+
+SCENARIO("The device polls the broker only when data has arrived", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupCounter);
+  SimDevice::setDataReadySignal(true);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  SimDevice::setLoop(countEverySecond);
+
+  WHEN("the device is idle for 10 s with a loop running every ms")
+  {
+    unsigned long const poll_cnt = MqttClient::pollCount();
+    SimDevice::run(10 * 1000UL);
+    THEN("the broker is polled about once per second and the device stays connected")
+    {
+      REQUIRE(MqttClient::pollCount() - poll_cnt <= 20);
+      REQUIRE(ArduinoCloud.connected());
+      REQUIRE(SimCloud.stats().data_messages >= 9);
+    }
+  }
+
+  WHEN("the cloud writes a property")
+  {
+    SimDevice::setLoop(nullptr);
+    SimDevice::run(1000);
+    uint64_t const write_us = SimNet.now();
+    SimCloud.writeProperty("counter", 1234);
+    while ((counter != 1234) && (SimNet.now() - write_us < 5 * 1000 * 1000UL))
+      SimDevice::step();
+    THEN("it is received as soon as it has arrived")
+    {
+      REQUIRE(counter == 1234);
+      REQUIRE(SimNet.now() - write_us <= (LAN_LINK.rtt_ms / 2 + 2) * 1000);
+    }
+  }
+}
+
+static unsigned int counter_update_cnt = 0;
+
+static void onCounterUpdate()
+{
+  counter_update_cnt++;
+}
+
+static void setupCounterCallback()
+{
+  counter = 0;
+  counter_update_cnt = 0;
+  ArduinoCloud.addProperty(counter, Permission::ReadWrite).onUpdate(onCounterUpdate);
+}
+
+SCENARIO("The device applies a command delivered again only once", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupCounterCallback);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+
+  SimCloud.writeProperty("counter", 1234);
+  SimDevice::run(1000);
+  REQUIRE(counter == 1234);
+  REQUIRE(counter_update_cnt == 1);
+  unsigned int const data_messages = SimCloud.stats().data_messages;
+
+  WHEN("the broker delivers the command again")
+  {
+    SimCloud.redeliver();
+    SimDevice::run(1000);
+
+    THEN("it is neither applied nor echoed again")
+    {
+      REQUIRE(counter_update_cnt == 1);
+      REQUIRE(SimCloud.stats().data_messages == data_messages);
+    }
+  }
+
+  WHEN("the cloud writes another value")
+  {
+    SimCloud.writeProperty("counter", 4321);
+    SimDevice::run(1000);
+
+    THEN("it is applied")
+    {
+      REQUIRE(counter == 4321);
+      REQUIRE(counter_update_cnt == 2);
+    }
+  }
+}
+
+class CountingSink : public MessageSink
+{
+public:
+  virtual bool deliver(uint8_t const * /* data */, size_t const /* length */, bool const /* is_timestamped */) override {
+    if (is_busy)
+      return false;
+    delivered++;
+    return true;
+  }
+  bool is_busy = false;
+  unsigned int delivered = 0;
+};
+
+static CountingSink counting_sink;
+
+static void setupCounterWithSink()
+{
+  setupCounter();
+  counting_sink = CountingSink();
+  ArduinoCloud.addMessageSink(counting_sink);
+}
+
+SCENARIO("The device offers the updates sent to the cloud to a sink", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupCounterWithSink);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  SimDevice::run(1000);
+  unsigned int const data_messages = SimCloud.stats().data_messages;
+  unsigned int const delivered = counting_sink.delivered;
+
+  WHEN("the property changes")
+  {
+    counter = 5;
+    SimDevice::run(1000);
+
+    THEN("the sink takes the message sent to the cloud")
+    {
+      REQUIRE(SimCloud.stats().data_messages == data_messages + 1);
+      REQUIRE(counting_sink.delivered == delivered + 1);
+    }
+  }
+
+  WHEN("the sink is busy while the property changes")
+  {
+    counting_sink.is_busy = true;
+    counter = 5;
+    SimDevice::run(1000);
+    REQUIRE(SimCloud.stats().data_messages == data_messages + 1);
+    REQUIRE(counting_sink.delivered == delivered);
+
+    counting_sink.is_busy = false;
+    counter = 6;
+    SimDevice::run(1000);
+
+    THEN("it is offered the message again, the cloud is not")
+    {
+      REQUIRE(SimCloud.stats().data_messages == data_messages + 2);
+      REQUIRE(counting_sink.delivered == delivered + 2);
+    }
+  }
+}
+
+SCENARIO("The cloud captures the trace of the device", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupCounter);
+  SimDevice::setLoop(countEverySecond);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  uint32_t const trace_cnt = trace_buffer().recordCount();
+  SimDevice::run(2000);
+  REQUIRE(trace_buffer().recordCount() == trace_cnt);
+  unsigned int const device_messages = SimCloud.stats().device_messages;
+
+  WHEN("a capture of 2 s is requested")
+  {
+    SimCloud.writeDeviceProperty("TRACE_REQ", 2);
+    SimDevice::run(1000);
+
+    THEN("the trace points are recorded for that long")
+    {
+      REQUIRE(trace_buffer().isEnabled());
+      REQUIRE(trace_buffer().recordCount() > 0);
+      REQUIRE(SimCloud.stats().device_messages == device_messages);
+    }
+
+    SimDevice::run(10 * 1000UL);
+
+    THEN("the records are then uploaded in chunks, one per second")
+    {
+      size_t const max_chunks = (TraceBuffer::SIZE * sizeof(TraceRecord) + AIOT_CONFIG_TRACE_CAPTURE_CHUNK_SIZE - TraceCapture::CHUNK_HEADER_SIZE - 1) / (AIOT_CONFIG_TRACE_CAPTURE_CHUNK_SIZE - TraceCapture::CHUNK_HEADER_SIZE);
+      REQUIRE_FALSE(trace_buffer().isEnabled());
+      REQUIRE(SimCloud.stats().device_messages > device_messages);
+      REQUIRE(SimCloud.stats().device_messages <= device_messages + max_chunks);
+    }
+  }
+}
+
+SCENARIO("The device reconnects after the connection is lost", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupCounter);
+  SimDevice::setLoop(countEverySecond);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+
+  WHEN("the connection is reset")
+  {
+    SimNet.drop();
+    THEN("the device connects again")
+    {
+      REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+      REQUIRE(SimDevice::disconnectCount() >= 1);
+      REQUIRE(SimCloud.stats().connects == 2);
+    }
+  }
+
+  WHEN("the device notices the loss only after a while")
+  {
+    SimDevice::run(2500);
+    SimNet.drop(5000);
+    SimDevice::run(3000);
+    SimDevice::setLoop(nullptr);
+    SimCloud.clearStats();
+
+    THEN("the properties of the messages sent meanwhile are sent again in one message")
+    {
+      REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+      /* After the publish hold of the rate control following a retransmission */
+      SimDevice::run(AIOT_CONFIG_RATE_CONTROL_MIN_HOLD_ms + 100);
+      REQUIRE(SimCloud.stats().data_messages == 1);
+    }
+  }
+
+  WHEN("the broker refuses connections for a minute")
+  {
+    SimCloud.setAvailable(false);
+    SimNet.drop();
+    SimDevice::run(60 * 1000UL);
+    unsigned int const refused = SimCloud.stats().refused;
+    SimCloud.setAvailable(true);
+
+    THEN("the device backs off and connects once the broker is back")
+    {
+      REQUIRE(refused >= 1);
+      REQUIRE(refused <= 10);
+      REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+    }
+  }
+}
+
+SCENARIO("The device is attached to another thing", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupCounter);
+  SimDevice::setDataReadySignal(true);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  SimCloud.clearStats();
+
+  WHEN("the cloud repeats the thing id")
+  {
+    SimCloud.attachThing(SimDevice::THING_ID);
+    SimDevice::run(5000);
+
+    THEN("the thing topics are kept")
+    {
+      REQUIRE(ArduinoCloud.connected());
+      REQUIRE(SimCloud.stats().subscribes == 0);
+      REQUIRE(SimCloud.stats().unsubscribes == 0);
+      REQUIRE(SimCloud.stats().last_value_requests == 0);
+    }
+  }
+
+  WHEN("the cloud sends a new thing id")
+  {
+    char const NEW_THING_ID[] = "00000000-1e2f-4a6b-8c0d-2e4f6a8b0c1e";
+    uint64_t const attach_us = SimNet.now();
+    SimCloud.attachThing(NEW_THING_ID);
+    REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+    uint64_t const sync_us = SimDevice::lastSyncTime() - attach_us;
+    SimDevice::run(1000);
+
+    THEN("it is synchronised after two subscriptions and the old ones are dropped later")
+    {
+      REQUIRE(ArduinoCloud.getThingId() == NEW_THING_ID);
+      REQUIRE(sync_us < 4 * LAN_LINK.rtt_ms * 1000);
+      REQUIRE(SimCloud.stats().subscribes == 2);
+      REQUIRE(SimCloud.stats().unsubscribes == 2);
+      REQUIRE(SimCloud.stats().last_value_requests == 1);
+    }
+  }
+}
+
+SCENARIO("The idle device pings as rarely as the NAT allows", "[ArduinoIoTCloudTCP]")
+{
+  /* The NAT forgets the connection after 5 minutes without traffic */
+  SimDevice::begin(NAT_LINK, 1);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+
+  WHEN("the device has been idle for a few hours")
+  {
+    SimDevice::run(3 * 60 * 60 * 1000UL);
+    unsigned int const disconnect_cnt = SimDevice::disconnectCount();
+    SimCloud.clearStats();
+    SimDevice::run(60 * 60 * 1000UL);
+
+    THEN("it pings less than every 4 minutes and stays connected")
+    {
+      REQUIRE(disconnect_cnt >= 1);
+      REQUIRE(SimCloud.stats().pings >= 1);
+      REQUIRE(SimCloud.stats().pings <= 15);
+      REQUIRE(SimDevice::disconnectCount() == disconnect_cnt);
+      REQUIRE(ArduinoCloud.connected());
+    }
+  }
+}
+
+SCENARIO("The device sends its changes within the transmit windows of the modem", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupCounter);
+  SimDevice::setLoop(countEverySecond);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+
+  WHEN("the modem is reachable for 1 s every 10 s")
+  {
+    ArduinoCloud.setTransmitWindow(10 * 1000UL, 1000);
+    SimCloud.clearStats();
+    SimDevice::run(60 * 1000UL);
+
+    THEN("the changes of each cycle are sent together and the device stays connected")
+    {
+      /* The change pending when a window opens and the one made within it */
+      REQUIRE(SimCloud.stats().data_messages >= 5);
+      REQUIRE(SimCloud.stats().data_messages <= 2 * 6);
+      REQUIRE(SimDevice::disconnectCount() == 0);
+      REQUIRE(ArduinoCloud.connected());
+    }
+  }
+}
+
+SCENARIO("The device keeps its changes within a data budget", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupCounter);
+  SimDevice::setLoop(countEverySecond);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+
+  WHEN("at most 200 bytes may be sent every 10 s while the property changes once per second")
+  {
+    ArduinoCloud.setDataBudget(200, 10 * 1000UL);
+    SimCloud.clearStats();
+    SimDevice::run(60 * 1000UL);
+
+    THEN("the changes are coalesced into fewer messages within the budget and the device stays connected")
+    {
+      /* The full budget at the start and its refill over six windows */
+      REQUIRE(SimCloud.stats().data_bytes <= 7 * 200);
+      REQUIRE(SimCloud.stats().data_messages >= 10);
+      REQUIRE(SimCloud.stats().data_messages <= 25);
+      REQUIRE(SimDevice::disconnectCount() == 0);
+      REQUIRE(ArduinoCloud.connected());
+    }
+  }
+}
+
+static void setupShortTimezone()
+{
+  setupCounter();
+  SimCloud.setTimeZone(3600, 60);
+}
+
+SCENARIO("The device refreshes the expired time zone without requesting the last values", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupShortTimezone);
+  SimDevice::setLoop(countEverySecond);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  SimCloud.clearStats();
+
+  WHEN("the time zone information expires after 60 s")
+  {
+    SimDevice::run(100 * 1000UL);
+
+    THEN("it is requested once on the device topic while the changes are sent on")
+    {
+      REQUIRE(SimCloud.stats().timezone_requests == 1);
+      REQUIRE(SimCloud.stats().last_value_requests == 0);
+      REQUIRE(SimCloud.stats().data_messages >= 95);
+      REQUIRE(ArduinoCloud.getLocalTime() - ArduinoCloud.getInternalTime() == 3600);
+      REQUIRE(ArduinoCloud.connected());
+    }
+  }
+
+  WHEN("the cloud does not answer the time zone requests")
+  {
+    SimCloud.setAnswerTimezone(false);
+    SimDevice::run(180 * 1000UL);
+
+    THEN("the last values are requested once the retries are used up")
+    {
+      REQUIRE(SimCloud.stats().timezone_requests == AIOT_CONFIG_TIMEZONE_REQUEST_MAX_RETRY_CNT);
+      REQUIRE(SimCloud.stats().last_value_requests == 1);
+      REQUIRE(SimCloud.stats().data_messages >= 170);
+      REQUIRE(ArduinoCloud.connected());
+    }
+  }
+}
+
+static int reading = 0;
+
+static void setupUnansweredSync()
+{
+  counter = 0;
+  reading = 0;
+  SimCloud.setAnswerLastValues(false);
+  ArduinoCloud.addProperty(counter, Permission::ReadWrite);
+  ArduinoCloud.addProperty(reading, Permission::Read);
+}
+
+static void readEverySecond()
+{
+  reading = static_cast<int>(millis() / 1000);
+}
+
+static int level = 0;
+
+static void setupReadings()
+{
+  counter = 0;
+  reading = 0;
+  level = 0;
+  ArduinoCloud.addProperty(counter, Permission::ReadWrite);
+  ArduinoCloud.addProperty(reading, Permission::Read);
+  ArduinoCloud.addProperty(level, Permission::Read);
+}
+
+SCENARIO("The device sends just the properties pushed", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupReadings);
+  SimDevice::setDataReadySignal(true);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  SimDevice::run(1000);
+
+  REQUIRE(ArduinoCloud.push(counter, reading, level));
+  SimCloud.clearStats();
+  /* The broker is served while the idle device wakes up */
+  SimDevice::run(5000);
+  unsigned int const all_bytes = SimCloud.stats().data_bytes;
+
+  WHEN("two of the unchanged properties are pushed")
+  {
+    REQUIRE(ArduinoCloud.push(reading, level));
+    SimCloud.clearStats();
+    SimDevice::run(5000);
+
+    THEN("they are sent together without the other one")
+    {
+      REQUIRE(all_bytes > 0);
+      REQUIRE(SimCloud.stats().data_messages == 1);
+      REQUIRE(SimCloud.stats().data_bytes > 0);
+      REQUIRE(SimCloud.stats().data_bytes < all_bytes);
+    }
+  }
+
+  WHEN("a variable which is not a property is pushed")
+  {
+    int other = 0;
+    THEN("it is refused")
+    {
+      REQUIRE_FALSE(ArduinoCloud.push(other));
+    }
+  }
+}
+
+SCENARIO("The device sends read-only properties before the last values are received", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupUnansweredSync);
+
+  WHEN("a read-only property changes while the last values are pending")
+  {
+    SimDevice::setLoop(readEverySecond);
+    SimDevice::run(5000);
+    THEN("it is sent nonetheless")
+    {
+      REQUIRE(SimCloud.stats().last_value_requests >= 1);
+      REQUIRE(SimCloud.stats().data_messages >= 4);
+    }
+  }
+
+  WHEN("a property writeable by the cloud changes while the last values are pending")
+  {
+    SimDevice::setLoop(countEverySecond);
+    SimDevice::run(5000);
+    THEN("it is held back")
+    {
+      /* Only the initial value of the read-only property */
+      REQUIRE(SimCloud.stats().data_messages <= 1);
+    }
+  }
+}
+
+static String log_line;
+
+static void setupLogLine()
+{
+  log_line = String(1000, 'x');
+  ArduinoCloud.addProperty(log_line, Permission::Read);
+}
+
+SCENARIO("The device sends a string property larger than a message", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupLogLine);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  SimDevice::run(1000);
+
+  THEN("it is streamed instead of being dropped")
+  {
+    REQUIRE(SimCloud.stats().data_messages >= 1);
+    REQUIRE(SimCloud.stats().data_bytes >= 1000);
+  }
+}
+
+static size_t const LINE_CNT = 24;
+static String lines[LINE_CNT];
+static char line_names[LINE_CNT][8];
+
+static void setupLines()
+{
+  for (size_t i = 0; i < LINE_CNT; i++)
+  {
+    lines[i] = String(40, 'a');
+    snprintf(line_names[i], sizeof(line_names[i]), "line%u", static_cast<unsigned int>(i));
+    ArduinoCloud.addPropertyReal(lines[i], line_names[i], Permission::Read);
+  }
+}
+
+SCENARIO("The device sends a backlog of changes in bursts", "[ArduinoIoTCloudTCP]")
+{
+  /* A sketch whose loop takes a second */
+  SimDevice::begin(LAN_LINK, 1, setupLines, 1000);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  SimDevice::run(5000);
+
+  WHEN("all properties change at once")
+  {
+    for (size_t i = 0; i < LINE_CNT; i++)
+      lines[i] = String(40, 'b');
+    SimCloud.clearStats();
+    SimDevice::step();
+    SimDevice::step();
+
+    THEN("they are sent in several messages per loop")
+    {
+      REQUIRE(SimCloud.stats().data_messages > 2);
+      REQUIRE(SimCloud.stats().data_messages <= 2 * AIOT_CONFIG_BURST_MSG_CNT);
+      REQUIRE(SimCloud.stats().data_bytes >= LINE_CNT * 40);
+    }
+  }
+}
+
+static void addAlternativeEndpoint()
+{
+  SimCloud.setReachable(DEFAULT_BROKER_ADDRESS_USER_PASS_AUTH, false);
+  ArduinoCloud.addBrokerEndpoint("mqtts-alt.iot.arduino.cc", DEFAULT_BROKER_PORT_USER_PASS_AUTH);
+}
+
+SCENARIO("The device falls back to another broker endpoint", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, addAlternativeEndpoint);
+
+  WHEN("the first endpoint is unreachable")
+  {
+    REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+    THEN("the next one is tried without backing off")
+    {
+      REQUIRE(SimDevice::lastSyncTime() < (1500 + 12 * LAN_LINK.rtt_ms) * 1000);
+      REQUIRE(SimCloud.stats().connects == 1);
+    }
+    THEN("it is kept for reconnecting")
+    {
+      SimDevice::run(5000);
+      uint64_t const drop_us = SimNet.now();
+      SimNet.drop();
+      REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+      REQUIRE(SimDevice::lastSyncTime() - drop_us < 12 * LAN_LINK.rtt_ms * 1000);
+    }
+  }
+}
+
+static char const SENSOR_THING_ID[]   = "0d6c2f1e-7a3b-4c5d-9e8f-1a2b3c4d5e6f";
+static char const ACTUATOR_THING_ID[] = "6f5e4d3c-2b1a-4f9e-8d7c-6b5a4f3e2d1c";
+
+static CloudThing * sensor_thing = nullptr;
+static CloudThing * actuator_thing = nullptr;
+static int temperature = 0;
+static int setpoint = 0;
+
+/* The things are built anew for each run as ArduinoCloud is */
+static void setupGateway()
+{
+  counter = 0;
+  temperature = 0;
+  setpoint = 0;
+  ArduinoCloud.addProperty(counter, Permission::ReadWrite);
+
+  delete sensor_thing;
+  delete actuator_thing;
+  sensor_thing = new CloudThing(SENSOR_THING_ID);
+  actuator_thing = new CloudThing(ACTUATOR_THING_ID);
+  sensor_thing->addProperty(temperature, Permission::Read);
+  actuator_thing->addProperty(setpoint, Permission::ReadWrite);
+  ArduinoCloud.addThing(*sensor_thing);
+  ArduinoCloud.addThing(*actuator_thing);
+}
+
+SCENARIO("A gateway synchronises the things of its sub-devices over its connection", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupGateway);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  SimDevice::run(1000);
+
+  THEN("the last values of each thing are requested on the same connection")
+  {
+    REQUIRE(SimCloud.stats().connects == 1);
+    REQUIRE(SimCloud.stats().gateway_last_value_requests == 2);
+    REQUIRE(sensor_thing->isSynced());
+    REQUIRE(actuator_thing->isSynced());
+  }
+
+  WHEN("no more things can be added")
+  {
+    CloudThing spare("00000000-0000-0000-0000-000000000000");
+    THEN("the thing is refused")
+    {
+      REQUIRE_FALSE(ArduinoCloud.addThing(spare));
+    }
+  }
+
+  WHEN("the value of a sub-device changes")
+  {
+    SimCloud.clearStats();
+    temperature = 21;
+    SimDevice::run(1000);
+    THEN("it is sent on the data topic of its thing")
+    {
+      REQUIRE(SimCloud.stats().gateway_data_messages == 1);
+      REQUIRE(SimCloud.stats().data_messages == 0);
+    }
+  }
+
+  WHEN("the cloud writes a property of a sub-device")
+  {
+    SimCloud.writeProperty("setpoint", 50, ACTUATOR_THING_ID);
+    SimDevice::run(100);
+    THEN("it is received by its thing only")
+    {
+      REQUIRE(setpoint == 50);
+      REQUIRE(counter == 0);
+    }
+  }
+
+  WHEN("the connection is reset")
+  {
+    SimCloud.clearStats();
+    SimNet.drop();
+    REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+    SimDevice::run(1000);
+    THEN("the things are synchronised again")
+    {
+      REQUIRE(SimCloud.stats().gateway_last_value_requests == 2);
+      REQUIRE(sensor_thing->isSynced());
+      REQUIRE(actuator_thing->isSynced());
+    }
+  }
+}
+
+static bool fan = false;
+
+static void setupThermostat()
+{
+  temperature = 20;
+  fan = false;
+  ArduinoCloud.addProperty(temperature, Permission::ReadWrite);
+  ArduinoCloud.addProperty(fan, Permission::ReadWrite);
+}
+
+SCENARIO("The device runs the rules written by the cloud while disconnected", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupThermostat);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+
+  /* fan = temperature > 30 */
+  std::vector<uint8_t> const program = {
+    'R', 1, 2,
+    11, 't', 'e', 'm', 'p', 'e', 'r', 'a', 't', 'u', 'r', 'e',
+    3, 'f', 'a', 'n',
+    10, 0x01, 0x00, 0x02, 0x00, 0x00, 0xF0, 0x41, 0x10, 0x40, 0x01
+  };
+  SimCloud.writeDeviceProperty("RULES", program);
+  SimDevice::run(1000);
+
+  WHEN("the temperature rises while the broker is unreachable")
+  {
+    SimCloud.setAvailable(false);
+    SimNet.drop();
+    SimDevice::run(1000);
+    REQUIRE_FALSE(ArduinoCloud.connected());
+    REQUIRE_FALSE(fan);
+
+    temperature = 35;
+    SimDevice::step();
+    SimDevice::step();
+
+    THEN("the fan is switched on by the device itself")
+    {
+      REQUIRE(fan);
+    }
+  }
+}
+
+class SimFlash : public PropertyCacheStorage
+{
+public:
+  std::vector<uint8_t> record;
+
+  virtual size_t read(uint8_t * buf, size_t const size) override
+  {
+    if (record.size() > size)
+      return 0;
+    std::copy(record.begin(), record.end(), buf);
+    return record.size();
+  }
+  virtual bool write(uint8_t const * buf, size_t const length) override
+  {
+    record.assign(buf, buf + length);
+    return true;
+  }
+};
+
+static SimFlash flash;
+
+static void setupCachedCounter()
+{
+  setupCounter();
+  ArduinoCloud.setPropertyCache(flash);
+}
+
+SCENARIO("The device resumes the property values stored before a restart", "[ArduinoIoTCloudTCP]")
+{
+  flash.record.clear();
+  SimDevice::begin(LAN_LINK, 1, setupCachedCounter);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+
+  SimCloud.writeProperty("counter", 77);
+  SimDevice::run(AIOT_CONFIG_PROPERTY_CACHE_INTERVAL_ms + 1000);
+  REQUIRE(counter == 77);
+
+  WHEN("the device restarts")
+  {
+    SimDevice::begin(LAN_LINK, 2, setupCachedCounter);
+
+    THEN("the value is restored before the connection is established")
+    {
+      REQUIRE_FALSE(ArduinoCloud.connected());
+      REQUIRE(counter == 77);
+      REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+      REQUIRE(counter == 77);
+    }
+  }
+}
+
+/* The thing runs on the application core, the connection on this one */
+alignas(SharedRing::CACHE_LINE) static uint8_t core_link_memory[4096];
+alignas(ArduinoIoTCloudTCP) static uint8_t application_storage[sizeof(ArduinoIoTCloudTCP)];
+static ArduinoIoTCloudTCP * application = nullptr;
+static CoreLink application_link;
+static CoreLink network_link;
+static int humidity = 0;
+static int threshold = 0;
+
+static void setupCoreLink()
+{
+  humidity = 0;
+  threshold = 0;
+  if (application)
+    application->~ArduinoIoTCloudTCP();
+  application = new (application_storage) ArduinoIoTCloudTCP();
+  application->addProperty(humidity, Permission::Read);
+  application->addProperty(threshold, Permission::ReadWrite);
+
+  application_link.begin(CoreLink::Side::Application, core_link_memory, sizeof(core_link_memory));
+  application->begin(application_link);
+  network_link.begin(CoreLink::Side::Network, core_link_memory, sizeof(core_link_memory));
+  ArduinoCloud.setCoreLink(network_link);
+}
+
+static void updateApplication()
+{
+  application->update();
+}
+
+SCENARIO("The thing runs on another core than the connection", "[ArduinoIoTCloudTCP]")
+{
+  SimDevice::begin(LAN_LINK, 1, setupCoreLink);
+  SimDevice::setLoop(updateApplication);
+  REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+  SimDevice::run(1000);
+
+  THEN("the application side is told once the thing is synchronised")
+  {
+    REQUIRE(application->connected());
+  }
+
+  WHEN("the cloud writes a property")
+  {
+    SimCloud.clearStats();
+    SimCloud.writeProperty("threshold", 80);
+    SimDevice::run(1000);
+    THEN("it is received on the application side and echoed")
+    {
+      REQUIRE(threshold == 80);
+      REQUIRE(SimCloud.stats().data_messages == 1);
+    }
+  }
+
+  WHEN("a property changes on the application side")
+  {
+    SimCloud.clearStats();
+    humidity = 7;
+    SimDevice::run(1000);
+    THEN("it is sent by the network side")
+    {
+      REQUIRE(SimCloud.stats().data_messages == 1);
+    }
+  }
+
+  WHEN("the connection is reset")
+  {
+    SimNet.drop();
+    SimDevice::run(100);
+    THEN("the application side is told")
+    {
+      REQUIRE_FALSE(application->connected());
+      REQUIRE(SimDevice::runUntilConnected(CONNECT_TIMEOUT_ms));
+      SimDevice::run(100);
+      REQUIRE(application->connected());
+    }
+  }
+}
@@ -0,0 +1,126 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <utility/net/BrokerEndpoints.h>
+
+/**************************************************************************************
+   HELPER
+ **************************************************************************************/
+
+static unsigned int resolve_cnt = 0;
+static bool resolve_ok = true;
+
+static int resolve(char const * /* host */, IPAddress & ip)
+{
+  resolve_cnt++;
+  if (!resolve_ok)
+    return 0;
+  ip = IPAddress(192, 0, 2, static_cast<uint8_t>(resolve_cnt));
+  return 1;
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Trying the broker endpoints in turn", "[BrokerEndpoints]")
+{
+  BrokerEndpoints endpoints;
+  endpoints.begin("primary.example", 8883);
+
+  WHEN("There is a single endpoint")
+  {
+    THEN("Every failure is followed by a back off")
+    {
+      REQUIRE(endpoints.onFailure());
+      REQUIRE(endpoints.host() == "primary.example");
+      REQUIRE(endpoints.onFailure());
+    }
+  }
+  WHEN("Alternative endpoints are added")
+  {
+    REQUIRE(endpoints.add("primary.example", 443));
+    REQUIRE(endpoints.add("secondary.example", 8883));
+    REQUIRE_FALSE(endpoints.add("tertiary.example", 8883));
+
+    THEN("They are tried right away before backing off")
+    {
+      REQUIRE_FALSE(endpoints.onFailure());
+      REQUIRE(endpoints.port() == 443);
+      REQUIRE_FALSE(endpoints.onFailure());
+      REQUIRE(endpoints.host() == "secondary.example");
+      REQUIRE(endpoints.onFailure());
+      REQUIRE(endpoints.host() == "primary.example");
+      REQUIRE(endpoints.port() == 8883);
+    }
+    THEN("The endpoint which worked is kept")
+    {
+      endpoints.onFailure();
+      endpoints.onConnected();
+      REQUIRE(endpoints.port() == 443);
+      REQUIRE_FALSE(endpoints.onFailure());
+      REQUIRE_FALSE(endpoints.onFailure());
+      REQUIRE(endpoints.onFailure());
+    }
+    THEN("They survive begin() being called again")
+    {
+      endpoints.begin("other.example", 8884);
+      REQUIRE(endpoints.count() == 3);
+      REQUIRE(endpoints.host() == "other.example");
+    }
+  }
+}
+
+SCENARIO("Caching the resolved broker address", "[BrokerEndpoints]")
+{
+  BrokerEndpoints endpoints;
+  endpoints.begin("primary.example", 8883);
+  resolve_cnt = 0;
+  resolve_ok = true;
+  IPAddress ip;
+
+  WHEN("No resolver is given")
+  {
+    THEN("The endpoint is connected to by name")
+    {
+      REQUIRE_FALSE(endpoints.address(ip, 0));
+    }
+  }
+  WHEN("A resolver is given")
+  {
+    endpoints.setResolver(resolve, 60 * 1000UL);
+    REQUIRE(endpoints.address(ip, 0));
+    REQUIRE(ip == IPAddress(192, 0, 2, 1));
+
+    THEN("The address is reused until it expires")
+    {
+      REQUIRE(endpoints.address(ip, 59 * 1000UL));
+      REQUIRE(resolve_cnt == 1);
+      REQUIRE(endpoints.address(ip, 60 * 1000UL));
+      REQUIRE(resolve_cnt == 2);
+      REQUIRE(ip == IPAddress(192, 0, 2, 2));
+    }
+    THEN("A failed connection drops the address")
+    {
+      endpoints.onFailure();
+      REQUIRE(endpoints.address(ip, 1000));
+      REQUIRE(resolve_cnt == 2);
+    }
+  }
+  WHEN("The name can not be resolved")
+  {
+    resolve_ok = false;
+    endpoints.setResolver(resolve, 60 * 1000UL);
+    THEN("The endpoint is connected to by name")
+    {
+      REQUIRE_FALSE(endpoints.address(ip, 0));
+    }
+  }
+}
@@ -0,0 +1,128 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <utility/net/CoalescingClient.h>
+
+/**************************************************************************************
+   TEST CLIENT
+ **************************************************************************************/
+
+/* Records each write as one string */
+class RecordingClient : public Client
+{
+public:
+
+  std::vector<std::string> writes;
+  bool fail = false;
+
+  virtual size_t write(const uint8_t * buf, size_t size) override
+  {
+    if (fail)
+      return 0;
+    writes.push_back(std::string(reinterpret_cast<char const *>(buf), size));
+    return size;
+  }
+};
+
+static size_t write(CoalescingClient & client, char const * str)
+{
+  return client.write(reinterpret_cast<uint8_t const *>(str), strlen(str));
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Coalescing the writes of back-to-back packets", "[CoalescingClient]")
+{
+  uint8_t buf[8];
+  RecordingClient tls;
+  CoalescingClient client(buf, sizeof(buf));
+  client.setClient(tls);
+
+  WHEN("The client is not corked")
+  {
+    write(client, "ab");
+    write(client, "cd");
+    THEN("Each write is passed through")
+    {
+      REQUIRE(tls.writes == std::vector<std::string>{"ab", "cd"});
+    }
+  }
+
+  WHEN("Several packets are written while corked")
+  {
+    client.cork();
+    REQUIRE(write(client, "ab") == 2);
+    REQUIRE(write(client, "cd") == 2);
+    REQUIRE(tls.writes.empty());
+    REQUIRE(client.uncork() == 1);
+    THEN("They are written at once on uncork")
+    {
+      REQUIRE(tls.writes == std::vector<std::string>{"abcd"});
+    }
+  }
+
+  WHEN("The cork is nested")
+  {
+    client.cork();
+    write(client, "ab");
+    client.cork();
+    write(client, "cd");
+    client.uncork();
+    REQUIRE(tls.writes.empty());
+    client.uncork();
+    THEN("Nothing is written before the outermost uncork")
+    {
+      REQUIRE(tls.writes == std::vector<std::string>{"abcd"});
+    }
+  }
+
+  WHEN("The packets exceed the buffer")
+  {
+    client.cork();
+    write(client, "abcde");
+    write(client, "fghij");
+    write(client, "0123456789");
+    client.uncork();
+    THEN("They are written in order and a packet larger than the buffer bypasses it")
+    {
+      REQUIRE(tls.writes == std::vector<std::string>{"abcde", "fghij", "0123456789"});
+    }
+  }
+
+  WHEN("Writing the collected packets fails")
+  {
+    client.cork();
+    write(client, "ab");
+    tls.fail = true;
+    THEN("uncork reports the failure")
+    {
+      REQUIRE(client.uncork() == 0);
+    }
+  }
+
+  WHEN("The connection is stopped while corked")
+  {
+    client.cork();
+    write(client, "ab");
+    client.stop();
+    write(client, "cd");
+    THEN("The collected data is discarded and writes pass through again")
+    {
+      REQUIRE(tls.writes == std::vector<std::string>{"cd"});
+    }
+  }
+}
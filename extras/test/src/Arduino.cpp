@@ -8,11 +8,13 @@
 
 #include <Arduino.h>
 
+#include <util/ClockTestUtil.h>
+
 /******************************************************************************
    GLOBAL VARIABLES
  ******************************************************************************/
 
-static unsigned long current_millis = 0;
+static unsigned long random_state = 1;
 
 /******************************************************************************
    PUBLIC FUNCTIONS
@@ -20,10 +22,43 @@ static unsigned long current_millis = 0;
 
 void set_millis(unsigned long const millis)
 {
-  current_millis = millis;
+  VirtualClock::set(static_cast<uint64_t>(millis) * 1000);
 }
 
 unsigned long millis()
 {
-  return current_millis;
+  return static_cast<unsigned long>(VirtualClock::now() / 1000);
+}
+
+void set_micros(unsigned long const micros)
+{
+  VirtualClock::set(micros);
+}
+
+unsigned long micros()
+{
+  return static_cast<unsigned long>(VirtualClock::now());
+}
+
+uint16_t word(uint8_t const h, uint8_t const l)
+{
+  return static_cast<uint16_t>((h << 8) | l);
+}
+
+void randomSeed(unsigned long const seed)
+{
+  random_state = (seed != 0) ? seed : 1;
+}
+
+long random(long const min, long const max)
+{
+  if (max <= min)
+    return min;
+  random_state = random_state * 1103515245UL + 12345UL;
+  return min + static_cast<long>((random_state >> 16) % static_cast<unsigned long>(max - min));
+}
+
+int analogRead(uint8_t const /* pin */)
+{
+  return 0;
 }
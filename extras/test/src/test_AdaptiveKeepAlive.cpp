@@ -0,0 +1,134 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <AdaptiveKeepAlive.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static KeepAliveLimits const LIMITS = {30 * 1000UL, 10 * 60 * 1000UL};
+
+/**************************************************************************************
+   HELPER
+ **************************************************************************************/
+
+/* Pings as often as due until the given time, returns the last ping */
+static unsigned long idle(AdaptiveKeepAlive & keep_alive, unsigned long & now, unsigned long const until)
+{
+  unsigned long last_ping = 0;
+  while ((now += keep_alive.nextPingIn(now)) <= until)
+  {
+    REQUIRE(keep_alive.isPingDue(now));
+    keep_alive.onPing(now);
+    last_ping = now;
+  }
+  now = until;
+  return last_ping;
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Probing the keep alive interval", "[AdaptiveKeepAlive]")
+{
+  AdaptiveKeepAlive keep_alive;
+  keep_alive.begin(LIMITS);
+  unsigned long now = 1000;
+  keep_alive.onConnected(now);
+
+  WHEN("The device has just connected")
+  {
+    THEN("The first ping is due after the minimum interval")
+    {
+      REQUIRE(keep_alive.interval() == LIMITS.min_ms);
+      REQUIRE_FALSE(keep_alive.isPingDue(now + LIMITS.min_ms - 1));
+      REQUIRE(keep_alive.isPingDue(now + LIMITS.min_ms));
+    }
+  }
+  WHEN("Messages are sent in between")
+  {
+    keep_alive.onTransmit(now + 20 * 1000UL);
+    THEN("The ping is postponed")
+    {
+      REQUIRE_FALSE(keep_alive.isPingDue(now + LIMITS.min_ms));
+      REQUIRE(keep_alive.nextPingIn(now + LIMITS.min_ms) == 20 * 1000UL);
+    }
+  }
+  WHEN("The connection survives every idle period")
+  {
+    idle(keep_alive, now, now + 3 * 60 * 60 * 1000UL);
+    THEN("The interval grows up to the maximum")
+    {
+      REQUIRE(keep_alive.interval() == LIMITS.max_ms);
+    }
+  }
+  WHEN("The connection is lost after an idle period of 4 minutes")
+  {
+    /* The shorter intervals are survived */
+    while (keep_alive.interval() < 4 * 60 * 1000UL)
+      idle(keep_alive, now, now + keep_alive.nextPingIn(now));
+    REQUIRE(keep_alive.interval() == 4 * 60 * 1000UL);
+    idle(keep_alive, now, now + keep_alive.nextPingIn(now));
+    keep_alive.onDisconnected();
+
+    THEN("The interval falls back to the longest one survived")
+    {
+      REQUIRE(keep_alive.interval() == 2 * 60 * 1000UL);
+    }
+    THEN("Later probes stay below the lost interval")
+    {
+      now += 1000;
+      keep_alive.onConnected(now);
+      idle(keep_alive, now, now + 60 * 60 * 1000UL);
+      REQUIRE(keep_alive.interval() < 4 * 60 * 1000UL);
+      REQUIRE(keep_alive.interval() > 3 * 60 * 1000UL);
+    }
+  }
+  WHEN("The loss is only noticed when the next ping is due")
+  {
+    /* The ping after 60 s of idle time is the last one */
+    idle(keep_alive, now, now + 5 * LIMITS.min_ms);
+    REQUIRE(keep_alive.interval() == 2 * LIMITS.min_ms);
+    keep_alive.onDisconnected();
+    THEN("It is still blamed on the idle period")
+    {
+      REQUIRE(keep_alive.interval() == LIMITS.min_ms);
+    }
+  }
+  WHEN("The connection is lost long after the last ping")
+  {
+    idle(keep_alive, now, now + LIMITS.min_ms);
+    keep_alive.onTransmit(now + LIMITS.min_ms + 1);
+    keep_alive.onDisconnected();
+    THEN("The interval is kept")
+    {
+      REQUIRE(keep_alive.interval() == LIMITS.min_ms);
+    }
+  }
+  WHEN("Even the minimum interval is lost")
+  {
+    idle(keep_alive, now, now + LIMITS.min_ms);
+    keep_alive.onDisconnected();
+    THEN("The minimum is used nonetheless")
+    {
+      REQUIRE(keep_alive.interval() == LIMITS.min_ms);
+    }
+  }
+  WHEN("The device is disconnected")
+  {
+    keep_alive.onDisconnected();
+    THEN("No ping is due")
+    {
+      REQUIRE_FALSE(keep_alive.isPingDue(now + LIMITS.max_ms));
+    }
+  }
+}
@@ -0,0 +1,104 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <vector>
+
+#include <CBORDecoder.h>
+#include <CallbackQueue.h>
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+static CallbackQueue * queue = nullptr;
+static int callback_cnt = 0;
+static unsigned long callback_duration_us = 0;
+
+static bool queueCallback(Property & property, bool const is_sync)
+{
+  return queue->push(property, is_sync);
+}
+
+static void onUpdate()
+{
+  callback_cnt++;
+  set_micros(micros() + callback_duration_us);
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The callbacks of properties written by the cloud are deferred", "[CallbackQueue]")
+{
+  CallbackQueue callback_queue;
+  queue = &callback_queue;
+  callback_cnt = 0;
+  callback_duration_us = 0;
+  set_micros(0);
+  Property::setDeferCallbackFunc(queueCallback);
+
+  PropertyContainer property_container;
+  CloudInt a = 0, b = 0;
+  addPropertyToContainer(property_container, a, "a", Permission::ReadWrite).onUpdate(onUpdate);
+  addPropertyToContainer(property_container, b, "b", Permission::ReadWrite).onUpdate(onUpdate);
+
+  WHEN("a message writes the same property twice")
+  {
+    /* [{0: "a", 2: 1}, {0: "a", 2: 2}, {0: "b", 2: 3}] = 83 A2 00 61 61 02 01 A2 00 61 61 02 02 A2 00 61 62 02 03 */
+    uint8_t const payload[] = {0x83, 0xA2, 0x00, 0x61, 0x61, 0x02, 0x01, 0xA2, 0x00, 0x61, 0x61, 0x02, 0x02, 0xA2, 0x00, 0x61, 0x62, 0x02, 0x03};
+    CBORDecoder::decode(property_container, payload, sizeof(payload));
+
+    THEN("no callback runs within the decoder and each property is queued once")
+    {
+      REQUIRE(callback_cnt == 0);
+      REQUIRE(callback_queue.size() == 2);
+      REQUIRE(callback_queue.drain(1000) == 2);
+      REQUIRE(callback_cnt == 2);
+      REQUIRE(a == 2);
+      REQUIRE(b == 3);
+    }
+  }
+
+  WHEN("the callbacks take longer than the budget")
+  {
+    callback_duration_us = 600;
+    /* [{0: "a", 2: 1}, {0: "b", 2: 3}] = 82 A2 00 61 61 02 01 A2 00 61 62 02 03 */
+    uint8_t const payload[] = {0x82, 0xA2, 0x00, 0x61, 0x61, 0x02, 0x01, 0xA2, 0x00, 0x61, 0x62, 0x02, 0x03};
+    CBORDecoder::decode(property_container, payload, sizeof(payload));
+
+    THEN("the remaining ones run on the next drain")
+    {
+      REQUIRE(callback_queue.drain(500) == 1);
+      REQUIRE(callback_cnt == 1);
+      REQUIRE_FALSE(callback_queue.empty());
+      REQUIRE(callback_queue.drain(500) == 1);
+      REQUIRE(callback_queue.empty());
+    }
+  }
+
+  WHEN("the queue is full")
+  {
+    std::vector<CloudInt> properties(CallbackQueue::CAPACITY);
+    for (CloudInt & p : properties)
+      REQUIRE(callback_queue.push(p, false));
+
+    THEN("further callbacks are refused and run right away by the property")
+    {
+      REQUIRE_FALSE(callback_queue.push(a, false));
+      /* [{0: "a", 2: 1}] = 81 A2 00 61 61 02 01 */
+      uint8_t const payload[] = {0x81, 0xA2, 0x00, 0x61, 0x61, 0x02, 0x01};
+      CBORDecoder::decode(property_container, payload, sizeof(payload));
+      REQUIRE(callback_cnt == 1);
+    }
+  }
+
+  Property::setDeferCallbackFunc(nullptr);
+}
@@ -0,0 +1,63 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <ClockDiscipline.h>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Collecting NTP samples", "[ClockDiscipline::offset]")
+{
+  ClockDiscipline discipline;
+
+  WHEN("A delayed sample is among the collected ones")
+  {
+    discipline.addSample(2);
+    discipline.addSample(9);
+    discipline.addSample(1);
+
+    THEN("The median offset is used")
+    {
+      REQUIRE(discipline.isComplete() == true);
+      REQUIRE(discipline.offset() == 2);
+    }
+  }
+}
+
+SCENARIO("Estimating the RTC skew", "[ClockDiscipline::updateSkew]")
+{
+  unsigned long const DAY_ms = 24UL * 60UL * 60UL * 1000UL;
+  ClockDiscipline discipline;
+  discipline.restart(0);
+
+  WHEN("The RTC lags 2 seconds behind after one day")
+  {
+    discipline.updateSkew(2, DAY_ms);
+
+    THEN("Half of the residual is compensated from then on")
+    {
+      REQUIRE(discipline.skew_ppb() == 11574);
+      discipline.restart(DAY_ms);
+      REQUIRE(discipline.correction(3 * DAY_ms) == 1);
+    }
+  }
+
+  WHEN("The sync interval is too short for a meaningful estimate")
+  {
+    discipline.updateSkew(2, 1000);
+
+    THEN("The skew estimate is left untouched")
+    {
+      REQUIRE(discipline.skew_ppb() == 0);
+      REQUIRE(discipline.correction(DAY_ms) == 0);
+    }
+  }
+}
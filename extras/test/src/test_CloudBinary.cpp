@@ -0,0 +1,108 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <vector>
+
+#include <util/CBORTestUtil.h>
+#include <CBORDecoder.h>
+#include <property/types/CloudBinary.h>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("A 'Binary' property is encoded as a CBOR byte string", "[CloudBinary::encode]")
+{
+  PropertyContainer property_container;
+  uint8_t buffer[8] = {0xDE, 0xAD, 0xBE, 0xEF};
+  CloudBinary blob(buffer, sizeof(buffer), 4);
+  addPropertyToContainer(property_container, blob, "test", Permission::ReadWrite);
+
+  WHEN("The property is encoded")
+  {
+    set_millis(0);
+    /* [{0: "test", 8: h'DEADBEEF'}] = 9F A2 00 64 74 65 73 74 08 44 DE AD BE EF FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x08, 0x44, 0xDE, 0xAD, 0xBE, 0xEF, 0xFF};
+    REQUIRE(cbor::encode(property_container) == expected);
+
+    THEN("It is only encoded again once the sketch changes it")
+    {
+      REQUIRE(cbor::encode(property_container).empty());
+
+      buffer[0] = 0x01;
+      blob.setLength(1);
+      set_millis(500);
+      /* [{0: "test", 8: h'01'}] = 9F A2 00 64 74 65 73 74 08 41 01 FF */
+      std::vector<uint8_t> const changed = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x08, 0x41, 0x01, 0xFF};
+      REQUIRE(cbor::encode(property_container) == changed);
+    }
+  }
+
+  WHEN("A value larger than the buffer is set")
+  {
+    uint8_t const data[9] = {0};
+    THEN("It is refused and the value is kept")
+    {
+      REQUIRE_FALSE(blob.set(data, sizeof(data)));
+      REQUIRE(blob.length() == 4);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("A 'Binary' property is decoded into the buffer of the sketch", "[CloudBinary::decode]")
+{
+  PropertyContainer property_container;
+  uint8_t buffer[4] = {0};
+  CloudBinary blob(buffer, sizeof(buffer));
+  addPropertyToContainer(property_container, blob, "test", Permission::ReadWrite);
+
+  WHEN("A byte string fitting into the buffer is received")
+  {
+    /* [{0: "test", 8: h'010203'}] = 81 A2 00 64 74 65 73 74 08 43 01 02 03 */
+    uint8_t const payload[] = {0x81, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x08, 0x43, 0x01, 0x02, 0x03};
+    CBORDecoder::decode(property_container, payload, sizeof(payload));
+
+    THEN("It is written into the buffer")
+    {
+      REQUIRE(blob.data() == buffer);
+      REQUIRE(blob.length() == 3);
+      REQUIRE(buffer[0] == 0x01);
+      REQUIRE(buffer[1] == 0x02);
+      REQUIRE(buffer[2] == 0x03);
+    }
+  }
+
+  WHEN("A byte string larger than the buffer is received")
+  {
+    /* [{0: "test", 8: h'0102030405'}] = 81 A2 00 64 74 65 73 74 08 45 01 02 03 04 05 */
+    uint8_t const payload[] = {0x81, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x08, 0x45, 0x01, 0x02, 0x03, 0x04, 0x05};
+    CBORDecoder::decode(property_container, payload, sizeof(payload));
+
+    THEN("It is ignored")
+    {
+      REQUIRE(blob.length() == 0);
+      REQUIRE(buffer[0] == 0x00);
+    }
+  }
+
+  WHEN("A text string is received instead of a byte string")
+  {
+    /* [{0: "test", 8: "abc"}] = 81 A2 00 64 74 65 73 74 08 63 61 62 63 */
+    uint8_t const payload[] = {0x81, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x08, 0x63, 0x61, 0x62, 0x63};
+    CBORDecoder::decode(property_container, payload, sizeof(payload));
+
+    THEN("The record is dropped")
+    {
+      REQUIRE(blob.length() == 0);
+    }
+  }
+}
@@ -112,4 +112,41 @@ SCENARIO("Arduino Cloud Properties ", "[ArduinoCloudThing::CloudColor]")
 
     REQUIRE(verify);
   }
-}
\ No newline at end of file
+
+  WHEN("RGB colors are converted to HSB and back")
+  {
+    Color color(0, 0, 0);
+    size_t mismatches = 0;
+
+    for (int r = 0; r < 256; r += 3) {
+      for (int g = 0; g < 256; g += 5) {
+        for (int b = 0; b < 256; b += 7) {
+          uint8_t rr, gg, bb;
+          color.setColorRGB(r, g, b);
+          color.getRGB(rr, gg, bb);
+          if (rr != r || gg != g || bb != b || color.hue < 0 || color.hue >= 360)
+            mismatches++;
+        }
+      }
+    }
+
+    THEN("The original RGB values are restored and the hue is within [0, 360)") {
+      REQUIRE(mismatches == 0);
+    }
+  }
+
+  WHEN("An array of colors is converted at once")
+  {
+    uint8_t const rgb[] = {255, 0, 128, 64, 128, 64};
+    uint8_t actual[6] = {0};
+    Color colors[2] = {Color(0, 0, 0), Color(0, 0, 0)};
+
+    Color::setColorsRGB(colors, 2, rgb);
+    Color::getColorsRGB(colors, 2, actual);
+
+    THEN("Each color is converted in turn") {
+      REQUIRE(std::equal(rgb, rgb + 6, actual));
+      REQUIRE(colors[1].hue == 120.0f);
+    }
+  }
+}
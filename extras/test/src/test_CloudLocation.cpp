@@ -117,3 +117,45 @@ SCENARIO("Testing cloud type 'Location' function distance for calculating Euclid
 
   REQUIRE(Location::distance(loc1, loc2) == sqrt(2.0f));
 }
+
+/**************************************************************************************/
+
+SCENARIO("Testing cloud type 'CloudLocation' change detection", "[CloudLocation::isDifferentFromCloud]")
+{
+  CloudLocation location(45.0f, 9.0f);
+
+  WHEN("The minimum delta is given in degrees")
+  {
+    location.publishOnChange(0.5f);
+
+    THEN("A location is different once its Euclidean distance reaches the delta") {
+      location = Location(45.3f, 9.3f);
+      REQUIRE(location.isDifferentFromCloud() == false);
+      location = Location(45.4f, 9.4f);
+      REQUIRE(location.isDifferentFromCloud() == true);
+      location = Location(45.0f, 9.6f);
+      REQUIRE(location.isDifferentFromCloud() == true);
+      location = Location(45.0f, 9.0f);
+      REQUIRE(location.isDifferentFromCloud() == false);
+    }
+  }
+
+  WHEN("The minimum distance is given in metres")
+  {
+    location.publishOnDistance(100.0f);
+
+    THEN("A degree of longitude is shorter than a degree of latitude away from the equator") {
+      /* 0.0008 degrees are ~89 m north but only ~63 m east at 45 degrees of latitude */
+      location = Location(45.0008f, 9.0f);
+      REQUIRE(location.isDifferentFromCloud() == false);
+      location = Location(45.0f, 9.0008f);
+      REQUIRE(location.isDifferentFromCloud() == false);
+      location = Location(45.0f, 9.0012f);
+      REQUIRE(location.isDifferentFromCloud() == false);
+      location = Location(45.0f, 9.0015f);
+      REQUIRE(location.isDifferentFromCloud() == true);
+      location = Location(45.0007f, 9.0009f);
+      REQUIRE(location.isDifferentFromCloud() == true);
+    }
+  }
+}
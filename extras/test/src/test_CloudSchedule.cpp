@@ -513,3 +513,147 @@ SCENARIO("Setup a one shot schedule and test isActive Method", "[Schedule::isAct
   }
 }
 
+
+/**************************************************************************************/
+
+SCENARIO("Cached isActive evaluation matches a fresh one", "[Schedule::isActive]")
+{
+  ScheduleWeeklyMask weekMask = {
+    ScheduleState::Inactive,   /* Sunday */
+    ScheduleState::Active,     /* Monday */
+    ScheduleState::Inactive,   /* Tuesday */
+    ScheduleState::Active,     /* Wednesday */
+    ScheduleState::Inactive,   /* Thursday */
+    ScheduleState::Inactive,   /* Friday */
+    ScheduleState::Inactive,   /* Saturday */
+  };
+
+  Schedule schedules[] = {
+    Schedule(1633305600, 1633651200,  600, Schedule::createFixedDeltaScheduleConfiguration(ScheduleUnit::Minutes, 20)),
+    Schedule(1633305600,          0,   10, Schedule::createFixedDeltaScheduleConfiguration(ScheduleUnit::Seconds, 7)),
+    Schedule(1633305600, 1633651200, 3600, Schedule::createWeeklyScheduleConfiguration(weekMask)),
+    Schedule(1633305600,          0, 7200, Schedule::createMonthlyScheduleConfiguration(5)),
+    Schedule(1633305600,          0,  120, Schedule::createYearlyScheduleConfiguration(ScheduleMonth::Oct, 6)),
+    Schedule(1633305600,          0,  900, Schedule::createOneShotScheduleConfiguration()),
+  };
+
+  WHEN("Time advances in small steps")
+  {
+    THEN("The cached state equals the state of an uncached copy") {
+      for (Schedule & schedule : schedules) {
+        int mismatches = 0;
+        for (time_now = 1633305600 - 100; time_now < 1633305600 + 3 * DAYS; time_now += 13) {
+          Schedule fresh(schedule.frm, schedule.to, schedule.len, schedule.msk);
+          if (schedule.isActive() != fresh.isActive()) {
+            mismatches++;
+          }
+        }
+        REQUIRE(mismatches == 0);
+      }
+    }
+  }
+
+  WHEN("Time goes backwards")
+  {
+    Schedule & schedule = schedules[0];
+    time_now = 1633306200;
+    REQUIRE(schedule.isActive() == true);
+    time_now = 1633306201;
+    REQUIRE(schedule.isActive() == false);
+    THEN("The schedule is evaluated again") {
+      time_now = 1633306200;
+      REQUIRE(schedule.isActive() == true);
+    }
+  }
+
+  WHEN("The schedule is modified")
+  {
+    Schedule & schedule = schedules[0];
+    time_now = 1633306201;
+    REQUIRE(schedule.isActive() == false);
+    THEN("The schedule is evaluated again") {
+      schedule.len = 601;
+      REQUIRE(schedule.isActive() == true);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+static int activate_cnt = 0;
+static int deactivate_cnt = 0;
+static void onScheduleActivate()   { activate_cnt++; }
+static void onScheduleDeactivate() { deactivate_cnt++; }
+
+SCENARIO("Schedule callbacks fired by the ScheduleTimer", "[ScheduleTimer::poll]")
+{
+  activate_cnt = 0;
+  deactivate_cnt = 0;
+
+  /* Active for 10 minutes every 20 minutes from 4/10/2021 00:00:00 */
+  CloudSchedule schedule(1633305600, 0, 600, Schedule::createFixedDeltaScheduleConfiguration(ScheduleUnit::Minutes, 20));
+  schedule.onActivate(onScheduleActivate).onDeactivate(onScheduleDeactivate);
+
+  WHEN("The time is not known yet")
+  {
+    ScheduleTimer.poll(0);
+    THEN("Nothing is fired") {
+      REQUIRE(activate_cnt == 0);
+      REQUIRE(deactivate_cnt == 0);
+      REQUIRE(ScheduleTimer.isPending());
+    }
+  }
+
+  WHEN("The schedule is inactive when the time becomes known")
+  {
+    ScheduleTimer.poll(1633305600 - 60);
+    THEN("Nothing is fired") {
+      REQUIRE(activate_cnt == 0);
+      REQUIRE(deactivate_cnt == 0);
+    }
+  }
+
+  WHEN("The time passes the edges of the schedule")
+  {
+    for (unsigned long now = 1633305600 - 60; now < 1633305600 + 3600; now += 30) {
+      ScheduleTimer.poll(now);
+    }
+    THEN("Every edge is fired once") {
+      REQUIRE(activate_cnt == 3);
+      REQUIRE(deactivate_cnt == 3);
+    }
+  }
+
+  WHEN("The time goes backwards into an active period")
+  {
+    ScheduleTimer.poll(1633305600 + 900);
+    ScheduleTimer.poll(1633305600 + 60);
+    THEN("The activation is fired") {
+      REQUIRE(activate_cnt == 1);
+      REQUIRE(deactivate_cnt == 0);
+    }
+  }
+
+  WHEN("The schedule is changed while active")
+  {
+    ScheduleTimer.poll(1633305600 + 60);
+    schedule = Schedule(1633305600 + 3600, 0, 600, Schedule::createOneShotScheduleConfiguration());
+    ScheduleTimer.poll(1633305600 + 61);
+    THEN("The deactivation is fired at once") {
+      REQUIRE(activate_cnt == 1);
+      REQUIRE(deactivate_cnt == 1);
+    }
+  }
+
+  WHEN("The schedule is destroyed")
+  {
+    {
+      CloudSchedule other(1633305600, 0, 600, 0);
+      other.onActivate(onScheduleActivate);
+    }
+    ScheduleTimer.poll(1633305600 + 60);
+    THEN("Only the remaining schedule is fired") {
+      REQUIRE(activate_cnt == 1);
+    }
+  }
+}
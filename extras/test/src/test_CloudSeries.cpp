@@ -0,0 +1,108 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Arduino Cloud Property 'CloudSeries'", "[ArduinoCloudThing::CloudSeries]")
+{
+  PropertyContainer property_container;
+
+  CloudSeries<int, 3> s;
+  addPropertyToContainer(property_container, s, "s", Permission::Read).publishOnChange(0.0f, 0);
+
+  WHEN("More samples are added than the series holds")
+  {
+    s.add(1, 100);
+    s.add(2, 101);
+    s.add(3, 102);
+    s.add(4, 103);
+
+    THEN("The oldest sample has been overwritten") {
+      REQUIRE(s.full());
+      REQUIRE(s[0] == 2);
+      REQUIRE(s[2] == 4);
+    }
+
+    THEN("Each sample is encoded as a timestamped record and the series is cleared") {
+      /* [{0: "s", 2: 2, 6: 101}, {0: "s", 2: 3, 6: 102}, {0: "s", 2: 4, 6: 103}] */
+      std::vector<uint8_t> const expected = {0x9F,
+                                             0xA3, 0x00, 0x61, 0x73, 0x02, 0x02, 0x06, 0x18, 0x65,
+                                             0xA3, 0x00, 0x61, 0x73, 0x02, 0x03, 0x06, 0x18, 0x66,
+                                             0xA3, 0x00, 0x61, 0x73, 0x02, 0x04, 0x06, 0x18, 0x67,
+                                             0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      REQUIRE(actual == expected);
+      REQUIRE(s.size() == 0);
+    }
+  }
+
+  WHEN("Samples are taken within a second")
+  {
+    s.addMillis(1, 100500);
+    s.addMillis(2, 101000);
+
+    THEN("Only the time with a fraction of a second is encoded as a double") {
+      /* [{0: "s", 2: 1, 6: 100.5}, {0: "s", 2: 2, 6: 101}] */
+      std::vector<uint8_t> const expected = {0x9F,
+                                             0xA3, 0x00, 0x61, 0x73, 0x02, 0x01, 0x06, 0xFB, 0x40, 0x59, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                             0xA3, 0x00, 0x61, 0x73, 0x02, 0x02, 0x06, 0x18, 0x65,
+                                             0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      REQUIRE(actual == expected);
+    }
+  }
+
+  WHEN("The samples of a series are encoded as a typed array")
+  {
+    CloudSeries<float, 2> f;
+    PropertyContainer float_container;
+    addPropertyToContainer(float_container, f, "f", Permission::Read).publishOnChange(0.0f, 0);
+    f.encodeTypedArray();
+    f.add(1.0f, 7);
+    f.add(2.0f, 8);
+    f.add(3.0f, 9);
+
+    THEN("A single record holds all samples in order, timestamped with the oldest one") {
+      /* [{0: "f", 8: 85(h'00000040 00004040'), 6: 8}] */
+      std::vector<uint8_t> const expected = {0x9F, 0xA3, 0x00, 0x61, 0x66, 0x08, 0xD8, 0x55, 0x48, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x40, 0x40, 0x06, 0x08, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(float_container);
+      REQUIRE(actual == expected);
+    }
+  }
+
+  WHEN("The samples of a float series are sent as half precision floats")
+  {
+    CloudSeries<float, 4> f;
+    PropertyContainer float_container;
+    addPropertyToContainer(float_container, f, "f", Permission::Read).publishOnChange(0.0f, 0);
+    f.encodeHalfFloat();
+    f.add(1.0f, 7);
+    f.add(-2.0f, 8);
+    f.add(0.5f, 9);
+
+    THEN("Their min, max and mean are available before they are sent") {
+      SeriesStats const stats = f.stats();
+      REQUIRE(stats.min == -2.0f);
+      REQUIRE(stats.max == 1.0f);
+      REQUIRE(stats.mean == Approx(-0.5f / 3.0f));
+    }
+
+    THEN("A single record holds them as a typed array of half precision floats") {
+      /* [{0: "f", 8: 84(h'003C 00C0 0038'), 6: 7}] */
+      std::vector<uint8_t> const expected = {0x9F, 0xA3, 0x00, 0x61, 0x66, 0x08, 0xD8, 0x54, 0x46, 0x00, 0x3C, 0x00, 0xC0, 0x00, 0x38, 0x06, 0x07, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(float_container);
+      REQUIRE(actual == expected);
+    }
+  }
+}
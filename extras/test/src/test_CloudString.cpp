@@ -0,0 +1,108 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+#include <util/AllocationTestUtil.h>
+
+#include <CBORDecoder.h>
+#include <property/types/CloudString.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static char const LONG_VALUE[]  = "A status string which does not fit into the small string buffer";
+static char const OTHER_VALUE[] = "A status string which does not fit into the small string buffer!";
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("A CloudString detects local changes against the published value", "[ArduinoCloudThing::CloudString]")
+{
+  CloudString str_test = LONG_VALUE;
+
+  WHEN("The value has not been changed")
+  {
+    THEN("It is not different from the cloud value")
+    {
+      REQUIRE(str_test.isDifferentFromCloud() == false);
+    }
+  }
+
+  WHEN("The value is changed")
+  {
+    str_test = OTHER_VALUE;
+
+    THEN("It is different from the cloud value until it is published")
+    {
+      REQUIRE(str_test.isDifferentFromCloud() == true);
+      str_test.fromLocalToCloud();
+      REQUIRE(str_test.isDifferentFromCloud() == false);
+      REQUIRE(str_test == OTHER_VALUE);
+    }
+  }
+
+  WHEN("The value is changed and published")
+  {
+    str_test = OTHER_VALUE;
+    str_test.fromLocalToCloud();
+
+    THEN("Publishing does not copy the value")
+    {
+      AllocationCounter counter;
+      str_test.fromLocalToCloud();
+      REQUIRE(counter.count() == 0);
+    }
+    THEN("Setting the published value again is no change")
+    {
+      str_test = OTHER_VALUE;
+      REQUIRE(str_test.isDifferentFromCloud() == false);
+    }
+    THEN("A value of the same length is a change")
+    {
+      String value(OTHER_VALUE);
+      value[0] = 'a';
+      str_test = value;
+      REQUIRE(str_test.isDifferentFromCloud() == true);
+    }
+    THEN("Appending to the value is a change, reverting it is not")
+    {
+      str_test += "?";
+      REQUIRE(str_test.isDifferentFromCloud() == true);
+      str_test = OTHER_VALUE;
+      REQUIRE(str_test.isDifferentFromCloud() == false);
+    }
+    THEN("Reverting a change restores the published value")
+    {
+      str_test = LONG_VALUE;
+      str_test.fromCloudToLocal();
+      REQUIRE(str_test == OTHER_VALUE);
+      REQUIRE(str_test.isDifferentFromCloud() == false);
+    }
+  }
+
+  WHEN("A published value is changed via CBOR message")
+  {
+    PropertyContainer property_container;
+    addPropertyToContainer(property_container, str_test, "test", Permission::ReadWrite);
+    str_test.fromLocalToCloud();
+
+    /* [{0: "test", 3: "cloud"}] = 81 A2 00 64 74 65 73 74 03 65 63 6C 6F 75 64 */
+    uint8_t const payload[] = {0x81, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x03, 0x65, 0x63, 0x6C, 0x6F, 0x75, 0x64};
+    CBORDecoder::decode(property_container, payload, sizeof(payload) / sizeof(uint8_t));
+
+    THEN("The local value takes the cloud value")
+    {
+      REQUIRE(str_test == "cloud");
+      REQUIRE(str_test.isDifferentFromCloud() == false);
+    }
+  }
+}
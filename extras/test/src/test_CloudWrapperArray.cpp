@@ -0,0 +1,76 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+
+#include <CBORDecoder.h>
+#include <PropertyContainer.h>
+#include "types/CloudWrapperArray.h"
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("A C array is bound to a single property", "[CloudWrapperArray]")
+{
+  PropertyContainer property_container;
+
+  int levels[3] = {1, 2, 3};
+  CloudWrapperArray<int, 3> levels_property(levels);
+  addPropertyToContainer(property_container, levels_property, "lvl", Permission::ReadWrite);
+
+  WHEN("It is encoded for the first time")
+  {
+    THEN("Every element is encoded as an attribute named after its index")
+    {
+      /* [{0: "lvl:0", 2: 1}, {0: "lvl:1", 2: 2}, {0: "lvl:2", 2: 3}]
+       * = 9F A2 00 65 6C 76 6C 3A 30 02 01 A2 00 65 6C 76 6C 3A 31 02 02 A2 00 65 6C 76 6C 3A 32 02 03 FF
+       */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x65, 0x6C, 0x76, 0x6C, 0x3A, 0x30, 0x02, 0x01,
+                                                   0xA2, 0x00, 0x65, 0x6C, 0x76, 0x6C, 0x3A, 0x31, 0x02, 0x02,
+                                                   0xA2, 0x00, 0x65, 0x6C, 0x76, 0x6C, 0x3A, 0x32, 0x02, 0x03, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+    }
+  }
+
+  WHEN("A single element changes after the array has been sent")
+  {
+    set_millis(0);
+    REQUIRE(cbor::encode(property_container).size() != 0);
+
+    set_millis(1000);
+    levels[1] = 7;
+    REQUIRE(levels_property.isChangedLocally());
+    REQUIRE_FALSE(levels_property.isChangedLocally());
+    updateTimestampOnLocallyChangedProperties(property_container);
+
+    THEN("Only that element is encoded")
+    {
+      /* [{0: "lvl:1", 2: 7}] = 9F A2 00 65 6C 76 6C 3A 31 02 07 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x65, 0x6C, 0x76, 0x6C, 0x3A, 0x31, 0x02, 0x07, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+      REQUIRE(cbor::encode(property_container).size() == 0);
+    }
+  }
+
+  WHEN("An element is written by the cloud")
+  {
+    /* [{0: "lvl:2", 2: 9}] = 9F A2 00 65 6C 76 6C 3A 32 02 09 FF */
+    uint8_t const payload[] = {0x9F, 0xA2, 0x00, 0x65, 0x6C, 0x76, 0x6C, 0x3A, 0x32, 0x02, 0x09, 0xFF};
+    CBORDecoder::decode(property_container, payload, sizeof(payload));
+
+    THEN("The element of the array is updated and the others are kept")
+    {
+      REQUIRE(levels[0] == 1);
+      REQUIRE(levels[1] == 2);
+      REQUIRE(levels[2] == 9);
+    }
+  }
+}
@@ -0,0 +1,109 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <CooperativeTask.h>
+
+#include <Arduino.h>
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+static int feed_cnt = 0;
+
+static void feed_watchdog()
+{
+  feed_cnt++;
+}
+
+/* Takes step_ms per step and is done after step_cnt steps */
+class CountingTask : public CooperativeTask
+{
+public:
+
+  CountingTask(int const step_cnt, unsigned long const step_ms, int const error_at = -1)
+  : steps{0}, _step_cnt{step_cnt}, _step_ms{step_ms}, _error_at{error_at} { }
+
+  virtual TaskStatus step() override
+  {
+    set_millis(millis() + _step_ms);
+    steps++;
+    if (steps == _error_at)
+      return TaskStatus::Error;
+    return (steps < _step_cnt) ? TaskStatus::InProgress : TaskStatus::Done;
+  }
+
+  int steps;
+
+private:
+
+  int const _step_cnt;
+  unsigned long const _step_ms;
+  int const _error_at;
+};
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Running a long operation in steps", "[CooperativeTask]")
+{
+  set_millis(0);
+  feed_cnt = 0;
+  TaskRunner runner(feed_watchdog);
+
+  WHEN("A task is run to completion")
+  {
+    CountingTask task(5, 10);
+
+    THEN("The watchdog is fed after every step")
+    {
+      REQUIRE(runner.run(task) == TaskStatus::Done);
+      REQUIRE(task.steps == 5);
+      REQUIRE(feed_cnt == 5);
+      REQUIRE(runner.longestStepMillis() == 10);
+    }
+  }
+  WHEN("A step fails")
+  {
+    CountingTask task(5, 10, 2);
+
+    THEN("The task is not stepped any further")
+    {
+      REQUIRE(runner.run(task) == TaskStatus::Error);
+      REQUIRE(task.steps == 2);
+    }
+  }
+  WHEN("A task is run within a budget which is too short")
+  {
+    CountingTask task(10, 10);
+
+    THEN("It is resumed where it has stopped")
+    {
+      REQUIRE(runner.run(task, 25) == TaskStatus::InProgress);
+      REQUIRE(task.steps == 3);
+      REQUIRE(runner.run(task, 25) == TaskStatus::InProgress);
+      REQUIRE(task.steps == 6);
+      REQUIRE(runner.run(task) == TaskStatus::Done);
+      REQUIRE(task.steps == 10);
+    }
+  }
+  WHEN("A task is run without a watchdog")
+  {
+    CountingTask task(3, 1);
+    TaskRunner unfed_runner;
+
+    THEN("It completes all the same")
+    {
+      REQUIRE(unfed_runner.run(task) == TaskStatus::Done);
+      REQUIRE(feed_cnt == 0);
+    }
+  }
+}
@@ -0,0 +1,70 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <CoreLink.h>
+
+#include <string.h>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Passing messages between the cores", "[CoreLink]")
+{
+  alignas(SharedRing::CACHE_LINE) static uint8_t memory[1024];
+  memset(memory, 0, sizeof(memory));
+  CoreLink application;
+  CoreLink network;
+  CoreLink::Kind kind = CoreLink::Kind::Data;
+  uint8_t const * data = nullptr;
+  size_t length = 0;
+
+  WHEN("The application side has not begun yet")
+  {
+    THEN("The network side can not attach")
+    {
+      REQUIRE(network.begin(CoreLink::Side::Network, memory, sizeof(memory)) == false);
+      REQUIRE(network.isReady() == false);
+    }
+  }
+  WHEN("Both sides have begun")
+  {
+    REQUIRE(application.begin(CoreLink::Side::Application, memory, sizeof(memory)) == true);
+    REQUIRE(network.begin(CoreLink::Side::Network, memory, sizeof(memory)) == true);
+
+    THEN("The messages of either side are received by the other one only")
+    {
+      REQUIRE(network.send(CoreLink::Kind::Sync, reinterpret_cast<uint8_t const *>("\xA0"), 1) == true);
+      REQUIRE(network.peek(kind, data, length) == false);
+      REQUIRE(application.peek(kind, data, length) == true);
+      REQUIRE(kind == CoreLink::Kind::Sync);
+      REQUIRE(length == 1);
+      REQUIRE(data[0] == 0xA0);
+      application.pop();
+
+      uint8_t * buf = application.reserve(64);
+      REQUIRE(buf != nullptr);
+      memcpy(buf, "\x81\xA0", 2);
+      application.commit(CoreLink::Kind::Data, 2);
+      REQUIRE(application.peek(kind, data, length) == false);
+      REQUIRE(network.peek(kind, data, length) == true);
+      REQUIRE(kind == CoreLink::Kind::Data);
+      REQUIRE(length == 2);
+      REQUIRE(memcmp(data, "\x81\xA0", 2) == 0);
+    }
+    THEN("A state is passed without a payload")
+    {
+      REQUIRE(network.send(CoreLink::Kind::Connected) == true);
+      REQUIRE(application.peek(kind, data, length) == true);
+      REQUIRE(kind == CoreLink::Kind::Connected);
+      REQUIRE(length == 0);
+    }
+  }
+}
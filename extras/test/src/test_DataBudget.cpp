@@ -0,0 +1,104 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <utility/net/DataBudget.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The data budget refills over its window", "[DataBudget]")
+{
+  DataBudget budget;
+
+  WHEN("No budget is set")
+  {
+    THEN("Any amount of data may be sent")
+    {
+      REQUIRE_FALSE(budget.isEnabled());
+      budget.onSend(100000, 1000);
+      REQUIRE(budget.available(1000) > 100000);
+      REQUIRE(budget.nextAvailableIn(100000, 1000) == 0);
+    }
+  }
+
+  WHEN("A budget of 2048 bytes per minute is set")
+  {
+    budget.begin(2048, 60000, 1000);
+
+    THEN("It starts out full")
+    {
+      REQUIRE(budget.isEnabled());
+      REQUIRE(budget.available(1000) == 2048);
+    }
+
+    THEN("It does not refill beyond its size")
+    {
+      REQUIRE(budget.available(1000 + 10 * 60000) == 2048);
+    }
+
+    AND_WHEN("It has been used up")
+    {
+      budget.onSend(2048, 1000);
+
+      THEN("It refills steadily")
+      {
+        REQUIRE(budget.available(1000) == 0);
+        REQUIRE(budget.available(1000 + 30000) == 1024);
+        REQUIRE(budget.available(1000 + 60000) == 2048);
+      }
+
+      THEN("The time until enough has refilled is known")
+      {
+        REQUIRE(budget.nextAvailableIn(512, 1000) == 15000);
+        REQUIRE(budget.nextAvailableIn(512, 1000 + 10000) == 5000);
+        REQUIRE(budget.nextAvailableIn(512, 1000 + 15000) == 0);
+        REQUIRE(budget.available(1000 + 15000) >= 512);
+      }
+
+      THEN("More than the whole budget is never waited for")
+      {
+        REQUIRE(budget.nextAvailableIn(4096, 1000) == 60000);
+      }
+    }
+
+    AND_WHEN("A message larger than what is left is sent")
+    {
+      budget.onSend(3072, 1000);
+
+      THEN("The debt is paid back before anything is available")
+      {
+        REQUIRE(budget.available(1000 + 30000) == 0);
+        REQUIRE(budget.available(1000 + 60000) == 1024);
+        REQUIRE(budget.nextAvailableIn(1024, 1000) == 60000);
+      }
+    }
+
+    THEN("It follows the wrap around of millis()")
+    {
+      budget.begin(2048, 60000, static_cast<unsigned long>(-1) - 9999);
+      budget.onSend(2048, static_cast<unsigned long>(-1) - 9999);
+      REQUIRE(budget.available(20000) == 1024);
+    }
+  }
+
+  WHEN("The budget is lifted again")
+  {
+    budget.begin(2048, 60000, 1000);
+    budget.onSend(2048, 1000);
+    budget.begin(2048, 0, 2000);
+
+    THEN("Any amount of data may be sent")
+    {
+      REQUIRE_FALSE(budget.isEnabled());
+      REQUIRE(budget.nextAvailableIn(4096, 2000) == 0);
+    }
+  }
+}
@@ -0,0 +1,74 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string>
+
+#include <utility/ota/DeltaPatcher.h>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+static void append(uint8_t const c, void * ctx)
+{
+  static_cast<std::string *>(ctx)->push_back(static_cast<char>(c));
+}
+
+SCENARIO("Applying a delta produced by extras/tools/bin2delta.py", "[DeltaPatcher::patch]")
+{
+  std::string const source = "Arduino IoT Cloud delta update test, old image content here.";
+  std::string const target = "Arduino IoT Cloud delta update test, NEW image content here.";
+
+  /* COPY 0 37, INSERT "NEW", COPY 40 20 */
+  uint8_t delta[] =
+  {
+    0x41, 0x44, 0x4c, 0x54, 0xe0, 0xfe, 0x1f, 0xd7, 0xac, 0x95, 0x33, 0x8f,
+    0x58, 0xe4, 0xa1, 0x92, 0x83, 0x5f, 0x8d, 0x4e, 0xfe, 0x28, 0x3e, 0xa9,
+    0x46, 0xef, 0x46, 0x46, 0xd4, 0x10, 0xfd, 0x45, 0xbd, 0xb1, 0x48, 0x27,
+    0x3c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00,
+    0x00, 0x02, 0x03, 0x00, 0x00, 0x00, 0x4e, 0x45, 0x57, 0x01, 0x28, 0x00,
+    0x00, 0x00, 0x14, 0x00, 0x00, 0x00
+  };
+
+  std::string patched;
+  DeltaPatcher patcher(append, &patched);
+  patcher.reset(reinterpret_cast<uint8_t const *>(source.data()), source.size());
+
+  WHEN("The delta is fed byte by byte")
+  {
+    for (size_t i = 0; i < sizeof(delta); i++)
+      REQUIRE(patcher.patch(delta + i, 1) == DeltaPatcher::Error::None);
+
+    THEN("The target image is rebuilt") {
+      REQUIRE(patcher.isHeaderComplete() == true);
+      REQUIRE(patcher.sourceSHA256()[0] == 0xe0);
+      REQUIRE(patcher.targetSize() == target.size());
+      REQUIRE(patcher.isComplete() == true);
+      REQUIRE(patched == target);
+    }
+  }
+
+  WHEN("A copy exceeds the source image")
+  {
+    delta[sizeof(delta) - 4] = 0xFF;
+    THEN("The delta is rejected") {
+      REQUIRE(patcher.patch(delta, sizeof(delta)) == DeltaPatcher::Error::SourceRange);
+      REQUIRE(patcher.isComplete() == false);
+    }
+  }
+
+  WHEN("The delta is not in the expected format")
+  {
+    delta[0] = 'X';
+    THEN("The header is rejected") {
+      REQUIRE(patcher.patch(delta, sizeof(delta)) == DeltaPatcher::Error::Header);
+    }
+  }
+}
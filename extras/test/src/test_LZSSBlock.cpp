@@ -0,0 +1,196 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include <util/CBORTestUtil.h>
+
+#include <CBORDecoder.h>
+#include <property/types/CloudBinary.h>
+#include <property/types/CloudString.h>
+#include <utility/compress/LZSSBlock.h>
+#include <utility/memory/ScratchPool.h>
+#include <utility/ota/LZSSDecoder.h>
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+static void append(uint8_t const c, void * ctx)
+{
+  static_cast<std::string *>(ctx)->push_back(static_cast<char>(c));
+}
+
+static std::string const JSON = "{\"temperature\":21.5,\"humidity\":40,\"pressure\":1013},"
+                                "{\"temperature\":21.6,\"humidity\":41,\"pressure\":1013},"
+                                "{\"temperature\":21.6,\"humidity\":41,\"pressure\":1012}";
+
+static uint8_t const * bytes(std::string const & str)
+{
+  return reinterpret_cast<uint8_t const *>(str.c_str());
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("A value is compressed as a whole", "[LZSSBlock]")
+{
+  uint8_t compressed[256];
+
+  WHEN("A repetitive value is compressed")
+  {
+    size_t const length = LZSSBlock::compress(bytes(JSON), JSON.length(), compressed, sizeof(compressed));
+
+    THEN("It shrinks and is restored by decompressing it")
+    {
+      REQUIRE(length > 0);
+      REQUIRE(length < JSON.length() / 2);
+
+      String decompressed;
+      REQUIRE(LZSSBlock::decompress(compressed, length, decompressed, 1024));
+      REQUIRE(std::string(decompressed.c_str()) == JSON);
+    }
+
+    THEN("It is restored by the decoder of the OTA images as well")
+    {
+      std::string decoded;
+      LZSSDecoder decoder(append, &decoded);
+      decoder.decode(compressed, length);
+      REQUIRE(decoded == JSON);
+    }
+
+    THEN("It is refused if the decompressed value exceeds the maximum length")
+    {
+      String decompressed;
+      REQUIRE_FALSE(LZSSBlock::decompress(compressed, length, decompressed, JSON.length() - 1));
+    }
+  }
+
+  WHEN("A value with runs and leading spaces is compressed")
+  {
+    std::string const value = "    aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa b";
+    size_t const length = LZSSBlock::compress(bytes(value), value.length(), compressed, sizeof(compressed));
+
+    THEN("The overlapping matches are restored")
+    {
+      String decompressed;
+      REQUIRE(LZSSBlock::decompress(compressed, length, decompressed, 1024));
+      REQUIRE(std::string(decompressed.c_str()) == value);
+    }
+  }
+
+  WHEN("The compressed value does not fit")
+  {
+    THEN("Nothing is returned")
+    {
+      REQUIRE(LZSSBlock::compress(bytes(JSON), JSON.length(), compressed, 8) == 0);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("A string property is sent compressed", "[LZSSBlock]")
+{
+  PropertyContainer property_container;
+  CloudString str;
+  addPropertyToContainer(property_container, str, "test", Permission::ReadWrite).encodeCompressed();
+
+  WHEN("A long value which compresses is sent")
+  {
+    str = JSON.c_str();
+    std::vector<uint8_t> const encoded = cbor::encode(property_container);
+
+    THEN("It is sent as compressed data value and restored by the receiver")
+    {
+      /* [{0: "test", 9: 1, 8: h'...'}] */
+      uint8_t const header[] = {0x9F, 0xA3, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x09, 0x01, 0x08};
+      REQUIRE(encoded.size() < JSON.length());
+      REQUIRE(std::vector<uint8_t>(encoded.begin(), encoded.begin() + sizeof(header)) == std::vector<uint8_t>(header, header + sizeof(header)));
+
+      PropertyContainer receiver_container;
+      CloudString received;
+      addPropertyToContainer(receiver_container, received, "test", Permission::ReadWrite);
+      CBORDecoder::decode(receiver_container, encoded.data(), encoded.size());
+      REQUIRE(std::string(String(received).c_str()) == JSON);
+    }
+  }
+
+  WHEN("A short value is sent")
+  {
+    str = "test";
+    std::vector<uint8_t> const encoded = cbor::encode(property_container);
+
+    THEN("It is sent as string value")
+    {
+      /* [{0: "test", 3: "test"}] */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x03, 0x64, 0x74, 0x65, 0x73, 0x74, 0xFF};
+      REQUIRE(encoded == expected);
+    }
+  }
+
+  WHEN("A long value is sent while the scratch pool is leased")
+  {
+    str = JSON.c_str();
+    ScratchLease const lease(1);
+    std::vector<uint8_t> const encoded = cbor::encode(property_container);
+
+    THEN("It is sent as string value")
+    {
+      /* [{0: "test", 3: "..."}] */
+      uint8_t const header[] = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x03};
+      REQUIRE(encoded.size() > JSON.length());
+      REQUIRE(std::vector<uint8_t>(encoded.begin(), encoded.begin() + sizeof(header)) == std::vector<uint8_t>(header, header + sizeof(header)));
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("A binary property is sent compressed", "[LZSSBlock]")
+{
+  PropertyContainer property_container;
+  uint8_t buffer[256];
+  CloudBinary blob(buffer, sizeof(buffer));
+  addPropertyToContainer(property_container, blob, "test", Permission::ReadWrite).encodeCompressed();
+  REQUIRE(blob.set(bytes(JSON), JSON.length()));
+  std::vector<uint8_t> const encoded = cbor::encode(property_container);
+
+  WHEN("The receiver has room for the value")
+  {
+    PropertyContainer receiver_container;
+    uint8_t received_buffer[256] = {0};
+    CloudBinary received(received_buffer, sizeof(received_buffer));
+    addPropertyToContainer(receiver_container, received, "test", Permission::ReadWrite);
+    CBORDecoder::decode(receiver_container, encoded.data(), encoded.size());
+
+    THEN("It is restored")
+    {
+      REQUIRE(encoded.size() < JSON.length());
+      REQUIRE(std::string(reinterpret_cast<char const *>(received.data()), received.length()) == JSON);
+    }
+  }
+
+  WHEN("The value does not fit into the buffer of the receiver")
+  {
+    PropertyContainer receiver_container;
+    uint8_t received_buffer[64] = {0};
+    CloudBinary received(received_buffer, sizeof(received_buffer), 4);
+    addPropertyToContainer(receiver_container, received, "test", Permission::ReadWrite);
+    CBORDecoder::decode(receiver_container, encoded.data(), encoded.size());
+
+    THEN("The buffer is emptied")
+    {
+      REQUIRE(received.length() == 0);
+    }
+  }
+}
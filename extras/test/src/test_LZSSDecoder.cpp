@@ -0,0 +1,54 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string>
+
+#include <utility/ota/LZSSDecoder.h>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+static void append(uint8_t const c, void * ctx)
+{
+  static_cast<std::string *>(ctx)->push_back(static_cast<char>(c));
+}
+
+SCENARIO("Decoding data compressed by extras/tools/lzss.c", "[LZSSDecoder::decode]")
+{
+  /* lzss.c --encode of "Arduino IoT Cloud Arduino IoT Cloud OTA OTA OTA OTA OTA " */
+  uint8_t const compressed[] =
+  {
+    0xa0, 0xdc, 0xac, 0x97, 0x5b, 0x4d, 0xba, 0xdf, 0x20, 0xa4, 0xdb, 0xea,
+    0x92, 0x0a, 0x1d, 0xb2, 0xdf, 0x75, 0xb2, 0x3f, 0x77, 0xbf, 0xf8, 0x53,
+    0xea, 0x94, 0x10, 0x12, 0xf0
+  };
+  std::string const expected = "Arduino IoT Cloud Arduino IoT Cloud OTA OTA OTA OTA OTA ";
+
+  std::string decoded;
+  LZSSDecoder decoder(append, &decoded);
+
+  WHEN("The compressed data is fed at once")
+  {
+    decoder.decode(compressed, sizeof(compressed));
+    THEN("The original data is restored") {
+      REQUIRE(decoded == expected);
+    }
+  }
+
+  WHEN("The compressed data is fed byte by byte")
+  {
+    for (size_t i = 0; i < sizeof(compressed); i++)
+      decoder.decode(compressed + i, 1);
+    THEN("The original data is restored") {
+      REQUIRE(decoded == expected);
+    }
+  }
+}
@@ -0,0 +1,60 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <LatencyStats.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Latency percentiles are computed over the recent samples", "[LatencyStats]")
+{
+  LatencyStats stats;
+
+  WHEN("No sample has been taken")
+  {
+    THEN("All percentiles are 0")
+    {
+      REQUIRE(stats.size() == 0);
+      REQUIRE(stats.percentile(50) == 0);
+      REQUIRE(stats.percentile(99) == 0);
+    }
+  }
+
+  WHEN("Samples 1..20 are added in reverse order")
+  {
+    for (uint32_t s = 20; s > 0; s--)
+      stats.add(s);
+
+    THEN("The nearest-rank percentiles are returned")
+    {
+      REQUIRE(stats.size() == 20);
+      REQUIRE(stats.percentile(50) == 10);
+      REQUIRE(stats.percentile(95) == 19);
+      REQUIRE(stats.percentile(99) == 20);
+      REQUIRE(stats.percentile(100) == 20);
+    }
+  }
+
+  WHEN("More samples than fit are added")
+  {
+    size_t const sample_cnt = LatencyStats::SAMPLE_CNT;
+    for (size_t i = 0; i < sample_cnt; i++)
+      stats.add(1000);
+    for (size_t i = 0; i < sample_cnt; i++)
+      stats.add(5);
+
+    THEN("Only the most recent samples are kept")
+    {
+      REQUIRE(stats.size() == sample_cnt);
+      REQUIRE(stats.percentile(99) == 5);
+    }
+  }
+}
@@ -0,0 +1,144 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <limits.h>
+
+#include <LoRaDutyCycle.h>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Computing the time on air of an uplink", "[LoRaDutyCycle::airtime_us]")
+{
+  WHEN("10 application bytes are sent at SF7/125 kHz")
+  {
+    THEN("The 23 byte frame takes 61.7 ms")
+    {
+      REQUIRE(LoRaDutyCycle::airtime_us(10, 7, 125) == 61696);
+    }
+  }
+  WHEN("The same payload is sent at SF12/125 kHz")
+  {
+    THEN("The low data rate optimisation applies")
+    {
+      REQUIRE(LoRaDutyCycle::airtime_us(10, 12, 125) == 1482752);
+    }
+  }
+  WHEN("The payload grows")
+  {
+    THEN("The time on air does not decrease")
+    {
+      REQUIRE(LoRaDutyCycle::airtime_us(51, 9, 125) >= LoRaDutyCycle::airtime_us(50, 9, 125));
+    }
+  }
+}
+
+SCENARIO("Pacing uplinks to the duty cycle", "[LoRaDutyCycle::canTransmit]")
+{
+  LoRaDutyCycle duty_cycle;
+
+  WHEN("No uplink has been sent yet")
+  {
+    THEN("The band is free")
+    {
+      REQUIRE(duty_cycle.canTransmit(0) == true);
+    }
+  }
+  WHEN("An uplink of 62 ms on air is sent with a 1% duty cycle")
+  {
+    duty_cycle.onTransmit(10, 1000);
+
+    THEN("The band is blocked for 99 times the time on air")
+    {
+      REQUIRE(duty_cycle.canTransmit(1000) == false);
+      REQUIRE(duty_cycle.waitTime(1000) == 62 * 99);
+      REQUIRE(duty_cycle.canTransmit(1000 + 62 * 99 - 1) == false);
+      REQUIRE(duty_cycle.canTransmit(1000 + 62 * 99) == true);
+    }
+  }
+  WHEN("The clock wraps around while the band is blocked")
+  {
+    duty_cycle.onTransmit(10, ULONG_MAX - 0xFF);
+
+    THEN("The remaining time is computed across the wrap")
+    {
+      REQUIRE(duty_cycle.waitTime(0x100UL) == (62 * 99 - 0x200));
+    }
+  }
+  WHEN("The duty cycle is disabled")
+  {
+    duty_cycle.setDutyCycle(0);
+    duty_cycle.onTransmit(10, 1000);
+
+    THEN("Uplinks are never delayed")
+    {
+      REQUIRE(duty_cycle.canTransmit(1000) == true);
+    }
+  }
+}
+
+SCENARIO("Bounding the payload of an uplink", "[LoRaDutyCycle::maxPayload]")
+{
+  LoRaDutyCycle duty_cycle;
+
+  WHEN("The default data rate is used")
+  {
+    THEN("The EU868 DR5 limit applies")
+    {
+      REQUIRE(duty_cycle.maxPayload() == 222);
+    }
+  }
+  WHEN("The data rate is lowered to SF12")
+  {
+    duty_cycle.setDataRate(12, 125);
+
+    THEN("The EU868 DR0 limit applies")
+    {
+      REQUIRE(duty_cycle.maxPayload() == 51);
+    }
+  }
+  WHEN("A dwell time of 400 ms is configured")
+  {
+    duty_cycle.setDataRate(10, 125);
+    duty_cycle.setMaxPayload(222);
+    duty_cycle.setMaxDwellTime(400);
+
+    THEN("The payload is limited to what fits into the dwell time")
+    {
+      size_t const max_payload = duty_cycle.maxPayload();
+      REQUIRE(max_payload < 222);
+      REQUIRE(LoRaDutyCycle::airtime_us(max_payload, 10, 125) <= 400000);
+      REQUIRE(LoRaDutyCycle::airtime_us(max_payload + 1, 10, 125) > 400000);
+    }
+  }
+}
+
+SCENARIO("Applying regional parameters", "[LoRaDutyCycle::setRegion]")
+{
+  LoRaDutyCycle duty_cycle;
+
+  WHEN("The region is set to US915")
+  {
+    duty_cycle.setRegion(LoRaRegion::US915);
+
+    THEN("Uplinks are not paced by a duty cycle")
+    {
+      duty_cycle.onTransmit(10, 1000);
+      REQUIRE(duty_cycle.canTransmit(1000) == true);
+    }
+    THEN("The payload follows the US915 limit of the data rate")
+    {
+      REQUIRE(duty_cycle.maxPayload() == 242);
+      duty_cycle.setDataRate(10, 125);
+      REQUIRE(duty_cycle.maxPayload() == 11);
+    }
+  }
+}
@@ -0,0 +1,288 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string.h>
+
+#include <vector>
+
+#include <util/CBORTestUtil.h>
+
+#include <CBORDecoder.h>
+#include <utility/net/LocalMirror.h>
+#include "types/CloudWrapperInt.h"
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+/* [{0: "test", 2: 7}] = 81 A2 00 64 74 65 73 74 02 07 */
+static std::vector<uint8_t> const MESSAGE = {0x81, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x07};
+
+static uint8_t const KEY[32] = {
+  0x4b, 0x8e, 0x13, 0xa7, 0x02, 0x5d, 0xf1, 0x9c, 0x66, 0x3a, 0xc4, 0x0e, 0x7f, 0xb2, 0x58, 0x91,
+  0xd3, 0x27, 0x6c, 0xe0, 0x1a, 0x85, 0x4f, 0xbb, 0x39, 0x70, 0xae, 0x15, 0xc8, 0x62, 0x0d, 0xf4
+};
+
+static uint32_t epoch = 0;
+
+static LocalMirror & attach(LocalMirror & mirror, char const * device_id, uint8_t const * key = KEY, char const * thing_id = "thing-id")
+{
+  REQUIRE(mirror.begin(device_id, key, sizeof(KEY)));
+  mirror.setThing(thing_id, ++epoch);
+  return mirror;
+}
+
+static std::vector<uint8_t> frame(LocalMirror & sender)
+{
+  std::vector<uint8_t> buf(LocalMirror::HEADER_SIZE);
+  sender.header(buf.data());
+  buf.insert(buf.end(), MESSAGE.begin(), MESSAGE.end());
+  buf.resize(buf.size() + LocalMirror::TAG_SIZE);
+  sender.tag(buf.data(), MESSAGE.data(), MESSAGE.size(), buf.data() + LocalMirror::HEADER_SIZE + MESSAGE.size());
+  return buf;
+}
+
+/* Delivers buf to the receiver, the replies are delivered back and forth
+ * between receiver and sender until the handshake is done. All the frames
+ * seen are appended to the record if one is given.
+ */
+static bool deliver(LocalMirror & receiver, std::vector<uint8_t> const & buf, LocalMirror * sender = nullptr, std::vector<std::vector<uint8_t>> * record = nullptr)
+{
+  if (record)
+    record->push_back(buf);
+
+  size_t length = 0;
+  uint8_t reply[LocalMirror::REPLY_SIZE];
+  size_t reply_length = 0;
+  uint8_t const * message = receiver.accept(buf.data(), buf.size(), length, reply, reply_length);
+  bool const is_accepted = (message != nullptr) && (std::vector<uint8_t>(message, message + length) == MESSAGE);
+
+  if (sender && (reply_length > 0))
+    deliver(*sender, std::vector<uint8_t>(reply, reply + reply_length), &receiver, record);
+  return is_accepted;
+}
+
+static bool accepted(LocalMirror & receiver, std::vector<uint8_t> const & buf)
+{
+  return deliver(receiver, buf);
+}
+
+/* Applies the first frame of the sender, the receiver handshakes meanwhile */
+static void sync(LocalMirror & receiver, LocalMirror & sender)
+{
+  REQUIRE_FALSE(deliver(receiver, frame(sender), &sender));
+  REQUIRE(accepted(receiver, frame(sender)));
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Property updates are framed for the peers on the LAN", "[LocalMirror]")
+{
+  LocalMirror own, peer;
+  attach(own, "5f4f0c1a-9bd4-4c8f-8d0e-6c7e5a1b2c3d");
+  attach(peer, "0d6c2f1e-7a3b-4c5d-9e8f-1a2b3c4d5e6f");
+
+  WHEN("the first frame of a peer is received")
+  {
+    THEN("it is dropped until the peer answered the challenge")
+    {
+      REQUIRE_FALSE(accepted(own, frame(peer)));
+      REQUIRE_FALSE(accepted(own, frame(peer)));
+      REQUIRE_FALSE(deliver(own, frame(peer), &peer));
+      REQUIRE(accepted(own, frame(peer)));
+    }
+  }
+
+  WHEN("our own frame is looped back by the multicast group")
+  {
+    THEN("it is dropped")
+    {
+      REQUIRE_FALSE(deliver(own, frame(own), &own));
+    }
+  }
+
+  WHEN("a frame of a peer arrives after a later one")
+  {
+    sync(own, peer);
+    std::vector<uint8_t> const first = frame(peer);
+    std::vector<uint8_t> const second = frame(peer);
+    REQUIRE(accepted(own, second));
+    THEN("it is dropped, as is a duplicate")
+    {
+      REQUIRE_FALSE(accepted(own, first));
+      REQUIRE_FALSE(accepted(own, second));
+      REQUIRE(accepted(own, frame(peer)));
+    }
+  }
+
+  WHEN("the frames of a peer are replayed after it restarted")
+  {
+    std::vector<std::vector<uint8_t>> record;
+    REQUIRE_FALSE(deliver(own, frame(peer), &peer, &record));
+    for (int i = 0; i < 100; i++)
+      REQUIRE(deliver(own, frame(peer), &peer, &record));
+    attach(peer, "0d6c2f1e-7a3b-4c5d-9e8f-1a2b3c4d5e6f");
+    THEN("the restarted peer is synchronized again and none of the frames recorded is applied")
+    {
+      REQUIRE_FALSE(deliver(own, frame(peer), &peer));
+      REQUIRE(accepted(own, frame(peer)));
+      for (std::vector<uint8_t> const & buf : record)
+        REQUIRE_FALSE(deliver(own, buf, &peer));
+      REQUIRE(accepted(own, frame(peer)));
+    }
+  }
+
+  WHEN("the frames of a peer are replayed after the receiver restarted")
+  {
+    std::vector<std::vector<uint8_t>> record;
+    REQUIRE_FALSE(deliver(own, frame(peer), &peer, &record));
+    for (int i = 0; i < 100; i++)
+      REQUIRE(deliver(own, frame(peer), &peer, &record));
+    attach(own, "5f4f0c1a-9bd4-4c8f-8d0e-6c7e5a1b2c3d");
+    THEN("neither the frames nor the syncs recorded are applied")
+    {
+      for (std::vector<uint8_t> const & buf : record)
+        REQUIRE_FALSE(deliver(own, buf, &peer));
+      for (std::vector<uint8_t> const & buf : record)
+        REQUIRE_FALSE(accepted(own, buf));
+      REQUIRE(accepted(own, frame(peer)));
+    }
+  }
+
+  WHEN("a frame is malformed")
+  {
+    std::vector<uint8_t> buf = frame(peer);
+    buf[0] = 'X';
+    THEN("it is dropped")
+    {
+      REQUIRE_FALSE(deliver(own, buf, &peer));
+      REQUIRE_FALSE(deliver(own, std::vector<uint8_t>(LocalMirror::HEADER_SIZE + LocalMirror::TAG_SIZE, 0), &peer));
+    }
+  }
+
+  WHEN("a frame of a device of another thing is received")
+  {
+    LocalMirror other;
+    attach(other, "0d6c2f1e-7a3b-4c5d-9e8f-1a2b3c4d5e6f", KEY, "other-thing-id");
+    THEN("it is dropped")
+    {
+      REQUIRE_FALSE(deliver(own, frame(other), &other));
+      REQUIRE_FALSE(deliver(own, frame(other), &other));
+    }
+  }
+
+  WHEN("a frame is tagged with another key")
+  {
+    uint8_t key[sizeof(KEY)];
+    memcpy(key, KEY, sizeof(KEY));
+    key[0] ^= 1;
+    LocalMirror forger;
+    attach(forger, "0d6c2f1e-7a3b-4c5d-9e8f-1a2b3c4d5e6f", key);
+    THEN("it is dropped")
+    {
+      REQUIRE_FALSE(deliver(own, frame(forger), &forger));
+      REQUIRE_FALSE(deliver(own, frame(forger), &forger));
+    }
+  }
+
+  WHEN("a frame is tampered with")
+  {
+    sync(own, peer);
+    std::vector<uint8_t> payload = frame(peer);
+    payload[LocalMirror::HEADER_SIZE + 9] ^= 1;
+    std::vector<uint8_t> sequence = frame(peer);
+    sequence[19] ^= 1;
+    std::vector<uint8_t> tag = frame(peer);
+    tag.back() ^= 1;
+    std::vector<uint8_t> truncated = frame(peer);
+    truncated.pop_back();
+    THEN("it is dropped")
+    {
+      REQUIRE_FALSE(accepted(own, payload));
+      REQUIRE_FALSE(accepted(own, sequence));
+      REQUIRE_FALSE(accepted(own, tag));
+      REQUIRE_FALSE(accepted(own, truncated));
+      REQUIRE(accepted(own, frame(peer)));
+    }
+  }
+
+  WHEN("the mirror is not attached to a thing yet")
+  {
+    LocalMirror detached;
+    REQUIRE(detached.begin("5f4f0c1a-9bd4-4c8f-8d0e-6c7e5a1b2c3d", KEY, sizeof(KEY)));
+    THEN("every frame is dropped")
+    {
+      REQUIRE_FALSE(detached.isAttached());
+      REQUIRE_FALSE(deliver(detached, frame(peer), &peer));
+      REQUIRE_FALSE(deliver(detached, frame(peer), &peer));
+    }
+  }
+
+  WHEN("the key is too short")
+  {
+    LocalMirror mirror;
+    THEN("the mirror is not started")
+    {
+      REQUIRE_FALSE(mirror.begin("5f4f0c1a-9bd4-4c8f-8d0e-6c7e5a1b2c3d", KEY, LocalMirror::MIN_KEY_SIZE - 1));
+      REQUIRE_FALSE(mirror.begin("5f4f0c1a-9bd4-4c8f-8d0e-6c7e5a1b2c3d", nullptr, sizeof(KEY)));
+    }
+  }
+
+  WHEN("more peers are heard than can be tracked")
+  {
+    std::vector<LocalMirror> peers(LocalMirror::MAX_PEERS + 1);
+    for (size_t i = 0; i < peers.size(); i++)
+    {
+      std::string const id = "peer-" + std::to_string(i);
+      attach(peers[i], id.c_str());
+    }
+    sync(own, peers[0]);
+    std::vector<uint8_t> const stale = frame(peers[0]);
+    for (LocalMirror & p : peers)
+      deliver(own, frame(p), &p);
+    THEN("the one heard of the longest time ago is synchronized again")
+    {
+      REQUIRE_FALSE(deliver(own, frame(peers[0]), &peers[0]));
+      REQUIRE_FALSE(accepted(own, stale));
+      REQUIRE(accepted(own, frame(peers[0])));
+    }
+  }
+}
+
+SCENARIO("A property update of a peer is applied without an echo", "[LocalMirror]")
+{
+  PropertyContainer property_container;
+  int value = 0;
+  CloudWrapperInt * p = new CloudWrapperInt(value);
+  addPropertyToContainer(property_container, *p, "test", Permission::ReadWrite);
+  cbor::encode(property_container);
+
+  WHEN("the message is decoded as one of a peer")
+  {
+    CBORDecoder::decode(property_container, MESSAGE.data(), MESSAGE.size(), false, true);
+    THEN("the value is taken but not sent back")
+    {
+      REQUIRE(value == 7);
+      REQUIRE(cbor::encode(property_container).empty());
+    }
+  }
+
+  WHEN("the message is decoded as one of the cloud")
+  {
+    CBORDecoder::decode(property_container, MESSAGE.data(), MESSAGE.size());
+    THEN("the value is echoed")
+    {
+      REQUIRE(value == 7);
+      REQUIRE_FALSE(cbor::encode(property_container).empty());
+    }
+  }
+}
@@ -0,0 +1,119 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <stdint.h>
+
+#include <util/AllocationTestUtil.h>
+
+#include <utility/memory/MemoryPool.h>
+#include <utility/memory/StaticArena.h>
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+/* Hands out a single block of its own buffer, as an allocator of external
+ * memory would.
+ */
+class BufferAllocator : public MemoryAllocator
+{
+public:
+  BufferAllocator() : allocation_cnt(0), release_cnt(0), _is_taken(false) { }
+
+  virtual void * allocate(size_t const size) override
+  {
+    if (_is_taken || (size > sizeof(_buffer)))
+      return nullptr;
+    _is_taken = true;
+    allocation_cnt++;
+    return _buffer;
+  }
+  virtual void release(void * ptr) override
+  {
+    REQUIRE(ptr == _buffer);
+    _is_taken = false;
+    release_cnt++;
+  }
+
+  inline bool owns(void const * ptr) const { return ptr == _buffer; }
+
+  int allocation_cnt;
+  int release_cnt;
+
+private:
+  alignas(8) uint8_t _buffer[StaticArena::SIZE];
+  bool _is_taken;
+};
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The memory of a pool is taken from the allocator set for it", "[MemoryPool]")
+{
+  BufferAllocator allocator;
+
+  WHEN("No allocator is set")
+  {
+    AllocationCounter counter;
+    void * const mem = memoryAlloc(MemoryPool::Certificate, 64);
+    memoryFree(MemoryPool::Certificate, mem);
+    size_t const allocation_cnt = counter.count();
+
+    THEN("The heap is used")
+    {
+      REQUIRE(mem != nullptr);
+      REQUIRE(allocation_cnt == 1);
+    }
+  }
+
+  WHEN("An allocator is set for a pool")
+  {
+    setMemoryAllocator(MemoryPool::Ota, &allocator);
+
+    AllocationCounter counter;
+    void * const ota_mem = memoryAlloc(MemoryPool::Ota, 1024);
+    void * const second_ota_mem = memoryAlloc(MemoryPool::Ota, 1024);
+    void * const cert_mem = memoryAlloc(MemoryPool::Certificate, 64);
+    memoryFree(MemoryPool::Ota, ota_mem);
+    memoryFree(MemoryPool::Certificate, cert_mem);
+    size_t const allocation_cnt = counter.count();
+
+    setMemoryAllocator(MemoryPool::Ota, nullptr);
+
+    THEN("Only that pool is taken from it")
+    {
+      REQUIRE(allocator.owns(ota_mem));
+      REQUIRE(allocation_cnt == 1);
+      REQUIRE_FALSE(allocator.owns(cert_mem));
+      REQUIRE(allocator.release_cnt == 1);
+    }
+
+    THEN("An allocation which it can not serve fails")
+    {
+      REQUIRE(second_ota_mem == nullptr);
+    }
+  }
+
+  WHEN("An allocator is set for the properties and the arena is exhausted")
+  {
+    setMemoryAllocator(MemoryPool::Property, &allocator);
+    void * const mem = arenaAlloc(StaticArena::SIZE);
+    arenaFree(mem);
+    setMemoryAllocator(MemoryPool::Property, nullptr);
+
+    THEN("The objects of the properties are taken from it")
+    {
+      REQUIRE(allocator.owns(mem));
+      REQUIRE(allocator.allocation_cnt == 1);
+      REQUIRE(allocator.release_cnt == 1);
+    }
+  }
+}
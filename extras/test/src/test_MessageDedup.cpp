@@ -0,0 +1,85 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string.h>
+
+#include <string>
+
+#include <MessageDedup.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+static uint32_t digest(char const * topic, char const * payload)
+{
+  return MessageDedup::update(MessageDedup::begin(topic, strlen(topic)), reinterpret_cast<uint8_t const *>(payload), strlen(payload));
+}
+
+SCENARIO("Recognising messages which are delivered again", "[MessageDedup]")
+{
+  char const * data   = "/a/t/a3b5c7d9-1e2f-4a6b-8c0d-2e4f6a8b0c1e/e/i";
+  char const * shadow = "/a/t/a3b5c7d9-1e2f-4a6b-8c0d-2e4f6a8b0c1e/shadow/i";
+
+  MessageDedup dedup;
+  dedup.add(digest(data, "switch=1"));
+
+  WHEN("The same message is received again")
+  {
+    THEN("It is found in the window")
+    {
+      REQUIRE(dedup.contains(digest(data, "switch=1")));
+    }
+  }
+
+  WHEN("Another payload or the same payload on another topic is received")
+  {
+    THEN("It is not found")
+    {
+      REQUIRE_FALSE(dedup.contains(digest(data, "switch=0")));
+      REQUIRE_FALSE(dedup.contains(digest(shadow, "switch=1")));
+    }
+  }
+
+  WHEN("The payload is hashed in chunks")
+  {
+    uint32_t chunked = MessageDedup::begin(data, strlen(data));
+    chunked = MessageDedup::update(chunked, reinterpret_cast<uint8_t const *>("swi"), 3);
+    chunked = MessageDedup::update(chunked, reinterpret_cast<uint8_t const *>("tch=1"), 5);
+
+    THEN("The digest equals that of the whole payload")
+    {
+      REQUIRE(chunked == digest(data, "switch=1"));
+    }
+  }
+
+  WHEN("The window has filled up with other messages")
+  {
+    size_t const window_size = MessageDedup::WINDOW_SIZE;
+    for (size_t i = 0; i < window_size; i++)
+      dedup.add(digest(data, std::to_string(i).c_str()));
+
+    THEN("The oldest message has been forgotten")
+    {
+      REQUIRE_FALSE(dedup.contains(digest(data, "switch=1")));
+      REQUIRE(dedup.contains(digest(data, "0")));
+    }
+  }
+
+  WHEN("The window is cleared")
+  {
+    dedup.clear();
+
+    THEN("No message is found")
+    {
+      REQUIRE_FALSE(dedup.contains(digest(data, "switch=1")));
+    }
+  }
+}
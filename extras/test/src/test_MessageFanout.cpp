@@ -0,0 +1,87 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <utility/net/MessageFanout.h>
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+class TestSink : public MessageSink
+{
+public:
+  TestSink() : is_busy(false), delivered(0), last_data(nullptr) { }
+  virtual bool deliver(uint8_t const * data, size_t const /* length */, bool const /* is_timestamped */) override {
+    if (is_busy)
+      return false;
+    delivered++;
+    last_data = data;
+    return true;
+  }
+  bool is_busy;
+  int delivered;
+  uint8_t const * last_data;
+};
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("A message is fanned out to several sinks", "[MessageFanout]")
+{
+  MessageFanout fanout;
+  TestSink mirror, log;
+  uint8_t const msg[] = {0x81, 0xA2, 0x00, 0x61, 0x63, 0x02, 0x01};
+
+  REQUIRE(fanout.add(mirror));
+  REQUIRE(fanout.add(log));
+  REQUIRE(fanout.size() == 2);
+  REQUIRE(fanout.all() == 0x03);
+
+  WHEN("no more sinks can be added")
+  {
+    TestSink spare;
+    THEN("the sink is refused")
+    {
+      REQUIRE_FALSE(fanout.add(spare));
+    }
+  }
+
+  WHEN("all sinks take the message")
+  {
+    MessageFanout::SinkMask const left = fanout.deliver(fanout.all(), msg, sizeof(msg), false);
+    THEN("none is left and each one got the same buffer")
+    {
+      REQUIRE(left == 0);
+      REQUIRE(mirror.delivered == 1);
+      REQUIRE(log.delivered == 1);
+      REQUIRE(mirror.last_data == msg);
+      REQUIRE(log.last_data == msg);
+    }
+  }
+
+  WHEN("a sink is busy")
+  {
+    log.is_busy = true;
+    MessageFanout::SinkMask left = fanout.deliver(fanout.all(), msg, sizeof(msg), false);
+    REQUIRE(left == 0x02);
+    REQUIRE(fanout.retries(1) == 1);
+
+    THEN("only that one is offered the message again")
+    {
+      log.is_busy = false;
+      left = fanout.deliver(left, msg, sizeof(msg), false);
+      REQUIRE(left == 0);
+      REQUIRE(mirror.delivered == 1);
+      REQUIRE(log.delivered == 1);
+      REQUIRE(fanout.retries(0) == 0);
+    }
+  }
+}
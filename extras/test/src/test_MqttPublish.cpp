@@ -0,0 +1,146 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <vector>
+
+#include <MqttPublish.h>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Encoding the header of a PUBLISH packet", "[mqtt_publish_header]")
+{
+  uint8_t buf[256];
+
+  WHEN("The packet is shorter than 128 bytes")
+  {
+    size_t const header_len = mqtt_publish_header(buf, sizeof(buf), "a/b", 4);
+    THEN("The remaining length takes a single byte")
+    {
+      std::vector<uint8_t> const expected = {0x30, 0x09, 0x00, 0x03, 'a', '/', 'b'};
+      REQUIRE(header_len == expected.size());
+      REQUIRE(std::vector<uint8_t>(buf, buf + header_len) == expected);
+    }
+  }
+  WHEN("The packet is 128 bytes or longer")
+  {
+    size_t const header_len = mqtt_publish_header(buf, sizeof(buf), "a/b", 200);
+    THEN("The remaining length takes two bytes")
+    {
+      /* 2 + 3 + 200 = 205 = 0x4D | 0x80, 0x01 */
+      std::vector<uint8_t> const expected = {0x30, 0xCD, 0x01, 0x00, 0x03, 'a', '/', 'b'};
+      REQUIRE(header_len == expected.size());
+      REQUIRE(std::vector<uint8_t>(buf, buf + header_len) == expected);
+    }
+  }
+  WHEN("Header and payload fill the buffer exactly")
+  {
+    THEN("The header is written")
+    {
+      REQUIRE(mqtt_publish_header(buf, 7 + 4, "a/b", 4) == 7);
+    }
+  }
+  WHEN("The payload does not fit behind the header")
+  {
+    THEN("Nothing is written")
+    {
+      REQUIRE(mqtt_publish_header(buf, 7 + 3, "a/b", 4) == 0);
+      REQUIRE(mqtt_publish_header(buf, 5, "a/b", 0) == 0);
+    }
+  }
+}
+
+SCENARIO("Encoding the header of an MQTT 5 PUBLISH packet", "[mqtt5_publish_header]")
+{
+  uint8_t buf[256];
+
+  WHEN("No alias is given")
+  {
+    size_t const header_len = mqtt5_publish_header(buf, sizeof(buf), "a/b", 0, 4);
+    THEN("The property section is empty")
+    {
+      std::vector<uint8_t> const expected = {0x30, 0x0A, 0x00, 0x03, 'a', '/', 'b', 0x00};
+      REQUIRE(header_len == expected.size());
+      REQUIRE(std::vector<uint8_t>(buf, buf + header_len) == expected);
+    }
+  }
+  WHEN("An alias is given along with the topic")
+  {
+    size_t const header_len = mqtt5_publish_header(buf, sizeof(buf), "a/b", 0x0102, 4);
+    THEN("It is sent as Topic Alias property")
+    {
+      std::vector<uint8_t> const expected = {0x30, 0x0D, 0x00, 0x03, 'a', '/', 'b', 0x03, 0x23, 0x01, 0x02};
+      REQUIRE(header_len == expected.size());
+      REQUIRE(std::vector<uint8_t>(buf, buf + header_len) == expected);
+    }
+  }
+  WHEN("An alias is given without the topic")
+  {
+    size_t const header_len = mqtt5_publish_header(buf, sizeof(buf), "", 1, 4);
+    THEN("The topic is empty")
+    {
+      std::vector<uint8_t> const expected = {0x30, 0x0A, 0x00, 0x00, 0x03, 0x23, 0x00, 0x01};
+      REQUIRE(header_len == expected.size());
+      REQUIRE(std::vector<uint8_t>(buf, buf + header_len) == expected);
+    }
+  }
+}
+
+SCENARIO("Publishing under topic aliases", "[MqttTopicAliases]")
+{
+  char const topic[] = "/a/t/a3b5c7d9-1e2f-4a6b-8c0d-2e4f6a8b0c1e/e/o";
+  size_t const topic_len = sizeof(topic) - 1;
+  uint8_t buf[256];
+  MqttTopicAliases aliases;
+
+  WHEN("The broker allows topic aliases")
+  {
+    aliases.reset(4);
+    size_t const first_len = aliases.header(buf, sizeof(buf), topic, 3, 20);
+    size_t const second_len = aliases.header(buf, sizeof(buf), topic, 3, 20);
+    THEN("The topic is only sent with the first message")
+    {
+      REQUIRE(first_len == 2 + 2 + topic_len + 4);
+      REQUIRE(second_len == 2 + 2 + 4);
+      std::vector<uint8_t> const expected = {0x30, 0x1A, 0x00, 0x00, 0x03, 0x23, 0x00, 0x03};
+      REQUIRE(std::vector<uint8_t>(buf, buf + second_len) == expected);
+    }
+    THEN("A reconnect establishes the alias again")
+    {
+      aliases.reset(4);
+      REQUIRE(aliases.header(buf, sizeof(buf), topic, 3, 20) == first_len);
+    }
+    THEN("A changed topic is established again once forgotten")
+    {
+      aliases.forget(3);
+      REQUIRE(aliases.header(buf, sizeof(buf), topic, 3, 20) == first_len);
+      REQUIRE(aliases.header(buf, sizeof(buf), topic, 3, 20) == second_len);
+    }
+  }
+  WHEN("The alias exceeds the maximum of the broker")
+  {
+    aliases.reset(2);
+    aliases.header(buf, sizeof(buf), topic, 3, 20);
+    THEN("The topic is sent in full without alias")
+    {
+      REQUIRE(aliases.header(buf, sizeof(buf), topic, 3, 20) == 2 + 2 + topic_len + 1);
+    }
+  }
+  WHEN("The broker does not allow topic aliases")
+  {
+    aliases.reset(0);
+    THEN("The topic is always sent in full")
+    {
+      REQUIRE(aliases.header(buf, sizeof(buf), topic, 1, 20) == 2 + 2 + topic_len + 1);
+      REQUIRE(aliases.header(buf, sizeof(buf), topic, 1, 20) == 2 + 2 + topic_len + 1);
+    }
+  }
+}
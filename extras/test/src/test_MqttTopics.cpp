@@ -0,0 +1,73 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string.h>
+
+#include <MqttTopics.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The topics are formatted into their slots", "[MqttTopics]")
+{
+  MqttTopics topics;
+  REQUIRE(topics.setDeviceId("5f4f0c1a-9bd4-4c8f-8d0e-6c7e5a1b2c3d"));
+
+  WHEN("No thing id is known yet")
+  {
+    THEN("Only the device topics are set")
+    {
+      REQUIRE(strcmp(topics.deviceOut(), "/a/d/5f4f0c1a-9bd4-4c8f-8d0e-6c7e5a1b2c3d/e/o") == 0);
+      REQUIRE(strcmp(topics.deviceIn(),  "/a/d/5f4f0c1a-9bd4-4c8f-8d0e-6c7e5a1b2c3d/e/i") == 0);
+      REQUIRE(strlen(topics.shadowOut()) == 0);
+      REQUIRE(strlen(topics.dataIn()) == 0);
+    }
+  }
+
+  WHEN("The thing id is set and changed")
+  {
+    REQUIRE(topics.setThingId("a3b5c7d9-1e2f-4a6b-8c0d-2e4f6a8b0c1e"));
+    char const * const data_out = topics.dataOut();
+    REQUIRE(topics.setThingId("00000000-1e2f-4a6b-8c0d-2e4f6a8b0c1e"));
+
+    THEN("The thing topics are replaced in place")
+    {
+      REQUIRE(topics.dataOut() == data_out);
+      REQUIRE(strcmp(topics.shadowOut(), "/a/t/00000000-1e2f-4a6b-8c0d-2e4f6a8b0c1e/shadow/o") == 0);
+      REQUIRE(strcmp(topics.shadowIn(),  "/a/t/00000000-1e2f-4a6b-8c0d-2e4f6a8b0c1e/shadow/i") == 0);
+      REQUIRE(strcmp(topics.dataOut(),   "/a/t/00000000-1e2f-4a6b-8c0d-2e4f6a8b0c1e/e/o") == 0);
+      REQUIRE(strcmp(topics.dataIn(),    "/a/t/00000000-1e2f-4a6b-8c0d-2e4f6a8b0c1e/e/i") == 0);
+    }
+
+    AND_WHEN("The thing id is cleared")
+    {
+      REQUIRE(topics.setThingId(""));
+
+      THEN("The thing topics are empty")
+      {
+        REQUIRE(strlen(topics.shadowIn()) == 0);
+        REQUIRE(strlen(topics.dataOut()) == 0);
+      }
+    }
+  }
+
+  WHEN("An id is longer than a slot")
+  {
+    String const too_long(String("a3b5c7d9-1e2f-4a6b-8c0d-2e4f6a8b0c1e") + "-0000");
+
+    THEN("It is refused and the topics are cleared")
+    {
+      REQUIRE_FALSE(topics.setThingId(too_long));
+      REQUIRE(strlen(topics.shadowOut()) == 0);
+      REQUIRE(strlen(topics.dataIn()) == 0);
+    }
+  }
+}
@@ -0,0 +1,92 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <utility/ota/OTAUrlSHA256.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+/* Decodes a device message which may write the hash, as handleMessage does */
+static void message(OTAUrlSHA256 & hash, String const & url, char const * sha256 = nullptr)
+{
+  String const before = hash.value();
+  if (sha256)
+    hash.value() = sha256;
+  hash.onMessage(before, url);
+}
+
+SCENARIO("Binding OTA_URL_SHA256 to the OTA_URL it was received with", "[OTAUrlSHA256]")
+{
+  OTAUrlSHA256 hash;
+  String const first  = "https://mirror.local/first.ota";
+  String const second = "http://mirror.local/second.ota";
+  char const * sha256 = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+
+  WHEN("No hash was received")
+  {
+    message(hash, first);
+    THEN("None is returned") {
+      REQUIRE(hash.get(first) == "");
+    }
+  }
+
+  WHEN("The hash is received along with the url")
+  {
+    message(hash, first, sha256);
+    THEN("It is returned for that url") {
+      REQUIRE(hash.get(first) == sha256);
+    }
+    THEN("It is not returned for another url") {
+      REQUIRE(hash.get(second) == "");
+    }
+  }
+
+  WHEN("A second url is received without a hash")
+  {
+    message(hash, first, sha256);
+    message(hash, second);
+    THEN("The second url does not inherit the hash of the first") {
+      REQUIRE(hash.get(second) == "");
+    }
+  }
+
+  WHEN("The hash is received in a message before the url")
+  {
+    message(hash, "", sha256);
+    message(hash, first);
+    THEN("It is not taken for the url") {
+      REQUIRE(hash.get(first) == "");
+    }
+  }
+
+  WHEN("The hash was consumed by the download")
+  {
+    message(hash, first, sha256);
+    hash.consume();
+    THEN("It is not returned for the same url again") {
+      REQUIRE(hash.get(first) == "");
+    }
+    THEN("A hash received afterwards is bound to its url") {
+      message(hash, second, sha256);
+      REQUIRE(hash.get(second) == sha256);
+      REQUIRE(hash.get(first) == "");
+    }
+  }
+
+  WHEN("A new hash is received with the same url")
+  {
+    message(hash, first, sha256);
+    message(hash, first, "fedcba9876543210fedcba9876543210fedcba9876543210fedcba9876543210");
+    THEN("The new hash is returned") {
+      REQUIRE(hash.get(first) == "fedcba9876543210fedcba9876543210fedcba9876543210fedcba9876543210");
+    }
+  }
+}
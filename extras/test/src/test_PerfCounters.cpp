@@ -0,0 +1,94 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <limits.h>
+
+#include <PerfCounters.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Performance counters are kept", "[PerfCounters]")
+{
+  WHEN("Nothing has happened yet")
+  {
+    PerfCounters perf;
+
+    THEN("The report contains only zeros")
+    {
+      REQUIRE(perf.toString() == "msg_tx=0;msg_rx=0;bytes_tx=0;bytes_rx=0;encode_us=0;decode_us=0;retransmits=0;reconnects=0;connect_ms=0;update_max_us=0;state_ms=0/0/0/0/0/0/0/0/0/0/0/0;c2d_ms=0/0/0;callback_us=0/0/0");
+    }
+  }
+
+  WHEN("Messages are sent and received")
+  {
+    PerfCounters perf;
+    perf.onEncode(120);
+    perf.onSend(64);
+    perf.onEncode(80);
+    perf.onSend(36);
+    perf.onReceive(10, 50);
+    perf.onRetransmit();
+    perf.onReconnect();
+    perf.onConnect(2500);
+
+    THEN("Messages and bytes are counted and the durations are summed up")
+    {
+      REQUIRE(perf.messagesSent() == 2);
+      REQUIRE(perf.bytesSent() == 100);
+      REQUIRE(perf.messagesReceived() == 1);
+      REQUIRE(perf.bytesReceived() == 10);
+      REQUIRE(perf.retransmits() == 1);
+      REQUIRE(perf.reconnects() == 1);
+      REQUIRE(perf.toString() == "msg_tx=2;msg_rx=1;bytes_tx=100;bytes_rx=10;encode_us=200;decode_us=50;retransmits=1;reconnects=1;connect_ms=2500;update_max_us=0;state_ms=0/0/0/0/0/0/0/0/0/0/0/0;c2d_ms=0/0/0;callback_us=0/0/0");
+    }
+  }
+
+  WHEN("update() runs through several states")
+  {
+    PerfCounters perf;
+    perf.onUpdate(0, 1000);
+    perf.onUpdateDone(300);
+    perf.onUpdate(0, 1100);
+    perf.onUpdateDone(900);
+    perf.onUpdate(2, 1500);
+    perf.onUpdateDone(100);
+    perf.onUpdate(9, 4500);
+
+    THEN("The time between updates is accounted to the state the previous one ended in")
+    {
+      REQUIRE(perf.stateMillis(0) == 500);
+      REQUIRE(perf.stateMillis(2) == 3000);
+      REQUIRE(perf.stateMillis(9) == 0);
+      REQUIRE(perf.stateMillis(PerfCounters::STATE_CNT) == 0);
+    }
+
+    THEN("The longest update() is kept")
+    {
+      REQUIRE(perf.updateMaxMicros() == 900);
+    }
+  }
+
+  WHEN("Commands are received from the cloud")
+  {
+    PerfCounters perf;
+    perf.onCommand(800, 40);
+    perf.onCommand(ULONG_MAX, 60);
+    perf.onCommand(1200, 20);
+
+    THEN("The latency percentiles are reported, a change without cloud timestamp only with its callback latency")
+    {
+      REQUIRE(perf.cloudToDeviceMillis().size() == 2);
+      REQUIRE(perf.callbackMicros().size() == 3);
+      REQUIRE(perf.toString() == "msg_tx=0;msg_rx=0;bytes_tx=0;bytes_rx=0;encode_us=0;decode_us=0;retransmits=0;reconnects=0;connect_ms=0;update_max_us=0;state_ms=0/0/0/0/0/0/0/0/0/0/0/0;c2d_ms=800/1200/1200;callback_us=40/60/60");
+    }
+  }
+}
@@ -0,0 +1,163 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string.h>
+
+#include <vector>
+
+#include <util/CBORTestUtil.h>
+#include <utility/storage/PropertyCache.h>
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+class RamStorage : public PropertyCacheStorage
+{
+public:
+  std::vector<uint8_t> record;
+  int write_cnt = 0;
+
+  virtual size_t read(uint8_t * buf, size_t const size) override
+  {
+    if (record.size() > size)
+      return 0;
+    if (!record.empty())
+      memcpy(buf, record.data(), record.size());
+    return record.size();
+  }
+  virtual bool write(uint8_t const * buf, size_t const length) override
+  {
+    record.assign(buf, buf + length);
+    write_cnt++;
+    return true;
+  }
+};
+
+static int on_update_cnt = 0;
+
+static void onUpdate()
+{
+  on_update_cnt++;
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The values of writeable properties are restored after a restart", "[PropertyCache]")
+{
+  RamStorage storage;
+
+  {
+    PropertyContainer property_container;
+    CloudBool  light = true;
+    CloudInt   level = 42;
+    CloudFloat temperature = 21.5f;
+    addPropertyToContainer(property_container, light, "light", Permission::ReadWrite);
+    addPropertyToContainer(property_container, level, "level", Permission::ReadWrite);
+    addPropertyToContainer(property_container, temperature, "temperature", Permission::Read);
+
+    PropertyCache cache;
+    cache.begin(storage);
+    REQUIRE_FALSE(cache.restore(property_container));
+    REQUIRE(cache.save(property_container));
+    REQUIRE(storage.write_cnt == 1);
+
+    THEN("the values are only stored again once they change")
+    {
+      REQUIRE_FALSE(cache.save(property_container));
+      level = 43;
+      REQUIRE(cache.save(property_container));
+      REQUIRE(storage.write_cnt == 2);
+    }
+
+    THEN("storing them leaves the properties to be sent to the cloud")
+    {
+      REQUIRE_FALSE(cbor::encode(property_container).empty());
+    }
+  }
+
+  WHEN("the properties are restored after the restart")
+  {
+    on_update_cnt = 0;
+    PropertyContainer property_container;
+    CloudBool  light = false;
+    CloudInt   level = 0;
+    CloudFloat temperature = 0.0f;
+    addPropertyToContainer(property_container, light, "light", Permission::ReadWrite).onUpdate(onUpdate);
+    addPropertyToContainer(property_container, level, "level", Permission::ReadWrite).onUpdate(onUpdate);
+    addPropertyToContainer(property_container, temperature, "temperature", Permission::Read);
+
+    PropertyCache cache;
+    cache.begin(storage);
+    REQUIRE(cache.restore(property_container));
+
+    THEN("the writeable ones resume their values and run their callbacks")
+    {
+      REQUIRE(light == true);
+      REQUIRE(level == 42);
+      REQUIRE(temperature == 0.0f);
+      REQUIRE(on_update_cnt == 2);
+    }
+
+    THEN("the restored values are neither echoed nor written back")
+    {
+      cbor::encode(property_container);
+      light = false;
+      light = true;
+      REQUIRE_FALSE(cache.save(property_container));
+      REQUIRE(storage.write_cnt == 1);
+    }
+  }
+
+  WHEN("the record is of another version")
+  {
+    PropertyContainer property_container;
+    CloudInt level = 0;
+    addPropertyToContainer(property_container, level, "level", Permission::ReadWrite);
+    PropertyCache cache;
+    cache.begin(storage);
+    REQUIRE(cache.save(property_container));
+    storage.record[2]++;
+    level = 7;
+
+    THEN("it is ignored")
+    {
+      REQUIRE_FALSE(cache.restore(property_container));
+      REQUIRE(level == 7);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("The property cache is written at most once per interval", "[PropertyCache]")
+{
+  RamStorage storage;
+  PropertyContainer property_container;
+  CloudInt level = 0;
+  addPropertyToContainer(property_container, level, "level", Permission::ReadWrite);
+  PropertyCache cache;
+  cache.begin(storage);
+
+  cache.poll(property_container, 30000, 30000);
+  REQUIRE(storage.write_cnt == 1);
+
+  for (unsigned long now = 30000; now < 60000; now += 1000)
+  {
+    level = static_cast<int>(now);
+    cache.poll(property_container, now, 30000);
+  }
+  REQUIRE(storage.write_cnt == 1);
+
+  cache.poll(property_container, 60000, 30000);
+  REQUIRE(storage.write_cnt == 2);
+}
@@ -0,0 +1,168 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+
+#include <PropertyContainer.h>
+#include <CBOREncoder.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Only the properties pushed are sent again", "[PropertyGroup]")
+{
+  PropertyContainer property_container;
+
+  CloudInt temperature = 21;
+  CloudInt humidity    = 40;
+  CloudInt pressure    = 1013;
+  CloudInt outside     = 0;
+
+  PropertyGroup climate;
+  REQUIRE(climate.add(addPropertyToContainer(property_container, temperature, "temperature", Permission::Read)));
+  REQUIRE(climate.add(addPropertyToContainer(property_container, humidity, "humidity", Permission::Read)));
+  addPropertyToContainer(property_container, pressure, "pressure", Permission::Read);
+
+  /* All properties are sent once initially */
+  REQUIRE(cbor::encode(property_container).size() != 0);
+  REQUIRE(cbor::encode(property_container).size() == 0);
+
+  WHEN("A single property is pushed")
+  {
+    REQUIRE(requestUpdateForProperty(property_container, &pressure));
+
+    THEN("Just that one is encoded")
+    {
+      /* [{0: "pressure", 2: 1013}] = 9F A2 00 68 70 72 65 73 73 75 72 65 02 19 03 F5 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x68, 0x70, 0x72, 0x65, 0x73, 0x73, 0x75, 0x72, 0x65, 0x02, 0x19, 0x03, 0xF5, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+    }
+  }
+
+  WHEN("The group is pushed")
+  {
+    REQUIRE(requestUpdateForGroup(property_container, climate));
+
+    THEN("The properties of the group are encoded and no other")
+    {
+      /* [{0: "temperature", 2: 21}, {0: "humidity", 2: 40}] = 9F A2 00 6B 74 65 6D 70 65 72 61 74 75 72 65 02 15 A2 00 68 68 75 6D 69 64 69 74 79 02 18 28 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x6B, 0x74, 0x65, 0x6D, 0x70, 0x65, 0x72, 0x61, 0x74, 0x75, 0x72, 0x65, 0x02, 0x15,
+                                                   0xA2, 0x00, 0x68, 0x68, 0x75, 0x6D, 0x69, 0x64, 0x69, 0x74, 0x79, 0x02, 0x18, 0x28, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+    }
+  }
+
+  WHEN("A property is not in the container")
+  {
+    THEN("It is refused")
+    {
+      REQUIRE_FALSE(requestUpdateForProperty(property_container, &outside));
+      REQUIRE_FALSE(requestUpdateForProperty(property_container, nullptr));
+      REQUIRE(climate.add(outside));
+      REQUIRE_FALSE(requestUpdateForGroup(property_container, climate));
+      /* The others of the group are sent nevertheless */
+      REQUIRE(cbor::encode(property_container).size() != 0);
+    }
+  }
+
+  WHEN("Properties are added to a group")
+  {
+    THEN("Each is only added once and a full group refuses more")
+    {
+      PropertyGroup group;
+      REQUIRE(group.add(temperature));
+      REQUIRE(group.add(temperature));
+      REQUIRE(group.size() == 1);
+      CloudInt others[PropertyGroup::CAPACITY];
+      for (size_t i = 0; i < PropertyGroup::CAPACITY - 1; i++)
+        REQUIRE(group.add(others[i]));
+      REQUIRE_FALSE(group.add(others[PropertyGroup::CAPACITY - 1]));
+    }
+  }
+}
+
+SCENARIO("The members of a named group share its name as SenML base name", "[PropertyGroup]")
+{
+  PropertyContainer property_container;
+
+  CloudInt  speed   = 3;
+  CloudBool running = true;
+  CloudInt  level   = 5;
+
+  PropertyGroup pump("pump1_");
+  pump.add(addPropertyToContainer(property_container, speed, "pump1_speed", Permission::Read));
+  pump.add(addPropertyToContainer(property_container, running, "pump1_on", Permission::Read));
+  pump.add(addPropertyToContainer(property_container, level, "level", Permission::Read));
+
+  uint8_t buf[64] = {0};
+  int bytes_encoded = 0;
+  unsigned int current_property_index = 0;
+  REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index, false, 0, true) == CborNoError);
+
+  THEN("The names starting with the group name are encoded relative to it")
+  {
+    /* [{-2: "pump1_", 0: "speed", 2: 3}, {0: "on", 4: true}, {-2: "", 0: "level", 2: 5}]
+     * = 9F A3 21 66 70 75 6D 70 31 5F 00 65 73 70 65 65 64 02 03 A2 00 62 6F 6E 04 F5 A3 21 60 00 65 6C 65 76 65 6C 02 05 FF
+     */
+    std::vector<uint8_t> const expected = {0x9F, 0xA3, 0x21, 0x66, 0x70, 0x75, 0x6D, 0x70, 0x31, 0x5F, 0x00, 0x65, 0x73, 0x70, 0x65, 0x65, 0x64, 0x02, 0x03,
+                                                 0xA2, 0x00, 0x62, 0x6F, 0x6E, 0x04, 0xF5,
+                                                 0xA3, 0x21, 0x60, 0x00, 0x65, 0x6C, 0x65, 0x76, 0x65, 0x6C, 0x02, 0x05, 0xFF};
+    REQUIRE(std::vector<uint8_t>(buf, buf + bytes_encoded) == expected);
+  }
+}
+
+SCENARIO("The rate limit of a group is shared by its members", "[PropertyGroup]")
+{
+  PropertyContainer property_container;
+
+  CloudInt speed    = 3;
+  CloudInt pressure = 1;
+  CloudInt level    = 5;
+
+  PropertyGroup pump("pump1_");
+  pump.publishOnChange(1000);
+  pump.add(addPropertyToContainer(property_container, speed, "pump1_speed", Permission::Read));
+  pump.add(addPropertyToContainer(property_container, pressure, "pump1_pressure", Permission::Read));
+  addPropertyToContainer(property_container, level, "level", Permission::Read);
+
+  set_millis(0);
+  REQUIRE(cbor::encode(property_container).size() != 0);
+
+  WHEN("Members change within the window of the group")
+  {
+    /* Past the default rate limit of the properties themselves */
+    set_millis(600);
+    speed = 4;
+    level = 6;
+
+    THEN("They are held back while the other properties are sent")
+    {
+      /* [{0: "level", 2: 6}] = 9F A2 00 65 6C 65 76 65 6C 02 06 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x65, 0x6C, 0x65, 0x76, 0x65, 0x6C, 0x02, 0x06, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+      REQUIRE(millisUntilNextUpdate(property_container, millis()) == 400);
+
+      set_millis(1000);
+      pressure = 2;
+
+      AND_THEN("Once it closed all changed members are sent by the same message")
+      {
+        /* [{0: "pump1_speed", 2: 4}, {0: "pump1_pressure", 2: 2}]
+         * = 9F A2 00 6B 70 75 6D 70 31 5F 73 70 65 65 64 02 04 A2 00 6E 70 75 6D 70 31 5F 70 72 65 73 73 75 72 65 02 02 FF
+         */
+        std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x6B, 0x70, 0x75, 0x6D, 0x70, 0x31, 0x5F, 0x73, 0x70, 0x65, 0x65, 0x64, 0x02, 0x04,
+                                                     0xA2, 0x00, 0x6E, 0x70, 0x75, 0x6D, 0x70, 0x31, 0x5F, 0x70, 0x72, 0x65, 0x73, 0x73, 0x75, 0x72, 0x65, 0x02, 0x02, 0xFF};
+        REQUIRE(cbor::encode(property_container) == expected);
+        REQUIRE(cbor::encode(property_container).size() == 0);
+      }
+    }
+  }
+}
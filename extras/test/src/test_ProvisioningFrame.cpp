@@ -0,0 +1,129 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include <utility/provisioning/ProvisioningFrame.h>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+static ProvisioningFrame::Status feed(ProvisioningFrame & frame, std::vector<uint8_t> const & data)
+{
+  ProvisioningFrame::Status status = ProvisioningFrame::Status::Incomplete;
+  for (uint8_t const c : data)
+    status = frame.feed(c);
+  return status;
+}
+
+static std::vector<uint8_t> encodeBegin(std::string const & device_id)
+{
+  uint8_t payload[64];
+  size_t len = 0;
+  REQUIRE(ProvisioningFrame::appendField(payload, sizeof(payload), len, ProvisioningField::DeviceId, reinterpret_cast<uint8_t const *>(device_id.data()), device_id.size()));
+
+  uint8_t out[ProvisioningFrame::MAX_FRAME_SIZE];
+  size_t const size = ProvisioningFrame::encode(ProvisioningFrameType::Begin, payload, len, out, sizeof(out));
+  REQUIRE(size == ProvisioningFrame::HEADER_SIZE + ProvisioningFrame::FIELD_HEADER_SIZE + device_id.size() + ProvisioningFrame::CRC_SIZE);
+  return std::vector<uint8_t>(out, out + size);
+}
+
+SCENARIO("Batch provisioning frames", "[ProvisioningFrame]")
+{
+  ProvisioningFrame frame;
+  std::string const device_id = "a1b2c3d4-e5f6-4a5b-8c9d-0e1f2a3b4c5d";
+
+  WHEN("An encoded frame is received")
+  {
+    REQUIRE(feed(frame, encodeBegin(device_id)) == ProvisioningFrame::Status::Complete);
+    THEN("Its type and fields are found")
+    {
+      REQUIRE(frame.type() == ProvisioningFrameType::Begin);
+      uint8_t const * value = nullptr;
+      size_t len = 0;
+      REQUIRE(frame.field(ProvisioningField::DeviceId, value, len));
+      REQUIRE(std::string(reinterpret_cast<char const *>(value), len) == device_id);
+      REQUIRE_FALSE(frame.field(ProvisioningField::Signature, value, len));
+    }
+  }
+
+  WHEN("A frame is encoded")
+  {
+    THEN("It matches the one built by extras/tools/provision.py")
+    {
+      std::vector<uint8_t> const expected = {0xA5, 0x01, 0x06, 0x00, 0x01, 0x03, 0x00, 'a', 'b', 'c', 0xCF, 0x38, 0x84, 0x71};
+      REQUIRE(encodeBegin("abc") == expected);
+    }
+  }
+
+  WHEN("Noise precedes the frame")
+  {
+    std::vector<uint8_t> data = {0x00, 0x13, 0x37};
+    std::vector<uint8_t> const begin = encodeBegin(device_id);
+    data.insert(data.end(), begin.begin(), begin.end());
+    THEN("It is skipped")
+    {
+      REQUIRE(feed(frame, data) == ProvisioningFrame::Status::Complete);
+      REQUIRE(frame.length() == ProvisioningFrame::FIELD_HEADER_SIZE + device_id.size());
+    }
+  }
+
+  WHEN("A byte of the frame is corrupted")
+  {
+    std::vector<uint8_t> data = encodeBegin(device_id);
+    data[ProvisioningFrame::HEADER_SIZE + 5] ^= 0x01;
+    THEN("The CRC does not match and the next frame is received again")
+    {
+      REQUIRE(feed(frame, data) == ProvisioningFrame::Status::Error);
+      REQUIRE(feed(frame, encodeBegin(device_id)) == ProvisioningFrame::Status::Complete);
+    }
+  }
+
+  WHEN("The announced payload is too long")
+  {
+    std::vector<uint8_t> const data = {ProvisioningFrame::START, static_cast<uint8_t>(ProvisioningFrameType::Cert), 0xFF, 0xFF};
+    THEN("The frame is dropped right away")
+    {
+      REQUIRE(feed(frame, data) == ProvisioningFrame::Status::Error);
+    }
+  }
+
+  WHEN("A field is longer than 255 bytes")
+  {
+    std::vector<uint8_t> const csr(300, 0x30);
+    uint8_t payload[ProvisioningFrame::MAX_PAYLOAD_SIZE];
+    size_t len = 0;
+    REQUIRE(ProvisioningFrame::appendField(payload, sizeof(payload), len, ProvisioningField::Csr, csr.data(), csr.size()));
+    uint8_t out[ProvisioningFrame::MAX_FRAME_SIZE];
+    size_t const size = ProvisioningFrame::encode(ProvisioningFrameType::Csr, payload, len, out, sizeof(out));
+    THEN("Its length is kept")
+    {
+      REQUIRE(feed(frame, std::vector<uint8_t>(out, out + size)) == ProvisioningFrame::Status::Complete);
+      uint8_t const * value = nullptr;
+      size_t value_len = 0;
+      REQUIRE(frame.field(ProvisioningField::Csr, value, value_len));
+      REQUIRE(value_len == csr.size());
+    }
+  }
+
+  WHEN("A field does not fit the payload")
+  {
+    uint8_t payload[8];
+    size_t len = 0;
+    uint8_t const value[8] = {0};
+    THEN("It is not appended")
+    {
+      REQUIRE_FALSE(ProvisioningFrame::appendField(payload, sizeof(payload), len, ProvisioningField::Nonce, value, sizeof(value)));
+      REQUIRE(len == 0);
+    }
+  }
+}
@@ -0,0 +1,102 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <utility/net/PublishRateControl.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static RateControlLimits const LIMITS = {500, 1000, 8000, -90, 5000};
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The thing updates are held while the link is bad", "[PublishRateControl]")
+{
+  PublishRateControl rate_control;
+  rate_control.begin(LIMITS);
+  rate_control.onPublish(1000);
+
+  WHEN("The writes are fast")
+  {
+    rate_control.onWrite(20);
+
+    THEN("Nothing is held")
+    {
+      REQUIRE(rate_control.hold() == 0);
+      REQUIRE(rate_control.isDue(1000));
+    }
+  }
+
+  WHEN("A write is slow")
+  {
+    rate_control.onWrite(2000);
+
+    THEN("The updates are held for the shortest hold time")
+    {
+      REQUIRE(rate_control.hold() == 1000);
+      REQUIRE_FALSE(rate_control.isDue(1999));
+      REQUIRE(rate_control.nextDueIn(1500) == 500);
+      REQUIRE(rate_control.isDue(2000));
+    }
+
+    AND_WHEN("Writes keep failing and messages are sent again")
+    {
+      for (int i = 0; i < 5; i++)
+        rate_control.onWriteFailed();
+      rate_control.onRetransmit();
+
+      THEN("The hold time doubles up to the longest one")
+      {
+        REQUIRE(rate_control.hold() == 8000);
+      }
+
+      AND_WHEN("The writes are fast again")
+      {
+        for (int i = 0; i < 4; i++)
+          rate_control.onWrite(20);
+
+        THEN("The hold time halves with each of them until nothing is held")
+        {
+          REQUIRE(rate_control.hold() == 0);
+        }
+      }
+    }
+  }
+
+  WHEN("The writes have been slow for a while")
+  {
+    for (int i = 0; i < 20; i++)
+      rate_control.onWrite(1000);
+    rate_control.onWrite(20);
+
+    THEN("A single fast write is not taken for a recovered link")
+    {
+      REQUIRE(rate_control.writeTime() > LIMITS.slow_write_ms);
+      REQUIRE(rate_control.hold() == 8000);
+    }
+  }
+
+  WHEN("The signal is weak")
+  {
+    rate_control.onSignalStrength(-95);
+
+    THEN("The weak signal hold time is kept until it is strong again")
+    {
+      REQUIRE(rate_control.hold() == 5000);
+      rate_control.onWrite(20);
+      REQUIRE(rate_control.hold() == 5000);
+      rate_control.onSignalStrength(-60);
+      REQUIRE(rate_control.hold() == 0);
+    }
+  }
+}
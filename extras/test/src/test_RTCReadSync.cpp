@@ -0,0 +1,49 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <RTCReadSync.h>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Converting the calendar registers of an RTC", "[RTCReadSync::calendarToEpoch]")
+{
+  REQUIRE(RTCReadSync::calendarToEpoch(1970,  1,  1,  0,  0,  0) == 0UL);
+  REQUIRE(RTCReadSync::calendarToEpoch(2000,  1,  1,  0,  0,  0) == 946684800UL);
+  REQUIRE(RTCReadSync::calendarToEpoch(2000,  2, 29, 12,  0,  0) == 951825600UL);
+  REQUIRE(RTCReadSync::calendarToEpoch(2000,  3,  1,  0,  0,  0) == 951868800UL);
+  REQUIRE(RTCReadSync::calendarToEpoch(2019,  2, 14, 10,  6, 50) == 1550138810UL);
+  REQUIRE(RTCReadSync::calendarToEpoch(2024, 12, 31, 23, 59, 59) == 1735689599UL);
+  REQUIRE(RTCReadSync::calendarToEpoch(2063, 12, 31, 23, 59, 59) == 2966371199UL);
+}
+
+SCENARIO("Reading an RTC in continuous read synchronization mode", "[RTCReadSync::take]")
+{
+  RTCReadSync read_sync;
+  read_sync.restart(1000);
+
+  WHEN("The RTC is read again after less than a second")
+  {
+    THEN("The synchronized value is taken as is")
+    {
+      REQUIRE(read_sync.take(1550138810, 1999) == 1550138810);
+    }
+  }
+
+  WHEN("The previous read is long ago")
+  {
+    THEN("The value is advanced by the whole seconds elapsed since then")
+    {
+      REQUIRE(read_sync.take(1550138810, 61500) == 1550138870);
+      REQUIRE(read_sync.take(1550138870, 62500) == 1550138871);
+    }
+  }
+}
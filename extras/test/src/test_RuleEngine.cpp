@@ -0,0 +1,224 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include <CBORDecoder.h>
+#include <utility/rules/RuleEngine.h>
+#include "types/CloudWrapperInt.h"
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+static std::vector<uint8_t> program(std::vector<std::string> const & names, std::vector<std::vector<uint8_t>> const & rules)
+{
+  std::vector<uint8_t> buf = {'R', RuleEngine::VERSION, static_cast<uint8_t>(names.size())};
+  for (std::string const & name : names)
+  {
+    buf.push_back(static_cast<uint8_t>(name.size()));
+    buf.insert(buf.end(), name.begin(), name.end());
+  }
+  for (std::vector<uint8_t> const & rule : rules)
+  {
+    buf.push_back(static_cast<uint8_t>(rule.size()));
+    buf.insert(buf.end(), rule.begin(), rule.end());
+  }
+  return buf;
+}
+
+/* fan = temperature > 30 */
+static std::vector<uint8_t> const FAN_RULE = {0x01, 0x00, 0x02, 0x00, 0x00, 0xF0, 0x41, 0x10, 0x40, 0x01};
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Rules are evaluated as the properties they read change", "[RuleEngine]")
+{
+  PropertyContainer property_container;
+  CloudFloat temperature = 20.0f;
+  CloudBool  fan = false;
+  CloudInt   level = 0;
+  addPropertyToContainer(property_container, temperature, "temperature", Permission::ReadWrite);
+  addPropertyToContainer(property_container, fan, "fan", Permission::ReadWrite);
+  addPropertyToContainer(property_container, level, "level", Permission::ReadWrite);
+
+  std::vector<uint8_t> const rules = program({"temperature", "fan"}, {FAN_RULE});
+  RuleEngine engine;
+  REQUIRE(engine.load(property_container, rules.data(), rules.size()) == RuleEngine::Error::None);
+
+  WHEN("the program has been loaded")
+  {
+    THEN("each rule runs once")
+    {
+      REQUIRE(engine.evaluate() == 1);
+      REQUIRE_FALSE(fan);
+      REQUIRE(engine.evaluate() == 0);
+    }
+  }
+
+  WHEN("the sketch changes a property read by a rule")
+  {
+    engine.evaluate();
+    temperature = 35.0f;
+    THEN("the rule runs and writes the property")
+    {
+      REQUIRE(engine.evaluate() == 1);
+      REQUIRE(fan);
+    }
+  }
+
+  WHEN("a property not read by any rule changes")
+  {
+    engine.evaluate();
+    level = 3;
+    fan = true;
+    THEN("no rule runs")
+    {
+      REQUIRE(engine.evaluate() == 0);
+      REQUIRE(fan);
+    }
+  }
+
+  WHEN("the cloud writes a property read by a rule")
+  {
+    engine.evaluate();
+    /* [{0: "temperature", 2: 40}] = 81 A2 00 6B 74 65 6D 70 65 72 61 74 75 72 65 02 18 28 */
+    uint8_t const payload[] = {0x81, 0xA2, 0x00, 0x6B, 0x74, 0x65, 0x6D, 0x70, 0x65, 0x72, 0x61, 0x74, 0x75, 0x72, 0x65, 0x02, 0x18, 0x28};
+    CBORDecoder::decode(property_container, payload, sizeof(payload));
+    THEN("the rule runs on the received value")
+    {
+      REQUIRE(temperature == 40.0f);
+      REQUIRE(engine.evaluate() == 1);
+      REQUIRE(fan);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("Rules read wrapped primitives and branch", "[RuleEngine]")
+{
+  PropertyContainer property_container;
+  int     count = 0;
+  CloudInt level = 0;
+  CloudWrapperInt count_property(count);
+  addPropertyToContainer(property_container, count_property, "count", Permission::ReadWrite);
+  addPropertyToContainer(property_container, level, "level", Permission::ReadWrite);
+
+  /* if (count >= 2) level = count * 10 */
+  std::vector<uint8_t> const rule = {0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x40, 0x12, 0x30, 0x0A,
+                                     0x01, 0x00, 0x02, 0x00, 0x00, 0x20, 0x41, 0x22, 0x40, 0x01};
+  std::vector<uint8_t> const rules = program({"count", "level"}, {rule});
+  RuleEngine engine;
+  REQUIRE(engine.load(property_container, rules.data(), rules.size()) == RuleEngine::Error::None);
+  engine.evaluate();
+
+  WHEN("the wrapped variable stays below the threshold")
+  {
+    count = 1;
+    THEN("the change is noticed but the branch is skipped")
+    {
+      REQUIRE(engine.evaluate() == 1);
+      REQUIRE(level == 0);
+    }
+  }
+
+  WHEN("the wrapped variable reaches the threshold")
+  {
+    count = 3;
+    THEN("the property is written")
+    {
+      REQUIRE(engine.evaluate() == 1);
+      REQUIRE(level == 30);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("Malformed rule programs are refused", "[RuleEngine]")
+{
+  PropertyContainer property_container;
+  CloudFloat temperature = 20.0f;
+  CloudBool  fan = false;
+  CloudString name;
+  addPropertyToContainer(property_container, temperature, "temperature", Permission::ReadWrite);
+  addPropertyToContainer(property_container, fan, "fan", Permission::ReadWrite);
+  addPropertyToContainer(property_container, name, "name", Permission::ReadWrite);
+  RuleEngine engine;
+
+  auto load = [&](std::vector<uint8_t> const & buf) {
+    RuleEngine::Error const err = engine.load(property_container, buf.data(), buf.size());
+    REQUIRE_FALSE(engine.isLoaded());
+    return err;
+  };
+
+  WHEN("the header is wrong")
+  {
+    std::vector<uint8_t> buf = program({"temperature", "fan"}, {FAN_RULE});
+    buf[1] = RuleEngine::VERSION + 1;
+    REQUIRE(load(buf) == RuleEngine::Error::Version);
+    REQUIRE(load({'X', RuleEngine::VERSION, 0}) == RuleEngine::Error::Format);
+  }
+
+  WHEN("a property is unknown or not a number")
+  {
+    REQUIRE(load(program({"temperature", "pump"}, {FAN_RULE})) == RuleEngine::Error::UnknownProperty);
+    REQUIRE(load(program({"temperature", "name"}, {FAN_RULE})) == RuleEngine::Error::UnsupportedType);
+  }
+
+  WHEN("an instruction is invalid")
+  {
+    REQUIRE(load(program({"temperature", "fan"}, {{0x01, 0x02}})) == RuleEngine::Error::InvalidInstruction);
+    REQUIRE(load(program({"temperature", "fan"}, {{0x02, 0x00, 0x00}})) == RuleEngine::Error::InvalidInstruction);
+    REQUIRE(load(program({"temperature", "fan"}, {{0x01, 0x00, 0x30, 0x05}})) == RuleEngine::Error::InvalidInstruction);
+    REQUIRE(load(program({"temperature", "fan"}, {{0x01, 0x00, 0x30, 0x01, 0x40, 0x01}})) == RuleEngine::Error::InvalidInstruction);
+    REQUIRE(load(program({"temperature", "fan"}, {{0x7F}})) == RuleEngine::Error::InvalidInstruction);
+  }
+
+  WHEN("a rule is truncated")
+  {
+    std::vector<uint8_t> buf = program({"temperature", "fan"}, {FAN_RULE});
+    buf.pop_back();
+    REQUIRE(load(buf) == RuleEngine::Error::Format);
+  }
+
+  WHEN("there are more rules than supported")
+  {
+    std::vector<std::vector<uint8_t>> const rules(RuleEngine::MAX_RULES + 1, FAN_RULE);
+    REQUIRE(load(program({"temperature", "fan"}, rules)) == RuleEngine::Error::TooManyRules);
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("A rule exceeding the stack is aborted", "[RuleEngine]")
+{
+  PropertyContainer property_container;
+  CloudFloat temperature = 20.0f;
+  addPropertyToContainer(property_container, temperature, "temperature", Permission::ReadWrite);
+
+  std::vector<uint8_t> rule;
+  for (size_t i = 0; i <= RuleEngine::STACK_DEPTH; i++)
+    rule.insert(rule.end(), {0x01, 0x00});
+  rule.insert(rule.end(), {0x40, 0x00});
+  std::vector<uint8_t> const rules = program({"temperature"}, {rule, {0x40, 0x00}});
+  RuleEngine engine;
+  REQUIRE(engine.load(property_container, rules.data(), rules.size()) == RuleEngine::Error::None);
+
+  THEN("the property is left unchanged")
+  {
+    REQUIRE(engine.evaluate() == 2);
+    REQUIRE(temperature == 20.0f);
+  }
+}
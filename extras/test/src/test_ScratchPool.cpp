@@ -0,0 +1,138 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/AllocationTestUtil.h>
+#include <util/CBORTestUtil.h>
+
+#include <CBORDecoder.h>
+#include <property/types/CloudInt.h>
+#include <utility/memory/ScratchPool.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Scratch buffers are leased from a shared pool", "[ScratchPool]")
+{
+  WHEN("A buffer which fits is leased")
+  {
+    ScratchLease lease(ScratchPool::SIZE);
+
+    THEN("It is taken from the pool until it is released")
+    {
+      REQUIRE(lease);
+      REQUIRE(lease.isPooled());
+      REQUIRE(lease.size() == ScratchPool::SIZE);
+      REQUIRE(ScratchPool::isLeased());
+      REQUIRE(ScratchPool::highWater() >= ScratchPool::SIZE);
+      lease.release();
+      REQUIRE(!lease);
+      REQUIRE(!ScratchPool::isLeased());
+    }
+
+    THEN("Another lease without a fallback fails meanwhile")
+    {
+      ScratchLease const other(1);
+      REQUIRE(!other);
+      REQUIRE(other.size() == 0);
+    }
+
+    THEN("Another lease with a fallback is allocated from it meanwhile")
+    {
+      ScratchLease const other(1, MemoryPool::Scratch);
+      REQUIRE(other);
+      REQUIRE(!other.isPooled());
+    }
+  }
+
+  WHEN("A buffer larger than the pool is leased")
+  {
+    AllocationCounter counter;
+    ScratchLease lease(ScratchPool::SIZE + 1, MemoryPool::Scratch);
+    size_t const allocation_cnt = counter.count();
+
+    THEN("It is allocated from the fallback pool and the pool is left free")
+    {
+      REQUIRE(lease);
+      REQUIRE(!lease.isPooled());
+      REQUIRE(allocation_cnt == 1);
+      REQUIRE(!ScratchPool::isLeased());
+      REQUIRE(ScratchPool::highWater() > ScratchPool::SIZE);
+    }
+  }
+
+  WHEN("A lease is acquired once more")
+  {
+    ScratchLease lease(ScratchPool::SIZE + 1, MemoryPool::Scratch);
+    AllocationCounter counter;
+    bool const is_acquired = lease.acquire(1);
+    size_t const live_bytes = counter.liveBytes();
+
+    THEN("The buffer held before is released")
+    {
+      REQUIRE(is_acquired);
+      REQUIRE(lease.isPooled());
+      REQUIRE(live_bytes == 0);
+    }
+  }
+}
+
+SCENARIO("The decoder leases its buffer from the scratch pool", "[ScratchPool]")
+{
+  PropertyContainer property_container;
+  CloudInt value = 0;
+  addPropertyToContainer(property_container, value, "test", Permission::ReadWrite);
+
+  /* [{0: "test", 2: 7}] = 81 A2 00 64 74 65 73 74 02 07 */
+  uint8_t const payload[] = {0x81, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x07};
+
+  WHEN("A message is received in chunks")
+  {
+    bool is_leased_before = true, is_leased_while = false, is_complete = false;
+    size_t available = 0;
+    AllocationCounter counter;
+    {
+      CBORDecoder decoder(property_container);
+      is_leased_before = ScratchPool::isLeased();
+      uint8_t * buf = decoder.writeBuffer(available);
+      is_leased_while = ScratchPool::isLeased();
+      memcpy(buf, payload, sizeof(payload));
+      is_complete = decoder.commit(sizeof(payload)) && decoder.isComplete();
+    }
+    size_t const allocation_cnt = counter.count();
+
+    THEN("The pool is leased once data is received until the decoder is gone, nothing is allocated")
+    {
+      REQUIRE(!is_leased_before);
+      REQUIRE(is_leased_while);
+      REQUIRE(available >= sizeof(payload));
+      REQUIRE(is_complete);
+      REQUIRE(!ScratchPool::isLeased());
+      REQUIRE(allocation_cnt == 0);
+      REQUIRE(value == 7);
+    }
+  }
+
+  WHEN("A message is received while the pool is leased")
+  {
+    ScratchLease const lease(1);
+    CBORDecoder decoder(property_container);
+    size_t available = 0;
+    uint8_t * buf = decoder.writeBuffer(available);
+    memcpy(buf, payload, sizeof(payload));
+
+    THEN("It is decoded all the same")
+    {
+      REQUIRE(decoder.commit(sizeof(payload)));
+      REQUIRE(decoder.isComplete());
+      REQUIRE(value == 7);
+    }
+  }
+}
@@ -0,0 +1,97 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <SeqLock.h>
+
+#include <thread>
+
+/**************************************************************************************
+   TYPEDEF
+ **************************************************************************************/
+
+struct Sample
+{
+  uint32_t seq;
+  float    value;
+  uint32_t seq_copy;
+};
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Sharing a value via a sequence lock", "[SeqLock]")
+{
+  WHEN("The lock has just been constructed")
+  {
+    SeqLock<float> lock(1.5f);
+    float value = 0.0f;
+    lock.read(value);
+
+    THEN("The initial value is read")
+    {
+      REQUIRE(value == 1.5f);
+    }
+  }
+  WHEN("A value which is not a multiple of 32 bit is written")
+  {
+    SeqLock<bool> lock(false);
+    lock.write(true);
+    bool value = false;
+    lock.read(value);
+
+    THEN("The written value is read")
+    {
+      REQUIRE(value == true);
+    }
+  }
+  WHEN("A lock is copied")
+  {
+    SeqLock<Sample> lock(Sample{1, 2.0f, 1});
+    SeqLock<Sample> copy(lock);
+    Sample value{0, 0.0f, 0};
+    copy.read(value);
+
+    THEN("The copy holds the value of the original")
+    {
+      REQUIRE(value.seq == 1);
+      REQUIRE(value.value == 2.0f);
+      REQUIRE(value.seq_copy == 1);
+    }
+  }
+  WHEN("A reader runs concurrently to the writer")
+  {
+    uint32_t const WRITE_CNT = 100000;
+    SeqLock<Sample> lock(Sample{0, 0.0f, 0});
+
+    std::thread writer([&lock]()
+    {
+      for (uint32_t i = 1; i <= WRITE_CNT; i++)
+        lock.write(Sample{i, static_cast<float>(i), i});
+    });
+
+    bool is_torn = false;
+    uint32_t last_seq = 0;
+    while (last_seq < WRITE_CNT)
+    {
+      Sample value{0, 0.0f, 0};
+      lock.read(value);
+      if ((value.seq != value.seq_copy) || (value.value != static_cast<float>(value.seq)) || (value.seq < last_seq))
+        is_torn = true;
+      last_seq = value.seq;
+    }
+    writer.join();
+
+    THEN("It never reads a partially written value")
+    {
+      REQUIRE(is_torn == false);
+    }
+  }
+}
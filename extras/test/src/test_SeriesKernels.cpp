@@ -0,0 +1,128 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <math.h>
+#include <string.h>
+
+#include <SeriesKernels.h>
+
+/**************************************************************************************
+   HELPER
+ **************************************************************************************/
+
+static float from_bits(uint32_t const bits)
+{
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The samples of a series are aggregated", "[SeriesKernels]")
+{
+  WHEN("The float samples do not fill the last block of four")
+  {
+    float const sample[] = {3.0f, -1.5f, 8.0f, 2.0f, 0.5f, -4.0f, 7.0f};
+    SeriesStats const stats = series_stats(sample, sizeof(sample) / sizeof(sample[0]));
+
+    THEN("All of them are taken into account")
+    {
+      REQUIRE(stats.min == -4.0f);
+      REQUIRE(stats.max == 8.0f);
+      REQUIRE(stats.mean == Approx(15.0f / 7.0f));
+    }
+  }
+
+  WHEN("There is a single float sample")
+  {
+    float const sample = 2.5f;
+    SeriesStats const stats = series_stats(&sample, 1);
+
+    THEN("It is the min, the max and the mean")
+    {
+      REQUIRE(stats.min == 2.5f);
+      REQUIRE(stats.max == 2.5f);
+      REQUIRE(stats.mean == 2.5f);
+    }
+  }
+
+  WHEN("The samples are integers")
+  {
+    int const sample[] = {10, -20, 40};
+    SeriesStats const stats = series_stats(sample, 3);
+
+    THEN("They are aggregated by the portable loop")
+    {
+      REQUIRE(stats.min == -20.0f);
+      REQUIRE(stats.max == 40.0f);
+      REQUIRE(stats.mean == 10.0f);
+    }
+  }
+}
+
+SCENARIO("Floats are converted to half precision", "[SeriesKernels]")
+{
+  WHEN("The value is exact in half precision")
+  {
+    THEN("It is converted as it is")
+    {
+      REQUIRE(float_to_half(0.0f) == 0x0000);
+      REQUIRE(float_to_half(-0.0f) == 0x8000);
+      REQUIRE(float_to_half(1.0f) == 0x3C00);
+      REQUIRE(float_to_half(-2.0f) == 0xC000);
+      REQUIRE(float_to_half(0.333251953125f) == 0x3555);
+      REQUIRE(float_to_half(65504.0f) == 0x7BFF);
+      REQUIRE(float_to_half(from_bits(0x33800000)) == 0x0001); /* 2^-24, the smallest subnormal */
+      REQUIRE(float_to_half(from_bits(0x38800000)) == 0x0400); /* 2^-14, the smallest normal */
+    }
+  }
+
+  WHEN("The value lies between two half precision values")
+  {
+    THEN("It is rounded to the nearest one, ties to even")
+    {
+      REQUIRE(float_to_half(1.0f + 1.0f / 4096.0f) == 0x3C00);
+      REQUIRE(float_to_half(1.0f + 1.0f / 2048.0f) == 0x3C00);
+      REQUIRE(float_to_half(1.0f + 3.0f / 2048.0f) == 0x3C02);
+      REQUIRE(float_to_half(from_bits(0x33000000)) == 0x0000); /* 2^-25 ties to zero */
+      REQUIRE(float_to_half(from_bits(0x33000001)) == 0x0001);
+      REQUIRE(float_to_half(from_bits(0x387FE000)) == 0x0400); /* Subnormal rounded up to the smallest normal */
+    }
+  }
+
+  WHEN("The value is out of range")
+  {
+    THEN("It becomes infinite or zero")
+    {
+      REQUIRE(float_to_half(65520.0f) == 0x7C00);
+      REQUIRE(float_to_half(-1e10f) == 0xFC00);
+      REQUIRE(float_to_half(1e-10f) == 0x0000);
+      REQUIRE(float_to_half(INFINITY) == 0x7C00);
+      REQUIRE(float_to_half(NAN) == 0x7E00);
+    }
+  }
+
+  WHEN("A batch of samples is converted")
+  {
+    float const sample[] = {1.0f, -2.0f, 65504.0f};
+    uint16_t half[3] = {0};
+    series_to_half(sample, half, 3);
+
+    THEN("Each one is converted")
+    {
+      REQUIRE(half[0] == 0x3C00);
+      REQUIRE(half[1] == 0xC000);
+      REQUIRE(half[2] == 0x7BFF);
+    }
+  }
+}
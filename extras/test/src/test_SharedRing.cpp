@@ -0,0 +1,165 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <SharedRing.h>
+
+#include <string.h>
+
+#include <thread>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Passing messages through a ring in shared memory", "[SharedRing]")
+{
+  alignas(SharedRing::CACHE_LINE) static uint8_t memory[SharedRing::OVERHEAD + 64];
+  SharedRing producer;
+  SharedRing consumer;
+  size_t length = 0;
+
+  WHEN("The memory has not been laid out yet")
+  {
+    memset(memory, 0, sizeof(memory));
+    THEN("The consumer can not attach")
+    {
+      REQUIRE(consumer.attach(memory, sizeof(memory)) == false);
+      REQUIRE(consumer.isReady() == false);
+      REQUIRE(consumer.peek(length) == nullptr);
+    }
+  }
+  WHEN("The memory is not aligned to a cache line")
+  {
+    THEN("The ring is not laid out")
+    {
+      REQUIRE(producer.init(memory + 4, sizeof(memory) - 4) == false);
+    }
+  }
+  WHEN("The ring is laid out and attached to")
+  {
+    REQUIRE(producer.init(memory, sizeof(memory)) == true);
+    REQUIRE(consumer.attach(memory, sizeof(memory)) == true);
+
+    THEN("It is empty")
+    {
+      REQUIRE(consumer.peek(length) == nullptr);
+      REQUIRE(producer.capacity() == 56);
+    }
+    THEN("A message is received as it has been sent")
+    {
+      REQUIRE(producer.push(reinterpret_cast<uint8_t const *>("hello"), 5) == true);
+      uint8_t const * message = consumer.peek(length);
+      REQUIRE(message != nullptr);
+      REQUIRE(length == 5);
+      REQUIRE(memcmp(message, "hello", 5) == 0);
+      /* Until it is popped */
+      REQUIRE(consumer.peek(length) == message);
+      consumer.pop();
+      REQUIRE(consumer.peek(length) == nullptr);
+    }
+    THEN("A message reserved is only received once committed, with the length committed")
+    {
+      uint8_t * buf = producer.reserve(32);
+      REQUIRE(buf != nullptr);
+      memcpy(buf, "abc", 3);
+      REQUIRE(consumer.peek(length) == nullptr);
+      producer.commit(3);
+      uint8_t const * message = consumer.peek(length);
+      REQUIRE(message == buf);
+      REQUIRE(length == 3);
+    }
+    THEN("A message longer than the ring can hold is refused")
+    {
+      REQUIRE(producer.reserve(producer.capacity() + 1) == nullptr);
+      REQUIRE(producer.reserve(producer.capacity()) != nullptr);
+    }
+    THEN("Messages are refused while the ring is full")
+    {
+      uint8_t const data[12] = {0};
+      REQUIRE(producer.push(data, sizeof(data)) == true);
+      REQUIRE(producer.push(data, sizeof(data)) == true);
+      REQUIRE(producer.push(data, sizeof(data)) == true);
+      REQUIRE(producer.push(data, sizeof(data)) == false);
+      consumer.peek(length);
+      consumer.pop();
+      /* It ends right at the end of the ring */
+      REQUIRE(producer.push(data, sizeof(data)) == true);
+      REQUIRE(producer.push(data, sizeof(data)) == false);
+    }
+    THEN("A message which does not fit before the end starts at the beginning")
+    {
+      uint8_t const data[20] = {1, 2, 3};
+      REQUIRE(producer.push(data, sizeof(data)) == true);
+      REQUIRE(producer.push(data, sizeof(data)) == true);
+      consumer.peek(length);
+      consumer.pop();
+      /* 16 bytes are left up to the end, 24 before the head */
+      uint8_t * buf = producer.reserve(16);
+      REQUIRE(buf != nullptr);
+      buf[0] = 42;
+      producer.commit(1);
+
+      uint8_t const * message = consumer.peek(length);
+      REQUIRE(length == sizeof(data));
+      REQUIRE(memcmp(message, data, sizeof(data)) == 0);
+      consumer.pop();
+      message = consumer.peek(length);
+      REQUIRE(message == buf);
+      REQUIRE(length == 1);
+      REQUIRE(message[0] == 42);
+      consumer.pop();
+      REQUIRE(consumer.peek(length) == nullptr);
+    }
+  }
+  WHEN("A producer and a consumer run in different threads")
+  {
+    static uint32_t const COUNT = 10000;
+    alignas(SharedRing::CACHE_LINE) static uint8_t shared[SharedRing::OVERHEAD + 256];
+    REQUIRE(producer.init(shared, sizeof(shared)) == true);
+    REQUIRE(consumer.attach(shared, sizeof(shared)) == true);
+
+    /* The messages vary in length so that they wrap at any position */
+    std::thread thread([&producer]()
+    {
+      for (uint32_t i = 0; i < COUNT; )
+      {
+        size_t const message_length = sizeof(i) + (i % 13);
+        uint8_t * buf = producer.reserve(message_length);
+        if (!buf)
+          continue;
+        memset(buf, static_cast<uint8_t>(i), message_length);
+        memcpy(buf, &i, sizeof(i));
+        producer.commit(message_length);
+        i++;
+      }
+    });
+
+    bool in_order = true;
+    for (uint32_t expected = 0; expected < COUNT; )
+    {
+      uint8_t const * message = consumer.peek(length);
+      if (!message)
+        continue;
+      uint32_t i = 0;
+      memcpy(&i, message, sizeof(i));
+      bool const is_intact = (length == sizeof(i) + (i % 13)) && ((length == sizeof(i)) || (message[length - 1] == static_cast<uint8_t>(i)));
+      in_order = in_order && (i == expected) && is_intact;
+      consumer.pop();
+      expected++;
+    }
+    thread.join();
+
+    THEN("Every message arrives exactly once, intact and in order")
+    {
+      REQUIRE(in_order == true);
+      REQUIRE(consumer.peek(length) == nullptr);
+    }
+  }
+}
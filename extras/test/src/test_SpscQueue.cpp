@@ -0,0 +1,80 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <SpscQueue.h>
+
+#include <thread>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Passing items through a single producer single consumer queue", "[SpscQueue]")
+{
+  SpscQueue<int, 3> queue;
+  int item = 0;
+
+  WHEN("The queue is empty")
+  {
+    THEN("Nothing can be popped")
+    {
+      REQUIRE(queue.empty() == true);
+      REQUIRE(queue.pop(item) == false);
+    }
+  }
+  WHEN("The queue is filled up to its capacity")
+  {
+    REQUIRE(queue.push(1) == true);
+    REQUIRE(queue.push(2) == true);
+    REQUIRE(queue.push(3) == true);
+
+    THEN("Further items are rejected")
+    {
+      REQUIRE(queue.push(4) == false);
+    }
+    THEN("The items are popped in order")
+    {
+      REQUIRE(queue.pop(item) == true); REQUIRE(item == 1);
+      REQUIRE(queue.pop(item) == true); REQUIRE(item == 2);
+      REQUIRE(queue.push(4) == true);
+      REQUIRE(queue.pop(item) == true); REQUIRE(item == 3);
+      REQUIRE(queue.pop(item) == true); REQUIRE(item == 4);
+      REQUIRE(queue.empty() == true);
+    }
+  }
+  WHEN("A producer and a consumer run in different threads")
+  {
+    static int const COUNT = 10000;
+    SpscQueue<int, 16> shared;
+
+    std::thread producer([&shared]()
+    {
+      for (int i = 0; i < COUNT; )
+        if (shared.push(i)) i++;
+    });
+
+    bool in_order = true;
+    for (int expected = 0; expected < COUNT; )
+    {
+      if (shared.pop(item))
+      {
+        in_order = in_order && (item == expected);
+        expected++;
+      }
+    }
+    producer.join();
+
+    THEN("Every item arrives exactly once and in order")
+    {
+      REQUIRE(in_order == true);
+      REQUIRE(shared.empty() == true);
+    }
+  }
+}
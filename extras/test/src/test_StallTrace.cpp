@@ -0,0 +1,109 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <StallTrace.h>
+
+#include <string.h>
+
+/**************************************************************************************
+  TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Tracing where update() stalled before a watchdog reset", "[StallTrace]")
+{
+  StallTraceRecord record;
+  memset(&record, 0xA5, sizeof(record));
+  set_millis(1000);
+
+  WHEN("The record holds random data after power up")
+  {
+    StallTrace trace(record);
+
+    THEN("Nothing is reported")
+    {
+      REQUIRE(trace.begin(true) == false);
+      REQUIRE(trace.report() == "");
+    }
+  }
+
+  WHEN("The previous boot has been reset by the watchdog within update()")
+  {
+    {
+      StallTrace trace(record);
+      trace.begin(false);
+      trace.enter(2);
+      set_millis(1005);
+      trace.leave();
+      trace.enter(2);
+      trace.leave();
+      trace.enter(9);
+      set_millis(1100);
+      trace.phase(StallPhase::MqttPoll);
+    }
+    StallTrace trace(record);
+
+    THEN("The state, the phase and the durations per state are reported")
+    {
+      REQUIRE(trace.begin(true) == true);
+      REQUIRE(trace.report() == "state:9,phase:3,at:1005,hist:2=1/0/1/0/0/0/0/0");
+    }
+    THEN("The report is only made once")
+    {
+      trace.begin(true);
+      REQUIRE(trace.begin(true) == false);
+    }
+  }
+
+  WHEN("The previous boot has been reset otherwise")
+  {
+    {
+      StallTrace trace(record);
+      trace.begin(false);
+      trace.enter(9);
+    }
+    StallTrace trace(record);
+
+    THEN("Nothing is reported")
+    {
+      REQUIRE(trace.begin(false) == false);
+    }
+  }
+
+  WHEN("The previous boot has been reset intentionally")
+  {
+    {
+      StallTrace trace(record);
+      trace.begin(false);
+      trace.enter(9);
+      trace.clear();
+    }
+    StallTrace trace(record);
+
+    THEN("Nothing is reported")
+    {
+      REQUIRE(trace.begin(true) == false);
+    }
+  }
+
+  WHEN("Durations are sorted into buckets")
+  {
+    THEN("Each bucket spans four times the previous one")
+    {
+      REQUIRE(StallTrace::bucket(0) == 0);
+      REQUIRE(StallTrace::bucket(1) == 1);
+      REQUIRE(StallTrace::bucket(3) == 1);
+      REQUIRE(StallTrace::bucket(4) == 2);
+      REQUIRE(StallTrace::bucket(1023) == 5);
+      REQUIRE(StallTrace::bucket(1024) == 6);
+      REQUIRE(StallTrace::bucket(4096) == 7);
+      REQUIRE(StallTrace::bucket(100000) == 7);
+    }
+  }
+}
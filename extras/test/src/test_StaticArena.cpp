@@ -0,0 +1,146 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <stdint.h>
+
+#include <util/AllocationTestUtil.h>
+#include <util/CBORTestUtil.h>
+
+#include <CBORDecoder.h>
+#include <property/types/CloudWrapperInt.h>
+#include <utility/memory/StaticArena.h>
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+static void onUpdate()
+{
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Blocks are taken from the static arena", "[StaticArena]")
+{
+  WHEN("A block is allocated")
+  {
+    void * const block = StaticArena::allocate(3);
+
+    THEN("It is aligned and taken from the buffer")
+    {
+      REQUIRE(block != nullptr);
+      REQUIRE(StaticArena::owns(block));
+      REQUIRE((reinterpret_cast<uintptr_t>(block) % StaticArena::ALIGNMENT) == 0);
+      StaticArena::release(block);
+    }
+
+    AND_WHEN("It is released")
+    {
+      StaticArena::release(block);
+
+      THEN("It is reused for a block of the same size but not for a larger one")
+      {
+        void * const larger = StaticArena::allocate(2 * StaticArena::ALIGNMENT);
+        size_t const used_before = StaticArena::used();
+        REQUIRE(larger != block);
+        REQUIRE(StaticArena::allocate(StaticArena::ALIGNMENT) == block);
+        REQUIRE(StaticArena::used() == used_before);
+        StaticArena::release(larger);
+        StaticArena::release(block);
+      }
+    }
+  }
+
+  WHEN("A block larger than the arena is allocated")
+  {
+    int value = 0;
+    size_t const used_before = StaticArena::used();
+
+    THEN("It is refused and the heap is used instead")
+    {
+      REQUIRE(StaticArena::allocate(StaticArena::SIZE) == nullptr);
+      REQUIRE(StaticArena::used() == used_before);
+      REQUIRE_FALSE(StaticArena::owns(&value));
+
+      void * const mem = arenaAlloc(StaticArena::SIZE);
+      REQUIRE(mem != nullptr);
+      REQUIRE_FALSE(StaticArena::owns(mem));
+      arenaFree(mem);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("The objects created for the properties do not use the heap", "[StaticArena]")
+{
+  WHEN("A primitive is wrapped")
+  {
+    int value = 0;
+    AllocationCounter counter;
+    CloudWrapperInt * const wrapper = arenaNew<CloudWrapperInt>(value);
+    size_t const allocation_cnt = counter.count();
+
+    THEN("The wrapper is constructed within the arena")
+    {
+      REQUIRE(allocation_cnt == 0);
+      REQUIRE(StaticArena::owns(wrapper));
+      value = 5;
+      REQUIRE(wrapper->isDifferentFromCloud());
+      arenaDelete(wrapper);
+    }
+  }
+
+  WHEN("Properties with extra state are created and destroyed during runtime")
+  {
+    /* The first one may still grow the arena */
+    { CloudInt warmup; warmup.onUpdate(onUpdate); warmup.publishAggregated(Aggregation::Mean, 10); }
+    size_t const used_before = StaticArena::used();
+
+    AllocationCounter counter;
+    for (int i = 0; i < 10; i++)
+    {
+      CloudInt number;
+      number.onUpdate(onUpdate);
+      number.publishAggregated(Aggregation::Mean, 10);
+    }
+    size_t const allocation_cnt = counter.count();
+
+    THEN("The released blocks are reused")
+    {
+      REQUIRE(allocation_cnt == 0);
+      REQUIRE(StaticArena::used() == used_before);
+    }
+  }
+
+  WHEN("A property is added under a copied name and its value is received")
+  {
+    PropertyContainer property_container;
+    CloudInt number;
+    /* [{0: "test", 2: 7}] = 81 A2 00 64 74 65 73 74 02 07 */
+    uint8_t const payload[] = {0x81, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x07};
+
+    String const name("test");
+
+    AllocationCounter counter;
+    addPropertyToContainer(property_container, number, name, Permission::ReadWrite);
+    number.setLastCloudChangeTimestamp(1);
+    CBORDecoder::decode(property_container, payload, sizeof(payload));
+    size_t const allocation_cnt = counter.count();
+
+    THEN("Neither the name nor the timestamps are allocated from the heap")
+    {
+      REQUIRE(allocation_cnt == 0);
+      REQUIRE(number == 7);
+    }
+  }
+}
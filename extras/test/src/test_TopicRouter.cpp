@@ -0,0 +1,89 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string.h>
+
+#include <TopicRouter.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+static uint8_t match(TopicRouter const & router, char const * topic)
+{
+  return router.match(topic, strlen(topic));
+}
+
+SCENARIO("Routing incoming topics to their identifiers", "[TopicRouter]")
+{
+  String const device = "/a/d/5f4f0c1a-9bd4-4c8f-8d0e-6c7e5a1b2c3d/c/dm";
+  String const data   = "/a/t/a3b5c7d9-1e2f-4a6b-8c0d-2e4f6a8b0c1e/e/i";
+  String const shadow = "/a/t/a3b5c7d9-1e2f-4a6b-8c0d-2e4f6a8b0c1e/shadow/i";
+
+  TopicRouter router;
+  REQUIRE(router.add(1, device));
+  REQUIRE(router.add(2, data));
+  REQUIRE(router.add(3, shadow));
+
+  WHEN("A subscribed topic is received")
+  {
+    THEN("Its identifier is returned")
+    {
+      REQUIRE(match(router, device.c_str()) == 1);
+      REQUIRE(match(router, data.c_str()) == 2);
+      REQUIRE(match(router, shadow.c_str()) == 3);
+    }
+  }
+  WHEN("A topic of the same length differs in a single character")
+  {
+    THEN("It is not routed")
+    {
+      REQUIRE(match(router, "/a/t/a3b5c7d9-1e2f-4a6b-8c0d-2e4f6a8b0c1f/e/i") == TopicRouter::NONE);
+    }
+  }
+  WHEN("A prefix of a subscribed topic is received")
+  {
+    THEN("It is not routed")
+    {
+      REQUIRE(router.match(data.c_str(), data.length() - 1) == TopicRouter::NONE);
+      REQUIRE(match(router, "") == TopicRouter::NONE);
+    }
+  }
+  WHEN("The topic of an identifier is replaced")
+  {
+    String const new_data = "/a/t/00000000-1e2f-4a6b-8c0d-2e4f6a8b0c1e/e/i";
+    REQUIRE(router.add(2, new_data));
+    THEN("Only the new topic is routed to it")
+    {
+      REQUIRE(match(router, new_data.c_str()) == 2);
+      REQUIRE(match(router, data.c_str()) == TopicRouter::NONE);
+    }
+  }
+  WHEN("An identifier is removed")
+  {
+    router.remove(3);
+    THEN("Its topic is no longer routed")
+    {
+      REQUIRE(match(router, shadow.c_str()) == TopicRouter::NONE);
+      REQUIRE(match(router, device.c_str()) == 1);
+    }
+  }
+  WHEN("More topics than supported are added")
+  {
+    String const extra = "/extra";
+    String const overflow = "/overflow";
+    REQUIRE(router.add(4, extra));
+    THEN("The excess topic is rejected")
+    {
+      REQUIRE_FALSE(router.add(5, overflow));
+      REQUIRE(match(router, extra.c_str()) == 4);
+    }
+  }
+}
@@ -0,0 +1,106 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string>
+
+#include <Trace.h>
+
+/**************************************************************************************
+   HELPER
+ **************************************************************************************/
+
+/* Collects the output of TraceBuffer::dump() */
+class StringOutput
+{
+public:
+  std::string str;
+  void print  (unsigned long const val) { str += std::to_string(val); }
+  void print  (char const val)          { str += val; }
+  void print  (char const * val)        { str += val; }
+  void println(unsigned int const val)  { str += std::to_string(val); str += '\n'; }
+};
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Trace points are recorded into a ring buffer", "[Trace]")
+{
+  TraceRecord records[TraceBuffer::SIZE];
+
+  WHEN("A few records are added")
+  {
+    TraceBuffer trace;
+    set_micros(100);
+    trace.record(TraceEvent::EncodeBegin, 3);
+    set_micros(250);
+    trace.record(TraceEvent::EncodeEnd, 0x12345);
+
+    THEN("They are kept in order with their time stamp and the lower 16 bits of the argument")
+    {
+      REQUIRE(trace.copy(records, TraceBuffer::SIZE) == 2);
+      REQUIRE(records[0].time_us == 100);
+      REQUIRE(records[0].event == static_cast<uint8_t>(TraceEvent::EncodeBegin));
+      REQUIRE(records[0].arg == 3);
+      REQUIRE(records[0].seq == 0);
+      REQUIRE(records[1].time_us == 250);
+      REQUIRE(records[1].arg == 0x2345);
+      REQUIRE(records[1].seq == 1);
+    }
+
+    THEN("They can be dumped as text")
+    {
+      StringOutput out;
+      trace.dump(out);
+      REQUIRE(out.str == "100 EncodeBegin 3\n250 EncodeEnd 9029\n");
+    }
+
+    THEN("A clear drops them")
+    {
+      trace.clear();
+      REQUIRE(trace.recordCount() == 0);
+      REQUIRE(trace.copy(records, TraceBuffer::SIZE) == 0);
+    }
+  }
+
+  WHEN("More records are added than fit")
+  {
+    TraceBuffer trace;
+    for (uint32_t i = 0; i < TraceBuffer::SIZE + 5; i++)
+      trace.record(TraceEvent::MqttWrite, i);
+
+    THEN("The oldest ones are overwritten")
+    {
+      REQUIRE(trace.recordCount() == TraceBuffer::SIZE + 5);
+      REQUIRE(trace.copy(records, TraceBuffer::SIZE) == TraceBuffer::SIZE);
+      REQUIRE(records[0].arg == 5);
+      REQUIRE(records[TraceBuffer::SIZE - 1].arg == TraceBuffer::SIZE + 4);
+    }
+
+    THEN("Fewer records can be copied")
+    {
+      REQUIRE(trace.copy(records, 2) == 2);
+      REQUIRE(records[1].arg == 6);
+    }
+  }
+
+#if !AIOT_CONFIG_TRACE_ENABLED
+  WHEN("Tracing is disabled")
+  {
+    int evaluated = 0;
+    AIOTC_TRACE(State, evaluated++);
+
+    THEN("The argument of a trace point is not evaluated")
+    {
+      REQUIRE(evaluated == 0);
+    }
+  }
+#endif
+}
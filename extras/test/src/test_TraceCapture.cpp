@@ -0,0 +1,106 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <string.h>
+
+#include <TraceCapture.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("A trace capture is recorded and uploaded in chunks", "[TraceCapture]")
+{
+  TraceBuffer trace;
+  trace.setEnabled(false);
+  TraceCapture capture(trace);
+  uint8_t chunk[TraceCapture::CHUNK_HEADER_SIZE + 4 * sizeof(TraceRecord)];
+
+  WHEN("No capture has been requested")
+  {
+    trace.record(TraceEvent::MqttPoll, 1);
+
+    THEN("Nothing is recorded or uploaded")
+    {
+      REQUIRE(trace.recordCount() == 0);
+      REQUIRE(capture.state() == TraceCapture::State::Idle);
+      REQUIRE(capture.nextChunk(chunk, sizeof(chunk)) == 0);
+    }
+  }
+
+  WHEN("A capture of one second is started")
+  {
+    trace.record(TraceEvent::MqttPoll, 1);
+    capture.start(1000, 5000);
+    for (uint32_t i = 0; i < 10; i++)
+      trace.record(TraceEvent::MqttWrite, i);
+    capture.update(5999);
+
+    THEN("The trace points are recorded for that long")
+    {
+      REQUIRE(capture.state() == TraceCapture::State::Recording);
+      REQUIRE(capture.endsIn(5999) == 1);
+      REQUIRE(trace.recordCount() == 10);
+    }
+
+    capture.update(6000);
+    trace.record(TraceEvent::MqttPoll, 0);
+
+    THEN("The records are then uploaded in chunks of as many records as fit")
+    {
+      REQUIRE(capture.state() == TraceCapture::State::Uploading);
+      REQUIRE(capture.recordCount() == 10);
+      REQUIRE_FALSE(trace.isEnabled());
+
+      size_t const lengths[] = {36, 36, 20};
+      size_t first = 0;
+      for (size_t const length : lengths)
+      {
+        REQUIRE(capture.nextChunk(chunk, sizeof(chunk)) == length);
+        REQUIRE(chunk[0] == first);
+        REQUIRE(chunk[1] == 0);
+        REQUIRE(chunk[2] == 10);
+        REQUIRE(chunk[3] == 0);
+        TraceRecord record;
+        memcpy(&record, chunk + TraceCapture::CHUNK_HEADER_SIZE, sizeof(record));
+        REQUIRE(record.event == static_cast<uint8_t>(TraceEvent::MqttWrite));
+        REQUIRE(record.arg == first);
+        first += (length - TraceCapture::CHUNK_HEADER_SIZE) / sizeof(TraceRecord);
+      }
+      REQUIRE(capture.state() == TraceCapture::State::Idle);
+      REQUIRE(capture.nextChunk(chunk, sizeof(chunk)) == 0);
+    }
+  }
+
+  WHEN("Nothing is traced during the capture")
+  {
+    capture.start(1000, 0);
+    capture.update(1000);
+
+    THEN("A single chunk with the header only is uploaded")
+    {
+      REQUIRE(capture.nextChunk(chunk, sizeof(chunk)) == TraceCapture::CHUNK_HEADER_SIZE);
+      REQUIRE(chunk[2] == 0);
+      REQUIRE(capture.nextChunk(chunk, sizeof(chunk)) == 0);
+    }
+  }
+
+  WHEN("A capture is aborted")
+  {
+    capture.start(1000, 0);
+    capture.start(0, 500);
+
+    THEN("Tracing stops right away")
+    {
+      REQUIRE(capture.state() == TraceCapture::State::Idle);
+      REQUIRE_FALSE(trace.isEnabled());
+    }
+  }
+}
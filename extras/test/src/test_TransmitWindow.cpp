@@ -0,0 +1,74 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <utility/net/TransmitWindow.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The transmit window opens once per cycle", "[TransmitWindow]")
+{
+  TransmitWindow window;
+
+  WHEN("No cycle is set")
+  {
+    THEN("It is always open")
+    {
+      REQUIRE_FALSE(window.isEnabled());
+      REQUIRE(window.isOpen(12345));
+      REQUIRE(window.nextOpenIn(12345) == 0);
+    }
+  }
+
+  WHEN("A cycle of 20 s with a window of 2 s is set")
+  {
+    window.begin(20000, 2000, 1000);
+
+    THEN("It is open at the start of each cycle only")
+    {
+      REQUIRE(window.isOpen(1000));
+      REQUIRE(window.isOpen(2999));
+      REQUIRE_FALSE(window.isOpen(3000));
+      REQUIRE(window.nextOpenIn(3000) == 18000);
+      REQUIRE(window.isOpen(21500));
+      REQUIRE(window.nextCycleIn(21500) == 19500);
+    }
+
+    THEN("It follows the wrap around of millis()")
+    {
+      window.begin(20000, 2000, static_cast<unsigned long>(-1) - 999);
+      REQUIRE(window.isOpen(999));
+      REQUIRE_FALSE(window.isOpen(1000));
+    }
+
+    AND_WHEN("Data is received while it is thought to be closed")
+    {
+      window.align(10000);
+
+      THEN("The windows are aligned to it")
+      {
+        REQUIRE(window.isOpen(11999));
+        REQUIRE_FALSE(window.isOpen(12000));
+        REQUIRE(window.nextOpenIn(12000) == 18000);
+      }
+    }
+
+    AND_WHEN("Data is received while it is open")
+    {
+      window.align(2000);
+
+      THEN("The windows stay as they are")
+      {
+        REQUIRE_FALSE(window.isOpen(3000));
+      }
+    }
+  }
+}
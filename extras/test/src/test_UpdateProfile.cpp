@@ -0,0 +1,101 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <limits.h>
+
+#include <UpdateProfile.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Durations are profiled", "[UpdateProfile]")
+{
+  WHEN("Nothing has been measured")
+  {
+    ProfileCounter counter;
+
+    THEN("All figures are zero")
+    {
+      REQUIRE(counter.count() == 0);
+      REQUIRE(counter.totalMicros() == 0);
+      REQUIRE(counter.maxMicros() == 0);
+      REQUIRE(counter.averageMicros() == 0);
+    }
+  }
+
+  WHEN("Several durations are added")
+  {
+    ProfileCounter counter;
+    counter.add(100);
+    counter.add(400);
+    counter.add(250);
+
+    THEN("The count, total, longest and average duration are kept")
+    {
+      REQUIRE(counter.count() == 3);
+      REQUIRE(counter.totalMicros() == 750);
+      REQUIRE(counter.maxMicros() == 400);
+      REQUIRE(counter.averageMicros() == 250);
+    }
+
+    THEN("A reset clears the counter")
+    {
+      counter.reset();
+      REQUIRE(counter.count() == 0);
+      REQUIRE(counter.maxMicros() == 0);
+    }
+  }
+
+  WHEN("A scope is timed")
+  {
+    UpdateProfile profile;
+    set_micros(1000);
+    {
+      ProfileScope const scope(profile.section(ProfileSection::Encode));
+      set_micros(1750);
+    }
+
+    THEN("Its duration is added to the section")
+    {
+      REQUIRE(profile.section(ProfileSection::Encode).count() == 1);
+      REQUIRE(profile.section(ProfileSection::Encode).totalMicros() == 750);
+      REQUIRE(profile.section(ProfileSection::Send).count() == 0);
+    }
+  }
+
+  WHEN("micros() wraps around within a scope")
+  {
+    UpdateProfile profile;
+    set_micros(ULONG_MAX - 99);
+    {
+      ProfileScope const scope(profile.state(0));
+      set_micros(150);
+    }
+
+    THEN("The duration is still correct")
+    {
+      REQUIRE(profile.state(0).maxMicros() == 250);
+    }
+  }
+
+  WHEN("A state beyond the last one is profiled")
+  {
+    UpdateProfile profile;
+    profile.state(UpdateProfile::STATE_CNT + 5).add(10);
+
+    THEN("It is accounted to the last state")
+    {
+      REQUIRE(profile.state(UpdateProfile::STATE_CNT - 1).count() == 1);
+      profile.reset();
+      REQUIRE(profile.state(UpdateProfile::STATE_CNT - 1).count() == 0);
+    }
+  }
+}
@@ -0,0 +1,115 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+#include <util/ClockTestUtil.h>
+
+#include <AIoTC_Const.h>
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+/* The other tests expect the POSIX time to be unknown */
+struct ClockRestart
+{
+  ClockRestart()  { VirtualClock::reset(); }
+  ~ClockRestart() { VirtualClock::reset(); }
+};
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("All time sources derive from the virtual clock", "[VirtualClock]")
+{
+  ClockRestart restart;
+
+  WHEN("Time passes")
+  {
+    VirtualClock::advanceMicros(1500);
+    VirtualClock::advance(2);
+
+    THEN("millis() and micros() agree")
+    {
+      REQUIRE(micros() == 3500);
+      REQUIRE(millis() == 3);
+    }
+
+    THEN("Time does not go backwards")
+    {
+      VirtualClock::advanceTo(1000);
+      REQUIRE(VirtualClock::now() == 3500);
+    }
+  }
+
+  WHEN("The clock is set through the Arduino stub")
+  {
+    set_millis(1234);
+
+    THEN("micros() follows")
+    {
+      REQUIRE(micros() == 1234000);
+    }
+  }
+
+  WHEN("The POSIX time is set")
+  {
+    VirtualClock::advance(500);
+    REQUIRE(getTime() == 0);
+    VirtualClock::setTime(1700000000);
+
+    THEN("It advances with millis()")
+    {
+      VirtualClock::advance(999);
+      REQUIRE(getTime() == 1700000000);
+      VirtualClock::advance(1);
+      REQUIRE(getTime() == 1700000001);
+    }
+
+    THEN("The properties are timestamped with it")
+    {
+      PropertyContainer property_container;
+      CloudInt test = 0;
+      addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+      VirtualClock::advance(60 * 1000UL);
+      test = 1;
+      test.updateLocalTimestamp();
+      REQUIRE(test.getLastLocalChangeTimestamp() == 1700000060);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("Hours of device time are run within a test", "[VirtualClock]")
+{
+  ClockRestart restart;
+  PropertyContainer property_container;
+  CloudInt test = 0;
+  addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishEvery(10 * SECONDS);
+
+  WHEN("The sketch changes and sends the property every 100 ms for an hour")
+  {
+    int publish_cnt = 0;
+    VirtualClock::run(60 * 60 * 1000UL, 100, [&]()
+    {
+      test = test + 1;
+      if (cbor::encode(property_container).size() != 0)
+        publish_cnt++;
+    });
+
+    THEN("It is published once every 10 s")
+    {
+      REQUIRE(millis() == 60 * 60 * 1000UL);
+      REQUIRE(publish_cnt == 360);
+    }
+  }
+}
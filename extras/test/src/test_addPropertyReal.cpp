@@ -81,4 +81,108 @@ SCENARIO("The same arduino cloud properties are added multiple times", "[Arduino
       REQUIRE(str_property_ptr_1 == str_property_ptr_2);
     }
   }
-}
\ No newline at end of file
+}
+
+/**************************************************************************************/
+
+SCENARIO("The name of an arduino cloud property is added from a String", "[ArduinoCloudThing::addPropertyToContainer]")
+{
+  PropertyContainer property_container;
+
+  CloudInt int_property = 1;
+  {
+    String const name("int_property");
+    addPropertyToContainer(property_container, int_property, name, Permission::ReadWrite);
+  }
+
+  WHEN("The String the property has been added with is gone")
+  {
+    THEN("The property still owns a copy of the name") {
+      REQUIRE(getProperty(property_container, "int_property") == &int_property);
+      REQUIRE(int_property.name() == "int_property");
+    }
+  }
+
+  WHEN("The property is copied")
+  {
+    CloudInt int_property_copy = int_property;
+    THEN("The copy owns a copy of the name") {
+      REQUIRE(int_property_copy.c_name() != int_property.c_name());
+      REQUIRE(int_property_copy.name() == int_property.name());
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("Arduino cloud properties are added from a schema table", "[ArduinoCloudThing::addPropertiesToContainer]")
+{
+  static CloudBool  schema_bool_property;
+  static CloudInt   schema_int_property;
+  static CloudFloat schema_float_property;
+
+  static PropertySchemaEntry const schema[] = {
+    AIOT_PROPERTY   (schema_bool_property,      Permission::ReadWrite),
+    AIOT_PROPERTY_ID(schema_int_property,   7,  Permission::Read),
+    AIOT_PROPERTY   (schema_float_property,     Permission::Write),
+  };
+
+  PropertyContainer property_container;
+
+  WHEN("The schema is added to an empty container")
+  {
+    THEN("All properties are added in order with their names, permissions and identifiers") {
+      REQUIRE(addPropertiesToContainer(property_container, schema) == true);
+      REQUIRE(property_container.size() == 3);
+      REQUIRE(property_container.at(0) == &schema_bool_property);
+      REQUIRE(property_container.at(2) == &schema_float_property);
+      REQUIRE(getProperty(property_container, "schema_int_property") == &schema_int_property);
+      REQUIRE(schema_int_property.c_name() == schema[1].name);
+      REQUIRE(schema_int_property.identifier() == 7);
+      REQUIRE(schema_bool_property.isWriteableByCloud() == true);
+      REQUIRE(schema_int_property.isWriteableByCloud() == false);
+      REQUIRE(schema_float_property.isReadableByCloud() == false);
+    }
+  }
+
+  WHEN("The schema is added twice")
+  {
+    addPropertiesToContainer(property_container, schema);
+    THEN("No property is added again") {
+      REQUIRE(addPropertiesToContainer(property_container, schema) == false);
+      REQUIRE(property_container.size() == 3);
+    }
+  }
+}
+
+SCENARIO("Arduino Cloud Properties are added with a name built at runtime", "[ArduinoCloudThing::addPropertyToContainer]")
+{
+  PropertyContainer property_container;
+  CloudInt int_property = 1;
+  CloudInt literal_property = 2;
+
+  WHEN("the name is built in a buffer which is reused afterwards")
+  {
+    char name[16];
+    snprintf(name, sizeof(name), "int_%d", 1);
+    addPropertyToContainer(property_container, int_property, name, Permission::ReadWrite);
+    strcpy(name, "overwritten");
+
+    THEN("the property keeps a copy of the name") {
+      REQUIRE(int_property.name() == "int_1");
+      REQUIRE(getProperty(property_container, "int_1") == &int_property);
+    }
+  }
+
+  WHEN("the name is passed as a literal name")
+  {
+    static char const name[] = "literal_property";
+    addPropertyToContainer(property_container, literal_property, LiteralName(name), Permission::ReadWrite);
+
+    THEN("the property references it") {
+      REQUIRE(literal_property.c_name() == name);
+      REQUIRE(literal_property.name() == "literal_property");
+      REQUIRE(getProperty(property_container, "literal_property") == &literal_property);
+    }
+  }
+}
@@ -0,0 +1,175 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <stdio.h>
+
+#include <memory>
+#include <vector>
+
+#include <util/AllocationTestUtil.h>
+#include <util/CBORTestUtil.h>
+
+#include <CBORDecoder.h>
+#include <CBOREncoder.h>
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static size_t const PROPERTY_CNT        = 20;
+static size_t const STRING_PROPERTY_CNT = PROPERTY_CNT / 4;
+
+/* Upper bounds of the heap use as of today, lower them when an allocation
+ * is removed. Publishing a string value does not copy it, decoding copies
+ * each string value which does not fit into the small string buffer once,
+ * the peak allows for allocator overhead.
+ */
+static size_t const MAX_ENCODE_ALLOCATIONS      = 0;
+static size_t const MAX_DECODE_SYNC_ALLOCATIONS = STRING_PROPERTY_CNT;
+static size_t const MAX_DECODE_SYNC_PEAK_BYTES  = STRING_PROPERTY_CNT * 64;
+
+/**************************************************************************************
+   HELPER
+ **************************************************************************************/
+
+/* Five of each int, float, bool and string */
+class Thing
+{
+public:
+
+  Thing()
+  {
+    /* The container keeps pointers to the names */
+    _names.reserve(PROPERTY_CNT);
+    for (size_t i = 0; i < PROPERTY_CNT; i++)
+    {
+      char name[16];
+      snprintf(name, sizeof(name), "p%02u", static_cast<unsigned int>(i));
+      _names.emplace_back(name);
+      Property * p = nullptr;
+      switch (i % 4)
+      {
+        case 0: p = new CloudInt();   break;
+        case 1: p = new CloudFloat(); break;
+        case 2: p = new CloudBool();  break;
+        case 3: p = new CloudString(); break;
+      }
+      _properties.emplace_back(p);
+      addPropertyToContainer(_container, *p, _names.back().c_str(), Permission::ReadWrite).onSync(onForceCloudSync);
+    }
+  }
+
+  void change(int const value)
+  {
+    for (size_t i = 0; i < PROPERTY_CNT; i++)
+    {
+      Property * p = _properties[i].get();
+      switch (i % 4)
+      {
+        case 0: *static_cast<CloudInt *>(p) = value;                            break;
+        case 1: *static_cast<CloudFloat *>(p) = static_cast<float>(value) / 2;  break;
+        case 2: *static_cast<CloudBool *>(p) = (value % 2) != 0;               break;
+        case 3: *static_cast<CloudString *>(p) = (value % 2) ? "an odd value, too long for SSO" : "an even value, too long for SSO"; break;
+      }
+    }
+  }
+
+  PropertyContainer & container() { return _container; }
+  Property & property(size_t const i) { return *_properties[i]; }
+
+private:
+
+  PropertyContainer _container;
+  std::vector<std::string> _names;
+  std::vector<std::unique_ptr<Property>> _properties;
+};
+
+/* Encodes all properties into a single message */
+static std::vector<uint8_t> encodeAll(PropertyContainer & property_container)
+{
+  int bytes_encoded = 0;
+  unsigned int starting_property_index = 0;
+  uint8_t buf[1024] = {0};
+
+  REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, starting_property_index, false) == CborNoError);
+  REQUIRE(starting_property_index == 0);
+  return std::vector<uint8_t>(buf, buf + bytes_encoded);
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The heap use of encoding and decoding is bounded", "[Allocations]")
+{
+  WHEN("A thing with 20 properties is encoded")
+  {
+    Thing thing;
+    set_millis(1000);
+    encodeAll(thing.container());
+    set_millis(2000);
+    thing.change(1);
+
+    int bytes_encoded = 0;
+    unsigned int starting_property_index = 0;
+    uint8_t buf[1024] = {0};
+
+    AllocationCounter counter;
+    CborError const err = CBOREncoder::encode(thing.container(), buf, sizeof(buf), bytes_encoded, starting_property_index, false);
+    size_t const allocation_cnt = counter.count();
+
+    THEN("The encoder does not allocate")
+    {
+      REQUIRE(err == CborNoError);
+      REQUIRE(bytes_encoded > 0);
+      REQUIRE(allocation_cnt <= MAX_ENCODE_ALLOCATIONS);
+    }
+  }
+
+  WHEN("A sync message of a thing with 20 properties is decoded")
+  {
+    Thing sender;
+    sender.change(1);
+    std::vector<uint8_t> const payload = encodeAll(sender.container());
+
+    Thing receiver;
+    receiver.change(2);
+    CloudInt & first = static_cast<CloudInt &>(receiver.property(0));
+
+    AllocationCounter counter;
+    CBORDecoder::decode(receiver.container(), payload.data(), payload.size(), true);
+    size_t const allocation_cnt = counter.count();
+    size_t const peak_bytes = counter.peakBytes();
+
+    THEN("The number of allocations and the heap high-water mark stay within budget")
+    {
+      REQUIRE(first == 1);
+      REQUIRE(static_cast<CloudString &>(receiver.property(3)) == "an odd value, too long for SSO");
+      REQUIRE(allocation_cnt <= MAX_DECODE_SYNC_ALLOCATIONS);
+      REQUIRE(peak_bytes <= MAX_DECODE_SYNC_PEAK_BYTES);
+    }
+  }
+
+  WHEN("Counting is reset")
+  {
+    AllocationCounter counter;
+    std::unique_ptr<int> p(new int(0));
+    size_t const allocation_cnt_before_reset = counter.count();
+    counter.reset();
+    p.reset();
+    size_t const allocation_cnt_after_reset = counter.count();
+
+    THEN("Only the allocations done afterwards are counted")
+    {
+      REQUIRE(allocation_cnt_before_reset == 1);
+      REQUIRE(allocation_cnt_after_reset == 0);
+    }
+  }
+}
@@ -343,3 +343,134 @@ SCENARIO("After a connection/reconnection an incoming cbor payload is processed.
 
   REQUIRE(test == false);
 }
+
+/**************************************************************************************/
+
+SCENARIO("After a reconnection the last values received are unchanged since the previous sync")
+{
+  CloudBool test = false;
+  sync_callback_called = false;
+  change_callback_called = false;
+
+  PropertyContainer property_container;
+
+  addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).onUpdate(change_callback).onSync(auto_sync_callback);
+
+  /* [{-3: 1550138810.00, 0: "test", 4: true}] = 81 A3 22 FB 41 D7 19 4F 6E 80 00 00 00 64 74 65 73 74 04 F5 */
+  uint8_t const payload[] = {0x81, 0xA3, 0x22, 0xFB, 0x41, 0xD7, 0x19, 0x4F, 0x6E, 0x80, 0x00, 0x00, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x04, 0xF5};
+  int const payload_length = sizeof(payload) / sizeof(uint8_t);
+  CBORDecoder::decode(property_container, payload, payload_length, true);
+  REQUIRE(sync_callback_called == true);
+  REQUIRE(test == true);
+  sync_callback_called = false;
+  change_callback_called = false;
+
+  WHEN("the local value did not change either")
+  {
+    CBORDecoder::decode(property_container, payload, payload_length, true);
+    THEN("the synchronization callback is not executed")
+    {
+      REQUIRE(sync_callback_called == false);
+      REQUIRE(change_callback_called == false);
+      REQUIRE(test == true);
+    }
+  }
+
+  WHEN("the local value changed meanwhile")
+  {
+    test = false;
+    test.setLastLocalChangeTimestamp(1550138811);
+    CBORDecoder::decode(property_container, payload, payload_length, true);
+    THEN("the synchronization callback is executed and keeps the more recent local value")
+    {
+      REQUIRE(sync_callback_called == true);
+      REQUIRE(change_callback_called == false);
+      REQUIRE(test == false);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+static CloudBool * sync_batch_last = nullptr;
+static int sync_batch_custom_calls = 0;
+static unsigned long sync_batch_last_cloud_ts = 0;
+
+void sync_batch_custom_callback(Property& property)
+{
+  /* Runs only once the whole message has been decoded */
+  sync_batch_last_cloud_ts = sync_batch_last->getLastCloudChangeTimestamp();
+  sync_batch_custom_calls++;
+  CLOUD_WINS(property);
+}
+
+SCENARIO("The sync policies of a shadow message are applied once all of its properties are known")
+{
+  CloudBool custom = false, most_recent = false, cloud = false, device = false;
+  sync_batch_last = &device;
+  sync_batch_custom_calls = 0;
+  sync_batch_last_cloud_ts = 0;
+  change_callback_called = false;
+
+  PropertyContainer property_container;
+
+  addPropertyToContainer(property_container, custom, "c", Permission::ReadWrite).onSync(sync_batch_custom_callback);
+  addPropertyToContainer(property_container, most_recent, "m", Permission::ReadWrite).onUpdate(change_callback).onSync(MOST_RECENT_WINS);
+  addPropertyToContainer(property_container, cloud, "f", Permission::ReadWrite).onSync(CLOUD_WINS);
+  addPropertyToContainer(property_container, device, "d", Permission::ReadWrite).onSync(DEVICE_WINS);
+
+  /* [{-3: 1550138810.00, 0: "c", 4: true}, {-3: 1550138810.00, 0: "m", 4: true},
+   *  {-3: 1550138810.00, 0: "f", 4: true}, {-3: 1550138810.00, 0: "d", 4: true}]
+   */
+  uint8_t const payload[] = {0x84,
+                             0xA3, 0x22, 0xFB, 0x41, 0xD7, 0x19, 0x4F, 0x6E, 0x80, 0x00, 0x00, 0x00, 0x61, 0x63, 0x04, 0xF5,
+                             0xA3, 0x22, 0xFB, 0x41, 0xD7, 0x19, 0x4F, 0x6E, 0x80, 0x00, 0x00, 0x00, 0x61, 0x6D, 0x04, 0xF5,
+                             0xA3, 0x22, 0xFB, 0x41, 0xD7, 0x19, 0x4F, 0x6E, 0x80, 0x00, 0x00, 0x00, 0x61, 0x66, 0x04, 0xF5,
+                             0xA3, 0x22, 0xFB, 0x41, 0xD7, 0x19, 0x4F, 0x6E, 0x80, 0x00, 0x00, 0x00, 0x61, 0x64, 0x04, 0xF5};
+
+  WHEN("the local values are older than the cloud ones")
+  {
+    CBORDecoder::decode(property_container, payload, sizeof(payload), true);
+
+    THEN("the built-in policies are resolved and the custom callback runs once after the last record")
+    {
+      REQUIRE(sync_batch_custom_calls == 1);
+      REQUIRE(sync_batch_last_cloud_ts == 1550138810);
+      REQUIRE(custom == true);
+      REQUIRE(most_recent == true);
+      REQUIRE(change_callback_called == true);
+      REQUIRE(cloud == true);
+      REQUIRE(device == false);
+    }
+  }
+
+  WHEN("the local value of a MOST_RECENT_WINS property is newer")
+  {
+    most_recent.setLastLocalChangeTimestamp(1550138811);
+    CBORDecoder::decode(property_container, payload, sizeof(payload), true);
+
+    THEN("it keeps its local value")
+    {
+      REQUIRE(most_recent == false);
+      REQUIRE(change_callback_called == false);
+      REQUIRE(cloud == true);
+    }
+  }
+
+  WHEN("a second shadow message arrives")
+  {
+    CBORDecoder::decode(property_container, payload, sizeof(payload), true);
+    custom = false;
+    custom.setLastLocalChangeTimestamp(1550138811);
+    /* [{-3: 1550138812.00, 0: "m", 4: false}] */
+    uint8_t const update[] = {0x81, 0xA3, 0x22, 0xFB, 0x41, 0xD7, 0x19, 0x4F, 0x6F, 0x00, 0x00, 0x00, 0x00, 0x61, 0x6D, 0x04, 0xF4};
+    CBORDecoder::decode(property_container, update, sizeof(update), true);
+
+    THEN("only the properties of that message are resolved")
+    {
+      REQUIRE(sync_batch_custom_calls == 1);
+      REQUIRE(custom == false);
+      REQUIRE(most_recent == false);
+    }
+  }
+}
@@ -9,10 +9,14 @@
 #include <catch.hpp>
 
 #include <memory>
+#include <vector>
+#include <string.h>
+#include <algorithm>
 
 #include <util/CBORTestUtil.h>
 
 #include <CBORDecoder.h>
+#include <CBOREncoder.h>
 #include "types/CloudWrapperBool.h"
 #include "types/CloudWrapperFloat.h"
 #include "types/CloudWrapperInt.h"
@@ -252,6 +256,49 @@ SCENARIO("Arduino Cloud Properties are decoded", "[ArduinoCloudThing::decode]")
 
   /************************************************************************************/
 
+  WHEN("A Television property is changed via CBOR message - light payload")
+  {
+    PropertyContainer property_container;
+
+    CloudTelevision tv_test = CloudTelevision(false, 0, false, PlaybackCommands::Stop, InputValue::AUX1, 0);
+
+    addPropertyToContainer(property_container, tv_test, "test", Permission::ReadWrite, 1);
+
+    /* The attribute identifier 7 is out of range
+     * [{0: 1537, 2: 9},{0: 1793, 2: 1},{0: 513, 2: 20}] = 83 A2 00 19 06 01 02 09 A2 00 19 07 01 02 01 A2 00 19 02 01 02 14
+     */
+    uint8_t const payload[] = {0x83, 0xA2, 0x00, 0x19, 0x06, 0x01, 0x02, 0x09, 0xA2, 0x00, 0x19, 0x07, 0x01, 0x02, 0x01, 0xA2, 0x00, 0x19, 0x02, 0x01, 0x02, 0x14};
+    CBORDecoder::decode(property_container, payload, sizeof(payload) / sizeof(uint8_t));
+
+    Television value_tv_test = tv_test.getValue();
+    REQUIRE(value_tv_test.cha == 9);
+    REQUIRE(value_tv_test.vol == 20);
+    REQUIRE(value_tv_test.swi == false);
+    REQUIRE(value_tv_test.pbc == PlaybackCommands::Stop);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A Television property is changed via CBOR message with an unknown attribute")
+  {
+    PropertyContainer property_container;
+
+    CloudTelevision tv_test = CloudTelevision(false, 0, false, PlaybackCommands::Stop, InputValue::AUX1, 0);
+
+    addPropertyToContainer(property_container, tv_test, "test", Permission::ReadWrite);
+
+    /* [{0: "test:abc", 2: 5},{0: "test:vol", 2: 5}] = 82 A2 00 68 74 65 73 74 3A 61 62 63 02 05 A2 00 68 74 65 73 74 3A 76 6F 6C 02 05 */
+    uint8_t const payload[] = {0x82, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x61, 0x62, 0x63, 0x02, 0x05, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x76, 0x6F, 0x6C, 0x02, 0x05};
+    CBORDecoder::decode(property_container, payload, sizeof(payload) / sizeof(uint8_t));
+
+    Television value_tv_test = tv_test.getValue();
+    REQUIRE(value_tv_test.vol == 5);
+    REQUIRE(value_tv_test.cha == 0);
+    REQUIRE(value_tv_test.inp == InputValue::AUX1);
+  }
+
+  /************************************************************************************/
+
   WHEN("A DimmedLight property is changed via CBOR message")
   {
     PropertyContainer property_container;
@@ -648,4 +695,254 @@ SCENARIO("Arduino Cloud Properties are decoded", "[ArduinoCloudThing::decode]")
   }
 
   /************************************************************************************/
+
+  WHEN("A payload containing CBOR keys with nested and indefinite length values is parsed")
+  {
+    PropertyContainer property_container;
+
+    CloudInt test = 0;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+
+    /* [{123: [1, {"a": h'00'}], 124: (_ "ab", "c"), 0: "test", 2: 1}] =
+       81 A4 18 7B 82 01 A1 61 61 41 00 18 7C 7F 62 61 62 61 63 FF 00 64 74 65 73 74 02 01
+    */
+    uint8_t const payload[] = {0x81, 0xA4, 0x18, 0x7B, 0x82, 0x01, 0xA1, 0x61, 0x61, 0x41, 0x00, 0x18, 0x7C, 0x7F, 0x62, 0x61, 0x62, 0x61, 0x63, 0xFF, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x01};
+    CBORDecoder::decode(property_container, payload, sizeof(payload) / sizeof(uint8_t));
+
+    REQUIRE(test == 1);
+  }
+
+  /************************************************************************************/
+
+  WHEN("A payload containing a CBOR map of indefinite length is parsed")
+  {
+    PropertyContainer property_container;
+
+    CloudInt test = 0;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+
+    /* [{_ 0: "test", 2: 1}] = 81 BF 00 64 74 65 73 74 02 01 FF */
+    uint8_t const payload[] = {0x81, 0xBF, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x01, 0xFF};
+    CBORDecoder::decode(property_container, payload, sizeof(payload) / sizeof(uint8_t));
+
+    REQUIRE(test == 1);
+  }
+
+  /************************************************************************************/
+}
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+static bool decodeInChunks(CBORDecoder & decoder, uint8_t const * payload, size_t length, size_t const chunk_size)
+{
+  while (length > 0)
+  {
+    size_t available = 0;
+    uint8_t * buf = decoder.writeBuffer(available);
+    size_t const bytes = std::min(std::min(available, chunk_size), length);
+    memcpy(buf, payload, bytes);
+    if (!decoder.commit(bytes))
+      return false;
+    payload += bytes;
+    length -= bytes;
+  }
+  return decoder.isComplete();
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Arduino Cloud Properties are decoded incrementally", "[ArduinoCloudThing::decode]")
+{
+  WHEN("Multiple properties are received in chunks of varying size")
+  {
+    /* [{0: "bool_test", 4: true}, {0: "int_test", 2: 10}, {0: "float_test", 2: 20.0}, {0: "str_test", 3: "hello arduino"}] */
+    uint8_t const payload[] = {0x84, 0xA2, 0x00, 0x69, 0x62, 0x6F, 0x6F, 0x6C, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x04, 0xF5, 0xA2, 0x00, 0x68, 0x69, 0x6E, 0x74, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x02, 0x0A, 0xA2, 0x00, 0x6A, 0x66, 0x6C, 0x6F, 0x61, 0x74, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x02, 0xF9, 0x4D, 0x00, 0xA2, 0x00, 0x68, 0x73, 0x74, 0x72, 0x5F, 0x74, 0x65, 0x73, 0x74, 0x03, 0x6D, 0x68, 0x65, 0x6C, 0x6C, 0x6F, 0x20, 0x61, 0x72, 0x64, 0x75, 0x69, 0x6E, 0x6F};
+
+    for (size_t chunk_size : {1, 3, 7, 64})
+    {
+      PropertyContainer property_container;
+
+      CloudBool   bool_test = false;
+      CloudInt    int_test = 1;
+      CloudFloat  float_test = 2.0f;
+      CloudString str_test;
+      str_test = ("str_test");
+
+      addPropertyToContainer(property_container, bool_test,  "bool_test",  Permission::ReadWrite);
+      addPropertyToContainer(property_container, int_test,   "int_test",   Permission::ReadWrite);
+      addPropertyToContainer(property_container, float_test, "float_test", Permission::ReadWrite);
+      addPropertyToContainer(property_container, str_test,   "str_test",   Permission::ReadWrite);
+
+      CBORDecoder decoder(property_container);
+      REQUIRE(decodeInChunks(decoder, payload, sizeof(payload), chunk_size));
+
+      REQUIRE(bool_test  == true);
+      REQUIRE(int_test   == 10);
+      REQUIRE(float_test == Approx(20.0).epsilon(0.01));
+      REQUIRE(str_test   == "hello arduino");
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A payload larger than the decoder buffer is received")
+  {
+    PropertyContainer property_container;
+
+    CloudInt   int_a = 0, int_b = 0;
+    CloudColor color_test = CloudColor(0.0, 0.0, 0.0);
+
+    addPropertyToContainer(property_container, int_a,      "a",    Permission::ReadWrite);
+    addPropertyToContainer(property_container, int_b,      "b",    Permission::ReadWrite);
+    addPropertyToContainer(property_container, color_test, "test", Permission::ReadWrite);
+
+    /* [{0: "a", 2: 0}, {0: "b", 2: 1}, ..., {0: "test:hue", 2: 2.0}, {0: "test:sat", 2: 2.0}, {0: "test:bri", 2: 2.0}] */
+    std::vector<uint8_t> payload = {0x98, 0};
+    size_t const int_records = AIOT_CONFIG_CBOR_DECODER_BUFFER_SIZE / 6 + 4;
+    for (size_t i = 0; i < int_records; i++)
+      payload.insert(payload.end(), {0xA2, 0x00, 0x61, static_cast<uint8_t>('a' + (i % 2)), 0x02, static_cast<uint8_t>(i % 20)});
+    uint8_t const color[] = {0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x68, 0x75, 0x65, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x73, 0x61, 0x74, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x62, 0x72, 0x69, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00};
+    payload.insert(payload.end(), color, color + sizeof(color));
+    payload[1] = static_cast<uint8_t>(int_records + 3);
+
+    CBORDecoder decoder(property_container);
+    REQUIRE(decodeInChunks(decoder, payload.data(), payload.size(), 5));
+
+    REQUIRE(int_a == static_cast<int>((int_records - 2) % 20));
+    REQUIRE(int_b == static_cast<int>((int_records - 1) % 20));
+    Color value_color_test = color_test.getValue();
+    REQUIRE(value_color_test.hue == Approx(2.0));
+    REQUIRE(value_color_test.sat == Approx(2.0));
+    REQUIRE(value_color_test.bri == Approx(2.0));
+  }
+
+  /************************************************************************************/
+
+  WHEN("The last values are received with a record larger than the decoder buffer")
+  {
+    PropertyContainer property_container;
+
+    CloudInt    int_a = 0, int_b = 0;
+    CloudString str_test;
+    str_test = "unchanged";
+    addPropertyToContainer(property_container, int_a,    "a",   Permission::ReadWrite).onSync(CLOUD_WINS);
+    addPropertyToContainer(property_container, str_test, "str", Permission::ReadWrite).onSync(CLOUD_WINS);
+    addPropertyToContainer(property_container, int_b,    "b",   Permission::ReadWrite).onSync(CLOUD_WINS);
+
+    /* [{0: "a", 2: 1}, {0: "str", 3: "xx...x"}, {0: "b", 2: 2}] */
+    size_t const str_length = AIOT_CONFIG_CBOR_DECODER_BUFFER_SIZE + 44;
+    std::vector<uint8_t> payload = {0x83, 0xA2, 0x00, 0x61, 0x61, 0x02, 0x01, 0xA2, 0x00, 0x63, 0x73, 0x74, 0x72, 0x03, 0x79,
+                                    static_cast<uint8_t>(str_length >> 8), static_cast<uint8_t>(str_length)};
+    payload.insert(payload.end(), str_length, 'x');
+    payload.insert(payload.end(), {0xA2, 0x00, 0x61, 0x62, 0x02, 0x02});
+
+    CBORDecoder decoder(property_container, true);
+
+    THEN("It is skipped and the other properties are synchronised")
+    {
+      REQUIRE(decodeInChunks(decoder, payload.data(), payload.size(), 16));
+      REQUIRE(int_a == 1);
+      REQUIRE(int_b == 2);
+      REQUIRE(str_test == "unchanged");
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("The records of a single property do not fit into the decoder buffer together")
+  {
+    PropertyContainer property_container;
+
+    CloudColor color_test = CloudColor(0.0, 0.0, 0.0);
+    addPropertyToContainer(property_container, color_test, "test", Permission::ReadWrite);
+
+    /* [{123: "pp...p", 0: "test:hue", 2: 2.0}, ... sat, ... bri] */
+    size_t const padding = AIOT_CONFIG_CBOR_DECODER_BUFFER_SIZE / 3;
+    char const * const attributes[] = {"hue", "sat", "bri"};
+    std::vector<uint8_t> payload = {0x83};
+    for (char const * attribute : attributes)
+    {
+      payload.insert(payload.end(), {0xA3, 0x18, 0x7B, 0x78, static_cast<uint8_t>(padding)});
+      payload.insert(payload.end(), padding, 'p');
+      payload.insert(payload.end(), {0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A});
+      payload.insert(payload.end(), attribute, attribute + 3);
+      payload.insert(payload.end(), {0x02, 0xFA, 0x40, 0x00, 0x00, 0x00});
+    }
+
+    CBORDecoder decoder(property_container);
+
+    THEN("The property is updated with the records as they are received")
+    {
+      REQUIRE(decodeInChunks(decoder, payload.data(), payload.size(), 16));
+      Color value_color_test = color_test.getValue();
+      REQUIRE(value_color_test.hue == Approx(2.0));
+      REQUIRE(value_color_test.sat == Approx(2.0));
+      REQUIRE(value_color_test.bri == Approx(2.0));
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A truncated payload is received")
+  {
+    PropertyContainer property_container;
+
+    CloudBool test = true;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+
+    /* [{0: "test", 4: false}] without the last byte */
+    uint8_t const payload[] = {0x81, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x04};
+
+    CBORDecoder decoder(property_container);
+    REQUIRE_FALSE(decodeInChunks(decoder, payload, sizeof(payload), 4));
+    REQUIRE(test == true);
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("Arduino Cloud Properties encoded with SenML base values are decoded", "[ArduinoCloudThing::decode]")
+{
+  WHEN("A composite and a primitive property are encoded with base name and base time")
+  {
+    PropertyContainer src_container, ref_container, dst_container;
+
+    CloudColoredLight src_light(true, 10.0f, 20.0f, 30.0f), ref_light(true, 10.0f, 20.0f, 30.0f), dst_light;
+    CloudInt          src_count = 7, ref_count = 7, dst_count = 0;
+
+    addPropertyToContainer(src_container, src_light, "light", Permission::ReadWrite);
+    addPropertyToContainer(src_container, src_count, "count", Permission::ReadWrite);
+    addPropertyToContainer(ref_container, ref_light, "light", Permission::ReadWrite);
+    addPropertyToContainer(ref_container, ref_count, "count", Permission::ReadWrite);
+    addPropertyToContainer(dst_container, dst_light, "light", Permission::ReadWrite);
+    addPropertyToContainer(dst_container, dst_count, "count", Permission::ReadWrite);
+
+    uint8_t buf[256] = {0}, ref_buf[256] = {0};
+    int bytes_encoded = 0, ref_bytes_encoded = 0;
+    unsigned int current_property_index = 0, ref_current_property_index = 0;
+    REQUIRE(CBOREncoder::encode(src_container, buf, sizeof(buf), bytes_encoded, current_property_index, false, 1000, true) == CborNoError);
+    REQUIRE(CBOREncoder::encode(ref_container, ref_buf, sizeof(ref_buf), ref_bytes_encoded, ref_current_property_index, false, 1000, false) == CborNoError);
+
+    THEN("The message is smaller than without base values")
+    {
+      REQUIRE(bytes_encoded > 0);
+      REQUIRE(bytes_encoded < ref_bytes_encoded);
+    }
+
+    THEN("All values are restored")
+    {
+      CBORDecoder::decode(dst_container, buf, bytes_encoded);
+
+      REQUIRE(dst_light.getSwitch() == true);
+      REQUIRE(dst_light.getHue() == Approx(10.0));
+      REQUIRE(dst_light.getSaturation() == Approx(20.0));
+      REQUIRE(dst_light.getBrightness() == Approx(30.0));
+      REQUIRE(dst_count == 7);
+      REQUIRE(dst_count.getLastCloudChangeTimestamp() == 1000);
+    }
+  }
 }
@@ -0,0 +1,168 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <util/AllocationTestUtil.h>
+
+#include <CBORDecoder.h>
+#include "types/automation/CloudColoredLight.h"
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+static size_t       const SMALL_CNT = 250;
+static size_t       const LARGE_CNT = 8 * SMALL_CNT;
+static unsigned int const RUN_CNT   = 5;
+
+/**************************************************************************************
+   HELPER
+ **************************************************************************************/
+
+static void appendHeader(std::vector<uint8_t> & cbor, uint8_t const major_type, size_t const val)
+{
+  if (val < 24) {
+    cbor.push_back((major_type << 5) | val);
+  } else if (val < 256) {
+    cbor.insert(cbor.end(), {static_cast<uint8_t>((major_type << 5) | 24), static_cast<uint8_t>(val)});
+  } else {
+    cbor.insert(cbor.end(), {static_cast<uint8_t>((major_type << 5) | 25), static_cast<uint8_t>(val >> 8), static_cast<uint8_t>(val)});
+  }
+}
+
+static void appendString(std::vector<uint8_t> & cbor, std::string const & str)
+{
+  appendHeader(cbor, 3, str.length());
+  cbor.insert(cbor.end(), str.begin(), str.end());
+}
+
+/* [{0: "int_test", 100: 0, 101: 1, ..., 2: 1}] */
+static std::vector<uint8_t> undefinedKeys(size_t const cnt)
+{
+  std::vector<uint8_t> cbor;
+  appendHeader(cbor, 4, 1);
+  appendHeader(cbor, 5, cnt + 2);
+  cbor.push_back(0x00);
+  appendString(cbor, "int_test");
+  for (size_t i = 0; i < cnt; i++) {
+    appendHeader(cbor, 0, 100 + i);
+    appendHeader(cbor, 0, i % 24);
+  }
+  cbor.insert(cbor.end(), {0x02, 0x01});
+  return cbor;
+}
+
+/* [{0: "light:attr0", 2: 1}, {0: "light:attr1", 2: 1}, ...] */
+static std::vector<uint8_t> attributeFlood(size_t const cnt)
+{
+  std::vector<uint8_t> cbor;
+  appendHeader(cbor, 4, cnt);
+  for (size_t i = 0; i < cnt; i++) {
+    cbor.insert(cbor.end(), {0xA2, 0x00});
+    appendString(cbor, "light:attr" + std::to_string(i));
+    cbor.insert(cbor.end(), {0x02, 0x01});
+  }
+  return cbor;
+}
+
+/* [{0: "str_test", 3: "xxx..."}] */
+static std::vector<uint8_t> longString(size_t const cnt)
+{
+  std::vector<uint8_t> cbor;
+  appendHeader(cbor, 4, 1);
+  cbor.insert(cbor.end(), {0xA2, 0x00});
+  appendString(cbor, "str_test");
+  cbor.push_back(0x03);
+  appendString(cbor, std::string(cnt, 'x'));
+  return cbor;
+}
+
+struct DecodeCost
+{
+  double min_us;
+  size_t peak_bytes;
+};
+
+/* Fastest of a few runs, the others are disturbed by whatever else runs */
+static DecodeCost decode(std::vector<uint8_t> const & payload)
+{
+  DecodeCost cost = {0.0, 0};
+  for (unsigned int r = 0; r < RUN_CNT; r++)
+  {
+    PropertyContainer property_container;
+    CloudInt int_test;
+    CloudString str_test;
+    CloudColoredLight light;
+    addPropertyToContainer(property_container, int_test, "int_test", Permission::ReadWrite);
+    addPropertyToContainer(property_container, str_test, "str_test", Permission::ReadWrite);
+    addPropertyToContainer(property_container, light,    "light",    Permission::ReadWrite);
+
+    AllocationCounter counter;
+    auto const start = std::chrono::steady_clock::now();
+    CBORDecoder::decode(property_container, payload.data(), payload.size());
+    double const us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    size_t const peak_bytes = counter.peakBytes();
+
+    if ((r == 0) || (us < cost.min_us))
+      cost.min_us = us;
+    cost.peak_bytes = peak_bytes;
+  }
+  return cost;
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+/* An input 8 times as large may take at most 32 times as long, a quadratic
+ * decoder would take 64 times as long. The heap use must not grow at all
+ * unless the input contains a value which has to be copied.
+ */
+SCENARIO("Adversarial messages are decoded in linear time", "[CBORDecoder::complexity]")
+{
+  WHEN("A record contains many unknown keys")
+  {
+    DecodeCost const small = decode(undefinedKeys(SMALL_CNT));
+    DecodeCost const large = decode(undefinedKeys(LARGE_CNT));
+
+    THEN("Time grows linearly and the heap use does not grow")
+    {
+      REQUIRE(large.min_us <= 32.0 * small.min_us + 50.0);
+      REQUIRE(large.peak_bytes == small.peak_bytes);
+    }
+  }
+
+  WHEN("A property has more attributes than can be kept")
+  {
+    DecodeCost const small = decode(attributeFlood(SMALL_CNT));
+    DecodeCost const large = decode(attributeFlood(LARGE_CNT));
+
+    THEN("Time grows linearly and the heap use does not grow")
+    {
+      REQUIRE(large.min_us <= 32.0 * small.min_us + 50.0);
+      REQUIRE(large.peak_bytes == small.peak_bytes);
+    }
+  }
+
+  WHEN("A string value is very long")
+  {
+    DecodeCost const small = decode(longString(SMALL_CNT));
+    DecodeCost const large = decode(longString(LARGE_CNT));
+
+    THEN("Time and heap use grow linearly")
+    {
+      REQUIRE(large.min_us <= 32.0 * small.min_us + 50.0);
+      REQUIRE(large.peak_bytes <= 8 * small.peak_bytes + 64);
+    }
+  }
+}
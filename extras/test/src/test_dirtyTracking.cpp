@@ -0,0 +1,159 @@
+/*
+   Copyright (c) 2023 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+
+#include "types/CloudWrapperInt.h"
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Only dirty Arduino cloud properties are evaluated by the encoder", "[ArduinoCloudThing::dirtyTracking]")
+{
+  PropertyContainer property_container;
+
+  CloudInt   test_1 = 10;
+  CloudFloat test_2 = 1.0f;
+  int        primitive = 5;
+  CloudWrapperInt test_3(primitive);
+
+  addPropertyToContainer(property_container, test_1, "test_1", Permission::ReadWrite).publishOnChange(0.0f, 0);
+  addPropertyToContainer(property_container, test_2, "test_2", Permission::ReadWrite).publishOnChange(0.0f, 0);
+  addPropertyToContainer(property_container, test_3, "test_3", Permission::ReadWrite);
+
+  WHEN("The properties are added to the container")
+  {
+    THEN("All properties are dirty") {
+      REQUIRE(property_container.isDirty(0));
+      REQUIRE(property_container.isDirty(1));
+      REQUIRE(property_container.isDirty(2));
+    }
+  }
+
+  WHEN("The properties are encoded twice without any change")
+  {
+    cbor::encode(property_container);
+    cbor::encode(property_container);
+
+    THEN("Only the primitive wrapper property is still dirty") {
+      REQUIRE_FALSE(property_container.isDirty(0));
+      REQUIRE_FALSE(property_container.isDirty(1));
+      REQUIRE(property_container.isDirty(2));
+      REQUIRE(property_container.nextDirty(0) == 2);
+    }
+
+    WHEN("A property is modified")
+    {
+      test_2 = 2.0f;
+
+      THEN("The property is dirty again and it is the only one being encoded") {
+        REQUIRE(property_container.isDirty(1));
+        /* [{0: "test_2", 2: 2.0}] = 9F A2 00 66 74 65 73 74 5F 32 02 FA 40 00 00 00 FF */
+        std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x5F, 0x32, 0x02, 0xFA, 0x40, 0x00, 0x00, 0x00, 0xFF};
+        std::vector<uint8_t> const actual = cbor::encode(property_container);
+        REQUIRE(actual == expected);
+      }
+    }
+
+    WHEN("An update is requested for a property")
+    {
+      test_1.requestUpdate();
+
+      THEN("The property is dirty again") {
+        REQUIRE(property_container.isDirty(0));
+      }
+    }
+
+    WHEN("A message is lost and its property is modified once more meanwhile")
+    {
+      test_2 = 2.0f;
+      cbor::encode(property_container);
+      uint32_t lost[PropertyContainer::BITMAP_SIZE];
+      memcpy(lost, property_container.appended(), sizeof(lost));
+      test_2 = 3.0f;
+      property_container.provideEcho(lost);
+
+      THEN("Only the properties of the message are sent again, once with their current values") {
+        REQUIRE(lost[0] == (1UL << 1));
+        REQUIRE(property_container.canProvideEcho(lost));
+        /* [{0: "test_2", 2: 3.0}] = 9F A2 00 66 74 65 73 74 5F 32 02 FA 40 40 00 00 FF */
+        std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x5F, 0x32, 0x02, 0xFA, 0x40, 0x40, 0x00, 0x00, 0xFF};
+        REQUIRE(cbor::encode(property_container) == expected);
+        REQUIRE(cbor::encode(property_container).size() == 0);
+      }
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("Arduino cloud properties which the cloud can not read are never dirty", "[ArduinoCloudThing::dirtyTracking]")
+{
+  PropertyContainer property_container;
+
+  CloudInt test_1 = 10;
+  CloudInt test_2 = 20;
+
+  addPropertyToContainer(property_container, test_1, "test_1", Permission::Write).publishOnChange(0.0f, 0);
+  addPropertyToContainer(property_container, test_2, "test_2", Permission::Read).publishOnChange(0.0f, 0);
+
+  WHEN("The properties are added to the container and modified")
+  {
+    test_1 = 11;
+    test_1.requestUpdate();
+
+    THEN("Only the readable property is dirty and it is the only one being encoded") {
+      REQUIRE_FALSE(property_container.isDirty(0));
+      REQUIRE(property_container.nextDirty(0) == 1);
+      /* [{0: "test_2", 2: 20}] = 9F A2 00 66 74 65 73 74 5F 32 02 14 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x5F, 0x32, 0x02, 0x14, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("Primitive wrapper properties with manual change detection", "[ArduinoCloudThing::dirtyTracking]")
+{
+  PropertyContainer property_container;
+
+  int primitive = 5;
+  CloudWrapperInt test(primitive);
+
+  addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(0.0f, 0).manualChangeDetection();
+
+  WHEN("The property is encoded twice without any change")
+  {
+    cbor::encode(property_container);
+    cbor::encode(property_container);
+
+    THEN("It is neither dirty nor scanned for local changes any longer") {
+      REQUIRE_FALSE(property_container.isDirty(0));
+      REQUIRE(property_container.nextPrimitive(0) == property_container.size());
+    }
+
+    WHEN("The change of the wrapped variable is reported")
+    {
+      primitive = 6;
+      REQUIRE(getPrimitiveProperty(property_container, &primitive) == &test);
+      getPrimitiveProperty(property_container, &primitive)->markChanged();
+
+      THEN("The property is dirty again") {
+        REQUIRE(property_container.isDirty(0));
+        /* [{0: "test", 2: 6}] = 9F A2 00 64 74 65 73 74 02 06 FF */
+        std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x06, 0xFF};
+        std::vector<uint8_t> const actual = cbor::encode(property_container);
+        REQUIRE(actual == expected);
+      }
+    }
+  }
+}
@@ -11,6 +11,7 @@
 #include <memory>
 
 #include <util/CBORTestUtil.h>
+#include <CBOREncoder.h>
 #include "types/CloudWrapperBool.h"
 #include "types/CloudWrapperFloat.h"
 #include "types/CloudWrapperInt.h"
@@ -57,6 +58,25 @@ SCENARIO("Arduino Cloud Properties are encoded", "[ArduinoCloudThing::encode-1]"
 
   /************************************************************************************/
 
+  WHEN("Properties are added without identifier - light payload")
+  {
+    /*Properties added without an explicit identifier are numbered in the order they are added*/
+    PropertyContainer property_container;
+    cbor::encode(property_container);
+
+    CloudBool test_1 = true;
+    CloudBool test_2 = false;
+    addPropertyToContainer(property_container, test_1, "test_1", Permission::ReadWrite);
+    addPropertyToContainer(property_container, test_2, "test_2", Permission::ReadWrite);
+
+    /* [{0: 1, 4: true}, {0: 2, 4: false}] = 9F A2 00 01 04 F5 A2 00 02 04 F4 FF*/
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x01, 0x04, 0xF5, 0xA2, 0x00, 0x02, 0x04, 0xF4, 0xFF};
+    std::vector<uint8_t> const actual = cbor::encode(property_container, true);
+    REQUIRE(actual == expected);
+  }
+
+  /************************************************************************************/
+
   WHEN("A 'int' property is added")
   {
     PropertyContainer property_container;
@@ -89,6 +109,53 @@ SCENARIO("Arduino Cloud Properties are encoded", "[ArduinoCloudThing::encode-1]"
 
   /************************************************************************************/
 
+  WHEN("A 'float' property is added with compact float encoding")
+  {
+    PropertyContainer property_container;
+    cbor::encode(property_container);
+
+    CloudFloat float_test = 2.0f;
+    addPropertyToContainer(property_container, float_test, "test", Permission::ReadWrite).encodeCompactFloat();
+
+    THEN("An integral value is encoded as integer")
+    {
+      /* [{0: "test", 2: 2}] = 9F A2 00 64 74 65 73 74 02 02 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x02, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      REQUIRE(actual == expected);
+    }
+
+    THEN("A value exactly representable as half-float is encoded as half-float")
+    {
+      float_test = -1.5f;
+      /* [{0: "test", 2: -1.5}] = 9F A2 00 64 74 65 73 74 02 F9 BE 00 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xF9, 0xBE, 0x00, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      REQUIRE(actual == expected);
+    }
+
+    THEN("A value not representable as half-float is encoded as float")
+    {
+      float_test = 3.14159f;
+      /* [{0: "test", 2: 3.141590118408203}] = 9F A2 00 64 74 65 73 74 02 FA 40 49 0F D0 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xFA, 0x40, 0x49, 0x0F, 0xD0, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      REQUIRE(actual == expected);
+    }
+
+    THEN("A value within the publishOnChange delta of a half-float is encoded as half-float")
+    {
+      float_test.publishOnChange(0.01f);
+      float_test = 3.14159f;
+      /* [{0: "test", 2: 3.140625}] = 9F A2 00 64 74 65 73 74 02 F9 42 48 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xF9, 0x42, 0x48, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      REQUIRE(actual == expected);
+    }
+  }
+
+  /************************************************************************************/
+
   WHEN("A 'String' property is added")
   {
     PropertyContainer property_container;
@@ -494,6 +561,55 @@ SCENARIO("Arduino Cloud Properties are encoded", "[ArduinoCloudThing::encode-1]"
   }
 
 
+  /************************************************************************************/
+
+  WHEN("A property is encoded with the timestamp of a sample")
+  {
+    PropertyContainer property_container;
+
+    CloudBool test = true;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+
+    /* [{0: "test", 4: true, 6: 1000}] = 9F A3 00 64 74 65 73 74 04 F5 06 19 03 E8 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA3, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x04, 0xF5, 0x06, 0x19, 0x03, 0xE8, 0xFF};
+
+    uint8_t buf[256] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+    REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index, false, 1000) == CborNoError);
+    std::vector<uint8_t> const actual(buf, buf + bytes_encoded);
+    REQUIRE(actual == expected);
+  }
+
+  /************************************************************************************/
+
+  WHEN("Only properties which are not writeable by the cloud are encoded")
+  {
+    PropertyContainer property_container;
+
+    CloudBool test = true;
+    CloudBool test_ro = true;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+    addPropertyToContainer(property_container, test_ro, "ro", Permission::Read);
+
+    /* [{0: "ro", 4: true}] = 9F A2 00 62 72 6F 04 F5 FF */
+    std::vector<uint8_t> const expected_ro = {0x9F, 0xA2, 0x00, 0x62, 0x72, 0x6F, 0x04, 0xF5, 0xFF};
+    /* [{0: "test", 4: true}] = 9F A2 00 64 74 65 73 74 04 F5 FF */
+    std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x04, 0xF5, 0xFF};
+
+    uint8_t buf[256] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+    REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index, false, 0, false, false, true) == CborNoError);
+    std::vector<uint8_t> const actual_ro(buf, buf + bytes_encoded);
+    REQUIRE(actual_ro == expected_ro);
+
+    THEN("The others are encoded later on")
+    {
+      REQUIRE(cbor::encode(property_container) == expected);
+    }
+  }
+
   /************************************************************************************/
 
   WHEN("The size of a single encoded properties is exceeding the CBOR buffer size")
@@ -516,4 +632,287 @@ SCENARIO("Arduino Cloud Properties are encoded", "[ArduinoCloudThing::encode-1]"
     REQUIRE(actual_1 == expected_1);
   }
 
+
+  /************************************************************************************/
+
+  WHEN("A high priority property is placed behind properties exceeding the CBOR buffer size")
+  {
+    PropertyContainer property_container;
+
+    CloudString str[10];
+    char const * names[10] = {"str_0", "str_1", "str_2", "str_3", "str_4", "str_5", "str_6", "str_7", "str_8", "str_9"};
+    for (size_t i = 0; i < 10; i++) {
+      str[i] = "This string is 30 bytes long.";
+      addPropertyToContainer(property_container, str[i], names[i], Permission::ReadWrite);
+    }
+    getProperty(property_container, "str_9")->priority(Priority::High);
+
+    /* Every encoded property {0: "str_X", 3: "This string is 30 bytes long."} takes 40 bytes,
+     * the name starts at offset 3 of it.
+     */
+    auto encoded_names = [](std::vector<uint8_t> const & msg)
+    {
+      std::vector<std::string> names;
+      for (size_t offset = 1; (offset + 40) < msg.size(); offset += 40)
+        names.push_back(std::string(msg.begin() + offset + 3, msg.begin() + offset + 8));
+      return names;
+    };
+
+    THEN("It is encoded into the first message ahead of the round-robin order")
+    {
+      std::vector<std::string> const expected_1 = {"str_9", "str_0", "str_1", "str_2", "str_3", "str_4"};
+      REQUIRE(encoded_names(cbor::encode(property_container)) == expected_1);
+
+      std::vector<std::string> const expected_2 = {"str_5", "str_6", "str_7", "str_8"};
+      REQUIRE(encoded_names(cbor::encode(property_container)) == expected_2);
+
+      REQUIRE(cbor::encode(property_container).empty());
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("A confirmed property is placed behind properties exceeding the CBOR buffer size")
+  {
+    PropertyContainer property_container;
+
+    CloudString str[10];
+    char const * names[10] = {"str_0", "str_1", "str_2", "str_3", "str_4", "str_5", "str_6", "str_7", "str_8", "str_9"};
+    for (size_t i = 0; i < 10; i++) {
+      str[i] = "This string is 30 bytes long.";
+      addPropertyToContainer(property_container, str[i], names[i], Permission::ReadWrite);
+    }
+    getProperty(property_container, "str_9")->reliability(Reliability::Confirmed);
+
+    THEN("It is pending until it has been encoded into the first message")
+    {
+      REQUIRE(getProperty(property_container, "str_9")->getPriority() == Priority::High);
+      REQUIRE(isConfirmedUpdatePending(property_container));
+
+      std::vector<uint8_t> const actual_1 = cbor::encode(property_container);
+      REQUIRE(std::string(actual_1.begin() + 4, actual_1.begin() + 9) == "str_9");
+      REQUIRE_FALSE(isConfirmedUpdatePending(property_container));
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("Properties are packed into a buffer too small for all of them")
+  {
+    PropertyContainer property_container;
+
+    CloudString str_0; str_0 = "This string is 30 bytes long.";
+    CloudString str_1; str_1 = "This string is 30 bytes long.";
+    CloudString str_2; str_2 = "This string is far more than 60 bytes long and never fits the buffer.";
+    CloudBool   test = true;
+
+    addPropertyToContainer(property_container, str_0, "str_0", Permission::ReadWrite);
+    addPropertyToContainer(property_container, str_1, "str_1", Permission::ReadWrite);
+    addPropertyToContainer(property_container, str_2, "str_2", Permission::ReadWrite);
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+
+    uint8_t buf[60] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+
+    auto encode = [&]()
+    {
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index, false, 0, false, true) == CborNoError);
+      return std::vector<uint8_t>(buf, buf + bytes_encoded);
+    };
+
+    THEN("Smaller properties behind one which does not fit fill the remaining payload")
+    {
+      /* [{0: "str_0", 3: "This string is 30 bytes long."}, {0: "test", 4: true}] */
+      std::vector<uint8_t> const expected_1 = {0x9F, 0xA2, 0x00, 0x65, 0x73, 0x74, 0x72, 0x5F, 0x30, 0x03, 0x78, 0x1D, 0x54, 0x68, 0x69, 0x73, 0x20, 0x73, 0x74, 0x72, 0x69, 0x6E, 0x67, 0x20, 0x69, 0x73, 0x20, 0x33, 0x30, 0x20, 0x62, 0x79, 0x74, 0x65, 0x73, 0x20, 0x6C, 0x6F, 0x6E, 0x67, 0x2E, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x04, 0xF5, 0xFF};
+      REQUIRE(encode() == expected_1);
+      REQUIRE(current_property_index == 1);
+
+      /* [{0: "str_1", 3: "This string is 30 bytes long."}] */
+      std::vector<uint8_t> const expected_2 = {0x9F, 0xA2, 0x00, 0x65, 0x73, 0x74, 0x72, 0x5F, 0x31, 0x03, 0x78, 0x1D, 0x54, 0x68, 0x69, 0x73, 0x20, 0x73, 0x74, 0x72, 0x69, 0x6E, 0x67, 0x20, 0x69, 0x73, 0x20, 0x33, 0x30, 0x20, 0x62, 0x79, 0x74, 0x65, 0x73, 0x20, 0x6C, 0x6F, 0x6E, 0x67, 0x2E, 0xFF};
+      REQUIRE(encode() == expected_2);
+
+      /* The property which never fits is passed over without blocking the others */
+      REQUIRE(encode().empty());
+      REQUIRE(current_property_index == 0);
+    }
+  }
+
+  /************************************************************************************/
+
+  WHEN("Properties of known size are packed")
+  {
+    PropertyContainer property_container;
+
+    /* {0: "sX", 3: "..."} takes 7 bytes plus the string, 8 from 24 characters on */
+    CloudString s0; s0 = String("aaaaaaaaaaaaa");                  /* 20 bytes */
+    CloudString s1; s1 = String("bbbbbbbbbbbbbbbbbbbbbbb");        /* 30 bytes */
+    CloudString s2; s2 = String("ccccccccccccccccccccc");          /* 28 bytes */
+    CloudString s3; s3 = String("dddddddddddddddddddddddddddddd"); /* 38 bytes */
+
+    addPropertyToContainer(property_container, s0, "s0", Permission::ReadWrite);
+    addPropertyToContainer(property_container, s1, "s1", Permission::ReadWrite);
+    addPropertyToContainer(property_container, s2, "s2", Permission::ReadWrite);
+    addPropertyToContainer(property_container, s3, "s3", Permission::ReadWrite);
+
+    /* The sizes are known once the properties have been encoded */
+    set_millis(0);
+    cbor::encode(property_container);
+    set_millis(500);
+    s0 = String("AAAAAAAAAAAAA");
+    s1 = String("BBBBBBBBBBBBBBBBBBBBBBB");
+    s2 = String("CCCCCCCCCCCCCCCCCCCCC");
+    s3 = String("DDDDDDDDDDDDDDDDDDDDDDDDDDDDDD");
+
+    /* 58 bytes are left within the array */
+    uint8_t buf[60] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+
+    auto encode = [&]()
+    {
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index, false, 0, false, true) == CborNoError);
+      return std::vector<uint8_t>(buf, buf + bytes_encoded);
+    };
+
+    THEN("The largest ones are appended first and fewer messages are needed")
+    {
+      /* First fit in container order would need three: s0 + s1, s2, s3 */
+      std::vector<uint8_t> const msg_1 = encode();
+      REQUIRE(msg_1.size() == 60);
+      REQUIRE(msg_1[4] == 's'); REQUIRE(msg_1[5] == '3');
+      REQUIRE(msg_1[42] == 's'); REQUIRE(msg_1[43] == '0');
+
+      std::vector<uint8_t> const msg_2 = encode();
+      REQUIRE(msg_2.size() == 60);
+      REQUIRE(msg_2[5] == '1');
+      REQUIRE(msg_2[35] == '2');
+
+      REQUIRE(encode().empty());
+    }
+  }
+}
+
+/**************************************************************************************/
+
+/* Counts how often the property is encoded, including attempts which did not fit */
+class CountingCloudInt : public CloudInt
+{
+  public:
+    static unsigned int append_cnt;
+    CountingCloudInt & operator = (int const v) { CloudInt::operator=(v); return *this; }
+    virtual CborError appendAttributesToCloud(CborEncoder * encoder) override
+    {
+      append_cnt++;
+      return CloudInt::appendAttributesToCloud(encoder);
+    }
+};
+
+unsigned int CountingCloudInt::append_cnt = 0;
+
+SCENARIO("Properties exceeding the CBOR buffer size are split into messages in a single pass", "[ArduinoCloudThing::encode-3]")
+{
+  static size_t const PROPERTY_CNT = 20;
+  PropertyContainer property_container;
+  CountingCloudInt p[PROPERTY_CNT];
+  char names[PROPERTY_CNT][8];
+  for (size_t i = 0; i < PROPERTY_CNT; i++)
+  {
+    snprintf(names[i], sizeof(names[i]), "int_%02u", static_cast<unsigned int>(i));
+    p[i] = 1000 + static_cast<int>(i);
+    addPropertyToContainer(property_container, p[i], names[i], Permission::ReadWrite);
+  }
+  CountingCloudInt::append_cnt = 0;
+
+  WHEN("all properties are encoded into messages of 64 bytes")
+  {
+    uint8_t buf[64] = {0};
+    unsigned int current_property_index = 0;
+    size_t message_cnt = 0;
+    for (;;)
+    {
+      int bytes_encoded = 0;
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+      if (bytes_encoded == 0)
+        break;
+      REQUIRE(buf[bytes_encoded - 1] == 0xFF);
+      message_cnt++;
+    }
+
+    THEN("each property is encoded once, except for the one overflowing each message")
+    {
+      REQUIRE(message_cnt > 1);
+      REQUIRE(CountingCloudInt::append_cnt == PROPERTY_CNT + message_cnt - 1);
+      for (size_t i = 0; i < PROPERTY_CNT; i++)
+        REQUIRE(!p[i].isDifferentFromCloud());
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("A string property exceeding the CBOR buffer size is spilled", "[ArduinoCloudThing::encode-4]")
+{
+  PropertyContainer property_container;
+  CloudString str;
+  str = std::string(600, 'x');
+  CloudBool test = true;
+  addPropertyToContainer(property_container, str, "str", Permission::ReadWrite);
+  addPropertyToContainer(property_container, test, "test", Permission::ReadWrite);
+
+  /* [{0: "str", 3: "xxx...x"}, {0: "test", 4: true}] as encoded into a buffer large enough */
+  std::vector<uint8_t> expected;
+  {
+    PropertyContainer ref_container;
+    CloudString ref_str;
+    ref_str = std::string(600, 'x');
+    CloudBool ref_test = true;
+    addPropertyToContainer(ref_container, ref_str, "str", Permission::ReadWrite);
+    addPropertyToContainer(ref_container, ref_test, "test", Permission::ReadWrite);
+    uint8_t buf[1024] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+    REQUIRE(CBOREncoder::encode(ref_container, buf, sizeof(buf), bytes_encoded, current_property_index) == CborNoError);
+    expected.assign(buf, buf + bytes_encoded);
+  }
+
+  WHEN("it is encoded into a message of 256 bytes")
+  {
+    uint8_t buf[256] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+    SpilledString spill;
+    REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index, false, 0, false, false, false, &spill) == CborNoError);
+
+    THEN("the message refers to the string value in place of the placeholder")
+    {
+      REQUIRE(spill.property == &str);
+      REQUIRE(spill.length == 600);
+      REQUIRE(spill.placeholder >= buf);
+      REQUIRE(spill.placeholder < buf + bytes_encoded);
+      REQUIRE(*spill.placeholder == 0x60);
+
+      size_t const offset = spill.placeholder - buf;
+      uint8_t header[5];
+      size_t const header_len = CBOREncoder::encodeTextStringHeader(header, spill.length);
+      std::vector<uint8_t> actual(buf, buf + offset);
+      actual.insert(actual.end(), header, header + header_len);
+      actual.insert(actual.end(), spill.data, spill.data + spill.length);
+      actual.insert(actual.end(), buf + offset + 1, buf + bytes_encoded);
+      REQUIRE(actual == expected);
+      REQUIRE(!str.isDifferentFromCloud());
+    }
+  }
+
+  WHEN("it is encoded without spilling")
+  {
+    uint8_t buf[256] = {0};
+    int bytes_encoded = 0;
+    unsigned int current_property_index = 0;
+    THEN("it is passed over as before")
+    {
+      REQUIRE(CBOREncoder::encode(property_container, buf, sizeof(buf), bytes_encoded, current_property_index) != CborNoError);
+      REQUIRE(current_property_index == 1);
+    }
+  }
 }
@@ -0,0 +1,122 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+#include <AIoTC_Const.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Only the changed attributes of a composite property are encoded", "[ArduinoCloudThing::encode-changed-attributes]")
+{
+  PropertyContainer property_container;
+  set_millis(0);
+  cbor::encode(property_container);
+
+  WHEN("The brightness of a 'ColoredLight' changes after it has been sent")
+  {
+    CloudColoredLight light = CloudColoredLight(true, 2.0, 2.0, 2.0);
+    addPropertyToContainer(property_container, light, "test", Permission::ReadWrite);
+    REQUIRE(cbor::encode(property_container).size() != 0);
+
+    set_millis(1000);
+    light.setBrightness(3.0);
+
+    THEN("Only the brightness is encoded")
+    {
+      /* [{0: "test:bri", 2: 3.0}] = 9F A2 00 68 74 65 73 74 3A 62 72 69 02 FA 40 40 00 00 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x62, 0x72, 0x69, 0x02, 0xFA, 0x40, 0x40, 0x00, 0x00, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+    }
+  }
+
+  WHEN("The saturation of a 'Color' changes and the light payload is used")
+  {
+    CloudColor color = CloudColor(2.0, 2.0, 2.0);
+    addPropertyToContainer(property_container, color, "test", Permission::ReadWrite, 1);
+    REQUIRE(cbor::encode(property_container, true).size() != 0);
+
+    set_millis(1000);
+    color = Color(2.0, 3.0, 2.0);
+
+    THEN("The saturation keeps its attribute identifier")
+    {
+      /* [{0: 513, 2: 3.0}] = 9F A2 00 19 02 01 02 FA 40 40 00 00 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x19, 0x02, 0x01, 0x02, 0xFA, 0x40, 0x40, 0x00, 0x00, 0xFF};
+      REQUIRE(cbor::encode(property_container, true) == expected);
+    }
+  }
+
+  WHEN("The volume of a 'Television' changes")
+  {
+    CloudTelevision tv = CloudTelevision(true, 50, false, PlaybackCommands::Play, InputValue::TV, 7);
+    addPropertyToContainer(property_container, tv, "test", Permission::ReadWrite);
+    REQUIRE(cbor::encode(property_container).size() != 0);
+
+    set_millis(1000);
+    tv.setVolume(60);
+
+    THEN("Only the volume is encoded")
+    {
+      /* [{0: "test:vol", 2: 60}] = 9F A2 00 68 74 65 73 74 3A 76 6F 6C 02 18 3C FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x76, 0x6F, 0x6C, 0x02, 0x18, 0x3C, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+    }
+  }
+
+  WHEN("A composite property is encoded for the first time")
+  {
+    CloudSchedule schedule = CloudSchedule(1633305600, 1633651200, 600, 1140850708);
+    addPropertyToContainer(property_container, schedule, "test", Permission::ReadWrite);
+
+    THEN("All attributes are encoded")
+    {
+      /* frm, to, len and msk are all present */
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      std::string const payload(actual.begin(), actual.end());
+      REQUIRE(payload.find("test:frm") != std::string::npos);
+      REQUIRE(payload.find("test:to") != std::string::npos);
+      REQUIRE(payload.find("test:len") != std::string::npos);
+      REQUIRE(payload.find("test:msk") != std::string::npos);
+    }
+  }
+
+  WHEN("The start of a 'Schedule' changes")
+  {
+    CloudSchedule schedule = CloudSchedule(1633305600, 1633651200, 600, 1140850708);
+    addPropertyToContainer(property_container, schedule, "test", Permission::ReadWrite);
+    REQUIRE(cbor::encode(property_container).size() != 0);
+
+    set_millis(1000);
+    schedule = Schedule(1633309200, 1633651200, 600, 1140850708);
+
+    THEN("Only the start is encoded")
+    {
+      /* [{0: "test:frm", 2: 1633309200}] = 9F A2 00 68 74 65 73 74 3A 66 72 6D 02 1A 61 5A 52 10 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x68, 0x74, 0x65, 0x73, 0x74, 0x3A, 0x66, 0x72, 0x6D, 0x02, 0x1A, 0x61, 0x5A, 0x52, 0x10, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+    }
+  }
+
+  WHEN("An unchanged composite property is published periodically")
+  {
+    CloudColor color = CloudColor(2.0, 2.0, 2.0);
+    addPropertyToContainer(property_container, color, "test", Permission::ReadWrite, 1).publishEvery(1 * SECONDS);
+    std::vector<uint8_t> const first = cbor::encode(property_container, true);
+
+    set_millis(1000);
+
+    THEN("All attributes are encoded again")
+    {
+      REQUIRE(cbor::encode(property_container, true) == first);
+    }
+  }
+}
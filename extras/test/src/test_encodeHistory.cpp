@@ -0,0 +1,97 @@
+/*
+   Copyright (c) 2024 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+
+/**************************************************************************************
+   TEST HELPER
+ **************************************************************************************/
+
+static uint64_t history_time_ms = 0;
+
+static uint64_t getHistoryTimeMillis()
+{
+  return history_time_ms;
+}
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("The values a property changed to in between two messages are sent as a history", "[ArduinoCloudThing::encodeHistory]")
+{
+  Property::setTimeMillisFunc(getHistoryTimeMillis);
+
+  PropertyContainer property_container;
+  CloudInt h = 0;
+  addPropertyToContainer(property_container, h, "h", Permission::ReadWrite).publishOnChange(0, 500);
+  h.encodeHistory(3);
+
+  set_millis(0);
+  /* [{0: "h", 2: 0}] = 9F A2 00 61 68 02 00 FF */
+  std::vector<uint8_t> const initial = {0x9F, 0xA2, 0x00, 0x61, 0x68, 0x02, 0x00, 0xFF};
+  REQUIRE(cbor::encode(property_container) == initial);
+
+  WHEN("More values are assigned within the rate limit than the history holds")
+  {
+    for (int v = 1; v <= 4; v++) {
+      history_time_ms = 100000 + (v * 1000);
+      h = v;
+    }
+    set_millis(100);
+    REQUIRE(cbor::encode(property_container).size() == 0);
+    set_millis(500);
+
+    THEN("The latest values are encoded in order as timestamped records of one message") {
+      /* [{0: "h", 2: 2, 6: 102}, {0: "h", 2: 3, 6: 103}, {0: "h", 2: 4, 6: 104}] */
+      std::vector<uint8_t> const expected = {0x9F,
+                                             0xA3, 0x00, 0x61, 0x68, 0x02, 0x02, 0x06, 0x18, 0x66,
+                                             0xA3, 0x00, 0x61, 0x68, 0x02, 0x03, 0x06, 0x18, 0x67,
+                                             0xA3, 0x00, 0x61, 0x68, 0x02, 0x04, 0x06, 0x18, 0x68,
+                                             0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+      REQUIRE(cbor::encode(property_container).size() == 0);
+    }
+  }
+
+  WHEN("A value is assigned again and then changed back")
+  {
+    history_time_ms = 101000;
+    h = 1;
+    history_time_ms = 102000;
+    h = 1;
+    history_time_ms = 103000;
+    h = 0;
+    set_millis(500);
+
+    THEN("Each change is kept once, including the one back to the value sent") {
+      /* [{0: "h", 2: 1, 6: 101}, {0: "h", 2: 0, 6: 103}] */
+      std::vector<uint8_t> const expected = {0x9F,
+                                             0xA3, 0x00, 0x61, 0x68, 0x02, 0x01, 0x06, 0x18, 0x65,
+                                             0xA3, 0x00, 0x61, 0x68, 0x02, 0x00, 0x06, 0x18, 0x67,
+                                             0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+    }
+  }
+
+  WHEN("The cloud changes the value while changes are kept")
+  {
+    history_time_ms = 101000;
+    h = 1;
+    h.fromCloudToLocal();
+    set_millis(500);
+
+    THEN("The kept changes are dropped") {
+      REQUIRE(cbor::encode(property_container).size() == 0);
+    }
+  }
+
+  Property::setTimeMillisFunc(nullptr);
+}
@@ -0,0 +1,102 @@
+/*
+   Copyright (c) 2023 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <PropertyContainer.h>
+
+#include <types/CloudInt.h>
+#include <types/CloudBool.h>
+#include <types/CloudFloat.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Arduino Cloud Properties are retrieved from the container", "[ArduinoCloudThing::getProperty]")
+{
+  PropertyContainer property_container;
+
+  CloudInt   int_property   = 1;
+  CloudBool  bool_property  = false;
+  CloudFloat float_property = 1.0f;
+
+  addPropertyToContainer(property_container, int_property,   "zeta",  Permission::ReadWrite, 3);
+  addPropertyToContainer(property_container, bool_property,  "alpha", Permission::ReadWrite, 1);
+  addPropertyToContainer(property_container, float_property, "mu",    Permission::ReadWrite, 2);
+
+  WHEN("A property is looked up by name")
+  {
+    THEN("The matching property is returned") {
+      REQUIRE(getProperty(property_container, "alpha") == &bool_property);
+      REQUIRE(getProperty(property_container, "mu")    == &float_property);
+      REQUIRE(getProperty(property_container, "zeta")  == &int_property);
+    }
+    THEN("A nullptr is returned for an unknown name") {
+      REQUIRE(getProperty(property_container, "beta") == nullptr);
+      REQUIRE(getProperty(property_container, "")     == nullptr);
+    }
+  }
+
+  WHEN("A property is looked up by identifier")
+  {
+    THEN("The matching property is returned") {
+      REQUIRE(getProperty(property_container, 1) == &bool_property);
+      REQUIRE(getProperty(property_container, 2) == &float_property);
+      REQUIRE(getProperty(property_container, 3) == &int_property);
+      REQUIRE(getPropertyNameByIdentifier(property_container, 2) == "mu");
+    }
+    THEN("A nullptr is returned for an unknown identifier") {
+      REQUIRE(getProperty(property_container, 0) == nullptr);
+      REQUIRE(getProperty(property_container, 4) == nullptr);
+    }
+  }
+
+  WHEN("The container is iterated")
+  {
+    THEN("The properties are returned in insertion order") {
+      PropertyContainer::iterator iter = property_container.begin();
+      REQUIRE(*iter++ == &int_property);
+      REQUIRE(*iter++ == &bool_property);
+      REQUIRE(*iter++ == &float_property);
+      REQUIRE(iter == property_container.end());
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("Arduino Cloud Properties are added to a full container", "[ArduinoCloudThing::PropertyContainer::add]")
+{
+  PropertyContainer property_container;
+  CloudInt int_property[PropertyContainer::CAPACITY + 1];
+
+  for (size_t i = 0; i < PropertyContainer::CAPACITY; i++)
+    REQUIRE(property_container.add(&int_property[i]));
+
+  WHEN("One more property is added")
+  {
+    THEN("The property is rejected and the container is left untouched") {
+      REQUIRE(property_container.full());
+      REQUIRE_FALSE(property_container.add(&int_property[PropertyContainer::CAPACITY]));
+      REQUIRE(property_container.size() == PropertyContainer::CAPACITY);
+    }
+  }
+
+  WHEN("One more property is added by name")
+  {
+    Property & p = addPropertyToContainer(property_container, int_property[PropertyContainer::CAPACITY], "int_property", Permission::ReadWrite);
+
+    THEN("The property is returned but not attached to the container") {
+      REQUIRE(&p == &int_property[PropertyContainer::CAPACITY]);
+      REQUIRE_FALSE(p.isAttachedToContainer());
+      REQUIRE(getProperty(property_container, "int_property") == nullptr);
+      REQUIRE(property_container.size() == PropertyContainer::CAPACITY);
+    }
+  }
+}
@@ -0,0 +1,79 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+#include <AIoTC_Const.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Predicting when the next property update is due", "[millisUntilNextUpdate]")
+{
+  PropertyContainer property_container;
+
+  WHEN("The container is empty")
+  {
+    THEN("Nothing is pending")
+    {
+      REQUIRE(millisUntilNextUpdate(property_container, 0) == ULONG_MAX);
+    }
+  }
+
+  WHEN("A property is published periodically")
+  {
+    set_millis(0);
+    CloudBool test = true;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishEvery(1 * SECONDS);
+
+    THEN("It is due right away before it has been sent once")
+    {
+      REQUIRE(millisUntilNextUpdate(property_container, 0) == 0);
+    }
+    THEN("It is due again once its interval expired")
+    {
+      cbor::encode(property_container);
+      cbor::encode(property_container);
+      set_millis(400);
+      REQUIRE(millisUntilNextUpdate(property_container, 400) == 600);
+    }
+  }
+
+  WHEN("A change of a property is held back by the rate limit")
+  {
+    set_millis(0);
+    CloudInt test = 0;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(0.0f, 500);
+    cbor::encode(property_container);
+    cbor::encode(property_container);
+
+    THEN("An unchanged property is not pending")
+    {
+      REQUIRE(millisUntilNextUpdate(property_container, 100) == ULONG_MAX);
+    }
+    THEN("A changed property is due once the rate limit expired")
+    {
+      test = 1;
+      REQUIRE(millisUntilNextUpdate(property_container, 100) == 400);
+      REQUIRE(millisUntilNextUpdate(property_container, 700) == 0);
+    }
+  }
+
+  WHEN("A property is not readable by the cloud")
+  {
+    CloudBool test = true;
+    addPropertyToContainer(property_container, test, "test", Permission::Write);
+
+    THEN("It is never pending")
+    {
+      REQUIRE(millisUntilNextUpdate(property_container, 0) == ULONG_MAX);
+    }
+  }
+}
@@ -0,0 +1,98 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+#include <Aggregation.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Samples are aggregated incrementally", "[Aggregator]")
+{
+  int const samples[] = {4, -2, 9, 3};
+
+  WHEN("No sample has been added")
+  {
+    Aggregator<int, int64_t> aggregator(Aggregation::Mean);
+    THEN("The aggregator is empty") {
+      REQUIRE(aggregator.empty());
+    }
+  }
+
+  WHEN("Samples are added")
+  {
+    Aggregator<int, int64_t> last(Aggregation::Last), mean(Aggregation::Mean), min(Aggregation::Min), max(Aggregation::Max);
+    for (int const s : samples) {
+      last.add(s);
+      mean.add(s);
+      min.add(s);
+      max.add(s);
+    }
+    THEN("The aggregate is computed over all of them") {
+      REQUIRE(last.count() == 4);
+      REQUIRE(last.value() == 3);
+      REQUIRE(mean.value() == 3);
+      REQUIRE(min.value() == -2);
+      REQUIRE(max.value() == 9);
+    }
+
+    WHEN("The aggregator is reset")
+    {
+      min.reset();
+      min.add(5);
+      THEN("The next window starts from scratch") {
+        REQUIRE(min.count() == 1);
+        REQUIRE(min.value() == 5);
+      }
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("A CloudFloat property publishes the mean of a window", "[ArduinoCloudThing::publishAggregated]")
+{
+  PropertyContainer property_container;
+
+  CloudFloat test = 0.0f;
+  addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(0.0f, 0);
+  test.publishAggregated(Aggregation::Mean, 1);
+
+  WHEN("Several values are assigned within the window")
+  {
+    set_millis(0);
+    test = 1.0f;
+    test = 2.0f;
+    test = 6.0f;
+
+    THEN("Their mean is encoded instead of the current value") {
+      /* [{0: "test", 2: 3.0}] = 9F A2 00 64 74 65 73 74 02 FA 40 40 00 00 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xFA, 0x40, 0x40, 0x00, 0x00, 0xFF};
+      std::vector<uint8_t> const actual = cbor::encode(property_container);
+      REQUIRE(actual == expected);
+      REQUIRE(test == 6.0f);
+
+      WHEN("Values are assigned within the next window")
+      {
+        set_millis(1000);
+        test = 10.0f;
+        test = 20.0f;
+
+        THEN("Only the values of the new window are aggregated") {
+          /* [{0: "test", 2: 15.0}] = 9F A2 00 64 74 65 73 74 02 FA 41 70 00 00 FF */
+          std::vector<uint8_t> const expected_2 = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0xFA, 0x41, 0x70, 0x00, 0x00, 0xFF};
+          std::vector<uint8_t> const actual_2 = cbor::encode(property_container);
+          REQUIRE(actual_2 == expected_2);
+        }
+      }
+    }
+  }
+}
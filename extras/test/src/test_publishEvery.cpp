@@ -55,3 +55,44 @@ SCENARIO("A Arduino cloud property is published periodically", "[ArduinoCloudThi
     }
   }
 }
+
+/**************************************************************************************/
+
+SCENARIO("Periodically published Arduino cloud properties are scheduled by deadline", "[ArduinoCloudThing::publishEvery]")
+{
+  PropertyContainer property_container;
+
+  CloudBool  test_1 = true;
+  CloudFloat test_2 = 1.0f;
+
+  addPropertyToContainer(property_container, test_1, "test_1", Permission::ReadWrite).publishEvery(2 * SECONDS);
+  addPropertyToContainer(property_container, test_2, "test_2", Permission::ReadWrite).publishEvery(1 * SECONDS);
+
+  WHEN("t = 0 ms, both properties are encoded for the 1st time, t = 500 ms, 'encode' is called again") {
+    set_millis(0);
+    cbor::encode(property_container);
+    set_millis(500);
+    cbor::encode(property_container);
+
+    THEN("Both properties are scheduled and not dirty") {
+      unsigned long deadline = 0;
+      REQUIRE_FALSE(property_container.isDirty(0));
+      REQUIRE_FALSE(property_container.isDirty(1));
+      REQUIRE(property_container.nextDeadline(deadline));
+      REQUIRE(deadline == 1000);
+    }
+
+    WHEN("t = 1000 ms") {
+      set_millis(1000);
+      THEN("Only the property with the expired deadline is encoded") {
+        /* [{0: "test_2", 2: 1.0}] = 9F A2 00 66 74 65 73 74 5F 32 02 FA 3F 80 00 00 FF */
+        std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x5F, 0x32, 0x02, 0xFA, 0x3F, 0x80, 0x00, 0x00, 0xFF};
+        std::vector<uint8_t> const actual = cbor::encode(property_container);
+        REQUIRE(actual == expected);
+        unsigned long deadline = 0;
+        REQUIRE(property_container.nextDeadline(deadline));
+        REQUIRE(deadline == 2000);
+      }
+    }
+  }
+}
@@ -41,3 +41,97 @@ SCENARIO("An Arduino cloud property is published on value change", "[ArduinoClou
     }
   }
 }
+
+SCENARIO("An integer property is compared against its minimum delta without float arithmetic", "[ArduinoCloudThing::publishOnChange]")
+{
+  PropertyContainer property_container;
+
+  WHEN("The delta has a fraction")
+  {
+    CloudInt test = 0;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(2.5f);
+    REQUIRE(cbor::encode(property_container).size() != 0);
+
+    THEN("A change by the delta rounded down is not published, one by the delta rounded up is")
+    {
+      test = -2;
+      REQUIRE(cbor::encode(property_container).size() == 0);
+      test = -3;
+      REQUIRE(cbor::encode(property_container).size() != 0);
+    }
+  }
+
+  WHEN("The values exceed the precision of a float")
+  {
+    CloudUnsignedInt test = 16777216;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(2);
+    REQUIRE(cbor::encode(property_container).size() != 0);
+
+    THEN("A change by one less than the delta is not published")
+    {
+      test = 16777217;
+      REQUIRE(cbor::encode(property_container).size() == 0);
+      test = 16777218;
+      REQUIRE(cbor::encode(property_container).size() != 0);
+    }
+  }
+
+  WHEN("The values are far apart")
+  {
+    CloudInt test = -2147483647;
+    addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(100);
+    REQUIRE(cbor::encode(property_container).size() != 0);
+
+    THEN("Their difference does not overflow")
+    {
+      test = 2147483647;
+      REQUIRE(cbor::encode(property_container).size() != 0);
+    }
+  }
+}
+
+SCENARIO("A property is published once it leaves the deadband around the value sent last", "[ArduinoCloudThing::publishOnChange]")
+{
+  PropertyContainer property_container;
+
+  CloudFloat test = 20.0f;
+  addPropertyToContainer(property_container, test, "test", Permission::Read).publishOutsideDeadband(0.5f, 2.0f);
+  REQUIRE(cbor::encode(property_container).size() != 0);
+
+  WHEN("The value rises by less than the rising delta")
+  {
+    test = 21.5f;
+    THEN("It is not published")
+    {
+      REQUIRE(cbor::encode(property_container).size() == 0);
+    }
+  }
+
+  WHEN("The value falls by the falling delta")
+  {
+    test = 19.5f;
+    THEN("It is published")
+    {
+      REQUIRE(cbor::encode(property_container).size() != 0);
+    }
+  }
+
+  WHEN("The deadband of an integer property is set and then reset")
+  {
+    CloudInt level = 100;
+    Property & p = addPropertyToContainer(property_container, level, "level", Permission::Read).publishOutsideDeadband(1, 10);
+    cbor::encode(property_container);
+    cbor::encode(property_container);
+
+    THEN("The falling delta applies until the symmetric delta replaces it")
+    {
+      level = 99;
+      REQUIRE(cbor::encode(property_container).size() != 0);
+      p.publishOnChange(10);
+      level = 90;
+      REQUIRE(cbor::encode(property_container).size() == 0);
+      level = 89;
+      REQUIRE(cbor::encode(property_container).size() != 0);
+    }
+  }
+}
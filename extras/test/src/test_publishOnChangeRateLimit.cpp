@@ -59,3 +59,84 @@ SCENARIO("An Arduino cloud property is published on value change but the update
     }
   }
 }
+
+/**************************************************************************************/
+
+SCENARIO("Changed Arduino cloud properties are requested for a batch update regardless of the update rate limit", "[ArduinoCloudThing::publishOnChange]")
+{
+  PropertyContainer property_container;
+
+  CloudInt test_1 = 0;
+  CloudInt test_2 = 0;
+  unsigned long const MIN_TIME_BETWEEN_UPDATES_ms = 500;
+
+  addPropertyToContainer(property_container, test_1, "test_1", Permission::ReadWrite).publishOnChange(0, MIN_TIME_BETWEEN_UPDATES_ms);
+  addPropertyToContainer(property_container, test_2, "test_2", Permission::ReadWrite).publishOnChange(0, MIN_TIME_BETWEEN_UPDATES_ms);
+
+  set_millis(0);
+  REQUIRE(cbor::encode(property_container).size() != 0);
+
+  WHEN("t = 100 ms, one property modified and a batch update requested") {
+    test_1++;
+    set_millis(100);
+    requestUpdateForChangedProperties(property_container);
+    THEN("'encode' should encode only the modified property") {
+      /* [{0: "test_1", 2: 1}] = 9F A2 00 66 74 65 73 74 5F 31 02 01 FF */
+      std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x66, 0x74, 0x65, 0x73, 0x74, 0x5F, 0x31, 0x02, 0x01, 0xFF};
+      REQUIRE(cbor::encode(property_container) == expected);
+      REQUIRE(cbor::encode(property_container).size() == 0);
+    }
+  }
+}
+
+/**************************************************************************************/
+
+SCENARIO("The last change held back by the update rate limit is published once the window closed", "[ArduinoCloudThing::publishOnChange]")
+{
+  PropertyContainer property_container;
+
+  CloudInt test = 0;
+  unsigned long const MIN_TIME_BETWEEN_UPDATES_ms = 500;
+
+  addPropertyToContainer(property_container, test, "test", Permission::ReadWrite).publishOnChange(0, MIN_TIME_BETWEEN_UPDATES_ms);
+
+  set_millis(0);
+  REQUIRE(cbor::encode(property_container).size() != 0);
+
+  WHEN("t = 100 ms and t = 200 ms, property modified twice within the window") {
+    set_millis(100);
+    test = 1;
+    REQUIRE(cbor::encode(property_container).size() == 0);
+    set_millis(200);
+    test = 2;
+    REQUIRE(cbor::encode(property_container).size() == 0);
+
+    THEN("The held back change is scheduled for the end of the window instead of being polled") {
+      REQUIRE_FALSE(property_container.isDirty(0));
+      REQUIRE(millisUntilNextUpdate(property_container, 200) == 300);
+
+      WHEN("t = 500 ms") {
+        set_millis(500);
+        THEN("'encode' should encode the last value only once") {
+          /* [{0: "test", 2: 2}] = 9F A2 00 64 74 65 73 74 02 02 FF */
+          std::vector<uint8_t> const expected = {0x9F, 0xA2, 0x00, 0x64, 0x74, 0x65, 0x73, 0x74, 0x02, 0x02, 0xFF};
+          REQUIRE(cbor::encode(property_container) == expected);
+          REQUIRE(cbor::encode(property_container).size() == 0);
+          REQUIRE(millisUntilNextUpdate(property_container, 500) == ULONG_MAX);
+        }
+      }
+    }
+  }
+
+  WHEN("The property is modified back to the published value within the window") {
+    set_millis(100);
+    test = 1;
+    REQUIRE(cbor::encode(property_container).size() == 0);
+    test = 0;
+    set_millis(500);
+    THEN("'encode' should not encode any property") {
+      REQUIRE(cbor::encode(property_container).size() == 0);
+      REQUIRE(millisUntilNextUpdate(property_container, 500) == ULONG_MAX);
+    }
+  }
+}
@@ -0,0 +1,99 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <catch.hpp>
+
+#include <util/CBORTestUtil.h>
+
+/**************************************************************************************
+   TEST CODE
+ **************************************************************************************/
+
+SCENARIO("Properties are updated from an interrupt", "[ArduinoCloudThing::setFromISR]")
+{
+  PropertyContainer property_container;
+
+  CloudCounter presses = 0;
+  CloudBool    alarm = false;
+  CloudInt     level = 7;
+
+  addPropertyToContainer(property_container, presses, "presses", Permission::Read).acceptUpdatesFromISR();
+  addPropertyToContainer(property_container, alarm, "alarm", Permission::Read).acceptUpdatesFromISR();
+  addPropertyToContainer(property_container, level, "level", Permission::Read);
+
+  cbor::encode(property_container);
+  cbor::encode(property_container);
+
+  WHEN("Nothing has been posted from an interrupt")
+  {
+    THEN("The container is not pending")
+    {
+      REQUIRE(property_container.isPendingFromISR() == false);
+    }
+  }
+
+  WHEN("A counter is incremented several times from an interrupt")
+  {
+    presses.addFromISR(1);
+    presses.addFromISR(1);
+    presses.addFromISR(1);
+
+    THEN("The value is only merged by the next update")
+    {
+      REQUIRE(presses == 0);
+      REQUIRE(property_container.isPendingFromISR() == true);
+      REQUIRE(millisUntilNextUpdate(property_container, millis()) == 0);
+      REQUIRE_FALSE(property_container.isDirty(0));
+
+      updateTimestampOnLocallyChangedProperties(property_container);
+
+      REQUIRE(presses == 3);
+      REQUIRE(property_container.isDirty(0));
+      REQUIRE(property_container.isPendingFromISR() == false);
+    }
+
+    WHEN("The counter is incremented again after the merge")
+    {
+      updateTimestampOnLocallyChangedProperties(property_container);
+      presses.addFromISR(2);
+      updateTimestampOnLocallyChangedProperties(property_container);
+
+      THEN("Only the new delta is added")
+      {
+        REQUIRE(presses == 5);
+      }
+    }
+  }
+
+  WHEN("A value is set and deltas are added from an interrupt")
+  {
+    presses.setFromISR(10);
+    presses.addFromISR(2);
+    alarm.setFromISR(true);
+    updateTimestampOnLocallyChangedProperties(property_container);
+
+    THEN("The deltas are added to the value set")
+    {
+      REQUIRE(presses == 12);
+      REQUIRE(alarm == true);
+      REQUIRE(property_container.isDirty(1));
+    }
+  }
+
+  WHEN("A property which does not accept updates from an interrupt is posted to")
+  {
+    level.setFromISR(3);
+    updateTimestampOnLocallyChangedProperties(property_container);
+
+    THEN("The value is ignored")
+    {
+      REQUIRE(level == 7);
+      REQUIRE(property_container.isPendingFromISR() == false);
+    }
+  }
+}
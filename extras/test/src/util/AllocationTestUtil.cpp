@@ -0,0 +1,127 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <util/AllocationTestUtil.h>
+
+#include <malloc.h>
+
+/**************************************************************************************
+   EXTERN
+ **************************************************************************************/
+
+extern "C" void * __libc_malloc(size_t size);
+extern "C" void * __libc_calloc(size_t nmemb, size_t size);
+extern "C" void * __libc_realloc(void * ptr, size_t size);
+extern "C" void   __libc_free(void * ptr);
+
+/**************************************************************************************
+   GLOBAL VARIABLES
+ **************************************************************************************/
+
+/* Plain thread locals, they must not allocate themselves */
+static thread_local bool   is_counting = false;
+static thread_local size_t allocation_cnt = 0;
+static thread_local long   live_bytes = 0;
+static thread_local long   peak_bytes = 0;
+
+/**************************************************************************************
+   PRIVATE FUNCTIONS
+ **************************************************************************************/
+
+static void onAllocate(void * ptr)
+{
+  if (!is_counting || !ptr)
+    return;
+  allocation_cnt++;
+  live_bytes += static_cast<long>(malloc_usable_size(ptr));
+  if (live_bytes > peak_bytes)
+    peak_bytes = live_bytes;
+}
+
+static void onFree(void * ptr)
+{
+  if (!is_counting || !ptr)
+    return;
+  live_bytes -= static_cast<long>(malloc_usable_size(ptr));
+}
+
+/**************************************************************************************
+   INTERPOSED FUNCTIONS
+ **************************************************************************************/
+
+extern "C" void * malloc(size_t size)
+{
+  void * ptr = __libc_malloc(size);
+  onAllocate(ptr);
+  return ptr;
+}
+
+extern "C" void * calloc(size_t nmemb, size_t size)
+{
+  void * ptr = __libc_calloc(nmemb, size);
+  onAllocate(ptr);
+  return ptr;
+}
+
+extern "C" void * realloc(void * ptr, size_t size)
+{
+  size_t const old_size = ptr ? malloc_usable_size(ptr) : 0;
+  void * new_ptr = __libc_realloc(ptr, size);
+  /* A failed realloc() leaves the original block in place */
+  if (is_counting && (new_ptr || !size))
+    live_bytes -= static_cast<long>(old_size);
+  onAllocate(new_ptr);
+  return new_ptr;
+}
+
+extern "C" void free(void * ptr)
+{
+  onFree(ptr);
+  __libc_free(ptr);
+}
+
+/**************************************************************************************
+   CTOR/DTOR
+ **************************************************************************************/
+
+AllocationCounter::AllocationCounter()
+{
+  reset();
+  is_counting = true;
+}
+
+AllocationCounter::~AllocationCounter()
+{
+  is_counting = false;
+}
+
+/**************************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void AllocationCounter::reset()
+{
+  allocation_cnt = 0;
+  live_bytes = 0;
+  peak_bytes = 0;
+}
+
+size_t AllocationCounter::count() const
+{
+  return allocation_cnt;
+}
+
+size_t AllocationCounter::peakBytes() const
+{
+  return static_cast<size_t>(peak_bytes);
+}
+
+size_t AllocationCounter::liveBytes() const
+{
+  return live_bytes > 0 ? static_cast<size_t>(live_bytes) : 0;
+}
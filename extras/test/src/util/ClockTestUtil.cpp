@@ -0,0 +1,75 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <util/ClockTestUtil.h>
+
+/**************************************************************************************
+   GLOBAL VARIABLES
+ **************************************************************************************/
+
+static uint64_t now_us = 0;
+/* POSIX time at now_us = 0 in microseconds, 0 if unknown */
+static uint64_t epoch_at_start_us = 0;
+
+/**************************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void VirtualClock::reset(unsigned long const epoch)
+{
+  now_us = 0;
+  epoch_at_start_us = static_cast<uint64_t>(epoch) * 1000000;
+}
+
+uint64_t VirtualClock::now()
+{
+  return now_us;
+}
+
+void VirtualClock::set(uint64_t const time_us)
+{
+  now_us = time_us;
+}
+
+void VirtualClock::advanceTo(uint64_t const time_us)
+{
+  if (time_us > now_us)
+    now_us = time_us;
+}
+
+void VirtualClock::advance(unsigned long const ms)
+{
+  advanceMicros(static_cast<uint64_t>(ms) * 1000);
+}
+
+void VirtualClock::advanceMicros(uint64_t const us)
+{
+  now_us += us;
+}
+
+unsigned long VirtualClock::getTime()
+{
+  if (epoch_at_start_us == 0)
+    return 0;
+  return static_cast<unsigned long>((epoch_at_start_us + now_us) / 1000000);
+}
+
+void VirtualClock::setTime(unsigned long const epoch)
+{
+  epoch_at_start_us = static_cast<uint64_t>(epoch) * 1000000 - now_us;
+}
+
+void VirtualClock::run(unsigned long const ms, unsigned long const step_ms, std::function<void()> poll)
+{
+  uint64_t const end_us = now_us + static_cast<uint64_t>(ms) * 1000;
+  while (now_us < end_us)
+  {
+    poll();
+    advanceTo(now_us + static_cast<uint64_t>(step_ms) * 1000);
+  }
+}
@@ -7,6 +7,7 @@
  **************************************************************************************/
 
 #include <util/PropertyTestUtil.h>
+#include <util/ClockTestUtil.h>
 #include <Arduino.h>
 #include <TimeService.h>
 
@@ -16,5 +17,5 @@
 
 unsigned long getTime()
 {
-  return 0;
+  return VirtualClock::getTime();
 }
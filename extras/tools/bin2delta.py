@@ -0,0 +1,73 @@
+#!/usr/bin/python3
+
+import sys
+import hashlib
+
+if len(sys.argv) != 4:
+    print ("Usage: bin2delta.py old_sketch.bin sketch.bin sketch.delta")
+    sys.exit()
+
+old_file = sys.argv[1]
+new_file = sys.argv[2]
+ofile    = sys.argv[3]
+
+CHUNK_SIZE = 64   # FlashSHA256::FLASH_READ_CHUNK_SIZE
+KEY_SIZE   = 8    # Bytes used to look up matches within the old image
+MIN_COPY   = 16   # Shorter matches are cheaper to insert
+OP_COPY    = 0x01
+OP_INSERT  = 0x02
+
+def flash_image(data):
+    # Same end of the image as found by FlashSHA256::calc on the device:
+    # the chunk preceding the first erased one, without its trailing 0xFF.
+    padded = data + b'\xff' * (2 * CHUNK_SIZE - len(data) % CHUNK_SIZE)
+    for offset in range(0, len(padded) - CHUNK_SIZE, CHUNK_SIZE):
+        if padded[offset + CHUNK_SIZE:offset + 2 * CHUNK_SIZE] == b'\xff' * CHUNK_SIZE:
+            return padded[:offset + CHUNK_SIZE].rstrip(b'\xff')
+    return data
+
+def u32(value):
+    return value.to_bytes(4, byteorder='little')
+
+with open(old_file, "rb") as f:
+    old = flash_image(f.read())
+with open(new_file, "rb") as f:
+    new = f.read()
+
+# Index the old image, only the last few occurrences of a key are kept
+index = {}
+for i in range(len(old) - KEY_SIZE + 1):
+    index.setdefault(old[i:i + KEY_SIZE], []).append(i)
+    if len(index[old[i:i + KEY_SIZE]]) > 8:
+        index[old[i:i + KEY_SIZE]].pop(0)
+
+delta = bytearray(b'ADLT' + hashlib.sha256(old).digest() + u32(len(new)))
+literal = bytearray()
+
+def flush_literal():
+    if literal:
+        delta.extend(bytes([OP_INSERT]) + u32(len(literal)) + literal)
+        literal.clear()
+
+pos = 0
+while pos < len(new):
+    best_offset, best_len = 0, 0
+    for candidate in index.get(new[pos:pos + KEY_SIZE], []):
+        length = 0
+        while pos + length < len(new) and candidate + length < len(old) and new[pos + length] == old[candidate + length]:
+            length += 1
+        if length > best_len:
+            best_offset, best_len = candidate, length
+    if best_len >= MIN_COPY:
+        flush_literal()
+        delta.extend(bytes([OP_COPY]) + u32(best_offset) + u32(best_len))
+        pos += best_len
+    else:
+        literal.append(new[pos])
+        pos += 1
+flush_literal()
+
+with open(ofile, "wb") as f:
+    f.write(delta)
+
+print ("delta: %d bytes (%d%% of %d bytes)" % (len(delta), (len(delta) * 100) // max(len(new), 1), len(new)))
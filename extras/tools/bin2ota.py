@@ -1,57 +1,60 @@
 #!/usr/bin/python3
 
 import sys
-import crccheck
-
-if len(sys.argv) != 4:
-    print ("Usage: bin2ota.py BOARD sketch.bin sketch.ota")
-    print ("  BOARD = [ MKR_WIFI_1010 | NANO_33_IOT | PORTENTA_H7_M7 | NANO_RP2040_CONNECT | NICLA_VISION | OPTA | GIGA ]")
-    sys.exit()
-
-board = sys.argv[1]
-ifile = sys.argv[2]
-ofile = sys.argv[3]
-
-# Read the binary file
-in_file = open(ifile, "rb")
-bin_data = bytearray(in_file.read())
-in_file.close()
+import zlib
 
 # Magic number (VID/PID)
-if board == "MKR_WIFI_1010":
-    magic_number = 0x23418054.to_bytes(4,byteorder='little')
-elif board == "NANO_33_IOT":
-    magic_number = 0x23418057.to_bytes(4,byteorder='little')
-elif board == "PORTENTA_H7_M7":
-    magic_number = 0x2341025B.to_bytes(4,byteorder='little')
-elif board == "NANO_RP2040_CONNECT":
-    magic_number = 0x2341005E.to_bytes(4,byteorder='little')
-elif board == "NICLA_VISION":
-    magic_number = 0x2341025F.to_bytes(4,byteorder='little')
-elif board == "OPTA":
-    magic_number = 0x23410064.to_bytes(4,byteorder='little')
-elif board == "GIGA":
-    magic_number = 0x23410266.to_bytes(4,byteorder='little')
-# Magic number for all ESP32 boards not related to (VID/PID)
-elif board == "ESP32":
-    magic_number = 0x45535033.to_bytes(4,byteorder='little')
-else:
-    print ("Error,", board, "is not a supported board type")
-    sys.exit()
-
-# Version field (byte array of size 8) - all 0 except the compression flag set.
-version = bytearray([0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40])
-
-# Prepend magic number and version field to payload
-bin_data_complete = magic_number + version + bin_data
-
-# Calculate length and CRC32
-bin_data_len = len(bin_data_complete)
-bin_data_crc = crccheck.crc.Crc32.calc(bin_data_complete)
-
-# Write to outfile
-out_file = open(ofile, "wb")
-out_file.write((bin_data_len).to_bytes(4,byteorder='little'))
-out_file.write((bin_data_crc).to_bytes(4,byteorder='little'))
-out_file.write(bin_data_complete)
-out_file.close()
+MAGIC_NUMBERS = {
+    "MKR_WIFI_1010":       0x23418054,
+    "NANO_33_IOT":         0x23418057,
+    "PORTENTA_H7_M7":      0x2341025B,
+    "NANO_RP2040_CONNECT": 0x2341005E,
+    "NICLA_VISION":        0x2341025F,
+    "OPTA":                0x23410064,
+    "GIGA":                0x23410266,
+    # Magic number for all ESP32 boards not related to (VID/PID)
+    "ESP32":               0x45535033,
+}
+
+CHUNK_SIZE = 64 * 1024
+
+def bin2ota(board, ifile, ofile, is_delta=False):
+    magic_number = MAGIC_NUMBERS[board].to_bytes(4,byteorder='little')
+
+    # Version field (byte array of size 8) - all 0 except the compression flag set
+    # and the delta flag if the payload is a delta produced by bin2delta.py.
+    version = bytearray([0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60 if is_delta else 0x40])
+
+    # The payload is copied and its CRC32 computed in a single pass, length
+    # and CRC32 are filled in once the whole payload is known.
+    prefix = magic_number + version
+    bin_data_len = len(prefix)
+    bin_data_crc = zlib.crc32(prefix)
+    with open(ifile, "rb") as in_file, open(ofile, "wb") as out_file:
+        out_file.write(bytes(8))
+        out_file.write(prefix)
+        for chunk in iter(lambda: in_file.read(CHUNK_SIZE), b''):
+            bin_data_len += len(chunk)
+            bin_data_crc = zlib.crc32(chunk, bin_data_crc)
+            out_file.write(chunk)
+        out_file.seek(0)
+        out_file.write((bin_data_len).to_bytes(4,byteorder='little'))
+        out_file.write((bin_data_crc).to_bytes(4,byteorder='little'))
+
+if __name__ == "__main__":
+    is_delta = len(sys.argv) == 5 and sys.argv[4] == "--delta"
+
+    if len(sys.argv) != 4 and not is_delta:
+        print ("Usage: bin2ota.py BOARD sketch.bin sketch.ota [--delta]")
+        print ("  BOARD = [ MKR_WIFI_1010 | NANO_33_IOT | PORTENTA_H7_M7 | NANO_RP2040_CONNECT | NICLA_VISION | OPTA | GIGA ]")
+        sys.exit()
+
+    board = sys.argv[1]
+    ifile = sys.argv[2]
+    ofile = sys.argv[3]
+
+    if board not in MAGIC_NUMBERS:
+        print ("Error,", board, "is not a supported board type")
+        sys.exit()
+
+    bin2ota(board, ifile, ofile, is_delta)
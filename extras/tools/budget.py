@@ -0,0 +1,114 @@
+#!/usr/bin/python3
+
+import json
+import sys
+
+LIBRARY_NAME = "ArduinoIoTCloud"
+
+def regressed(metric, old, new, tolerance):
+    # Throughput regresses when it drops, everything else when it grows
+    if metric == "mb_per_s":
+        return new < old * (1.0 - tolerance["throughput"])
+    if metric == "allocs_per_msg":
+        return new > old + tolerance["allocs_per_msg"]
+    return new > old * (1.0 + tolerance[metric])
+
+def summarise(report):
+    # Flash and RAM of the library modules and of the whole sketch per board and sketch
+    summary = {}
+    for name, modules in report.items():
+        library = {"flash": 0, "ram": 0}
+        total = {"flash": 0, "ram": 0}
+        for mod, usage in modules.items():
+            for region in ("flash", "ram"):
+                total[region] += usage[region]
+                if mod.startswith(LIBRARY_NAME + "/"):
+                    library[region] += usage[region]
+        summary[name] = {"library": library, "total": total}
+    return summary
+
+def check(title, rows, tolerance):
+    # Each row is (name, metric, old, new), returns the number of regressions
+    failed = 0
+    print(title)
+    for name, metric, old, new in rows:
+        bad = regressed(metric, old, new, tolerance)
+        failed += bad
+        print("  %-40s %-15s %12.2f %12.2f %s" % (name, metric, old, new, "REGRESSED" if bad else "ok"))
+    return failed
+
+def compare_bench(baseline, results, tolerance):
+    rows = []
+    missing = []
+    for cnt in sorted(results, key=int):
+        if cnt not in baseline:
+            missing.append(cnt + " properties")
+            continue
+        for step in ("encode", "decode"):
+            for metric in ("mb_per_s", "allocs_per_msg", "stack"):
+                rows.append((cnt + " properties " + step, metric, baseline[cnt][step][metric], results[cnt][step][metric]))
+    return rows, missing
+
+def compare_footprint(baseline, summary, tolerance):
+    rows = []
+    missing = []
+    for name in sorted(summary):
+        if name not in baseline:
+            missing.append(name)
+            continue
+        for part in ("library", "total"):
+            for region in ("flash", "ram"):
+                rows.append((name + " " + part, region, baseline[name][part][region], summary[name][part][region]))
+    return rows, missing
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    options = {"--bench": None, "--footprint": None, "--update": None}
+    for option in options:
+        if option in args:
+            index = args.index(option)
+            options[option] = args[index + 1] if index + 1 < len(args) else ""
+            del args[index:index + 2]
+
+    if len(args) != 1 or "" in options.values() or (options["--bench"] is None and options["--footprint"] is None):
+        print ("Usage: budget.py baseline.json [--bench bench.json] [--footprint report.json] [--update VERSION]")
+        sys.exit(2)
+
+    with open(args[0], "r") as in_file:
+        baseline = json.load(in_file)
+
+    bench = None
+    if options["--bench"]:
+        with open(options["--bench"], "r") as in_file:
+            bench = json.load(in_file)
+    footprint = None
+    if options["--footprint"]:
+        with open(options["--footprint"], "r") as in_file:
+            footprint = summarise(json.load(in_file))
+
+    # A release records its results as the baseline of the next one
+    if options["--update"]:
+        baseline["version"] = options["--update"]
+        if bench is not None:
+            baseline["bench"] = bench
+        if footprint is not None:
+            baseline["footprint"].update(footprint)
+        with open(args[0], "w") as out_file:
+            json.dump(baseline, out_file, indent=2, sort_keys=True)
+            out_file.write("\n")
+        sys.exit()
+
+    tolerance = baseline["tolerance"]
+    failed = 0
+    for title, results, compare, section in (("benchmark", bench, compare_bench, "bench"),
+                                             ("footprint", footprint, compare_footprint, "footprint")):
+        if results is None:
+            continue
+        rows, missing = compare(baseline[section], results, tolerance)
+        failed += check("%s against %s %s" % (title, LIBRARY_NAME, baseline["version"]), rows, tolerance)
+        for name in missing:
+            print("  %-40s not in the baseline" % name)
+
+    if failed:
+        print("%d regressions beyond the tolerance" % failed)
+        sys.exit(1)
@@ -0,0 +1,165 @@
+#!/usr/bin/python3
+
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+# Modules of this library, matched against the object path below src/ in order
+LIBRARY_NAME = "ArduinoIoTCloud"
+LIBRARY_MODULES = [
+    ("tls/bearssl/",       "BearSSL"),
+    ("tls/",               "TLS"),
+    ("cbor/lib/tinycbor/", "tinycbor"),
+    ("cbor/",              "CBOR"),
+    ("property/",          "property"),
+    ("utility/ota/",       "OTA"),
+    ("utility/",           "utility"),
+    ("",                   "cloud"),
+]
+
+# Output sections occupying flash, RAM or both (initialised data is copied at startup)
+FLASH_SECTIONS = (".text", ".rodata", ".ARM.exidx", ".ARM.extab", ".init", ".fini", ".flash", ".irom", ".iram", ".dram0.rodata", ".flash.text", ".flash.rodata")
+DATA_SECTIONS  = (".data", ".dram0.data", ".ramfunc")
+RAM_SECTIONS   = (".bss", ".noinit", ".dram0.bss", ".tbss")
+
+INPUT_SECTION  = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$")
+WRAPPED_NAME   = re.compile(r"^ (\S+)$")
+WRAPPED_ADDR   = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$")
+OUTPUT_SECTION = re.compile(r"^(\.\S+)")
+
+def module(path):
+    path = path.replace("\\", "/")
+    lib = "/libraries/" + LIBRARY_NAME + "/"
+    if lib in path:
+        rel = path.split(lib, 1)[1]
+        rel = rel[len("src/"):] if rel.startswith("src/") else rel
+        for prefix, name in LIBRARY_MODULES:
+            if rel.startswith(prefix):
+                return LIBRARY_NAME + "/" + name
+    match = re.search(r"/libraries/([^/]+)/", path)
+    if match:
+        return match.group(1)
+    if "/sketch/" in path:
+        return "sketch"
+    if "/core/" in path or "core.a(" in path:
+        return "core"
+    return "toolchain"
+
+def kind(section):
+    for prefixes, name in ((DATA_SECTIONS, "data"), (RAM_SECTIONS, "ram"), (FLASH_SECTIONS, "flash")):
+        if section.startswith(prefixes):
+            return name
+    return None
+
+def parse_map(map_file):
+    # Sizes in bytes per module and the input sections they consist of
+    modules = {}
+    sections = []
+    output = None
+    pending = None
+
+    def add(name, size, path):
+        region = kind(output) if output else None
+        if region is None or size == 0 or name == "*fill*":
+            return
+        usage = modules.setdefault(module(path), {"flash": 0, "ram": 0})
+        if region in ("flash", "data"):
+            usage["flash"] += size
+        if region in ("ram", "data"):
+            usage["ram"] += size
+        sections.append((size, region, module(path), name))
+
+    with open(map_file, "r", errors="replace") as in_file:
+        # The memory map follows the list of discarded sections
+        for line in in_file:
+            if line.startswith("Linker script and memory map"):
+                break
+        for line in in_file:
+            line = line.rstrip("\n")
+            if pending:
+                match = WRAPPED_ADDR.match(line)
+                if match:
+                    add(pending, int(match.group(2), 16), match.group(3))
+                pending = None
+                continue
+            match = OUTPUT_SECTION.match(line)
+            if match:
+                output = match.group(1)
+                continue
+            match = INPUT_SECTION.match(line)
+            if match:
+                add(match.group(1), int(match.group(3), 16), match.group(4))
+                continue
+            match = WRAPPED_NAME.match(line)
+            if match:
+                pending = match.group(1)
+
+    return modules, sections
+
+def compile_sketch(fqbn, sketch, build_path):
+    # The map file is written next to the elf, the library is taken from this repository
+    root = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+    map_file = os.path.join(build_path, "footprint.map")
+    subprocess.run(["arduino-cli", "compile", "--fqbn", fqbn, "--library", root, "--build-path", build_path,
+                    "--build-property", "compiler.c.elf.extra_flags=-Wl,-Map," + map_file, sketch], check=True)
+    return map_file
+
+def report(name, modules, sections, baseline, top):
+    print(name)
+    print("  %-28s %10s %10s" % ("module", "flash", "ram") + ("   %10s %10s" % ("Δ flash", "Δ ram") if baseline is not None else ""))
+    total = {"flash": 0, "ram": 0}
+    for mod in sorted(set(modules) | set(baseline or {})):
+        usage = modules.get(mod, {"flash": 0, "ram": 0})
+        total["flash"] += usage["flash"]
+        total["ram"] += usage["ram"]
+        line = "  %-28s %10d %10d" % (mod, usage["flash"], usage["ram"])
+        if baseline is not None:
+            old = baseline.get(mod, {"flash": 0, "ram": 0})
+            line += "   %+10d %+10d" % (usage["flash"] - old["flash"], usage["ram"] - old["ram"])
+        print(line)
+    print("  %-28s %10d %10d" % ("total", total["flash"], total["ram"]))
+    if top > 0:
+        print("  largest sections")
+        for size, region, mod, section in sorted(sections, reverse=True)[:top]:
+            print("  %10d %-5s %-28s %s" % (size, region, mod, section))
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    options = {"--top": "0", "--json": None, "--baseline": None}
+    for option in options:
+        if option in args:
+            index = args.index(option)
+            options[option] = args[index + 1] if index + 1 < len(args) else None
+            del args[index:index + 2]
+
+    if len(args) == 0 or (args[0] == "--compile" and len(args) < 3) or options["--top"] is None:
+        print ("Usage: footprint.py sketch.map [--top N] [--json sketch.json] [--baseline old.json]")
+        print ("       footprint.py --compile FQBN sketch1 [sketch2 ...] [--top N] [--json report.json] [--baseline old.json]")
+        sys.exit()
+
+    # A baseline is a report written with --json by an earlier release
+    baseline = {}
+    if options["--baseline"]:
+        with open(options["--baseline"], "r") as in_file:
+            baseline = json.load(in_file)
+
+    results = {}
+    if args[0] == "--compile":
+        fqbn = args[1]
+        for sketch in args[2:]:
+            with tempfile.TemporaryDirectory() as build_path:
+                name = fqbn + " " + os.path.basename(os.path.normpath(sketch))
+                results[name] = parse_map(compile_sketch(fqbn, sketch, build_path))
+    else:
+        for map_file in args:
+            results[map_file] = parse_map(map_file)
+
+    for name, (modules, sections) in results.items():
+        report(name, modules, sections, baseline.get(name) if options["--baseline"] else None, int(options["--top"]))
+
+    if options["--json"]:
+        with open(options["--json"], "w") as out_file:
+            json.dump({name: modules for name, (modules, sections) in results.items()}, out_file, indent=2, sort_keys=True)
@@ -8,11 +8,20 @@
 #define P   1  /* If match length <= P then output one character */
 #define N (1 << EI)  /* buffer size */
 #define F ((1 << EJ) + 1)  /* lookahead buffer size */
+#define H (1 << 16)  /* hash chain heads, one per pair of leading bytes */
+#define NIL (-1)
 
 int bit_buffer = 0, bit_mask = 128;
 unsigned long codecount = 0, textcount = 0;
 unsigned char buffer[N * 2];
 FILE *infile, *outfile;
+/* Hash chains of the buffer positions starting with the same two bytes,
+ * newest first. A match of more than P characters always starts with such
+ * a pair, so walking a chain finds the same match as searching the whole
+ * window.
+ */
+int head[H], prev[N * 2];
+int getbit_buf = 0, getbit_mask = 0;
 
 void error(void)
 {
@@ -73,22 +82,31 @@ void output2(int x, int y)
     }
 }
 
+int hash(int i)
+{
+    return (buffer[i] << 8) | buffer[i + 1];
+}
+
 void encode(void)
 {
-    int i, j, f1, x, y, r, s, bufferend, c;
+    int i, j, f1, x, y, r, s, bufferend, c, h;
     
+    for (i = 0; i < H; i++) head[i] = NIL;
     for (i = 0; i < N - F; i++) buffer[i] = ' ';
     for (i = N - F; i < N * 2; i++) {
         if ((c = fgetc(infile)) == EOF) break;
         buffer[i] = c;  textcount++;
     }
-    bufferend = i;  r = N - F;  s = 0;
+    bufferend = i;  r = N - F;  s = 0;  h = 0;
     while (r < bufferend) {
+        for (; h < r; h++) {  /* bring the chains up to date */
+            prev[h] = head[hash(h)];  head[hash(h)] = h;
+        }
         f1 = (F <= bufferend - r) ? F : bufferend - r;
         x = 0;  y = 1;  c = buffer[r];
-        for (i = r - 1; i >= s; i--)
-            if (buffer[i] == c) {
-                for (j = 1; j < f1; j++)
+        if (f1 > 1)
+            for (i = head[hash(r)]; i >= s && y < f1; i = prev[i]) {
+                for (j = 2; j < f1; j++)
                     if (buffer[i + j] != buffer[r + j]) break;
                 if (j > y) {
                     x = i;  y = j;
@@ -99,7 +117,9 @@ void encode(void)
         r += y;  s += y;
         if (r >= N * 2 - F) {
             for (i = 0; i < N; i++) buffer[i] = buffer[i + N];
-            bufferend -= N;  r -= N;  s -= N;
+            for (i = 0; i < H; i++) head[i] = (head[i] >= N) ? head[i] - N : NIL;
+            for (i = 0; i < N; i++) prev[i] = (prev[i + N] >= N) ? prev[i + N] - N : NIL;
+            bufferend -= N;  r -= N;  s -= N;  h -= N;
             while (bufferend < N * 2) {
                 if ((c = fgetc(infile)) == EOF) break;
                 buffer[bufferend++] = c;  textcount++;
@@ -109,23 +129,22 @@ void encode(void)
     flush_bit_buffer();
     printf("text:  %ld bytes\n", textcount);
     printf("code:  %ld bytes (%ld%%)\n",
-        codecount, (codecount * 100) / textcount);
+        codecount, textcount ? (codecount * 100) / textcount : 0);
 }
 
 int getbit(int n) /* get n bits */
 {
     int i, x;
-    static int buf, mask = 0;
     
     x = 0;
     for (i = 0; i < n; i++) {
-        if (mask == 0) {
-            if ((buf = fgetc(infile)) == EOF) return EOF;
-            mask = 128;
+        if (getbit_mask == 0) {
+            if ((getbit_buf = fgetc(infile)) == EOF) return EOF;
+            getbit_mask = 128;
         }
         x <<= 1;
-        if (buf & mask) x++;
-        mask >>= 1;
+        if (getbit_buf & getbit_mask) x++;
+        getbit_mask >>= 1;
     }
     return x;
 }
@@ -161,6 +180,8 @@ int encode_file(char const * in, char const * out)
     outfile = fopen(out, "wb");
     if (outfile == NULL) return 0;
 
+    /* Several files may be handled by the same process */
+    bit_buffer = 0;  bit_mask = 128;  codecount = 0;  textcount = 0;
     encode();
 
     fclose(infile);
@@ -177,6 +198,7 @@ int decode_file(char const * in, char const * out)
     outfile = fopen(out, "wb");
     if (outfile == NULL) return 0;
 
+    getbit_buf = 0;  getbit_mask = 0;
     decode();
 
     fclose(infile);
@@ -1,31 +1,54 @@
 #!/usr/bin/python3
 
+import os
 import platform
 import sys
 import ctypes
+import multiprocessing
 
 LZSS_SO_EXT = "so" if platform.uname()[0] != "Darwin" else "dylib"
 
-LZSS_SO_FILE = f"./lzss.{LZSS_SO_EXT}"
-
-if len(sys.argv) != 4:
-    print ("Usage: lzss.py --[encode|decode] infile outfile")
-    sys.exit()
-
-lzss_functions = ctypes.CDLL(LZSS_SO_FILE)
-
-mode   = sys.argv[1]
-ifile  = sys.argv[2]
-ofile  = sys.argv[3]
-
-b_ifile = ifile.encode('utf-8')
-b_ofile = ofile.encode('utf-8')
-
-if mode == "--encode":
-    lzss_functions.encode_file.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
-    lzss_functions.encode_file(b_ifile, b_ofile)
-elif mode == "--decode":
-    lzss_functions.decode_file.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
-    lzss_functions.decode_file(b_ifile, b_ofile)
-else:
-    print ("Error, invalid mode parameter, use --encode or --decode")
+LZSS_SO_FILE = os.path.join(os.path.dirname(os.path.abspath(__file__)), f"lzss.{LZSS_SO_EXT}")
+
+def lzss(mode, ifile, ofile):
+    lzss_functions = ctypes.CDLL(LZSS_SO_FILE)
+    function = lzss_functions.encode_file if mode == "--encode" else lzss_functions.decode_file
+    function.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
+    function(ifile.encode('utf-8'), ofile.encode('utf-8'))
+
+def encode_ota(board, ifile):
+    # Imported here, so that plain encoding doesn't depend on bin2ota.py
+    from bin2ota import bin2ota
+    base = os.path.splitext(ifile)[0]
+    lzss("--encode", ifile, base + ".lzss")
+    bin2ota(board, base + ".lzss", base + ".ota")
+    return base + ".ota"
+
+def batch(board, ifiles):
+    # Every file is compressed and packaged by its own worker process
+    with multiprocessing.Pool() as pool:
+        for ofile in pool.starmap(encode_ota, [(board, ifile) for ifile in ifiles]):
+            print (ofile)
+
+if __name__ == "__main__":
+    if len(sys.argv) >= 4 and sys.argv[1] == "--batch":
+        from bin2ota import MAGIC_NUMBERS
+        if sys.argv[2] not in MAGIC_NUMBERS:
+            print ("Error,", sys.argv[2], "is not a supported board type")
+            sys.exit()
+        batch(sys.argv[2], sys.argv[3:])
+        sys.exit()
+
+    if len(sys.argv) != 4:
+        print ("Usage: lzss.py --[encode|decode] infile outfile")
+        print ("       lzss.py --batch BOARD sketch1.bin [sketch2.bin ...]")
+        sys.exit()
+
+    mode   = sys.argv[1]
+    ifile  = sys.argv[2]
+    ofile  = sys.argv[3]
+
+    if mode == "--encode" or mode == "--decode":
+        lzss(mode, ifile, ofile)
+    else:
+        print ("Error, invalid mode parameter, use --encode or --decode")
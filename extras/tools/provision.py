@@ -0,0 +1,145 @@
+#!/usr/bin/python3
+
+import json
+import os
+import subprocess
+import sys
+import zlib
+from concurrent.futures import ThreadPoolExecutor
+
+import serial
+
+# See src/utility/provisioning/ProvisioningFrame.h
+START = 0xA5
+
+FRAME_BEGIN   = 1
+FRAME_CSR     = 2
+FRAME_CERT    = 3
+FRAME_CONFIRM = 4
+FRAME_ERROR   = 5
+
+FIELD_DEVICE_ID        = 1
+FIELD_ISSUE_YEAR       = 2
+FIELD_ISSUE_MONTH      = 3
+FIELD_ISSUE_DAY        = 4
+FIELD_ISSUE_HOUR       = 5
+FIELD_EXPIRE_YEARS     = 6
+FIELD_SERIAL_NUMBER    = 7
+FIELD_AUTHORITY_KEY_ID = 8
+FIELD_SIGNATURE        = 9
+FIELD_CSR              = 10
+FIELD_NONCE            = 11
+FIELD_ERROR            = 12
+
+BAUD_RATE = 115200
+TIMEOUT_S = 30
+
+def field(id, value):
+    return bytes([id]) + len(value).to_bytes(2, byteorder='little') + value
+
+def number(id, value):
+    return field(id, int(value).to_bytes(2, byteorder='little'))
+
+def encode(type, payload):
+    body = bytes([type]) + len(payload).to_bytes(2, byteorder='little') + payload
+    return bytes([START]) + body + zlib.crc32(body).to_bytes(4, byteorder='little')
+
+def fields(payload):
+    result = {}
+    pos = 0
+    while pos + 3 <= len(payload):
+        length = int.from_bytes(payload[pos + 1:pos + 3], byteorder='little')
+        result[payload[pos]] = payload[pos + 3:pos + 3 + length]
+        pos += 3 + length
+    return result
+
+def receive(port):
+    # Skips anything up to the start byte, e.g. output of the bootloader
+    while True:
+        c = port.read(1)
+        if not c:
+            raise RuntimeError("timeout")
+        if c[0] == START:
+            break
+    header = port.read(3)
+    length = int.from_bytes(header[1:3], byteorder='little')
+    payload = port.read(length)
+    crc = port.read(4)
+    if len(header) != 3 or len(payload) != length or len(crc) != 4:
+        raise RuntimeError("timeout")
+    if zlib.crc32(header + payload) != int.from_bytes(crc, byteorder='little'):
+        raise RuntimeError("CRC mismatch")
+    if header[0] == FRAME_ERROR:
+        raise RuntimeError("device failed at " + fields(payload).get(FIELD_ERROR, b'?').decode())
+    return header[0], fields(payload)
+
+def sign(signer, device_id, csr):
+    # The signer gets the CSR and returns the fields of the certificate, e.g.
+    # by a request to the certificate authority.
+    request = json.dumps({"device_id": device_id, "csr": csr.hex()})
+    reply = subprocess.run(signer, shell=True, input=request, capture_output=True, text=True, check=True)
+    return json.loads(reply.stdout)
+
+def verify(csr, nonce, device_id, serial_number, signature):
+    try:
+        from cryptography import x509
+        from cryptography.hazmat.primitives import hashes
+        from cryptography.hazmat.primitives.asymmetric import ec
+        from cryptography.hazmat.primitives.asymmetric.utils import encode_dss_signature
+    except ImportError:
+        return "unverified"
+    r = int.from_bytes(signature[:32], byteorder='big')
+    s = int.from_bytes(signature[32:], byteorder='big')
+    key = x509.load_der_x509_csr(csr).public_key()
+    key.verify(encode_dss_signature(r, s), nonce + device_id.encode() + serial_number, ec.ECDSA(hashes.SHA256()))
+    return "verified"
+
+def provision(signer, port_name, device_id):
+    with serial.Serial(port_name, BAUD_RATE, timeout=TIMEOUT_S) as port:
+        port.write(encode(FRAME_BEGIN, field(FIELD_DEVICE_ID, device_id.encode())))
+        type, reply = receive(port)
+        if type != FRAME_CSR:
+            raise RuntimeError("unexpected reply")
+        csr = reply[FIELD_CSR]
+
+        cert = sign(signer, device_id, csr)
+        nonce = os.urandom(32)
+        serial_number = bytes.fromhex(cert["serial_number"])
+        payload = field(FIELD_DEVICE_ID, device_id.encode()) + \
+                  number(FIELD_ISSUE_YEAR, cert["issue_year"]) + \
+                  number(FIELD_ISSUE_MONTH, cert["issue_month"]) + \
+                  number(FIELD_ISSUE_DAY, cert["issue_day"]) + \
+                  number(FIELD_ISSUE_HOUR, cert["issue_hour"]) + \
+                  number(FIELD_EXPIRE_YEARS, cert["expire_years"]) + \
+                  field(FIELD_SERIAL_NUMBER, serial_number) + \
+                  field(FIELD_AUTHORITY_KEY_ID, bytes.fromhex(cert["authority_key_id"])) + \
+                  field(FIELD_SIGNATURE, bytes.fromhex(cert["signature"])) + \
+                  field(FIELD_NONCE, nonce)
+        port.write(encode(FRAME_CERT, payload))
+        type, reply = receive(port)
+        if type != FRAME_CONFIRM:
+            raise RuntimeError("unexpected reply")
+        return verify(csr, nonce, device_id, serial_number, reply[FIELD_SIGNATURE])
+
+def run(signer, port_name, device_id):
+    try:
+        return port_name, device_id, provision(signer, port_name, device_id)
+    except Exception as e:
+        return port_name, device_id, "failed: " + str(e)
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3 or any(":" not in arg for arg in sys.argv[2:]):
+        print ("Usage: provision.py SIGNER PORT:DEVICE_ID [PORT:DEVICE_ID ...]")
+        print ("  SIGNER reads {\"device_id\", \"csr\"} as JSON from stdin and prints the certificate fields")
+        sys.exit()
+
+    signer = sys.argv[1]
+    jobs = [arg.rsplit(":", 1) for arg in sys.argv[2:]]
+
+    # The devices are served concurrently, each one waits on its serial port
+    failed = False
+    with ThreadPoolExecutor(max_workers=len(jobs)) as executor:
+        for port_name, device_id, result in executor.map(lambda job: run(signer, *job), jobs):
+            print (port_name, device_id, result)
+            failed = failed or result.startswith("failed")
+    sys.exit(1 if failed else 0)
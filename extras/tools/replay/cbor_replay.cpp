@@ -0,0 +1,357 @@
+/*
+   Copyright (c) 2020 Arduino.  All rights reserved.
+*/
+
+/**************************************************************************************
+   INCLUDE
+ **************************************************************************************/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <util/AllocationTestUtil.h>
+
+#include <PropertyContainer.h>
+#include <CBOREncoder.h>
+#include <CBORDecoder.h>
+#include "types/CloudSchedule.h"
+#include "types/automation/CloudColoredLight.h"
+#include "types/automation/CloudContactSensor.h"
+#include "types/automation/CloudDimmedLight.h"
+#include "types/automation/CloudLight.h"
+#include "types/automation/CloudMotionSensor.h"
+#include "types/automation/CloudSmartPlug.h"
+#include "types/automation/CloudSwitch.h"
+#include "types/automation/CloudTelevision.h"
+#include "types/automation/CloudTemperatureSensor.h"
+
+/**************************************************************************************
+   CONSTANTS
+ **************************************************************************************/
+
+/* Same as the MQTT payload buffer of the TCP connection */
+static size_t const MESSAGE_SIZE = 256;
+
+/**************************************************************************************
+   SCHEMA
+ **************************************************************************************/
+
+/* The properties of the thing, all of them writeable by the cloud so that
+ * the captured messages of both directions can be applied.
+ */
+class Thing
+{
+public:
+
+  bool add(std::string const & type, std::string const & name, int const identifier)
+  {
+    Property * p = create(type);
+    if (p == nullptr)
+      return false;
+    _property.emplace_back(p);
+    addPropertyToContainer(container, *p, String(name.c_str()), Permission::ReadWrite, identifier);
+    return true;
+  }
+
+  PropertyContainer container;
+
+private:
+
+  std::vector<std::unique_ptr<Property>> _property;
+
+  static Property * create(std::string const & type)
+  {
+    if (type == "bool")               return new CloudBool();
+    if (type == "int")                return new CloudInt();
+    if (type == "uint")               return new CloudUnsignedInt();
+    if (type == "float")              return new CloudFloat();
+    if (type == "string")             return new CloudString();
+    if (type == "location")           return new CloudLocation();
+    if (type == "color")              return new CloudColor();
+    if (type == "schedule")           return new CloudSchedule();
+    if (type == "colored_light")      return new CloudColoredLight();
+    if (type == "contact_sensor")     return new CloudContactSensor();
+    if (type == "dimmed_light")       return new CloudDimmedLight();
+    if (type == "light")              return new CloudLight();
+    if (type == "motion_sensor")      return new CloudMotionSensor();
+    if (type == "smart_plug")         return new CloudSmartPlug();
+    if (type == "switch")             return new CloudSwitch();
+    if (type == "television")         return new CloudTelevision();
+    if (type == "temperature_sensor") return new CloudTemperatureSensor();
+    return nullptr;
+  }
+};
+
+/**************************************************************************************
+   CAPTURE
+ **************************************************************************************/
+
+enum class Direction { In, Sync, Out };
+
+struct Message
+{
+  unsigned int line;
+  unsigned long time_ms;
+  Direction direction;
+  std::vector<uint8_t> payload;
+};
+
+static char const * toString(Direction const direction)
+{
+  switch (direction)
+  {
+    case Direction::In:   return "in";
+    case Direction::Sync: return "sync";
+    case Direction::Out:  return "out";
+  }
+  return "?";
+}
+
+static bool isComment(char const * line)
+{
+  while (isspace(static_cast<unsigned char>(*line)))
+    line++;
+  return (*line == '\0') || (*line == '#');
+}
+
+/* Each line holds "<type> <name> [<identifier>]" */
+static bool readSchema(char const * path, Thing & thing)
+{
+  FILE * f = fopen(path, "r");
+  if (f == nullptr)
+  {
+    fprintf(stderr, "cannot open schema %s\n", path);
+    return false;
+  }
+
+  char line[256];
+  unsigned int line_no = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f))
+  {
+    line_no++;
+    if (isComment(line))
+      continue;
+    char type[64], name[128];
+    int identifier = -1;
+    int const fields = sscanf(line, "%63s %127s %d", type, name, &identifier);
+    ok = (fields >= 2) && thing.add(type, name, identifier);
+    if (!ok)
+      fprintf(stderr, "%s:%u: expected \"<type> <name> [<identifier>]\" of a known type\n", path, line_no);
+  }
+  fclose(f);
+  return ok;
+}
+
+/* Each line holds "<time_ms> <in|sync|out> <hex payload>", the payload may
+ * be split by white space, e.g. "81 A2 00 ...".
+ */
+static bool readCapture(char const * path, std::vector<Message> & messages)
+{
+  FILE * f = fopen(path, "r");
+  if (f == nullptr)
+  {
+    fprintf(stderr, "cannot open capture %s\n", path);
+    return false;
+  }
+
+  std::string line;
+  unsigned int line_no = 0;
+  bool ok = true;
+  for (int c = 0; ok && (c != EOF); )
+  {
+    c = fgetc(f);
+    if ((c != '\n') && (c != EOF))
+    {
+      line += static_cast<char>(c);
+      continue;
+    }
+    line_no++;
+    if (!isComment(line.c_str()))
+    {
+      Message msg;
+      char direction[8];
+      int consumed = 0;
+      msg.line = line_no;
+      ok = (sscanf(line.c_str(), "%lu %7s %n", &msg.time_ms, direction, &consumed) == 2);
+      if (ok && !strcmp(direction, "in"))        msg.direction = Direction::In;
+      else if (ok && !strcmp(direction, "sync")) msg.direction = Direction::Sync;
+      else if (ok && !strcmp(direction, "out"))  msg.direction = Direction::Out;
+      else ok = false;
+
+      int nibble = -1;
+      for (char const * h = line.c_str() + consumed; ok && (*h != '\0'); h++)
+      {
+        if (isspace(static_cast<unsigned char>(*h)))
+          continue;
+        if (!isxdigit(static_cast<unsigned char>(*h)))
+        {
+          ok = false;
+          break;
+        }
+        int const v = isdigit(static_cast<unsigned char>(*h)) ? (*h - '0') : (tolower(*h) - 'a' + 10);
+        if (nibble < 0)
+          nibble = v;
+        else
+        {
+          msg.payload.push_back(static_cast<uint8_t>((nibble << 4) | v));
+          nibble = -1;
+        }
+      }
+      ok = ok && (nibble < 0) && !msg.payload.empty();
+      if (ok)
+        messages.push_back(msg);
+      else
+        fprintf(stderr, "%s:%u: expected \"<time_ms> <in|sync|out> <hex payload>\"\n", path, line_no);
+    }
+    line.clear();
+  }
+  fclose(f);
+  return ok;
+}
+
+/**************************************************************************************
+   REPLAY
+ **************************************************************************************/
+
+struct Measurement
+{
+  double decode_us;
+  size_t decode_allocs;
+  size_t decode_peak_bytes;
+  size_t encode_msgs;
+  size_t encode_bytes;
+  double encode_us;
+  size_t encode_allocs;
+};
+
+static double elapsed_us(std::chrono::steady_clock::time_point const start)
+{
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Encodes what the device sends in turn, the echo of the applied values,
+ * into as many messages as needed.
+ */
+static void encodeAll(Thing & thing, bool const light_payload, Measurement & m)
+{
+  unsigned int property_index = 0;
+  for (size_t i = 0; i < (thing.container.size() * 2); i++)
+  {
+    uint8_t buf[MESSAGE_SIZE];
+    int bytes_encoded = 0;
+    if ((CBOREncoder::encode(thing.container, buf, sizeof(buf), bytes_encoded, property_index, light_payload) != CborNoError) || (bytes_encoded == 0))
+      break;
+    m.encode_msgs++;
+    m.encode_bytes += bytes_encoded;
+  }
+}
+
+static Measurement replay(Thing & thing, Message const & msg, unsigned int const repeat, bool const light_payload)
+{
+  Measurement m = {};
+  set_millis(msg.time_ms);
+
+  /* Decoding the same message again applies the same values */
+  bool const is_sync = (msg.direction == Direction::Sync);
+  {
+    AllocationCounter counter;
+    auto const start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < repeat; i++)
+      CBORDecoder::decode(thing.container, msg.payload.data(), msg.payload.size(), is_sync);
+    m.decode_us = elapsed_us(start) / repeat;
+    m.decode_allocs = counter.count() / repeat;
+    m.decode_peak_bytes = counter.peakBytes();
+  }
+
+  {
+    AllocationCounter counter;
+    auto const start = std::chrono::steady_clock::now();
+    encodeAll(thing, light_payload, m);
+    m.encode_us = elapsed_us(start);
+    m.encode_allocs = counter.count();
+  }
+  return m;
+}
+
+/**************************************************************************************
+   MAIN
+ **************************************************************************************/
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: cborReplay [--repeat N] [--light] <schema> <capture>\n"
+    "  Decodes each captured message into the properties of the schema and\n"
+    "  encodes what the device sends in turn, reporting per message:\n"
+    "  decode time, allocations and peak heap, encoded messages and bytes.\n"
+    "  --repeat N  decodes each message N times and reports the mean\n"
+    "  --light     encodes with the light payload, by property identifier\n");
+}
+
+int main(int argc, char ** argv)
+{
+  unsigned int repeat = 1;
+  bool light_payload = false;
+  int arg = 1;
+  for (; (arg < argc) && (argv[arg][0] == '-'); arg++)
+  {
+    if (!strcmp(argv[arg], "--repeat") && (arg + 1 < argc))
+      repeat = static_cast<unsigned int>(strtoul(argv[++arg], nullptr, 10));
+    else if (!strcmp(argv[arg], "--light"))
+      light_payload = true;
+    else
+      break;
+  }
+  if ((argc - arg != 2) || (repeat == 0))
+  {
+    usage();
+    return 2;
+  }
+
+  Thing thing;
+  std::vector<Message> messages;
+  if (!readSchema(argv[arg], thing) || !readCapture(argv[arg + 1], messages))
+    return 1;
+
+  printf("%6s %10s %4s %6s %10s %6s %8s | %4s %6s %10s %6s\n", "line", "time_ms", "dir", "bytes", "decode_us", "allocs", "peak_B", "msgs", "bytes", "encode_us", "allocs");
+
+  Measurement total = {};
+  double decode_max_us = 0.0;
+  unsigned int decode_max_line = 0;
+  size_t bytes_in = 0;
+  for (Message const & msg : messages)
+  {
+    Measurement const m = replay(thing, msg, repeat, light_payload);
+    printf("%6u %10lu %4s %6u %10.2f %6u %8u | %4u %6u %10.2f %6u\n", msg.line, msg.time_ms, toString(msg.direction), static_cast<unsigned int>(msg.payload.size()),
+           m.decode_us, static_cast<unsigned int>(m.decode_allocs), static_cast<unsigned int>(m.decode_peak_bytes),
+           static_cast<unsigned int>(m.encode_msgs), static_cast<unsigned int>(m.encode_bytes), m.encode_us, static_cast<unsigned int>(m.encode_allocs));
+
+    bytes_in += msg.payload.size();
+    total.decode_us += m.decode_us;
+    total.decode_allocs += m.decode_allocs;
+    total.encode_msgs += m.encode_msgs;
+    total.encode_bytes += m.encode_bytes;
+    total.encode_us += m.encode_us;
+    total.encode_allocs += m.encode_allocs;
+    if (m.decode_us > decode_max_us)
+    {
+      decode_max_us = m.decode_us;
+      decode_max_line = msg.line;
+    }
+  }
+
+  size_t const cnt = messages.empty() ? 1 : messages.size();
+  printf("%u messages, %u bytes decoded: %.2f us/msg mean, %.2f us max (line %u), %.2f allocs/msg\n",
+         static_cast<unsigned int>(messages.size()), static_cast<unsigned int>(bytes_in), total.decode_us / cnt, decode_max_us, decode_max_line, static_cast<double>(total.decode_allocs) / cnt);
+  printf("%u messages, %u bytes encoded: %.2f us total, %u allocs\n",
+         static_cast<unsigned int>(total.encode_msgs), static_cast<unsigned int>(total.encode_bytes), total.encode_us, static_cast<unsigned int>(total.encode_allocs));
+  return 0;
+}
@@ -26,6 +26,247 @@
   #define NTP_USE_RANDOM_PORT     (1)
 #endif
 
+/* Maximum number of properties which can be added to a single property
+ * container. The storage is allocated statically, therefore raise this
+ * value only if the thing has more properties than the default allows.
+ * The properties added beyond it are not added to the thing, which is
+ * reported with DEBUG_ERROR, see addPropertyToContainer().
+ */
+#ifndef AIOT_CONFIG_PROPERTY_CONTAINER_CAPACITY
+  #define AIOT_CONFIG_PROPERTY_CONTAINER_CAPACITY (64)
+#endif
+
+/* Maximum number of properties of a PropertyGroup pushed together */
+#ifndef AIOT_CONFIG_PROPERTY_GROUP_CAPACITY
+  #define AIOT_CONFIG_PROPERTY_GROUP_CAPACITY (8)
+#endif
+
+/* Maximum number of attributes of a single property which are buffered
+ * while decoding a message received from the cloud.
+ */
+#ifndef AIOT_CONFIG_PROPERTY_MAX_ATTRIBUTES
+  #define AIOT_CONFIG_PROPERTY_MAX_ATTRIBUTES (8)
+#endif
+
+/* Size of the buffer into which a message received from the cloud is read
+ * while decoding it. All records belonging to a single property have to
+ * fit into it at the same time.
+ */
+#ifndef AIOT_CONFIG_CBOR_DECODER_BUFFER_SIZE
+  #define AIOT_CONFIG_CBOR_DECODER_BUFFER_SIZE (256)
+#endif
+
+/* Number of properties a packed message is chosen from, largest first. The
+ * ones behind are left to the next message.
+ */
+#ifndef AIOT_CONFIG_CBOR_PACKING_CANDIDATES
+  #define AIOT_CONFIG_CBOR_PACKING_CANDIDATES (16)
+#endif
+
+/* Encode the names of the records relative to a SenML base name, i.e. the
+ * "name:" prefix of composite properties or the name of a PropertyGroup, and
+ * the times relative to a base time. Only enable it if the thing is served by
+ * a cloud which resolves SenML base values.
+ */
+#ifndef AIOT_CONFIG_SENML_BASE_VALUES_ENABLED
+  #define AIOT_CONFIG_SENML_BASE_VALUES_ENABLED (0)
+#endif
+
+/* Send the string values of the properties configured with
+ * encodeCompressed() LZSS compressed and accept compressed values from the
+ * cloud. Only enable it if the thing is served by a cloud which supports it.
+ */
+#ifndef AIOT_CONFIG_COMPRESSION_ENABLED
+  #define AIOT_CONFIG_COMPRESSION_ENABLED (0)
+#endif
+
+/* Largest compressed value sent, a value which does not compress into it
+ * is sent as it is.
+ */
+#ifndef AIOT_CONFIG_COMPRESSION_BUFFER_SIZE
+  #define AIOT_CONFIG_COMPRESSION_BUFFER_SIZE (128)
+#endif
+
+/* Number of bytes searched back for a match while compressing, the time
+ * taken grows with it. At most 2031, the window of the decoder.
+ */
+#ifndef AIOT_CONFIG_COMPRESSION_SEARCH_WINDOW
+  #define AIOT_CONFIG_COMPRESSION_SEARCH_WINDOW (256)
+#endif
+
+/* Shorter values are not worth compressing */
+#ifndef AIOT_CONFIG_COMPRESSION_MIN_LENGTH
+  #define AIOT_CONFIG_COMPRESSION_MIN_LENGTH (32)
+#endif
+
+/* Longest value accepted once decompressed */
+#ifndef AIOT_CONFIG_COMPRESSION_MAX_LENGTH
+  #define AIOT_CONFIG_COMPRESSION_MAX_LENGTH (1024)
+#endif
+
+/* Compute the min, max and mean of the float samples of a CloudSeries with
+ * CMSIS-DSP on Cortex-M cores with the DSP extension. The sketch has to
+ * include the Arduino_CMSIS-DSP library (or any other providing
+ * arm_math.h), otherwise a portable loop is used.
+ */
+#ifndef AIOT_CONFIG_CMSIS_DSP_ENABLED
+  #define AIOT_CONFIG_CMSIS_DSP_ENABLED (0)
+#endif
+
+#if AIOT_CONFIG_CMSIS_DSP_ENABLED && defined(__ARM_FEATURE_DSP)
+  #define HAS_CMSIS_DSP
+#endif
+
+/* Support the CloudSchedule property and the timer which fires its
+ * callbacks, they pull in the calendar conversions of gmtime(). Define as 0
+ * if the thing has no schedule property.
+ */
+#ifndef AIOT_CONFIG_SCHEDULE_ENABLED
+  #define AIOT_CONFIG_SCHEDULE_ENABLED (1)
+#endif
+
+/* Include all automation types, e.g. CloudTelevision or CloudColoredLight,
+ * with ArduinoIoTCloud.h. Define as 0 to only compile those the sketch
+ * includes itself, e.g. <property/types/automation/CloudSwitch.h>.
+ */
+#ifndef AIOT_CONFIG_AUTOMATION_TYPES_ENABLED
+  #define AIOT_CONFIG_AUTOMATION_TYPES_ENABLED (1)
+#endif
+
+/* Support OTA updates on the boards which have an OTA storage. Define as 0
+ * to drop the OTA code, the device then does not announce the capability.
+ */
+#ifndef AIOT_CONFIG_OTA_ENABLED
+  #define AIOT_CONFIG_OTA_ENABLED (1)
+#endif
+
+/* Restrict the BearSSL profile of ECCX08 boards to what the broker actually
+ * negotiates: ECDHE-ECDSA-AES128-GCM-SHA256 over NIST P-256 only. Unused
+ * curves and implementations are then dropped by the linker.
+ */
+#ifndef AIOT_CONFIG_TLS_PROFILE_MINIMAL
+  #define AIOT_CONFIG_TLS_PROFILE_MINIMAL (0)
+#endif
+
+/* Maximum TLS fragment length negotiated with the broker on ECCX08 boards
+ * and ESP8266, one of 512, 1024, 2048 or 4096. The TLS buffers are sized
+ * accordingly.
+ * 0 keeps the default buffers which can also hold the records of brokers
+ * not honouring the negotiation.
+ */
+#ifndef AIOT_CONFIG_TLS_MAX_FRAGMENT_LENGTH
+  #define AIOT_CONFIG_TLS_MAX_FRAGMENT_LENGTH (0)
+#endif
+
+/* Use a single buffer for both directions of the TLS connection, data is
+ * then only sent once all received data has been processed.
+ */
+#ifndef AIOT_CONFIG_TLS_HALF_DUPLEX
+  #define AIOT_CONFIG_TLS_HALF_DUPLEX (0)
+#endif
+
+/* Pin the key of the last server certificate chain that passed the full
+ * X.509 validation, together with the server name it was validated for and
+ * the validity period of the certificate. The very same certificate
+ * presented again for the same server name within its validity period is
+ * trusted without verifying the chain, which saves the ECDSA verifications
+ * of the intermediate certificates. Any other certificate is validated in
+ * full as before and then replaces the pin. Costs about 1 kB of RAM for
+ * decoding the validity of the server certificate.
+ */
+#ifndef AIOT_CONFIG_TLS_KEY_PINNING_ENABLED
+  #define AIOT_CONFIG_TLS_KEY_PINNING_ENABLED (0)
+#endif
+
+/* Number of draws from the random generator of ECCX08 boards after which it
+ * is reseeded from the ECCX08. The TLS handshake draws once per connection.
+ */
+#ifndef AIOT_CONFIG_DRBG_RESEED_INTERVAL
+  #define AIOT_CONFIG_DRBG_RESEED_INTERVAL (256)
+#endif
+
+/* Keep the device certificate rebuilt from the compressed ECCX08 slots in
+ * RAM, it is only rebuilt when the slot contents change. Define
+ * AIOT_CONFIG_CERT_CACHE_SECTION as e.g. ".noinit" to keep it across resets.
+ */
+#ifndef AIOT_CONFIG_CERT_CACHE_ENABLED
+  #define AIOT_CONFIG_CERT_CACHE_ENABLED (0)
+#endif
+
+/* Resume the cloud connection after a restart, e.g. a wake from deep sleep,
+ * without negotiating the device configuration and the last values again.
+ * The thing id and the time zone are kept in RAM which survives the restart
+ * if AIOT_CONFIG_FAST_RESUME_SECTION is defined as e.g. ".noinit".
+ */
+#ifndef AIOT_CONFIG_FAST_RESUME_ENABLED
+  #define AIOT_CONFIG_FAST_RESUME_ENABLED (0)
+#endif
+
+/* Reconstruct the device certificate from the ECCX08 or SE050 while the
+ * network comes up instead of in begin(), which then only reads the device
+ * id. The broker is connected once both are done. A certificate which can't
+ * be read is retried with the reconnection backoff rather than failing
+ * begin().
+ */
+#ifndef AIOT_CONFIG_DEFERRED_CERT_ENABLED
+  #define AIOT_CONFIG_DEFERRED_CERT_ENABLED (0)
+#endif
+
+/* Decompress the RP2040 OTA image while it is downloaded and store it as
+ * UPDATE.BIN, SFU then flashes it without decompressing it first. The
+ * download can then only be resumed within the same OTA request.
+ */
+#ifndef AIOT_CONFIG_RP2040_OTA_STREAM_DECOMPRESSION
+  #define AIOT_CONFIG_RP2040_OTA_STREAM_DECOMPRESSION (0)
+#endif
+
+/* Decompress the Portenta H7, Opta, GIGA and Nicla Vision OTA image while it
+ * is downloaded and write it straight to UPDATE.BIN on the QSPI flash. This
+ * skips storing the compressed image and reading it back to decompress it,
+ * the download is then limited by the network rather than the flash.
+ */
+#ifndef AIOT_CONFIG_PORTENTA_OTA_STREAM_DECOMPRESSION
+  #define AIOT_CONFIG_PORTENTA_OTA_STREAM_DECOMPRESSION (0)
+#endif
+
+/* Download the OTA image of the MKR WiFi 1010 and Nano 33 IoT from update()
+ * through a socket of the NINA module instead of the blocking NINA-side
+ * download, the cloud connection and the sketch keep running meanwhile. The
+ * image is written to the NINA file system in pieces and only handed to SNU
+ * once it is complete and its CRC matches.
+ */
+#ifndef AIOT_CONFIG_SAMD_OTA_ASYNC_ENABLED
+  #define AIOT_CONFIG_SAMD_OTA_ASYNC_ENABLED (0)
+#endif
+
+/* Download the ESP32 OTA image from update() in bounded chunks straight into
+ * the inactive app partition. It is hashed while it is written and only
+ * made the boot partition once its CRC and the ESP-IDF image check pass,
+ * the hash is kept so that the new firmware does not read it back at boot.
+ * A server reached via https has to be verified by the root of the OTA
+ * storage or the one passed to setCACert(), see tls/AIoTCOTACert.h.
+ */
+#ifndef AIOT_CONFIG_ESP32_OTA_ASYNC_ENABLED
+  #define AIOT_CONFIG_ESP32_OTA_ASYNC_ENABLED (0)
+#endif
+
+/* Download and verify a requested image while the sketch still defers the
+ * update via ArduinoCloud.onOTARequestCb(), once it agrees the device only
+ * resets into the image. Supported on the Nano RP2040 Connect, whose staged
+ * image is kept apart from the one SFU flashes after any reset.
+ */
+#ifndef AIOT_CONFIG_OTA_PREFETCH_ENABLED
+  #define AIOT_CONFIG_OTA_PREFETCH_ENABLED (0)
+#endif
+
+/* Number of NTP samples taken on each periodic resync of the RTC. Their
+ * median is used as the RTC offset and to estimate the RTC skew.
+ */
+
+#ifndef AIOT_CONFIG_TIME_SYNC_SAMPLES
+  #define AIOT_CONFIG_TIME_SYNC_SAMPLES (3)
+#endif
+
 #ifndef DEBUG_ERROR
 # if defined(ARDUINO_AVR_UNO_WIFI_REV2)
 #   define DEBUG_ERROR(fmt, ...) Debug.print(DBG_ERROR, fmt, ## __VA_ARGS__)
@@ -112,12 +353,28 @@
   #define OTA_STORAGE_ESP         (1)
 #endif
 
-#if (OTA_STORAGE_SFU || OTA_STORAGE_SSU || OTA_STORAGE_SNU || OTA_STORAGE_PORTENTA_QSPI || OTA_STORAGE_ESP) && !defined(ARDUINO_AVR_UNO_WIFI_REV2)
+#if (OTA_STORAGE_SFU || OTA_STORAGE_SSU || OTA_STORAGE_SNU || OTA_STORAGE_PORTENTA_QSPI || OTA_STORAGE_ESP) && !defined(ARDUINO_AVR_UNO_WIFI_REV2) && AIOT_CONFIG_OTA_ENABLED
   #define OTA_ENABLED             (1)
 #else
   #define OTA_ENABLED             (0)
 #endif
 
+#if AIOT_CONFIG_OTA_PREFETCH_ENABLED && OTA_ENABLED && defined(ARDUINO_NANO_RP2040_CONNECT)
+  #define HAS_OTA_PREFETCH
+#endif
+
+#if AIOT_CONFIG_DEFERRED_CERT_ENABLED && (defined(BOARD_HAS_ECCX08) || defined(BOARD_HAS_SE050))
+  #define HAS_DEFERRED_CERT
+#endif
+
+#if AIOT_CONFIG_SAMD_OTA_ASYNC_ENABLED && OTA_ENABLED && OTA_STORAGE_SNU && defined(ARDUINO_ARCH_SAMD)
+  #define HAS_SAMD_OTA_ASYNC
+#endif
+
+#if AIOT_CONFIG_ESP32_OTA_ASYNC_ENABLED && OTA_ENABLED && defined(ARDUINO_ARCH_ESP32)
+  #define HAS_ESP32_OTA_ASYNC
+#endif
+
 #if defined(ARDUINO_SAMD_MKRGSM1400) || defined(ARDUINO_SAMD_MKR1000) ||   \
   defined(ARDUINO_SAMD_MKRNB1500) || defined(ARDUINO_PORTENTA_H7_M7)      ||   \
   defined (ARDUINO_NANO_RP2040_CONNECT) || defined(ARDUINO_OPTA) || \
@@ -150,6 +407,563 @@
   #define BOARD_STM32H7
 #endif
 
+/* The M4 core only takes part in the cloud through the core link */
+#if defined(ARDUINO_PORTENTA_H7_M4) && defined(AIOT_CONFIG_CORE_LINK_ENABLED) && AIOT_CONFIG_CORE_LINK_ENABLED
+  #define HAS_TCP
+#endif
+
+/* Verify the server certificate chain and the ECDHE parameters in software
+ * instead of on the ECCX08. A Cortex-M7 does this faster than the round trip
+ * over I2C to the secure element, a Cortex-M0+ does not.
+ */
+#ifndef AIOT_CONFIG_TLS_SOFTWARE_ECDSA_VERIFY
+  #if defined(BOARD_STM32H7)
+    #define AIOT_CONFIG_TLS_SOFTWARE_ECDSA_VERIFY (1)
+  #else
+    #define AIOT_CONFIG_TLS_SOFTWARE_ECDSA_VERIFY (0)
+  #endif
+#endif
+
+/* Maximum size of a single outgoing MQTT message. Boards with plenty of RAM
+ * use a larger buffer so that a change of many properties can be sent with
+ * a single publish. It can be overridden before including the library.
+ */
+#ifndef AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE
+  #if defined(BOARD_STM32H7) || defined(ARDUINO_ARCH_ESP32)
+    #define AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE (2048)
+  #else
+    #define AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE (256)
+  #endif
+#endif
+
+/* Number of outgoing MQTT messages which can be queued. One slot is always
+ * kept free for encoding the next message, the others hold messages which
+ * are waiting to be sent or which are replayed after a connection loss.
+ */
+#ifndef AIOT_CONFIG_MQTT_OUTBOUND_QUEUE_SIZE
+  #if defined(BOARD_STM32H7) || defined(ARDUINO_ARCH_ESP32)
+    #define AIOT_CONFIG_MQTT_OUTBOUND_QUEUE_SIZE (4)
+  #else
+    #define AIOT_CONFIG_MQTT_OUTBOUND_QUEUE_SIZE (2)
+  #endif
+#endif
+
+/* Size of the buffer in which back-to-back MQTT packets are collected in
+ * order to be handed to the TLS client with a single write, i.e. sealed as
+ * one TLS record. It applies to the TLS clients other than BearSSLClient,
+ * which coalesces in its own output buffer. 0 disables coalescing.
+ */
+#ifndef AIOT_CONFIG_MQTT_COALESCE_BUFFER_SIZE
+  #define AIOT_CONFIG_MQTT_COALESCE_BUFFER_SIZE (AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE + 128)
+#endif
+
+#if (AIOT_CONFIG_MQTT_COALESCE_BUFFER_SIZE > 0) && (defined(BOARD_HAS_OFFLOADED_ECCX08) || defined(BOARD_HAS_SE050) || defined(BOARD_ESP))
+  #define HAS_COALESCING_CLIENT
+#endif
+
+/* Once the cloud holds the value of a composite property, e.g. a colour or
+ * a television, only its attributes which changed are sent and the cloud
+ * merges them into the value. Define as 0 to always send all attributes.
+ */
+#ifndef AIOT_CONFIG_ATTRIBUTE_DELTA_ENABLED
+  #define AIOT_CONFIG_ATTRIBUTE_DELTA_ENABLED (1)
+#endif
+
+/* The broker always returns all last values on a reconnect. A property whose
+ * value and cloud timestamp are the ones already applied in an earlier sync
+ * is skipped, so its onSync callback is only executed if it changed since.
+ * Define as 0 to execute the onSync callback of every property on each sync.
+ */
+#ifndef AIOT_CONFIG_INCREMENTAL_SYNC_ENABLED
+  #define AIOT_CONFIG_INCREMENTAL_SYNC_ENABLED (1)
+#endif
+
+/* Record property samples while the connection to the cloud is down and
+ * send them with their timestamps once it is restored. Samples are stored
+ * in the outbound message queue, hence its size limits how many messages
+ * worth of samples are kept; the oldest ones are dropped first.
+ */
+#ifndef AIOT_CONFIG_OFFLINE_SAMPLES_ENABLED
+  #define AIOT_CONFIG_OFFLINE_SAMPLES_ENABLED (0)
+#endif
+
+/* Run the cloud in a thread of its own on boards with an RTOS, i.e. mbed OS
+ * and FreeRTOS on the ESP32, started via ArduinoCloud.startThread(). The
+ * callbacks are then passed to the sketch which runs them from its loop()
+ * via ArduinoCloud.dispatch().
+ */
+#ifndef AIOT_CONFIG_THREADED_UPDATE_ENABLED
+  #define AIOT_CONFIG_THREADED_UPDATE_ENABLED (0)
+#endif
+
+#if AIOT_CONFIG_THREADED_UPDATE_ENABLED && defined(HAS_TCP) && (defined(ARDUINO_ARCH_MBED) || defined(ARDUINO_ARCH_ESP32))
+  #define HAS_CLOUD_THREAD
+#endif
+
+#ifndef AIOT_CONFIG_CLOUD_THREAD_STACK_SIZE
+  #define AIOT_CONFIG_CLOUD_THREAD_STACK_SIZE (8192)
+#endif
+
+/* Core the cloud thread is pinned to on a dual-core ESP32, so that the TLS
+ * records, the encoding and the hashing of OTA images keep off the core of
+ * loop(), e.g. 0 where the WiFi driver runs while loop() runs on core 1.
+ * Together with AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED the sketch then
+ * exchanges the values via store() and load() without waiting for the lock.
+ * -1 leaves the thread to the scheduler, as on the other boards.
+ */
+#ifndef AIOT_CONFIG_CLOUD_THREAD_CORE
+  #define AIOT_CONFIG_CLOUD_THREAD_CORE (-1)
+#endif
+
+/* Number of callbacks which can be waiting for ArduinoCloud.dispatch() */
+#ifndef AIOT_CONFIG_CLOUD_THREAD_CALLBACK_QUEUE_SIZE
+  #define AIOT_CONFIG_CLOUD_THREAD_CALLBACK_QUEUE_SIZE (16)
+#endif
+
+/* Run the callbacks of the properties written by the cloud from update()
+ * instead of from within the decoder, spending at most about
+ * AIOT_CONFIG_CALLBACK_BUDGET_us per call on them. The properties are sent
+ * once all the callbacks pending have run. See utility/task/CallbackQueue.h.
+ */
+#ifndef AIOT_CONFIG_DEFERRED_CALLBACKS_ENABLED
+  #define AIOT_CONFIG_DEFERRED_CALLBACKS_ENABLED (0)
+#endif
+
+#ifndef AIOT_CONFIG_CALLBACK_BUDGET_us
+  #define AIOT_CONFIG_CALLBACK_BUDGET_us (2000UL)
+#endif
+
+/* Callbacks which can be waiting, those beyond are run right away */
+#ifndef AIOT_CONFIG_CALLBACK_QUEUE_SIZE
+  #define AIOT_CONFIG_CALLBACK_QUEUE_SIZE (32)
+#endif
+
+#if AIOT_CONFIG_DEFERRED_CALLBACKS_ENABLED && defined(HAS_TCP)
+  #define HAS_DEFERRED_CALLBACKS
+#endif
+
+/* Allow a second core or an interrupt to write the numeric, boolean, colour
+ * and location properties via store() and to read them via load() while the
+ * cloud encodes them on the core calling update(). Costs two sequence locked
+ * copies of the value per property of these types.
+ */
+#ifndef AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+  #define AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED (0)
+#endif
+
+/* Record the state and phase of each update() on SAMD and mbed boards, after
+ * a watchdog reset they are reported via the device property WDT_STALL. The
+ * record has to be kept in RAM which survives the reset, hence also define
+ * AIOT_CONFIG_STALL_TRACE_SECTION as e.g. ".noinit".
+ */
+#ifndef AIOT_CONFIG_STALL_TRACE_ENABLED
+  #define AIOT_CONFIG_STALL_TRACE_ENABLED (0)
+#endif
+
+#if AIOT_CONFIG_STALL_TRACE_ENABLED && defined(HAS_TCP) && (defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_MBED))
+  #define HAS_STALL_TRACE
+#endif
+
+/* Time each update() per state and the encoding, decoding, sending, broker
+ * connection, time synchronisation and image hashing with micros(). See
+ * examples/utility/Benchmark for printing the results.
+ */
+#ifndef AIOT_CONFIG_PROFILING_ENABLED
+  #define AIOT_CONFIG_PROFILING_ENABLED (0)
+#endif
+
+#if AIOT_CONFIG_PROFILING_ENABLED && defined(HAS_TCP)
+  #define HAS_PROFILING
+#endif
+
+/* Keep counters of the traffic and the timing of the connection and report
+ * them at a low rate via the device property PERF.
+ */
+#ifndef AIOT_CONFIG_PERF_COUNTERS_ENABLED
+  #define AIOT_CONFIG_PERF_COUNTERS_ENABLED (0)
+#endif
+
+#ifndef AIOT_CONFIG_PERF_COUNTERS_INTERVAL_ms
+  #define AIOT_CONFIG_PERF_COUNTERS_INTERVAL_ms (15 * 60 * 1000UL)
+#endif
+
+/* Number of the most recent commands, i.e. changes received from the cloud,
+ * the latency percentiles reported via PERF are computed from.
+ */
+#ifndef AIOT_CONFIG_LATENCY_SAMPLES
+  #define AIOT_CONFIG_LATENCY_SAMPLES (32)
+#endif
+
+#if AIOT_CONFIG_PERF_COUNTERS_ENABLED && defined(HAS_TCP)
+  #define HAS_PERF_COUNTERS
+#endif
+
+/* Record AIOTC_TRACE() points at the state transitions, around encoding,
+ * decoding and polling and at each MQTT and TLS read or write into a ring
+ * buffer of fixed size binary records, see utility/trace/Trace.h. Each
+ * record takes 8 bytes, the size has to be a power of two.
+ */
+#ifndef AIOT_CONFIG_TRACE_ENABLED
+  #define AIOT_CONFIG_TRACE_ENABLED (0)
+#endif
+
+#ifndef AIOT_CONFIG_TRACE_BUFFER_SIZE
+  #define AIOT_CONFIG_TRACE_BUFFER_SIZE (64)
+#endif
+
+/* Lets the cloud capture the trace of a device in the field. Writing a
+ * number of seconds, at most AIOT_CONFIG_TRACE_CAPTURE_MAX_s, to the device
+ * property TRACE_REQ records the trace points for that long, 0 aborts. The
+ * records kept by the trace buffer are then uploaded through the device
+ * property TRACE in chunks of up to AIOT_CONFIG_TRACE_CAPTURE_CHUNK_SIZE
+ * bytes, one every AIOT_CONFIG_TRACE_CAPTURE_CHUNK_INTERVAL_ms while nothing
+ * else is waiting to be sent. Outside of a capture nothing is recorded.
+ */
+#ifndef AIOT_CONFIG_TRACE_CAPTURE_ENABLED
+  #define AIOT_CONFIG_TRACE_CAPTURE_ENABLED (0)
+#endif
+
+#ifndef AIOT_CONFIG_TRACE_CAPTURE_MAX_s
+  #define AIOT_CONFIG_TRACE_CAPTURE_MAX_s (60UL)
+#endif
+
+#ifndef AIOT_CONFIG_TRACE_CAPTURE_CHUNK_SIZE
+  #define AIOT_CONFIG_TRACE_CAPTURE_CHUNK_SIZE (132)
+#endif
+
+#ifndef AIOT_CONFIG_TRACE_CAPTURE_CHUNK_INTERVAL_ms
+  #define AIOT_CONFIG_TRACE_CAPTURE_CHUNK_INTERVAL_ms (1000UL)
+#endif
+
+#if AIOT_CONFIG_TRACE_CAPTURE_ENABLED && AIOT_CONFIG_TRACE_ENABLED && defined(HAS_TCP)
+  #define HAS_TRACE_CAPTURE
+#endif
+
+/* QoS level used for publishing messages to the broker */
+#ifndef AIOT_CONFIG_MQTT_PUBLISH_QOS
+  #define AIOT_CONFIG_MQTT_PUBLISH_QOS (0)
+#endif
+
+/* QoS level of the subscriptions of the thing data and shadow topics. With
+ * QoS 1 the broker delivers a command again until it is acknowledged, one
+ * delivered again is recognised among the last AIOT_CONFIG_MQTT_DEDUP_WINDOW
+ * messages received and acknowledged without applying it a second time.
+ */
+#ifndef AIOT_CONFIG_MQTT_SUBSCRIBE_QOS
+  #define AIOT_CONFIG_MQTT_SUBSCRIBE_QOS (0)
+#endif
+
+#ifndef AIOT_CONFIG_MQTT_DEDUP_WINDOW
+  #define AIOT_CONFIG_MQTT_DEDUP_WINDOW (8)
+#endif
+
+#if (AIOT_CONFIG_MQTT_SUBSCRIBE_QOS > 0) && defined(HAS_TCP)
+  #define HAS_MQTT_DEDUP
+#endif
+
+/* Endpoints of the broker which can be tried in turn, the one passed to
+ * begin() and those added via ArduinoCloud.addBrokerEndpoint().
+ */
+#ifndef AIOT_CONFIG_BROKER_ENDPOINT_CNT
+  #define AIOT_CONFIG_BROKER_ENDPOINT_CNT (3)
+#endif
+
+/* Time for which a broker address obtained from the resolver given via
+ * ArduinoCloud.setBrokerResolver() is used before it is resolved again.
+ */
+#ifndef AIOT_CONFIG_BROKER_ADDRESS_TTL_ms
+  #define AIOT_CONFIG_BROKER_ADDRESS_TTL_ms (30 * 60 * 1000UL)
+#endif
+
+/* Things of sub-devices which a gateway can add via ArduinoCloud.addThing()
+ * in addition to its own, see utility/gateway/CloudThing.h. They share the
+ * MQTT connection and the outbound message queue. Define as 0 to leave the
+ * gateway support out.
+ */
+#ifndef AIOT_CONFIG_GATEWAY_THING_CNT
+  #define AIOT_CONFIG_GATEWAY_THING_CNT (0)
+#endif
+
+#if (AIOT_CONFIG_GATEWAY_THING_CNT > 0) && defined(HAS_TCP)
+  #define HAS_GATEWAY
+#endif
+
+/* Mirror the property updates sent to the cloud to the peers on the LAN via
+ * UDP multicast, started with ArduinoCloud.beginLocalMirror(). Peers apply
+ * the updates of properties with the same names right away, the cloud stays
+ * authoritative. Frames carry the thing id and a HMAC-SHA256 tag keyed per
+ * thing, those of other things or failing the tag are dropped before being
+ * decoded, as are those replayed. See utility/net/LocalMirror.h.
+ */
+#ifndef AIOT_CONFIG_LOCAL_MIRROR_ENABLED
+  #define AIOT_CONFIG_LOCAL_MIRROR_ENABLED (0)
+#endif
+
+#ifndef AIOT_CONFIG_LOCAL_MIRROR_PORT
+  #define AIOT_CONFIG_LOCAL_MIRROR_PORT (5688)
+#endif
+
+/* Peers whose sequence numbers are tracked to drop reordered updates */
+#ifndef AIOT_CONFIG_LOCAL_MIRROR_PEER_CNT
+  #define AIOT_CONFIG_LOCAL_MIRROR_PEER_CNT (8)
+#endif
+
+#if AIOT_CONFIG_LOCAL_MIRROR_ENABLED && defined(HAS_TCP)
+  #define HAS_LOCAL_MIRROR
+#endif
+
+/* Consumers besides the cloud the thing updates are offered to, encoded once
+ * and by reference, added with ArduinoCloud.addMessageSink(). The local
+ * mirror takes one of them. See utility/net/MessageFanout.h.
+ */
+#ifndef AIOT_CONFIG_MESSAGE_SINK_CNT
+  #define AIOT_CONFIG_MESSAGE_SINK_CNT (AIOT_CONFIG_LOCAL_MIRROR_ENABLED)
+#endif
+
+#if (AIOT_CONFIG_MESSAGE_SINK_CNT > 0) && defined(HAS_TCP)
+  #define HAS_MESSAGE_FANOUT
+#endif
+
+#if defined(HAS_LOCAL_MIRROR) && !defined(HAS_MESSAGE_FANOUT)
+  #error "AIOT_CONFIG_LOCAL_MIRROR_ENABLED requires AIOT_CONFIG_MESSAGE_SINK_CNT > 0"
+#endif
+
+/* Split the cloud between the cores of the Portenta H7 and the GIGA: one runs
+ * the connection, the other one the thing properties and their encoding. The
+ * messages are passed through a lock-free ring in each direction within
+ * AIOT_CONFIG_CORE_LINK_SIZE bytes at AIOT_CONFIG_CORE_LINK_ADDRESS, SRAM4 by
+ * default which both cores reach. See utility/thread/CoreLink.h.
+ */
+#ifndef AIOT_CONFIG_CORE_LINK_ENABLED
+  #define AIOT_CONFIG_CORE_LINK_ENABLED (0)
+#endif
+
+#ifndef AIOT_CONFIG_CORE_LINK_ADDRESS
+  #define AIOT_CONFIG_CORE_LINK_ADDRESS (0x38000000UL)
+#endif
+
+#ifndef AIOT_CONFIG_CORE_LINK_SIZE
+  #define AIOT_CONFIG_CORE_LINK_SIZE (16 * 1024)
+#endif
+
+#if AIOT_CONFIG_CORE_LINK_ENABLED && defined(HAS_TCP) && (defined(ARDUINO_PORTENTA_H7_M7) || defined(ARDUINO_PORTENTA_H7_M4) || defined(ARDUINO_GIGA) || defined(HOST))
+  #define HAS_CORE_LINK
+#endif
+
+/* Evaluate the rules of the device property RULES on the properties of the
+ * thing, also while the connection is down, see utility/rules/RuleEngine.h.
+ * The program is received into a buffer of AIOT_CONFIG_RULES_PROGRAM_SIZE
+ * bytes, a larger one is ignored.
+ */
+#ifndef AIOT_CONFIG_RULES_ENABLED
+  #define AIOT_CONFIG_RULES_ENABLED (0)
+#endif
+
+#ifndef AIOT_CONFIG_RULES_PROGRAM_SIZE
+  #define AIOT_CONFIG_RULES_PROGRAM_SIZE (128)
+#endif
+
+#if AIOT_CONFIG_RULES_ENABLED && defined(HAS_TCP)
+  #define HAS_RULES
+#endif
+
+/* Keep the values of the properties writeable by the cloud in flash across
+ * restarts, stored by ArduinoCloud.setPropertyCache() before begin(). They
+ * are written at most every AIOT_CONFIG_PROPERTY_CACHE_INTERVAL_ms if they
+ * have been changed, see utility/storage/PropertyCache.h.
+ */
+#ifndef AIOT_CONFIG_PROPERTY_CACHE_ENABLED
+  #define AIOT_CONFIG_PROPERTY_CACHE_ENABLED (0)
+#endif
+
+#ifndef AIOT_CONFIG_PROPERTY_CACHE_SIZE
+  #define AIOT_CONFIG_PROPERTY_CACHE_SIZE (256)
+#endif
+
+#ifndef AIOT_CONFIG_PROPERTY_CACHE_INTERVAL_ms
+  #define AIOT_CONFIG_PROPERTY_CACHE_INTERVAL_ms (30000UL)
+#endif
+
+#if AIOT_CONFIG_PROPERTY_CACHE_ENABLED && defined(HAS_TCP)
+  #define HAS_PROPERTY_CACHE
+#endif
+
+/* Take the property wrappers, the copied names, the aggregators and the extra
+ * state of the properties from a static arena of AIOT_CONFIG_STATIC_ARENA_SIZE
+ * bytes instead of the heap, see utility/memory/StaticArena.h. The arena is
+ * not locked, hence it is not available together with the cloud thread.
+ * With AIOT_CONFIG_HEAP_GUARD_ENABLED any call of malloc() once the device
+ * has been connected fails an assertion, on SAMD boards only.
+ */
+#ifndef AIOT_CONFIG_STATIC_ALLOCATION_ENABLED
+  #define AIOT_CONFIG_STATIC_ALLOCATION_ENABLED (0)
+#endif
+
+#ifndef AIOT_CONFIG_STATIC_ARENA_SIZE
+  #define AIOT_CONFIG_STATIC_ARENA_SIZE (2048)
+#endif
+
+#ifndef AIOT_CONFIG_HEAP_GUARD_ENABLED
+  #define AIOT_CONFIG_HEAP_GUARD_ENABLED (0)
+#endif
+
+#if AIOT_CONFIG_STATIC_ALLOCATION_ENABLED && defined(HAS_CLOUD_THREAD)
+  #error "AIOT_CONFIG_STATIC_ALLOCATION_ENABLED can not be combined with AIOT_CONFIG_THREADED_UPDATE_ENABLED"
+#endif
+
+/* Size of the static buffer shared by the scratch buffers of the decoder,
+ * of the compression and of an OTA update, see utility/memory/ScratchPool.h.
+ * A larger scratch buffer is allocated from the heap while it is in use.
+ */
+#ifndef AIOT_CONFIG_SCRATCH_POOL_SIZE
+  #if AIOT_CONFIG_CBOR_DECODER_BUFFER_SIZE > AIOT_CONFIG_COMPRESSION_BUFFER_SIZE
+    #define AIOT_CONFIG_SCRATCH_POOL_SIZE AIOT_CONFIG_CBOR_DECODER_BUFFER_SIZE
+  #else
+    #define AIOT_CONFIG_SCRATCH_POOL_SIZE AIOT_CONFIG_COMPRESSION_BUFFER_SIZE
+  #endif
+#endif
+
+/* Ping the broker only once the connection has been idle for as long as the
+ * NAT on the way is found to allow, see utility/mqtt/AdaptiveKeepAlive.h.
+ * The interval is probed from the minimum up to the maximum of the network
+ * adapter, which is announced to the broker on connect. Define as 0 to ping
+ * every AIOT_CONFIG_KEEP_ALIVE_MIN_ms.
+ */
+#ifndef AIOT_CONFIG_ADAPTIVE_KEEP_ALIVE_ENABLED
+  #define AIOT_CONFIG_ADAPTIVE_KEEP_ALIVE_ENABLED (1)
+#endif
+
+#ifndef AIOT_CONFIG_KEEP_ALIVE_MIN_ms
+  #define AIOT_CONFIG_KEEP_ALIVE_MIN_ms (30 * 1000UL)
+#endif
+
+#ifndef AIOT_CONFIG_KEEP_ALIVE_MAX_ETHERNET_ms
+  #define AIOT_CONFIG_KEEP_ALIVE_MAX_ETHERNET_ms (20 * 60 * 1000UL)
+#endif
+
+#ifndef AIOT_CONFIG_KEEP_ALIVE_MAX_WIFI_ms
+  #define AIOT_CONFIG_KEEP_ALIVE_MAX_WIFI_ms (10 * 60 * 1000UL)
+#endif
+
+/* GSM, NB-IoT, CAT-M1 and any other adapter */
+#ifndef AIOT_CONFIG_KEEP_ALIVE_MAX_CELLULAR_ms
+  #define AIOT_CONFIG_KEEP_ALIVE_MAX_CELLULAR_ms (10 * 60 * 1000UL)
+#endif
+
+#if AIOT_CONFIG_ADAPTIVE_KEEP_ALIVE_ENABLED && defined(HAS_TCP)
+  #define HAS_ADAPTIVE_KEEP_ALIVE
+#endif
+
+/* Send the thing updates and the pings only within the windows in which a
+ * modem saving power in cycles is awake anyway, e.g. the eDRX cycle of the
+ * MKR NB 1500, once set with ArduinoCloud.setTransmitWindow(). Between the
+ * windows a network reported down for up to the grace period does not end
+ * the MQTT session as long as the socket is still connected.
+ */
+#ifndef AIOT_CONFIG_TRANSMIT_WINDOW_ENABLED
+  #define AIOT_CONFIG_TRANSMIT_WINDOW_ENABLED (1)
+#endif
+
+#ifndef AIOT_CONFIG_TRANSMIT_WINDOW_SUSPEND_GRACE_ms
+  #define AIOT_CONFIG_TRANSMIT_WINDOW_SUSPEND_GRACE_ms (60 * 1000UL)
+#endif
+
+#if AIOT_CONFIG_TRANSMIT_WINDOW_ENABLED && defined(HAS_TCP)
+  #define HAS_TRANSMIT_WINDOW
+#endif
+
+/* Hold the thing updates for a while after each message while the link is
+ * bad, the changes made meanwhile are then sent together. Slow or failing
+ * writes and messages sent again after a connection loss widen the hold
+ * time, fast writes narrow it again, see utility/net/PublishRateControl.h.
+ * A signal reported weaker than AIOT_CONFIG_RATE_CONTROL_WEAK_SIGNAL_dBm with
+ * ArduinoCloud.setSignalStrength() keeps a minimum hold time.
+ */
+#ifndef AIOT_CONFIG_RATE_CONTROL_ENABLED
+  #define AIOT_CONFIG_RATE_CONTROL_ENABLED (1)
+#endif
+
+#ifndef AIOT_CONFIG_RATE_CONTROL_SLOW_WRITE_ms
+  #define AIOT_CONFIG_RATE_CONTROL_SLOW_WRITE_ms (500UL)
+#endif
+
+#ifndef AIOT_CONFIG_RATE_CONTROL_MIN_HOLD_ms
+  #define AIOT_CONFIG_RATE_CONTROL_MIN_HOLD_ms (1000UL)
+#endif
+
+#ifndef AIOT_CONFIG_RATE_CONTROL_MAX_HOLD_ms
+  #define AIOT_CONFIG_RATE_CONTROL_MAX_HOLD_ms (30 * 1000UL)
+#endif
+
+#ifndef AIOT_CONFIG_RATE_CONTROL_WEAK_SIGNAL_dBm
+  #define AIOT_CONFIG_RATE_CONTROL_WEAK_SIGNAL_dBm (-90)
+#endif
+
+#ifndef AIOT_CONFIG_RATE_CONTROL_WEAK_SIGNAL_HOLD_ms
+  #define AIOT_CONFIG_RATE_CONTROL_WEAK_SIGNAL_HOLD_ms (5 * 1000UL)
+#endif
+
+#if AIOT_CONFIG_RATE_CONTROL_ENABLED && defined(HAS_TCP)
+  #define HAS_RATE_CONTROL
+#endif
+
+/* Keep the data sent within a budget per time window, e.g. the data plan of
+ * a SIM, once set with ArduinoCloud.setDataBudget(). All messages count
+ * against it, but only the thing updates are held back: they are encoded
+ * into what is left of the budget, the changes which do not fit remain
+ * pending and go out with their latest value once it has refilled. Nothing
+ * is encoded while less than AIOT_CONFIG_DATA_BUDGET_MIN_BYTES are left for
+ * the payload besides the topic.
+ */
+#ifndef AIOT_CONFIG_DATA_BUDGET_ENABLED
+  #define AIOT_CONFIG_DATA_BUDGET_ENABLED (1)
+#endif
+
+#ifndef AIOT_CONFIG_DATA_BUDGET_MIN_BYTES
+  #define AIOT_CONFIG_DATA_BUDGET_MIN_BYTES (32)
+#endif
+
+#if AIOT_CONFIG_DATA_BUDGET_ENABLED && defined(HAS_TCP)
+  #define HAS_DATA_BUDGET
+#endif
+
+/* Send a backlog of thing updates, e.g. after a reconnect, back to back with
+ * up to AIOT_CONFIG_BURST_MSG_CNT messages per update() instead of one, as
+ * long as less than AIOT_CONFIG_BURST_TIME_ms have passed and less than
+ * AIOT_CONFIG_BURST_BYTES have been written within the same call. The burst
+ * ends early once a message could not be written or the rate control or the
+ * data budget hold the updates back.
+ */
+#ifndef AIOT_CONFIG_BURST_MSG_CNT
+  #define AIOT_CONFIG_BURST_MSG_CNT (8)
+#endif
+
+#ifndef AIOT_CONFIG_BURST_TIME_ms
+  #define AIOT_CONFIG_BURST_TIME_ms (100UL)
+#endif
+
+#ifndef AIOT_CONFIG_BURST_BYTES
+  #define AIOT_CONFIG_BURST_BYTES (2048)
+#endif
+
+#if (AIOT_CONFIG_BURST_MSG_CNT > 1) && defined(HAS_TCP)
+  #define HAS_BURST_FLUSH
+#endif
+
+/* Refresh the time zone information once it expired by a request on the
+ * device topic, which the cloud answers with tz_offset and tz_dst_until,
+ * instead of requesting all the last values of the thing again. The thing
+ * updates go on meanwhile. Without a reply to any of the retries the last
+ * values are requested as before.
+ */
+#ifndef AIOT_CONFIG_TIMEZONE_REQUEST_ENABLED
+  #define AIOT_CONFIG_TIMEZONE_REQUEST_ENABLED (1)
+#endif
+
+#if AIOT_CONFIG_TIMEZONE_REQUEST_ENABLED && defined(HAS_TCP)
+  #define HAS_TIMEZONE_REQUEST
+#endif
+
 /******************************************************************************
  * CONSTANTS
  ******************************************************************************/
@@ -163,9 +977,24 @@
 #define AIOT_CONFIG_MAX_DEVICE_TOPIC_ATTACH_RETRY_DELAY_ms      (1280000UL)
 #define AIOT_CONFIG_TIMEOUT_FOR_LASTVALUES_SYNC_ms                (30000UL)
 #define AIOT_CONFIG_LASTVALUES_SYNC_MAX_RETRY_CNT                    (10UL)
+#define AIOT_CONFIG_TIMEOUT_FOR_TIMEZONE_REQUEST_ms               (30000UL)
+#define AIOT_CONFIG_TIMEZONE_REQUEST_MAX_RETRY_CNT                    (3UL)
+#define AIOT_CONFIG_TLS_HANDSHAKE_TIMEOUT_ms                      (30000UL)
+#define AIOT_CONFIG_CLOUD_THREAD_POLL_INTERVAL_ms                    (50UL)
+#define AIOT_CONFIG_MQTT_IDLE_POLL_INTERVAL_ms                     (1000UL)
 
 #define AIOT_CONFIG_RP2040_OTA_HTTP_HEADER_RECEIVE_TIMEOUT_ms   (10*1000UL)
 #define AIOT_CONFIG_RP2040_OTA_HTTP_DATA_RECEIVE_TIMEOUT_ms   (4*60*1000UL)
+#define AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE                        (4096UL)
+#define AIOT_CONFIG_RP2040_OTA_WRITE_BUFFER_SIZE                   (4096UL)
+#define AIOT_CONFIG_RP2040_OTA_MAX_RESUME_CNT                         (3UL)
+#define AIOT_CONFIG_PORTENTA_OTA_HTTP_HEADER_RECEIVE_TIMEOUT_ms (10*1000UL)
+#define AIOT_CONFIG_PORTENTA_OTA_HTTP_DATA_RECEIVE_TIMEOUT_ms (4*60*1000UL)
+#define AIOT_CONFIG_PORTENTA_OTA_WRITE_BUFFER_SIZE                 (4096UL)
+#define AIOT_CONFIG_SAMD_OTA_HTTP_HEADER_RECEIVE_TIMEOUT_ms     (10*1000UL)
+#define AIOT_CONFIG_SAMD_OTA_HTTP_DATA_RECEIVE_TIMEOUT_ms     (4*60*1000UL)
+#define AIOT_CONFIG_ESP32_OTA_HTTP_HEADER_RECEIVE_TIMEOUT_ms    (10*1000UL)
+#define AIOT_CONFIG_ESP32_OTA_HTTP_DATA_RECEIVE_TIMEOUT_ms    (4*60*1000UL)
 
 #define AIOT_CONFIG_LIB_VERSION "1.11.0"
 
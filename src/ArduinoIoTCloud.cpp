@@ -21,6 +21,9 @@
 
 #include <ArduinoIoTCloud.h>
 
+#include "utility/time/ScheduleTimer.h"
+#include "utility/memory/StaticArena.h"
+
 /******************************************************************************
    CTOR/DTOR
  ******************************************************************************/
@@ -29,6 +32,8 @@ ArduinoIoTCloudClass::ArduinoIoTCloudClass()
 : _connection{nullptr}
 , _last_checked_property_index{0}
 , _time_service(TimeService)
+, _batch_depth{0}
+, _batch_committed{false}
 , _tz_offset{0}
 , _tz_dst_until{0}
 , _thing_id{""}
@@ -36,6 +41,7 @@ ArduinoIoTCloudClass::ArduinoIoTCloudClass()
 , _device_id{""}
 , _cloud_event_callback{nullptr}
 , _thing_id_outdated{false}
+, _groups{nullptr}
 {
 
 }
@@ -49,7 +55,77 @@ void ArduinoIoTCloudClass::push()
   requestUpdateForAllProperties(_thing_property_container);
 }
 
+bool ArduinoIoTCloudClass::push(Property & property)
+{
+  return requestUpdateForProperty(_thing_property_container, &property);
+}
+
+bool ArduinoIoTCloudClass::push(bool & property)
+{
+  return requestUpdateForProperty(_thing_property_container, getPrimitiveProperty(_thing_property_container, &property));
+}
+
+bool ArduinoIoTCloudClass::push(float & property)
+{
+  return requestUpdateForProperty(_thing_property_container, getPrimitiveProperty(_thing_property_container, &property));
+}
+
+bool ArduinoIoTCloudClass::push(int & property)
+{
+  return requestUpdateForProperty(_thing_property_container, getPrimitiveProperty(_thing_property_container, &property));
+}
+
+bool ArduinoIoTCloudClass::push(unsigned int & property)
+{
+  return requestUpdateForProperty(_thing_property_container, getPrimitiveProperty(_thing_property_container, &property));
+}
+
+bool ArduinoIoTCloudClass::push(String & property)
+{
+  return requestUpdateForProperty(_thing_property_container, getPrimitiveProperty(_thing_property_container, &property));
+}
+
+bool ArduinoIoTCloudClass::push(PropertyGroup const & group)
+{
+  return requestUpdateForGroup(_thing_property_container, group);
+}
+
+PropertyGroup & ArduinoIoTCloudClass::group(char const * name)
+{
+  for (PropertyGroup * g = _groups; g; g = g->next())
+  {
+    if (strcmp(g->name(), name) == 0)
+      return *g;
+  }
+  PropertyGroup * g = arenaNew<PropertyGroup>(name);
+  g->setNext(_groups);
+  _groups = g;
+  return *g;
+}
+
+void ArduinoIoTCloudClass::beginBatch()
+{
+  _batch_depth++;
+}
+
+void ArduinoIoTCloudClass::commitBatch()
+{
+  if (_batch_depth == 0)
+    return;
+
+  if (--_batch_depth == 0)
+  {
+    requestUpdateForChangedProperties(_thing_property_container);
+    _batch_committed = true;
+  }
+}
+
 bool ArduinoIoTCloudClass::setTimestamp(String const & prop_name, unsigned long const timestamp)
+{
+  return setTimestamp(prop_name.c_str(), timestamp);
+}
+
+bool ArduinoIoTCloudClass::setTimestamp(char const * prop_name, unsigned long const timestamp)
 {
   Property * p = getProperty(_thing_property_container, prop_name);
 
@@ -95,27 +171,27 @@ Property& ArduinoIoTCloudClass::addPropertyReal(Property& property, String name,
 /* The following methods are used for both LoRa and non-Lora boards */
 Property& ArduinoIoTCloudClass::addPropertyReal(bool& property, String name, int tag, Permission const permission)
 {
-  Property* p = new CloudWrapperBool(property);
+  Property* p = arenaNew<CloudWrapperBool>(property);
   return addPropertyReal(*p, name, tag, permission);
 }
 Property& ArduinoIoTCloudClass::addPropertyReal(float& property, String name, int tag, Permission const permission)
 {
-  Property* p = new CloudWrapperFloat(property);
+  Property* p = arenaNew<CloudWrapperFloat>(property);
   return addPropertyReal(*p, name, tag, permission);
 }
 Property& ArduinoIoTCloudClass::addPropertyReal(int& property, String name, int tag, Permission const permission)
 {
-  Property* p = new CloudWrapperInt(property);
+  Property* p = arenaNew<CloudWrapperInt>(property);
   return addPropertyReal(*p, name, tag, permission);
 }
 Property& ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, String name, int tag, Permission const permission)
 {
-  Property* p = new CloudWrapperUnsignedInt(property);
+  Property* p = arenaNew<CloudWrapperUnsignedInt>(property);
   return addPropertyReal(*p, name, tag, permission);
 }
 Property& ArduinoIoTCloudClass::addPropertyReal(String& property, String name, int tag, Permission const permission)
 {
-  Property* p = new CloudWrapperString(property);
+  Property* p = arenaNew<CloudWrapperString>(property);
   return addPropertyReal(*p, name, tag, permission);
 }
 Property& ArduinoIoTCloudClass::addPropertyReal(Property& property, String name, int tag, Permission const permission)
@@ -123,6 +199,60 @@ Property& ArduinoIoTCloudClass::addPropertyReal(Property& property, String name,
   return addPropertyToContainer(_thing_property_container, property, name, permission, tag);
 }
 
+Property& ArduinoIoTCloudClass::addPropertyReal(bool& property, char const * name, Permission const permission)
+{
+  return addPropertyReal(property, name, -1, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(float& property, char const * name, Permission const permission)
+{
+  return addPropertyReal(property, name, -1, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(int& property, char const * name, Permission const permission)
+{
+  return addPropertyReal(property, name, -1, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, char const * name, Permission const permission)
+{
+  return addPropertyReal(property, name, -1, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(String& property, char const * name, Permission const permission)
+{
+  return addPropertyReal(property, name, -1, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(Property& property, char const * name, Permission const permission)
+{
+  return addPropertyReal(property, name, -1, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(bool& property, char const * name, int tag, Permission const permission)
+{
+  Property* p = arenaNew<CloudWrapperBool>(property);
+  return addPropertyReal(*p, name, tag, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(float& property, char const * name, int tag, Permission const permission)
+{
+  Property* p = arenaNew<CloudWrapperFloat>(property);
+  return addPropertyReal(*p, name, tag, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(int& property, char const * name, int tag, Permission const permission)
+{
+  Property* p = arenaNew<CloudWrapperInt>(property);
+  return addPropertyReal(*p, name, tag, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, char const * name, int tag, Permission const permission)
+{
+  Property* p = arenaNew<CloudWrapperUnsignedInt>(property);
+  return addPropertyReal(*p, name, tag, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(String& property, char const * name, int tag, Permission const permission)
+{
+  Property* p = arenaNew<CloudWrapperString>(property);
+  return addPropertyReal(*p, name, tag, permission);
+}
+Property& ArduinoIoTCloudClass::addPropertyReal(Property& property, char const * name, int tag, Permission const permission)
+{
+  return addPropertyToContainer(_thing_property_container, property, name, permission, tag);
+}
+
 /* The following methods are deprecated but still used for non-LoRa boards */
 void ArduinoIoTCloudClass::addPropertyReal(bool& property, String name, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
@@ -152,27 +282,27 @@ void ArduinoIoTCloudClass::addPropertyReal(Property& property, String name, perm
 /* The following methods are deprecated but still used for both LoRa and non-LoRa boards */
 void ArduinoIoTCloudClass::addPropertyReal(bool& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperBool(property);
+  Property* p = arenaNew<CloudWrapperBool>(property);
   addPropertyReal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
 void ArduinoIoTCloudClass::addPropertyReal(float& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperFloat(property);
+  Property* p = arenaNew<CloudWrapperFloat>(property);
   addPropertyReal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
 void ArduinoIoTCloudClass::addPropertyReal(int& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperInt(property);
+  Property* p = arenaNew<CloudWrapperInt>(property);
   addPropertyReal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
 void ArduinoIoTCloudClass::addPropertyReal(unsigned int& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperUnsignedInt(property);
+  Property* p = arenaNew<CloudWrapperUnsignedInt>(property);
   addPropertyReal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
 void ArduinoIoTCloudClass::addPropertyReal(String& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
 {
-  Property* p = new CloudWrapperString(property);
+  Property* p = arenaNew<CloudWrapperString>(property);
   addPropertyReal(*p, name, tag, permission_type, seconds, fn, minDelta, synFn);
 }
 void ArduinoIoTCloudClass::addPropertyReal(Property& property, String name, int tag, permissionType permission_type, long seconds, void(*fn)(void), float minDelta, void(*synFn)(Property & property))
@@ -205,6 +335,29 @@ void ArduinoIoTCloudClass::execCloudEventCallback(ArduinoIoTCloudEvent const eve
   }
 }
 
+unsigned long ArduinoIoTCloudClass::thingNextUpdateIn()
+{
+  unsigned long const property_wait = millisUntilNextUpdate(_thing_property_container, millis());
+  unsigned long const schedule_wait = scheduleNextUpdateIn();
+  return (schedule_wait < property_wait) ? schedule_wait : property_wait;
+}
+
+unsigned long ArduinoIoTCloudClass::scheduleNextUpdateIn()
+{
+#if AIOT_CONFIG_SCHEDULE_ENABLED
+  /* The schedules are evaluated against the local time in seconds */
+  unsigned long long edge = 0;
+  if (!ScheduleTimer.nextEdge(edge))
+    return ULONG_MAX;
+
+  unsigned long long const now = getLocalTime();
+  unsigned long long const edge_ms = (edge > now) ? (edge - now) * 1000ULL : 0;
+  return (edge_ms < ULONG_MAX) ? static_cast<unsigned long>(edge_ms) : ULONG_MAX;
+#else
+  return ULONG_MAX;
+#endif
+}
+
 __attribute__((weak)) void setDebugMessageLevel(int const /* level */)
 {
   /* do nothing */
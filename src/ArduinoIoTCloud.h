@@ -41,8 +41,11 @@
 #include "property/types/CloudWrapperInt.h"
 #include "property/types/CloudWrapperUnsignedInt.h"
 #include "property/types/CloudWrapperString.h"
+#include "property/types/CloudWrapperArray.h"
 
 #include "utility/time/TimeService.h"
+#include "utility/memory/MemoryPool.h"
+#include "utility/memory/StaticArena.h"
 
 /******************************************************************************
    TYPEDEF
@@ -87,9 +90,40 @@ class ArduinoIoTCloudClass
     virtual void update        () = 0;
     virtual int  connected     () = 0;
     virtual void printDebugInfo() = 0;
+    /* Milliseconds until update() has to be called again, 0 if there is work
+     * pending, so that the sketch can sleep in between. Messages arriving from
+     * the network and changes to properties made by the sketch are not
+     * predictable, call update() whenever one of them may have happened.
+     */
+    virtual unsigned long nextUpdateIn() = 0;
 
             void push();
+            /* Send just the given properties with the next update, changed
+             * or not, instead of all of them as push() does. Return false
+             * if one of them is not a property of the thing.
+             */
+            bool push(Property & property);
+            bool push(bool & property);
+            bool push(float & property);
+            bool push(int & property);
+            bool push(unsigned int & property);
+            bool push(String & property);
+            bool push(PropertyGroup const & group);
+            /* The group of the given name, created on first use, see PropertyGroup */
+            PropertyGroup & group(char const * name);
+    template <typename T1, typename T2, typename... Ts>
+    inline  bool push(T1 & first, T2 & second, Ts & ... rest) {
+      bool const is_pushed = push(first);
+      return push(second, rest...) && is_pushed;
+    }
+            /* Properties changed between beginBatch() and commitBatch() are
+             * not sent until the batch is committed and then go out together.
+             */
+            void beginBatch();
+            void commitBatch();
+    inline  bool batchActive() const                    { return _batch_depth > 0; }
             bool setTimestamp(String const & prop_name, unsigned long const timestamp);
+            bool setTimestamp(char const * prop_name, unsigned long const timestamp);
 
     inline void     setThingId (String const thing_id)  { _thing_id = thing_id; };
     inline String & getThingId ()                       { return _thing_id; };
@@ -105,11 +139,17 @@ class ArduinoIoTCloudClass
     inline ConnectionHandler * getConnection()          { return _connection; }
 
     inline unsigned long getInternalTime()              { return _time_service.getTime(); }
+    inline uint64_t      getInternalTimeMillis()        { return _time_service.getTimeMillis(); }
     inline unsigned long getLocalTime()                 { return _time_service.getLocalTime(); }
     inline void          updateInternalTimezoneInfo()   { _time_service.setTimeZoneData(_tz_offset, _tz_dst_until); }
 
     void addCallback(ArduinoIoTCloudEvent const event, OnCloudEventCallback callback);
 
+    /* Takes the memory of a pool from the allocator instead of the heap, to
+     * be called at the start of setup(), see utility/memory/MemoryPool.h.
+     */
+    inline void setAllocator(MemoryPool const pool, MemoryAllocator & allocator) { setMemoryAllocator(pool, &allocator); }
+
 #define addProperty( v, ...) addPropertyReal(v, #v, __VA_ARGS__)
 
     /* The following methods are used for non-LoRa boards which can use the 
@@ -129,6 +169,23 @@ class ArduinoIoTCloudClass
     Property& addPropertyReal(int& property, String name, Permission const permission);
     Property& addPropertyReal(unsigned int& property, String name, Permission const permission);
     Property& addPropertyReal(String& property, String name, Permission const permission);
+    /* A name passed as char const *, e.g. by addProperty(), is copied */
+    Property& addPropertyReal(Property& property, char const * name, Permission const permission);
+    Property& addPropertyReal(bool& property, char const * name, Permission const permission);
+    Property& addPropertyReal(float& property, char const * name, Permission const permission);
+    Property& addPropertyReal(int& property, char const * name, Permission const permission);
+    Property& addPropertyReal(unsigned int& property, char const * name, Permission const permission);
+    Property& addPropertyReal(String& property, char const * name, Permission const permission);
+    /* A C array of primitives, e.g. float temps[16], bound as a single property */
+    template <typename T, size_t N>
+    Property& addPropertyReal(T (&property)[N], char const * name, Permission const permission) {
+      return addPropertyReal(property, name, -1, permission);
+    }
+    template <typename T, size_t N>
+    Property& addPropertyReal(T (&property)[N], char const * name, int tag, Permission const permission) {
+      Property* p = arenaNew<CloudWrapperArray<T, N>>(property);
+      return addPropertyReal(*p, name, tag, permission);
+    }
 
     /* The following methods are for MKR WAN 1300/1310 LoRa boards since
      * they use a number to identify a given property within a CBOR message.
@@ -149,6 +206,32 @@ class ArduinoIoTCloudClass
     Property& addPropertyReal(int& property, String name, int tag, Permission const permission);
     Property& addPropertyReal(unsigned int& property, String name, int tag, Permission const permission);
     Property& addPropertyReal(String& property, String name, int tag, Permission const permission);
+    Property& addPropertyReal(Property& property, char const * name, int tag, Permission const permission);
+    Property& addPropertyReal(bool& property, char const * name, int tag, Permission const permission);
+    Property& addPropertyReal(float& property, char const * name, int tag, Permission const permission);
+    Property& addPropertyReal(int& property, char const * name, int tag, Permission const permission);
+    Property& addPropertyReal(unsigned int& property, char const * name, int tag, Permission const permission);
+    Property& addPropertyReal(String& property, char const * name, int tag, Permission const permission);
+
+    /* Reports a change of a primitive variable added as a property with
+     * manualChangeDetection(), returns false if there is no such property.
+     */
+    template <typename T>
+    inline bool markDirty(T & value) {
+      Property * p = getPrimitiveProperty(_thing_property_container, &value);
+      if (p == nullptr)
+        return false;
+      p->markChanged();
+      return true;
+    }
+
+    /* Adds all properties of a thing at once from a constant table, which
+     * is checked against the container capacity at compile time.
+     */
+    template <size_t N>
+    inline bool addProperties(PropertySchemaEntry const (&schema)[N]) {
+      return addPropertiesToContainer(_thing_property_container, schema);
+    }
 
   protected:
 
@@ -157,18 +240,24 @@ class ArduinoIoTCloudClass
     PropertyContainer _thing_property_container;
     unsigned int _last_checked_property_index;
     TimeServiceClass & _time_service;
+    unsigned int _batch_depth;
+    bool _batch_committed;
     int _tz_offset;
     unsigned int _tz_dst_until;
     String _thing_id;
     String _lib_version;
 
-    void execCloudEventCallback(ArduinoIoTCloudEvent const event);
+    virtual void execCloudEventCallback(ArduinoIoTCloudEvent const event);
+    /* Time until a thing property or a schedule transition is due, ULONG_MAX if none */
+    unsigned long thingNextUpdateIn();
+    unsigned long scheduleNextUpdateIn();
 
   private:
 
     String _device_id;
     OnCloudEventCallback _cloud_event_callback[3];
     bool _thing_id_outdated;
+    PropertyGroup * _groups;
 };
 
 #ifdef HAS_TCP
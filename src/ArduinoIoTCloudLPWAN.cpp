@@ -26,12 +26,17 @@
 #include<ArduinoIoTCloudLPWAN.h>
 
 #include "cbor/CBOREncoder.h"
+#include "utility/time/ScheduleTimer.h"
+#include "utility/memory/StaticArena.h"
 
 /******************************************************************************
    CONSTANTS
  ******************************************************************************/
 
 static size_t const CBOR_LORA_MSG_MAX_SIZE = 255;
+static size_t const LORA_MAX_DOWNLINKS_PER_UPDATE = 4;
+/* Network time older than this is refreshed with the next uplink */
+static unsigned long const LORA_NETWORK_TIME_MAX_AGE_ms = 24 * 60 * 60 * 1000UL;
 
 /******************************************************************************
    LOCAL MODULE FUNCTIONS
@@ -42,6 +47,16 @@ unsigned long getTime()
   return ArduinoCloud.getInternalTime();
 }
 
+static unsigned long getNetworkTime()
+{
+  return ArduinoCloud.getNetworkTime();
+}
+
+static void updateTimezoneInfo()
+{
+  ArduinoCloud.updateInternalTimezoneInfo();
+}
+
 /******************************************************************************
    CTOR/DTOR
  ******************************************************************************/
@@ -51,6 +66,16 @@ ArduinoIoTCloudLPWAN::ArduinoIoTCloudLPWAN()
 , _retryEnable{false}
 , _maxNumRetry{5}
 , _intervalRetry{1000}
+, _duty_cycle{}
+, _pending_msg_length{0}
+, _pending_msg_retries{0}
+, _pending_msg_confirmed{false}
+, _pending_msg_port{LoRaPort::Thing}
+, _last_checked_device_property_index{0}
+, _pending_msg_retry_tick{0}
+, _network_time{0}
+, _network_time_tick{0}
+, _uplink_func{nullptr}
 {
 
 }
@@ -69,6 +94,18 @@ int ArduinoIoTCloudLPWAN::begin(ConnectionHandler& connection, bool retry)
   _connection = &connection;
   _retryEnable = retry;
   _time_service.begin(nullptr);
+  _time_service.setSyncFunction(::getNetworkTime);
+
+  /* Exchanged on their own port, see setUplinkFunction() */
+  Property * p;
+  p = arenaNew<CloudWrapperString>(_lib_version);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("LIB_VERSION"), Permission::Read, -1);
+  p = arenaNew<CloudWrapperString>(_thing_id);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("thing_id"), Permission::ReadWrite, -1);
+  p = arenaNew<CloudWrapperInt>(_tz_offset);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("tz_offset"), Permission::Write, -1).onUpdate(updateTimezoneInfo);
+  p = arenaNew<CloudWrapperUnsignedInt>(_tz_dst_until);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("tz_dst_until"), Permission::Write, -1).onUpdate(updateTimezoneInfo);
   return 1;
 }
 
@@ -83,6 +120,83 @@ void ArduinoIoTCloudLPWAN::update()
   case State::Connected:  next_state = handle_Connected();  break;
   }
   _state = next_state;
+
+#if AIOT_CONFIG_SCHEDULE_ENABLED
+  /* Fire the callbacks of the schedules whose next transition is due */
+  if ((_state == State::Connected) && ScheduleTimer.isPending())
+    ScheduleTimer.poll(getLocalTime());
+#endif
+}
+
+unsigned long ArduinoIoTCloudLPWAN::nextUpdateIn()
+{
+  if ((_state != State::Connected) || _connection->available())
+    return 0;
+
+  unsigned long const now = millis();
+  unsigned long wait = 0;
+
+  if (_pending_msg_length > 0)
+  {
+    /* The failed uplink is retried after the retry interval */
+    unsigned long const elapsed = now - _pending_msg_retry_tick;
+    unsigned long const interval = static_cast<unsigned long>(_intervalRetry);
+    if ((_pending_msg_retries > 0) && (elapsed < interval))
+      wait = interval - elapsed;
+  }
+  else
+  {
+    wait = millisUntilNextUpdate(_thing_property_container, now);
+    if (_uplink_func)
+    {
+      unsigned long const device_wait = millisUntilNextUpdate(_device_property_container, now);
+      if (device_wait < wait)
+        wait = device_wait;
+    }
+  }
+
+  /* Nothing can be sent before the duty cycle allows it again, the
+   * schedules however fire locally regardless of it.
+   */
+  unsigned long const duty_cycle_wait = _duty_cycle.waitTime(now);
+  if (duty_cycle_wait > wait)
+    wait = duty_cycle_wait;
+  unsigned long const schedule_wait = scheduleNextUpdateIn();
+  return (schedule_wait < wait) ? schedule_wait : wait;
+}
+
+void ArduinoIoTCloudLPWAN::setNetworkTime(unsigned long utc)
+{
+  _network_time = utc;
+  _network_time_tick = millis();
+  /* Discipline the internal clock right away instead of on the next sync interval */
+  if (_time_service.sync())
+    DEBUG_VERBOSE("ArduinoIoTCloudLPWAN::%s internal clock synced to network time %u", __FUNCTION__, utc);
+}
+
+bool ArduinoIoTCloudLPWAN::isNetworkTimeRequired()
+{
+  return (_network_time == 0) || ((millis() - _network_time_tick) > LORA_NETWORK_TIME_MAX_AGE_ms);
+}
+
+unsigned long ArduinoIoTCloudLPWAN::getNetworkTime()
+{
+  /* Without network time the sync fails and the RTC keeps running on the compile time */
+  if (_network_time == 0)
+    return 0;
+  return _network_time + ((millis() - _network_time_tick) / 1000);
+}
+
+void ArduinoIoTCloudLPWAN::onDownlink(uint8_t const port, uint8_t const * data, size_t const length)
+{
+  switch (static_cast<LoRaPort>(port))
+  {
+  case LoRaPort::Thing:  CBORDecoder::decode(_thing_property_container, data, length);  break;
+  case LoRaPort::Device: CBORDecoder::decode(_device_property_container, data, length); break;
+  default:
+    DEBUG_VERBOSE("ArduinoIoTCloudLPWAN::%s ignoring downlink of %d bytes on port %d", __FUNCTION__, length, port);
+    break;
+  }
 }
 
 void ArduinoIoTCloudLPWAN::printDebugInfo()
@@ -121,13 +235,24 @@ ArduinoIoTCloudLPWAN::State ArduinoIoTCloudLPWAN::handle_Connected()
 
   /* Check if a primitive property wrapper is locally changed. */
   updateTimestampOnLocallyChangedProperties(_thing_property_container);
+  if (_uplink_func)
+    updateTimestampOnLocallyChangedProperties(_device_property_container);
 
   /* Decode available data. */
   if (_connection->available())
     decodePropertiesFromCloud();
 
+  /* A message whose uplink failed takes precedence over new property
+   * updates, those stay dirty until the band is free again.
+   */
+  if (_pending_msg_length > 0)
+    sendPendingMessage();
   /* If properties need updating sent them to the cloud. */
-  sendPropertiesToCloud();
+  else if (!batchActive())
+  {
+    sendPropertiesToCloud();
+    _batch_committed = false;
+  }
 
   return State::Connected;
 }
@@ -135,38 +260,107 @@ ArduinoIoTCloudLPWAN::State ArduinoIoTCloudLPWAN::handle_Connected()
 void ArduinoIoTCloudLPWAN::decodePropertiesFromCloud()
 {
   uint8_t lora_msg_buf[CBOR_LORA_MSG_MAX_SIZE];
-  size_t bytes_received;
-  for (bytes_received = 0;
-       _connection->available() && (bytes_received < CBOR_LORA_MSG_MAX_SIZE);
-       bytes_received++)
+
+  /* Drain all the downlinks queued since the last call, but bound the work
+   * done within a single update() in case the modem keeps delivering data.
+   */
+  for (size_t msg = 0; msg < LORA_MAX_DOWNLINKS_PER_UPDATE; msg++)
   {
-    lora_msg_buf[bytes_received] = _connection->read();
+    int const available = _connection->available();
+    if (available <= 0)
+      break;
+
+    /* The number of pending bytes is queried once per downlink instead of
+     * before every single byte.
+     */
+    size_t const msg_length = (static_cast<size_t>(available) < CBOR_LORA_MSG_MAX_SIZE) ? static_cast<size_t>(available) : CBOR_LORA_MSG_MAX_SIZE;
+    size_t bytes_received = 0;
+    for (; bytes_received < msg_length; bytes_received++)
+    {
+      int const c = _connection->read();
+      if (c < 0)
+        break;
+      lora_msg_buf[bytes_received] = static_cast<uint8_t>(c);
+    }
+
+    /* The connection handler does not report the port, so it is the thing one */
+    onDownlink(static_cast<uint8_t>(LoRaPort::Thing), lora_msg_buf, bytes_received);
   }
-  CBORDecoder::decode(_thing_property_container, lora_msg_buf, bytes_received);
 }
 
 void ArduinoIoTCloudLPWAN::sendPropertiesToCloud()
 {
-  int bytes_encoded = 0;
-  uint8_t data[CBOR_LORA_MSG_MAX_SIZE];
+  /* Leave the properties dirty as long as the duty cycle does not allow an
+   * uplink, they are encoded with their latest value once it does.
+   */
+  if (!_duty_cycle.canTransmit(millis()))
+    return;
+
+  /* The rarely changing device properties only take an uplink of their own
+   * when no thing property is due, and only if the port can be chosen.
+   */
+  if (!encodePropertiesToCloud(_thing_property_container, _last_checked_property_index, true, LoRaPort::Thing) && _uplink_func)
+    encodePropertiesToCloud(_device_property_container, _last_checked_device_property_index, false, LoRaPort::Device);
+}
 
-  if (CBOREncoder::encode(_thing_property_container, data, sizeof(data), bytes_encoded, _last_checked_property_index, true) == CborNoError)
-    if (bytes_encoded > 0)
-      writeProperties(data, bytes_encoded);
+bool ArduinoIoTCloudLPWAN::encodePropertiesToCloud(PropertyContainer & property_container, unsigned int & current_property_index, bool const light_payload, LoRaPort const port)
+{
+  int bytes_encoded = 0;
+  size_t const max_payload = _duty_cycle.maxPayload();
+  size_t const buf_size = (max_payload < sizeof(_pending_msg)) ? max_payload : sizeof(_pending_msg);
+
+  /* Confirmed properties are encoded first, their presence makes the whole uplink confirmed */
+  bool const confirmed = isConfirmedUpdatePending(property_container);
+
+  /* Pack as many changed properties as fit into the payload of the current data rate */
+  if (CBOREncoder::encode(property_container, _pending_msg, buf_size, bytes_encoded, current_property_index, light_payload, 0, AIOT_CONFIG_SENML_BASE_VALUES_ENABLED, true) != CborNoError)
+    return false;
+  if (bytes_encoded <= 0)
+    return false;
+
+  _pending_msg_length = bytes_encoded;
+  _pending_msg_retries = 0;
+  _pending_msg_confirmed = confirmed;
+  _pending_msg_port = port;
+  sendPendingMessage();
+  return true;
 }
 
-int ArduinoIoTCloudLPWAN::writeProperties(const byte data[], int length)
+void ArduinoIoTCloudLPWAN::sendPendingMessage()
 {
-  int retcode = _connection->write(data, length);
-  int i = 0;
-  while (_retryEnable && retcode < 0 && i < _maxNumRetry)
+  unsigned long const now = millis();
+  if (!_duty_cycle.canTransmit(now))
+    return;
+  if ((_pending_msg_retries > 0) && ((now - _pending_msg_retry_tick) < static_cast<unsigned long>(_intervalRetry)))
+    return;
+
+  if (writeProperties(_pending_msg, _pending_msg_length, _pending_msg_port, _pending_msg_confirmed) > 0)
   {
-    delay(_intervalRetry);
-    retcode = _connection->write(data, length);
-    i++;
+    _duty_cycle.onTransmit(_pending_msg_length, now);
+    _pending_msg_length = 0;
+    return;
   }
 
-  return 1;
+  /* Instead of blocking the sketch retry the uplink on a later call of update(),
+   * confirmed ones always and all others only if retries are enabled.
+   */
+  if ((_pending_msg_confirmed || _retryEnable) && (_pending_msg_retries < _maxNumRetry))
+  {
+    _pending_msg_retries++;
+    _pending_msg_retry_tick = now;
+  }
+  else
+  {
+    DEBUG_ERROR("ArduinoIoTCloudLPWAN::%s dropping uplink of %d bytes", __FUNCTION__, _pending_msg_length);
+    _pending_msg_length = 0;
+  }
+}
+
+int ArduinoIoTCloudLPWAN::writeProperties(const byte data[], int length, LoRaPort port, bool confirmed)
+{
+  if (_uplink_func)
+    return (_uplink_func(data, static_cast<size_t>(length), static_cast<uint8_t>(port), confirmed) < 0) ? 0 : 1;
+  return (_connection->write(data, length) < 0) ? 0 : 1;
 }
 
 /******************************************************************************
@@ -23,6 +23,25 @@
  ******************************************************************************/
 
 #include <ArduinoIoTCloud.h>
+#include "utility/lora/LoRaDutyCycle.h"
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+/* LoRaWAN application ports the messages are routed by, each one carries a
+ * single kind of message so that no downlink has to be probed by every decoder.
+ */
+enum class LoRaPort : uint8_t
+{
+  Thing   = 2,
+  Device  = 3,
+  /* Reserved for control messages, downlinks on it are ignored for now */
+  Control = 4,
+};
+
+/* Sends an uplink via the modem on the given port, returns a negative value if it failed */
+typedef int(*LoRaUplinkFunc)(uint8_t const * data, size_t const length, uint8_t const port, bool const confirmed);
 
 /******************************************************************************
  * CLASS DECLARATION
@@ -38,6 +57,7 @@ class ArduinoIoTCloudLPWAN : public ArduinoIoTCloudClass
     virtual void update        () override;
     virtual int  connected     () override;
     virtual void printDebugInfo() override;
+    virtual unsigned long nextUpdateIn() override;
 
     int begin(ConnectionHandler& connection, bool retry = false);
 
@@ -49,6 +69,34 @@ class ArduinoIoTCloudLPWAN : public ArduinoIoTCloudClass
     inline void setMaxRetry     (int val)  { _maxNumRetry = val; }
     inline void setIntervalRetry(long val) { _intervalRetry = val; }
 
+    /* Regional parameters used to pace and size the uplinks, the defaults match EU868 at DR5.
+     * Call setDataRate() whenever the modem changes the data rate, e.g. due to ADR.
+     */
+    inline void setRegion       (LoRaRegion region)                           { _duty_cycle.setRegion(region); }
+    inline void setDutyCycle    (uint16_t per_mille)                          { _duty_cycle.setDutyCycle(per_mille); }
+    inline void setDataRate     (uint8_t spreading_factor, uint16_t bw_kHz)   { _duty_cycle.setDataRate(spreading_factor, bw_kHz); }
+    inline void setMaxPayload   (size_t max_payload)                          { _duty_cycle.setMaxPayload(max_payload); }
+    inline void setMaxDwellTime (unsigned long max_dwell_ms)                  { _duty_cycle.setMaxDwellTime(max_dwell_ms); }
+
+    /* Network time, e.g. from the DeviceTimeAns of the LoRaWAN network server or
+     * from a time downlink sent by the cloud. Ask for it with the next regular
+     * uplink whenever isNetworkTimeRequired() returns true and hand the answer
+     * over via setNetworkTime(), the internal clock is then synced to it.
+     */
+    void setNetworkTime(unsigned long utc);
+    bool isNetworkTimeRequired();
+    unsigned long getNetworkTime();
+
+    /* Uplinks carrying a property with Reliability::Confirmed are sent confirmed
+     * and retried up to getMaxRetry() times, all others are sent unconfirmed.
+     * The connection handler does not tell them apart, the modem does once the
+     * uplinks are sent through this function instead. The same holds for the
+     * port: device properties are only exchanged once it is set, and downlinks
+     * received by the modem are routed by their port via onDownlink().
+     */
+    inline void setUplinkFunction(LoRaUplinkFunc func) { _uplink_func = func; }
+    void onDownlink(uint8_t const port, uint8_t const * data, size_t const length);
+
 
   private:
 
@@ -63,6 +111,17 @@ class ArduinoIoTCloudLPWAN : public ArduinoIoTCloudClass
     bool _retryEnable;
     int _maxNumRetry;
     long _intervalRetry;
+    LoRaDutyCycle _duty_cycle;
+    uint8_t _pending_msg[255];
+    int _pending_msg_length;
+    int _pending_msg_retries;
+    bool _pending_msg_confirmed;
+    LoRaPort _pending_msg_port;
+    unsigned int _last_checked_device_property_index;
+    unsigned long _pending_msg_retry_tick;
+    unsigned long _network_time;
+    unsigned long _network_time_tick;
+    LoRaUplinkFunc _uplink_func;
 
     State handle_ConnectPhy();
     State handle_SyncTime();
@@ -70,7 +129,9 @@ class ArduinoIoTCloudLPWAN : public ArduinoIoTCloudClass
 
     void decodePropertiesFromCloud();
     void sendPropertiesToCloud();
-    int writeProperties(const byte data[], int length);
+    bool encodePropertiesToCloud(PropertyContainer & property_container, unsigned int & current_property_index, bool const light_payload, LoRaPort const port);
+    void sendPendingMessage();
+    int writeProperties(const byte data[], int length, LoRaPort port, bool confirmed);
 };
 
 /******************************************************************************
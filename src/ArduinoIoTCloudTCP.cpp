@@ -27,6 +27,7 @@
 #ifdef BOARD_HAS_ECCX08
   #include "tls/BearSSLTrustAnchors.h"
   #include "tls/utility/CryptoUtil.h"
+  #include "tls/utility/DRBG.h"
 #endif
 
 #ifdef BOARD_HAS_SE050
@@ -41,11 +42,41 @@
 
 #if OTA_ENABLED
   #include "utility/ota/OTA.h"
+  #include "utility/url/URLParser.h"
 #endif
 
 #include <algorithm>
 #include "cbor/CBOREncoder.h"
 #include "utility/watchdog/Watchdog.h"
+#include "utility/watchdog/StallTrace.h"
+#include "utility/trace/Trace.h"
+#include "utility/backoff/Backoff.h"
+#include "utility/mqtt/MqttPublish.h"
+#include "utility/time/ScheduleTimer.h"
+#include "utility/memory/StaticArena.h"
+
+/******************************************************************************
+   LOCAL MODULE VARIABLES
+ ******************************************************************************/
+
+#if AIOT_CONFIG_FAST_RESUME_ENABLED
+#ifdef AIOT_CONFIG_FAST_RESUME_SECTION
+  #define AIOT_FAST_RESUME_ATTRIBUTE __attribute__((section(AIOT_CONFIG_FAST_RESUME_SECTION)))
+#else
+  #define AIOT_FAST_RESUME_ATTRIBUTE
+#endif
+
+static uint32_t const FAST_RESUME_MAGIC = 0x46524553;
+
+/* Outcome of the last complete negotiation with the cloud */
+static struct
+{
+  uint32_t     magic;
+  char         thing_id[40];
+  int          tz_offset;
+  unsigned int tz_dst_until;
+} _fast_resume AIOT_FAST_RESUME_ATTRIBUTE;
+#endif
 
 /******************************************************************************
    LOCAL MODULE FUNCTIONS
@@ -56,6 +87,11 @@ unsigned long getTime()
   return ArduinoCloud.getInternalTime();
 }
 
+uint64_t getTimeMillis()
+{
+  return ArduinoCloud.getInternalTimeMillis();
+}
+
 void updateTimezoneInfo()
 {
   ArduinoCloud.updateInternalTimezoneInfo();
@@ -66,6 +102,46 @@ void setThingIdOutdated()
   ArduinoCloud.setThingIdOutdatedFlag();
 }
 
+#if OTA_ENABLED
+void setOtaUrlReceived()
+{
+  ArduinoCloud.setOtaUrlReceivedFlag();
+}
+#endif
+
+#ifdef HAS_RULES
+void setRulesReceived()
+{
+  ArduinoCloud.setRulesReceivedFlag();
+}
+#endif
+
+#ifdef HAS_TRACE_CAPTURE
+void setTraceRequested()
+{
+  ArduinoCloud.setTraceRequestedFlag();
+}
+#endif
+
+#ifdef HAS_TIMEZONE_REQUEST
+void setTimezoneReceived()
+{
+  ArduinoCloud.setTimezoneReceivedFlag();
+}
+#endif
+
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+static unsigned long keepAliveMax(NetworkAdapter const adapter)
+{
+  switch (adapter)
+  {
+    case NetworkAdapter::ETHERNET: return AIOT_CONFIG_KEEP_ALIVE_MAX_ETHERNET_ms;
+    case NetworkAdapter::WIFI:     return AIOT_CONFIG_KEEP_ALIVE_MAX_WIFI_ms;
+    default:                       return AIOT_CONFIG_KEEP_ALIVE_MAX_CELLULAR_ms;
+  }
+}
+#endif
+
 /******************************************************************************
    CTOR/DTOR
  ******************************************************************************/
@@ -78,34 +154,99 @@ ArduinoIoTCloudTCP::ArduinoIoTCloudTCP()
 , _last_device_subscribe_cnt{0}
 , _last_sync_request_tick{0}
 , _last_sync_request_cnt{0}
+#ifdef HAS_TIMEZONE_REQUEST
+, _tz_request_tick{0}
+, _tz_request_cnt{0}
+, _tz_received{false}
+#endif
 , _last_subscribe_request_tick{0}
 , _last_subscribe_request_cnt{0}
-, _mqtt_data_buf{0}
-, _mqtt_data_len{0}
-, _mqtt_data_request_retransmit{false}
+, _last_values_received{false}
+, _outbound_queue_head{0}
+, _outbound_queue_count{0}
+, _has_been_connected{false}
+, _is_mqtt_connected_valid{false}
+, _is_mqtt_connected{false}
+, _tls_handshake{TlsHandshake::None}
+, _is_data_ready{false}
+, _is_data_ready_signalled{false}
+, _last_mqtt_poll_tick{0}
+#ifdef HAS_DEFERRED_CERT
+, _is_cert_pending{false}
+#endif
 #ifdef BOARD_HAS_ECCX08
+, _tls_handshake_started{false}
+, _tls_handshake_tick{0}
 , _sslClient(nullptr, ArduinoIoTCloudTrustAnchor, ArduinoIoTCloudTrustAnchor_NUM, getTime)
 #endif
   #ifdef BOARD_ESP
 , _password("")
+, _ca_cert{nullptr}
   #endif
+#ifdef HAS_COALESCING_CLIENT
+, _coalescingClient(_coalescing_buf, sizeof(_coalescing_buf))
+#endif
 , _mqttClient{nullptr}
-, _deviceTopicOut("")
-, _deviceTopicIn("")
-, _shadowTopicOut("")
-, _shadowTopicIn("")
-, _dataTopicOut("")
-, _dataTopicIn("")
+#ifdef HAS_TRANSMIT_WINDOW
+, _is_link_suspended{false}
+, _link_suspended_tick{0}
+#endif
+#ifdef HAS_GATEWAY
+, _gateway_thing_cnt{0}
+#endif
+#ifdef HAS_LOCAL_MIRROR
+, _mirror_udp{nullptr}
+, _mirror_port{0}
+, _mirror_sink{*this}
+#endif
+#ifdef HAS_CORE_LINK
+, _core_link{nullptr}
+, _is_core_link_connected{false}
+, _is_core_link_synced{false}
+#endif
+#ifdef HAS_RULES
+, _rules_program{nullptr}
+, _rules_error{static_cast<int>(RuleEngine::Error::None)}
+, _rules_received{false}
+#endif
 , _deviceSubscribedToThing{false}
+, _light_payload_cap{true}
+, _light_payload{false}
 #if OTA_ENABLED
 , _ota_cap{false}
 , _ota_error{static_cast<int>(OTAError::None)}
+, _ota_progress{-1}
+, _ota_metrics{""}
 , _ota_img_sha256{"Inv."}
+, _is_ota_img_sha256_pending{false}
 , _ota_url{""}
+, _ota_url_sha256{}
+, _ota_url_received{true}
 , _ota_req{false}
 , _ask_user_before_executing_ota{false}
 , _get_ota_confirmation{nullptr}
+, _get_ota_url{nullptr}
+#ifdef HAS_OTA_PREFETCH
+, _ota_prefetch_url{""}
+#endif
 #endif /* OTA_ENABLED */
+#ifdef HAS_STALL_TRACE
+, _wdt_stall{""}
+#endif
+#ifdef HAS_BURST_FLUSH
+, _bytes_written{0}
+#endif
+#ifdef HAS_PERF_COUNTERS
+, _perf_report{""}
+, _perf_report_tick{0}
+#endif
+#ifdef HAS_TRACE_CAPTURE
+, _trace_req_s{0}
+, _trace_req_received{false}
+, _trace_capture(trace_buffer())
+, _trace_chunk{nullptr}
+, _trace_chunk_tick{0}
+#endif
 {
 
 }
@@ -127,6 +268,7 @@ int ArduinoIoTCloudTCP::begin(bool const enable_watchdog, String brokerAddress,
 {
   _brokerAddress = brokerAddress;
   _brokerPort = brokerPort;
+  _brokerEndpoints.begin(_brokerAddress, _brokerPort);
 
 #if defined(__AVR__)
   String const nina_fw_version = WiFi.firmwareVersion();
@@ -138,8 +280,10 @@ int ArduinoIoTCloudTCP::begin(bool const enable_watchdog, String brokerAddress,
 #endif /* AVR */
 
 #if OTA_ENABLED && !defined(__AVR__)
-  _ota_img_sha256 = OTA::getImageSHA256();
-  DEBUG_VERBOSE("SHA256: HASH(%d) = %s", strlen(_ota_img_sha256.c_str()), _ota_img_sha256.c_str());
+  /* Hashing the whole image takes long, it is done from update() instead */
+  _is_ota_img_sha256_pending = true;
+  /* Metrics of the update which brought up this firmware, if kept */
+  _ota_metrics = OTA::toString(OTA::metrics());
 #endif /* OTA_ENABLED */
 
 #if defined(BOARD_HAS_ECCX08) || defined(BOARD_HAS_OFFLOADED_ECCX08) || defined(BOARD_HAS_SE050)
@@ -155,13 +299,12 @@ int ArduinoIoTCloudTCP::begin(bool const enable_watchdog, String brokerAddress,
   }
 #endif
 
-#if defined(BOARD_HAS_ECCX08) || defined(BOARD_HAS_SE050)
-  if (!_crypto.readCert(_cert, CryptoSlot::CompressedCertificate))
-  {
-    DEBUG_ERROR("Cryptography certificate reconstruction failure.");
+#if defined(HAS_DEFERRED_CERT)
+  /* Done by handle_ConnectPhy() while the network comes up */
+  _is_cert_pending = true;
+#elif defined(BOARD_HAS_ECCX08) || defined(BOARD_HAS_SE050)
+  if (!loadCert())
     return 0;
-  }
-  _sslClient.setEccSlot(static_cast<int>(CryptoSlot::Key), _cert.bytes(), _cert.length());
 #endif
 
 #if defined(BOARD_HAS_ECCX08)
@@ -169,41 +312,155 @@ int ArduinoIoTCloudTCP::begin(bool const enable_watchdog, String brokerAddress,
 #elif defined(BOARD_HAS_SE050)
   _sslClient.appendCustomCACert(AIoTSSCert);
 #elif defined(BOARD_ESP)
-  _sslClient.setInsecure();
+  if (_ca_cert) {
+  #if defined(ARDUINO_ARCH_ESP8266)
+    _ca_list.append(_ca_cert);
+    _sslClient.setTrustAnchors(&_ca_list);
+  #else
+    _sslClient.setCACert(_ca_cert);
+  #endif
+  } else {
+    _sslClient.setInsecure();
+  }
+  #if defined(HAS_ESP32_OTA_ASYNC)
+  OTA::setCACert(_ca_cert);
+  #endif
+  #if defined(ARDUINO_ARCH_ESP8266)
+  /* The session is offered again on each reconnect to skip the full handshake */
+  _sslClient.setSession(&_tls_session);
+    #if AIOT_CONFIG_TLS_MAX_FRAGMENT_LENGTH > 0
+  _sslClient.setBufferSizes(AIOT_CONFIG_TLS_MAX_FRAGMENT_LENGTH, AIOT_CONFIG_TLS_MAX_FRAGMENT_LENGTH);
+    #endif
+  #else
+  _sslClient.setHandshakeTimeout(AIOT_CONFIG_TLS_HANDSHAKE_TIMEOUT_ms / 1000);
+  #endif
 #endif
 
+#if defined(HAS_COALESCING_CLIENT)
+  _coalescingClient.setClient(_sslClient);
+  _mqttClient.setClient(_coalescingClient);
+#elif defined(BOARD_HAS_ECCX08) || defined(BOARD_HAS_OFFLOADED_ECCX08) || defined(BOARD_HAS_SE050) || defined(BOARD_ESP)
   _mqttClient.setClient(_sslClient);
+#else
+  /* The host simulation has no TLS client, the connection stands in for it */
+  _mqttClient.setClient(_connection->getClient());
+#endif
 #ifdef BOARD_ESP
   _mqttClient.setUsernamePassword(getDeviceId(), _password);
 #endif
   _mqttClient.onMessage(ArduinoIoTCloudTCP::onMessage);
-  _mqttClient.setKeepAliveInterval(30 * 1000);
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+  /* The broker is told the longest interval, the pings follow the probed one */
+  _keep_alive.begin(KeepAliveLimits{AIOT_CONFIG_KEEP_ALIVE_MIN_ms, keepAliveMax(_connection->getInterface())});
+  _mqttClient.setKeepAliveInterval(_keep_alive.maxInterval());
+#else
+  _mqttClient.setKeepAliveInterval(AIOT_CONFIG_KEEP_ALIVE_MIN_ms);
+#endif
+#ifdef HAS_RATE_CONTROL
+  _rate_control.begin(RateControlLimits{AIOT_CONFIG_RATE_CONTROL_SLOW_WRITE_ms,
+                                        AIOT_CONFIG_RATE_CONTROL_MIN_HOLD_ms,
+                                        AIOT_CONFIG_RATE_CONTROL_MAX_HOLD_ms,
+                                        AIOT_CONFIG_RATE_CONTROL_WEAK_SIGNAL_dBm,
+                                        AIOT_CONFIG_RATE_CONTROL_WEAK_SIGNAL_HOLD_ms});
+#endif
   _mqttClient.setConnectionTimeout(1500);
   _mqttClient.setId(getDeviceId().c_str());
 
-  _deviceTopicOut = getTopic_deviceout();
-  _deviceTopicIn  = getTopic_devicein();
+  /* Seed the reconnection jitter so that a fleet of devices does not retry in lockstep */
+  uint32_t backoff_seed_val = 2166136261UL;
+  for (char const * c = getDeviceId().c_str(); *c != '\0'; c++)
+    backoff_seed_val = (backoff_seed_val ^ static_cast<uint8_t>(*c)) * 16777619UL;
+#ifdef BOARD_HAS_ECCX08
+  uint32_t drbg_random = 0;
+  if (drbg_generate(&drbg_random, sizeof(drbg_random)))
+    backoff_seed_val ^= drbg_random;
+#endif
+  backoff_seed(backoff_seed_val ^ micros());
+
+  if (!_topics.setDeviceId(getDeviceId()))
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s device id too long for the topics", __FUNCTION__);
+  _topicRouter.add(static_cast<uint8_t>(InboundTopic::Device), _topics.deviceIn());
 
   Property* p;
-  p = new CloudWrapperString(_lib_version);
-  addPropertyToContainer(_device_property_container, *p, "LIB_VERSION", Permission::Read, -1);
+  p = arenaNew<CloudWrapperString>(_lib_version);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("LIB_VERSION"), Permission::Read, -1);
+  p = arenaNew<CloudWrapperBool>(_light_payload_cap);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("LIGHT_PAYLOAD_CAP"), Permission::Read, -1);
+  p = arenaNew<CloudWrapperBool>(_light_payload);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("LIGHT_PAYLOAD"), Permission::ReadWrite, -1);
 #if OTA_ENABLED
-  p = new CloudWrapperBool(_ota_cap);
-  addPropertyToContainer(_device_property_container, *p, "OTA_CAP", Permission::Read, -1);
-  p = new CloudWrapperInt(_ota_error);
-  addPropertyToContainer(_device_property_container, *p, "OTA_ERROR", Permission::Read, -1);
-  p = new CloudWrapperString(_ota_img_sha256);
-  addPropertyToContainer(_device_property_container, *p, "OTA_SHA256", Permission::Read, -1);
-  p = new CloudWrapperString(_ota_url);
-  addPropertyToContainer(_device_property_container, *p, "OTA_URL", Permission::ReadWrite, -1);
-  p = new CloudWrapperBool(_ota_req);
-  addPropertyToContainer(_device_property_container, *p, "OTA_REQ", Permission::ReadWrite, -1);
+  p = arenaNew<CloudWrapperBool>(_ota_cap);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("OTA_CAP"), Permission::Read, -1);
+  p = arenaNew<CloudWrapperInt>(_ota_error);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("OTA_ERROR"), Permission::Read, -1);
+  p = arenaNew<CloudWrapperInt>(_ota_progress);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("OTA_PROGRESS"), Permission::Read, -1);
+  p = arenaNew<CloudWrapperString>(_ota_metrics);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("OTA_METRICS"), Permission::Read, -1);
+  p = arenaNew<CloudWrapperString>(_ota_img_sha256);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("OTA_SHA256"), Permission::Read, -1);
+  p = arenaNew<CloudWrapperString>(_ota_url);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("OTA_URL"), Permission::ReadWrite, -1).onUpdate(setOtaUrlReceived);
+  p = arenaNew<CloudWrapperString>(_ota_url_sha256.value());
+  addPropertyToContainer(_device_property_container, *p, LiteralName("OTA_URL_SHA256"), Permission::Write, -1);
+  p = arenaNew<CloudWrapperBool>(_ota_req);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("OTA_REQ"), Permission::ReadWrite, -1);
 #endif /* OTA_ENABLED */
-  p = new CloudWrapperString(_thing_id);
-  addPropertyToContainer(_device_property_container, *p, "thing_id", Permission::ReadWrite, -1).onUpdate(setThingIdOutdated);
+  p = arenaNew<CloudWrapperString>(_thing_id);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("thing_id"), Permission::ReadWrite, -1).onUpdate(setThingIdOutdated);
+#ifdef HAS_STALL_TRACE
+  /* Where the previous boot stalled, only reported after a watchdog reset */
+  if (stall_trace().begin(watchdog_caused_reset()))
+  {
+    _wdt_stall = stall_trace().report();
+    DEBUG_WARNING("ArduinoIoTCloudTCP::%s watchdog reset, %s", __FUNCTION__, _wdt_stall.c_str());
+    p = arenaNew<CloudWrapperString>(_wdt_stall);
+    addPropertyToContainer(_device_property_container, *p, LiteralName("WDT_STALL"), Permission::Read, -1);
+  }
+#endif
+#ifdef HAS_PERF_COUNTERS
+  p = arenaNew<CloudWrapperString>(_perf_report);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("PERF"), Permission::Read, -1);
+#endif
+#ifdef HAS_RULES
+  _rules_program = arenaNew<CloudBinary>(_rules_buf, sizeof(_rules_buf));
+  addPropertyToContainer(_device_property_container, *_rules_program, LiteralName("RULES"), Permission::ReadWrite, -1).onUpdate(setRulesReceived);
+  p = arenaNew<CloudWrapperInt>(_rules_error);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("RULES_ERROR"), Permission::Read, -1);
+#endif
+#ifdef HAS_TRACE_CAPTURE
+  /* Nothing is traced until the cloud asks for a capture */
+  trace_buffer().setEnabled(false);
+  p = arenaNew<CloudWrapperInt>(_trace_req_s);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("TRACE_REQ"), Permission::Write, -1).onUpdate(setTraceRequested);
+  _trace_chunk = arenaNew<CloudBinary>(_trace_chunk_buf, sizeof(_trace_chunk_buf));
+  addPropertyToContainer(_device_property_container, *_trace_chunk, LiteralName("TRACE"), Permission::Read, -1);
+#endif
 
   addPropertyReal(_tz_offset, "tz_offset", Permission::ReadWrite).onSync(CLOUD_WINS).onUpdate(updateTimezoneInfo);
   addPropertyReal(_tz_dst_until, "tz_dst_until", Permission::ReadWrite).onSync(CLOUD_WINS).onUpdate(updateTimezoneInfo);
+#ifdef HAS_TIMEZONE_REQUEST
+  /* The reply to a time zone request on the device topic, never sent back */
+  p = arenaNew<CloudWrapperInt>(_tz_offset);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("tz_offset"), Permission::Write, -1).onUpdate(setTimezoneReceived);
+  p = arenaNew<CloudWrapperUnsignedInt>(_tz_dst_until);
+  addPropertyToContainer(_device_property_container, *p, LiteralName("tz_dst_until"), Permission::Write, -1).onUpdate(setTimezoneReceived);
+#endif
+
+  Property::setTimeMillisFunc(getTimeMillis);
+#ifdef HAS_PERF_COUNTERS
+  Property::setCommandLatencyFunc(ArduinoIoTCloudTCP::onCommandLatency);
+#endif
+
+#ifdef HAS_DEFERRED_CALLBACKS
+  Property::setDeferCallbackFunc(ArduinoIoTCloudTCP::queuePropertyCallback);
+#endif
+
+#ifdef HAS_PROPERTY_CACHE
+  /* The actuators resume their state before the last values are received */
+  if (_property_cache.restore(_thing_property_container))
+    DEBUG_INFO("ArduinoIoTCloudTCP::%s property values restored", __FUNCTION__);
+#endif
 
 #if OTA_ENABLED
   _ota_cap = OTA::isCapable();
@@ -234,6 +491,24 @@ int ArduinoIoTCloudTCP::begin(bool const enable_watchdog, String brokerAddress,
 
 void ArduinoIoTCloudTCP::update()
 {
+#ifdef HAS_CLOUD_THREAD
+  /* The state machine is owned by the cloud thread once it is running */
+  if (_thread.isRunning() && !_thread.isCurrent())
+  {
+    dispatch();
+    return;
+  }
+#endif
+
+#ifdef HAS_CORE_LINK
+  /* The connection is run by the other core */
+  if (isCoreLinkApplication())
+  {
+    updateCoreLink();
+    return;
+  }
+#endif
+
   /* Feed the watchdog. If any of the functions called below
    * get stuck than we can at least reset and recover.
    */
@@ -242,6 +517,30 @@ void ArduinoIoTCloudTCP::update()
 #endif
 
 
+#ifdef HAS_STALL_TRACE
+  stall_trace().enter(static_cast<uint8_t>(_state));
+#endif
+
+#ifdef HAS_PROFILING
+  ProfileScope const profile(_profile.state(static_cast<uint8_t>(_state)));
+#endif
+
+#ifdef HAS_PERF_COUNTERS
+  _perf.onUpdate(static_cast<uint8_t>(_state), millis());
+  unsigned long const perf_update_start_us = micros();
+#endif
+
+  /* Take the reply to a pending NTP request as soon as it arrives */
+  _time_service.poll();
+
+#ifdef HAS_LOCAL_MIRROR
+  /* Updates of the peers do not depend on the cloud connection */
+  receiveFromPeers();
+#endif
+
+  /* The link is evaluated once per call, see isMqttConnected() */
+  invalidateMqttConnected();
+
   /* Run through the state machine. */
   State next_state = _state;
   switch (_state)
@@ -258,8 +557,56 @@ void ArduinoIoTCloudTCP::update()
   case State::Connected:            next_state = handle_Connected();            break;
   case State::Disconnect:           next_state = handle_Disconnect();           break;
   }
+  if (next_state != _state)
+    AIOTC_TRACE(State, next_state);
   _state = next_state;
 
+#ifdef HAS_CORE_LINK
+  if (isCoreLinkNetwork())
+    relayCoreLink();
+#endif
+
+#ifdef HAS_DEFERRED_CALLBACKS
+  /* Run the callbacks of the properties received so far within the budget */
+  if (!_callback_queue.empty())
+    _callback_queue.drain(AIOT_CONFIG_CALLBACK_BUDGET_us);
+#endif
+
+  /* Fire the callbacks of the schedules whose next transition is due, the
+   * time is known once the device has been connected.
+   */
+#if AIOT_CONFIG_SCHEDULE_ENABLED
+  if (_has_been_connected && ScheduleTimer.isPending())
+  {
+#ifdef HAS_STALL_TRACE
+    stall_trace().phase(StallPhase::ScheduleTimer);
+#endif
+    ScheduleTimer.poll(getLocalTime());
+  }
+#endif
+
+#ifdef HAS_RULES
+  /* The rules act on the changes made by the cloud and the sketch so far */
+  evaluateRules();
+#endif
+
+#ifdef HAS_PROPERTY_CACHE
+  _property_cache.poll(_thing_property_container, millis(), AIOT_CONFIG_PROPERTY_CACHE_INTERVAL_ms);
+#endif
+
+#if OTA_ENABLED && !defined(__AVR__)
+  if (_is_ota_img_sha256_pending)
+    pollImageSHA256();
+#endif
+
+#if AIOT_CONFIG_OFFLINE_SAMPLES_ENABLED
+  /* Keep track of the property values while the connection is down */
+#ifdef HAS_STALL_TRACE
+  stall_trace().phase(StallPhase::OfflineSamples);
+#endif
+  recordOfflineSamples();
+#endif
+
   /* This watchdog feed is actually needed only by the RP2040 Connect because its
    * maximum watchdog window is 8389 ms; despite this we feed it for all 
    * supported ARCH to keep code aligned.
@@ -269,156 +616,691 @@ void ArduinoIoTCloudTCP::update()
 #endif
 
   /* Check for new data from the MQTT client. */
-  if (_mqttClient.connected())
+#ifdef HAS_STALL_TRACE
+  stall_trace().phase(StallPhase::MqttPoll);
+#endif
+  if (isMqttConnected() && isMqttPollDue())
+  {
+    AIOTC_TRACE(MqttPoll, 1);
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+    /* The client pings on its own once the announced interval has elapsed
+     * since its last ping. Shortened for this poll it pings right away.
+     */
+    bool const ping = isPingDue(millis());
+    if (ping)
+      _mqttClient.setKeepAliveInterval(1);
+#endif
     _mqttClient.poll();
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+    if (ping)
+    {
+      _mqttClient.setKeepAliveInterval(_keep_alive.maxInterval());
+      _keep_alive.onPing(millis());
+    }
+#endif
+    AIOTC_TRACE(MqttPoll, 0);
+  }
+
+#ifdef HAS_PERF_COUNTERS
+  _perf.onUpdateDone(micros() - perf_update_start_us);
+#endif
+
+#ifdef HAS_STALL_TRACE
+  stall_trace().leave();
+#endif
 }
 
 int ArduinoIoTCloudTCP::connected()
 {
-  return _mqttClient.connected();
+#ifdef HAS_CORE_LINK
+  if (isCoreLinkApplication())
+    return _is_core_link_connected;
+#endif
+  return isMqttConnected();
 }
 
-void ArduinoIoTCloudTCP::printDebugInfo()
+bool ArduinoIoTCloudTCP::isMqttConnected()
 {
-  DEBUG_INFO("***** Arduino IoT Cloud - configuration info *****");
-  DEBUG_INFO("Device ID: %s", getDeviceId().c_str());
-  DEBUG_INFO("MQTT Broker: %s:%d", _brokerAddress.c_str(), _brokerPort);
+  /* MqttClient::connected() asks the network client, which is e.g. an SPI
+   * round trip to the NINA module. The answer is kept until the next call of
+   * update() or until the client is connected or stopped meanwhile. A network
+   * connection reported down by the connection handler needs no asking.
+   */
+  if (!_is_mqtt_connected_valid)
+  {
+    _is_mqtt_connected = isLinkUp() && _mqttClient.connected();
+    _is_mqtt_connected_valid = true;
+  }
+  return _is_mqtt_connected;
 }
 
-/******************************************************************************
- * PRIVATE MEMBER FUNCTIONS
- ******************************************************************************/
-
-ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_ConnectPhy()
+bool ArduinoIoTCloudTCP::isLinkUp()
 {
-  if (_connection->check() == NetworkConnectionState::CONNECTED)
+  bool const is_up = (_connection != nullptr) && (_connection->getStatus() == NetworkConnectionState::CONNECTED);
+#ifdef HAS_TRANSMIT_WINDOW
+  if (is_up || (_connection == nullptr) || !_transmit_window.isEnabled())
   {
-    bool const is_retry_attempt = (_last_connection_attempt_cnt > 0);
-    if (!is_retry_attempt || (is_retry_attempt && (millis() > _next_connection_attempt_tick)))
-      return State::SyncTime;
+    _is_link_suspended = false;
+    return is_up;
   }
 
-  return State::ConnectPhy;
+  /* Only a network going down between the windows is taken for a modem
+   * suspended until the next one, the socket tells whether it survived.
+   */
+  unsigned long const now = millis();
+  if (!_is_link_suspended)
+  {
+    if (_transmit_window.isOpen(now))
+      return false;
+    _is_link_suspended = true;
+    _link_suspended_tick = now;
+  }
+  return (now - _link_suspended_tick) < AIOT_CONFIG_TRANSMIT_WINDOW_SUSPEND_GRACE_ms;
+#else
+  return is_up;
+#endif
 }
 
-ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SyncTime()
+bool ArduinoIoTCloudTCP::isTransmitWindowOpen()
 {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-variable"
-  unsigned long const internal_posix_time = _time_service.getTime();
-#pragma GCC diagnostic pop
-  DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s internal clock configured to posix timestamp %d", __FUNCTION__, internal_posix_time);
-  return State::ConnectMqttBroker;
+#ifdef HAS_TRANSMIT_WINDOW
+  return _transmit_window.isOpen(millis());
+#else
+  return true;
+#endif
 }
 
-ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_ConnectMqttBroker()
+bool ArduinoIoTCloudTCP::isPublishDue()
 {
-  if (_mqttClient.connect(_brokerAddress.c_str(), _brokerPort))
+  bool is_due = true;
+#ifdef HAS_RATE_CONTROL
+  is_due = is_due && _rate_control.isDue(millis());
+#endif
+#ifdef HAS_DATA_BUDGET
+  is_due = is_due && (_data_budget.nextAvailableIn(strlen(_topics.dataOut()) + AIOT_CONFIG_DATA_BUDGET_MIN_BYTES, millis()) == 0);
+#endif
+  return is_due;
+}
+
+#ifdef HAS_DATA_BUDGET
+size_t ArduinoIoTCloudTCP::dataBudgetLeft(unsigned long const now)
+{
+  size_t pending = 0;
+  for (size_t i = 0; i < _outbound_queue_count; i++)
   {
-    _last_connection_attempt_cnt = 0;
-    return State::SendDeviceProperties;
+    OutboundMessage const & msg = _outbound_queue[(_outbound_queue_head + i) % MQTT_OUTBOUND_QUEUE_SIZE];
+    if (msg.state == OutboundMessageState::Pending)
+      pending += strlen(msg.topic) + msg.length;
   }
+  size_t const available = _data_budget.available(now);
+  return (available > pending) ? (available - pending) : 0;
+}
 
-  _last_connection_attempt_cnt++;
-  unsigned long reconnection_retry_delay = (1 << _last_connection_attempt_cnt) * AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms;
-  reconnection_retry_delay = min(reconnection_retry_delay, static_cast<unsigned long>(AIOT_CONFIG_MAX_RECONNECTION_RETRY_DELAY_ms));
-  _next_connection_attempt_tick = millis() + reconnection_retry_delay;
+void ArduinoIoTCloudTCP::onDataSent(char const * topic, size_t const length)
+{
+  _data_budget.onSend(strlen(topic) + length, millis());
+}
+#endif
 
-  DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not connect to %s:%d", __FUNCTION__, _brokerAddress.c_str(), _brokerPort);
-  DEBUG_ERROR("ArduinoIoTCloudTCP::%s %d connection attempt at tick time %d", __FUNCTION__, _last_connection_attempt_cnt, _next_connection_attempt_tick);
-  return State::ConnectPhy;
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+bool ArduinoIoTCloudTCP::isPingDue(unsigned long const now)
+{
+  bool is_due = _keep_alive.isPingDue(now);
+#ifdef HAS_TRANSMIT_WINDOW
+  /* A ping falling due before the next window is sent in this one, unless
+   * the keep alive interval is too short to skip a window anyway.
+   */
+  bool const is_aligned = _transmit_window.isEnabled() && (_keep_alive.interval() >= _transmit_window.cycle());
+  if (is_aligned && _transmit_window.isOpen(now))
+    is_due = is_due || (_keep_alive.nextPingIn(now) < _transmit_window.nextCycleIn(now));
+#endif
+  return is_due;
 }
+#endif
 
-ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SendDeviceProperties()
+#ifdef HAS_TRANSMIT_WINDOW
+void ArduinoIoTCloudTCP::setTransmitWindow(unsigned long const cycle_ms, unsigned long const window_ms)
 {
-  if (!_mqttClient.connected())
-  {
-    return State::Disconnect;
-  }
+  _transmit_window.begin(cycle_ms, window_ms, millis());
+}
+#endif
 
-  sendDevicePropertiesToCloud();
-  return State::SubscribeDeviceTopic;
+void ArduinoIoTCloudTCP::notifyDataReady()
+{
+  _is_data_ready = true;
+  _is_data_ready_signalled = true;
+#ifdef HAS_CLOUD_THREAD
+  _thread.wake();
+#endif
 }
 
-ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SubscribeDeviceTopic()
+bool ArduinoIoTCloudTCP::isMqttPollDue()
 {
-  if (!_mqttClient.connected())
+  /* Without data ready signals each poll() asks the network client for data */
+  unsigned long const now = millis();
+  bool is_due = !_is_data_ready_signalled || _is_data_ready || (_state != State::Connected) ||
+                ((now - _last_mqtt_poll_tick) >= AIOT_CONFIG_MQTT_IDLE_POLL_INTERVAL_ms);
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+  is_due = is_due || isPingDue(now);
+#endif
+  if (is_due)
   {
-    return State::Disconnect;
+    /* Cleared before the poll, a signal raised meanwhile finds its data read */
+    _is_data_ready = false;
+    _last_mqtt_poll_tick = now;
   }
+  return is_due;
+}
 
-  if (!_mqttClient.subscribe(_deviceTopicIn))
-  {
-    DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not subscribe to %s", __FUNCTION__, _deviceTopicIn.c_str());
-    return State::SubscribeDeviceTopic;
-  }
+unsigned long ArduinoIoTCloudTCP::nextUpdateIn()
+{
+#ifdef HAS_CORE_LINK
+  /* Changed properties are only sent once synchronised */
+  if (isCoreLinkApplication())
+    return _is_core_link_synced ? thingNextUpdateIn() : ULONG_MAX;
+#endif
 
-  if (_last_device_subscribe_cnt > AIOT_CONFIG_LASTVALUES_SYNC_MAX_RETRY_CNT)
+  unsigned long const now = millis();
+
+  /* Nothing but the next connection attempt is due while backing off */
+  if ((_state == State::ConnectPhy) && (_last_connection_attempt_cnt > 0) && (_connection->getStatus() == NetworkConnectionState::CONNECTED))
   {
-    _last_device_subscribe_cnt = 0;
-    _next_device_subscribe_attempt_tick = 0;
-    _mqttClient.stop();
-    execCloudEventCallback(ArduinoIoTCloudEvent::DISCONNECT);
-    return State::ConnectPhy;
+    long const remaining = static_cast<long>(_next_connection_attempt_tick - now);
+    return (remaining > 0) ? static_cast<unsigned long>(remaining) : 0;
   }
 
-  /* No device configuration reply. Wait: 5s -> 10s -> 20s -> 30s */
-  unsigned long subscribe_retry_delay = (1 << _last_device_subscribe_cnt) * AIOT_CONFIG_DEVICE_TOPIC_SUBSCRIBE_RETRY_DELAY_ms;
-  subscribe_retry_delay = min(subscribe_retry_delay, static_cast<unsigned long>(AIOT_CONFIG_MAX_DEVICE_TOPIC_SUBSCRIBE_RETRY_DELAY_ms));
-  _next_device_subscribe_attempt_tick = millis() + subscribe_retry_delay;
-  _last_device_subscribe_cnt++;
+  /* All the other states advance on every call */
+  if ((_state != State::Connected) || !isMqttConnected() || getThingIdOutdatedFlag() || (_batch_committed && isTransmitWindowOpen()) || _is_data_ready || callbacksPending())
+    return 0;
 
-  return State::WaitDeviceConfig;
-}
+  if (hasPendingMessages())
+    return 0;
 
-ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_WaitDeviceConfig()
-{
-  if (!_mqttClient.connected())
+#if OTA_ENABLED
+  if (_ota_req || OTA::isInProgress() || _is_ota_img_sha256_pending)
+    return 0;
+#endif
+
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+  /* Nothing has to be sent before the next ping is due */
+  unsigned long wait = _keep_alive.nextPingIn(now);
+#else
+  /* The broker drops the connection without a ping within the keep alive interval.
+   * The time of the last transmission is unknown, so it is polled well before.
+   */
+  unsigned long wait = AIOT_CONFIG_KEEP_ALIVE_MIN_ms / 3;
+#endif
+
+#if defined (ARDUINO_ARCH_SAMD) || defined (ARDUINO_ARCH_MBED)
+  unsigned long const watchdog_window = watchdog_timeout() / 2;
+  if ((watchdog_window > 0) && (watchdog_window < wait))
+    wait = watchdog_window;
+#endif
+
+  /* The time zone information expires and has to be requested again */
+  unsigned long const internal_posix_time = _time_service.getTime();
+  if (internal_posix_time >= _tz_dst_until)
   {
-    return State::Disconnect;
+#ifdef HAS_TIMEZONE_REQUEST
+    /* Until the reply is received only the retry is due */
+    unsigned long const tz_request_elapsed = now - _tz_request_tick;
+    if ((_tz_request_cnt == 0) || (tz_request_elapsed > AIOT_CONFIG_TIMEOUT_FOR_TIMEZONE_REQUEST_ms))
+      return 0;
+    unsigned long const tz_retry_in = AIOT_CONFIG_TIMEOUT_FOR_TIMEZONE_REQUEST_ms - tz_request_elapsed + 1;
+    if (tz_retry_in < wait)
+      wait = tz_retry_in;
+#else
+    return 0;
+#endif
   }
-
-  if (getThingIdOutdatedFlag())
+  else
   {
-    return State::CheckDeviceConfig;
+    unsigned long const tz_valid_for = _tz_dst_until - internal_posix_time;
+    if (tz_valid_for < (wait / 1000UL))
+      wait = tz_valid_for * 1000UL;
   }
 
-  if (millis() > _next_device_subscribe_attempt_tick)
+  unsigned long thing_wait = thingNextUpdateIn();
+#ifdef HAS_TRANSMIT_WINDOW
+  /* The changes of the thing wait for the next window, which is woken up
+   * for in any case to align the pings.
+   */
+  if (_transmit_window.isEnabled())
   {
-    /* Configuration not received or device not attached to a valid thing. Try to resubscribe */
-    if (_mqttClient.unsubscribe(_deviceTopicIn))
-    {
-      DEBUG_ERROR("ArduinoIoTCloudTCP::%s device waiting for valid thing_id", __FUNCTION__);
-      return State::SubscribeDeviceTopic;
-    }
+    unsigned long const schedule_wait = scheduleNextUpdateIn();
+    if (!_transmit_window.isOpen(now))
+      thing_wait = schedule_wait;
+    unsigned long const window_wait = _transmit_window.nextCycleIn(now);
+    if (window_wait < thing_wait)
+      thing_wait = window_wait;
   }
-  return State::WaitDeviceConfig;
+#endif
+#ifdef HAS_RATE_CONTROL
+  /* The changes made meanwhile are held on a bad link */
+  unsigned long const hold_wait = _rate_control.nextDueIn(now);
+  if (hold_wait > thing_wait)
+    thing_wait = hold_wait;
+#endif
+#ifdef HAS_DATA_BUDGET
+  /* As well as until the budget has refilled */
+  unsigned long const budget_wait = _data_budget.nextAvailableIn(strlen(_topics.dataOut()) + AIOT_CONFIG_DATA_BUDGET_MIN_BYTES, now);
+  if (budget_wait > thing_wait)
+    thing_wait = budget_wait;
+#endif
+  if (thing_wait < wait)
+    wait = thing_wait;
+
+#ifdef HAS_GATEWAY
+  unsigned long const gateway_wait = gatewayNextUpdateIn(now);
+  if (gateway_wait < wait)
+    wait = gateway_wait;
+#endif
+#ifdef HAS_TRACE_CAPTURE
+  /* The end of a capture and the next chunk of its upload */
+  unsigned long trace_wait = ULONG_MAX;
+  if (_trace_capture.state() == TraceCapture::State::Recording)
+    trace_wait = _trace_capture.endsIn(now);
+  else if (_trace_capture.state() == TraceCapture::State::Uploading)
+    trace_wait = AIOT_CONFIG_TRACE_CAPTURE_CHUNK_INTERVAL_ms - std::min(now - _trace_chunk_tick, AIOT_CONFIG_TRACE_CAPTURE_CHUNK_INTERVAL_ms);
+  if (trace_wait < wait)
+    wait = trace_wait;
+#endif
+  return wait;
 }
 
-ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_CheckDeviceConfig()
+bool ArduinoIoTCloudTCP::hasPendingMessages() const
 {
-  if (!_mqttClient.connected())
+  for (size_t i = 0; i < _outbound_queue_count; i++)
   {
-    return State::Disconnect;
+    if (_outbound_queue[(_outbound_queue_head + i) % MQTT_OUTBOUND_QUEUE_SIZE].state == OutboundMessageState::Pending)
+      return true;
   }
+  return false;
+}
 
-  if(_deviceSubscribedToThing == true)
+#ifdef HAS_CLOUD_THREAD
+bool ArduinoIoTCloudTCP::startThread()
+{
+  Property::setDeferCallbackFunc(ArduinoIoTCloudTCP::deferPropertyCallback);
+  if (_thread.start(ArduinoIoTCloudTCP::threadEntry, this))
+    return true;
+
+#ifdef HAS_DEFERRED_CALLBACKS
+  Property::setDeferCallbackFunc(ArduinoIoTCloudTCP::queuePropertyCallback);
+#else
+  Property::setDeferCallbackFunc(nullptr);
+#endif
+  DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not start the cloud thread", __FUNCTION__);
+  return false;
+}
+
+void ArduinoIoTCloudTCP::dispatch()
+{
+  DeferredCallback callback;
+  while (_deferred_callbacks.pop(callback))
   {
-    /* Unsubscribe from old things topics and go on with a new subscription */
-    _mqttClient.unsubscribe(_shadowTopicIn);
-    _mqttClient.unsubscribe(_dataTopicIn);
-    _deviceSubscribedToThing = false;
-    DEBUG_INFO("Disconnected from Arduino IoT Cloud");
-    execCloudEventCallback(ArduinoIoTCloudEvent::DISCONNECT);
+    lock();
+    if (callback.type == DeferredCallbackType::CloudEvent)
+      ArduinoIoTCloudClass::execCloudEventCallback(callback.event);
+    else
+      callback.property->execDeferredCallback(callback.type == DeferredCallbackType::OnSync);
+    unlock();
   }
+  /* A property changed within a callback is sent without waiting for the timeout */
+  wake();
+}
+#endif
 
-  updateThingTopics();
+#ifdef HAS_CORE_LINK
+int ArduinoIoTCloudTCP::begin(CoreLink & link)
+{
+  if (link.side() != CoreLink::Side::Application)
+    return 0;
+  _core_link = &link;
+
+  /* The time zone is kept by the network side along with the time */
+  Property::setTimeMillisFunc(getTimeMillis);
+
+#ifdef HAS_DEFERRED_CALLBACKS
+  Property::setDeferCallbackFunc(ArduinoIoTCloudTCP::queuePropertyCallback);
+#endif
+  return 1;
+}
+#endif
+
+#ifdef HAS_LOCAL_MIRROR
+bool ArduinoIoTCloudTCP::beginLocalMirror(UDP & udp, uint8_t const * key, size_t const key_len, IPAddress const group, uint16_t const port)
+{
+  if (!_mirror.begin(getDeviceId().c_str(), key, key_len))
+  {
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s the key has to be %d to %d bytes long", __FUNCTION__, static_cast<int>(LocalMirror::MIN_KEY_SIZE), static_cast<int>(LocalMirror::MAX_KEY_SIZE));
+    return false;
+  }
+
+  /* The mirror is one of the sinks of the updates sent to the cloud */
+  if ((_mirror_udp == nullptr) && !_fanout.add(_mirror_sink))
+  {
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s no message sink left for the mirror", __FUNCTION__);
+    return false;
+  }
+
+  if (!udp.beginMulticast(group, port))
+  {
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not join the multicast group", __FUNCTION__);
+    return false;
+  }
+
+  _mirror.setThing(getThingId().c_str(), mirrorEpoch());
+  _mirror_udp = &udp;
+  _mirror_group = group;
+  _mirror_port = port;
+  return true;
+}
+#endif
+
+#ifdef HAS_GATEWAY
+bool ArduinoIoTCloudTCP::addThing(CloudThing & thing)
+{
+  if (_gateway_thing_cnt >= AIOT_CONFIG_GATEWAY_THING_CNT)
+    return false;
+
+  thing._state = CloudThing::State::Subscribe;
+  _gateway_things[_gateway_thing_cnt++] = &thing;
+  return true;
+}
+#endif
+
+void ArduinoIoTCloudTCP::printDebugInfo()
+{
+  DEBUG_INFO("***** Arduino IoT Cloud - configuration info *****");
+  DEBUG_INFO("Device ID: %s", getDeviceId().c_str());
+  DEBUG_INFO("MQTT Broker: %s:%d", _brokerAddress.c_str(), _brokerPort);
+}
+
+#ifdef HAS_PROFILING
+char const * ArduinoIoTCloudTCP::getStateName(uint8_t const state)
+{
+  switch (static_cast<State>(state))
+  {
+    case State::ConnectPhy:           return "ConnectPhy";
+    case State::SyncTime:             return "SyncTime";
+    case State::ConnectMqttBroker:    return "ConnectMqttBroker";
+    case State::SendDeviceProperties: return "SendDeviceProperties";
+    case State::SubscribeDeviceTopic: return "SubscribeDeviceTopic";
+    case State::WaitDeviceConfig:     return "WaitDeviceConfig";
+    case State::CheckDeviceConfig:    return "CheckDeviceConfig";
+    case State::SubscribeThingTopics: return "SubscribeThingTopics";
+    case State::RequestLastValues:    return "RequestLastValues";
+    case State::Connected:            return "Connected";
+    case State::Disconnect:           return "Disconnect";
+  }
+  return "";
+}
+#endif
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_ConnectPhy()
+{
+  bool const is_connected = (_connection->check() == NetworkConnectionState::CONNECTED);
+  bool const is_retry_attempt = (_last_connection_attempt_cnt > 0);
+  bool const is_attempt_due = !is_retry_attempt || (is_retry_attempt && (millis() > _next_connection_attempt_tick));
+
+#ifdef HAS_DEFERRED_CERT
+  /* The connection handler has been kicked off, the secure element is read
+   * meanwhile. The broker can't be connected without the certificate.
+   */
+  if (_is_cert_pending)
+  {
+    if (!is_attempt_due)
+      return State::ConnectPhy;
+    if (!loadCert())
+    {
+      _last_connection_attempt_cnt++;
+      _next_connection_attempt_tick = millis() + backoff_delay(_last_connection_attempt_cnt, AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms, AIOT_CONFIG_MAX_RECONNECTION_RETRY_DELAY_ms);
+      return State::ConnectPhy;
+    }
+    _is_cert_pending = false;
+  }
+#endif
+
+  if (is_connected && is_attempt_due)
+    return State::SyncTime;
+
+  return State::ConnectPhy;
+}
+
+#if defined(BOARD_HAS_ECCX08) || defined(BOARD_HAS_SE050)
+bool ArduinoIoTCloudTCP::loadCert()
+{
+  if (!_crypto.readCert(_cert, CryptoSlot::CompressedCertificate))
+  {
+    DEBUG_ERROR("Cryptography certificate reconstruction failure.");
+    return false;
+  }
+  _sslClient.setEccSlot(static_cast<int>(CryptoSlot::Key), _cert.bytes(), _cert.length());
+  return true;
+}
+#endif
+
+ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SyncTime()
+{
+#ifdef HAS_PROFILING
+  ProfileScope const profile(_profile.section(ProfileSection::NtpSync));
+#endif
+  /* The NTP reply is received while connecting to the broker. The TLS
+   * certificate validation is the first to need the time and only waits
+   * for the reply if it has not arrived by then.
+   */
+  _time_service.beginSync();
+  return State::ConnectMqttBroker;
+}
+
+ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_ConnectMqttBroker()
+{
+#ifdef HAS_PROFILING
+  ProfileScope const profile(_profile.section(ProfileSection::TlsConnect));
+#endif
+#if defined(HAS_PERF_COUNTERS) && !defined(BOARD_HAS_ECCX08)
+  unsigned long const connect_tick = millis();
+#endif
+  bool tls_connected = true;
+
+#ifdef BOARD_HAS_ECCX08
+  /* The TLS handshake is advanced by one record per call of update() in
+   * order not to block the sketch while the ECCX08 computes signatures
+   * and the records are waiting on the network round trip.
+   */
+  if (!_tls_handshake_started)
+  {
+    IPAddress broker_ip;
+    if (_brokerEndpoints.address(broker_ip, millis()))
+      _tls_handshake_started = _sslClient.connectAsync(broker_ip, _brokerEndpoints.port(), _brokerEndpoints.host().c_str());
+    else
+      _tls_handshake_started = _sslClient.connectAsync(_brokerEndpoints.host().c_str(), _brokerEndpoints.port());
+    _tls_handshake_tick = millis();
+    if (_tls_handshake_started)
+      return State::ConnectMqttBroker;
+    tls_connected = false;
+  }
+  else
+  {
+    BearSSLClient::Handshake const handshake = _sslClient.pollHandshake();
+    bool const handshake_timeout = (millis() - _tls_handshake_tick) > AIOT_CONFIG_TLS_HANDSHAKE_TIMEOUT_ms;
+    if ((handshake == BearSSLClient::Handshake::InProgress) && !handshake_timeout)
+      return State::ConnectMqttBroker;
+    if (handshake != BearSSLClient::Handshake::Completed)
+    {
+      _sslClient.stop();
+      tls_connected = false;
+    }
+    _tls_handshake_started = false;
+  }
+#endif
+
+  if (tls_connected && _mqttClient.connect(_brokerEndpoints.host().c_str(), _brokerEndpoints.port()))
+  {
+    invalidateMqttConnected();
+    _last_connection_attempt_cnt = 0;
+    _brokerEndpoints.onConnected();
+#ifdef BOARD_HAS_ECCX08
+    _tls_handshake = _sslClient.isSessionResumed() ? TlsHandshake::Resumed : TlsHandshake::Full;
+#else
+    _tls_handshake = TlsHandshake::Full;
+#endif
+    DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s %s TLS handshake", __FUNCTION__, (_tls_handshake == TlsHandshake::Resumed) ? "resumed" : "full");
+    /* The session starts without any subscriptions */
+    _deviceSubscribedToThing = false;
+    _topics.clearRetiredThing();
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+    _keep_alive.onConnected(millis());
+#endif
+#ifdef HAS_GATEWAY
+    resetGatewayThings();
+#endif
+#ifdef HAS_PERF_COUNTERS
+    /* The asynchronous handshake started in an earlier update() */
+#ifdef BOARD_HAS_ECCX08
+    _perf.onConnect(millis() - _tls_handshake_tick);
+#else
+    _perf.onConnect(millis() - connect_tick);
+#endif
+#endif
+#if AIOT_CONFIG_FAST_RESUME_ENABLED
+    if (resumeThingTopics())
+      return State::Connected;
+#endif
+    return State::SendDeviceProperties;
+  }
+
+  DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not connect to %s:%d", __FUNCTION__, _brokerEndpoints.host().c_str(), _brokerEndpoints.port());
+
+  /* A broker refusing the connection because it is unavailable is taken as
+   * a hint to back off for the maximum delay right away. Otherwise the next
+   * endpoint is tried without delay until all of them failed.
+   */
+  bool const server_unavailable = (_mqttClient.connectError() == MQTT_SERVER_UNAVAILABLE);
+  if (!_brokerEndpoints.onFailure() && !server_unavailable)
+    return State::ConnectMqttBroker;
+
+  _last_connection_attempt_cnt++;
+  unsigned int const reconnection_attempt = server_unavailable ? UINT8_MAX : _last_connection_attempt_cnt;
+  unsigned long const reconnection_retry_delay = backoff_delay(reconnection_attempt, AIOT_CONFIG_RECONNECTION_RETRY_DELAY_ms, AIOT_CONFIG_MAX_RECONNECTION_RETRY_DELAY_ms);
+  _next_connection_attempt_tick = millis() + reconnection_retry_delay;
+
+  DEBUG_ERROR("ArduinoIoTCloudTCP::%s %d connection attempt at tick time %d", __FUNCTION__, _last_connection_attempt_cnt, _next_connection_attempt_tick);
+  return State::ConnectPhy;
+}
+
+ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SendDeviceProperties()
+{
+  if (!isMqttConnected())
+  {
+    return State::Disconnect;
+  }
+
+#ifdef HAS_PERF_COUNTERS
+  _perf_report = _perf.toString();
+#endif
+  sendDevicePropertiesToCloud();
+  return State::SubscribeDeviceTopic;
+}
+
+ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SubscribeDeviceTopic()
+{
+  if (!isMqttConnected())
+  {
+    return State::Disconnect;
+  }
+
+  if (!_mqttClient.subscribe(_topics.deviceIn()))
+  {
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not subscribe to %s", __FUNCTION__, _topics.deviceIn());
+    return State::SubscribeDeviceTopic;
+  }
+
+  if (_last_device_subscribe_cnt > AIOT_CONFIG_LASTVALUES_SYNC_MAX_RETRY_CNT)
+  {
+    _last_device_subscribe_cnt = 0;
+    _next_device_subscribe_attempt_tick = 0;
+    _mqttClient.stop();
+    invalidateMqttConnected();
+    execCloudEventCallback(ArduinoIoTCloudEvent::DISCONNECT);
+    return State::ConnectPhy;
+  }
+
+  /* No device configuration reply. Wait up to: 5s -> 10s -> 20s -> 30s */
+  unsigned long const subscribe_retry_delay = backoff_delay(_last_device_subscribe_cnt, AIOT_CONFIG_DEVICE_TOPIC_SUBSCRIBE_RETRY_DELAY_ms, AIOT_CONFIG_MAX_DEVICE_TOPIC_SUBSCRIBE_RETRY_DELAY_ms);
+  _next_device_subscribe_attempt_tick = millis() + subscribe_retry_delay;
+  _last_device_subscribe_cnt++;
+
+  return State::WaitDeviceConfig;
+}
+
+ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_WaitDeviceConfig()
+{
+  if (!isMqttConnected())
+  {
+    return State::Disconnect;
+  }
+
+  if (getThingIdOutdatedFlag())
+  {
+    return State::CheckDeviceConfig;
+  }
+
+  if (millis() > _next_device_subscribe_attempt_tick)
+  {
+    /* Configuration not received or device not attached to a valid thing. Try to resubscribe */
+    if (_mqttClient.unsubscribe(_topics.deviceIn()))
+    {
+      DEBUG_ERROR("ArduinoIoTCloudTCP::%s device waiting for valid thing_id", __FUNCTION__);
+      return State::SubscribeDeviceTopic;
+    }
+  }
+  return State::WaitDeviceConfig;
+}
+
+ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_CheckDeviceConfig()
+{
+  if (!isMqttConnected())
+  {
+    return State::Disconnect;
+  }
+
+  if (_deviceSubscribedToThing && _topics.isThingId(getThingId()))
+  {
+    /* The cloud repeated the thing the device is attached to already, the
+     * subscriptions are kept and the sync carries on where it was.
+     */
+    clrThingIdOutdatedFlag();
+    return (_last_sync_request_cnt == 0) ? State::Connected : State::RequestLastValues;
+  }
+
+  if(_deviceSubscribedToThing == true)
+  {
+#if AIOT_CONFIG_FAST_RESUME_ENABLED
+    _fast_resume.magic = 0;
+#endif
+    /* The old thing topics are only unsubscribed once the device is attached
+     * to the new thing, messages still arriving on them are not routed.
+     */
+    if (_topics.hasRetiredThing())
+      unsubscribeRetiredThingTopics();
+    _topics.retireThing();
+    _deviceSubscribedToThing = false;
+    DEBUG_INFO("Disconnected from Arduino IoT Cloud");
+    execCloudEventCallback(ArduinoIoTCloudEvent::DISCONNECT);
+  }
+
+  updateThingTopics();
 
   if (deviceNotAttached())
   {
-    /* Configuration received but device not attached. Wait: 40s */
-    unsigned long attach_retry_delay = (1 << _last_device_attach_cnt) * AIOT_CONFIG_DEVICE_TOPIC_SUBSCRIBE_RETRY_DELAY_ms;
-    attach_retry_delay = min(attach_retry_delay, static_cast<unsigned long>(AIOT_CONFIG_MAX_DEVICE_TOPIC_ATTACH_RETRY_DELAY_ms));
+    /* Configuration received but device not attached. Wait up to: 5s -> 10s -> 20s -> ... */
+    unsigned long const attach_retry_delay = backoff_delay(_last_device_attach_cnt, AIOT_CONFIG_DEVICE_TOPIC_SUBSCRIBE_RETRY_DELAY_ms, AIOT_CONFIG_MAX_DEVICE_TOPIC_ATTACH_RETRY_DELAY_ms);
     _next_device_subscribe_attempt_tick = millis() + attach_retry_delay;
     _last_device_attach_cnt++;
     return State::WaitDeviceConfig;
@@ -432,7 +1314,7 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_CheckDeviceConfig()
 
 ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SubscribeThingTopics()
 {
-  if (!_mqttClient.connected())
+  if (!isMqttConnected())
   {
     return State::Disconnect;
   }
@@ -456,6 +1338,7 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SubscribeThingTopics()
     _last_subscribe_request_cnt = 0;
     _last_subscribe_request_tick = 0;
     _mqttClient.stop();
+    invalidateMqttConnected();
     execCloudEventCallback(ArduinoIoTCloudEvent::DISCONNECT);
     return State::ConnectPhy;
   }
@@ -463,18 +1346,27 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SubscribeThingTopics()
   _last_subscribe_request_tick = now;
   _last_subscribe_request_cnt++;
 
-  if (!_mqttClient.subscribe(_dataTopicIn))
+  if (!_mqttClient.subscribe(_topics.shadowIn(), AIOT_CONFIG_MQTT_SUBSCRIBE_QOS))
   {
-    DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not subscribe to %s", __FUNCTION__, _dataTopicIn.c_str());
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not subscribe to %s", __FUNCTION__, _topics.shadowIn());
 #if !defined(__AVR__)
     DEBUG_ERROR("Check your thing configuration, and press the reset button on your board.");
 #endif
     return State::SubscribeThingTopics;
   }
 
-  if (!_mqttClient.subscribe(_shadowTopicIn))
+  /* The last values are requested right away so that the reply travels while
+   * waiting for the acknowledgement of the data topic subscription. If it
+   * arrives meanwhile it is completed below, otherwise in RequestLastValues.
+   */
+  DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s [%d] last values requested", __FUNCTION__, now);
+  requestLastValue(_topics.shadowOut());
+  _last_sync_request_tick = now;
+  _last_sync_request_cnt = 1;
+
+  if (!_mqttClient.subscribe(_topics.dataIn(), AIOT_CONFIG_MQTT_SUBSCRIBE_QOS))
   {
-    DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not subscribe to %s", __FUNCTION__, _shadowTopicIn.c_str());
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not subscribe to %s", __FUNCTION__, _topics.dataIn());
 #if !defined(__AVR__)
     DEBUG_ERROR("Check your thing configuration, and press the reset button on your board.");
 #endif
@@ -485,6 +1377,14 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SubscribeThingTopics()
   DEBUG_INFO("Thing ID: %s", getThingId().c_str());
   execCloudEventCallback(ArduinoIoTCloudEvent::CONNECT);
   _deviceSubscribedToThing = true;
+  /* The next thing is subscribed right away, not after the retry delay */
+  _last_subscribe_request_cnt = 0;
+
+  if (_last_values_received)
+  {
+    handleLastValues();
+    return State::Connected;
+  }
 
   /*Add retry wait time otherwise we are trying to reconnect every 250 ms...*/
   return State::RequestLastValues;
@@ -492,7 +1392,7 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_SubscribeThingTopics()
 
 ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_RequestLastValues()
 {
-  if (!_mqttClient.connected())
+  if (!isMqttConnected())
   {
     return State::Disconnect;
   }
@@ -509,7 +1409,7 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_RequestLastValues()
   if (is_first_sync_request || is_sync_request_timeout)
   {
     DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s [%d] last values requested", __FUNCTION__, now);
-    requestLastValue();
+    requestLastValue(_topics.shadowOut());
     _last_sync_request_tick = now;
     /* Track the number of times a get-last-values request was sent to the cloud.
      * If no data is received within a certain number of retry-requests it's a better
@@ -521,20 +1421,28 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_RequestLastValues()
       _last_sync_request_cnt = 0;
       _last_sync_request_tick = 0;
       _mqttClient.stop();
+      invalidateMqttConnected();
       execCloudEventCallback(ArduinoIoTCloudEvent::DISCONNECT);
       return State::ConnectPhy;
     }
   }
 
+  /* Properties which the cloud can not write do not depend on the last
+   * values, there is no need to hold them back until they are received.
+   */
+  updateTimestampOnLocallyChangedProperties(_thing_property_container);
+  if (!batchActive() && !callbacksPending())
+    sendThingPropertiesToCloud(true);
+
   return State::RequestLastValues;
 }
 
 ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Connected()
 {
-  if (!_mqttClient.connected())
+  if (!isMqttConnected())
   {
-    /* The last message was definitely lost, trigger a retransmit. */
-    _mqtt_data_request_retransmit = true;
+    /* The messages sent recently might have been lost, replay them. */
+    replayOutboundQueue();
     return State::Disconnect;
   }
   /* We are connected so let's to our stuff here. */
@@ -545,6 +1453,11 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Connected()
       return State::CheckDeviceConfig;
     }
 
+    if (_topics.hasRetiredThing())
+    {
+      unsubscribeRetiredThingTopics();
+    }
+
     /* Check if a primitive property wrapper is locally changed.
     * This function requires an existing time service which in
     * turn requires an established connection. Not having that
@@ -552,25 +1465,54 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Connected()
     * the connection from being established due to a wrong data
     * in the reconstructed certificate.
     */
+#ifdef HAS_TIMEZONE_REQUEST
+    if (_tz_received)
+      handleTimezone();
+#endif
     updateTimestampOnLocallyChangedProperties(_thing_property_container);
+#if AIOT_CONFIG_STATIC_ALLOCATION_ENABLED
+    /* The TLS session, the thing and its topics have been set up by now */
+    if (!_has_been_connected)
+      StaticArena::lockHeap();
+#endif
+    _has_been_connected = true;
 
     /* Retransmit data in case there was a lost transaction due
     * to phy layer or MQTT connectivity loss.
     */
-    if(_mqtt_data_request_retransmit && (_mqtt_data_len > 0)) {
-      write(_dataTopicOut, _mqtt_data_buf, _mqtt_data_len);
-      _mqtt_data_request_retransmit = false;
-    }
+    flushOutboundQueue();
 
 #if OTA_ENABLED
     /* Request a OTA download if the hidden property
      * OTA request has been set.
      */
 
-    if (_ota_req)
+    if (_ota_req && !OTA::isInProgress())
     {
       bool const ota_execution_allowed_by_user = (_get_ota_confirmation != nullptr && _get_ota_confirmation());
       bool const perform_ota_now = ota_execution_allowed_by_user || !_ask_user_before_executing_ota;
+#ifdef HAS_OTA_PREFETCH
+      if (perform_ota_now && OTA::isStaged(otaDownloadUrl())) {
+        _ota_error = static_cast<int>(OTAError::None);
+        _ota_req = false;
+        sendDevicePropertyToCloud("OTA_REQ");
+        /* Only resets into the prefetched image, returns on failure */
+        _ota_error = OTA::apply();
+        sendDevicePropertyToCloud("OTA_ERROR");
+      }
+      else if (!perform_ota_now && (_ota_prefetch_url != _ota_url)) {
+        /* Download the image while the sketch still defers the update, it
+         * is polled below like any other download but not applied.
+         */
+        _ota_prefetch_url = _ota_url;
+        _ota_error = OTA::prefetch(otaDownloadUrl(), _connection->getInterface(), otaDownloadSHA256());
+        _ota_url_sha256.consume();
+        _ota_progress = -1;
+        if (_ota_error != static_cast<int>(OTAError::None))
+          sendDevicePropertyToCloud("OTA_ERROR");
+      }
+      else
+#endif
       if (perform_ota_now) {
         /* Clear the error flag. */
         _ota_error = static_cast<int>(OTAError::None);
@@ -578,29 +1520,109 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Connected()
         _ota_req = false;
         /* Transmit the cleared request flags to the cloud. */
         sendDevicePropertyToCloud("OTA_REQ");
-        /* Call member function to handle OTA request. */
-        _ota_error = OTA::onRequest(_ota_url, _connection->getInterface());
+        /* Start the download, it is advanced below on each call
+         * so that the MQTT connection is kept alive meanwhile.
+         */
+#ifdef HAS_STALL_TRACE
+        stall_trace().phase(StallPhase::OTAStart);
+#endif
+        _ota_error = OTA::start(otaDownloadUrl(), _connection->getInterface(), otaDownloadSHA256());
+        _ota_url_sha256.consume();
+        _ota_progress = -1;
         /* If something fails send the OTA error to the cloud */
         sendDevicePropertyToCloud("OTA_ERROR");
+        if (_ota_error != static_cast<int>(OTAError::None))
+        {
+          _ota_metrics = OTA::toString(OTA::metrics());
+          sendDevicePropertyToCloud("OTA_METRICS");
+        }
+      }
+    }
+    else if (OTA::isInProgress())
+    {
+#ifdef HAS_STALL_TRACE
+      stall_trace().phase(StallPhase::OTAPoll);
+#endif
+      _ota_error = OTA::poll();
+      if (_ota_error != static_cast<int>(OTAError::None))
+      {
+        sendDevicePropertyToCloud("OTA_ERROR");
+        /* Tells where the failed download got stuck */
+        _ota_metrics = OTA::toString(OTA::metrics());
+        sendDevicePropertyToCloud("OTA_METRICS");
+      }
+      /* Report the progress in steps of 10 percent */
+      int const ota_progress = OTA::progress();
+      if ((ota_progress / 10) != (_ota_progress / 10))
+      {
+        _ota_progress = ota_progress;
+        sendDevicePropertyToCloud("OTA_PROGRESS");
       }
     }
 
-    /* Check if we have received the OTA_URL property and provide
-    * echo to the cloud.
+    /* Provide the echo once the OTA_URL property has been received. The
+    * initial value is sent once as well.
     */
-    sendDevicePropertyToCloud("OTA_URL");
+    if (_ota_url_received)
+    {
+      _ota_url_received = false;
+      sendDevicePropertyToCloud("OTA_URL");
+    }
 
 #endif /* OTA_ENABLED */
 
     /* Check if any properties need encoding and send them to
-    * the cloud if necessary.
+    * the cloud if necessary. While a batch is open nothing is sent,
+    * a committed batch is packed into as few messages as possible.
     */
-    sendThingPropertiesToCloud();
+    if (!isTransmitWindowOpen())
+    {
+      /* Held back until the modem wakes up for the next window */
+    }
+    else if (_batch_committed)
+    {
+      sendThingBatchToCloud();
+      _batch_committed = false;
+    }
+    else if (!batchActive() && !callbacksPending() && isPublishDue())
+    {
+      /* The values set by the callbacks still pending are sent along with them */
+#ifdef HAS_BURST_FLUSH
+      sendThingBurstToCloud();
+#else
+      sendThingPropertiesToCloud();
+#endif
+    }
+
+#ifdef HAS_GATEWAY
+    /* The things behind the gateway queue up after the own one */
+    updateGatewayThings();
+#endif
+
+#ifdef HAS_PERF_COUNTERS
+    /* Report the performance counters at a low rate */
+    if ((millis() - _perf_report_tick) >= AIOT_CONFIG_PERF_COUNTERS_INTERVAL_ms)
+    {
+      _perf_report_tick = millis();
+      _perf_report = _perf.toString();
+      sendDevicePropertyToCloud("PERF");
+    }
+#endif
+
+#ifdef HAS_TRACE_CAPTURE
+    updateTraceCapture();
+#endif
 
     unsigned long const internal_posix_time = _time_service.getTime();
     if(internal_posix_time < _tz_dst_until) {
       return State::Connected;
-    } else {
+    }
+#ifdef HAS_TIMEZONE_REQUEST
+    else if (requestTimezone(millis())) {
+      return State::Connected;
+    }
+#endif
+    else {
       return State::RequestLastValues;
     }
   }
@@ -609,7 +1631,15 @@ ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Connected()
 ArduinoIoTCloudTCP::State ArduinoIoTCloudTCP::handle_Disconnect()
 {
   DEBUG_ERROR("ArduinoIoTCloudTCP::%s MQTT client connection lost", __FUNCTION__);
+  _last_values_received = false;
+#ifdef HAS_PERF_COUNTERS
+  _perf.onReconnect();
+#endif
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+  _keep_alive.onDisconnected();
+#endif
   _mqttClient.stop();
+  invalidateMqttConnected();
   execCloudEventCallback(ArduinoIoTCloudEvent::DISCONNECT);
   return State::ConnectPhy;
 }
@@ -621,110 +1651,1020 @@ void ArduinoIoTCloudTCP::onMessage(int length)
 
 void ArduinoIoTCloudTCP::handleMessage(int length)
 {
-  String topic = _mqttClient.messageTopic();
-
-  byte bytes[length];
+  /* The topic is copied once by the MQTT client and then routed by its
+   * precomputed hash rather than compared against each subscribed topic.
+   */
+  String const topic = _mqttClient.messageTopic();
+#ifdef HAS_TRANSMIT_WINDOW
+  _transmit_window.align(millis());
+#endif
+  InboundTopic const inbound = static_cast<InboundTopic>(_topicRouter.match(topic.c_str(), topic.length()));
 
-  for (int i = 0; i < length; i++) {
-    bytes[i] = _mqttClient.read();
-  }
+  bool const is_device_message = (inbound == InboundTopic::Device);
+  bool is_data_message = (inbound == InboundTopic::Data);
+  bool is_sync_message = (inbound == InboundTopic::Shadow) && ((_state == State::RequestLastValues) || (_state == State::SubscribeThingTopics));
+  PropertyContainer * property_container = is_device_message ? &_device_property_container : &_thing_property_container;
 
-  /* Topic for OTA properties and device configuration */
-  if (_deviceTopicIn == topic) {
-    CBORDecoder::decode(_device_property_container, (uint8_t*)bytes, length);
-    _last_device_subscribe_cnt = 0;
-    _next_device_subscribe_attempt_tick = 0;
+#ifdef HAS_GATEWAY
+  /* Messages for the things behind the gateway are told apart only once
+   * those of the gateway itself have been ruled out.
+   */
+  CloudThing::Topic gateway_inbound = CloudThing::Topic::None;
+  CloudThing * const gateway_thing = (inbound == InboundTopic::None) ? matchGatewayThing(topic, gateway_inbound) : nullptr;
+  if (gateway_thing != nullptr)
+  {
+    is_data_message = (gateway_inbound == CloudThing::Topic::Data);
+    is_sync_message = (gateway_inbound == CloudThing::Topic::Shadow) && (gateway_thing->_state == CloudThing::State::RequestLastValues);
+    property_container = &gateway_thing->_property_container;
   }
+#endif
 
-  /* Topic for user input data */
-  if (_dataTopicIn == topic) {
-    CBORDecoder::decode(_thing_property_container, (uint8_t*)bytes, length);
-  }
+  /* The payload is read in bulk and decoded while it is being received. Messages
+   * on other topics are read as well in order to discard them.
+   */
+#ifdef HAS_PROFILING
+  ProfileScope const profile(_profile.section(ProfileSection::Decode));
+#endif
+#ifdef HAS_PERF_COUNTERS
+  unsigned long const perf_decode_start_us = micros();
+  size_t const perf_message_length = (length > 0) ? static_cast<size_t>(length) : 0;
+#endif
+  CBORDecoder decoder(*property_container, is_sync_message);
+  bool decode = is_device_message || is_data_message || is_sync_message;
+#if OTA_ENABLED
+  /* Tells whether the message writes the hash of the image */
+  String const ota_url_sha256 = is_device_message ? _ota_url_sha256.value() : String("");
+#endif
+
+#ifdef HAS_CORE_LINK
+  /* The thing lives on the other core, its messages are passed on as they are */
+  if (isCoreLinkNetwork() && (property_container == &_thing_property_container) && (is_data_message || is_sync_message))
+  {
+    if (!forwardToCoreLink(is_sync_message ? CoreLink::Kind::Sync : CoreLink::Kind::Data, length))
+      DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not pass message on topic %s to the other core", __FUNCTION__, topic.c_str());
+    decode = false;
+  }
+#endif
 
-  /* Topic for sync Thing last values on connect */
-  if ((_shadowTopicIn == topic) && (_state == State::RequestLastValues))
+#ifdef HAS_MQTT_DEDUP
+  bool const is_dedup_message = decode && ((inbound == InboundTopic::Data) || (inbound == InboundTopic::Shadow));
+  uint32_t digest = MessageDedup::begin(topic.c_str(), topic.length());
+  if (is_dedup_message && _mqttClient.messageDup())
   {
-    DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s [%d] last values received", __FUNCTION__, millis());
-    CBORDecoder::decode(_thing_property_container, (uint8_t*)bytes, length, true);
-    _time_service.setTimeZoneData(_tz_offset, _tz_dst_until);
-    execCloudEventCallback(ArduinoIoTCloudEvent::SYNC);
-    _last_sync_request_cnt = 0;
-    _last_sync_request_tick = 0;
-    _state = State::Connected;
+    /* A message delivered again is read in full before any of it is applied.
+     * If it has been applied already it is dropped, the client has
+     * acknowledged it anyway. One which does not fit into the decoder buffer
+     * is decoded as any other.
+     */
+    size_t available = 0;
+    uint8_t * buf = decoder.writeBuffer(available);
+    if (buf && (static_cast<size_t>(length) <= available))
+    {
+      size_t received = 0;
+      while (received < static_cast<size_t>(length))
+      {
+        int const bytes_read = _mqttClient.read(buf + received, length - received);
+        if (bytes_read <= 0)
+          break;
+        received += bytes_read;
+      }
+      digest = MessageDedup::update(digest, buf, received);
+      length -= received;
+      if (_dedup.contains(digest))
+      {
+        DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s dropped duplicate message on topic %s", __FUNCTION__, topic.c_str());
+        return;
+      }
+      decoder.commit(received);
+    }
+  }
+#endif
+
+  while (length > 0)
+  {
+    size_t available = 0;
+    uint8_t * buf = decoder.writeBuffer(available);
+    if (!buf)
+      break;
+    int const bytes_read = _mqttClient.read(buf, std::min(available, static_cast<size_t>(length)));
+    if (bytes_read <= 0)
+      break;
+#ifdef HAS_MQTT_DEDUP
+    if (is_dedup_message)
+      digest = MessageDedup::update(digest, buf, bytes_read);
+#endif
+    if (decode)
+      decoder.commit(bytes_read);
+    length -= bytes_read;
+  }
+
+#ifdef HAS_MQTT_DEDUP
+  if (is_dedup_message && decoder.isComplete())
+    _dedup.add(digest);
+#endif
+
+  if (decode && !decoder.isComplete())
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not decode message on topic %s", __FUNCTION__, topic.c_str());
+
+#ifdef HAS_PERF_COUNTERS
+  _perf.onReceive(perf_message_length, micros() - perf_decode_start_us);
+#endif
+
+  /* Topic for OTA properties and device configuration */
+  if (is_device_message) {
+    _last_device_subscribe_cnt = 0;
+    _next_device_subscribe_attempt_tick = 0;
+#if OTA_ENABLED
+    _ota_url_sha256.onMessage(ota_url_sha256, _ota_url);
+#endif
+  }
+
+#ifdef HAS_GATEWAY
+  if (gateway_thing != nullptr)
+  {
+    if (is_sync_message)
+    {
+      gateway_thing->_state = CloudThing::State::Synced;
+      if (gateway_thing->_on_sync)
+        gateway_thing->_on_sync(*gateway_thing);
+    }
+    return;
+  }
+#endif
+
+  /* Topic for sync Thing last values on connect. While the thing topics are
+   * still being subscribed the sync is completed once that is done.
+   */
+  if (is_sync_message)
+  {
+    if (_state == State::SubscribeThingTopics)
+    {
+      _last_values_received = true;
+    }
+    else
+    {
+      handleLastValues();
+      AIOTC_TRACE(State, State::Connected);
+      _state = State::Connected;
+    }
   }
 }
 
-void ArduinoIoTCloudTCP::sendPropertyContainerToCloud(String const topic, PropertyContainer & property_container, unsigned int & current_property_index)
+void ArduinoIoTCloudTCP::handleLastValues()
 {
+  DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s [%d] last values received", __FUNCTION__, millis());
+  _time_service.setTimeZoneData(_tz_offset, _tz_dst_until);
+  execCloudEventCallback(ArduinoIoTCloudEvent::SYNC);
+#if AIOT_CONFIG_FAST_RESUME_ENABLED
+  saveThingTopics();
+#endif
+  _last_values_received = false;
+  _last_sync_request_cnt = 0;
+  _last_sync_request_tick = 0;
+#ifdef HAS_TIMEZONE_REQUEST
+  _tz_request_cnt = 0;
+#endif
+}
+
+void ArduinoIoTCloudTCP::sendPropertyContainerToCloud(char const * topic, PropertyContainer & property_container, unsigned int & current_property_index, bool const read_only)
+{
+  /* Messages which could not be sent yet have to go out first */
+  flushOutboundQueue();
+
+  /* Transmit the properties to the MQTT broker */
+  if (enqueuePropertyContainer(topic, property_container, current_property_index, 0, false, read_only))
+    flushOutboundQueue();
+}
+
+bool ArduinoIoTCloudTCP::enqueuePropertyContainer(char const * topic, PropertyContainer & property_container, unsigned int & current_property_index, unsigned long const timestamp, bool const drop_pending, bool const read_only)
+{
+  /* If all other slots are still waiting to be sent there is no room for
+   * a new message unless the oldest one may be dropped. Otherwise the
+   * properties remain pending and are encoded later on.
+   */
+  size_t const head = _outbound_queue_head;
+  if (!drop_pending &&
+      (_outbound_queue_count == MQTT_OUTBOUND_QUEUE_SIZE - 1) &&
+      (_outbound_queue[head].state == OutboundMessageState::Pending))
+    return false;
+
+  /* Once the cloud has enabled the light payload through the device topic
+   * thing properties are encoded using their identifiers instead of their names.
+   */
+  bool const light_payload = _light_payload && (&property_container == &_thing_property_container);
+
+  /* A property which does not fit into a message of its own is sent right
+   * away with its string value streamed, unless messages are still waiting.
+   * Those are sent first in order, the string is only referenced meanwhile.
+   */
+  bool may_spill = !drop_pending && (timestamp == 0) && isMqttConnected();
+  for (size_t i = 0; may_spill && (i < _outbound_queue_count); i++)
+    may_spill = (_outbound_queue[(head + i) % MQTT_OUTBOUND_QUEUE_SIZE].state != OutboundMessageState::Pending);
+  SpilledString spill;
+
   int bytes_encoded = 0;
-  uint8_t data[MQTT_TRANSMIT_BUFFER_SIZE];
+  OutboundMessage & msg = _outbound_queue[(head + _outbound_queue_count) % MQTT_OUTBOUND_QUEUE_SIZE];
+  size_t size = sizeof(msg.data);
+
+#ifdef HAS_DATA_BUDGET
+  /* The thing updates are encoded into what is left of the budget, the high
+   * priority ones first. Those which do not fit remain pending.
+   */
+  if ((&property_container == &_thing_property_container) && _data_budget.isEnabled())
+  {
+    size_t const topic_len = strlen(topic);
+    size_t const left = dataBudgetLeft(millis());
+    if (left < topic_len + AIOT_CONFIG_DATA_BUDGET_MIN_BYTES)
+      return false;
+    if ((left - topic_len) < size)
+    {
+      size = left - topic_len;
+      may_spill = false;
+    }
+  }
+#endif
+
+  {
+#ifdef HAS_PROFILING
+    ProfileScope const profile(_profile.section(ProfileSection::Encode));
+#endif
+#ifdef HAS_PERF_COUNTERS
+    unsigned long const perf_encode_start_us = micros();
+#endif
+    CborError const err = CBOREncoder::encode(property_container, msg.data, size, bytes_encoded, current_property_index, light_payload, timestamp, AIOT_CONFIG_SENML_BASE_VALUES_ENABLED, false, read_only, may_spill ? &spill : nullptr);
+#ifdef HAS_PERF_COUNTERS
+    _perf.onEncode(micros() - perf_encode_start_us);
+#endif
+    if (err != CborNoError)
+      return false;
+  }
+  if (bytes_encoded == 0)
+    return false;
+
+  /* The spilled message is not queued for a replay, it is sent again if lost right away */
+  if (spill.data != nullptr)
+  {
+    if (!writeSpilled(topic, msg.data, bytes_encoded, spill))
+      spill.property->provideEcho();
+    return true;
+  }
+
+#ifdef HAS_MESSAGE_FANOUT
+  /* The sinks take the message encoded for the cloud, they resolve the properties by name */
+  msg.is_timestamped = (timestamp != 0);
+  msg.sinks = 0;
+  if ((&property_container == &_thing_property_container) && !light_payload)
+    msg.sinks = _fanout.deliver(_fanout.all(), msg.data, bytes_encoded, msg.is_timestamped);
+#endif
+
+  msg.state = OutboundMessageState::Pending;
+  msg.topic = topic;
+  msg.is_echoed_on_replay = (&property_container == &_thing_property_container) && (timestamp == 0) && property_container.canProvideEcho(property_container.appended());
+  if (msg.is_echoed_on_replay)
+    memcpy(msg.properties, property_container.appended(), sizeof(msg.properties));
+  msg.length = bytes_encoded;
+  _outbound_queue_count++;
+
+  /* Keep the next slot free for encoding by dropping the oldest message */
+  if (_outbound_queue_count == MQTT_OUTBOUND_QUEUE_SIZE) {
+    _outbound_queue_head = (_outbound_queue_head + 1) % MQTT_OUTBOUND_QUEUE_SIZE;
+    _outbound_queue_count--;
+  }
+  return true;
+}
+
+void ArduinoIoTCloudTCP::flushOutboundQueue()
+{
+  /* Messages are sent in order, stop at the first one which fails. Should the
+   * coalesced messages fail to go out the connection is closed, they are then
+   * replayed as all others in flight.
+   */
+#ifdef HAS_RATE_CONTROL
+  unsigned long const write_start_tick = millis();
+  size_t sent_cnt = 0;
+  bool is_failed = false;
+#endif
+#ifdef HAS_MESSAGE_FANOUT
+  retryMessageSinks();
+#endif
+  corkTransmission();
+  for (size_t i = 0; i < _outbound_queue_count; i++)
+  {
+    OutboundMessage & msg = _outbound_queue[(_outbound_queue_head + i) % MQTT_OUTBOUND_QUEUE_SIZE];
+    if (msg.state != OutboundMessageState::Pending)
+      continue;
+    if (!write(msg.topic, msg.data, msg.length))
+    {
+#ifdef HAS_RATE_CONTROL
+      is_failed = true;
+#endif
+      break;
+    }
+    msg.state = OutboundMessageState::InFlight;
+#ifdef HAS_RATE_CONTROL
+    sent_cnt++;
+#endif
+  }
+#ifdef HAS_RATE_CONTROL
+  is_failed = !uncorkTransmission() || is_failed;
+  /* The coalesced messages leave with the uncork, the time they took tells the link */
+  unsigned long const now = millis();
+  if (is_failed)
+    _rate_control.onWriteFailed();
+  else if (sent_cnt > 0)
+    _rate_control.onWrite(now - write_start_tick);
+  if (sent_cnt > 0)
+    _rate_control.onPublish(now);
+#else
+  uncorkTransmission();
+#endif
+}
+
+void ArduinoIoTCloudTCP::replayOutboundQueue()
+{
+#ifdef HAS_RATE_CONTROL
+  bool is_retransmit = false;
+#endif
+  /* The messages which are echoed are dropped, the others are kept in order */
+  size_t kept = 0;
+  for (size_t i = 0; i < _outbound_queue_count; i++)
+  {
+    OutboundMessage & msg = _outbound_queue[(_outbound_queue_head + i) % MQTT_OUTBOUND_QUEUE_SIZE];
+#ifdef HAS_PERF_COUNTERS
+    if (msg.state == OutboundMessageState::InFlight)
+      _perf.onRetransmit();
+#endif
+#ifdef HAS_RATE_CONTROL
+    is_retransmit = is_retransmit || (msg.state == OutboundMessageState::InFlight);
+#endif
+    if (msg.is_echoed_on_replay)
+    {
+      _thing_property_container.provideEcho(msg.properties);
+      continue;
+    }
+    msg.state = OutboundMessageState::Pending;
+    if (kept != i)
+      _outbound_queue[(_outbound_queue_head + kept) % MQTT_OUTBOUND_QUEUE_SIZE] = msg;
+    kept++;
+  }
+  _outbound_queue_count = kept;
+#ifdef HAS_RATE_CONTROL
+  /* Once per connection lost, however many messages were in flight */
+  if (is_retransmit)
+    _rate_control.onRetransmit();
+#endif
+}
+
+#if AIOT_CONFIG_OFFLINE_SAMPLES_ENABLED
+void ArduinoIoTCloudTCP::recordOfflineSamples()
+{
+  /* Recorded samples are timestamped, therefore the time service must
+   * have been synchronised at least once.
+   */
+  if (!_has_been_connected || isMqttConnected())
+    return;
+
+  updateTimestampOnLocallyChangedProperties(_thing_property_container);
+  enqueuePropertyContainer(_topics.dataOut(), _thing_property_container, _last_checked_property_index, _time_service.getTime(), true);
+}
+#endif
+
+#ifdef HAS_MESSAGE_FANOUT
+void ArduinoIoTCloudTCP::retryMessageSinks()
+{
+  /* Independent of the cloud, a message may be pending for a sink once in flight */
+  for (size_t i = 0; i < _outbound_queue_count; i++)
+  {
+    OutboundMessage & msg = _outbound_queue[(_outbound_queue_head + i) % MQTT_OUTBOUND_QUEUE_SIZE];
+    if (msg.sinks != 0)
+      msg.sinks = _fanout.deliver(msg.sinks, msg.data, msg.length, msg.is_timestamped);
+  }
+}
+#endif
+
+#ifdef HAS_LOCAL_MIRROR
+void ArduinoIoTCloudTCP::mirrorToPeers(byte const data[], int const length)
+{
+  if ((_mirror_udp == nullptr) || !_mirror.isAttached())
+    return;
+
+  /* Datagrams are sent best effort, a lost one is superseded by the cloud */
+  uint8_t header[LocalMirror::HEADER_SIZE];
+  uint8_t tag[LocalMirror::TAG_SIZE];
+  _mirror.header(header);
+  _mirror.tag(header, data, length, tag);
+  if (!_mirror_udp->beginPacket(_mirror_group, _mirror_port))
+    return;
+  _mirror_udp->write(header, sizeof(header));
+  _mirror_udp->write(data, length);
+  _mirror_udp->write(tag, sizeof(tag));
+  _mirror_udp->endPacket();
+}
+
+uint32_t ArduinoIoTCloudTCP::mirrorEpoch()
+{
+  /* The thing is attached once connected, the time is known by then */
+  uint32_t epoch = static_cast<uint32_t>(_time_service.getTime()) ^ micros();
+#ifdef BOARD_HAS_ECCX08
+  uint32_t drbg_random = 0;
+  if (drbg_generate(&drbg_random, sizeof(drbg_random)))
+    epoch ^= drbg_random;
+#endif
+  return epoch;
+}
+
+void ArduinoIoTCloudTCP::receiveFromPeers()
+{
+  if (_mirror_udp == nullptr)
+    return;
+
+  /* A frame larger than the buffer is not one of ours and skipped */
+  int length = 0;
+  while ((length = _mirror_udp->parsePacket()) > 0)
+  {
+    if (static_cast<size_t>(length) > sizeof(_mirror_buf))
+      continue;
+    int const bytes_read = _mirror_udp->read(_mirror_buf, sizeof(_mirror_buf));
+    size_t message_length = 0;
+    uint8_t reply[LocalMirror::REPLY_SIZE];
+    size_t reply_length = 0;
+    uint8_t const * message = (bytes_read > 0) ? _mirror.accept(_mirror_buf, bytes_read, message_length, reply, reply_length) : nullptr;
+    if (message != nullptr)
+      CBORDecoder::decode(_thing_property_container, message, message_length, false, true);
+    /* The handshake of a peer not synchronized yet */
+    if ((reply_length > 0) && _mirror_udp->beginPacket(_mirror_group, _mirror_port))
+    {
+      _mirror_udp->write(reply, reply_length);
+      _mirror_udp->endPacket();
+    }
+  }
+}
+#endif
+
+#ifdef HAS_CORE_LINK
+void ArduinoIoTCloudTCP::updateCoreLink()
+{
+  /* The messages of the other core are handled as those of the cloud */
+  CoreLink::Kind kind = CoreLink::Kind::Data;
+  uint8_t const * data = nullptr;
+  size_t length = 0;
+  while (_core_link->peek(kind, data, length))
+  {
+    switch (kind)
+    {
+    case CoreLink::Kind::Data:
+      CBORDecoder::decode(_thing_property_container, data, length);
+      break;
+    case CoreLink::Kind::Sync:
+      CBORDecoder::decode(_thing_property_container, data, length, true);
+      _is_core_link_synced = true;
+      execCloudEventCallback(ArduinoIoTCloudEvent::SYNC);
+      break;
+    case CoreLink::Kind::Connected:
+      _is_core_link_connected = true;
+      execCloudEventCallback(ArduinoIoTCloudEvent::CONNECT);
+      break;
+    case CoreLink::Kind::Disconnected:
+      _is_core_link_connected = false;
+      _is_core_link_synced = false;
+      execCloudEventCallback(ArduinoIoTCloudEvent::DISCONNECT);
+      break;
+    }
+    _core_link->pop();
+  }
+
+#ifdef HAS_DEFERRED_CALLBACKS
+  if (!_callback_queue.empty())
+    _callback_queue.drain(AIOT_CONFIG_CALLBACK_BUDGET_us);
+#endif
+
+  /* The changes are encoded right into the ring, as many messages as it takes */
+  if (!_is_core_link_synced || batchActive() || callbacksPending())
+    return;
+  _batch_committed = false;
+  updateTimestampOnLocallyChangedProperties(_thing_property_container);
+  uint8_t * buf = nullptr;
+  while ((buf = _core_link->reserve(MQTT_TRANSMIT_BUFFER_SIZE)) != nullptr)
+  {
+    int bytes_encoded = 0;
+    if ((CBOREncoder::encode(_thing_property_container, buf, MQTT_TRANSMIT_BUFFER_SIZE, bytes_encoded, _last_checked_property_index) != CborNoError) || (bytes_encoded == 0))
+      break;
+    _core_link->commit(CoreLink::Kind::Data, bytes_encoded);
+  }
+}
+
+void ArduinoIoTCloudTCP::relayCoreLink()
+{
+  /* The other core is told once the thing topics have been subscribed */
+  bool const is_connected = (_state == State::RequestLastValues) || (_state == State::Connected);
+  if ((is_connected != _is_core_link_connected) && _core_link->send(is_connected ? CoreLink::Kind::Connected : CoreLink::Kind::Disconnected))
+    _is_core_link_connected = is_connected;
+
+  /* The updates of the other core wait in the ring until the thing is synchronised */
+  if ((_state != State::Connected) || !isTransmitWindowOpen())
+    return;
+  CoreLink::Kind kind = CoreLink::Kind::Data;
+  uint8_t const * data = nullptr;
+  size_t length = 0;
+  bool is_enqueued = false;
+  while (_core_link->peek(kind, data, length))
+  {
+    if ((kind == CoreLink::Kind::Data) && !enqueueMessage(_topics.dataOut(), data, static_cast<int>(length)))
+      break;
+    _core_link->pop();
+    is_enqueued = true;
+  }
+  if (is_enqueued)
+    flushOutboundQueue();
+}
+
+bool ArduinoIoTCloudTCP::forwardToCoreLink(CoreLink::Kind const kind, int & length)
+{
+  /* The payload is received right into the ring, what is left is discarded */
+  uint8_t * const buf = _core_link->reserve(length);
+  if (!buf)
+    return false;
+  int received = 0;
+  while (received < length)
+  {
+    int const bytes_read = _mqttClient.read(buf + received, length - received);
+    if (bytes_read <= 0)
+      break;
+    received += bytes_read;
+  }
+  length -= received;
+  if (length > 0)
+    return false;
+  /* The properties added on this core, i.e. the time zone, are decoded as well */
+  CBORDecoder::decode(_thing_property_container, buf, received, kind == CoreLink::Kind::Sync);
+  _core_link->commit(kind, received);
+  return true;
+}
+
+bool ArduinoIoTCloudTCP::enqueueMessage(char const * topic, byte const data[], int const length)
+{
+  /* A message the queue can not hold is dropped rather than blocking the others */
+  if (length > MQTT_TRANSMIT_BUFFER_SIZE)
+    return true;
+
+  size_t const head = _outbound_queue_head;
+  if ((_outbound_queue_count == MQTT_OUTBOUND_QUEUE_SIZE - 1) &&
+      (_outbound_queue[head].state == OutboundMessageState::Pending))
+    return false;
+
+  /* The properties are not known on this core, a lost message is replayed as it is */
+  OutboundMessage & msg = _outbound_queue[(head + _outbound_queue_count) % MQTT_OUTBOUND_QUEUE_SIZE];
+  memcpy(msg.data, data, length);
+  msg.state = OutboundMessageState::Pending;
+  msg.topic = topic;
+  msg.is_echoed_on_replay = false;
+#ifdef HAS_MESSAGE_FANOUT
+  msg.sinks = 0;
+#endif
+  msg.length = length;
+  _outbound_queue_count++;
+
+  if (_outbound_queue_count == MQTT_OUTBOUND_QUEUE_SIZE) {
+    _outbound_queue_head = (_outbound_queue_head + 1) % MQTT_OUTBOUND_QUEUE_SIZE;
+    _outbound_queue_count--;
+  }
+  return true;
+}
+#endif
+
+#ifdef HAS_RULES
+void ArduinoIoTCloudTCP::evaluateRules()
+{
+  if (_rules_received)
+  {
+    /* An empty program removes the rules */
+    _rules_received = false;
+    RuleEngine::Error err = RuleEngine::Error::None;
+    if (_rules_program->length() > 0)
+      err = _rules.load(_thing_property_container, _rules_program->data(), _rules_program->length());
+    else
+      _rules.clear();
+    if (err != RuleEngine::Error::None)
+      DEBUG_ERROR("ArduinoIoTCloudTCP::%s rules refused, error %d", __FUNCTION__, static_cast<int>(err));
+    _rules_error = static_cast<int>(err);
+    sendDevicePropertyToCloud("RULES_ERROR");
+  }
+
+  _rules.evaluate();
+}
+#endif
+
+#ifdef HAS_TRACE_CAPTURE
+void ArduinoIoTCloudTCP::updateTraceCapture()
+{
+  unsigned long const now = millis();
+
+  if (_trace_req_received)
+  {
+    _trace_req_received = false;
+    unsigned long const duration_s = (_trace_req_s > 0) ? std::min(static_cast<unsigned long>(_trace_req_s), AIOT_CONFIG_TRACE_CAPTURE_MAX_s) : 0;
+    DEBUG_INFO("ArduinoIoTCloudTCP::%s capturing the trace for %lu s", __FUNCTION__, duration_s);
+    _trace_capture.start(duration_s * 1000UL, now);
+  }
+
+  _trace_capture.update(now);
+
+  /* The chunks are sent at a low rate while nothing else is waiting */
+  if ((_trace_capture.state() != TraceCapture::State::Uploading) ||
+      ((now - _trace_chunk_tick) < AIOT_CONFIG_TRACE_CAPTURE_CHUNK_INTERVAL_ms) ||
+      hasPendingMessages() || callbacksPending() || !isPublishDue())
+    return;
+
+  size_t const length = _trace_capture.nextChunk(_trace_chunk->data(), _trace_chunk->capacity());
+  if (length == 0)
+    return;
+  _trace_chunk->setLength(length);
+  _trace_chunk_tick = now;
+  sendDevicePropertyToCloud("TRACE");
+}
+#endif
+
+#ifdef HAS_GATEWAY
+void ArduinoIoTCloudTCP::resetGatewayThings()
+{
+  /* The subscriptions do not outlive the session, the last values are requested again */
+  for (size_t i = 0; i < _gateway_thing_cnt; i++)
+    _gateway_things[i]->_state = CloudThing::State::Subscribe;
+}
 
-  if (CBOREncoder::encode(property_container, data, sizeof(data), bytes_encoded, current_property_index, false) == CborNoError)
-    if (bytes_encoded > 0)
+void ArduinoIoTCloudTCP::updateGatewayThings()
+{
+  /* At most one thing is subscribed per call, which keeps the time spent
+   * in a single update() as low as with the thing of the board alone.
+   */
+  unsigned long const now = millis();
+  for (size_t i = 0; i < _gateway_thing_cnt; i++)
+  {
+    CloudThing & thing = *_gateway_things[i];
+    switch (thing._state)
     {
-      /* If properties have been encoded store them in the back-up buffer
-       * in order to allow retransmission in case of failure.
-       */
-      _mqtt_data_len = bytes_encoded;
-      memcpy(_mqtt_data_buf, data, _mqtt_data_len);
-      /* Transmit the properties to the MQTT broker */
-      write(topic, _mqtt_data_buf, _mqtt_data_len);
+    case CloudThing::State::Subscribe:
+      if (!_mqttClient.subscribe(thing._shadow_topic_in) || !_mqttClient.subscribe(thing._data_topic_in))
+      {
+        DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not subscribe to the topics of thing %s", __FUNCTION__, thing._thing_id.c_str());
+        return;
+      }
+      requestLastValue(thing._shadow_topic_out.c_str());
+      thing._last_sync_request_tick = now;
+      thing._state = CloudThing::State::RequestLastValues;
+      return;
+
+    case CloudThing::State::RequestLastValues:
+      if ((now - thing._last_sync_request_tick) > AIOT_CONFIG_TIMEOUT_FOR_LASTVALUES_SYNC_ms)
+      {
+        requestLastValue(thing._shadow_topic_out.c_str());
+        thing._last_sync_request_tick = now;
+      }
+      /* As for the own thing the read-only properties are not held back */
+      updateTimestampOnLocallyChangedProperties(thing._property_container);
+      sendPropertyContainerToCloud(thing._data_topic_out.c_str(), thing._property_container, thing._last_checked_property_index, true);
+      break;
+
+    case CloudThing::State::Synced:
+      updateTimestampOnLocallyChangedProperties(thing._property_container);
+      sendPropertyContainerToCloud(thing._data_topic_out.c_str(), thing._property_container, thing._last_checked_property_index);
+      break;
     }
+  }
 }
 
-void ArduinoIoTCloudTCP::sendThingPropertiesToCloud()
+CloudThing * ArduinoIoTCloudTCP::matchGatewayThing(String const & topic, CloudThing::Topic & inbound)
 {
-  sendPropertyContainerToCloud(_dataTopicOut, _thing_property_container, _last_checked_property_index);
+  for (size_t i = 0; i < _gateway_thing_cnt; i++)
+  {
+    inbound = _gateway_things[i]->match(topic.c_str(), topic.length());
+    if (inbound != CloudThing::Topic::None)
+      return _gateway_things[i];
+  }
+  return nullptr;
 }
 
+unsigned long ArduinoIoTCloudTCP::gatewayNextUpdateIn(unsigned long const now)
+{
+  unsigned long wait = ULONG_MAX;
+  for (size_t i = 0; i < _gateway_thing_cnt; i++)
+  {
+    CloudThing & thing = *_gateway_things[i];
+    unsigned long thing_wait = millisUntilNextUpdate(thing._property_container, now);
+    if (thing._state == CloudThing::State::Subscribe)
+    {
+      thing_wait = 0;
+    }
+    else if (thing._state == CloudThing::State::RequestLastValues)
+    {
+      unsigned long const since = now - thing._last_sync_request_tick;
+      unsigned long const retry_wait = (since > AIOT_CONFIG_TIMEOUT_FOR_LASTVALUES_SYNC_ms) ? 0 : (AIOT_CONFIG_TIMEOUT_FOR_LASTVALUES_SYNC_ms - since + 1);
+      if (retry_wait < thing_wait)
+        thing_wait = retry_wait;
+    }
+    if (thing_wait < wait)
+      wait = thing_wait;
+  }
+  return wait;
+}
+#endif
+
+void ArduinoIoTCloudTCP::sendThingPropertiesToCloud(bool const read_only)
+{
+  sendPropertyContainerToCloud(_topics.dataOut(), _thing_property_container, _last_checked_property_index, read_only);
+}
+
+void ArduinoIoTCloudTCP::sendThingBatchToCloud()
+{
+  flushOutboundQueue();
+
+  /* Encode messages until all properties are sent or every free slot is used */
+  for (size_t i = 0; i < MQTT_OUTBOUND_QUEUE_SIZE - 1; i++)
+  {
+    if (!enqueuePropertyContainer(_topics.dataOut(), _thing_property_container, _last_checked_property_index, 0, false))
+      break;
+  }
+
+  flushOutboundQueue();
+}
+
+#ifdef HAS_BURST_FLUSH
+void ArduinoIoTCloudTCP::sendThingBurstToCloud()
+{
+  /* The first message goes out as before, each further one only while the
+   * previous call wrote something and nothing is left pending, i.e. there
+   * are more updates and the connection keeps up with them.
+   */
+  unsigned long const start = millis();
+  size_t const bytes_start = _bytes_written;
+  for (size_t i = 0; i < AIOT_CONFIG_BURST_MSG_CNT; i++)
+  {
+    size_t const bytes_before = _bytes_written;
+    sendThingPropertiesToCloud();
+    if ((_bytes_written == bytes_before) || hasPendingMessages())
+      break;
+    if ((millis() - start) >= AIOT_CONFIG_BURST_TIME_ms)
+      break;
+    if ((_bytes_written - bytes_start) >= AIOT_CONFIG_BURST_BYTES)
+      break;
+    if (!isPublishDue())
+      break;
+  }
+}
+#endif
+
 void ArduinoIoTCloudTCP::sendDevicePropertiesToCloud()
 {
-  PropertyContainer ro_device_property_container;
+  static char const * const ro_device_property_list[] = {"LIB_VERSION", "LIGHT_PAYLOAD_CAP", "OTA_CAP", "OTA_ERROR", "OTA_METRICS", "OTA_PROGRESS", "OTA_SHA256", "PERF", "RULES_ERROR", "WDT_STALL"};
+  uint32_t mask = 0;
+  for (char const * name : ro_device_property_list)
+    mask |= getDevicePropertyMask(name);
+
+  sendDevicePropertyMaskToCloud(mask);
+}
+
+uint32_t ArduinoIoTCloudTCP::getDevicePropertyMask(char const * name)
+{
+  Property * p = getProperty(_device_property_container, name);
+  if ((p == nullptr) || (p->getContainerPosition() >= 32))
+    return 0;
+  return (1UL << p->getContainerPosition());
+}
+
+void ArduinoIoTCloudTCP::sendDevicePropertyMaskToCloud(uint32_t const mask)
+{
+  /* The device property container is never encoded otherwise, therefore its
+   * dirty flags are used to select the properties to be encoded. They are
+   * cleared afterwards so that the polled ones are not picked up next time.
+   */
+  if (mask == 0)
+    return;
+
   unsigned int last_device_property_index = 0;
+  size_t const size = std::min(_device_property_container.size(), static_cast<size_t>(32));
+  for (size_t idx = 0; idx < size; idx++)
+  {
+    if (mask & (1UL << idx))
+      _device_property_container.markDirty(idx);
+    else
+      _device_property_container.clearDirty(idx);
+  }
 
-  std::list<String> ro_device_property_list {"LIB_VERSION", "OTA_CAP", "OTA_ERROR", "OTA_SHA256"};
-  std::for_each(ro_device_property_list.begin(),
-                ro_device_property_list.end(),
-                [this, &ro_device_property_container ] (String const & name)
-                {
-                  Property* p = getProperty(this->_device_property_container, name);
-                  if(p != nullptr)
-                    addPropertyToContainer(ro_device_property_container, *p, p->name(), p->isWriteableByCloud() ? Permission::ReadWrite : Permission::Read);
-                }
-                );
+  sendPropertyContainerToCloud(_topics.deviceOut(), _device_property_container, last_device_property_index);
 
-  sendPropertyContainerToCloud(_deviceTopicOut, ro_device_property_container, last_device_property_index);
+  for (size_t idx = 0; idx < size; idx++)
+    _device_property_container.clearDirty(idx);
 }
 
+#if OTA_ENABLED || defined(HAS_RULES)
+void ArduinoIoTCloudTCP::sendDevicePropertyToCloud(char const * name)
+{
+  sendDevicePropertyMaskToCloud(getDevicePropertyMask(name));
+}
+#endif
+
 #if OTA_ENABLED
-void ArduinoIoTCloudTCP::sendDevicePropertyToCloud(String const name)
+String ArduinoIoTCloudTCP::otaDownloadUrl()
 {
-  PropertyContainer temp_device_property_container;
-  unsigned int last_device_property_index = 0;
+  if (!_get_ota_url)
+    return _ota_url;
+
+  String const url = _get_ota_url(_ota_url);
+  if ((url.length() == 0) || (url == _ota_url))
+    return _ota_url;
 
-  Property* p = getProperty(this->_device_property_container, name);
-  if(p != nullptr)
+  /* The image of a mirror has to be checked against the hash sent by the
+   * cloud before it is applied, or the mirror authenticated via TLS.
+   */
+  URL parsed;
+  bool const is_tls = url_parse(url.c_str(), parsed) && url_equals(parsed.scheme, "https");
+  if (!is_tls && (otaDownloadSHA256().length() == 0))
   {
-    addPropertyToContainer(temp_device_property_container, *p, p->name(), p->isWriteableByCloud() ? Permission::ReadWrite : Permission::Read);
-    sendPropertyContainerToCloud(_deviceTopicOut, temp_device_property_container, last_device_property_index);
+    DEBUG_WARNING("ArduinoIoTCloudTCP::%s %s refused, neither TLS nor a SHA256 to verify the image", __FUNCTION__, url.c_str());
+    return _ota_url;
   }
+  return url;
 }
+
+String ArduinoIoTCloudTCP::otaDownloadSHA256()
+{
+  /* Passed wherever the image can be verified before it is applied */
+  return OTA::isSHA256Verifiable() ? _ota_url_sha256.get(_ota_url) : String("");
+}
+
+void ArduinoIoTCloudTCP::pollImageSHA256()
+{
+#ifdef HAS_STALL_TRACE
+  stall_trace().phase(StallPhase::OTAHash);
 #endif
+#ifdef HAS_PROFILING
+  ProfileScope const profile(_profile.section(ProfileSection::OtaHash));
+#endif
+  String sha256;
+  TaskStatus const status = OTA::pollImageSHA256(sha256);
+  if (status == TaskStatus::InProgress)
+    return;
+
+  /* OTA_SHA256 stays invalid if the image could not be hashed */
+  _is_ota_img_sha256_pending = false;
+  if (status != TaskStatus::Done)
+    return;
 
-void ArduinoIoTCloudTCP::requestLastValue()
+  _ota_img_sha256 = sha256;
+  DEBUG_VERBOSE("SHA256: HASH(%d) = %s", strlen(_ota_img_sha256.c_str()), _ota_img_sha256.c_str());
+
+  /* Sent along with the other device properties unless they are gone already */
+  if ((_state > State::SendDeviceProperties) && (_state != State::Disconnect) && isMqttConnected())
+    sendDevicePropertyToCloud("OTA_SHA256");
+}
+#endif
+
+void ArduinoIoTCloudTCP::requestLastValue(char const * topic)
 {
   // Send the getLastValues CBOR message to the cloud
   // [{0: "r:m", 3: "getLastValues"}] = 81 A2 00 63 72 3A 6D 03 6D 67 65 74 4C 61 73 74 56 61 6C 75 65 73
   // Use http://cbor.me to easily generate CBOR encoding
   const uint8_t CBOR_REQUEST_LAST_VALUE_MSG[] = { 0x81, 0xA2, 0x00, 0x63, 0x72, 0x3A, 0x6D, 0x03, 0x6D, 0x67, 0x65, 0x74, 0x4C, 0x61, 0x73, 0x74, 0x56, 0x61, 0x6C, 0x75, 0x65, 0x73 };
-  write(_shadowTopicOut, CBOR_REQUEST_LAST_VALUE_MSG, sizeof(CBOR_REQUEST_LAST_VALUE_MSG));
+  write(topic, CBOR_REQUEST_LAST_VALUE_MSG, sizeof(CBOR_REQUEST_LAST_VALUE_MSG));
+}
+
+#ifdef HAS_TIMEZONE_REQUEST
+bool ArduinoIoTCloudTCP::requestTimezone(unsigned long const now)
+{
+  bool const is_tz_request_timeout = (now - _tz_request_tick) > AIOT_CONFIG_TIMEOUT_FOR_TIMEZONE_REQUEST_ms;
+  if ((_tz_request_cnt > 0) && !is_tz_request_timeout)
+    return true;
+
+  /* A cloud which does not answer sends the time zone with the last values */
+  if (_tz_request_cnt >= AIOT_CONFIG_TIMEZONE_REQUEST_MAX_RETRY_CNT)
+  {
+    DEBUG_WARNING("ArduinoIoTCloudTCP::%s no time zone received, requesting the last values", __FUNCTION__);
+    _tz_request_cnt = 0;
+    return false;
+  }
+
+  // Send the getTimezone CBOR message to the cloud
+  // [{0: "r:m", 3: "getTimezone"}] = 81 A2 00 63 72 3A 6D 03 6B 67 65 74 54 69 6D 65 7A 6F 6E 65
+  const uint8_t CBOR_REQUEST_TIMEZONE_MSG[] = { 0x81, 0xA2, 0x00, 0x63, 0x72, 0x3A, 0x6D, 0x03, 0x6B, 0x67, 0x65, 0x74, 0x54, 0x69, 0x6D, 0x65, 0x7A, 0x6F, 0x6E, 0x65 };
+  DEBUG_VERBOSE("ArduinoIoTCloudTCP::%s [%d] time zone requested", __FUNCTION__, now);
+  write(_topics.deviceOut(), CBOR_REQUEST_TIMEZONE_MSG, sizeof(CBOR_REQUEST_TIMEZONE_MSG));
+  _tz_request_tick = now;
+  _tz_request_cnt++;
+  return true;
+}
+
+void ArduinoIoTCloudTCP::handleTimezone()
+{
+  _tz_received = false;
+  _tz_request_cnt = 0;
+  updateInternalTimezoneInfo();
+
+  /* The thing properties hold the values of the cloud as well, they are
+   * not sent back as if they had been changed by the sketch.
+   */
+  Property * const tz_offset = _thing_property_container.find("tz_offset");
+  Property * const tz_dst_until = _thing_property_container.find("tz_dst_until");
+  if (tz_offset)
+    tz_offset->fromLocalToCloud();
+  if (tz_dst_until)
+    tz_dst_until->fromLocalToCloud();
+}
+#endif
+
+int ArduinoIoTCloudTCP::write(char const * topic, byte const data[], int const length)
+{
+  AIOTC_TRACE(MqttWrite, length);
+#ifdef HAS_PROFILING
+  ProfileScope const profile(_profile.section(ProfileSection::Send));
+#endif
+  /* Header and payload are sealed into one TLS record */
+  corkTransmission();
+  int const success = publish(topic, data, length);
+  int const sent = (uncorkTransmission() && success) ? 1 : 0;
+#ifdef HAS_BURST_FLUSH
+  if (sent)
+    _bytes_written += length;
+#endif
+#ifdef HAS_DATA_BUDGET
+  if (sent)
+    onDataSent(topic, length);
+#endif
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+  /* Every message keeps the connection alive as well as a ping */
+  if (sent)
+    _keep_alive.onTransmit(millis());
+#endif
+  return sent;
+}
+
+int ArduinoIoTCloudTCP::writeSpilled(char const * topic, byte const data[], int const length, SpilledString const & spill)
+{
+  AIOTC_TRACE(MqttWrite, length);
+  uint8_t header[5];
+  size_t const header_len = CBOREncoder::encodeTextStringHeader(header, spill.length);
+  size_t const offset = static_cast<size_t>(spill.placeholder - data);
+  size_t const tail_len = static_cast<size_t>(length) - offset - 1;
+  size_t const message_len = offset + header_len + spill.length + tail_len;
+
+  /* The placeholder is the empty string encoded as a single byte */
+  corkTransmission();
+  bool success = _mqttClient.beginMessage(topic, message_len, false, AIOT_CONFIG_MQTT_PUBLISH_QOS);
+  success = success && (_mqttClient.write(data, offset) == offset);
+  success = success && (_mqttClient.write(header, header_len) == header_len);
+  success = success && ((spill.length == 0) || (_mqttClient.write(reinterpret_cast<uint8_t const *>(spill.data), spill.length) == spill.length));
+  success = success && (_mqttClient.write(data + offset + 1, tail_len) == tail_len);
+  success = success && _mqttClient.endMessage();
+  int const sent = (uncorkTransmission() && success) ? 1 : 0;
+#ifdef HAS_PERF_COUNTERS
+  if (sent)
+    _perf.onSend(message_len);
+#endif
+#ifdef HAS_BURST_FLUSH
+  if (sent)
+    _bytes_written += message_len;
+#endif
+#ifdef HAS_DATA_BUDGET
+  if (sent)
+    onDataSent(topic, message_len);
+#endif
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+  if (sent)
+    _keep_alive.onTransmit(millis());
+#endif
+  return sent;
 }
 
-int ArduinoIoTCloudTCP::write(String const topic, byte const data[], int const length)
+int ArduinoIoTCloudTCP::publish(char const * topic, byte const data[], int const length)
 {
-  if (_mqttClient.beginMessage(topic, length, false, 0)) {
+#if defined(BOARD_HAS_ECCX08) && (AIOT_CONFIG_MQTT_PUBLISH_QOS == 0)
+  /* The PUBLISH packet is assembled right in the TLS output buffer and sent
+   * as a single record, the queued message is the only other copy of the
+   * payload. MqttClient is only used if the packet exceeds the record.
+   */
+  size_t record_len = 0;
+  unsigned char * record = isMqttConnected() ? _sslClient.appBuffer(record_len) : nullptr;
+  size_t const header_len = (record != nullptr) ? mqtt_publish_header(record, record_len, topic, length) : 0;
+  if (header_len > 0) {
+    memcpy(record + header_len, data, length);
+    if (_sslClient.writeAppBuffer(header_len + length) == 0) {
+      /* As MqttClient does when a write fails */
+      _mqttClient.stop();
+      invalidateMqttConnected();
+      return 0;
+    }
+#ifdef HAS_PERF_COUNTERS
+    _perf.onSend(length);
+#endif
+    return 1;
+  }
+#endif
+
+  if (_mqttClient.beginMessage(topic, length, false, AIOT_CONFIG_MQTT_PUBLISH_QOS)) {
     if (_mqttClient.write(data, length)) {
       if (_mqttClient.endMessage()) {
+#ifdef HAS_PERF_COUNTERS
+        _perf.onSend(length);
+#endif
         return 1;
       }
     }
@@ -732,16 +2672,198 @@ int ArduinoIoTCloudTCP::write(String const topic, byte const data[], int const l
   return 0;
 }
 
+void ArduinoIoTCloudTCP::corkTransmission()
+{
+#if defined(BOARD_HAS_ECCX08)
+  _sslClient.cork();
+#elif defined(HAS_COALESCING_CLIENT)
+  _coalescingClient.cork();
+#endif
+}
+
+bool ArduinoIoTCloudTCP::uncorkTransmission()
+{
+#if defined(BOARD_HAS_ECCX08)
+  int const success = _sslClient.uncork();
+#elif defined(HAS_COALESCING_CLIENT)
+  int const success = _coalescingClient.uncork();
+#else
+  int const success = 1;
+#endif
+  if (!success) {
+    /* As MqttClient does when a write fails */
+    _mqttClient.stop();
+    invalidateMqttConnected();
+    return false;
+  }
+  return true;
+}
+
+#if AIOT_CONFIG_FAST_RESUME_ENABLED
+void ArduinoIoTCloudTCP::saveThingTopics()
+{
+  if (getThingId().length() >= sizeof(_fast_resume.thing_id))
+    return;
+
+  strcpy(_fast_resume.thing_id, getThingId().c_str());
+  _fast_resume.tz_offset = _tz_offset;
+  _fast_resume.tz_dst_until = _tz_dst_until;
+  _fast_resume.magic = FAST_RESUME_MAGIC;
+}
+
+bool ArduinoIoTCloudTCP::resumeThingTopics()
+{
+  if (_fast_resume.magic != FAST_RESUME_MAGIC)
+    return false;
+
+  _fast_resume.thing_id[sizeof(_fast_resume.thing_id) - 1] = '\0';
+  setThingId(String(_fast_resume.thing_id));
+  _tz_offset = _fast_resume.tz_offset;
+  _tz_dst_until = _fast_resume.tz_dst_until;
+  _time_service.setTimeZoneData(_tz_offset, _tz_dst_until);
+  updateThingTopics();
+
+  /* The session is clean, the topics still have to be subscribed. A change
+   * of the thing id is received on the device topic as usual.
+   */
+  if (!_mqttClient.subscribe(_topics.deviceIn()) ||
+      !_mqttClient.subscribe(_topics.dataIn(), AIOT_CONFIG_MQTT_SUBSCRIBE_QOS) ||
+      !_mqttClient.subscribe(_topics.shadowIn(), AIOT_CONFIG_MQTT_SUBSCRIBE_QOS))
+  {
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s could not resume thing topics", __FUNCTION__);
+    return false;
+  }
+
+  DEBUG_INFO("Connected to Arduino IoT Cloud");
+  DEBUG_INFO("Thing ID: %s", getThingId().c_str());
+  execCloudEventCallback(ArduinoIoTCloudEvent::CONNECT);
+  _deviceSubscribedToThing = true;
+  return true;
+}
+#endif
+
+void ArduinoIoTCloudTCP::unsubscribeRetiredThingTopics()
+{
+  _mqttClient.unsubscribe(_topics.retiredShadowIn());
+  _mqttClient.unsubscribe(_topics.retiredDataIn());
+  _topics.clearRetiredThing();
+}
+
 void ArduinoIoTCloudTCP::updateThingTopics()
 {
-  _shadowTopicOut = getTopic_shadowout();
-  _shadowTopicIn  = getTopic_shadowin();
-  _dataTopicOut   = getTopic_dataout();
-  _dataTopicIn    = getTopic_datain();
+  if (!_topics.setThingId(getThingId()))
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s thing id too long for the topics", __FUNCTION__);
+  _topicRouter.add(static_cast<uint8_t>(InboundTopic::Shadow), _topics.shadowIn());
+  _topicRouter.add(static_cast<uint8_t>(InboundTopic::Data), _topics.dataIn());
+#ifdef HAS_LOCAL_MIRROR
+  /* Only the peers of the same thing are mirrored to and from */
+  _mirror.setThing(getThingId().c_str(), mirrorEpoch());
+#endif
 
   clrThingIdOutdatedFlag();
 }
 
+#ifdef HAS_CLOUD_THREAD
+void ArduinoIoTCloudTCP::threadEntry(void * arg)
+{
+  reinterpret_cast<ArduinoIoTCloudTCP *>(arg)->threadLoop();
+}
+
+void ArduinoIoTCloudTCP::threadLoop()
+{
+  for (;;)
+  {
+    lock();
+    update();
+    unsigned long wait = nextUpdateIn();
+    unlock();
+
+    /* Incoming messages can not be signalled by the MQTT client, so it is
+     * polled at least every AIOT_CONFIG_CLOUD_THREAD_POLL_INTERVAL_ms unless
+     * notifyDataReady() wakes the thread. The minimum of 1 ms lets the
+     * sketch run while there is work pending.
+     */
+    unsigned long const poll_interval = _is_data_ready_signalled ? AIOT_CONFIG_MQTT_IDLE_POLL_INTERVAL_ms : AIOT_CONFIG_CLOUD_THREAD_POLL_INTERVAL_ms;
+    if (wait > poll_interval)
+      wait = poll_interval;
+    if (wait == 0)
+      wait = 1;
+    _thread.wait(wait);
+  }
+}
+
+bool ArduinoIoTCloudTCP::deferPropertyCallback(Property & property, bool const is_sync)
+{
+  if (!isCallbackDeferrable(property))
+    return false;
+
+  DeferredCallback callback;
+  callback.type = is_sync ? DeferredCallbackType::OnSync : DeferredCallbackType::OnChange;
+  callback.event = ArduinoIoTCloudEvent::SYNC;
+  callback.property = &property;
+  return ArduinoCloud.deferCallback(callback);
+}
+
+bool ArduinoIoTCloudTCP::deferCallback(DeferredCallback const & callback)
+{
+  if (_deferred_callbacks.push(callback))
+    return true;
+
+  /* Running it now is racy, dropping it silently would hide a lost update */
+  DEBUG_WARNING("ArduinoIoTCloudTCP::%s callback queue full, callback dropped", __FUNCTION__);
+  return true;
+}
+
+void ArduinoIoTCloudTCP::execCloudEventCallback(ArduinoIoTCloudEvent const event)
+{
+  if (!_thread.isRunning())
+  {
+    ArduinoIoTCloudClass::execCloudEventCallback(event);
+    return;
+  }
+
+  DeferredCallback callback;
+  callback.type = DeferredCallbackType::CloudEvent;
+  callback.event = event;
+  callback.property = nullptr;
+  deferCallback(callback);
+}
+#endif
+
+#if defined(HAS_CLOUD_THREAD) || defined(HAS_DEFERRED_CALLBACKS)
+bool ArduinoIoTCloudTCP::isCallbackDeferrable(Property & property)
+{
+  /* The callbacks of the library itself are run right away, the time zone
+   * is needed to complete the synchronisation.
+   */
+  if (ArduinoCloud._thing_property_container.find(property.c_name()) != &property)
+    return false;
+  if (property.isPrimitive())
+  {
+    void const * const primitive = reinterpret_cast<CloudWrapperBase &>(property).primitive();
+    if ((primitive == &ArduinoCloud._tz_offset) || (primitive == &ArduinoCloud._tz_dst_until))
+      return false;
+  }
+  return true;
+}
+#endif
+
+#ifdef HAS_PERF_COUNTERS
+void ArduinoIoTCloudTCP::onCommandLatency(unsigned long const cloud_to_device_ms, unsigned long const callback_us)
+{
+  ArduinoCloud._perf.onCommand(cloud_to_device_ms, callback_us);
+}
+#endif
+
+#ifdef HAS_DEFERRED_CALLBACKS
+bool ArduinoIoTCloudTCP::queuePropertyCallback(Property & property, bool const is_sync)
+{
+  if (!isCallbackDeferrable(property))
+    return false;
+  return ArduinoCloud._callback_queue.push(property, is_sync);
+}
+#endif
+
 /******************************************************************************
  * EXTERN DEFINITION
  ******************************************************************************/
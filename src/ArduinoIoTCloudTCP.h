@@ -43,6 +43,84 @@
 
 #include <ArduinoMqttClient.h>
 
+#include "utility/mqtt/MqttTopics.h"
+#include "utility/mqtt/TopicRouter.h"
+#include "utility/net/BrokerEndpoints.h"
+
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+  #include "utility/mqtt/AdaptiveKeepAlive.h"
+#endif
+
+#ifdef HAS_MQTT_DEDUP
+  #include "utility/mqtt/MessageDedup.h"
+#endif
+
+#ifdef HAS_TRANSMIT_WINDOW
+  #include "utility/net/TransmitWindow.h"
+#endif
+
+#ifdef HAS_RATE_CONTROL
+  #include "utility/net/PublishRateControl.h"
+#endif
+
+#ifdef HAS_DATA_BUDGET
+  #include "utility/net/DataBudget.h"
+#endif
+
+#ifdef HAS_COALESCING_CLIENT
+  #include "utility/net/CoalescingClient.h"
+#endif
+
+#ifdef HAS_GATEWAY
+  #include "utility/gateway/CloudThing.h"
+#endif
+
+#ifdef HAS_LOCAL_MIRROR
+  #include <Udp.h>
+  #include "utility/net/LocalMirror.h"
+#endif
+
+#ifdef HAS_MESSAGE_FANOUT
+  #include "utility/net/MessageFanout.h"
+#endif
+
+#if OTA_ENABLED
+  #include "utility/ota/OTAUrlSHA256.h"
+#endif
+
+#ifdef HAS_RULES
+  #include "utility/rules/RuleEngine.h"
+#endif
+
+#ifdef HAS_DEFERRED_CALLBACKS
+  #include "utility/task/CallbackQueue.h"
+#endif
+
+#ifdef HAS_PROPERTY_CACHE
+  #include "utility/storage/PropertyCacheStorage.h"
+#endif
+
+#ifdef HAS_CLOUD_THREAD
+  #include "utility/thread/CloudThread.h"
+  #include "utility/thread/SpscQueue.h"
+#endif
+
+#ifdef HAS_CORE_LINK
+  #include "utility/thread/CoreLink.h"
+#endif
+
+#ifdef HAS_PROFILING
+  #include "utility/profile/UpdateProfile.h"
+#endif
+
+#ifdef HAS_PERF_COUNTERS
+  #include "utility/profile/PerfCounters.h"
+#endif
+
+#ifdef HAS_TRACE_CAPTURE
+  #include "utility/trace/TraceCapture.h"
+#endif
+
 /******************************************************************************
    CONSTANTS
  ******************************************************************************/
@@ -56,7 +134,16 @@ static uint16_t const DEFAULT_BROKER_PORT_USER_PASS_AUTH = 8884;
  * TYPEDEF
  ******************************************************************************/
 
+/* How the TLS session of a connection to the broker has been set up */
+enum class TlsHandshake : uint8_t
+{
+  None,    /* Not connected yet */
+  Full,
+  Resumed, /* The session of the previous connection */
+};
+
 typedef bool (*onOTARequestCallbackFunc)(void);
+typedef String (*onOTAUrlCallbackFunc)(String const & url);
 
 /******************************************************************************
  * CLASS DECLARATION
@@ -73,6 +160,7 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
     virtual void update        () override;
     virtual int  connected     () override;
     virtual void printDebugInfo() override;
+    virtual unsigned long nextUpdateIn() override;
 
     #if defined(BOARD_HAS_ECCX08) || defined(BOARD_HAS_OFFLOADED_ECCX08) || defined(BOARD_HAS_SE050)
     int begin(ConnectionHandler & connection, bool const enable_watchdog = true, String brokerAddress = DEFAULT_BROKER_ADDRESS_SECURE_AUTH, uint16_t brokerPort = DEFAULT_BROKER_PORT_SECURE_AUTH);
@@ -84,11 +172,150 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
     #ifdef BOARD_ESP
     inline void setBoardId        (String const device_id) { setDeviceId(device_id); }
     inline void setSecretDeviceKey(String const password)  { _password = password;  }
+    /* Verifies the broker against the given PEM root certificate instead of
+     * connecting without verification. To be called before begin(), the
+     * certificate is not copied and has to outlive the cloud connection.
+     * The asynchronous ESP32 OTA download trusts it as well.
+     */
+    inline void setCACert         (char const * ca_cert)   { _ca_cert = ca_cert;    }
     #endif
 
+    /* To be called when the network client has received data, e.g. from the
+     * NINA IRQ, an lwIP receive callback or once select() returns on ESP32.
+     * From the first call on update() only polls the MQTT client when
+     * signalled, while connecting and at least every
+     * AIOT_CONFIG_MQTT_IDLE_POLL_INTERVAL_ms for the pings and missed
+     * signals. May be called from an interrupt, unless the cloud thread
+     * runs on ESP32, where it has to be called from a task.
+     */
+    void notifyDataReady();
+
+#ifdef HAS_CLOUD_THREAD
+    /* Runs update() in a thread of its own after begin(). The properties may
+     * then only be accessed between lock() and unlock(), the callbacks are
+     * run from the sketch via dispatch() which update() calls as well, so
+     * that an unchanged sketch keeps working.
+     */
+    bool startThread();
+    void dispatch();
+    /* Wakes the cloud thread, e.g. to send a changed property right away */
+    inline void wake  () { _thread.wake(); }
+    inline void lock  () { _thread.lock(); }
+    inline void unlock() { _thread.unlock(); }
+#endif
+
+#ifdef HAS_CORE_LINK
+    /* Runs the thing on this core, in place of the other begin(), while the
+     * other core runs the connection with setCoreLink(). update() then
+     * decodes the messages passed on by the other core and encodes the
+     * changed properties for it, it does not connect on its own.
+     */
+    int begin(CoreLink & link);
+    /* Passes the messages of the thing on to the core which has begun with
+     * the link, only the properties added on this core, e.g. the time zone,
+     * are decoded here as well. To be called before begin().
+     */
+    inline void setCoreLink(CoreLink & link) { _core_link = &link; }
+#endif
+
+#ifdef HAS_PROFILING
+    /* Durations of update() per state, see UpdateProfile */
+    inline UpdateProfile const & getProfile() const { return _profile; }
+    inline void resetProfile() { _profile.reset(); }
+    /* Name of a state as indexed by UpdateProfile::state() */
+    static char const * getStateName(uint8_t const state);
+#endif
+
+    /* Only the BearSSL client of the ECCX08 boards resumes the previous
+     * session. The TLS offloaded to the NINA firmware or the SE050 client
+     * does not expose its session, those handshakes are reported as full.
+     */
+    inline TlsHandshake lastTlsHandshake() const { return _tls_handshake; }
+
     inline String   getBrokerAddress() const { return _brokerAddress; }
     inline uint16_t getBrokerPort   () const { return _brokerPort; }
 
+    /* Alternative endpoints of the broker, e.g. another port or point of
+     * presence. Once a connection attempt fails the next one is tried right
+     * away, the reconnection delay only applies once all of them failed.
+     */
+    inline bool addBrokerEndpoint(String const brokerAddress, uint16_t const brokerPort) { return _brokerEndpoints.add(brokerAddress, brokerPort); }
+#ifdef HAS_GATEWAY
+    /* Adds the thing of a sub-device, which is then synchronised over the
+     * connection of the board once its own thing is. Returns false if
+     * AIOT_CONFIG_GATEWAY_THING_CNT things have been added already.
+     */
+    bool addThing(CloudThing & thing);
+#endif
+
+#ifdef HAS_LOCAL_MIRROR
+    /* Mirrors the updates of the thing properties to the peers in the
+     * multicast group, and applies theirs to the properties of the same
+     * name, on a UDP socket of its own, e.g. a WiFiUDP other than the one
+     * of the connection handler. To be called after begin(). Only the
+     * frames of peers attached to the same thing and authenticated with the
+     * same key, 16 to 64 secret bytes provisioned for the thing, are applied.
+     * A peer is synchronized by a handshake when first heard, its first
+     * update is only applied from the cloud.
+     */
+    bool beginLocalMirror(UDP & udp, uint8_t const * key, size_t const key_len, IPAddress const group = IPAddress(239, 255, 22, 88), uint16_t const port = AIOT_CONFIG_LOCAL_MIRROR_PORT);
+#endif
+
+#ifdef HAS_MESSAGE_FANOUT
+    /* Offers each update of the thing properties, as encoded for the cloud,
+     * to the sink as well, e.g. a log in flash. A sink which does not take
+     * a message is offered it again until it leaves the outbound queue.
+     * Returns false if AIOT_CONFIG_MESSAGE_SINK_CNT sinks have been added.
+     */
+    inline bool addMessageSink(MessageSink & sink) { return _fanout.add(sink); }
+#endif
+
+#ifdef HAS_PROPERTY_CACHE
+    /* Restores the values of the writeable thing properties stored before
+     * the restart in begin() and stores them whenever they change, e.g. in
+     * a KVStorePropertyCacheStorage. To be called before begin().
+     */
+    inline void setPropertyCache(PropertyCacheStorage & storage) { _property_cache.begin(storage); }
+#endif
+
+    #ifdef BOARD_HAS_ECCX08
+    /* Resolves the broker address ahead of connecting and caches it for
+     * ttl_ms, e.g. with WiFi.hostByName(). Not needing to look the name up
+     * again saves a round trip to each reconnect.
+     */
+    inline void setBrokerResolver(BrokerEndpoints::Resolver resolver, unsigned long const ttl_ms = AIOT_CONFIG_BROKER_ADDRESS_TTL_ms) { _brokerEndpoints.setResolver(resolver, ttl_ms); }
+    #endif
+
+    #ifdef HAS_TRANSMIT_WINDOW
+    /* Holds the thing updates back until the next window of window_ms opens,
+     * one every cycle_ms starting now, e.g. the paging time window and the
+     * eDRX cycle the network granted the modem. The pings are sent in the
+     * last window before they fall due. A cycle of 0 sends at any time.
+     */
+    void setTransmitWindow(unsigned long const cycle_ms, unsigned long const window_ms);
+    /* 0 while the window is open, e.g. to take a measurement just before */
+    inline unsigned long nextTransmitWindowIn() { return _transmit_window.nextOpenIn(millis()); }
+    #endif
+
+    #ifdef HAS_RATE_CONTROL
+    /* The signal strength in dBm, e.g. WiFi.RSSI(), to be reported as it
+     * changes. The connection handlers do not tell.
+     */
+    inline void setSignalStrength(int const dbm) { _rate_control.onSignalStrength(dbm); }
+    /* How long the thing updates are currently held after each message */
+    inline unsigned long publishHoldTime() const { return _rate_control.hold(); }
+    #endif
+
+    #ifdef HAS_DATA_BUDGET
+    /* Sends at most 'bytes' of MQTT payload and topics per window_ms, e.g.
+     * 2048 bytes per minute on a SIM with a small data plan. The thing
+     * updates are held back and coalesced to stay within it, the budget has
+     * to allow for the largest of them. A window of 0 lifts the limit.
+     */
+    inline void setDataBudget(size_t const bytes, unsigned long const window_ms) { _data_budget.begin(bytes, window_ms, millis()); }
+    inline size_t dataBudgetAvailable() const { return _data_budget.available(millis()); }
+    #endif
+
 #if OTA_ENABLED
     /* The callback is triggered when the OTA is initiated and it gets executed until _ota_req flag is cleared.
      * It should return true when the OTA can be applied or false otherwise.
@@ -98,10 +325,78 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
       _get_ota_confirmation = cb;
       _ask_user_before_executing_ota = true;
     }
+    /* The callback maps the url of a requested image to the one it is
+     * downloaded from, e.g. a cache on the local network which fetches each
+     * image from the cloud once for all the devices of a site. A cache which
+     * is not reached via TLS is only used if the board verifies the image
+     * against the OTA_URL_SHA256 sent by the cloud before applying it, the
+     * image is downloaded from the cloud otherwise.
+     */
+    inline void onOTAUrlCb(onOTAUrlCallbackFunc cb) { _get_ota_url = cb; }
+    inline void setOtaUrlReceivedFlag() { _ota_url_received = true; }
+#endif
+#ifdef HAS_RULES
+    inline void setRulesReceivedFlag() { _rules_received = true; }
+#endif
+#ifdef HAS_TRACE_CAPTURE
+    inline void setTraceRequestedFlag() { _trace_req_received = true; }
+#endif
+#ifdef HAS_TIMEZONE_REQUEST
+    inline void setTimezoneReceivedFlag() { _tz_received = true; }
 #endif
 
   private:
-    static const int MQTT_TRANSMIT_BUFFER_SIZE = 256;
+    static const int MQTT_TRANSMIT_BUFFER_SIZE = AIOT_CONFIG_MQTT_TRANSMIT_BUFFER_SIZE;
+    static const size_t MQTT_OUTBOUND_QUEUE_SIZE = AIOT_CONFIG_MQTT_OUTBOUND_QUEUE_SIZE;
+
+    enum class OutboundMessageState
+    {
+      Pending,  /* Not yet handed over to the MQTT client */
+      InFlight, /* Sent, replayed if the connection is lost */
+    };
+
+    struct OutboundMessage
+    {
+      OutboundMessageState state;
+      char const * topic;
+      /* A lost update of the thing is not replayed, its properties are
+       * sent again with their current values, see provideEcho().
+       */
+      bool is_echoed_on_replay;
+      uint32_t properties[PropertyContainer::BITMAP_SIZE];
+#ifdef HAS_MESSAGE_FANOUT
+      /* The sinks which have not taken the message yet */
+      MessageFanout::SinkMask sinks;
+      bool is_timestamped;
+#endif
+      int length;
+      uint8_t data[MQTT_TRANSMIT_BUFFER_SIZE];
+    };
+
+#ifdef HAS_CLOUD_THREAD
+    enum class DeferredCallbackType : uint8_t
+    {
+      OnChange,
+      OnSync,
+      CloudEvent,
+    };
+
+    struct DeferredCallback
+    {
+      DeferredCallbackType type;
+      ArduinoIoTCloudEvent event;
+      Property * property;
+    };
+#endif
+
+    /* Identifiers of the subscribed topics within _topicRouter */
+    enum class InboundTopic : uint8_t
+    {
+      None = TopicRouter::NONE,
+      Device,
+      Shadow,
+      Data
+    };
 
     enum class State
     {
@@ -127,15 +422,39 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
     unsigned int _last_device_attach_cnt;
     unsigned long _last_sync_request_tick;
     unsigned int _last_sync_request_cnt;
+#ifdef HAS_TIMEZONE_REQUEST
+    /* The time zone information requested on the device topic once expired */
+    unsigned long _tz_request_tick;
+    unsigned int _tz_request_cnt;
+    bool _tz_received;
+#endif
     unsigned long _last_subscribe_request_tick;
     unsigned int  _last_subscribe_request_cnt;
+    bool _last_values_received;
     String _brokerAddress;
     uint16_t _brokerPort;
-    uint8_t _mqtt_data_buf[MQTT_TRANSMIT_BUFFER_SIZE];
-    int _mqtt_data_len;
-    bool _mqtt_data_request_retransmit;
+    BrokerEndpoints _brokerEndpoints;
+    /* Ring of outgoing messages, ordered from the oldest one at the head.
+     * Messages are encoded directly into the free slot behind the tail.
+     */
+    OutboundMessage _outbound_queue[MQTT_OUTBOUND_QUEUE_SIZE];
+    size_t _outbound_queue_head;
+    size_t _outbound_queue_count;
+    bool _has_been_connected;
+    bool _is_mqtt_connected_valid;
+    bool _is_mqtt_connected;
+    TlsHandshake _tls_handshake;
+    volatile bool _is_data_ready;
+    volatile bool _is_data_ready_signalled;
+    unsigned long _last_mqtt_poll_tick;
+
+    #ifdef HAS_DEFERRED_CERT
+    bool _is_cert_pending;
+    #endif
 
     #if defined(BOARD_HAS_ECCX08)
+    bool _tls_handshake_started;
+    unsigned long _tls_handshake_tick;
     ArduinoIoTCloudCertClass _cert;
     BearSSLClient _sslClient;
     CryptoUtil _crypto;
@@ -146,39 +465,162 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
     #elif defined(BOARD_ESP)
     WiFiClientSecure _sslClient;
     String _password;
+    char const * _ca_cert;
+    #if defined(ARDUINO_ARCH_ESP8266)
+    BearSSL::X509List _ca_list;
+    BearSSL::Session _tls_session;
+    #endif
     #elif defined(BOARD_HAS_SE050)
     ArduinoIoTCloudCertClass _cert;
     WiFiSSLSE050Client _sslClient;
     CryptoUtil _crypto;
     #endif
 
+    #ifdef HAS_COALESCING_CLIENT
+    uint8_t _coalescing_buf[AIOT_CONFIG_MQTT_COALESCE_BUFFER_SIZE];
+    CoalescingClient _coalescingClient;
+    #endif
+
     MqttClient _mqttClient;
+    #ifdef HAS_ADAPTIVE_KEEP_ALIVE
+    AdaptiveKeepAlive _keep_alive;
+    #endif
+    #ifdef HAS_TRANSMIT_WINDOW
+    TransmitWindow _transmit_window;
+    /* Since when the network is reported down between the windows */
+    bool _is_link_suspended;
+    unsigned long _link_suspended_tick;
+    #endif
+    #ifdef HAS_RATE_CONTROL
+    PublishRateControl _rate_control;
+    #endif
+    #ifdef HAS_DATA_BUDGET
+    DataBudget _data_budget;
+    #endif
 
-    String _deviceTopicOut;
-    String _deviceTopicIn;
-    String _shadowTopicOut;
-    String _shadowTopicIn;
-    String _dataTopicOut;
-    String _dataTopicIn;
+    MqttTopics _topics;
+    TopicRouter _topicRouter;
+#ifdef HAS_MQTT_DEDUP
+    MessageDedup _dedup;
+#endif
+#ifdef HAS_GATEWAY
+    CloudThing * _gateway_things[AIOT_CONFIG_GATEWAY_THING_CNT];
+    size_t _gateway_thing_cnt;
+#endif
+#ifdef HAS_LOCAL_MIRROR
+    UDP * _mirror_udp;
+    IPAddress _mirror_group;
+    uint16_t _mirror_port;
+    LocalMirror _mirror;
+    uint8_t _mirror_buf[LocalMirror::HEADER_SIZE + MQTT_TRANSMIT_BUFFER_SIZE + LocalMirror::TAG_SIZE];
+
+    class MirrorSink : public MessageSink
+    {
+    public:
+      MirrorSink(ArduinoIoTCloudTCP & cloud) : _cloud(cloud) { }
+      /* Peers are sent the live values only, best effort */
+      virtual bool deliver(uint8_t const * data, size_t const length, bool const is_timestamped) override {
+        if (!is_timestamped)
+          _cloud.mirrorToPeers(data, length);
+        return true;
+      }
+    private:
+      ArduinoIoTCloudTCP & _cloud;
+    };
+    MirrorSink _mirror_sink;
+#endif
+#ifdef HAS_MESSAGE_FANOUT
+    MessageFanout _fanout;
+#endif
+#ifdef HAS_DEFERRED_CALLBACKS
+    CallbackQueue _callback_queue;
+#endif
+#ifdef HAS_CORE_LINK
+    CoreLink * _core_link;
+    /* On the application side as reported by the network side, on the
+     * network side as last reported to the application side.
+     */
+    bool _is_core_link_connected;
+    /* The last values have been received since connecting */
+    bool _is_core_link_synced;
+#endif
+#ifdef HAS_PROPERTY_CACHE
+    PropertyCache _property_cache;
+#endif
+#ifdef HAS_RULES
+    /* The program written by the cloud into the device property RULES */
+    RuleEngine _rules;
+    uint8_t _rules_buf[AIOT_CONFIG_RULES_PROGRAM_SIZE];
+    CloudBinary * _rules_program;
+    int _rules_error;
+    bool _rules_received;
+#endif
 
     bool _deviceSubscribedToThing;
+    /* The light payload is advertised through the device topic and
+     * enabled by the cloud writing the LIGHT_PAYLOAD device property.
+     */
+    bool _light_payload_cap;
+    bool _light_payload;
 
 #if OTA_ENABLED
     bool _ota_cap;
     int _ota_error;
+    int _ota_progress;
+    String _ota_metrics;
     String _ota_img_sha256;
+    /* The running image is hashed in slices from update() */
+    bool _is_ota_img_sha256_pending;
     String _ota_url;
+    /* The SHA256 of the application held by the image at OTA_URL */
+    OTAUrlSHA256 _ota_url_sha256;
+    bool _ota_url_received;
     bool _ota_req;
     bool _ask_user_before_executing_ota;
     onOTARequestCallbackFunc _get_ota_confirmation;
+    onOTAUrlCallbackFunc _get_ota_url;
+#ifdef HAS_OTA_PREFETCH
+    /* The url last prefetched, each image is only tried once */
+    String _ota_prefetch_url;
+#endif
 #endif /* OTA_ENABLED */
 
-    inline String getTopic_deviceout() { return String("/a/d/" + getDeviceId() + "/e/o");}
-    inline String getTopic_devicein () { return String("/a/d/" + getDeviceId() + "/e/i");}
-    inline String getTopic_shadowout() { return ( getThingId().length() == 0) ? String("") : String("/a/t/" + getThingId() + "/shadow/o"); }
-    inline String getTopic_shadowin () { return ( getThingId().length() == 0) ? String("") : String("/a/t/" + getThingId() + "/shadow/i"); }
-    inline String getTopic_dataout  () { return ( getThingId().length() == 0) ? String("") : String("/a/t/" + getThingId() + "/e/o"); }
-    inline String getTopic_datain   () { return ( getThingId().length() == 0) ? String("") : String("/a/t/" + getThingId() + "/e/i"); }
+#ifdef HAS_STALL_TRACE
+    /* Report of the stall which led to the last watchdog reset */
+    String _wdt_stall;
+#endif
+
+#ifdef HAS_PROFILING
+    UpdateProfile _profile;
+#endif
+
+#ifdef HAS_BURST_FLUSH
+    /* Bytes written to the MQTT client, tell the size of a burst */
+    size_t _bytes_written;
+#endif
+
+#ifdef HAS_PERF_COUNTERS
+    PerfCounters _perf;
+    /* Value of the device property PERF, refreshed when it is sent */
+    String _perf_report;
+    unsigned long _perf_report_tick;
+#endif
+
+#ifdef HAS_TRACE_CAPTURE
+    /* Seconds to capture, written by the cloud into the device property TRACE_REQ */
+    int _trace_req_s;
+    bool _trace_req_received;
+    TraceCapture _trace_capture;
+    /* Value of the device property TRACE, the chunk sent last */
+    uint8_t _trace_chunk_buf[AIOT_CONFIG_TRACE_CAPTURE_CHUNK_SIZE];
+    CloudBinary * _trace_chunk;
+    unsigned long _trace_chunk_tick;
+#endif
+
+#if defined(BOARD_HAS_ECCX08) || defined(BOARD_HAS_SE050)
+    /* Reconstructs the device certificate and hands it to the TLS client */
+    bool loadCert();
+#endif
 
     State handle_ConnectPhy();
     State handle_SyncTime();
@@ -194,17 +636,125 @@ class ArduinoIoTCloudTCP: public ArduinoIoTCloudClass
 
     static void onMessage(int length);
     void handleMessage(int length);
-    void sendPropertyContainerToCloud(String const topic, PropertyContainer & property_container, unsigned int & current_property_index);
-    void sendThingPropertiesToCloud();
+    void handleLastValues();
+    void sendPropertyContainerToCloud(char const * topic, PropertyContainer & property_container, unsigned int & current_property_index, bool const read_only = false);
+    void sendThingPropertiesToCloud(bool const read_only = false);
+    void sendThingBatchToCloud();
+#ifdef HAS_BURST_FLUSH
+    /* Sends as many messages of thing updates as the burst budget allows */
+    void sendThingBurstToCloud();
+#endif
     void sendDevicePropertiesToCloud();
-    void requestLastValue();
-    int write(String const topic, byte const data[], int const length);
+    /* Bit i selects the property at position i of the device property container */
+    uint32_t getDevicePropertyMask(char const * name);
+    void sendDevicePropertyMaskToCloud(uint32_t const mask);
+    void requestLastValue(char const * topic);
+#ifdef HAS_TIMEZONE_REQUEST
+    /* Requests the expired time zone information, returns false once the
+     * retries are used up and the last values have to be requested instead.
+     */
+    bool requestTimezone(unsigned long const now);
+    void handleTimezone();
+#endif
+    int write(char const * topic, byte const data[], int const length);
+    /* Sends the message with the spilled string streamed in place of its placeholder */
+    int writeSpilled(char const * topic, byte const data[], int const length, SpilledString const & spill);
+    int publish(char const * topic, byte const data[], int const length);
+    /* Packets written in between leave with as few TLS records as possible */
+    void corkTransmission();
+    bool uncorkTransmission();
+    bool enqueuePropertyContainer(char const * topic, PropertyContainer & property_container, unsigned int & current_property_index, unsigned long const timestamp, bool const drop_pending, bool const read_only = false);
+    void flushOutboundQueue();
+    void replayOutboundQueue();
+    /* Messages in the outbound queue not yet handed over to the MQTT client */
+    bool hasPendingMessages() const;
+    bool isMqttConnected();
+    bool isMqttPollDue();
+    bool isLinkUp();
+    bool isTransmitWindowOpen();
+    bool isPublishDue();
+#ifdef HAS_DATA_BUDGET
+    /* What is left of the budget once the pending messages have been sent */
+    size_t dataBudgetLeft(unsigned long const now);
+    void onDataSent(char const * topic, size_t const length);
+#endif
+#ifdef HAS_ADAPTIVE_KEEP_ALIVE
+    bool isPingDue(unsigned long const now);
+#endif
+    inline void invalidateMqttConnected() { _is_mqtt_connected_valid = false; }
+#if AIOT_CONFIG_OFFLINE_SAMPLES_ENABLED
+    void recordOfflineSamples();
+#endif
+#ifdef HAS_MESSAGE_FANOUT
+    void retryMessageSinks();
+#endif
+#ifdef HAS_LOCAL_MIRROR
+    void mirrorToPeers(byte const data[], int const length);
+    void receiveFromPeers();
+    uint32_t mirrorEpoch();
+#endif
+#ifdef HAS_CORE_LINK
+    inline bool isCoreLinkApplication() const { return (_core_link != nullptr) && (_core_link->side() == CoreLink::Side::Application); }
+    inline bool isCoreLinkNetwork    () const { return (_core_link != nullptr) && (_core_link->side() == CoreLink::Side::Network); }
+    void updateCoreLink();
+    void relayCoreLink();
+    bool forwardToCoreLink(CoreLink::Kind const kind, int & length);
+    /* Queues a message encoded on the application side as it is */
+    bool enqueueMessage(char const * topic, byte const data[], int const length);
+#endif
+#if defined(HAS_CLOUD_THREAD) || defined(HAS_DEFERRED_CALLBACKS)
+    /* The callbacks of the library itself are never deferred */
+    static bool isCallbackDeferrable(Property & property);
+#endif
+#ifdef HAS_PERF_COUNTERS
+    static void onCommandLatency(unsigned long const cloud_to_device_ms, unsigned long const callback_us);
+#endif
+#ifdef HAS_DEFERRED_CALLBACKS
+    static bool queuePropertyCallback(Property & property, bool const is_sync);
+    inline bool callbacksPending() const { return !_callback_queue.empty(); }
+#else
+    inline bool callbacksPending() const { return false; }
+#endif
+#ifdef HAS_RULES
+    void evaluateRules();
+#endif
+#ifdef HAS_TRACE_CAPTURE
+    void updateTraceCapture();
+#endif
+#ifdef HAS_GATEWAY
+    void resetGatewayThings();
+    void updateGatewayThings();
+    CloudThing * matchGatewayThing(String const & topic, CloudThing::Topic & inbound);
+    unsigned long gatewayNextUpdateIn(unsigned long const now);
+#endif
 
+#if OTA_ENABLED || defined(HAS_RULES)
+    void sendDevicePropertyToCloud(char const * name);
+#endif
 #if OTA_ENABLED
-    void sendDevicePropertyToCloud(String const name);
+    void pollImageSHA256();
+    String otaDownloadUrl();
+    String otaDownloadSHA256();
+#endif
+
+#if AIOT_CONFIG_FAST_RESUME_ENABLED
+    void saveThingTopics();
+    bool resumeThingTopics();
 #endif
 
     void updateThingTopics();
+    void unsubscribeRetiredThingTopics();
+
+#ifdef HAS_CLOUD_THREAD
+    CloudThread _thread;
+    SpscQueue<DeferredCallback, AIOT_CONFIG_CLOUD_THREAD_CALLBACK_QUEUE_SIZE> _deferred_callbacks;
+
+    static void threadEntry(void * arg);
+    void threadLoop();
+    static bool deferPropertyCallback(Property & property, bool const is_sync);
+    bool deferCallback(DeferredCallback const & callback);
+    virtual void execCloudEventCallback(ArduinoIoTCloudEvent const event) override;
+#endif
 };
 
 /******************************************************************************
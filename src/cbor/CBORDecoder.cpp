@@ -24,348 +24,673 @@
 #undef max
 #undef min
 #include <algorithm>
+#include <climits>
 
 #include "CBORDecoder.h"
+#include "../utility/trace/Trace.h"
 
 /******************************************************************************
-   PUBLIC MEMBER FUNCTIONS
+   CTOR/DTOR
  ******************************************************************************/
 
-void CBORDecoder::decode(PropertyContainer & property_container, uint8_t const * const payload, size_t const length, bool isSyncMessage)
+CBORDecoder::CBORDecoder(PropertyContainer & property_container, bool const is_sync_message, bool const is_peer_message)
+: _property_container{property_container}
+, _is_sync_message{is_sync_message}
+, _is_peer_message{is_peer_message}
+, _state{DecoderState::EnterArray}
+, _buffer{nullptr}
+, _buffer_size{0}
+, _data{nullptr}
+, _length{0}
+, _record_offset{0}
+, _group_offset{0}
+, _remaining_records{0}
+, _is_indefinite_array{false}
+, _skip_items{0}
+, _skip_bytes{0}
+, _current_property{nullptr}
+, _current_property_base_time{0}
+, _current_property_time{0}
 {
-  CborValue array_iter, map_iter,value_iter;
-  CborParser parser;
-  CborMapData map_data;
-  std::list<CborMapData> map_data_list; /* List of map data that will hold all the attributes of a property */
-  String current_property_name; /* Current property name during decoding: use to look for a new property in the senml value array */
-  unsigned long current_property_base_time{0}, current_property_time{0};
-
-  if (cbor_parser_init(payload, length, 0, &parser, &array_iter) != CborNoError)
-    return;
 
-  if (array_iter.type != CborArrayType)
-    return;
+}
 
-  if (cbor_value_enter_container(&array_iter, &map_iter) != CborNoError)
-    return;
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
 
-  MapParserState current_state = MapParserState::EnterMap,
-                 next_state = MapParserState::Error;
-
-  while (current_state != MapParserState::Complete) {
-
-    switch (current_state) {
-      case MapParserState::EnterMap     : next_state = handle_EnterMap(&map_iter, &value_iter); break;
-      case MapParserState::MapKey       : next_state = handle_MapKey(&value_iter); break;
-      case MapParserState::UndefinedKey : next_state = handle_UndefinedKey(&value_iter); break;
-      case MapParserState::BaseVersion  : next_state = handle_BaseVersion(&value_iter, map_data); break;
-      case MapParserState::BaseName     : next_state = handle_BaseName(&value_iter, map_data); break;
-      case MapParserState::BaseTime     : next_state = handle_BaseTime(&value_iter, map_data); break;
-      case MapParserState::Time         : next_state = handle_Time(&value_iter, map_data); break;
-      case MapParserState::Name         : next_state = handle_Name(&value_iter, map_data, property_container); break;
-      case MapParserState::Value        : next_state = handle_Value(&value_iter, map_data); break;
-      case MapParserState::StringValue  : next_state = handle_StringValue(&value_iter, map_data); break;
-      case MapParserState::BooleanValue : next_state = handle_BooleanValue(&value_iter, map_data); break;
-      case MapParserState::LeaveMap     : next_state = handle_LeaveMap(&map_iter, &value_iter, map_data, property_container, current_property_name, current_property_base_time, current_property_time, isSyncMessage, map_data_list); break;
-      case MapParserState::Complete     : /* Nothing to do */ break;
-      case MapParserState::Error        : return; break;
+void CBORDecoder::decode(PropertyContainer & property_container, uint8_t const * const payload, size_t const length, bool isSyncMessage, bool isPeerMessage)
+{
+  /* The whole payload is available, hence it is decoded in place */
+  CBORDecoder decoder(property_container, isSyncMessage, isPeerMessage);
+  decoder._data = payload;
+  decoder._length = length;
+  AIOTC_TRACE(DecodeBegin, length);
+  decoder.process();
+  AIOTC_TRACE(DecodeEnd, decoder._state);
+}
+
+uint8_t * CBORDecoder::writeBuffer(size_t & available)
+{
+  if (!_buffer)
+  {
+    if (!_lease.acquire(AIOT_CONFIG_CBOR_DECODER_BUFFER_SIZE, MemoryPool::Scratch))
+    {
+      _state = DecoderState::Error;
+      available = 0;
+      return nullptr;
     }
+    _buffer = _lease.data();
+    _buffer_size = _lease.size();
+    _data = _buffer;
+  }
+
+  /* Once decoding has finished any further data is discarded */
+  if (_state == DecoderState::Complete || _state == DecoderState::Error)
+    _length = 0;
+  else if (_length == _buffer_size)
+    compact();
 
-    current_state = next_state;
+  available = _buffer_size - _length;
+  return _buffer + _length;
+}
+
+bool CBORDecoder::commit(size_t const length)
+{
+  if (_state == DecoderState::Complete || _state == DecoderState::Error)
+    return (_state == DecoderState::Complete);
+
+  _length = std::min(_length + length, _buffer_size);
+  AIOTC_TRACE(DecodeBegin, _length);
+  process();
+  AIOTC_TRACE(DecodeEnd, _state);
+
+  /* The records which are still required do not fit into the buffer. The
+   * property is updated with the records received so far, a single record
+   * which does not fit is passed without decoding it.
+   */
+  if (_state == DecoderState::Record && _length == _buffer_size && _group_offset == 0)
+  {
+    if (_map_data_list.size() > 0) {
+      flushProperty();
+      _group_offset = _record_offset;
+    } else {
+      _skip_items = 1;
+      _skip_bytes = 0;
+      _state = DecoderState::SkipRecord;
+      process();
+    }
   }
+
+  return (_state != DecoderState::Error);
 }
 
 /******************************************************************************
    PRIVATE MEMBER FUNCTIONS
  ******************************************************************************/
 
-CBORDecoder::MapParserState CBORDecoder::handle_EnterMap(CborValue * map_iter, CborValue * value_iter) {
-  MapParserState next_state = MapParserState::Error;
-
-  if (cbor_value_get_type(map_iter) == CborMapType) {
-    if (cbor_value_enter_container(map_iter, value_iter) == CborNoError) {
-      next_state = MapParserState::MapKey;
+void CBORDecoder::process()
+{
+  for (;;)
+  {
+    DecoderState const current_state = _state;
+    size_t const current_offset = _record_offset;
+
+    switch (_state)
+    {
+      case DecoderState::EnterArray: _state = handle_EnterArray(); break;
+      case DecoderState::Record:     _state = handle_Record(); break;
+      case DecoderState::SkipRecord: _state = handle_SkipRecord(); break;
+      case DecoderState::Complete:   /* Nothing to do */ return;
+      case DecoderState::Error:      /* Nothing to do */ return;
     }
-  }
 
-  return next_state;
+    /* The sync policies are applied once all properties of the message are known */
+    if (_is_sync_message && _state != current_state && (_state == DecoderState::Complete || _state == DecoderState::Error))
+      resolveSync(_property_container);
+
+    /* No progress has been made, wait for more data */
+    if (_state == current_state && _record_offset == current_offset)
+      return;
+  }
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_MapKey(CborValue * value_iter) {
-  MapParserState next_state = MapParserState::Error;
+CBORDecoder::DecoderState CBORDecoder::handle_EnterArray()
+{
+  if (_record_offset >= _length)
+    return DecoderState::EnterArray;
+
+  uint8_t const * const header = _data + _record_offset;
+  uint8_t const major_type = header[0] >> 5;
+  uint8_t const additional_info = header[0] & 0x1F;
+
+  if (major_type != 4 /* Array */)
+    return DecoderState::Error;
+
+  size_t header_length = 1;
+  if (additional_info == 31) {
+    _is_indefinite_array = true;
+  } else if (additional_info < 24) {
+    _remaining_records = additional_info;
+  } else if (additional_info <= 27) {
+    header_length += (1 << (additional_info - 24));
+    if (_length - _record_offset < header_length)
+      return DecoderState::EnterArray;
+    uint64_t count = 0;
+    for (size_t i = 1; i < header_length; i++)
+      count = (count << 8) | header[i];
+    _remaining_records = static_cast<size_t>(count);
+  } else {
+    return DecoderState::Error;
+  }
+
+  _record_offset += header_length;
+  _group_offset = _record_offset;
+  return DecoderState::Record;
+}
 
-  if (cbor_value_at_end(value_iter)) {
-    next_state = MapParserState::LeaveMap;
+CBORDecoder::DecoderState CBORDecoder::handle_Record()
+{
+  if (!_is_indefinite_array && _remaining_records == 0) {
+    flushProperty();
+    return DecoderState::Complete;
   }
-  /* The Map use the CBOR Label (protocol V2)
-     Example [{0: "temperature", 2: 25}]
-  */
-  else if (cbor_value_is_integer(value_iter)) {
-    int val = 0;
-    if (cbor_value_get_int(value_iter, &val) == CborNoError) {
-      if (cbor_value_advance(value_iter) == CborNoError) {
-        if (val == static_cast<int>(CborIntegerMapKey::Name)) {
-          next_state = MapParserState::Name;
-        } else if (val == static_cast<int>(CborIntegerMapKey::BaseVersion)) {
-          next_state = MapParserState::BaseVersion;
-        } else if (val == static_cast<int>(CborIntegerMapKey::BaseName)) {
-          next_state = MapParserState::BaseName;
-        } else if (val == static_cast<int>(CborIntegerMapKey::BaseTime)) {
-          next_state = MapParserState::BaseTime;
-        } else if (val == static_cast<int>(CborIntegerMapKey::Value)) {
-          next_state = MapParserState::Value;
-        } else if (val == static_cast<int>(CborIntegerMapKey::StringValue)) {
-          next_state = MapParserState::StringValue;
-        } else if (val == static_cast<int>(CborIntegerMapKey::BooleanValue)) {
-          next_state = MapParserState::BooleanValue;
-        } else if (val == static_cast<int>(CborIntegerMapKey::Time)) {
-          next_state = MapParserState::Time;
-        } else {
-          next_state = MapParserState::UndefinedKey;
-        }
-      }
-    }
+
+  if (_record_offset >= _length)
+    return DecoderState::Record;
+
+  uint8_t const * const record = _data + _record_offset;
+
+  if (_is_indefinite_array && record[0] == 0xFF /* Break */) {
+    flushProperty();
+    return DecoderState::Complete;
   }
 
-  return next_state;
+  /* The record is parsed into a copy, which is only taken over once the
+   * record has been received completely.
+   */
+  uint8_t const * pos = record;
+  CborMapData map_data = _map_data;
+  /* Unlike the base values the encoding only applies to its own record */
+  map_data.content_encoding.reset();
+
+  ItemState const record_state = parseRecord(pos, _data + _length, map_data, _property_container);
+  if (record_state == ItemState::Incomplete)
+    return DecoderState::Record;
+  if (record_state == ItemState::Malformed)
+    return DecoderState::Error;
+
+  size_t const record_length = pos - record;
+  _map_data = map_data;
+  appendRecord(_record_offset);
+
+  _record_offset += record_length;
+  if (!_is_indefinite_array)
+    _remaining_records--;
+
+  /* No record is referenced anymore, the buffer can be reused */
+  if (_map_data_list.size() == 0)
+    _group_offset = _record_offset;
+
+  return DecoderState::Record;
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_UndefinedKey(CborValue * value_iter) {
-  MapParserState next_state = MapParserState::Error;
+CBORDecoder::DecoderState CBORDecoder::handle_SkipRecord()
+{
+  /* The data items are passed header by header as they are received, only
+   * definite lengths can be followed this way (RFC 8949, Section 3).
+   */
+  while (_record_offset < _length)
+  {
+    if (_skip_bytes > 0) {
+      size_t const bytes = std::min(_skip_bytes, _length - _record_offset);
+      _skip_bytes -= bytes;
+      _record_offset += bytes;
+      continue;
+    }
+    if (_skip_items == 0)
+      break;
+
+    uint8_t const * const header = _data + _record_offset;
+    uint8_t const major_type = header[0] >> 5;
+    uint8_t const additional_info = header[0] & 0x1F;
+    if (additional_info > 27)
+      return DecoderState::Error;
+    size_t const header_length = (additional_info < 24) ? 1 : (1 + (1 << (additional_info - 24)));
+    if (_length - _record_offset < header_length)
+      break;
+    uint64_t argument = additional_info;
+    if (additional_info >= 24) {
+      argument = 0;
+      for (size_t i = 1; i < header_length; i++)
+        argument = (argument << 8) | header[i];
+    }
 
-  if (cbor_value_advance(value_iter) == CborNoError) {
-    next_state = MapParserState::MapKey;
+    _skip_items--;
+    _record_offset += header_length;
+    switch (major_type)
+    {
+      case 2: /* Byte string */
+      case 3: /* Text string */ _skip_bytes = static_cast<size_t>(argument); break;
+      case 4: /* Array */       _skip_items += static_cast<size_t>(argument); break;
+      case 5: /* Map */         _skip_items += 2 * static_cast<size_t>(argument); break;
+      case 6: /* Tag */         _skip_items += 1; break;
+      default: /* Integers, floats and simple values are complete with their header */ break;
+    }
   }
 
-  return next_state;
+  /* Nothing before the record is referenced anymore */
+  _group_offset = _record_offset;
+  if (_skip_items > 0 || _skip_bytes > 0)
+    return DecoderState::SkipRecord;
+
+  if (!_is_indefinite_array)
+    _remaining_records--;
+  return DecoderState::Record;
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_BaseVersion(CborValue * value_iter, CborMapData & map_data) {
-  MapParserState next_state = MapParserState::Error;
+void CBORDecoder::flushProperty()
+{
+  /* Update the property containers depending on the parsed data */
+  updateProperty(_current_property, _current_property_base_time + _current_property_time, _is_sync_message, &_map_data_list, _is_peer_message);
+  /* Reset current property data */
+  _map_data_list.clear();
+  _current_property = nullptr;
+  _current_property_base_time = 0;
+  _current_property_time = 0;
+}
 
-  if (cbor_value_is_integer(value_iter)) {
-    int val = 0;
-    if (cbor_value_get_int(value_iter, &val) == CborNoError) {
-      map_data.base_version.set(val);
+void CBORDecoder::compact()
+{
+  size_t const shift = _group_offset;
+  if (shift == 0)
+    return;
 
-      if (cbor_value_advance(value_iter) == CborNoError) {
-        next_state = MapParserState::MapKey;
-      }
-    }
+  /* Move the records still referenced to the front of the buffer and adjust
+   * all references into them, references into discarded records are dropped.
+   */
+  uint8_t const * const end = _buffer + _length;
+  for (CborMapData & map_data : _map_data_list) {
+    relocate(map_data.base_name, _buffer, end, shift);
+    relocate(map_data.name, _buffer, end, shift);
+    relocate(map_data.attribute_name, _buffer, end, shift);
+    relocate(map_data.value, _buffer, end, shift);
   }
-
-  return next_state;
+  relocate(_map_data.base_name, _buffer, end, shift);
+  relocate(_map_data.name, _buffer, end, shift);
+  relocate(_map_data.attribute_name, _buffer, end, shift);
+  relocate(_map_data.value, _buffer, end, shift);
+
+  MapEntry<CborStringView> current_property_name;
+  current_property_name.set(_current_property_name);
+  relocate(current_property_name, _buffer, end, shift);
+  _current_property_name = current_property_name.isSet() ? current_property_name.get() : CborStringView();
+
+  memmove(_buffer, _buffer + shift, _length - shift);
+  _length -= shift;
+  _record_offset -= shift;
+  _group_offset = 0;
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_BaseName(CborValue * value_iter, CborMapData & map_data) {
-  MapParserState next_state = MapParserState::Error;
+void CBORDecoder::appendRecord(size_t const record_offset) {
+  if (_map_data.name.isSet()) {
+    CborStringView propertyName = _map_data.name.get();
+    int colonPos = propertyName.find(':');
+    if (colonPos != -1) {
+      propertyName = propertyName.substr(0, colonPos);
+    }
 
-  if (cbor_value_is_text_string(value_iter)) {
-    char * val      = 0;
-    size_t val_size = 0;
-    if (cbor_value_dup_text_string(value_iter, &val, &val_size, value_iter) == CborNoError) {
-      map_data.base_name.set(String(val));
-      free(val);
-      next_state = MapParserState::MapKey;
+    /* A base name of the form "name:" is prepended to the attribute name of
+     * the record, a record without a name refers to the base name itself.
+     */
+    bool const is_light_payload = _map_data.isLightPayload();
+    if (!is_light_payload && _map_data.base_name.isSet() && !_map_data.base_name.get().empty()) {
+      CborStringView const base_name = _map_data.base_name.get();
+      int const baseColonPos = base_name.find(':');
+      if (baseColonPos == static_cast<int>(base_name.length()) - 1) {
+        propertyName = base_name.substr(0, baseColonPos);
+        _map_data.attribute_name.set(_map_data.name.get());
+      } else if (_map_data.name.get().empty()) {
+        propertyName = (baseColonPos != -1) ? base_name.substr(0, baseColonPos) : base_name;
+        _map_data.attribute_name.set((baseColonPos != -1) ? base_name.substr(baseColonPos + 1) : CborStringView());
+      }
     }
-  }
 
-  return next_state;
+    if (!_current_property_name.empty() && propertyName != _current_property_name) {
+      flushProperty();
+    }
+    /* The property is looked up once for all its records, the one of a light
+     * payload has already been resolved by its identifier.
+     */
+    if (_map_data_list.size() == 0) {
+      _current_property = is_light_payload ? _map_data.property.get() : _property_container.find(propertyName);
+    }
+    /* The first record of a property has to be kept until the property is updated */
+    if (_map_data_list.size() == 0) {
+      _group_offset = record_offset;
+    }
+    /* Compute the cloud change event baseTime and Time */
+    if (_map_data.base_time.isSet()) {
+      _current_property_base_time = (unsigned long)(_map_data.base_time.get());
+    }
+    if (_map_data.time.isSet() && (_map_data.time.get() > _current_property_time)) {
+      _current_property_time = (unsigned long)_map_data.time.get();
+    }
+    _map_data_list.push_back(_map_data);
+    _current_property_name = propertyName;
+  }
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_BaseTime(CborValue * value_iter, CborMapData & map_data) {
-  MapParserState next_state = MapParserState::Error;
+CBORDecoder::ItemState CBORDecoder::parseRecord(uint8_t const * & pos, uint8_t const * const end, CborMapData & map_data, PropertyContainer & property_container) {
+  uint8_t major_type = 0, additional_info = 0;
+  uint64_t argument = 0;
+  ItemState state = parseHeader(pos, end, major_type, additional_info, argument);
+  if (state != ItemState::Complete)
+    return state;
+  if (major_type != 5 /* Map */)
+    return ItemState::Malformed;
 
-  double val = 0.0;
-  if (ifNumericConvertToDouble(value_iter, &val)) {
-    map_data.base_time.set(val);
+  /* The Map use the CBOR Label (protocol V2)
+     Example [{0: "temperature", 2: 25}]
+  */
+  bool const is_indefinite_map = (additional_info == 31);
+  for (uint64_t pair = 0; is_indefinite_map || pair < argument; pair++) {
+    if (pos >= end)
+      return ItemState::Incomplete;
+    if (is_indefinite_map && pos[0] == 0xFF /* Break */) {
+      pos++;
+      break;
+    }
 
-    if (cbor_value_advance(value_iter) == CborNoError) {
-      next_state = MapParserState::MapKey;
+    int64_t key = 0;
+    state = parseInteger(pos, end, key);
+    if (state != ItemState::Complete)
+      return state;
+
+    double number = 0.0;
+    bool boolean = false;
+    int64_t integer = 0;
+    CborStringView view;
+
+    /* A key beyond the range of int is unknown as well */
+    int const label = (key >= INT_MIN && key <= INT_MAX) ? static_cast<int>(key) : INT_MAX;
+    switch (static_cast<CborIntegerMapKey>(label)) {
+      case CborIntegerMapKey::Name:
+        state = parseName(pos, end, map_data, property_container);
+        break;
+      case CborIntegerMapKey::BaseVersion:
+        /* Only version 10 exists, hence the version is not kept */
+        state = parseInteger(pos, end, integer);
+        break;
+      case CborIntegerMapKey::BaseName:
+        state = parseStringView(pos, end, 3 /* Text string */, view);
+        if (state == ItemState::Complete) map_data.base_name.set(view);
+        break;
+      case CborIntegerMapKey::BaseTime:
+        state = parseNumber(pos, end, number);
+        if (state == ItemState::Complete) map_data.base_time.set(number);
+        break;
+      case CborIntegerMapKey::Time:
+        state = parseNumber(pos, end, number);
+        if (state == ItemState::Complete) map_data.time.set(number);
+        break;
+      case CborIntegerMapKey::Value:
+        state = parseNumber(pos, end, number);
+        if (state == ItemState::Complete) map_data.value.setNumber(number);
+        break;
+      case CborIntegerMapKey::StringValue:
+        state = parseStringView(pos, end, 3 /* Text string */, view);
+        if (state == ItemState::Complete) map_data.value.setString(view);
+        break;
+      case CborIntegerMapKey::BooleanValue:
+        state = parseBoolean(pos, end, boolean);
+        if (state == ItemState::Complete) map_data.value.setBoolean(boolean);
+        break;
+      case CborIntegerMapKey::DataValue:
+        state = parseStringView(pos, end, 2 /* Byte string */, view);
+        if (state == ItemState::Complete) map_data.value.setData(view);
+        break;
+      case CborIntegerMapKey::ContentEncoding:
+        state = parseInteger(pos, end, integer);
+        if (state == ItemState::Complete) map_data.content_encoding.set(static_cast<uint8_t>(integer));
+        break;
+      default:
+        /* The value of an unknown key is skipped whatever its type, unless it is malformed */
+        state = skipItem(pos, end, 0);
+        break;
     }
+
+    if (state != ItemState::Complete)
+      return state;
   }
 
-  return next_state;
+  return ItemState::Complete;
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_Name(CborValue * value_iter, CborMapData & map_data, PropertyContainer & property_container) {
-  MapParserState next_state = MapParserState::Error;
+CBORDecoder::ItemState CBORDecoder::parseName(uint8_t const * & pos, uint8_t const * const end, CborMapData & map_data, PropertyContainer & property_container) {
+  if (pos >= end)
+    return ItemState::Incomplete;
 
-  if (cbor_value_is_text_string(value_iter)) {
+  if ((pos[0] >> 5) == 3 /* Text string */) {
     // if the value in the cbor message is a string, it corresponds to the name of the property to be updated (int the form [property_name]:[attribute_name])
-    char * val      = nullptr;
-    size_t val_size = 0;
-    if (cbor_value_dup_text_string(value_iter, &val, &val_size, value_iter) == CborNoError) {
-      String name = val;
-      free(val);
+    CborStringView name;
+    ItemState const state = parseStringView(pos, end, 3 /* Text string */, name);
+    if (state == ItemState::Complete) {
       map_data.name.set(name);
-      int colonPos = name.indexOf(":");
-      String attribute_name = "";
+      int colonPos = name.find(':');
+      CborStringView attribute_name;
       if (colonPos != -1) {
-        attribute_name = name.substring(colonPos + 1);
+        attribute_name = name.substr(colonPos + 1);
       }
       map_data.attribute_name.set(attribute_name);
-      next_state = MapParserState::MapKey;
-    }
-  } else if (cbor_value_is_integer(value_iter)) {
-    // if the value in the cbor message is an integer, a light payload has been used and an integer identifier should be decode in order to retrieve the corresponding property and attribute name to be updated
-    int val = 0;
-    if (cbor_value_get_int(value_iter, &val) == CborNoError) {
-      map_data.light_payload.set(true);
-      map_data.name_identifier.set(val & 255);
-      map_data.attribute_identifier.set(val >> 8);
-      map_data.light_payload.set(true);
-      String name = getPropertyNameByIdentifier(property_container, val);
-      map_data.name.set(name);
-
-
-      if (cbor_value_advance(value_iter) == CborNoError) {
-        next_state = MapParserState::MapKey;
-      }
     }
+    return state;
   }
 
-
-
-  return next_state;
+  // if the value in the cbor message is an integer, a light payload has been used and an integer identifier should be decode in order to retrieve the corresponding property and attribute name to be updated
+  int64_t identifier = 0;
+  ItemState const state = parseInteger(pos, end, identifier);
+  if (state == ItemState::Complete) {
+    int const val = static_cast<int>(identifier);
+    map_data.attribute_identifier.set(static_cast<uint8_t>(val >> 8));
+    /* The name refers to the one stored within the property, hence no copy is required */
+    Property * property = getProperty(property_container, val & 255);
+    map_data.name.set(property ? CborStringView(property->c_name()) : CborStringView());
+    map_data.property.set(property);
+  }
+  return state;
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_Value(CborValue * value_iter, CborMapData & map_data) {
-  MapParserState next_state = MapParserState::Error;
+CBORDecoder::ItemState CBORDecoder::parseHeader(uint8_t const * & pos, uint8_t const * const end, uint8_t & major_type, uint8_t & additional_info, uint64_t & argument) {
+  if (pos >= end)
+    return ItemState::Incomplete;
 
-  double val = 0.0;
-  if (ifNumericConvertToDouble(value_iter, &val)) {
-    map_data.val.set(val);
+  /* The initial byte is followed by up to 8 bytes of argument (RFC 8949, Section 3) */
+  major_type = pos[0] >> 5;
+  additional_info = pos[0] & 0x1F;
+  if (additional_info > 27 && additional_info != 31)
+    return ItemState::Malformed;
 
-    if (cbor_value_advance(value_iter) == CborNoError) {
-      next_state = MapParserState::MapKey;
-    }
-  }
+  size_t const header_length = (additional_info < 24 || additional_info == 31) ? 1 : (1 + (1 << (additional_info - 24)));
+  if (static_cast<size_t>(end - pos) < header_length)
+    return ItemState::Incomplete;
+
+  argument = (additional_info < 24) ? additional_info : 0;
+  for (size_t i = 1; i < header_length; i++)
+    argument = (argument << 8) | pos[i];
 
-  return next_state;
+  pos += header_length;
+  return ItemState::Complete;
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_StringValue(CborValue * value_iter, CborMapData & map_data) {
-  MapParserState next_state = MapParserState::Error;
+CBORDecoder::ItemState CBORDecoder::parseInteger(uint8_t const * & pos, uint8_t const * const end, int64_t & value) {
+  uint8_t major_type = 0, additional_info = 0;
+  uint64_t argument = 0;
+  ItemState const state = parseHeader(pos, end, major_type, additional_info, argument);
+  if (state != ItemState::Complete)
+    return state;
+  if (major_type > 1 /* Negative integer */ || additional_info == 31)
+    return ItemState::Malformed;
+
+  value = (major_type == 0) ? static_cast<int64_t>(argument) : (-1 - static_cast<int64_t>(argument));
+  return ItemState::Complete;
+}
 
-  if (cbor_value_is_text_string(value_iter)) {
-    char * val      = 0;
-    size_t val_size = 0;
-    if (cbor_value_dup_text_string(value_iter, &val, &val_size, value_iter) == CborNoError) {
-      map_data.str_val.set(String(val));
-      free(val);
-      next_state = MapParserState::MapKey;
-    }
+CBORDecoder::ItemState CBORDecoder::parseNumber(uint8_t const * & pos, uint8_t const * const end, double & value) {
+  uint8_t major_type = 0, additional_info = 0;
+  uint64_t argument = 0;
+  ItemState const state = parseHeader(pos, end, major_type, additional_info, argument);
+  if (state != ItemState::Complete)
+    return state;
+  if (additional_info == 31)
+    return ItemState::Malformed;
+
+  if (major_type == 0) {
+    value = static_cast<double>(argument);
+  } else if (major_type == 1) {
+    value = -1.0 - static_cast<double>(argument);
+  } else if (major_type == 7 && additional_info == 25) {
+    value = convertCborHalfFloatToDouble(static_cast<uint16_t>(argument));
+  } else if (major_type == 7 && additional_info == 26) {
+    uint32_t const bits = static_cast<uint32_t>(argument);
+    float val = 0.0f;
+    memcpy(&val, &bits, sizeof(val));
+    value = static_cast<double>(val);
+  } else if (major_type == 7 && additional_info == 27) {
+    memcpy(&value, &argument, sizeof(value));
+  } else {
+    return ItemState::Malformed;
   }
 
-  return next_state;
+  return ItemState::Complete;
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_BooleanValue(CborValue * value_iter, CborMapData & map_data) {
-  MapParserState next_state = MapParserState::Error;
-
-  bool val = false;
-  if (cbor_value_get_boolean(value_iter, &val) == CborNoError) {
-    map_data.bool_val.set(val);
-
-    if (cbor_value_advance(value_iter) == CborNoError) {
-      next_state = MapParserState::MapKey;
-    }
-  }
+CBORDecoder::ItemState CBORDecoder::parseBoolean(uint8_t const * & pos, uint8_t const * const end, bool & value) {
+  uint8_t major_type = 0, additional_info = 0;
+  uint64_t argument = 0;
+  ItemState const state = parseHeader(pos, end, major_type, additional_info, argument);
+  if (state != ItemState::Complete)
+    return state;
+  if (major_type != 7 || (additional_info != 20 /* false */ && additional_info != 21 /* true */))
+    return ItemState::Malformed;
+
+  value = (additional_info == 21);
+  return ItemState::Complete;
+}
 
-  return next_state;
+CBORDecoder::ItemState CBORDecoder::parseStringView(uint8_t const * & pos, uint8_t const * const end, uint8_t const major_type, CborStringView & view) {
+  uint8_t type = 0, additional_info = 0;
+  uint64_t length = 0;
+  ItemState const state = parseHeader(pos, end, type, additional_info, length);
+  if (state != ItemState::Complete)
+    return state;
+
+  /* Only a string of known length is stored contiguously within the payload
+   * and can therefore be referenced in place without copying it.
+   */
+  if (type != major_type || additional_info == 31)
+    return ItemState::Malformed;
+  if (static_cast<uint64_t>(end - pos) < length)
+    return ItemState::Incomplete;
+
+  view = CborStringView(reinterpret_cast<char const *>(pos), static_cast<size_t>(length));
+  pos += length;
+  return ItemState::Complete;
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_Time(CborValue * value_iter, CborMapData & map_data) {
-  MapParserState next_state = MapParserState::Error;
+CBORDecoder::ItemState CBORDecoder::skipItem(uint8_t const * & pos, uint8_t const * const end, unsigned int const depth) {
+  if (depth > MAX_NESTING_DEPTH)
+    return ItemState::Malformed;
+
+  uint8_t major_type = 0, additional_info = 0;
+  uint64_t argument = 0;
+  ItemState state = parseHeader(pos, end, major_type, additional_info, argument);
+  if (state != ItemState::Complete)
+    return state;
+
+  bool const is_indefinite = (additional_info == 31);
+  switch (major_type)
+  {
+    case 2: /* Byte string */
+    case 3: /* Text string */
+      if (!is_indefinite) {
+        if (static_cast<uint64_t>(end - pos) < argument)
+          return ItemState::Incomplete;
+        pos += argument;
+        return ItemState::Complete;
+      }
+      /* Definite length chunks of the same type up to the break */
+      for (;;) {
+        if (pos >= end)
+          return ItemState::Incomplete;
+        if (pos[0] == 0xFF /* Break */) {
+          pos++;
+          return ItemState::Complete;
+        }
+        CborStringView chunk;
+        state = parseStringView(pos, end, major_type, chunk);
+        if (state != ItemState::Complete)
+          return state;
+      }
 
-  double val = 0.0;
-  if (ifNumericConvertToDouble(value_iter, &val)) {
-    map_data.time.set(val);
+    case 4: /* Array */
+    case 5: /* Map */
+      for (uint64_t i = 0; is_indefinite || i < argument; i++) {
+        if (pos >= end)
+          return ItemState::Incomplete;
+        if (is_indefinite && pos[0] == 0xFF /* Break */) {
+          pos++;
+          break;
+        }
+        state = skipItem(pos, end, depth + 1);
+        if (state == ItemState::Complete && major_type == 5)
+          state = skipItem(pos, end, depth + 1);
+        if (state != ItemState::Complete)
+          return state;
+      }
+      return ItemState::Complete;
 
-    if (cbor_value_advance(value_iter) == CborNoError) {
-      next_state = MapParserState::MapKey;
-    }
-  }
+    case 6: /* Tag */
+      return is_indefinite ? ItemState::Malformed : skipItem(pos, end, depth + 1);
 
-  return next_state;
+    default: /* Integers, floats and simple values are complete with their header, a break is out of place */
+      return is_indefinite ? ItemState::Malformed : ItemState::Complete;
+  }
 }
 
-CBORDecoder::MapParserState CBORDecoder::handle_LeaveMap(CborValue * map_iter, CborValue * value_iter, CborMapData & map_data, PropertyContainer & property_container, String & current_property_name, unsigned long & current_property_base_time, unsigned long & current_property_time, bool const is_sync_message, std::list<CborMapData> & map_data_list) {
-  MapParserState next_state = MapParserState::Error;
-  if (map_data.name.isSet()) {
-    String propertyName;
-    int colonPos = map_data.name.get().indexOf(":");
-    if (colonPos != -1) {
-      propertyName = map_data.name.get().substring(0, colonPos);
-    } else {
-      propertyName = map_data.name.get();
-    }
+bool CBORDecoder::relocate(CborStringView & view, uint8_t const * const begin, uint8_t const * const end, size_t const shift) {
+  uint8_t const * const data = reinterpret_cast<uint8_t const *>(view.data());
+  if (data < begin || data >= end)
+    return true; /* Not a reference into the buffer, e.g. a property name */
 
-    if (current_property_name != "" && propertyName != current_property_name) {
-      /* Update the property containers depending on the parsed data */
-      updateProperty(property_container, current_property_name, current_property_base_time + current_property_time, is_sync_message, &map_data_list);
-      /* Reset current property data */
-      map_data_list.clear();
-      current_property_base_time = 0;
-      current_property_time = 0;
-    }
-    /* Compute the cloud change event baseTime and Time */
-    if (map_data.base_time.isSet()) {
-      current_property_base_time = (unsigned long)(map_data.base_time.get());
-    }
-    if (map_data.time.isSet() && (map_data.time.get() > current_property_time)) {
-      current_property_time = (unsigned long)map_data.time.get();
-    }
-    map_data_list.push_back(map_data);
-    current_property_name = propertyName;
-  }
+  if (data < begin + shift)
+    return false;
+  view = CborStringView(reinterpret_cast<char const *>(data - shift), view.length());
+  return true;
+}
 
-  /* Transition into the next map if available, otherwise finish */
-  if (cbor_value_leave_container(map_iter, value_iter) == CborNoError) {
-    if (!cbor_value_at_end(map_iter)) {
-      next_state = MapParserState::EnterMap;
-    } else {
-      /* Update the property containers depending on the parsed data */
-      updateProperty(property_container, current_property_name, current_property_base_time + current_property_time, is_sync_message, &map_data_list);
-      /* Reset last property data */
-      map_data_list.clear();
-      next_state = MapParserState::Complete;
-    }
-  }
+void CBORDecoder::relocate(MapEntry<CborStringView> & entry, uint8_t const * const begin, uint8_t const * const end, size_t const shift) {
+  if (!entry.isSet())
+    return;
 
-  return next_state;
+  CborStringView view = entry.get();
+  if (relocate(view, begin, end, shift))
+    entry.set(view);
+  else
+    entry.reset();
 }
 
-bool CBORDecoder::ifNumericConvertToDouble(CborValue * value_iter, double * numeric_val) {
-
-  if (cbor_value_is_integer(value_iter)) {
-    int64_t val = 0;
-    if (cbor_value_get_int64(value_iter, &val) == CborNoError) {
-      *numeric_val = static_cast<double>(val);
-      return true;
-    }
-  } else if (cbor_value_is_double(value_iter)) {
-    double val = 0.0;
-    if (cbor_value_get_double(value_iter, &val) == CborNoError) {
-      *numeric_val = val;
-      return true;
-    }
-  } else if (cbor_value_is_float(value_iter)) {
-    float val = 0.0;
-    if (cbor_value_get_float(value_iter, &val) == CborNoError) {
-      *numeric_val = static_cast<double>(val);
-      return true;
-    }
-  } else if (cbor_value_is_half_float(value_iter)) {
-    uint16_t val = 0;
-    if (cbor_value_get_half_float(value_iter, &val) == CborNoError) {
-      *numeric_val = static_cast<double>(convertCborHalfFloatToDouble(val));
-      return true;
-    }
-  }
+void CBORDecoder::relocate(MapValue & value, uint8_t const * const begin, uint8_t const * const end, size_t const shift) {
+  if (!value.isString() && !value.isData())
+    return;
 
-  return false;
+  CborStringView view = value.isString() ? value.string() : value.data();
+  if (!relocate(view, begin, end, shift))
+    value.reset();
+  else if (value.isString())
+    value.setString(view);
+  else
+    value.setData(view);
 }
 
 /* Source Idea from https://tools.ietf.org/html/rfc7049 : Page: 50 */
@@ -30,9 +30,9 @@
 
 #undef max
 #undef min
-#include <list>
 
 #include "../property/PropertyContainer.h"
+#include "../utility/memory/ScratchPool.h"
 
 /******************************************************************************
    CLASS DECLARATION
@@ -43,46 +43,101 @@ class CBORDecoder
 
 public:
 
+  /* A peer message is the update of a property mirrored by another device on
+   * the LAN. It is applied as one from the cloud but not echoed back, the
+   * cloud keeps sending its own value.
+   */
+  CBORDecoder(PropertyContainer & property_container, bool const is_sync_message = false, bool const is_peer_message = false);
+
   /* decode a CBOR payload received from the cloud */
-  static void decode(PropertyContainer & property_container, uint8_t const * const payload, size_t const length, bool isSyncMessage = false);
+  static void decode(PropertyContainer & property_container, uint8_t const * const payload, size_t const length, bool isSyncMessage = false, bool isPeerMessage = false);
+
+  /* Incremental decoding of a payload which is received in chunks: up to
+   * 'available' bytes of the payload are placed into the buffer returned by
+   * writeBuffer() and handed over to the decoder via commit(). Each SenML
+   * record is applied to the property container as soon as it is complete.
+   * commit() returns false if the payload is malformed. The memory used does
+   * not depend on the size of the payload: a property whose records do not
+   * fit into the decoder buffer together is updated with those received so
+   * far, a single record which does not fit is skipped. The buffer is leased
+   * from the scratch pool, if no memory is left writeBuffer() returns none.
+   */
+  uint8_t * writeBuffer(size_t & available);
+  bool      commit(size_t const length);
+  inline bool isComplete() const { return _state == DecoderState::Complete; }
 
 
 private:
 
-  CBORDecoder() { }
-  CBORDecoder(CBORDecoder const &) { }
-
-  enum class MapParserState {
-    EnterMap,
-    MapKey,
-    UndefinedKey,
-    BaseVersion,
-    BaseName,
-    BaseTime,
-    Name,
-    Value,
-    StringValue,
-    BooleanValue,
-    Time,
-    LeaveMap,
+  CBORDecoder(CBORDecoder const &) = delete;
+
+  enum class DecoderState {
+    EnterArray,
+    Record,
+    SkipRecord,
     Complete,
     Error
   };
 
-  static MapParserState handle_EnterMap(CborValue * map_iter, CborValue * value_iter);
-  static MapParserState handle_MapKey(CborValue * value_iter);
-  static MapParserState handle_UndefinedKey(CborValue * value_iter);
-  static MapParserState handle_BaseVersion(CborValue * value_iter, CborMapData & map_data);
-  static MapParserState handle_BaseName(CborValue * value_iter, CborMapData & map_data);
-  static MapParserState handle_BaseTime(CborValue * value_iter, CborMapData & map_data);
-  static MapParserState handle_Name(CborValue * value_iter, CborMapData & map_data, PropertyContainer & property_container);
-  static MapParserState handle_Value(CborValue * value_iter, CborMapData & map_data);
-  static MapParserState handle_StringValue(CborValue * value_iter, CborMapData & map_data);
-  static MapParserState handle_BooleanValue(CborValue * value_iter, CborMapData & map_data);
-  static MapParserState handle_Time(CborValue * value_iter, CborMapData & map_data);
-  static MapParserState handle_LeaveMap(CborValue * map_iter, CborValue * value_iter, CborMapData & map_data, PropertyContainer & property_container, String & current_property_name, unsigned long & current_property_base_time, unsigned long & current_property_time, bool const is_sync_message, std::list<CborMapData> & map_data_list);
-
-  static bool   ifNumericConvertToDouble(CborValue * value_iter, double * numeric_val);
+  /* Result of parsing a data item of a record which may not have been
+   * received completely yet.
+   */
+  enum class ItemState {
+    Complete,
+    Incomplete,
+    Malformed
+  };
+
+  /* Unknown values nested deeper are treated as malformed */
+  static constexpr unsigned int MAX_NESTING_DEPTH = 8;
+
+  PropertyContainer & _property_container;
+  bool const _is_sync_message;
+  bool const _is_peer_message;
+  DecoderState _state;
+  ScratchLease _lease;       /* Taken once the first chunk is to be received */
+  uint8_t * _buffer;
+  size_t _buffer_size;
+  uint8_t const * _data;
+  size_t _length;            /* Number of bytes available at _data */
+  size_t _record_offset;     /* Start of the next record which has not yet been decoded */
+  size_t _group_offset;      /* Start of the first record referenced by _map_data_list */
+  size_t _remaining_records;
+  bool _is_indefinite_array;
+  size_t _skip_items;        /* Data items of the record being skipped which have not been passed yet */
+  size_t _skip_bytes;        /* Content bytes of the string being skipped */
+  CborMapData _map_data;
+  CborMapDataList _map_data_list; /* List of map data that will hold all the attributes of a property */
+  CborStringView _current_property_name; /* Current property name during decoding: use to look for a new property in the senml value array */
+  Property * _current_property;          /* Resolved once per property, nullptr if it is unknown */
+  unsigned long _current_property_base_time;
+  unsigned long _current_property_time;
+
+  void process();
+  DecoderState handle_EnterArray();
+  DecoderState handle_Record();
+  DecoderState handle_SkipRecord();
+  void flushProperty();
+  void compact();
+
+  void appendRecord(size_t const record_offset);
+
+  /* The records are parsed in a single forward pass over the payload. A
+   * parser advances 'pos' past the data item it has parsed, 'end' is the end
+   * of the data received so far.
+   */
+  static ItemState parseRecord(uint8_t const * & pos, uint8_t const * const end, CborMapData & map_data, PropertyContainer & property_container);
+  static ItemState parseName(uint8_t const * & pos, uint8_t const * const end, CborMapData & map_data, PropertyContainer & property_container);
+  static ItemState parseHeader(uint8_t const * & pos, uint8_t const * const end, uint8_t & major_type, uint8_t & additional_info, uint64_t & argument);
+  static ItemState parseInteger(uint8_t const * & pos, uint8_t const * const end, int64_t & value);
+  static ItemState parseNumber(uint8_t const * & pos, uint8_t const * const end, double & value);
+  static ItemState parseBoolean(uint8_t const * & pos, uint8_t const * const end, bool & value);
+  static ItemState parseStringView(uint8_t const * & pos, uint8_t const * const end, uint8_t const major_type, CborStringView & view);
+  static ItemState skipItem(uint8_t const * & pos, uint8_t const * const end, unsigned int const depth);
+  /* Returns false if the view refers to the discarded part of the buffer */
+  static bool   relocate(CborStringView & view, uint8_t const * const begin, uint8_t const * const end, size_t const shift);
+  static void   relocate(MapEntry<CborStringView> & entry, uint8_t const * const begin, uint8_t const * const end, size_t const shift);
+  static void   relocate(MapValue & value, uint8_t const * const begin, uint8_t const * const end, size_t const shift);
   static double convertCborHalfFloatToDouble(uint16_t const half_val);
 
 };
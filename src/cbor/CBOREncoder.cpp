@@ -24,20 +24,29 @@
 #undef max
 #undef min
 #include <algorithm>
-#include <iterator>
 
 #include "lib/tinycbor/cbor-lib.h"
+#include "../utility/trace/Trace.h"
 
 /******************************************************************************
  * PUBLIC MEMBER FUNCTIONS
  ******************************************************************************/
 
-CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload)
+CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload, unsigned long const timestamp, bool baseValues, bool packing, bool readOnly, SpilledString * spill)
 {
   EncoderState current_state = EncoderState::InitPropertyEncoder,
                next_state = EncoderState::InitPropertyEncoder;
 
   PropertyContainerEncoder propertyEncoder(property_container, current_property_index);
+  propertyEncoder.timestamp = timestamp;
+  propertyEncoder.base_values_enabled = baseValues;
+  propertyEncoder.packing = packing;
+  propertyEncoder.read_only = readOnly;
+  propertyEncoder.spill = spill;
+  propertyEncoder.spill_armed = false;
+  PropertyGroup::beginMessage();
+
+  AIOTC_TRACE(EncodeBegin, current_property_index);
 
   while (current_state != EncoderState::SendMessage) {
 
@@ -47,9 +56,7 @@ CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t *
       case EncoderState::TryAppend                : next_state = handle_TryAppend(propertyEncoder, lightPayload); break;
       case EncoderState::OutOfMemory              : next_state = handle_OutOfMemory(propertyEncoder); break;
       case EncoderState::SkipProperty             : next_state = handle_SkipProperty(propertyEncoder); break;
-      case EncoderState::TrimAppend               : next_state = handle_TrimAppend(propertyEncoder); break;
       case EncoderState::CloseCBORContainer       : next_state = handle_CloseCBORContainer(propertyEncoder); break;
-      case EncoderState::TrimClose                : next_state = handle_TrimClose(propertyEncoder); break;
       case EncoderState::FinishAppend             : next_state = handle_FinishAppend(propertyEncoder); break;
       case EncoderState::SendMessage              : /* Nothing to do */ break;
       case EncoderState::Error                    : return CborErrorInternalError; break;
@@ -63,9 +70,25 @@ CborError CBOREncoder::encode(PropertyContainer & property_container, uint8_t *
   else
     bytes_encoded = 0;
 
+  AIOTC_TRACE(EncodeEnd, bytes_encoded);
   return CborNoError;
 }
 
+size_t CBOREncoder::encodeTextStringHeader(uint8_t * data, size_t const length)
+{
+  /* Major type 3 followed by the length as argument (RFC 8949, Section 3) */
+  uint8_t const major_type = 0x60;
+  if (length < 24) {
+    data[0] = major_type | static_cast<uint8_t>(length);
+    return 1;
+  }
+  size_t const bytes = (length <= 0xFF) ? 1 : (length <= 0xFFFF) ? 2 : 4;
+  data[0] = major_type | ((bytes == 1) ? 24 : (bytes == 2) ? 25 : 26);
+  for (size_t i = 0; i < bytes; i++)
+    data[1 + i] = static_cast<uint8_t>(static_cast<uint32_t>(length) >> (8 * (bytes - 1 - i)));
+  return 1 + bytes;
+}
+
 /******************************************************************************
    PRIVATE MEMBER FUNCTIONS
  ******************************************************************************/
@@ -74,8 +97,10 @@ CBOREncoder::EncoderState CBOREncoder::handle_InitPropertyEncoder(PropertyContai
 {
   propertyEncoder.encoded_property_count = 0;
   propertyEncoder.checked_property_count = 0;
-  propertyEncoder.encoded_property_limit = 0;
-  propertyEncoder.property_limit_active  = false;
+  propertyEncoder.priority_pass_enabled  = true;
+  propertyEncoder.priority_pass_end      = 0;
+  /* Pick up all the properties which are due to be published periodically */
+  propertyEncoder.property_container.processDeadlines(millis());
   return EncoderState::OpenCBORContainer;
 }
 
@@ -83,8 +108,19 @@ CBOREncoder::EncoderState CBOREncoder::handle_OpenCBORContainer(PropertyContaine
 {
   propertyEncoder.encoded_property_count = 0;
   propertyEncoder.checked_property_count = 0;
+  propertyEncoder.priority_pass_end = 0;
+  propertyEncoder.base_values = SenMLBaseValues();
+  propertyEncoder.property_container.clearAppended();
+  if (propertyEncoder.spill)
+    *propertyEncoder.spill = SpilledString();
   cbor_encoder_init(&propertyEncoder.encoder, data, size, 0);
-  cbor_encoder_create_array(&propertyEncoder.encoder, &propertyEncoder.arrayEncoder, CborIndefiniteLength);
+  /* The break byte closing the array is reserved up front, so that closing
+   * the message can not fail once the properties have filled the buffer.
+   */
+  CborError const error = cbor_encoder_create_array(&propertyEncoder.encoder, &propertyEncoder.arrayEncoder, CborIndefiniteLength);
+  propertyEncoder.break_reserved = (error == CborNoError) && (size >= 2);
+  if (propertyEncoder.break_reserved)
+    propertyEncoder.arrayEncoder.end -= 1;
   return EncoderState::TryAppend;
 }
 
@@ -94,35 +130,80 @@ CBOREncoder::EncoderState CBOREncoder::handle_TryAppend(PropertyContainerEncoder
    * and if that's the case encode the property into the CBOR.
    */
   CborError error = CborNoError;
-  PropertyContainer::iterator iter = propertyEncoder.property_container.begin();
-  std::advance(iter, propertyEncoder.current_property_index);
+  PropertyContainer & property_container = propertyEncoder.property_container;
 
-  for(; iter != propertyEncoder.property_container.end(); iter++)
+  /* A packed message is chosen from the due properties within each priority */
+  if (propertyEncoder.packing)
   {
-    Property * p = * iter;
+    size_t resume_idx = 0;
+    if (propertyEncoder.priority_pass_enabled)
+      error = appendPacked(propertyEncoder, 0, true, false, lightPayload, resume_idx);
+    if (error == CborNoError)
+      error = appendPacked(propertyEncoder, propertyEncoder.current_property_index, !propertyEncoder.priority_pass_enabled, true, lightPayload, resume_idx);
+    propertyEncoder.checked_property_count = resume_idx - propertyEncoder.current_property_index;
+    return (CborNoError == error) ? EncoderState::CloseCBORContainer : EncoderState::Error;
+  }
 
-    if (p->shouldBeUpdated() && p->isReadableByCloud())
+  /* High priority properties get the payload first, independently of the round-robin position */
+  if (propertyEncoder.priority_pass_enabled)
+  {
+    size_t idx = 0;
+    while (idx < property_container.size())
     {
-      error = p->append(&propertyEncoder.arrayEncoder, lightPayload);
-      if(error == CborNoError)
-        propertyEncoder.encoded_property_count++;
+      idx = property_container.nextDirty(idx);
+      if (idx >= property_container.size())
+        break;
+
+      if (property_container.at(idx)->getPriority() == Priority::High)
+      {
+        error = appendIfDiverged(propertyEncoder, idx, lightPayload);
+        if (error != CborNoError)
+          break;
+      }
+
+      idx++;
     }
-    if(error == CborNoError)
-      propertyEncoder.checked_property_count++;
+    propertyEncoder.priority_pass_end = idx;
+
+    /* A high priority property which does not fit into an empty message is
+     * left to the round-robin pass, which skips it as any other property.
+     */
+    if ((CborErrorOutOfMemory == error) && (propertyEncoder.encoded_property_count == 0))
+    {
+      propertyEncoder.priority_pass_enabled = false;
+      return EncoderState::OpenCBORContainer;
+    }
+  }
 
-    bool const maximum_number_of_properties_reached = (propertyEncoder.encoded_property_count >= propertyEncoder.encoded_property_limit) && (propertyEncoder.property_limit_active == true);
-    bool const cbor_encoder_error = (error != CborNoError);
+  size_t idx = propertyEncoder.current_property_index;
 
-    if (maximum_number_of_properties_reached || cbor_encoder_error)
+  while ((error == CborNoError) && (idx < property_container.size()))
+  {
+    /* Properties which are not dirty can not have diverged from the cloud,
+     * therefore they are skipped without evaluating them.
+     */
+    size_t const next_dirty_idx = property_container.nextDirty(idx);
+    propertyEncoder.checked_property_count += (next_dirty_idx - idx);
+    idx = next_dirty_idx;
+    if (idx >= property_container.size())
       break;
+
+    /* High priority properties have already been handled above */
+    bool const is_encoded_by_priority_pass = propertyEncoder.priority_pass_enabled && (property_container.at(idx)->getPriority() == Priority::High);
+    if (!is_encoded_by_priority_pass)
+      error = appendIfDiverged(propertyEncoder, idx, lightPayload);
+
+    if (error == CborNoError)
+      propertyEncoder.checked_property_count++;
+
+    idx++;
   }
 
+  /* A property which did not fit has been rolled back and starts the next message */
   if (CborErrorOutOfMemory == error)
     return EncoderState::OutOfMemory;
   else if (CborNoError == error)
     return EncoderState::CloseCBORContainer;
-  else if (CborErrorSplitItems == error)
-    return EncoderState::TrimAppend;
   else
     return EncoderState::Error;
 }
@@ -131,8 +212,13 @@ CBOREncoder::EncoderState CBOREncoder::handle_OutOfMemory(PropertyContainerEncod
 {
   if(propertyEncoder.encoded_property_count > 0)
     return EncoderState::CloseCBORContainer;
-  else
-    return EncoderState::SkipProperty;
+
+  /* Once more with the string value of the property spilled, it might fit then */
+  if (propertyEncoder.spill && !propertyEncoder.spill_armed) {
+    propertyEncoder.spill_armed = true;
+    return EncoderState::OpenCBORContainer;
+  }
+  return EncoderState::SkipProperty;
 }
 
 CBOREncoder::EncoderState CBOREncoder::handle_SkipProperty(PropertyContainerEncoder & propertyEncoder)
@@ -146,48 +232,27 @@ CBOREncoder::EncoderState CBOREncoder::handle_SkipProperty(PropertyContainerEnco
   return EncoderState::Error;
 }
 
-CBOREncoder::EncoderState CBOREncoder::handle_TrimAppend(PropertyContainerEncoder & propertyEncoder)
-{
-  /* Trim the number of properties to be included in the next message to avoid multivalue property split */
-  propertyEncoder.encoded_property_limit = propertyEncoder.encoded_property_count;
-  propertyEncoder.property_limit_active = true;
-  if(propertyEncoder.encoded_property_limit > 0)
-    return EncoderState::OpenCBORContainer;
-  else
-    return EncoderState::Error;
-}
-
 CBOREncoder::EncoderState CBOREncoder::handle_CloseCBORContainer(PropertyContainerEncoder & propertyEncoder)
 {
+  /* Release the byte reserved for the break byte */
+  if (propertyEncoder.break_reserved)
+    propertyEncoder.arrayEncoder.end += 1;
   CborError error = cbor_encoder_close_container(&propertyEncoder.encoder, &propertyEncoder.arrayEncoder);
   if (CborNoError != error)
-    return EncoderState::TrimClose;
+    return EncoderState::Error;
   else
     return EncoderState::FinishAppend;
 }
 
-CBOREncoder::EncoderState CBOREncoder::handle_TrimClose(PropertyContainerEncoder & propertyEncoder)
-{
-  /* Trim the number of properties to be included in the next message to avoid error closing container */
-  propertyEncoder.encoded_property_limit = propertyEncoder.encoded_property_count - 1;
-  propertyEncoder.property_limit_active = true;
-  if(propertyEncoder.encoded_property_limit > 0)
-    return EncoderState::OpenCBORContainer;
-  else
-    return EncoderState::Error;
-}
-
 CBOREncoder::EncoderState CBOREncoder::handle_FinishAppend(PropertyContainerEncoder & propertyEncoder)
 {
-  /* Restore property message limit to CBOR_ENCODER_NO_PROPERTIES_LIMIT */
-  propertyEncoder.property_limit_active = false;
-
-  /* The append process has been successful, so we don't need to try to send this properties set. Cleanup _has_been_appended_but_not_sended flag */
-  PropertyContainer::iterator iter = propertyEncoder.property_container.begin();
-  std::advance(iter, propertyEncoder.current_property_index);
+  /* The append process has been successful, so we don't need to try to send this properties set. Cleanup _has_been_appended_but_not_sended flag.
+   * When packing every appended property is part of the message and has been completed right away.
+   */
+  PropertyContainer::iterator iter = propertyEncoder.property_container.begin() + propertyEncoder.current_property_index;
   int num_appended_properties = 0;
 
-  for(; iter != propertyEncoder.property_container.end(); iter++)
+  for(; !propertyEncoder.packing && (iter != propertyEncoder.property_container.end()); iter++)
   {
     Property * p = * iter;
     if (num_appended_properties >= propertyEncoder.checked_property_count)
@@ -197,6 +262,17 @@ CBOREncoder::EncoderState CBOREncoder::handle_FinishAppend(PropertyContainerEnco
     num_appended_properties++;
   }
 
+  /* High priority properties are not part of the round-robin range */
+  if (propertyEncoder.priority_pass_enabled && !propertyEncoder.packing)
+  {
+    for (size_t idx = 0; idx < propertyEncoder.priority_pass_end; idx++)
+    {
+      Property * p = propertyEncoder.property_container.at(idx);
+      if (p->getPriority() == Priority::High)
+        p->appendCompleted();
+    }
+  }
+
   /* Advance property index for the next message */
   propertyEncoder.current_property_index += propertyEncoder.checked_property_count;
 
@@ -205,3 +281,106 @@ CBOREncoder::EncoderState CBOREncoder::handle_FinishAppend(PropertyContainerEnco
 
   return EncoderState::SendMessage;
 }
+
+CborError CBOREncoder::appendIfDiverged(PropertyContainerEncoder & propertyEncoder, size_t const idx, bool lightPayload)
+{
+  PropertyContainer & property_container = propertyEncoder.property_container;
+  Property * p = property_container.at(idx);
+
+  /* A property the cloud may write stays dirty until it is encoded without the restriction */
+  if (propertyEncoder.read_only && p->isWriteableByCloud())
+    return CborNoError;
+
+  if (p->isReadableByCloud() && p->shouldBeUpdated())
+  {
+    /* Snapshot of the encoder state to roll back a property which does not fit */
+    CborEncoder const array_encoder = propertyEncoder.arrayEncoder;
+    SenMLBaseValues const base_values = propertyEncoder.base_values;
+    SpilledString * const spill = propertyEncoder.spill_armed ? propertyEncoder.spill : nullptr;
+    SpilledString const spilled = spill ? *spill : SpilledString();
+
+    CborError const error = p->append(&propertyEncoder.arrayEncoder, lightPayload, propertyEncoder.timestamp, propertyEncoder.base_values_enabled ? &propertyEncoder.base_values : nullptr, spill);
+    if(error == CborNoError)
+    {
+      propertyEncoder.encoded_property_count++;
+      property_container.markAppended(idx);
+      /* A packed message may pass over properties, the appended ones are completed right away */
+      if (propertyEncoder.packing)
+        p->appendCompleted();
+    }
+    else if ((CborErrorOutOfMemory == error) || (CborErrorSplitItems == error))
+    {
+      propertyEncoder.arrayEncoder = array_encoder;
+      propertyEncoder.base_values = base_values;
+      if (spill)
+        *spill = spilled;
+      return CborErrorOutOfMemory;
+    }
+    return error;
+  }
+  else if (!p->requiresPolling())
+  {
+    property_container.clearDirty(idx);
+    /* Periodically published properties become dirty again once their interval expired */
+    if (p->isPublishedPeriodically())
+      property_container.scheduleDirty(idx, p->getPublishDeadline());
+    /* The last suppressed change is flushed on the trailing edge of the window */
+    else if (p->isHeldByRateLimit())
+      property_container.scheduleDirty(idx, p->getRateLimitDeadline());
+  }
+  return CborNoError;
+}
+
+CborError CBOREncoder::appendPacked(PropertyContainerEncoder & propertyEncoder, size_t idx, bool const high_priority, bool const normal_priority, bool lightPayload, size_t & resume_idx)
+{
+  PropertyContainer & property_container = propertyEncoder.property_container;
+  size_t candidates[AIOT_CONFIG_CBOR_PACKING_CANDIDATES];
+  size_t candidate_cnt = 0;
+
+  for (; candidate_cnt < AIOT_CONFIG_CBOR_PACKING_CANDIDATES; idx++)
+  {
+    idx = property_container.nextDirty(idx);
+    if (idx >= property_container.size())
+      break;
+    bool const is_high_priority = (property_container.at(idx)->getPriority() == Priority::High);
+    if (is_high_priority ? high_priority : normal_priority)
+      candidates[candidate_cnt++] = idx;
+  }
+
+  /* Largest first, a property which has not been encoded yet is taken as the
+   * largest. The order of equal ones is kept, i.e. the round-robin order.
+   */
+  auto sizeOf = [&property_container](size_t const i)
+  {
+    size_t const size = property_container.at(i)->getEncodedSize();
+    return (size > 0) ? size : SIZE_MAX;
+  };
+  for (size_t i = 1; i < candidate_cnt; i++)
+  {
+    size_t const candidate = candidates[i];
+    size_t const candidate_size = sizeOf(candidate);
+    size_t j = i;
+    for (; (j > 0) && (sizeOf(candidates[j - 1]) < candidate_size); j--)
+      candidates[j] = candidates[j - 1];
+    candidates[j] = candidate;
+  }
+
+  /* A property which has been skipped starts the next message, unless it
+   * does not even fit into an empty one and is passed over for good.
+   */
+  size_t first_skipped_idx = idx;
+  for (size_t i = 0; i < candidate_cnt; i++)
+  {
+    bool const is_message_empty = (propertyEncoder.encoded_property_count == 0);
+    CborError const error = appendIfDiverged(propertyEncoder, candidates[i], lightPayload);
+    if (CborErrorOutOfMemory == error)
+    {
+      if (!is_message_empty && (candidates[i] < first_skipped_idx))
+        first_skipped_idx = candidates[i];
+    }
+    else if (error != CborNoError)
+      return error;
+  }
+  resume_idx = first_skipped_idx;
+  return CborNoError;
+}
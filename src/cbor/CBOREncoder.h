@@ -24,14 +24,6 @@
 
 #include <Arduino.h>
 
-#ifdef __AVR__
-# include <Arduino_AVRSTL.h>
-#endif
-
-#undef max
-#undef min
-#include <list>
-
 #include "../property/PropertyContainer.h"
 
 /******************************************************************************
@@ -44,7 +36,14 @@ class CBOREncoder
 public:
     /* encode return > 0 if a property has changed and encodes the changed properties in CBOR format into the provided buffer */
     /* if lightPayload is true the integer identifier of the property will be encoded in the message instead of the property name in order to reduce the size of the message payload*/
-    static CborError encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload = false);
+    /* if timestamp is not 0 it is encoded as the time of every property, e.g. for samples recorded while offline */
+    /* if baseValues is true names and times are encoded relative to a SenML base name and base time to reduce the size of the message payload */
+    /* if packing is true the properties are appended largest first, by the size they were last encoded with, and those which do not fit into the remaining buffer are skipped instead of closing the message, so that smaller ones still fill the payload */
+    /* if readOnly is true only properties which are not writeable by the cloud are encoded, all others remain pending */
+    /* if spill is not nullptr a property which does not fit into an empty message is encoded with its string value spilled, see SpilledString */
+    static CborError encode(PropertyContainer & property_container, uint8_t * data, size_t const size, int & bytes_encoded, unsigned int & current_property_index, bool lightPayload = false, unsigned long const timestamp = 0, bool baseValues = false, bool packing = false, bool readOnly = false, SpilledString * spill = nullptr);
+    /* Encodes the header of a text string of the given length, e.g. of a spilled one, into at most 5 bytes */
+    static size_t encodeTextStringHeader(uint8_t * data, size_t const length);
 
 private:
 
@@ -58,9 +57,7 @@ private:
     TryAppend,
     OutOfMemory,
     SkipProperty,
-    TrimAppend,
     CloseCBORContainer,
-    TrimClose,
     FinishAppend,
     SendMessage,
     Error
@@ -73,8 +70,20 @@ private:
     unsigned int & current_property_index;
     int encoded_property_count;
     int checked_property_count;
-    int encoded_property_limit;
-    bool property_limit_active;
+    /* High priority properties are encoded ahead of the round-robin pass, the
+     * ones before priority_pass_end are part of the current message.
+     */
+    bool priority_pass_enabled;
+    size_t priority_pass_end;
+    unsigned long timestamp;
+    bool base_values_enabled;
+    bool packing;
+    bool read_only;
+    /* The break byte closing the array is reserved up front */
+    bool break_reserved;
+    SpilledString * spill;
+    bool spill_armed;
+    SenMLBaseValues base_values;
     CborEncoder encoder;
     CborEncoder arrayEncoder;
   };
@@ -84,12 +93,16 @@ private:
   static EncoderState handle_TryAppend(PropertyContainerEncoder & propertyEncoder, bool  & lightPayload);
   static EncoderState handle_OutOfMemory(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_SkipProperty(PropertyContainerEncoder & propertyEncoder);
-  static EncoderState handle_TrimAppend(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_CloseCBORContainer(PropertyContainerEncoder & propertyEncoder);
-  static EncoderState handle_TrimClose(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_FinishAppend(PropertyContainerEncoder & propertyEncoder);
   static EncoderState handle_AdvancePropertyContainer(PropertyContainerEncoder & propertyEncoder);
 
+  static CborError appendIfDiverged(PropertyContainerEncoder & propertyEncoder, size_t const idx, bool lightPayload);
+  /* First-fit decreasing of the dirty properties from idx on, of the given
+   * priorities. resume_idx is set to the first one left to the next message.
+   */
+  static CborError appendPacked(PropertyContainerEncoder & propertyEncoder, size_t idx, bool const high_priority, bool const normal_priority, bool lightPayload, size_t & resume_idx);
+
 };
 
 #endif /* ARDUINO_CBOR_CBOR_ENCODER_H_ */
@@ -0,0 +1,98 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_PROPERTY_AGGREGATION_H_
+#define ARDUINO_PROPERTY_AGGREGATION_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stdint.h>
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
+
+enum class Aggregation : uint8_t {
+  Last, Mean, Min, Max
+};
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Incrementally aggregates the samples of a publishing window in constant
+ * memory. SumT accumulates the samples for the mean and has to be wider
+ * than T so that a window of many samples does not overflow or lose
+ * precision. The mean of integral samples is truncated towards zero.
+ */
+template <typename T, typename SumT>
+class Aggregator
+{
+  public:
+    Aggregator(Aggregation const aggregation)
+    : _aggregation{aggregation}
+    , _count{0}
+    , _sum{0}
+    , _min{0}
+    , _max{0}
+    , _last{0}
+    { }
+
+    void add(T const sample)
+    {
+      if (_count == 0) {
+        _sum = 0;
+        _min = sample;
+        _max = sample;
+      } else {
+        if (sample < _min) _min = sample;
+        if (sample > _max) _max = sample;
+      }
+      _sum += sample;
+      _last = sample;
+      _count++;
+    }
+
+    /* Returns the aggregate of all samples added since the last reset */
+    T value() const
+    {
+      switch (_aggregation)
+      {
+        case Aggregation::Mean: return static_cast<T>(_sum / static_cast<SumT>(_count));
+        case Aggregation::Min:  return _min;
+        case Aggregation::Max:  return _max;
+        case Aggregation::Last:
+        default:                return _last;
+      }
+    }
+
+    inline bool     empty() const { return _count == 0; }
+    inline uint32_t count() const { return _count; }
+    inline void     reset()       { _count = 0; }
+
+  private:
+    Aggregation _aggregation;
+    uint32_t    _count;
+    SumT        _sum;
+    T           _min,
+                _max,
+                _last;
+};
+
+#endif /* ARDUINO_PROPERTY_AGGREGATION_H_ */
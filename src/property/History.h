@@ -0,0 +1,95 @@
+//
+// This file is part of ArduinoCloudThing
+//
+// Copyright 2024 ARDUINO SA (http://www.arduino.cc/)
+//
+// This software is released under the GNU General Public License version 3,
+// which covers the main part of ArduinoCloudThing.
+// The terms of this license can be found at:
+// https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// You can be released from the requirements of the above licenses by purchasing
+// a commercial license. Buying such a license is mandatory if you want to modify or
+// otherwise use the software for commercial activities involving the Arduino
+// software without disclosing the source code of your own applications. To purchase
+// a commercial license, send an email to license@arduino.cc.
+//
+
+#ifndef ARDUINO_PROPERTY_HISTORY_H_
+#define ARDUINO_PROPERTY_HISTORY_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../utility/memory/StaticArena.h"
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Ring of the last depth timestamped values of a property which have not
+ * been sent yet. The oldest value is overwritten once the ring is full.
+ * The samples are allocated along with the ring, a depth of 0 or a failed
+ * allocation leaves a ring which never holds anything.
+ */
+template <typename T>
+class History
+{
+  public:
+    History(size_t const depth)
+    : _sample{static_cast<Sample *>(depth ? arenaAlloc(depth * sizeof(Sample)) : nullptr)}
+    , _depth{_sample ? depth : 0}
+    , _head{0}
+    , _count{0}
+    { }
+
+    ~History()
+    {
+      if (_sample)
+        arenaFree(_sample);
+    }
+
+    History(History const &) = delete;
+    History & operator=(History const &) = delete;
+
+    void add(T const value, uint64_t const time_ms)
+    {
+      if (_depth == 0)
+        return;
+      Sample & sample = _sample[(_head + _count) % _depth];
+      sample.value = value;
+      sample.time_ms = time_ms;
+      if (_count < _depth)
+        _count++;
+      else
+        _head = (_head + 1) % _depth;
+    }
+
+    /* Returns the i-th oldest value and the time it was taken in milliseconds */
+    inline T        value     (size_t const i) const { return _sample[(_head + i) % _depth].value; }
+    inline uint64_t timeMillis(size_t const i) const { return _sample[(_head + i) % _depth].time_ms; }
+    inline T        last      () const { return value(_count - 1); }
+
+    inline size_t   size () const { return _count; }
+    inline size_t   depth() const { return _depth; }
+    inline bool     empty() const { return _count == 0; }
+    inline void     reset()       { _head = 0; _count = 0; }
+
+  private:
+    struct Sample
+    {
+      uint64_t time_ms;
+      T        value;
+    };
+
+    Sample * _sample;
+    size_t   _depth,
+             _head,
+             _count;
+};
+
+#endif /* ARDUINO_PROPERTY_HISTORY_H_ */
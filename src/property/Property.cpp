@@ -16,6 +16,12 @@
 //
 
 #include "Property.h"
+#include "PropertyContainer.h"
+#include "../utility/memory/StaticArena.h"
+#if AIOT_CONFIG_COMPRESSION_ENABLED
+  #include "../utility/compress/LZSSBlock.h"
+  #include "../utility/memory/ScratchPool.h"
+#endif
 
 #undef max
 #undef min
@@ -25,32 +31,95 @@
    CTOR/DTOR
  ******************************************************************************/
 Property::Property()
-: _name{""}
-, _min_delta_property{0.0f}
+: _min_delta_property{0.0f}
+, _min_delta_integral{0}
 , _min_time_between_updates_millis{DEFAULT_MIN_TIME_BETWEEN_UPDATES_MILLIS}
-, _permission{Permission::Read}
+, _name{""}
+, _extras{nullptr}
 , _get_time_func{nullptr}
-, _update_callback_func{nullptr}
-, _on_sync_callback_func{nullptr}
+, _permission{Permission::Read}
 , _update_policy{UpdatePolicy::OnChange}
+, _is_name_owned{false}
 , _has_been_updated_once{false}
 , _has_been_modified_in_callback{false}
 , _has_been_appended_but_not_sended{false}
-, _last_updated_millis{0}
-, _update_interval_millis{0}
-, _last_local_change_timestamp{0}
-, _last_cloud_change_timestamp{0}
-, _identifier{0}
-, _attributeIdentifier{0}
-, _lightPayload{false}
 , _update_requested{false}
 , _encode_timestamp{false}
+, _encode_compact_float{false}
 , _echo_requested{false}
-, _timestamp{0}
+, _is_change_detection_manual{false}
+, _is_high_priority{false}
+, _is_confirmed{false}
+, _has_deadband{false}
+, _encode_compressed{false}
+, _last_updated_millis{0}
+, _identifier{0}
+, _attribute_keys{""}
+, _container{nullptr}
+, _container_position{0}
+, _scheduled_deadline{0}
+, _encoded_size{0}
+{
+
+}
+
+Property::Property(Property const & other)
+: Property()
+{
+  *this = other;
+}
+
+Property & Property::operator=(Property const & other)
 {
+  if (this == &other)
+    return (*this);
+
+  _min_delta_property = other._min_delta_property;
+  _min_delta_integral = other._min_delta_integral;
+  _min_time_between_updates_millis = other._min_time_between_updates_millis;
+  setName(other._name, other._is_name_owned);
+  if (other._extras) {
+    extras() = *other._extras;
+  } else {
+    arenaDelete(_extras);
+    _extras = nullptr;
+  }
+  _get_time_func = other._get_time_func;
+  _permission = other._permission;
+  _update_policy = other._update_policy;
+  _has_been_updated_once = other._has_been_updated_once;
+  _has_been_modified_in_callback = other._has_been_modified_in_callback;
+  _has_been_appended_but_not_sended = other._has_been_appended_but_not_sended;
+  _update_requested = other._update_requested;
+  _encode_timestamp = other._encode_timestamp;
+  _encode_compact_float = other._encode_compact_float;
+  _echo_requested = other._echo_requested;
+  _is_change_detection_manual = other._is_change_detection_manual;
+  _is_high_priority = other._is_high_priority;
+  _is_confirmed = other._is_confirmed;
+  _has_deadband = other._has_deadband;
+  _encode_compressed = other._encode_compressed;
+  _last_updated_millis = other._last_updated_millis;
+  _identifier = other._identifier;
+  _attribute_keys = other._attribute_keys;
+  _container = other._container;
+  _container_position = other._container_position;
+  _scheduled_deadline = other._scheduled_deadline;
+  _encoded_size = other._encoded_size;
+  return (*this);
+}
 
+Property::~Property()
+{
+  setName("", false);
+  arenaDelete(_extras);
 }
 
+Property::Cursor Property::_cursor;
+DeferCallbackFunc Property::_defer_callback_func = nullptr;
+GetTimeMillisCallbackFunc Property::_get_time_millis_func = nullptr;
+CommandLatencyFunc Property::_command_latency_func = nullptr;
+
 /******************************************************************************
    CONST
  ******************************************************************************/
@@ -62,37 +131,74 @@ namespace PropertyActions
 /******************************************************************************
    PUBLIC MEMBER FUNCTIONS
  ******************************************************************************/
-void Property::init(String const name, Permission const permission, GetTimeCallbackFunc func) {
-  _name = name;
+void Property::init(char const * name, Permission const permission, GetTimeCallbackFunc func) {
+  setName(name, true);
+  init(LiteralName(_name), permission, func);
+}
+
+void Property::init(String const & name, Permission const permission, GetTimeCallbackFunc func) {
+  init(name.c_str(), permission, func);
+}
+
+void Property::init(LiteralName const name, Permission const permission, GetTimeCallbackFunc func) {
+  /* A name copied by init(char const *) is kept, setName() skips the same name */
+  setName(name.str, false);
   _permission = permission;
   _get_time_func = func;
+
+  /* Build the complete keys of all attributes once instead of concatenating
+   * them whenever the property is encoded. No data is encoded meanwhile.
+   */
+  _attribute_keys = "";
+  _cursor.attribute_identifier = 0;
+  _cursor.collect_attribute_keys = true;
+  appendAttributesToCloud(nullptr);
+  _cursor.collect_attribute_keys = false;
 }
 
 Property & Property::onUpdate(UpdateCallbackFunc func) {
-  _update_callback_func = func;
+  if (_extras || func)
+    extras().update_callback_func = func;
   return (*this);
 }
 
 Property & Property::onSync(OnSyncCallbackFunc func) {
-  _on_sync_callback_func = func;
+  if (_extras || func)
+    extras().on_sync_callback_func = func;
   return (*this);
 }
 
 Property & Property::publishOnChange(float const min_delta_property, unsigned long const min_time_between_updates_millis) {
   _update_policy = UpdatePolicy::OnChange;
   _min_delta_property = min_delta_property;
+  _min_delta_integral = toIntegralDelta(min_delta_property);
+  _has_deadband = false;
   _min_time_between_updates_millis = min_time_between_updates_millis;
+  markDirty();
+  return (*this);
+}
+
+Property & Property::publishOutsideDeadband(float const falling_delta, float const rising_delta, unsigned long const min_time_between_updates_millis) {
+  publishOnChange(rising_delta, min_time_between_updates_millis);
+  if (falling_delta != rising_delta) {
+    extras().min_falling_delta = falling_delta;
+    extras().min_falling_delta_integral = toIntegralDelta(falling_delta);
+    _has_deadband = true;
+  }
   return (*this);
 }
 
 Property & Property::publishEvery(unsigned long const seconds) {
   _update_policy = UpdatePolicy::TimeInterval;
-  _update_interval_millis = (seconds * 1000);
+  if (_extras || seconds)
+    extras().update_interval_millis = (seconds * 1000);
+  markDirty();
   return (*this);
 }
 
 Property & Property::publishOnDemand() {
   _update_policy = UpdatePolicy::OnDemand;
+  markDirty();
   return (*this);
 }
 
@@ -102,9 +208,84 @@ Property & Property::encodeTimestamp()
   return (*this);
 }
 
+Property & Property::encodeCompactFloat()
+{
+  _encode_compact_float = true;
+  return (*this);
+}
+
+Property & Property::encodeCompressed()
+{
+  _encode_compressed = true;
+  return (*this);
+}
+
+Property & Property::priority(Priority const priority)
+{
+  _is_high_priority = (priority == Priority::High);
+  return (*this);
+}
+
+Property & Property::reliability(Reliability const reliability)
+{
+  _is_confirmed = (reliability == Reliability::Confirmed);
+  if (_is_confirmed) {
+    _is_high_priority = true;
+  }
+  return (*this);
+}
+
+Property & Property::manualChangeDetection()
+{
+  _is_change_detection_manual = true;
+  if (_container) {
+    _container->excludeFromChangeScan(_container_position);
+  }
+  return (*this);
+}
+
+void Property::markChanged()
+{
+  if (isReadableByCloud()) {
+    updateLocalTimestamp();
+  }
+}
+
+Property & Property::acceptUpdatesFromISR()
+{
+  extras().accepts_isr_updates = true;
+  return (*this);
+}
+
+void Property::applyUpdatesFromISR()
+{
+  if (!_extras || !_extras->accepts_isr_updates)
+    return;
+
+  Extras & e = *_extras;
+  uint8_t  seq = 0;
+  int32_t  value = 0;
+  uint32_t sum = 0;
+  /* An interrupt in between changes the sequence or the sum, then read again */
+  do {
+    seq = e.isr_value_seq;
+    value = e.isr_value;
+    sum = e.isr_delta_sum;
+  } while ((seq != e.isr_value_seq) || (sum != e.isr_delta_sum));
+
+  bool const is_set = (seq != e.isr_value_seq_applied);
+  int32_t const delta = static_cast<int32_t>(sum - e.isr_delta_sum_applied);
+  e.isr_value_seq_applied = seq;
+  e.isr_delta_sum_applied = sum;
+  if (is_set || (delta != 0)) {
+    mergeFromISR(is_set, value, delta);
+  }
+}
+
 void Property::setTimestamp(unsigned long const timestamp)
 {
-  _timestamp = timestamp;
+  if (_extras || timestamp)
+    extras().timestamp = timestamp;
 }
 
 bool Property::shouldBeUpdated() {
@@ -125,9 +306,13 @@ bool Property::shouldBeUpdated() {
   }
 
   if (_update_policy == UpdatePolicy::OnChange) {
+    PropertyGroup const * const group = getGroup();
+    if (group && group->isHeld(millis())) {
+      return false;
+    }
     return (isDifferentFromCloud() && ((millis() - _last_updated_millis) >= (_min_time_between_updates_millis)));
   } else if (_update_policy == UpdatePolicy::TimeInterval) {
-    return ((millis() - _last_updated_millis) >= _update_interval_millis);
+    return ((millis() - _last_updated_millis) >= (_extras ? _extras->update_interval_millis : 0));
   } else if (_update_policy == UpdatePolicy::OnDemand) {
     return _update_requested;
   } else {
@@ -135,14 +320,66 @@ bool Property::shouldBeUpdated() {
   }
 }
 
+unsigned long Property::millisUntilDue(unsigned long const now) {
+  if (!isReadableByCloud()) {
+    return ULONG_MAX;
+  }
+
+  if (!_has_been_updated_once || _has_been_appended_but_not_sended || _has_been_modified_in_callback || _echo_requested) {
+    return 0;
+  }
+
+  unsigned long const elapsed = now - _last_updated_millis;
+  unsigned long interval = 0;
+  if (_update_policy == UpdatePolicy::OnChange) {
+    if (!isDifferentFromCloud()) {
+      return ULONG_MAX;
+    }
+    interval = _min_time_between_updates_millis;
+    PropertyGroup const * const group = getGroup();
+    if (group && group->isHeld(now)) {
+      unsigned long const group_wait = group->getRateLimitDeadline() - now;
+      unsigned long const wait = (elapsed >= interval) ? 0 : (interval - elapsed);
+      return std::max(wait, group_wait);
+    }
+  } else if (_update_policy == UpdatePolicy::TimeInterval) {
+    interval = _extras ? _extras->update_interval_millis : 0;
+  } else {
+    return _update_requested ? 0 : ULONG_MAX;
+  }
+  return (elapsed >= interval) ? 0 : (interval - elapsed);
+}
+
 void Property::requestUpdate()
 {
   _update_requested = true;
+  markDirty();
 }
 
 void Property::provideEcho()
 {
   _echo_requested = true;
+  markDirty();
+}
+
+unsigned long Property::getRateLimitDeadline() const
+{
+  unsigned long const deadline = _last_updated_millis + _min_time_between_updates_millis;
+  PropertyGroup const * const group = getGroup();
+  if (group && group->isHeld(millis())) {
+    /* Whichever is later, compared relative to now as the millis() wrap around */
+    unsigned long const now = millis();
+    unsigned long const group_deadline = group->getRateLimitDeadline();
+    return (static_cast<long>(group_deadline - now) > static_cast<long>(deadline - now)) ? group_deadline : deadline;
+  }
+  return deadline;
+}
+
+void Property::setGroup(PropertyGroup * group)
+{
+  if (!getGroup()) {
+    extras().group = group;
+  }
 }
 
 void Property::appendCompleted()
@@ -153,24 +390,102 @@ void Property::appendCompleted()
 }
 
 void Property::execCallbackOnChange() {
-  if (_update_callback_func != nullptr) {
-    _update_callback_func();
+#if AIOT_CONFIG_RULES_ENABLED
+  markChangedForRules();
+#endif
+  if (_defer_callback_func && _defer_callback_func(*this, false)) {
+    return;
+  }
+  execDeferredCallback(false);
+}
+
+void Property::execCallbackOnSync() {
+  if (_defer_callback_func && _defer_callback_func(*this, true)) {
+    return;
+  }
+  execDeferredCallback(true);
+}
+
+bool Property::markSyncPending() {
+  if (!_container) {
+    return false;
+  }
+  _container->markSyncPending(_container_position);
+  return true;
+}
+
+void Property::execDeferredCallback(bool const is_sync) {
+  if (is_sync) {
+    if (_extras && _extras->on_sync_callback_func != nullptr) {
+      _extras->on_sync_callback_func(*this);
+    }
+    return;
+  }
+  if (_extras && _extras->update_callback_func != nullptr) {
+    _extras->update_callback_func();
+  }
+  if (_extras && _extras->is_command_pending) {
+    _extras->is_command_pending = false;
+    if (_command_latency_func) {
+      _command_latency_func(_extras->command_cloud_to_device_ms, micros() - _extras->command_received_us);
+    }
   }
   if (isDifferentFromCloud()) {
     _has_been_modified_in_callback = true;
+    markDirty();
   }
 }
 
-void Property::execCallbackOnSync() {
-  if (_on_sync_callback_func != nullptr) {
-    _on_sync_callback_func(*this);
+void Property::setDeferCallbackFunc(DeferCallbackFunc func) {
+  _defer_callback_func = func;
+}
+
+void Property::setTimeMillisFunc(GetTimeMillisCallbackFunc func) {
+  _get_time_millis_func = func;
+}
+
+void Property::setCommandLatencyFunc(CommandLatencyFunc func) {
+  _command_latency_func = func;
+}
+
+void Property::onCloudChangeReceived() {
+  if (!_command_latency_func) {
+    return;
+  }
+  Extras & e = extras();
+  e.is_command_pending = true;
+  e.command_received_us = micros();
+  /* The cloud timestamps its changes with whole seconds, a clock behind the one of the cloud reads as no latency */
+  uint64_t const cloud_ms = static_cast<uint64_t>(e.last_cloud_change_timestamp) * 1000ULL;
+  uint64_t const now_ms = currentTimeMillis();
+  if (e.last_cloud_change_timestamp == 0) {
+    e.command_cloud_to_device_ms = ULONG_MAX;
+  } else {
+    e.command_cloud_to_device_ms = (now_ms > cloud_ms) ? static_cast<unsigned long>(now_ms - cloud_ms) : 0;
   }
 }
 
-CborError Property::append(CborEncoder *encoder, bool lightPayload) {
-  _lightPayload = lightPayload;
-  _attributeIdentifier = 0;
-  CHECK_CBOR(appendAttributesToCloud(encoder));
+CborError Property::append(CborEncoder *encoder, bool lightPayload, unsigned long const timestamp, SenMLBaseValues * base_values, SpilledString * spill) {
+  _cursor.light_payload = lightPayload;
+  _cursor.spill = spill;
+  _cursor.append_timestamp = timestamp;
+  _cursor.record_time_ms = 0;
+  _cursor.base_values = base_values;
+  _cursor.attribute_identifier = 0;
+  _cursor.attribute_key_offset = 0;
+#if AIOT_CONFIG_ATTRIBUTE_DELTA_ENABLED
+  /* Once the cloud holds the value a change is sent as the changed attributes,
+   * the cloud merges them. Echoes and requested updates carry all of them.
+   */
+  _cursor.changed_attributes_only = _has_been_updated_once && !_echo_requested && !_update_requested && isDifferentFromCloud();
+#endif
+  uint8_t const * const begin = encoder->data.ptr;
+  CborError const err = appendAttributesToCloud(encoder);
+  _cursor.changed_attributes_only = false;
+  _cursor.spill = nullptr;
+  CHECK_CBOR(err);
+  size_t const encoded_size = encoder->data.ptr - begin;
+  _encoded_size = (encoded_size < UINT16_MAX) ? static_cast<uint16_t>(encoded_size) : UINT16_MAX;
   fromLocalToCloud();
   _has_been_updated_once = true;
   _has_been_modified_in_callback = false;
@@ -178,10 +493,25 @@ CborError Property::append(CborEncoder *encoder, bool lightPayload) {
   _echo_requested = false;
   _has_been_appended_but_not_sended = true;
   _last_updated_millis = millis();
+  if (_extras && _extras->group) {
+    _extras->group->onPublished(_last_updated_millis);
+  }
   return CborNoError;
 }
 
-CborError Property::appendAttribute(bool value, String attributeName, CborEncoder *encoder) {
+CborError Property::appendSnapshot(CborEncoder * encoder) {
+  _cursor.light_payload = false;
+  _cursor.spill = nullptr;
+  _cursor.append_timestamp = 0;
+  _cursor.record_time_ms = 0;
+  _cursor.base_values = nullptr;
+  _cursor.attribute_identifier = 0;
+  _cursor.attribute_key_offset = 0;
+  _cursor.changed_attributes_only = false;
+  return appendAttributesToCloud(encoder);
+}
+
+CborError Property::appendAttribute(bool value, char const * attributeName, CborEncoder *encoder) {
   return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
   {
     CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::BooleanValue)));
@@ -190,7 +520,7 @@ CborError Property::appendAttribute(bool value, String attributeName, CborEncode
   }, encoder);
 }
 
-CborError Property::appendAttribute(int value, String attributeName, CborEncoder *encoder) {
+CborError Property::appendAttribute(int value, char const * attributeName, CborEncoder *encoder) {
   return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
   {
     CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
@@ -199,7 +529,7 @@ CborError Property::appendAttribute(int value, String attributeName, CborEncoder
   }, encoder);
 }
 
-CborError Property::appendAttribute(unsigned int value, String attributeName, CborEncoder *encoder) {
+CborError Property::appendAttribute(unsigned int value, char const * attributeName, CborEncoder *encoder) {
   return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
   {
     CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
@@ -208,180 +538,529 @@ CborError Property::appendAttribute(unsigned int value, String attributeName, Cb
   }, encoder);
 }
 
-CborError Property::appendAttribute(float value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+CborError Property::appendAttribute(float value, char const * attributeName, CborEncoder *encoder) {
+  return appendAttributeName(attributeName, [this, value](CborEncoder & mapEncoder)
   {
     CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Value)));
+    if (_encode_compact_float)
+      return encodeCompactFloat(mapEncoder, value, _min_delta_property);
     CHECK_CBOR(cbor_encode_float(&mapEncoder, value));
     return CborNoError;
   }, encoder);
 }
 
-CborError Property::appendAttribute(String value, String attributeName, CborEncoder *encoder) {
-  return appendAttributeName(attributeName, [value](CborEncoder & mapEncoder)
+CborError Property::appendAttribute(String const & value, char const * attributeName, CborEncoder *encoder) {
+#if AIOT_CONFIG_COMPRESSION_ENABLED
+  CborError err = CborNoError;
+  if (appendCompressedAttribute(reinterpret_cast<uint8_t const *>(value.c_str()), value.length(), attributeName, encoder, err)) {
+    return err;
+  }
+#endif
+  return appendAttributeName(attributeName, [this, &value](CborEncoder & mapEncoder)
   {
     CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::StringValue)));
-    CHECK_CBOR(cbor_encode_text_stringz(&mapEncoder, value.c_str()));
+    SpilledString * const spill = _cursor.spill;
+    if (spill && (spill->data == nullptr)) {
+      spill->property = this;
+      spill->placeholder = mapEncoder.data.ptr;
+      spill->data = value.c_str();
+      spill->length = value.length();
+      return cbor_encode_text_string(&mapEncoder, "", 0);
+    }
+    CHECK_CBOR(cbor_encode_text_string(&mapEncoder, value.c_str(), value.length()));
     return CborNoError;
   }, encoder);
 }
 
-#ifdef __AVR__
-CborError Property::appendAttributeName(String attributeName, nonstd::function<CborError (CborEncoder& mapEncoder)>appendValue, CborEncoder *encoder)
-#else
-CborError Property::appendAttributeName(String attributeName, std::function<CborError (CborEncoder& mapEncoder)>appendValue, CborEncoder *encoder)
+#if AIOT_CONFIG_COMPRESSION_ENABLED
+bool Property::appendCompressedAttribute(uint8_t const * data, size_t const length, char const * attributeName, CborEncoder * encoder, CborError & err) {
+  if (!encoder || !_encode_compressed || (length < AIOT_CONFIG_COMPRESSION_MIN_LENGTH)) {
+    return false;
+  }
+  /* The value is sent as it is while the scratch pool is leased, e.g. when
+   * it is encoded from within a callback of the decoder.
+   */
+  ScratchLease const lease(AIOT_CONFIG_COMPRESSION_BUFFER_SIZE);
+  if (!lease) {
+    return false;
+  }
+  /* The compressed value has to be shorter */
+  uint8_t * const compressed = lease.data();
+  size_t const size = std::min(lease.size(), length - 1);
+  size_t const compressed_len = LZSSBlock::compress(data, length, compressed, size);
+  if (compressed_len == 0) {
+    return false;
+  }
+
+  _cursor.content_encoding = ContentEncoding::LZSS;
+  err = appendAttributeName(attributeName, [compressed, compressed_len](CborEncoder & mapEncoder)
+  {
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::DataValue)));
+    CHECK_CBOR(cbor_encode_byte_string(&mapEncoder, compressed, compressed_len));
+    return CborNoError;
+  }, encoder);
+  _cursor.content_encoding = ContentEncoding::None;
+  return true;
+}
 #endif
+
+CborError Property::encodeTime(CborEncoder & encoder, int64_t const time_ms)
+{
+  /* Whole seconds are encoded as before, as an integer */
+  if ((time_ms % 1000) == 0)
+    return cbor_encode_int(&encoder, time_ms / 1000);
+  return cbor_encode_double(&encoder, static_cast<double>(time_ms) / 1000.0);
+}
+
+CborError Property::encodeCompactFloat(CborEncoder & encoder, float const value, float const tolerance)
+{
+  /* Values which are not finite are left to the regular float encoding */
+  if (!isfinite(value))
+    return cbor_encode_float(&encoder, value);
+
+  /* An integer takes between 1 and 5 bytes, depending on its magnitude */
+  float const integral = roundf(value);
+  if ((fabsf(integral) < 2147483648.0f) && (fabsf(integral - value) <= tolerance))
+    return cbor_encode_int(&encoder, static_cast<int64_t>(integral));
+
+  /* A half-float takes 3 bytes instead of 5 */
+  uint16_t half_val = 0;
+  if (convertFloatToCborHalfFloat(value, tolerance, half_val))
+    return cbor_encode_half_float(&encoder, &half_val);
+
+  return cbor_encode_float(&encoder, value);
+}
+
+/* Inverse of CBORDecoder::convertCborHalfFloatToDouble, returns false if the
+ * rounded value is out of range or differs from value by more than tolerance.
+ */
+bool Property::convertFloatToCborHalfFloat(float const value, float const tolerance, uint16_t & half_val)
+{
+  float const abs_val = fabsf(value);
+  int exp = 0;
+  int mant = 0;
+  frexpf(abs_val, &exp);
+
+  if (abs_val == 0.0f) {
+    half_val = (value < 0.0f) ? 0x8000 : 0;
+    return true;
+  }
+  /* Half-floats have an exponent range of [-14, 15] for normal values */
+  if (exp > 16)
+    return false;
+  if (exp < -13) {
+    /* Subnormal, rounding up to 1024 yields the smallest normal value */
+    mant = static_cast<int>(roundf(ldexpf(abs_val, 24)));
+    half_val = static_cast<uint16_t>(mant);
+  } else {
+    mant = static_cast<int>(roundf(ldexpf(abs_val, 11 - exp))) - 1024;
+    if (mant == 1024) {
+      mant = 0;
+      exp++;
+    }
+    if (exp > 16)
+      return false;
+    half_val = static_cast<uint16_t>(((exp + 14) << 10) | mant);
+  }
+
+  float const rounded = (half_val < 1024) ? ldexpf(half_val, -24) : ldexpf((half_val & 0x3FF) + 1024, (half_val >> 10) - 25);
+  if (fabsf(rounded - abs_val) > tolerance)
+    return false;
+
+  if (value < 0.0f)
+    half_val |= 0x8000;
+  return true;
+}
+
+bool Property::prepareAttribute(char const * attributeName)
+{
+  bool const has_attribute_name = (attributeName[0] != '\0');
+  if (has_attribute_name) {
+    // when the attribute name string is not empty, the attribute identifier is incremented in order to be encoded in the message if the light payload flag is set
+    _cursor.attribute_identifier++;
+  }
+  if (_cursor.collect_attribute_keys) {
+    if (has_attribute_name) {
+      _attribute_keys += _name;
+      _attribute_keys += ":";
+      _attribute_keys += attributeName;
+      _attribute_keys += ",";
+    }
+    return false;
+  }
+  return true;
+}
+
+CborError Property::skipAttribute(char const * attributeName)
+{
+  /* The identifier and the cached key of the attribute are consumed nonetheless */
+  if (prepareAttribute(attributeName)) {
+    nextAttributeKey();
+  }
+  return CborNoError;
+}
+
+CborError Property::beginAttribute(char const * attributeName, CborEncoder * encoder, CborEncoder & mapEncoder)
 {
-  if (attributeName != "") {
-    // when the attribute name string is not empty, the attribute identifier is incremented in order to be encoded in the message if the _lightPayload flag is set
-    _attributeIdentifier++;
+  bool const has_attribute_name = (attributeName[0] != '\0');
+  bool const encode_timestamp = _encode_timestamp || (_cursor.append_timestamp != 0) || (_cursor.record_time_ms != 0);
+  uint64_t const timestamp_ms = (_cursor.record_time_ms != 0) ? _cursor.record_time_ms :
+                                (_cursor.append_timestamp != 0) ? _cursor.append_timestamp * 1000ULL : (_extras ? _extras->timestamp * 1000ULL : 0);
+
+  /* Determine the complete name of the record */
+  CborStringView name;
+  String completeName;
+  if (!has_attribute_name) {
+    name = CborStringView(_name);
+  } else {
+    name = nextAttributeKey();
+    if (name.empty()) {
+      completeName = String(_name) + ":" + attributeName;
+      name = CborStringView(completeName);
+    }
+  }
+
+  /* With SenML base values the name is encoded relative to the base name,
+   * which is set to the "name:" prefix of composite properties, and the
+   * time relative to the base time set by the first timestamped record.
+   */
+  bool encode_base_name = false, encode_base_time = false;
+  CborStringView base_name;
+  _cursor.encode_time_entry = encode_timestamp;
+  _cursor.time_entry_ms = static_cast<int64_t>(timestamp_ms);
+  SenMLBaseValues * const base_values = _cursor.base_values;
+  if (base_values)
+  {
+    if (!_cursor.light_payload) {
+      /* Only a cached name outlives this record and can serve as base name */
+      base_name = (has_attribute_name && completeName.length() == 0) ? name.substr(0, strlen(_name) + 1) : CborStringView();
+      /* Otherwise the name of the group, provided the name of the record starts with it */
+      PropertyGroup const * const group = getGroup();
+      if (base_name.empty() && group && group->name()) {
+        CborStringView const group_name(group->name());
+        if ((name.length() > group_name.length()) && (name.substr(0, group_name.length()) == group_name)) {
+          base_name = group_name;
+        }
+      }
+      encode_base_name = (base_name != base_values->base_name);
+      base_values->base_name = base_name;
+      name = name.substr(base_name.length());
+    }
+    if (encode_timestamp) {
+      if (!base_values->has_base_time) {
+        base_values->has_base_time = true;
+        base_values->base_time_ms = timestamp_ms;
+        encode_base_time = true;
+      }
+      _cursor.time_entry_ms = static_cast<int64_t>(timestamp_ms) - static_cast<int64_t>(base_values->base_time_ms);
+      _cursor.encode_time_entry = (_cursor.time_entry_ms != 0);
+    }
   }
-  CborEncoder mapEncoder;
-  unsigned int num_map_properties = _encode_timestamp ? 3 : 2;
+
+  bool const encode_content_encoding = (_cursor.content_encoding != ContentEncoding::None);
+  unsigned int num_map_properties = 2 + (_cursor.encode_time_entry ? 1 : 0) + (encode_base_name ? 1 : 0) + (encode_base_time ? 1 : 0) + (encode_content_encoding ? 1 : 0);
   CHECK_CBOR(cbor_encoder_create_map(encoder, &mapEncoder, num_map_properties));
+  if (encode_base_name) {
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::BaseName)));
+    CHECK_CBOR(cbor_encode_text_string(&mapEncoder, base_name.data(), base_name.length()));
+  }
+  if (encode_base_time) {
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::BaseTime)));
+    CHECK_CBOR(encodeTime(mapEncoder, static_cast<int64_t>(timestamp_ms)));
+  }
   CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Name)));
 
-  // if _lightPayload is true, the property and attribute identifiers will be encoded instead of the property name
-  if (_lightPayload)
+  // with a light payload, the property and attribute identifiers will be encoded instead of the property name
+  if (_cursor.light_payload)
   {
     // the most significant byte of the identifier to be encoded represent the property identifier
-    int completeIdentifier = _attributeIdentifier * 256;
+    int completeIdentifier = _cursor.attribute_identifier * 256;
     // the least significant byte of the identifier to be encoded represent the attribute identifier
     completeIdentifier += _identifier;
     CHECK_CBOR(cbor_encode_int(&mapEncoder, completeIdentifier));
   }
   else
   {
-    String completeName = _name;
-    if (attributeName != "") {
-      completeName += ":" + attributeName;
-    }
-    CHECK_CBOR(cbor_encode_text_stringz(&mapEncoder, completeName.c_str()));
+    CHECK_CBOR(cbor_encode_text_string(&mapEncoder, name.data(), name.length()));
   }
-  /* Encode the value */
-  CHECK_CBOR(appendValue(mapEncoder));
+  if (encode_content_encoding) {
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::ContentEncoding)));
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(_cursor.content_encoding)));
+  }
+  return CborNoError;
+}
 
+CborError Property::endAttribute(CborEncoder * encoder, CborEncoder & mapEncoder)
+{
   /* Encode the timestamp if that has been required. */
-  if(_encode_timestamp)
+  if(_cursor.encode_time_entry)
   {
-    CHECK_CBOR(cbor_encode_int (&mapEncoder, static_cast<int>(CborIntegerMapKey::Time)));
-    CHECK_CBOR(cbor_encode_uint(&mapEncoder, _timestamp));
+    CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::Time)));
+    CHECK_CBOR(encodeTime(mapEncoder, _cursor.time_entry_ms));
   }
   /* Close the container */
   CHECK_CBOR(cbor_encoder_close_container(encoder, &mapEncoder));
   return CborNoError;
 }
 
-void Property::setAttributesFromCloud(std::list<CborMapData> * map_data_list) {
-  _map_data_list = map_data_list;
-  _attributeIdentifier = 0;
+CborStringView Property::nextAttributeKey() {
+  CborStringView const keys = CborStringView(_attribute_keys).substr(_cursor.attribute_key_offset);
+  int const separator = keys.find(',');
+  if (separator == -1)
+    return CborStringView();
+  _cursor.attribute_key_offset += separator + 1;
+  return keys.substr(0, separator);
+}
+
+void Property::setAttributesFromCloud(CborMapDataList * map_data_list) {
+  _cursor.map_data_list = map_data_list;
+  _cursor.attribute_identifier = 0;
   setAttributesFromCloud();
+  /* The cloud value has changed, the property might need to be echoed back */
+  markDirty();
 }
 
-void Property::setAttribute(bool& value, String attributeName) {
+void Property::setAttribute(bool& value, char const * attributeName) {
   setAttribute(attributeName, [&value](CborMapData & md) {
-    // Manage the case to have boolean values received as integers 0/1
-    if (md.bool_val.isSet()) {
-      value = md.bool_val.get();
-    } else if (md.val.isSet()) {
-      if (md.val.get() == 0) {
-        value = false;
-      } else if (md.val.get() == 1) {
-        value = true;
-      } else {
-        /* This should not happen. Leave the previous value */
-      }
-    }
+    setAttributeValue(value, md);
   });
 }
 
-void Property::setAttribute(int& value, String attributeName) {
+void Property::setAttribute(int& value, char const * attributeName) {
   setAttribute(attributeName, [&value](CborMapData & md) {
-    value = md.val.get();
+    setAttributeValue(value, md);
   });
 }
 
-void Property::setAttribute(unsigned int& value, String attributeName) {
+void Property::setAttribute(unsigned int& value, char const * attributeName) {
   setAttribute(attributeName, [&value](CborMapData & md) {
-    value = md.val.get();
+    setAttributeValue(value, md);
   });
 }
 
-void Property::setAttribute(float& value, String attributeName) {
+void Property::setAttribute(float& value, char const * attributeName) {
   setAttribute(attributeName, [&value](CborMapData & md) {
-    value = md.val.get();
+    setAttributeValue(value, md);
   });
 }
 
-void Property::setAttribute(String& value, String attributeName) {
+void Property::setAttribute(String& value, char const * attributeName) {
   setAttribute(attributeName, [&value](CborMapData & md) {
-    value = md.str_val.get();
+    setAttributeValue(value, md);
   });
 }
 
-#ifdef __AVR__
-void Property::setAttribute(String attributeName, nonstd::function<void (CborMapData & md)>setValue)
-#else
-void Property::setAttribute(String attributeName, std::function<void (CborMapData & md)>setValue)
-#endif
+bool Property::matchesAttribute(CborMapData const & map_data, char const * attributeName) const
 {
-  if (attributeName != "") {
-    _attributeIdentifier++;
-  }
-
-  std::for_each(_map_data_list->begin(),
-                _map_data_list->end(),
-                [this, attributeName, setValue](CborMapData & map)
-                {
-                  if (map.light_payload.isSet() && map.light_payload.get())
-                  {
-                    // if a light payload is detected, the attribute identifier is retrieved from the cbor map and the corresponding attribute is updated
-                    int attid = map.attribute_identifier.get();
-                    if (attid == _attributeIdentifier) {
-                      setValue(map);
-                      return;
-                    }
-                  }
-                  else
-                  {
-                    // if a normal payload is detected, the name of the attribute to be updated is extracted directly from the cbor map
-                    String an = map.attribute_name.get();
-                    if (an == attributeName) {
-                      setValue(map);
-                      return;
-                    }
-                  }
-                });
+  if (map_data.isLightPayload())
+  {
+    // if a light payload is detected, the attribute identifier is retrieved from the cbor map and the corresponding attribute is updated
+    return (map_data.attribute_identifier.get() == _cursor.attribute_identifier);
+  }
+  // if a normal payload is detected, the name of the attribute to be updated is extracted directly from the cbor map
+  return (map_data.attribute_name.get() == attributeName);
 }
 
 void Property::updateLocalTimestamp() {
-  if (isReadableByCloud()) {
+  markDirty();
+#if AIOT_CONFIG_RULES_ENABLED
+  markChangedForRules();
+#endif
+  /* The local timestamp is only compared against the one of a cloud change,
+   * which is never received by a property which is not writeable by the cloud.
+   */
+  if (isReadableByCloud() && isWriteableByCloud()) {
     if (_get_time_func) {
-      _last_local_change_timestamp = _get_time_func();
+      setLastLocalChangeTimestamp(_get_time_func());
     }
   }
 }
 
 void Property::setLastCloudChangeTimestamp(unsigned long cloudChangeEventTime) {
-  _last_cloud_change_timestamp = cloudChangeEventTime;
+  if (_extras || cloudChangeEventTime)
+    extras().last_cloud_change_timestamp = cloudChangeEventTime;
 }
 
 void Property::setLastLocalChangeTimestamp(unsigned long localChangeTime) {
-  _last_local_change_timestamp = localChangeTime;
+  if (_extras || localChangeTime)
+    extras().last_local_change_timestamp = localChangeTime;
 }
 
 unsigned long Property::getLastCloudChangeTimestamp() {
-  return _last_cloud_change_timestamp;
+  return _extras ? _extras->last_cloud_change_timestamp : 0;
 }
 
 unsigned long Property::getLastLocalChangeTimestamp() {
-  return _last_local_change_timestamp;
+  return _extras ? _extras->last_local_change_timestamp : 0;
 }
 
 void Property::setIdentifier(int identifier) {
   _identifier = identifier;
 }
 
+void Property::setContainer(PropertyContainer * container, size_t const position) {
+  _container = container;
+  _container_position = position;
+}
+
+bool Property::requiresPolling() {
+  /* A property which is not readable by the cloud is never sent. */
+  if (!isReadableByCloud()) {
+    return false;
+  }
+  /* Primitive wrappers can be modified without the property getting notified.
+   * Properties with UpdatePolicy::TimeInterval and changes held back by the
+   * rate limit are not polled but scheduled within the container until their
+   * deadline expires.
+   */
+  return isPrimitive() && !_is_change_detection_manual;
+}
+
+void Property::setName(char const * name, bool const copy) {
+  if (name == _name)
+    return;
+  char const * const name_to_release = _is_name_owned ? _name : nullptr;
+  if (copy) {
+    char * const name_copy = static_cast<char *>(arenaAlloc(strlen(name) + 1));
+    strcpy(name_copy, name);
+    _name = name_copy;
+  } else {
+    _name = name;
+  }
+  _is_name_owned = copy;
+  if (name_to_release)
+    arenaFree(const_cast<char *>(name_to_release));
+}
+
+Property::Extras & Property::extras() {
+  if (!_extras)
+    _extras = arenaNew<Extras>();
+  return (*_extras);
+}
+
+uint32_t Property::toIntegralDelta(float const delta) {
+  /* An integer distance reaches the delta once it reaches the delta rounded up */
+  if (!(delta > 0.0f))
+    return 0;
+  if (delta >= 4294967296.0f)
+    return UINT32_MAX;
+  uint32_t const integral = static_cast<uint32_t>(delta);
+  return (static_cast<float>(integral) < delta) ? (integral + 1) : integral;
+}
+
+unsigned long Property::currentTime() const {
+  return _get_time_func ? _get_time_func() : 0;
+}
+
+uint64_t Property::currentTimeMillis() const {
+  return _get_time_millis_func ? _get_time_millis_func() : currentTime() * 1000ULL;
+}
+
+void Property::setRecordTimestamp(unsigned long const timestamp) {
+  _cursor.record_time_ms = timestamp * 1000ULL;
+}
+
+void Property::setRecordTimeMillis(uint64_t const time_ms) {
+  _cursor.record_time_ms = time_ms;
+}
+
+void Property::markDirty() {
+  if (_container) {
+    _container->markDirty(_container_position);
+  }
+}
+
+#if AIOT_CONFIG_RULES_ENABLED
+void Property::markChangedForRules() {
+  if (_container) {
+    _container->markChanged(_container_position);
+  }
+}
+#endif
+
+void Property::postValueFromISR(int32_t const value) {
+  if (!_extras || !_extras->accepts_isr_updates)
+    return;
+  _extras->isr_value = value;
+  _extras->isr_value_seq = _extras->isr_value_seq + 1;
+  if (_container) {
+    _container->markPendingFromISR();
+  }
+}
+
+void Property::postDeltaFromISR(int32_t const delta) {
+  if (!_extras || !_extras->accepts_isr_updates)
+    return;
+  _extras->isr_delta_sum = _extras->isr_delta_sum + static_cast<uint32_t>(delta);
+  if (_container) {
+    _container->markPendingFromISR();
+  }
+}
+
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+void Property::markShared() {
+  /* Nothing runs update() on a property before it has been added */
+  if (_container) {
+    _container->markShared(_container_position);
+  } else {
+    applyShared();
+  }
+}
+#endif
+
+/******************************************************************************
+   ATTRIBUTE VALUES
+ ******************************************************************************/
+
+void setAttributeValue(bool & value, CborMapData const & md) {
+  // Manage the case to have boolean values received as integers 0/1
+  if (md.value.isBoolean()) {
+    value = md.value.boolean();
+  } else if (md.value.isNumber()) {
+    if (md.value.number() == 0) {
+      value = false;
+    } else if (md.value.number() == 1) {
+      value = true;
+    } else {
+      /* This should not happen. Leave the previous value */
+    }
+  }
+}
+
+void setAttributeValue(int & value, CborMapData const & md) {
+  if (md.value.isNumber()) {
+    value = md.value.number();
+  }
+}
+
+void setAttributeValue(unsigned int & value, CborMapData const & md) {
+  if (md.value.isNumber()) {
+    value = md.value.number();
+  }
+}
+
+void setAttributeValue(float & value, CborMapData const & md) {
+  if (md.value.isNumber()) {
+    value = md.value.number();
+  }
+}
+
+void setAttributeValue(String & value, CborMapData const & md) {
+#if AIOT_CONFIG_COMPRESSION_ENABLED
+  if (md.content_encoding.isSet() && md.value.isData()) {
+    /* A value which is too long or of an unknown encoding is dropped */
+    String decompressed;
+    CborStringView const data = md.value.data();
+    if ((md.content_encoding.get() == static_cast<int>(ContentEncoding::LZSS)) &&
+        LZSSBlock::decompress(reinterpret_cast<uint8_t const *>(data.data()), data.length(), decompressed, AIOT_CONFIG_COMPRESSION_MAX_LENGTH)) {
+      value = decompressed;
+    }
+    return;
+  }
+#endif
+  md.value.string().assignTo(value);
+}
+
 /******************************************************************************
    SYNCHRONIZATION CALLBACKS
  ******************************************************************************/
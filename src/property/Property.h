@@ -28,19 +28,14 @@
  ******************************************************************************/
 
 #include <Arduino.h>
+#include <AIoTC_Config.h>
+
+#include <limits.h>
+#include <string.h>
 
 #undef max
 #undef min
 
-#ifdef __AVR__
-# include <Arduino_AVRSTL.h>
-# include <nonstd/nonstd.h>
-#else
-# include <functional>
-#endif
-
-#include <list>
-
 #include "../cbor/lib/tinycbor/cbor-lib.h"
 
 /******************************************************************************
@@ -70,7 +65,14 @@ enum class CborIntegerMapKey : int {
   Sum          =  5, /* s    */
   Time         =  6, /* t    */
   UpdateTime   =  7, /* ut   */
-  DataValue    =  8  /* vd   */
+  DataValue    =  8, /* vd   */
+  /* Extension: encoding of the data value, a ContentEncoding */
+  ContentEncoding = 9  /* ce   */
+};
+
+enum class ContentEncoding : int {
+  None = 0,
+  LZSS = 1
 };
 
 template <typename T>
@@ -101,25 +103,218 @@ class MapEntry {
 
 };
 
+/* Non-owning reference to a string which is not necessarily null terminated,
+ * e.g. a CBOR text string within the received payload. A CborStringView is
+ * only valid as long as the referenced buffer is.
+ */
+class CborStringView {
+  public:
+
+    CborStringView() : _data(nullptr), _length(0) { }
+    CborStringView(char const * data, size_t const length) : _data(data), _length(length) { }
+    CborStringView(String const & str) : _data(str.c_str()), _length(str.length()) { }
+    explicit CborStringView(char const * str) : _data(str), _length(strlen(str)) { }
+
+    inline char const * data  () const { return _data; }
+    inline size_t       length() const { return _length; }
+    inline bool         empty () const { return _length == 0; }
+
+    /* Returns the position of the first occurrence of 'c' or -1 */
+    inline int find(char const c) const {
+      char const * pos = (_length > 0) ? static_cast<char const *>(memchr(_data, c, _length)) : nullptr;
+      return pos ? static_cast<int>(pos - _data) : -1;
+    }
+    inline CborStringView substr(size_t const pos, size_t const len) const {
+      return CborStringView(_data + pos, len);
+    }
+    inline CborStringView substr(size_t const pos) const {
+      return CborStringView(_data + pos, _length - pos);
+    }
+
+    /* Lexicographical comparison, same order as the one of String */
+    inline int compare(CborStringView const & other) const {
+      size_t const len = (_length < other._length) ? _length : other._length;
+      int const res = (len > 0) ? memcmp(_data, other._data, len) : 0;
+      if (res != 0) return res;
+      return (_length < other._length) ? -1 : ((_length > other._length) ? 1 : 0);
+    }
+    inline bool operator == (CborStringView const & other) const { return compare(other) == 0; }
+    inline bool operator != (CborStringView const & other) const { return compare(other) != 0; }
+    inline bool operator == (char const * str) const { return compare(CborStringView(str, strlen(str))) == 0; }
+    inline bool operator != (char const * str) const { return !operator == (str); }
+
+    /* Replaces the content of 'str' reusing its buffer if large enough */
+    inline void assignTo(String & str) const {
+      str = "";
+      str.reserve(_length);
+      for (size_t i = 0; i < _length; i++) {
+        str += _data[i];
+      }
+    }
+
+  private:
+
+    char const * _data;
+    size_t       _length;
+};
+
+class Property;
+
+/* Value of a SenML record. A record carries a single value, hence only the
+ * one of the value key decoded last is held.
+ */
+class MapValue {
+
+  public:
+    enum class Type : uint8_t { None, Number, String, Boolean, Data };
+
+    MapValue() : _number(0.0), _type(Type::None) { }
+
+    inline void setNumber (double const value)          { _number = value; _type = Type::Number; }
+    inline void setString (CborStringView const & value) { _view = value; _type = Type::String; }
+    inline void setBoolean(bool const value)            { _boolean = value; _type = Type::Boolean; }
+    /* Byte string referenced in place, viewed as characters */
+    inline void setData   (CborStringView const & value) { _view = value; _type = Type::Data; }
+    inline void reset     ()                            { _type = Type::None; }
+
+    inline Type type     () const { return _type; }
+    inline bool isNumber () const { return _type == Type::Number; }
+    inline bool isString () const { return _type == Type::String; }
+    inline bool isBoolean() const { return _type == Type::Boolean; }
+    inline bool isData   () const { return _type == Type::Data; }
+
+    /* A value of another type reads as 0, false or empty */
+    inline double         number () const { return isNumber() ? _number : 0.0; }
+    inline bool           boolean() const { return isBoolean() ? _boolean : false; }
+    inline CborStringView string () const { return isString() ? _view : CborStringView(); }
+    inline CborStringView data   () const { return isData() ? _view : CborStringView(); }
+
+  private:
+    union {
+      double         _number;
+      CborStringView _view;
+      bool           _boolean;
+    };
+    Type _type;
+};
+
+/* Decoded SenML record, all strings are referenced within the payload */
 class CborMapData {
 
   public:
-    MapEntry<int>    base_version;
-    MapEntry<String> base_name;
-    MapEntry<double> base_time;
-    MapEntry<String> name;
-    MapEntry<int>    name_identifier;
-    MapEntry<bool>   light_payload;
-    MapEntry<String> attribute_name;
-    MapEntry<int>    attribute_identifier;
-    MapEntry<int>    property_identifier;
-    MapEntry<double> val;
-    MapEntry<String> str_val;
-    MapEntry<bool>   bool_val;
-    MapEntry<double> time;
+    MapEntry<double>         base_time;
+    MapEntry<double>         time;
+    MapValue                 value;
+    MapEntry<CborStringView> base_name;
+    MapEntry<CborStringView> name;
+    MapEntry<CborStringView> attribute_name;
+    /* Resolved from the identifier of a light payload while decoding the name */
+    MapEntry<Property *>     property;
+    /* Only set for a light payload */
+    MapEntry<uint8_t>        attribute_identifier;
+    MapEntry<uint8_t>        content_encoding;
+
+    inline bool isLightPayload() const { return attribute_identifier.isSet(); }
 };
 
-enum class Permission {
+/* Fixed-size list holding the decoded attributes of a single property. */
+class CborMapDataList {
+
+  public:
+    static size_t const CAPACITY = AIOT_CONFIG_PROPERTY_MAX_ATTRIBUTES;
+
+    CborMapDataList() : _size(0) { }
+
+    /* Returns false if the list is full, the entry is dropped in that case. */
+    inline bool push_back(CborMapData const & map_data) {
+      if (_size >= CAPACITY) return false;
+      _map_data[_size++] = map_data;
+      return true;
+    }
+    inline void                clear()       { _size = 0; }
+    inline size_t              size () const { return _size; }
+    inline CborMapData       * begin()       { return _map_data; }
+    inline CborMapData       * end  ()       { return _map_data + _size; }
+
+  private:
+    CborMapData _map_data[CAPACITY];
+    size_t      _size;
+};
+
+/* Take the value of a decoded record over, the same as setAttribute() does */
+void setAttributeValue(bool & value, CborMapData const & md);
+void setAttributeValue(int & value, CborMapData const & md);
+void setAttributeValue(unsigned int & value, CborMapData const & md);
+void setAttributeValue(float & value, CborMapData const & md);
+void setAttributeValue(String & value, CborMapData const & md);
+
+/* An attribute of the composite value type T. The table of the attributes of
+ * a type lists them in the order of their identifiers, which start at 1, and
+ * is accompanied by their positions sorted by name. A received record is then
+ * resolved by its identifier or a binary search of its name, see
+ * Property::setAttributesFromTable(). Entries are defined by AIOT_ATTRIBUTE(),
+ * isSortedByName() checks the order of the names at compile time.
+ */
+template <typename T>
+struct AttributeEntry {
+  char const * name;
+  void (*set)(T & value, CborMapData const & md);
+};
+
+template <typename T, typename M, M member>
+void setAttributeMember(T & value, CborMapData const & md) {
+  setAttributeValue(value.*member, md);
+}
+
+#define AIOT_ATTRIBUTE(T, name) { #name, &setAttributeMember<T, decltype(&T::name), &T::name> }
+
+constexpr int compareAttributeNames(char const * lhs, char const * rhs) {
+  return (*lhs != *rhs) ? ((*lhs < *rhs) ? -1 : 1) : ((*lhs == '\0') ? 0 : compareAttributeNames(lhs + 1, rhs + 1));
+}
+
+template <typename T>
+constexpr bool isSortedByName(AttributeEntry<T> const * table, uint8_t const * by_name, size_t const size) {
+  return (size < 2) || ((compareAttributeNames(table[by_name[0]].name, table[by_name[1]].name) < 0) && isSortedByName(table, by_name + 1, size - 1));
+}
+
+/* Base name and base time in effect while encoding the records of a
+ * message with SenML base values (RFC 8428, Section 4.1).
+ */
+class SenMLBaseValues {
+  public:
+    SenMLBaseValues() : has_base_time(false), base_time_ms(0) { }
+
+    CborStringView base_name;
+    bool           has_base_time;
+    uint64_t       base_time_ms;
+};
+
+/* A string value which does not fit into a message of its own is encoded as
+ * an empty string, the placeholder, while the encoder spills. The message is
+ * then sent with the value streamed in place of the placeholder, so that it
+ * does not need to fit into the message buffer.
+ */
+class SpilledString {
+  public:
+    SpilledString() : property(nullptr), placeholder(nullptr), data(nullptr), length(0) { }
+
+    Property *      property;
+    uint8_t const * placeholder;
+    char const *    data;
+    size_t          length;
+};
+
+/* A property name which outlives the property, e.g. a string literal. It is
+ * referenced by the property instead of being copied like any other name.
+ */
+class LiteralName {
+  public:
+    explicit constexpr LiteralName(char const * name) : str(name) { }
+
+    char const * const str;
+};
+
+enum class Permission : uint8_t {
   Read, Write, ReadWrite
 };
 
@@ -127,38 +322,99 @@ enum class Type {
   Bool, Int, Float, String
 };
 
-enum class UpdatePolicy {
+enum class UpdatePolicy : uint8_t {
   OnChange, TimeInterval, OnDemand
 };
 
+enum class Priority : uint8_t {
+  Normal, High
+};
+
+enum class Reliability : uint8_t {
+  Unconfirmed, Confirmed
+};
+
 typedef void(*UpdateCallbackFunc)(void);
 typedef unsigned long(*GetTimeCallbackFunc)();
-class Property;
+/* Milliseconds since the epoch */
+typedef uint64_t(*GetTimeMillisCallbackFunc)();
+class PropertyContainer;
+class PropertyGroup;
 typedef void(*OnSyncCallbackFunc)(Property &);
+/* Returns true if it takes over running the callback later, e.g. in another thread */
+typedef bool(*DeferCallbackFunc)(Property &, bool const is_sync);
+/* Latency of a change received from the cloud, reported once its callback ran */
+typedef void(*CommandLatencyFunc)(unsigned long const cloud_to_device_ms, unsigned long const callback_us);
 
 /******************************************************************************
    CLASS DECLARATION
  ******************************************************************************/
 
-#ifdef __AVR__
-#include "nonstd/nonstd.h"
-#endif
-
 class Property
 {
   public:
     Property();
-    void init(String const name, Permission const permission, GetTimeCallbackFunc func);
+    Property(Property const & other);
+    Property & operator=(Property const & other);
+    virtual ~Property();
+    /* The name is copied, unless passed as LiteralName */
+    void init(char const * name, Permission const permission, GetTimeCallbackFunc func);
+    void init(String const & name, Permission const permission, GetTimeCallbackFunc func);
+    void init(LiteralName const name, Permission const permission, GetTimeCallbackFunc func);
 
     /* Composable configuration of the Property class */
     Property & onUpdate(UpdateCallbackFunc func);
     Property & onSync(OnSyncCallbackFunc func);
     Property & publishOnChange(float const min_delta_property, unsigned long const min_time_between_updates_millis = 0);
+    /* Publishes on change as well, but only once the value has fallen by
+     * falling_delta or risen by rising_delta from the value sent last.
+     */
+    Property & publishOutsideDeadband(float const falling_delta, float const rising_delta, unsigned long const min_time_between_updates_millis = 0);
     Property & publishEvery(unsigned long const seconds);
     Property & publishOnDemand();
     Property & encodeTimestamp();
+    Property & encodeCompactFloat();
+    /* String and binary values of at least AIOT_CONFIG_COMPRESSION_MIN_LENGTH
+     * bytes are sent LZSS compressed if that makes them shorter, given
+     * AIOT_CONFIG_COMPRESSION_ENABLED. Compressed values are always received.
+     */
+    Property & encodeCompressed();
+    /* High priority properties are encoded into a message before any normal
+     * priority one, which share the remaining payload in round-robin order.
+     */
+    Property & priority(Priority const priority);
+    inline Priority getPriority() const {
+      return _is_high_priority ? Priority::High : Priority::Normal;
+    }
+    /* Where the transport distinguishes them, e.g. LoRaWAN, updates of confirmed
+     * properties are sent as confirmed uplinks which are retried until they are
+     * acknowledged. Confirmed properties are encoded with high priority.
+     */
+    Property & reliability(Reliability const reliability);
+    inline Reliability getReliability() const {
+      return _is_confirmed ? Reliability::Confirmed : Reliability::Unconfirmed;
+    }
+    /* Wrapped primitives are compared against their previous value on every
+     * update by default. Manual change detection skips that comparison and
+     * relies on changes being reported via markChanged() instead.
+     */
+    Property & manualChangeDetection();
+    void markChanged();
+    inline bool isChangeDetectionManual() const {
+      return _is_change_detection_manual;
+    }
+    /* Prepares the mailbox written by the ...FromISR() setters of a property,
+     * which are ignored otherwise. The posted values are merged into the
+     * property by the next update() on the core running the interrupt.
+     */
+    Property & acceptUpdatesFromISR();
+    void applyUpdatesFromISR();
 
     inline String name() const {
+      return String(_name);
+    }
+    /* The name without copying it, valid as long as the property */
+    inline char const * c_name() const {
       return _name;
     }
     inline int identifier() const {
@@ -173,37 +429,115 @@ class Property
 
     void setTimestamp(unsigned long const timestamp);
     bool shouldBeUpdated();
+    /* Milliseconds until shouldBeUpdated() turns true, 0 if it already is and
+     * ULONG_MAX if the property is not waiting for anything time driven.
+     */
+    unsigned long millisUntilDue(unsigned long const now);
     void requestUpdate();
     void appendCompleted();
     void provideEcho();
     void execCallbackOnChange();
     void execCallbackOnSync();
+    /* Defers the sync callback of a shadow message until resolveSync() has
+     * taken all properties of the message. Returns false if the property is
+     * not attached to a container, the callback has to run right away then.
+     */
+    bool markSyncPending();
+    inline OnSyncCallbackFunc onSyncCallback() const {
+      return _extras ? _extras->on_sync_callback_func : nullptr;
+    }
+    /* Runs a callback whose execution has been taken over by the defer function */
+    void execDeferredCallback(bool const is_sync);
+    static void setDeferCallbackFunc(DeferCallbackFunc func);
+    /* The time base of the samples taken now, e.g. by CloudSeries::add(),
+     * which are timestamped with whole seconds without one.
+     */
+    static void setTimeMillisFunc(GetTimeMillisCallbackFunc func);
+    /* Measures the latency of the changes received from the cloud from their
+     * cloud timestamp to their arrival and from their arrival to the callback.
+     */
+    static void setCommandLatencyFunc(CommandLatencyFunc func);
+    void onCloudChangeReceived();
     void setLastCloudChangeTimestamp(unsigned long cloudChangeTime);
     void setLastLocalChangeTimestamp(unsigned long localChangeTime);
     unsigned long getLastCloudChangeTimestamp();
     unsigned long getLastLocalChangeTimestamp();
     void setIdentifier(int identifier);
+    void setContainer(PropertyContainer * container, size_t const position);
+    inline bool isAttachedToContainer() const {
+      return _container != nullptr;
+    }
+    inline size_t getContainerPosition() const {
+      return _container_position;
+    }
+    bool requiresPolling();
+    inline bool isPublishedPeriodically() const {
+      return (_update_policy == UpdatePolicy::TimeInterval) && isReadableByCloud();
+    }
+    inline unsigned long getPublishDeadline() const {
+      return _last_updated_millis + (_extras ? _extras->update_interval_millis : 0);
+    }
+    /* A changed value held back by the rate limit is sent once the window closed */
+    inline bool isHeldByRateLimit() {
+      return (_update_policy == UpdatePolicy::OnChange) && isReadableByCloud() && isDifferentFromCloud();
+    }
+    unsigned long getRateLimitDeadline() const;
+    /* Set by PropertyGroup::add() for the first group the property is added to */
+    void setGroup(PropertyGroup * group);
+    inline PropertyGroup * getGroup() const {
+      return _extras ? _extras->group : nullptr;
+    }
+    /* Deadline under which the property is currently scheduled within its container */
+    inline void setScheduledDeadline(unsigned long const deadline) {
+      _scheduled_deadline = deadline;
+    }
+    inline unsigned long getScheduledDeadline() const {
+      return _scheduled_deadline;
+    }
+    /* Bytes taken by the property when it was last appended, 0 before */
+    inline size_t getEncodedSize() const {
+      return _encoded_size;
+    }
 
     void updateLocalTimestamp();
-    CborError append(CborEncoder * encoder, bool lightPayload);
-    CborError appendAttribute(bool value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(int value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(unsigned int value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(float value, String attributeName = "", CborEncoder *encoder = nullptr);
-    CborError appendAttribute(String value, String attributeName = "", CborEncoder *encoder = nullptr);
-#ifndef __AVR__
-    CborError appendAttributeName(String attributeName, std::function<CborError (CborEncoder& mapEncoder)>f, CborEncoder *encoder);
-    void setAttribute(String attributeName, std::function<void (CborMapData & md)>setValue);
-#else
-    CborError appendAttributeName(String attributeName, nonstd::function<CborError (CborEncoder& mapEncoder)>f, CborEncoder *encoder);
-    void setAttribute(String attributeName, nonstd::function<void (CborMapData & md)>setValue);
-#endif
-    void setAttributesFromCloud(std::list<CborMapData> * map_data_list);
-    void setAttribute(bool& value, String attributeName = "");
-    void setAttribute(int& value, String attributeName = "");
-    void setAttribute(unsigned int& value, String attributeName = "");
-    void setAttribute(float& value, String attributeName = "");
-    void setAttribute(String& value, String attributeName = "");
+    CborError append(CborEncoder * encoder, bool lightPayload, unsigned long const timestamp = 0, SenMLBaseValues * base_values = nullptr, SpilledString * spill = nullptr);
+    /* Appends the current value like append() does, but leaves the property
+     * unchanged, i.e. it is still sent to the cloud as if not appended.
+     */
+    CborError appendSnapshot(CborEncoder * encoder);
+    CborError appendAttribute(bool value, char const * attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(int value, char const * attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(unsigned int value, char const * attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(float value, char const * attributeName = "", CborEncoder *encoder = nullptr);
+    CborError appendAttribute(String const & value, char const * attributeName = "", CborEncoder *encoder = nullptr);
+    /* Appends an attribute of a composite property, unless only the changed
+     * attributes are encoded and it equals the value last sent to the cloud.
+     */
+    template <typename T>
+    CborError appendChangedAttribute(T const & value, T const & cloudValue, char const * attributeName, CborEncoder *encoder) {
+      if (_cursor.changed_attributes_only && (value == cloudValue)) {
+        return skipAttribute(attributeName);
+      }
+      return appendAttribute(value, attributeName, encoder);
+    }
+    /* The value encoding/decoding functors are passed as template parameters
+     * so that they can be inlined without any type erasure or allocation.
+     */
+    template <typename AppendValueFunc>
+    CborError appendAttributeName(char const * attributeName, AppendValueFunc appendValue, CborEncoder *encoder);
+    template <typename SetValueFunc>
+    void setAttribute(char const * attributeName, SetValueFunc setValue);
+    /* Sets all attributes of a composite value at once, each record received
+     * is looked up in the table instead of compared with every attribute.
+     */
+    template <typename T, size_t N>
+    void setAttributesFromTable(AttributeEntry<T> const (&table)[N], uint8_t const (&by_name)[N], T & value);
+    void setAttributesFromCloud(CborMapDataList * map_data_list);
+    void setAttribute(bool& value, char const * attributeName = "");
+    void setAttribute(int& value, char const * attributeName = "");
+    void setAttribute(unsigned int& value, char const * attributeName = "");
+    void setAttribute(float& value, char const * attributeName = "");
+    void setAttribute(String& value, char const * attributeName = "");
 
     virtual bool isDifferentFromCloud() = 0;
     virtual void fromCloudToLocal() = 0;
@@ -213,52 +547,284 @@ class Property
     virtual bool isPrimitive() {
       return false;
     };
+    /* Whether an echo of the current value stands in for the value sent
+     * last, false for the properties sending the samples taken meanwhile.
+     */
+    virtual bool isEchoComplete() {
+      return true;
+    }
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    /* Takes over the value passed to store() on another core, called by the container on the core running update() */
+    virtual void applyShared() { }
+#endif
+#if AIOT_CONFIG_RULES_ENABLED
+    /* Numeric view of the value used by the rule engine, the types without
+     * one return false. setNumber() changes the value like the sketch does.
+     */
+    virtual bool getNumber(float & value) {
+      (void)value;
+      return false;
+    }
+    virtual bool setNumber(float const value) {
+      (void)value;
+      return false;
+    }
+#endif
 
     static unsigned long const DEFAULT_MIN_TIME_BETWEEN_UPDATES_MILLIS = 500; /* Data rate throttled to 2 Hz */
 
   protected:
-    /* Variables used for UpdatePolicy::OnChange */
-    String             _name;
+    /* Notifies the owning container that this property may need to be sent to the cloud */
+    void markDirty();
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    /* Notifies the owning container that store() has been called, safe on any core and within interrupts */
+    void markShared();
+#endif
+#if AIOT_CONFIG_RULES_ENABLED
+    /* Notifies the owning container that the value has been changed, see PropertyContainer::markChanged() */
+    void markChangedForRules();
+#endif
+    /* Interrupt side of the mailbox: the latest value and the sum of all deltas posted */
+    void postValueFromISR(int32_t const value);
+    void postDeltaFromISR(int32_t const delta);
+    /* Merges the mailbox into the value, i.e. the latest posted value if is_set
+     * plus the sum of the deltas posted since the previous merge.
+     */
+    virtual void mergeFromISR(bool const is_set, int32_t const value, int32_t const delta) {
+      (void)is_set;
+      (void)value;
+      (void)delta;
+    }
+    /* Returns the time of the time service after init(), 0 before */
+    unsigned long currentTime() const;
+    /* Returns the time in milliseconds, whole seconds without a time base */
+    uint64_t currentTimeMillis() const;
+    /* Timestamp of the records appended next within appendAttributesToCloud(),
+     * e.g. per sample of a series. It takes precedence over any other one, 0 resets it.
+     */
+    static void setRecordTimestamp(unsigned long const timestamp);
+    static void setRecordTimeMillis(uint64_t const time_ms);
+    /* Encodes a SenML time, with a fraction of a second only if it has one */
+    static CborError encodeTime(CborEncoder & encoder, int64_t const time_ms);
+    /* Encodes a float as integer or half-float if it is representable within the given tolerance */
+    static CborError encodeCompactFloat(CborEncoder & encoder, float const value, float const tolerance);
+    static bool convertFloatToCborHalfFloat(float const value, float const tolerance, uint16_t & half_val);
+    /* Returns the next cached "name:attribute" key in the order the attributes are appended */
+    CborStringView nextAttributeKey();
+    /* Non-template parts of appendAttributeName and setAttribute */
+    bool      prepareAttribute(char const * attributeName);
+    CborError skipAttribute(char const * attributeName);
+    CborError beginAttribute(char const * attributeName, CborEncoder * encoder, CborEncoder & mapEncoder);
+    CborError endAttribute(CborEncoder * encoder, CborEncoder & mapEncoder);
+    bool      matchesAttribute(CborMapData const & map_data, char const * attributeName) const;
+#if AIOT_CONFIG_COMPRESSION_ENABLED
+    /* Appends the data as LZSS compressed data value if configured with
+     * encodeCompressed() and shorter that way, returns false if it has not
+     * been appended.
+     */
+    bool      appendCompressedAttribute(uint8_t const * data, size_t const length, char const * attributeName, CborEncoder * encoder, CborError & err);
+#endif
+
+    /* Variables used for UpdatePolicy::OnChange. The minimum delta of the
+     * integer properties is the float one rounded up, their values are
+     * compared without converting them to float.
+     */
     float              _min_delta_property;
+    uint32_t           _min_delta_integral;
     unsigned long      _min_time_between_updates_millis;
 
+  protected:
+    /* Whether the value has moved far enough from the one sent last */
+    inline bool isBeyondMinDelta(int const value, int const cloud_value) const {
+      /* Differences of the unsigned values do not overflow */
+      return (value > cloud_value) ? (static_cast<uint32_t>(value) - static_cast<uint32_t>(cloud_value)) >= _min_delta_integral
+                                   : (static_cast<uint32_t>(cloud_value) - static_cast<uint32_t>(value)) >= minFallingDeltaIntegral();
+    }
+    inline bool isBeyondMinDelta(unsigned int const value, unsigned int const cloud_value) const {
+      return (value > cloud_value) ? static_cast<uint32_t>(value - cloud_value) >= _min_delta_integral
+                                   : static_cast<uint32_t>(cloud_value - value) >= minFallingDeltaIntegral();
+    }
+    inline bool isBeyondMinDelta(float const value, float const cloud_value) const {
+      return (value > cloud_value) ? (value - cloud_value) >= _min_delta_property
+                                   : (cloud_value - value) >= minFallingDelta();
+    }
+
   private:
-    Permission         _permission;
-    GetTimeCallbackFunc _get_time_func;
-    UpdateCallbackFunc _update_callback_func;
-    OnSyncCallbackFunc _on_sync_callback_func;
+    /* Settings which most properties leave at their defaults. They are
+     * allocated on the first non-default write and cost a pointer otherwise.
+     */
+    struct Extras {
+      UpdateCallbackFunc update_callback_func;
+      OnSyncCallbackFunc on_sync_callback_func;
+      /* Variables used for UpdatePolicy::TimeInterval */
+      unsigned long      update_interval_millis;
+      /* Variables used for reconnection sync*/
+      unsigned long      last_local_change_timestamp;
+      unsigned long      last_cloud_change_timestamp;
+      unsigned long      timestamp;
+      /* Mailbox of the ...FromISR() setters, only the sequence and the sum
+       * are compared, hence no read-modify-write is shared with the interrupt.
+       */
+      bool               accepts_isr_updates;
+      volatile uint8_t   isr_value_seq;
+      volatile int32_t   isr_value;
+      volatile uint32_t  isr_delta_sum;
+      uint8_t            isr_value_seq_applied;
+      uint32_t           isr_delta_sum_applied;
+      /* Minimum delta of a falling value if it differs from the rising one */
+      float              min_falling_delta;
+      uint32_t           min_falling_delta_integral;
+      /* Group providing the base name and the shared rate limit */
+      PropertyGroup *    group;
+      /* Arrival of the change received from the cloud whose callback is pending */
+      bool               is_command_pending;
+      unsigned long      command_received_us;
+      unsigned long      command_cloud_to_device_ms;
+    };
+    /* Transient state of the property being encoded or decoded. Only one
+     * property is processed at a time, hence it is shared by all of them.
+     */
+    struct Cursor {
+      /* Indicates if the property shall be encoded using the identifier instead of the name */
+      bool               light_payload;
+      bool               collect_attribute_keys;
+      /* Indicates if the attributes equal to the cloud value are left out */
+      bool               changed_attributes_only;
+      bool               encode_time_entry;
+      ContentEncoding    content_encoding;
+      int                attribute_identifier;
+      unsigned int       attribute_key_offset;
+      /* Timestamp overriding the property timestamp during append(), 0 if none */
+      unsigned long      append_timestamp;
+      /* Time in ms overriding the append timestamp for the next records, 0 if none */
+      uint64_t           record_time_ms;
+      /* Base values of the message being encoded, nullptr if not used */
+      SenMLBaseValues *  base_values;
+      /* Takes the first string value of the message if not nullptr */
+      SpilledString *    spill;
+      /* Time of the record in ms, relative to the base time if there is one */
+      int64_t            time_entry_ms;
+      CborMapDataList *  map_data_list;
+    };
+    static Cursor      _cursor;
+    static DeferCallbackFunc _defer_callback_func;
+    static GetTimeMillisCallbackFunc _get_time_millis_func;
+    static CommandLatencyFunc _command_latency_func;
 
+    char const *       _name;
+    Extras *           _extras;
+    GetTimeCallbackFunc _get_time_func;
+    Permission         _permission;
     UpdatePolicy       _update_policy;
-    bool               _has_been_updated_once,
-                       _has_been_modified_in_callback,
-                       _has_been_appended_but_not_sended;
-    /* Variables used for UpdatePolicy::TimeInterval */
-    unsigned long      _last_updated_millis,
-             _update_interval_millis;
-    /* Variables used for reconnection sync*/
-    unsigned long      _last_local_change_timestamp;
-    unsigned long      _last_cloud_change_timestamp;
-    std::list<CborMapData> * _map_data_list;
-    /* Store the identifier of the property in the array list */
-    int                _identifier;
-    int                _attributeIdentifier;
-    /* Indicates if the property shall be encoded using the identifier instead of the name */
-    bool               _lightPayload;
+    bool               _is_name_owned : 1;
+    bool               _has_been_updated_once : 1;
+    bool               _has_been_modified_in_callback : 1;
+    bool               _has_been_appended_but_not_sended : 1;
     /* Indicates whether a property update has been requested in case of the OnDemand update policy. */
-    bool               _update_requested;
+    bool               _update_requested : 1;
     /* Indicates whether the timestamp shall be encoded in the property or not */
-    bool               _encode_timestamp;
+    bool               _encode_timestamp : 1;
+    /* Indicates whether float values may be encoded as integer or half-float within _min_delta_property */
+    bool               _encode_compact_float : 1;
     /* Indicates if the property shall be echoed back to the cloud even if unchanged */
-    bool               _echo_requested;
-    unsigned long      _timestamp;
+    bool               _echo_requested : 1;
+    bool               _is_change_detection_manual : 1;
+    bool               _is_high_priority : 1;
+    bool               _is_confirmed : 1;
+    bool               _has_deadband : 1;
+    bool               _encode_compressed : 1;
+    unsigned long      _last_updated_millis;
+    /* Store the identifier of the property in the array list */
+    int                _identifier;
+    /* "name:attribute" keys of all attributes separated by ',', built once by init() */
+    String             _attribute_keys;
+    /* Container which tracks the dirty state of this property and the position within it */
+    PropertyContainer * _container;
+    size_t             _container_position;
+    unsigned long      _scheduled_deadline;
+    uint16_t           _encoded_size;
+
+    void    setName(char const * name, bool const copy);
+    Extras & extras();
+    static uint32_t toIntegralDelta(float const delta);
+    inline float minFallingDelta() const {
+      return _has_deadband ? _extras->min_falling_delta : _min_delta_property;
+    }
+    inline uint32_t minFallingDeltaIntegral() const {
+      return _has_deadband ? _extras->min_falling_delta_integral : _min_delta_integral;
+    }
 };
 
+/******************************************************************************
+   TEMPLATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+template <typename AppendValueFunc>
+CborError Property::appendAttributeName(char const * attributeName, AppendValueFunc appendValue, CborEncoder *encoder)
+{
+  if (!prepareAttribute(attributeName)) {
+    return CborNoError;
+  }
+  CborEncoder mapEncoder;
+  CHECK_CBOR(beginAttribute(attributeName, encoder, mapEncoder));
+  /* Encode the value */
+  CHECK_CBOR(appendValue(mapEncoder));
+  return endAttribute(encoder, mapEncoder);
+}
+
+template <typename SetValueFunc>
+void Property::setAttribute(char const * attributeName, SetValueFunc setValue)
+{
+  if (attributeName[0] != '\0') {
+    _cursor.attribute_identifier++;
+  }
+
+  for (CborMapData * map = _cursor.map_data_list->begin(); map != _cursor.map_data_list->end(); map++)
+  {
+    if (matchesAttribute(*map, attributeName)) {
+      setValue(*map);
+    }
+  }
+}
+
+template <typename T, size_t N>
+void Property::setAttributesFromTable(AttributeEntry<T> const (&table)[N], uint8_t const (&by_name)[N], T & value)
+{
+  for (CborMapData * map = _cursor.map_data_list->begin(); map != _cursor.map_data_list->end(); map++)
+  {
+    AttributeEntry<T> const * entry = nullptr;
+    if (map->isLightPayload()) {
+      uint8_t const identifier = map->attribute_identifier.get();
+      if ((identifier >= 1) && (identifier <= N)) {
+        entry = &table[identifier - 1];
+      }
+    } else {
+      CborStringView const name = map->attribute_name.get();
+      size_t lo = 0, hi = N;
+      while (!entry && (lo < hi)) {
+        size_t const mid = (lo + hi) / 2;
+        int const res = name.compare(CborStringView(table[by_name[mid]].name));
+        if (res == 0) {
+          entry = &table[by_name[mid]];
+        } else if (res < 0) {
+          hi = mid;
+        } else {
+          lo = mid + 1;
+        }
+      }
+    }
+    if (entry) {
+      entry->set(value, *map);
+    }
+  }
+}
+
 /******************************************************************************
    PROTOTYPE FREE FUNCTIONs
  ******************************************************************************/
 
 inline bool operator == (Property const & lhs, Property const & rhs) {
-  return (lhs.name() == rhs.name());
+  return (strcmp(lhs.c_name(), rhs.c_name()) == 0);
 }
 
 /******************************************************************************
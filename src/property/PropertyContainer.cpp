@@ -23,19 +23,26 @@
 
 #include <algorithm>
 
+#include <Arduino_DebugUtils.h>
+
 #include "types/CloudWrapperBase.h"
 
 /******************************************************************************
    INTERNAL FUNCTION DECLARATION
  ******************************************************************************/
 
-void addProperty(PropertyContainer & prop_cont, Property * property_obj, int propertyIdentifier);
+bool addProperty(PropertyContainer & prop_cont, Property * property_obj, int propertyIdentifier);
 
 /******************************************************************************
    PUBLIC FUNCTION DEFINITION
  ******************************************************************************/
 
 Property & addPropertyToContainer(PropertyContainer & prop_cont, Property & property, String const & name, Permission const permission, int propertyIdentifier, GetTimeCallbackFunc func)
+{
+  return addPropertyToContainer(prop_cont, property, name.c_str(), permission, propertyIdentifier, func);
+}
+
+Property & addPropertyToContainer(PropertyContainer & prop_cont, Property & property, char const * name, Permission const permission, int propertyIdentifier, GetTimeCallbackFunc func)
 {
   /* Check whether or not the property already has been added to the container */
   Property * p = getProperty(prop_cont, name);
@@ -44,43 +51,66 @@ Property & addPropertyToContainer(PropertyContainer & prop_cont, Property & prop
   /* Initialize property and add it to the container */
   property.init(name, permission, func);
 
-  addProperty(prop_cont, &property, propertyIdentifier);
+  if (!addProperty(prop_cont, &property, propertyIdentifier))
+    DEBUG_ERROR("%s: property %s not added, the container is full", __FUNCTION__, property.c_name());
   return property;
 }
 
+Property & addPropertyToContainer(PropertyContainer & prop_cont, Property & property, LiteralName const name, Permission const permission, int propertyIdentifier, GetTimeCallbackFunc func)
+{
+  /* Check whether or not the property already has been added to the container */
+  Property * p = getProperty(prop_cont, name.str);
+  if(p != nullptr) return (*p);
 
-Property * getProperty(PropertyContainer & prop_cont, String const & name)
+  /* Initialize property and add it to the container */
+  property.init(name, permission, func);
+
+  if (!addProperty(prop_cont, &property, propertyIdentifier))
+    DEBUG_ERROR("%s: property %s not added, the container is full", __FUNCTION__, property.c_name());
+  return property;
+}
+
+bool addPropertiesToContainer(PropertyContainer & prop_cont, PropertySchemaEntry const * schema, size_t const size, GetTimeCallbackFunc func)
 {
-  std::list<Property *>::iterator iter;
+  if ((prop_cont.size() + size) > PropertyContainer::CAPACITY)
+    return false;
 
-  iter = std::find_if(prop_cont.begin(),
-                      prop_cont.end(),
-                      [name](Property * p) -> bool
-                      {
-                        return (p->name() == name);
-                      });
+  bool is_unique = true;
+  for (PropertySchemaEntry const * entry = schema; entry != schema + size; entry++)
+  {
+    if (getProperty(prop_cont, entry->name) != nullptr) {
+      is_unique = false;
+      continue;
+    }
+    if (!addPropertyToContainer(prop_cont, *entry->property, LiteralName(entry->name), entry->permission, entry->identifier, func).isAttachedToContainer())
+      return false;
+  }
+  return is_unique;
+}
 
-  if (iter == prop_cont.end())
-    return nullptr;
-  else
-    return (*iter);
+Property * getProperty(PropertyContainer & prop_cont, String const & name)
+{
+  return prop_cont.find(name);
 }
 
-Property * getProperty(PropertyContainer & prop_cont, int const identifier)
+Property * getProperty(PropertyContainer & prop_cont, char const * name)
 {
-  std::list<Property *>::iterator iter;
+  return prop_cont.find(name);
+}
 
-  iter = std::find_if(prop_cont.begin(),
-                      prop_cont.end(),
-                      [identifier](Property * p) -> bool
-                      {
-                        return (p->identifier() == identifier);
-                      });
+Property * getProperty(PropertyContainer & prop_cont, int const identifier)
+{
+  return prop_cont.find(identifier);
+}
 
-  if (iter == prop_cont.end())
-    return nullptr;
-  else
-    return (*iter);
+Property * getPrimitiveProperty(PropertyContainer & prop_cont, void const * value)
+{
+  for (Property * p : prop_cont)
+  {
+    if (p->isPrimitive() && (reinterpret_cast<CloudWrapperBase *>(p)->primitive() == value))
+      return p;
+  }
+  return nullptr;
 }
 
 void requestUpdateForAllProperties(PropertyContainer & prop_cont)
@@ -93,41 +123,155 @@ void requestUpdateForAllProperties(PropertyContainer & prop_cont)
                 });
 }
 
-void updateTimestampOnLocallyChangedProperties(PropertyContainer & prop_cont)
+bool requestUpdateForProperty(PropertyContainer & prop_cont, Property * property)
 {
-  /* This function updates the timestamps on the primitive properties 
-   * that have been modified locally since last cloud synchronization
-   */
+  if ((property == nullptr) || (std::find(prop_cont.begin(), prop_cont.end(), property) == prop_cont.end()))
+    return false;
+  /* Sent with the next update whatever its update policy, unlike requestUpdate() */
+  property->provideEcho();
+  return true;
+}
+
+bool requestUpdateForGroup(PropertyContainer & prop_cont, PropertyGroup const & group)
+{
+  bool is_requested = true;
+  for (Property * p : group)
+    is_requested = requestUpdateForProperty(prop_cont, p) && is_requested;
+  return is_requested;
+}
+
+void requestUpdateForChangedProperties(PropertyContainer & prop_cont)
+{
+  /* Changed properties are sent regardless of their minimum time between updates */
   std::for_each(prop_cont.begin(),
                 prop_cont.end(),
                 [](Property * p)
                 {
-                  CloudWrapperBase * pbase = reinterpret_cast<CloudWrapperBase *>(p);
-                  if (pbase->isPrimitive() && pbase->isChangedLocally() && pbase->isReadableByCloud())
-                  {
-                    p->updateLocalTimestamp();
-                  }
+                  if (p->isDifferentFromCloud())
+                    p->provideEcho();
                 });
 }
 
-void updateProperty(PropertyContainer & prop_cont, String propertyName, unsigned long cloudChangeEventTime, bool const is_sync_message, std::list<CborMapData> * map_data_list)
+void updateTimestampOnLocallyChangedProperties(PropertyContainer & prop_cont)
 {
-  Property * property = getProperty(prop_cont, propertyName);
+  /* This function updates the timestamps on the primitive properties 
+   * that have been modified locally since last cloud synchronization
+   */
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+  prop_cont.applyShared();
+#endif
+  prop_cont.applyUpdatesFromISR();
+  for (size_t idx = prop_cont.nextPrimitive(0); idx < prop_cont.size(); idx = prop_cont.nextPrimitive(idx + 1))
+  {
+    CloudWrapperBase * pbase = reinterpret_cast<CloudWrapperBase *>(prop_cont.at(idx));
+    if (pbase->isChangedLocally() && pbase->isReadableByCloud())
+    {
+      pbase->updateLocalTimestamp();
+    }
+  }
+}
+
+unsigned long millisUntilNextUpdate(PropertyContainer & prop_cont, unsigned long const now)
+{
+  /* Values posted from an interrupt are merged and sent by the next update */
+  if (prop_cont.isPendingFromISR())
+    return 0;
+
+  unsigned long wait = ULONG_MAX;
+
+  /* Clean properties are only waiting for their publish deadline */
+  unsigned long deadline = 0;
+  if (prop_cont.nextDeadline(deadline))
+  {
+    long const remaining = static_cast<long>(deadline - now);
+    wait = (remaining > 0) ? static_cast<unsigned long>(remaining) : 0;
+  }
+
+  for (size_t idx = prop_cont.nextDirty(0); (wait > 0) && (idx < prop_cont.size()); idx = prop_cont.nextDirty(idx + 1))
+  {
+    unsigned long const due = prop_cont.at(idx)->millisUntilDue(now);
+    if (due < wait)
+      wait = due;
+  }
+
+  return wait;
+}
+
+bool isConfirmedUpdatePending(PropertyContainer & prop_cont)
+{
+  for (size_t idx = prop_cont.nextDirty(0); idx < prop_cont.size(); idx = prop_cont.nextDirty(idx + 1))
+  {
+    Property * p = prop_cont.at(idx);
+    if ((p->getReliability() == Reliability::Confirmed) && p->isReadableByCloud() && p->shouldBeUpdated())
+      return true;
+  }
+  return false;
+}
+
+void updateProperty(PropertyContainer & prop_cont, CborStringView const & propertyName, unsigned long cloudChangeEventTime, bool const is_sync_message, CborMapDataList * map_data_list)
+{
+  updateProperty(prop_cont.find(propertyName), cloudChangeEventTime, is_sync_message, map_data_list);
+}
+
+void updateProperty(Property * property, unsigned long cloudChangeEventTime, bool const is_sync_message, CborMapDataList * map_data_list, bool const is_peer_message)
+{
+  if (property && property->isWriteableByCloud() && is_peer_message)
+  {
+    property->setAttributesFromCloud(map_data_list);
+    property->fromCloudToLocal();
+    property->execCallbackOnChange();
+    return;
+  }
 
   if (property && property->isWriteableByCloud())
   {
+#if AIOT_CONFIG_INCREMENTAL_SYNC_ENABLED
+    bool const is_known_cloud_change = (cloudChangeEventTime != 0) && (cloudChangeEventTime == property->getLastCloudChangeTimestamp());
+#endif
     property->setLastCloudChangeTimestamp(cloudChangeEventTime);
     property->setAttributesFromCloud(map_data_list);
+#if AIOT_CONFIG_INCREMENTAL_SYNC_ENABLED
+    /* The value already received from the cloud is unchanged, there is nothing to reconcile */
+    if (is_sync_message && is_known_cloud_change && !property->isDifferentFromCloud()) {
+      return;
+    }
+#endif
     if (is_sync_message) {
-      property->execCallbackOnSync();
+      if (!property->markSyncPending())
+        property->execCallbackOnSync();
     } else {
       property->fromCloudToLocal();
+      property->onCloudChangeReceived();
       property->execCallbackOnChange();
       property->provideEcho();
     }
   }
 }
 
+void resolveSync(PropertyContainer & prop_cont)
+{
+  for (size_t idx = prop_cont.nextSyncPending(0); idx < prop_cont.size(); idx = prop_cont.nextSyncPending(idx + 1))
+  {
+    Property * p = prop_cont.at(idx);
+    OnSyncCallbackFunc const func = p->onSyncCallback();
+
+    if (func == nullptr || func == onForceDeviceSync)
+      continue;
+
+    if (func == onForceCloudSync ||
+       (func == onAutoSync && p->getLastCloudChangeTimestamp() > p->getLastLocalChangeTimestamp()))
+    {
+      p->fromCloudToLocal();
+      p->execCallbackOnChange();
+    }
+    else if (func != onAutoSync)
+    {
+      p->execCallbackOnSync();
+    }
+  }
+  prop_cont.clearSyncPending();
+}
+
 String getPropertyNameByIdentifier(PropertyContainer & prop_cont, int propertyIdentifier)
 {
   Property * property = nullptr;
@@ -147,7 +291,7 @@ String getPropertyNameByIdentifier(PropertyContainer & prop_cont, int propertyId
    INTERNAL FUNCTION DEFINITION
  ******************************************************************************/
 
-void addProperty(PropertyContainer & prop_cont, Property * property_obj, int propertyIdentifier)
+bool addProperty(PropertyContainer & prop_cont, Property * property_obj, int propertyIdentifier)
 {
   if (propertyIdentifier != -1)
   {
@@ -158,5 +302,252 @@ void addProperty(PropertyContainer & prop_cont, Property * property_obj, int pro
   {
     property_obj->setIdentifier(prop_cont.size() + 1); /* This is in order to stay compatible to the old system of first increasing _numProperties and then assigning it here. */
   }
-  prop_cont.push_back(property_obj);
+  return prop_cont.add(property_obj);
+}
+
+/******************************************************************************
+   PropertyContainer MEMBER FUNCTIONS
+ ******************************************************************************/
+
+size_t const PropertyContainer::CAPACITY;
+
+PropertyContainer::PropertyContainer()
+: _dirty{0}
+, _readable{0}
+, _primitive{0}
+, _scheduled{0}
+, _appended{0}
+, _sync_pending{0}
+#if AIOT_CONFIG_RULES_ENABLED
+, _changed{0}
+#endif
+, _deadline_heap_size{0}
+, _size{0}
+, _is_pending_from_isr{false}
+{
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+  for (size_t i = 0; i < BITMAP_SIZE; i++)
+    _shared[i].store(0, std::memory_order_relaxed);
+#endif
+}
+
+bool PropertyContainer::add(Property * property)
+{
+  if (full())
+    return false;
+
+  uint8_t const pos = static_cast<uint8_t>(_size);
+  _property[pos] = property;
+
+  /* A property shared with a temporary container keeps reporting
+   * its changes to the container it has been added to at first.
+   */
+  if (!property->isAttachedToContainer())
+    property->setContainer(this, pos);
+  if (property->isReadableByCloud())
+    _readable[pos / 32] |= (1UL << (pos % 32));
+  markDirty(pos);
+  if (property->isPrimitive() && !property->isChangeDetectionManual())
+    _primitive[pos / 32] |= (1UL << (pos % 32));
+
+  /* Insert after any entry with the same key so that a lookup
+   * returns the property which has been added first, same as a
+   * linear scan from the beginning of the container would.
+   */
+  uint8_t * name_pos =
+    std::upper_bound(_name_index,
+                     _name_index + _size,
+                     CborStringView(property->c_name()),
+                     [this](CborStringView const & n, uint8_t const idx) -> bool
+                     {
+                       return (n.compare(CborStringView(_property[idx]->c_name())) < 0);
+                     });
+  std::copy_backward(name_pos, _name_index + _size, _name_index + _size + 1);
+  *name_pos = pos;
+
+  uint8_t * identifier_pos =
+    std::upper_bound(_identifier_index,
+                     _identifier_index + _size,
+                     property->identifier(),
+                     [this](int const id, uint8_t const idx) -> bool
+                     {
+                       return (id < _property[idx]->identifier());
+                     });
+  std::copy_backward(identifier_pos, _identifier_index + _size, _identifier_index + _size + 1);
+  *identifier_pos = pos;
+
+  _size++;
+  return true;
+}
+
+size_t PropertyContainer::nextSet(uint32_t const * bitmap, size_t idx) const
+{
+  while (idx < _size)
+  {
+    uint32_t const word = bitmap[idx / 32] >> (idx % 32);
+    if (word) {
+      idx += __builtin_ctz(word);
+      break;
+    }
+    idx = ((idx / 32) + 1) * 32;
+  }
+  return (idx < _size) ? idx : _size;
+}
+
+void PropertyContainer::scheduleDirty(size_t const idx, unsigned long const deadline)
+{
+  if (_scheduled[idx / 32] & (1UL << (idx % 32)))
+    return;
+
+  _scheduled[idx / 32] |= (1UL << (idx % 32));
+  _property[idx]->setScheduledDeadline(deadline);
+
+  /* Sift up */
+  size_t child = _deadline_heap_size++;
+  _deadline_heap[child] = static_cast<uint8_t>(idx);
+  while (child > 0)
+  {
+    size_t const parent = (child - 1) / 2;
+    if (!isEarlier(child, parent))
+      break;
+    std::swap(_deadline_heap[child], _deadline_heap[parent]);
+    child = parent;
+  }
+}
+
+void PropertyContainer::processDeadlines(unsigned long const now)
+{
+  while (_deadline_heap_size > 0)
+  {
+    uint8_t const idx = _deadline_heap[0];
+    if (static_cast<long>(now - _property[idx]->getScheduledDeadline()) < 0)
+      break;
+
+    /* Pop the earliest deadline and sift down */
+    _deadline_heap[0] = _deadline_heap[--_deadline_heap_size];
+    size_t parent = 0;
+    for (;;)
+    {
+      size_t const left = 2 * parent + 1, right = left + 1;
+      size_t earliest = parent;
+      if (left < _deadline_heap_size && isEarlier(left, earliest))
+        earliest = left;
+      if (right < _deadline_heap_size && isEarlier(right, earliest))
+        earliest = right;
+      if (earliest == parent)
+        break;
+      std::swap(_deadline_heap[parent], _deadline_heap[earliest]);
+      parent = earliest;
+    }
+
+    _scheduled[idx / 32] &= ~(1UL << (idx % 32));
+    markDirty(idx);
+  }
+}
+
+void PropertyContainer::provideEcho(uint32_t const * bitmap)
+{
+  for (size_t idx = nextSet(bitmap, 0); idx < _size; idx = nextSet(bitmap, idx + 1))
+    _property[idx]->provideEcho();
+}
+
+bool PropertyContainer::canProvideEcho(uint32_t const * bitmap) const
+{
+  for (size_t idx = nextSet(bitmap, 0); idx < _size; idx = nextSet(bitmap, idx + 1))
+  {
+    if (!_property[idx]->isEchoComplete())
+      return false;
+  }
+  return true;
+}
+
+bool PropertyContainer::nextDeadline(unsigned long & deadline) const
+{
+  if (_deadline_heap_size == 0)
+    return false;
+
+  deadline = _property[_deadline_heap[0]]->getScheduledDeadline();
+  return true;
+}
+
+void PropertyContainer::applyUpdatesFromISR()
+{
+  if (!_is_pending_from_isr)
+    return;
+
+  /* Cleared before reading the mailboxes, so a value posted meanwhile is
+   * either merged now or marks the container pending again.
+   */
+  _is_pending_from_isr = false;
+  for (size_t idx = 0; idx < _size; idx++)
+    _property[idx]->applyUpdatesFromISR();
+}
+
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+void PropertyContainer::applyShared()
+{
+  for (size_t w = 0; w < BITMAP_SIZE; w++)
+  {
+    /* A store() after the exchange marks the property again for the next call */
+    uint32_t bits = _shared[w].exchange(0, std::memory_order_acquire);
+    while (bits)
+    {
+      size_t const bit = __builtin_ctz(bits);
+      bits &= bits - 1;
+      _property[(w * 32) + bit]->applyShared();
+    }
+  }
+}
+#endif
+
+bool PropertyContainer::isEarlier(size_t const lhs, size_t const rhs) const
+{
+  /* Compare the difference in order to handle a millis() overflow */
+  unsigned long const lhs_deadline = _property[_deadline_heap[lhs]]->getScheduledDeadline();
+  unsigned long const rhs_deadline = _property[_deadline_heap[rhs]]->getScheduledDeadline();
+  return static_cast<long>(lhs_deadline - rhs_deadline) < 0;
+}
+
+Property * PropertyContainer::find(String const & name) const
+{
+  return find(CborStringView(name));
+}
+
+Property * PropertyContainer::find(char const * name) const
+{
+  return find(CborStringView(name));
+}
+
+Property * PropertyContainer::find(CborStringView const & name) const
+{
+  uint8_t const * iter =
+    std::lower_bound(_name_index,
+                     _name_index + _size,
+                     name,
+                     [this](uint8_t const idx, CborStringView const & n) -> bool
+                     {
+                       return (CborStringView(_property[idx]->c_name()).compare(n) < 0);
+                     });
+
+  if ((iter == _name_index + _size) || (CborStringView(_property[*iter]->c_name()) != name))
+    return nullptr;
+  else
+    return _property[*iter];
+}
+
+Property * PropertyContainer::find(int const identifier) const
+{
+  uint8_t const * iter =
+    std::lower_bound(_identifier_index,
+                     _identifier_index + _size,
+                     identifier,
+                     [this](uint8_t const idx, int const id) -> bool
+                     {
+                       return (_property[idx]->identifier() < id);
+                     });
+
+  if ((iter == _identifier_index + _size) || (_property[*iter]->identifier() != identifier))
+    return nullptr;
+  else
+    return _property[*iter];
 }
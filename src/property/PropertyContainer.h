@@ -23,8 +23,10 @@
  ******************************************************************************/
 
 #include <Arduino.h>
+#include <AIoTC_Config.h>
 
 #include "Property.h"
+#include "PropertyGroup.h"
 
 #ifdef __AVR__
 # include <Arduino_AVRSTL.h>
@@ -32,27 +34,36 @@
 
 #undef max
 #undef min
-#include <list>
+
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+# include <atomic>
+#endif
 
 #include "types/CloudBool.h"
 #include "types/CloudFloat.h"
 #include "types/CloudInt.h"
 #include "types/CloudUnsignedInt.h"
 #include "types/CloudString.h"
+#include "types/CloudBinary.h"
 #include "types/CloudLocation.h"
-#include "types/CloudSchedule.h"
+#if AIOT_CONFIG_SCHEDULE_ENABLED
+# include "types/CloudSchedule.h"
+#endif
+#include "types/CloudSeries.h"
 #include "types/CloudColor.h"
 #include "types/CloudWrapperBase.h"
 
-#include "types/automation/CloudColoredLight.h"
-#include "types/automation/CloudContactSensor.h"
-#include "types/automation/CloudDimmedLight.h"
-#include "types/automation/CloudLight.h"
-#include "types/automation/CloudMotionSensor.h"
-#include "types/automation/CloudSmartPlug.h"
-#include "types/automation/CloudSwitch.h"
-#include "types/automation/CloudTemperatureSensor.h"
-#include "types/automation/CloudTelevision.h"
+#if AIOT_CONFIG_AUTOMATION_TYPES_ENABLED
+# include "types/automation/CloudColoredLight.h"
+# include "types/automation/CloudContactSensor.h"
+# include "types/automation/CloudDimmedLight.h"
+# include "types/automation/CloudLight.h"
+# include "types/automation/CloudMotionSensor.h"
+# include "types/automation/CloudSmartPlug.h"
+# include "types/automation/CloudSwitch.h"
+# include "types/automation/CloudTemperatureSensor.h"
+# include "types/automation/CloudTelevision.h"
+#endif
 
 /******************************************************************************
    DECLARATION OF getTime
@@ -61,10 +72,170 @@
 extern "C" unsigned long getTime();
 
 /******************************************************************************
-   TYPEDEF
+   CLASS DECLARATION
  ******************************************************************************/
 
-typedef std::list<Property *> PropertyContainer;
+/* The PropertyContainer keeps the properties in insertion order, which is
+ * the order used by the encoder, and additionally maintains two sorted
+ * indices over the property name and the property identifier. This allows
+ * to lookup a property via binary search instead of a linear list scan.
+ * All storage is a contiguous fixed-size array sized at compile time via
+ * AIOT_CONFIG_PROPERTY_CONTAINER_CAPACITY, so adding properties does not
+ * allocate and the encoder can resume at any index in constant time.
+ */
+class PropertyContainer
+{
+  public:
+
+    static size_t const CAPACITY = AIOT_CONFIG_PROPERTY_CONTAINER_CAPACITY;
+    static size_t const BITMAP_SIZE = (CAPACITY + 31) / 32;
+
+    typedef Property *       * iterator;
+    typedef Property * const * const_iterator;
+
+    PropertyContainer();
+
+    inline iterator       begin()       { return _property; }
+    inline iterator       end  ()       { return _property + _size; }
+    inline const_iterator begin() const { return _property; }
+    inline const_iterator end  () const { return _property + _size; }
+    inline size_t         size () const { return _size; }
+    inline bool           empty() const { return _size == 0; }
+    inline bool           full () const { return _size >= CAPACITY; }
+    inline Property *     at   (size_t const idx) const { return _property[idx]; }
+
+    /* Returns false if the container has already reached its capacity. */
+    bool       add (Property * property);
+    Property * find(String const & name) const;
+    Property * find(char const * name) const;
+    Property * find(CborStringView const & name) const;
+    Property * find(int const identifier) const;
+
+    /* A property is dirty if it may need to be sent to the cloud. Clean
+     * properties are skipped by the encoder without evaluating them, those
+     * which the cloud can not read never become dirty.
+     */
+    inline void markDirty (size_t const idx)       { _dirty[idx / 32] |=  (1UL << (idx % 32)) & _readable[idx / 32]; }
+    inline void clearDirty(size_t const idx)       { _dirty[idx / 32] &= ~(1UL << (idx % 32)); }
+    inline bool isDirty   (size_t const idx) const { return (_dirty[idx / 32] & (1UL << (idx % 32))) != 0; }
+
+    /* Return the position of the next dirty/primitive property starting
+     * from (and including) 'idx' or size() if there is none.
+     */
+    inline size_t nextDirty    (size_t const idx) const { return nextSet(_dirty, idx); }
+    inline size_t nextPrimitive(size_t const idx) const { return nextSet(_primitive, idx); }
+    /* Primitive properties which report their changes themselves are skipped by nextPrimitive() */
+    inline void excludeFromChangeScan(size_t const idx) { _primitive[idx / 32] &= ~(1UL << (idx % 32)); }
+
+    /* The properties appended to the message encoded last, BITMAP_SIZE words.
+     * Should the message get lost they are sent again by provideEcho() with
+     * their current values rather than the ones of the message.
+     */
+    inline void             clearAppended()                       { memset(_appended, 0, sizeof(_appended)); }
+    inline void             markAppended (size_t const idx)       { _appended[idx / 32] |= (1UL << (idx % 32)); }
+    inline uint32_t const * appended     ()                 const { return _appended; }
+    void provideEcho(uint32_t const * bitmap);
+    /* Returns false if any of the properties would lose data that way */
+    bool canProvideEcho(uint32_t const * bitmap) const;
+
+    /* Mark the property dirty again as soon as 'deadline' has expired. A
+     * property which is already scheduled keeps its earlier deadline.
+     */
+    void scheduleDirty(size_t const idx, unsigned long const deadline);
+    /* Mark all properties dirty whose deadline has expired at 'now'. */
+    void processDeadlines(unsigned long const now);
+    /* Returns false if no property is scheduled, otherwise the earliest deadline. */
+    bool nextDeadline(unsigned long & deadline) const;
+
+    /* The properties of a shadow message whose sync policy has not been
+     * applied yet, see resolveSync().
+     */
+    inline void   markSyncPending(size_t const idx)       { _sync_pending[idx / 32] |= (1UL << (idx % 32)); }
+    inline size_t nextSyncPending(size_t const idx) const { return nextSet(_sync_pending, idx); }
+    inline void   clearSyncPending()                      { memset(_sync_pending, 0, sizeof(_sync_pending)); }
+
+    /* Set by a property written from an interrupt until applyUpdatesFromISR()
+     * has merged the mailboxes of all properties. A plain store suffices.
+     */
+    inline void markPendingFromISR()       { _is_pending_from_isr = true; }
+    inline bool isPendingFromISR  () const { return _is_pending_from_isr; }
+    void applyUpdatesFromISR();
+
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    /* A property is shared after store() until applyShared() has taken over
+     * its value. Only these bits are written from other cores.
+     */
+    inline void markShared(size_t const idx) { _shared[idx / 32].fetch_or(1UL << (idx % 32), std::memory_order_release); }
+    void applyShared();
+#endif
+
+#if AIOT_CONFIG_RULES_ENABLED
+    /* A property is changed from a local write, a write of the cloud or of a
+     * peer until the rule engine has taken the change, see RuleEngine.h.
+     */
+    inline void markChanged(size_t const idx)       { _changed[idx / 32] |= (1UL << (idx % 32)); }
+    inline bool takeChanged(size_t const idx) {
+      uint32_t const bit = 1UL << (idx % 32);
+      bool const is_changed = (_changed[idx / 32] & bit) != 0;
+      _changed[idx / 32] &= ~bit;
+      return is_changed;
+    }
+#endif
+
+  private:
+
+    static_assert(CAPACITY <= 255, "AIOT_CONFIG_PROPERTY_CONTAINER_CAPACITY must not exceed 255");
+
+    Property * _property[CAPACITY];
+    /* Positions within _property, sorted by name and identifier respectively. */
+    uint8_t    _name_index[CAPACITY];
+    uint8_t    _identifier_index[CAPACITY];
+    uint32_t   _dirty[BITMAP_SIZE];
+    uint32_t   _readable[BITMAP_SIZE];
+    uint32_t   _primitive[BITMAP_SIZE];
+    uint32_t   _scheduled[BITMAP_SIZE];
+    uint32_t   _appended[BITMAP_SIZE];
+    uint32_t   _sync_pending[BITMAP_SIZE];
+#if AIOT_CONFIG_RULES_ENABLED
+    uint32_t   _changed[BITMAP_SIZE];
+#endif
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    std::atomic<uint32_t> _shared[BITMAP_SIZE];
+#endif
+    /* Binary min-heap of positions within _property ordered by the scheduled deadline */
+    uint8_t    _deadline_heap[CAPACITY];
+    size_t     _deadline_heap_size;
+    size_t     _size;
+    volatile bool _is_pending_from_isr;
+
+    size_t nextSet(uint32_t const * bitmap, size_t idx) const;
+    bool   isEarlier(size_t const lhs, size_t const rhs) const;
+};
+
+/* Entry of a property schema, i.e. a table of all properties of a thing.
+ * As it only refers to properties with static storage duration and to
+ * string literals it is constant-initialized and can reside in flash. The
+ * names are referenced by the properties instead of being copied:
+ *
+ *   static PropertySchemaEntry const schema[] = {
+ *     AIOT_PROPERTY(led, Permission::ReadWrite),
+ *     AIOT_PROPERTY(temperature, Permission::Read),
+ *   };
+ */
+struct PropertySchemaEntry
+{
+  Property *   property;
+  char const * name;
+  Permission   permission;
+  int          identifier;
+};
+
+#define AIOT_PROPERTY(v, permission)             { &(v), #v, (permission), -1 }
+#define AIOT_PROPERTY_ID(v, identifier, permission) { &(v), #v, (permission), (identifier) }
+
+/******************************************************************************
+   TYPEDEF
+ ******************************************************************************/
 
 typedef CloudFloat CloudEnergy;
 typedef CloudFloat CloudForce;
@@ -101,6 +272,10 @@ typedef CloudFloat CloudRelativeHumidity;
    FUNCTION DECLARATION
  ******************************************************************************/
 
+/* Once the container holds AIOT_CONFIG_PROPERTY_CONTAINER_CAPACITY properties
+ * a new one is not added, which is reported with DEBUG_ERROR. The property is
+ * returned nonetheless, isAttachedToContainer() tells whether it was added.
+ */
 Property & addPropertyToContainer(PropertyContainer & prop_cont,
                                   Property & property,
                                   String const & name,
@@ -108,14 +283,63 @@ Property & addPropertyToContainer(PropertyContainer & prop_cont,
                                   int propertyIdentifier = -1,
                                   GetTimeCallbackFunc func = getTime);
 
-  
+Property & addPropertyToContainer(PropertyContainer & prop_cont,
+                                  Property & property,
+                                  char const * name,
+                                  Permission const permission,
+                                  int propertyIdentifier = -1,
+                                  GetTimeCallbackFunc func = getTime);
+
+/* The name is referenced by the property instead of being copied */
+Property & addPropertyToContainer(PropertyContainer & prop_cont,
+                                  Property & property,
+                                  LiteralName const name,
+                                  Permission const permission,
+                                  int propertyIdentifier = -1,
+                                  GetTimeCallbackFunc func = getTime);
+
+/* Adds all properties of the schema in order, returns false if they do not
+ * fit into the container or if a name has already been added before.
+ */
+bool addPropertiesToContainer(PropertyContainer & prop_cont,
+                              PropertySchemaEntry const * schema,
+                              size_t const size,
+                              GetTimeCallbackFunc func = getTime);
+
+template <size_t N>
+inline bool addPropertiesToContainer(PropertyContainer & prop_cont,
+                                     PropertySchemaEntry const (&schema)[N],
+                                     GetTimeCallbackFunc func = getTime)
+{
+  static_assert(N <= PropertyContainer::CAPACITY, "The property schema exceeds AIOT_CONFIG_PROPERTY_CONTAINER_CAPACITY");
+  return addPropertiesToContainer(prop_cont, schema, N, func);
+}
+
 Property * getProperty(PropertyContainer & prop_cont, String const & name);
+Property * getProperty(PropertyContainer & prop_cont, char const * name);
 Property * getProperty(PropertyContainer & prop_cont, int const identifier);
+/* Returns the primitive wrapper property of the variable at 'value' */
+Property * getPrimitiveProperty(PropertyContainer & prop_cont, void const * value);
 
 
 void updateTimestampOnLocallyChangedProperties(PropertyContainer & prop_cont);
+/* Milliseconds until a property of the container is due to be sent, ULONG_MAX if none is pending */
+unsigned long millisUntilNextUpdate(PropertyContainer & prop_cont, unsigned long const now);
+/* True if a property with Reliability::Confirmed is due to be sent */
+bool isConfirmedUpdatePending(PropertyContainer & prop_cont);
 void requestUpdateForAllProperties(PropertyContainer & prop_cont);
-void updateProperty(PropertyContainer & prop_cont, String propertyName, unsigned long cloudChangeEventTime, bool const is_sync_message, std::list<CborMapData> * map_data_list);
+/* Return false if the property, or one of the group, is not in the container */
+bool requestUpdateForProperty(PropertyContainer & prop_cont, Property * property);
+bool requestUpdateForGroup(PropertyContainer & prop_cont, PropertyGroup const & group);
+void requestUpdateForChangedProperties(PropertyContainer & prop_cont);
+void updateProperty(PropertyContainer & prop_cont, CborStringView const & propertyName, unsigned long cloudChangeEventTime, bool const is_sync_message, CborMapDataList * map_data_list);
+/* An update mirrored by a peer is neither echoed nor taken as a change of the cloud */
+void updateProperty(Property * property, unsigned long cloudChangeEventTime, bool const is_sync_message, CborMapDataList * map_data_list, bool const is_peer_message = false);
+/* Applies the sync policies of all properties taken from a shadow message.
+ * The built-in policies are resolved in place, only custom sync callbacks
+ * are dispatched (and possibly deferred) one by one.
+ */
+void resolveSync(PropertyContainer & prop_cont);
 String getPropertyNameByIdentifier(PropertyContainer & prop_cont, int propertyIdentifier);
 
 #endif /* ARDUINO_PROPERTY_CONTAINER_H_ */
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include "PropertyGroup.h"
+
+/******************************************************************************
+   CTOR/DTOR
+ ******************************************************************************/
+
+uint32_t PropertyGroup::_message = 0;
+
+PropertyGroup::PropertyGroup(char const * name)
+: _size{0}
+, _name{name}
+, _min_time_between_updates_millis{0}
+, _last_published_millis{0}
+, _published_message{0}
+, _next{nullptr}
+{
+
+}
+
+/******************************************************************************
+   PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool PropertyGroup::add(Property & property)
+{
+  for (Property * p : *this)
+  {
+    if (p == &property)
+      return true;
+  }
+  if (_size >= CAPACITY)
+    return false;
+  _property[_size++] = &property;
+  property.setGroup(this);
+  return true;
+}
+
+PropertyGroup & PropertyGroup::publishOnChange(unsigned long const min_time_between_updates_millis)
+{
+  _min_time_between_updates_millis = min_time_between_updates_millis;
+  return (*this);
+}
+
+void PropertyGroup::onPublished(unsigned long const now)
+{
+  /* Only the first member of a message starts the next window */
+  if (_published_message != _message)
+  {
+    _published_message = _message;
+    _last_published_millis = now;
+  }
+}
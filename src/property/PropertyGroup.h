@@ -0,0 +1,98 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_PROPERTY_GROUP_H_
+#define ARDUINO_PROPERTY_GROUP_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+
+#include "Property.h"
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* A set of properties the sketch forces out together with push(group), e.g.
+ * the readings of one sensor, without marking all the others as push() does:
+ *
+ *   PropertyGroup climate;
+ *   climate.add(ArduinoCloud.addProperty(temperature, Permission::Read));
+ *   climate.add(ArduinoCloud.addProperty(humidity, Permission::Read));
+ *   ...
+ *   ArduinoCloud.push(climate);
+ *
+ * A named group, e.g. ArduinoCloud.group("pump1_"), serves as SenML base name
+ * of the records of its members whose names start with it, given SenML base
+ * values are encoded. A rate limit of the group holds back the changes of all
+ * its members until the group may publish again, the members published by a
+ * single message count as one publication of the group. A property takes the
+ * name and the rate limit of the first group it is added to.
+ */
+class PropertyGroup
+{
+  public:
+
+    static size_t const CAPACITY = AIOT_CONFIG_PROPERTY_GROUP_CAPACITY;
+
+    typedef Property * const * const_iterator;
+
+    PropertyGroup(char const * name = nullptr);
+
+    /* Returns false if the group is full, a property is only added once */
+    bool add(Property & property);
+    PropertyGroup & publishOnChange(unsigned long const min_time_between_updates_millis);
+
+    inline const_iterator begin() const { return _property; }
+    inline const_iterator end  () const { return _property + _size; }
+    inline size_t         size () const { return _size; }
+    inline char const *   name () const { return _name; }
+
+    /* Evaluated for the group as a whole ahead of the policy of each member */
+    inline bool isHeld(unsigned long const now) const {
+      return (_published_message != 0) && (_published_message != _message) && ((now - _last_published_millis) < _min_time_between_updates_millis);
+    }
+    inline unsigned long getRateLimitDeadline() const {
+      return _last_published_millis + _min_time_between_updates_millis;
+    }
+    void onPublished(unsigned long const now);
+    /* Called by the encoder for every message it encodes */
+    static inline void beginMessage() { if (++_message == 0) _message = 1; }
+
+    /* Links the groups created by ArduinoCloud.group() */
+    inline PropertyGroup * next() const { return _next; }
+    inline void setNext(PropertyGroup * next) { _next = next; }
+
+  private:
+
+    Property * _property[CAPACITY];
+    size_t     _size;
+    char const * _name;
+    unsigned long _min_time_between_updates_millis;
+    unsigned long _last_published_millis;
+    uint32_t   _published_message;
+    PropertyGroup * _next;
+
+    static uint32_t _message;
+};
+
+#endif /* ARDUINO_PROPERTY_GROUP_H_ */
@@ -0,0 +1,60 @@
+//
+// This file is part of ArduinoCloudThing
+//
+// Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+//
+// This software is released under the GNU General Public License version 3,
+// which covers the main part of ArduinoCloudThing.
+// The terms of this license can be found at:
+// https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// You can be released from the requirements of the above licenses by purchasing
+// a commercial license. Buying such a license is mandatory if you want to modify or
+// otherwise use the software for commercial activities involving the Arduino
+// software without disclosing the source code of your own applications. To purchase
+// a commercial license, send an email to license@arduino.cc.
+//
+
+#ifndef ARDUINO_CLOUD_SHARED_VALUE_H_
+#define ARDUINO_CLOUD_SHARED_VALUE_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+
+#include "../utility/thread/SeqLock.h"
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Double buffer between the value of a property, which is only accessed on
+ * the core calling update(), and one other core or interrupt. Each buffer
+ * has a single writer: the other side writes the stored value via store()
+ * and the property publishes each value it takes on for load().
+ */
+template <typename T>
+class SharedValue
+{
+  public:
+    SharedValue(T const & value) : _stored(value), _published(value) {}
+    SharedValue(SharedValue const & other) : _stored(other._stored), _published(other._published) {}
+
+    inline void store (T const & value)       { _stored.write(value); }
+    inline void stored(T & value) const       { _stored.read(value); }
+
+    inline void publish(T const & value)      { _published.write(value); }
+    inline void load   (T & value) const      { _published.read(value); }
+
+  private:
+    SeqLock<T> _stored;
+    SeqLock<T> _published;
+};
+
+#endif /* AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED */
+
+#endif /* ARDUINO_CLOUD_SHARED_VALUE_H_ */
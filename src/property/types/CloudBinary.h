@@ -0,0 +1,132 @@
+//
+// This file is part of ArduinoCloudThing
+//
+// Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+//
+// This software is released under the GNU General Public License version 3,
+// which covers the main part of ArduinoCloudThing.
+// The terms of this license can be found at:
+// https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// You can be released from the requirements of the above licenses by purchasing
+// a commercial license. Buying such a license is mandatory if you want to modify or
+// otherwise use the software for commercial activities involving the Arduino
+// software without disclosing the source code of your own applications. To purchase
+// a commercial license, send an email to license@arduino.cc.
+//
+
+#ifndef CLOUDBINARY_H_
+#define CLOUDBINARY_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <string.h>
+
+#include <Arduino.h>
+#include "../Property.h"
+#if AIOT_CONFIG_COMPRESSION_ENABLED
+  #include "../../utility/compress/LZSSBlock.h"
+#endif
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Binary data sent as a CBOR byte string (SenML "vd") straight from a buffer
+ * owned by the sketch, which avoids hex or base64 encoding it into a String.
+ * A value received from the cloud is copied from the payload into the same
+ * buffer, a value larger than the buffer is ignored. A compressed value only
+ * turns out to be too large while decompressing it, it empties the buffer. As there is no separate
+ * copy of the cloud value, a received value always replaces the local one.
+ */
+class CloudBinary : public Property {
+  private:
+    uint8_t *    _buffer;
+    size_t const _capacity;
+    size_t       _length;
+    bool         _is_changed;
+  public:
+    CloudBinary(uint8_t * buffer, size_t const capacity, size_t const length = 0)
+    : _buffer(buffer)
+    , _capacity(capacity)
+    , _length((length < capacity) ? length : capacity)
+    , _is_changed(false)
+    { }
+
+    inline uint8_t * data    () const { return _buffer; }
+    inline size_t    length  () const { return _length; }
+    inline size_t    capacity() const { return _capacity; }
+
+    /* To be called once the sketch has written a new value into data() */
+    void setLength(size_t const length) {
+      _length = (length < _capacity) ? length : _capacity;
+      _is_changed = true;
+      updateLocalTimestamp();
+    }
+    /* Returns false if the value does not fit into the buffer */
+    bool set(uint8_t const * data, size_t const length) {
+      if (length > _capacity) {
+        return false;
+      }
+      memmove(_buffer, data, length);
+      setLength(length);
+      return true;
+    }
+
+    virtual bool isDifferentFromCloud() {
+      return _is_changed;
+    }
+    virtual void fromCloudToLocal() {
+      /* The received value has already been written into the buffer */
+    }
+    virtual void fromLocalToCloud() {
+      _is_changed = false;
+    }
+    virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
+#if AIOT_CONFIG_COMPRESSION_ENABLED
+      CborError err = CborNoError;
+      if (appendCompressedAttribute(_buffer, _length, "", encoder, err)) {
+        return err;
+      }
+#endif
+      return appendAttributeName("", [this](CborEncoder & mapEncoder)
+      {
+        CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::DataValue)));
+        CHECK_CBOR(cbor_encode_byte_string(&mapEncoder, _buffer, _length));
+        return CborNoError;
+      }, encoder);
+    }
+    virtual void setAttributesFromCloud() {
+      setAttribute("", [this](CborMapData & md) {
+#if AIOT_CONFIG_COMPRESSION_ENABLED
+        if (md.content_encoding.isSet()) {
+          /* A value of an unknown encoding is ignored */
+          if (!md.value.isData() || (md.content_encoding.get() != static_cast<int>(ContentEncoding::LZSS))) {
+            return;
+          }
+          CborStringView const value = md.value.data();
+          size_t length = 0;
+          if (!LZSSBlock::decompress(reinterpret_cast<uint8_t const *>(value.data()), value.length(), _buffer, _capacity, length)) {
+            length = 0;
+          }
+          _length = length;
+          _is_changed = false;
+          return;
+        }
+#endif
+        if (!md.value.isData() || (md.value.data().length() > _capacity)) {
+          return;
+        }
+        CborStringView const value = md.value.data();
+        if (value.length() > 0) {
+          memcpy(_buffer, value.data(), value.length());
+        }
+        _length = value.length();
+        _is_changed = false;
+      });
+    }
+};
+
+#endif /* CLOUDBINARY_H_ */
@@ -24,6 +24,7 @@
 
 #include <Arduino.h>
 #include "../Property.h"
+#include "../SharedValue.h"
 
 /******************************************************************************
    CLASS DECLARATION
@@ -35,19 +36,49 @@ class CloudBool : public Property {
   protected:
     bool  _value,
           _cloud_value;
-  public:
-    CloudBool()                                           {
-      CloudBool(false);
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    SharedValue<bool> _shared;
+#endif
+    virtual void mergeFromISR(bool const is_set, int32_t const value, int32_t const delta) {
+      (void)delta;
+      if (is_set)
+        operator=(value != 0);
     }
-    CloudBool(bool v) : _value(v), _cloud_value(v) {}
+  public:
+    CloudBool() : CloudBool(false) {}
+    CloudBool(bool v) : _value(v), _cloud_value(v)
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    , _shared(v)
+#endif
+    {}
     operator bool() const                             {
       return _value;
     }
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    /* Thread and interrupt safe access from one other core, see AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED */
+    void store(bool const v) {
+      _shared.store(v);
+      markShared();
+    }
+    bool load() const {
+      bool v;
+      _shared.load(v);
+      return v;
+    }
+    virtual void applyShared() {
+      bool v;
+      _shared.stored(v);
+      operator=(v);
+    }
+#endif
     virtual bool isDifferentFromCloud() {
       return _value != _cloud_value;
     }
     virtual void fromCloudToLocal() {
       _value = _cloud_value;
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+      _shared.publish(_value);
+#endif
     }
     virtual void fromLocalToCloud() {
       _cloud_value = _value;
@@ -58,9 +89,27 @@ class CloudBool : public Property {
     virtual void setAttributesFromCloud() {
       setAttribute(_cloud_value, "");
     }
+#if AIOT_CONFIG_RULES_ENABLED
+    virtual bool getNumber(float & value) {
+      value = _value ? 1.0f : 0.0f;
+      return true;
+    }
+    virtual bool setNumber(float const value) {
+      if ((value != 0) != _value)
+        operator=(value != 0);
+      return true;
+    }
+#endif
+    /* Interrupt safe, see acceptUpdatesFromISR() */
+    void setFromISR(bool const v) {
+      postValueFromISR(v ? 1 : 0);
+    }
     //modifiers
     CloudBool& operator=(bool v) {
       _value = v;
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+      _shared.publish(v);
+#endif
       updateLocalTimestamp();
       return *this;
     }
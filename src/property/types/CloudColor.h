@@ -25,6 +25,7 @@
 #include <math.h>
 #include <Arduino.h>
 #include "../Property.h"
+#include "../SharedValue.h"
 
 /******************************************************************************
    CLASS DECLARATION
@@ -52,88 +53,97 @@ class Color {
     }
 
     bool setColorRGB(uint8_t R, uint8_t G, uint8_t B) {
-      float temp[3];
-      float max, min, delta;
-      uint8_t imax;
-      temp[0] = (float)R / 255;
-      temp[1] = (float)G / 255;
-      temp[2] = (float)B / 255;
-      max = temp[0];
-      imax = 0;
-      min = temp[0];
+      uint8_t const rgb[3] = {R, G, B};
+      uint8_t max = R, min = R, imax = 0;
 
       for (uint8_t j = 0; j < 3; j++) {
-
-        if (temp[j] >= max) {
-          max = temp[j];
+        if (rgb[j] >= max) {
+          max = rgb[j];
           imax = j;
         }
-        if (temp[j] <= min) {
-          min = temp[j];
+        if (rgb[j] <= min) {
+          min = rgb[j];
         }
       }
 
-      delta = max - min;
+      /* The differences are exact integers, hence a single float division
+       * per component yields the correctly rounded value.
+       */
+      int const delta = max - min;
       if (delta == 0) {
         hue = 0;
       } else if (imax == 0) {
-
-        hue = 60 * fmod((temp[1] - temp[2]) / delta, 6);
+        hue = (60.0f * (G - B)) / delta;
+        /* A hue has to be within [0, 360), which fmod() did not ensure */
+        if (hue < 0) {
+          hue += 360;
+        }
       } else if (imax == 1) {
-        hue = 60 * (((temp[2] - temp[0]) / delta) + 2);
-      } else if (imax == 2) {
-        hue = 60 * (((temp[0] - temp[1]) / delta) + 4);
+        hue = (60.0f * (B - R)) / delta + 120;
+      } else {
+        hue = (60.0f * (R - G)) / delta + 240;
       }
 
       if (max == 0) {
         sat = 0;
       } else {
-        sat = (delta / max) * 100;
+        sat = (100.0f * delta) / max;
       }
 
-      bri = max * 100;
+      bri = (100.0f * max) / 255;
       return true;
     }
 
-    void getRGB(uint8_t& R, uint8_t& G, uint8_t& B) {
-      float fC = (bri / 100) * (sat / 100);
-      float fHPrime = fmod(hue / 60.0, 6);
-      float fX = fC * (1 - fabs(fmod(fHPrime, 2) - 1));
-      float fM = (bri / 100) - fC;
-      float fR, fG, fB;
-
-      if (0 <= fHPrime && fHPrime < 1) {
-        fR = fC;
-        fG = fX;
-        fB = 0;
-      } else if (1 <= fHPrime && fHPrime < 2) {
-        fR = fX;
-        fG = fC;
-        fB = 0;
-      } else if (2 <= fHPrime && fHPrime < 3) {
-        fR = 0;
-        fG = fC;
-        fB = fX;
-      } else if (3 <= fHPrime && fHPrime < 4) {
-        fR = 0;
-        fG = fX;
-        fB = fC;
-      } else if (4 <= fHPrime && fHPrime < 5) {
-        fR = fX;
-        fG = 0;
-        fB = fC;
-      } else if (5 <= fHPrime && fHPrime < 6) {
-        fR = fC;
-        fG = 0;
-        fB = fX;
-      } else {
-        fR = 0;
-        fG = 0;
-        fB = 0;
+    /* Computed in 8.24 fixed point, which rounds like the exact result
+     * except for values which are exactly halfway, these round up.
+     */
+    void getRGB(uint8_t& R, uint8_t& G, uint8_t& B) const {
+      /* Brightness and saturation as fractions of 1, hue within [0, 6) */
+      uint32_t const v = lrintf(bri * (ONE / 100.0f));
+      uint32_t const s = lrintf(sat * (ONE / 100.0f));
+      uint32_t const vmax = v * 255;
+      uint32_t const c = (static_cast<uint64_t>(vmax) * s) >> SHIFT;
+      uint32_t const vmin = vmax - c;
+      uint32_t sector = 6, frac = 0;
+
+      if (hue >= 0) {
+        uint32_t const h = static_cast<uint32_t>(lrintf(hue * (ONE / 60.0f))) % (6UL << SHIFT);
+        sector = h >> SHIFT;
+        frac = h & (ONE - 1);
+        if (sector & 1) {
+          frac = ONE - frac;
+        }
+      }
+
+      uint32_t const vmid = vmin + ((static_cast<uint64_t>(c) * frac) >> SHIFT);
+      uint32_t r, g, b;
+
+      switch (sector) {
+        case 0:  r = vmax; g = vmid; b = vmin; break;
+        case 1:  r = vmid; g = vmax; b = vmin; break;
+        case 2:  r = vmin; g = vmax; b = vmid; break;
+        case 3:  r = vmin; g = vmid; b = vmax; break;
+        case 4:  r = vmid; g = vmin; b = vmax; break;
+        case 5:  r = vmax; g = vmin; b = vmid; break;
+        default: r = vmin; g = vmin; b = vmin; break;
+      }
+
+      R = (r + (ONE / 2)) >> SHIFT;
+      G = (g + (ONE / 2)) >> SHIFT;
+      B = (b + (ONE / 2)) >> SHIFT;
+    }
+
+    /* Batch conversion between colors and consecutive R, G, B bytes, e.g. of a LED strip */
+    static void getColorsRGB(Color const * colors, size_t const count, uint8_t * rgb) {
+      for (size_t i = 0; i < count; i++, rgb += 3) {
+        colors[i].getRGB(rgb[0], rgb[1], rgb[2]);
+      }
+    }
+
+    static void setColorsRGB(Color * colors, size_t const count, uint8_t const * rgb) {
+      for (size_t i = 0; i < count; i++, rgb += 3) {
+        colors[i].setColorRGB(rgb[0], rgb[1], rgb[2]);
       }
-      R = lrint((fR + fM) * 255);
-      G = lrint((fG + fM) * 255);
-      B = lrint((fB + fM) * 255);
     }
 
     Color& operator=(Color & aColor) {
@@ -151,16 +161,56 @@ class Color {
       return !(operator==(aColor));
     }
 
+  private:
+    static uint8_t  const SHIFT = 24;
+    static uint32_t const ONE   = 1UL << SHIFT;
 };
 
+/* In the order of the attribute identifiers */
+static constexpr AttributeEntry<Color> COLOR_ATTRIBUTES[] = {
+  AIOT_ATTRIBUTE(Color, hue),
+  AIOT_ATTRIBUTE(Color, sat),
+  AIOT_ATTRIBUTE(Color, bri),
+};
+static constexpr uint8_t COLOR_ATTRIBUTES_BY_NAME[] = {2 /* bri */, 0 /* hue */, 1 /* sat */};
+static_assert(isSortedByName(COLOR_ATTRIBUTES, COLOR_ATTRIBUTES_BY_NAME, 3), "COLOR_ATTRIBUTES_BY_NAME must be sorted by name");
+
 class CloudColor : public Property {
   private:
     Color _value,
           _cloud_value;
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    SharedValue<Color> _shared;
+#endif
   public:
-    CloudColor() : _value(0, 0, 0), _cloud_value(0, 0, 0) {}
-    CloudColor(float hue, float saturation, float brightness) : _value(hue, saturation, brightness), _cloud_value(hue, saturation, brightness) {}
+    CloudColor() : _value(0, 0, 0), _cloud_value(0, 0, 0)
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    , _shared(Color(0, 0, 0))
+#endif
+    {}
+    CloudColor(float hue, float saturation, float brightness) : _value(hue, saturation, brightness), _cloud_value(hue, saturation, brightness)
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    , _shared(Color(hue, saturation, brightness))
+#endif
+    {}
 
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    /* Thread and interrupt safe access from one other core, see AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED */
+    void store(Color const v) {
+      _shared.store(v);
+      markShared();
+    }
+    Color load() const {
+      Color v(0, 0, 0);
+      _shared.load(v);
+      return v;
+    }
+    virtual void applyShared() {
+      Color v(0, 0, 0);
+      _shared.stored(v);
+      operator=(v);
+    }
+#endif
     virtual bool isDifferentFromCloud() {
 
       return _value != _cloud_value;
@@ -170,6 +220,9 @@ class CloudColor : public Property {
       _value.hue = aColor.hue;
       _value.sat = aColor.sat;
       _value.bri = aColor.bri;
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+      _shared.publish(_value);
+#endif
       updateLocalTimestamp();
       return *this;
     }
@@ -184,20 +237,21 @@ class CloudColor : public Property {
 
     virtual void fromCloudToLocal() {
       _value = _cloud_value;
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+      _shared.publish(_value);
+#endif
     }
     virtual void fromLocalToCloud() {
       _cloud_value = _value;
     }
     virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
-      CHECK_CBOR_MULTI(appendAttribute(_value.hue, "hue", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.sat, "sat", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.bri, "bri", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.hue, _cloud_value.hue, "hue", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.sat, _cloud_value.sat, "sat", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.bri, _cloud_value.bri, "bri", encoder));
       return CborNoError;
     }
     virtual void setAttributesFromCloud() {
-      setAttribute(_cloud_value.hue, "hue");
-      setAttribute(_cloud_value.sat, "sat");
-      setAttribute(_cloud_value.bri, "bri");
+      setAttributesFromTable(COLOR_ATTRIBUTES, COLOR_ATTRIBUTES_BY_NAME, _cloud_value);
     }
 };
 
@@ -25,6 +25,7 @@
 #include <math.h>
 #include <Arduino.h>
 #include "../Property.h"
+#include "../SharedValue.h"
 
 /******************************************************************************
    CLASS DECLARATION
@@ -52,25 +53,104 @@ class Location {
       return !(operator==(aLocation));
     }
     static float distance(Location& loc1, Location& loc2) {
-      return sqrt(pow(loc1.lat - loc2.lat, 2) + pow(loc1.lon - loc2.lon, 2));
+      return sqrt(squaredDistance(loc1, loc2));
     }
+    static float squaredDistance(Location const & loc1, Location const & loc2) {
+      float const dlat = loc1.lat - loc2.lat;
+      float const dlon = loc1.lon - loc2.lon;
+      return (dlat * dlat) + (dlon * dlon);
+    }
+};
+
+/* In the order of the attribute identifiers */
+static constexpr AttributeEntry<Location> LOCATION_ATTRIBUTES[] = {
+  AIOT_ATTRIBUTE(Location, lat),
+  AIOT_ATTRIBUTE(Location, lon),
 };
+static constexpr uint8_t LOCATION_ATTRIBUTES_BY_NAME[] = {0 /* lat */, 1 /* lon */};
+static_assert(isSortedByName(LOCATION_ATTRIBUTES, LOCATION_ATTRIBUTES_BY_NAME, 2), "LOCATION_ATTRIBUTES_BY_NAME must be sorted by name");
 
 class CloudLocation : public Property {
   private:
     Location _value,
              _cloud_value;
+    /* Minimum distance in metres, 0 if the minimum delta is given in degrees */
+    float    _min_distance;
+    /* Metres per degree of longitude at the latitude of the cloud value */
+    float    _meters_per_deg_lon;
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    SharedValue<Location> _shared;
+#endif
+
+    static constexpr float METERS_PER_DEG_LAT = 111320.0f;
+
+    void updateMetersPerDegLon() {
+      if (_min_distance > 0) {
+        _meters_per_deg_lon = METERS_PER_DEG_LAT * cosf(_cloud_value.lat * (float)(M_PI / 180.0));
+      }
+    }
+
+    /* The distance lies within [max(a, b), a + b] of the coordinate deltas
+     * a and b, which decides most comparisons without any multiplication.
+     */
+    static bool isAtLeast(float const a, float const b, float const min) {
+      if ((a >= min) || (b >= min))
+        return true;
+      if ((a + b) < min)
+        return false;
+      return ((a * a) + (b * b)) >= (min * min);
+    }
+
   public:
-    CloudLocation() : _value(0, 0), _cloud_value(0, 0) {}
-    CloudLocation(float lat, float lon) : _value(lat, lon), _cloud_value(lat, lon) {}
+    CloudLocation() : CloudLocation(0, 0) {}
+    CloudLocation(float lat, float lon) : _value(lat, lon), _cloud_value(lat, lon), _min_distance(0), _meters_per_deg_lon(0)
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    , _shared(Location(lat, lon))
+#endif
+    {}
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    /* Thread and interrupt safe access from one other core, see AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED */
+    void store(Location const v) {
+      _shared.store(v);
+      markShared();
+    }
+    Location load() const {
+      Location v(0, 0);
+      _shared.load(v);
+      return v;
+    }
+    virtual void applyShared() {
+      Location v(0, 0);
+      _shared.stored(v);
+      operator=(v);
+    }
+#endif
     virtual bool isDifferentFromCloud() {
-      float const distance = Location::distance(_value, _cloud_value);
-      return _value != _cloud_value && (abs(distance) >= Property::_min_delta_property);
+      if (_value == _cloud_value)
+        return false;
+      float const dlat = fabsf(_value.lat - _cloud_value.lat);
+      float const dlon = fabsf(_value.lon - _cloud_value.lon);
+      if (_min_distance > 0)
+        return isAtLeast(dlat * METERS_PER_DEG_LAT, dlon * _meters_per_deg_lon, _min_distance);
+      return isAtLeast(dlat, dlon, Property::_min_delta_property);
+    }
+
+    /* Publishes a new location once it is at least min_distance_meters away
+     * from the last one sent, using an equirectangular approximation which
+     * is accurate for the short distances relevant to change detection.
+     */
+    Property & publishOnDistance(float const min_distance_meters, unsigned long const min_time_between_updates_millis = 0) {
+      _min_distance = min_distance_meters;
+      updateMetersPerDegLon();
+      return publishOnChange(0.0f, min_time_between_updates_millis);
     }
 
     CloudLocation& operator=(Location aLocation) {
       _value.lat = aLocation.lat;
       _value.lon = aLocation.lon;
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+      _shared.publish(_value);
+#endif
       updateLocalTimestamp();
       return *this;
     }
@@ -85,9 +165,13 @@ class CloudLocation : public Property {
 
     virtual void fromCloudToLocal() {
       _value = _cloud_value;
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+      _shared.publish(_value);
+#endif
     }
     virtual void fromLocalToCloud() {
       _cloud_value = _value;
+      updateMetersPerDegLon();
     }
     virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
       CHECK_CBOR_MULTI(appendAttribute(_value.lat, "lat", encoder));
@@ -95,8 +179,8 @@ class CloudLocation : public Property {
       return CborNoError;
     }
     virtual void setAttributesFromCloud() {
-      setAttribute(_cloud_value.lat, "lat");
-      setAttribute(_cloud_value.lon, "lon");
+      setAttributesFromTable(LOCATION_ATTRIBUTES, LOCATION_ATTRIBUTES_BY_NAME, _cloud_value);
+      updateMetersPerDegLon();
     }
 };
 
@@ -0,0 +1,458 @@
+//
+// This file is part of ArduinoCloudThing
+//
+// Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+//
+// This software is released under the GNU General Public License version 3,
+// which covers the main part of ArduinoCloudThing.
+// The terms of this license can be found at:
+// https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// You can be released from the requirements of the above licenses by purchasing
+// a commercial license. Buying such a license is mandatory if you want to modify or
+// otherwise use the software for commercial activities involving the Arduino
+// software without disclosing the source code of your own applications. To purchase
+// a commercial license, send an email to license@arduino.cc.
+//
+
+#ifndef CLOUDNUMBER_H_
+#define CLOUDNUMBER_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <math.h>
+
+#include <Arduino.h>
+#include "../Property.h"
+#include "../SharedValue.h"
+#include "../Aggregation.h"
+#include "../History.h"
+#include "../../utility/memory/StaticArena.h"
+
+/******************************************************************************
+   POLICIES
+ ******************************************************************************/
+
+template <typename T> class CloudNumber;
+
+/* Type specific parts of CloudNumber<T>: the type accumulating the mean of
+ * an aggregation window and the conversion from the number of a rule.
+ * Integral is only defined for integer types and enables the unary operators
+ * and the updates from an interrupt, Floating is only defined for float and
+ * enables the operators mixing it with int and double.
+ */
+template <typename T> struct CloudNumberPolicy;
+
+template <> struct CloudNumberPolicy<int> {
+  typedef int64_t          Sum;
+  typedef CloudNumber<int> Integral;
+  static inline int fromNumber(float const v) {
+    return static_cast<int>(v + ((v < 0) ? -0.5f : 0.5f));
+  }
+};
+
+template <> struct CloudNumberPolicy<unsigned int> {
+  typedef uint64_t                  Sum;
+  typedef CloudNumber<unsigned int> Integral;
+  static inline unsigned int fromNumber(float const v) {
+    return (v > 0) ? static_cast<unsigned int>(v + 0.5f) : 0;
+  }
+};
+
+template <> struct CloudNumberPolicy<float> {
+  typedef double             Sum;
+  typedef CloudNumber<float> Floating;
+  static inline float fromNumber(float const v) {
+    return v;
+  }
+};
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Numeric property, aliased as CloudInt, CloudUnsignedInt and CloudFloat.
+ * The value is encoded by the Property::appendAttribute overload of T.
+ */
+template <typename T>
+class CloudNumber : public Property {
+  protected:
+    typedef CloudNumberPolicy<T> Policy;
+
+    T _value,
+      _cloud_value;
+    Aggregator<T, typename Policy::Sum> * _aggregator;
+    History<T> * _history;
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    SharedValue<T> _shared;
+#endif
+    inline T aggregatedValue() const {
+      return (_aggregator && !_aggregator->empty()) ? _aggregator->value() : _value;
+    }
+    /* Keeps a value which has moved far enough from the one kept or sent last */
+    inline void addToHistory(T const v) {
+      T const previous = _history->empty() ? _cloud_value : _history->last();
+      if (v != previous && isBeyondMinDelta(v, previous))
+        _history->add(v, currentTimeMillis());
+    }
+    virtual void mergeFromISR(bool const is_set, int32_t const value, int32_t const delta) {
+      operator=(static_cast<T>((is_set ? static_cast<T>(value) : _value) + static_cast<T>(delta)));
+    }
+  public:
+    CloudNumber() : CloudNumber(static_cast<T>(0)) {}
+    CloudNumber(T v) : _value(v), _cloud_value(v), _aggregator(nullptr), _history(nullptr)
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    , _shared(v)
+#endif
+    {}
+    /* A copy, e.g. the result of an arithmetic operator, does not aggregate */
+    CloudNumber(CloudNumber const & other) : Property(other), _value(other._value), _cloud_value(other._cloud_value), _aggregator(nullptr), _history(nullptr)
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    , _shared(other._value)
+#endif
+    {}
+    virtual ~CloudNumber() {
+      arenaDelete(_aggregator);
+      arenaDelete(_history);
+    }
+    /* Publishes the mean, minimum, maximum or last of the values assigned
+     * within each window of window_seconds instead of the current value.
+     */
+    Property & publishAggregated(Aggregation const aggregation, unsigned long const window_seconds) {
+      arenaDelete(_aggregator);
+      _aggregator = arenaNew<Aggregator<T, typename Policy::Sum>>(aggregation);
+      return publishEvery(window_seconds);
+    }
+    /* Keeps up to depth timestamped values changed since the last message
+     * and sends each of them as a record of its own, instead of only the
+     * latest one. The oldest value is dropped once depth are kept. Values
+     * within the minimum delta of publishOnChange() are not kept.
+     */
+    Property & encodeHistory(size_t const depth) {
+      arenaDelete(_history);
+      _history = arenaNew<History<T>>(depth);
+      if (_history && (_history->depth() == 0)) {
+        arenaDelete(_history);
+        _history = nullptr;
+      }
+      return *this;
+    }
+    operator T() const {
+      return _value;
+    }
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+    /* Thread and interrupt safe access from one other core, see AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED */
+    void store(T const v) {
+      _shared.store(v);
+      markShared();
+    }
+    T load() const {
+      T v;
+      _shared.load(v);
+      return v;
+    }
+    virtual void applyShared() {
+      T v;
+      _shared.stored(v);
+      operator=(v);
+    }
+#endif
+    virtual bool isDifferentFromCloud() {
+      if (_history)
+        return !_history->empty();
+      return _value != _cloud_value && isBeyondMinDelta(_value, _cloud_value);
+    }
+    virtual void fromCloudToLocal() {
+      _value = _cloud_value;
+      if (_history)
+        _history->reset();
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+      _shared.publish(_value);
+#endif
+    }
+    virtual void fromLocalToCloud() {
+      _cloud_value = aggregatedValue();
+      if (_aggregator)
+        _aggregator->reset();
+      if (_history)
+        _history->reset();
+    }
+    virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
+      if (!_history || _history->empty())
+        return appendAttribute(aggregatedValue(), "", encoder);
+      for (size_t i = 0; i < _history->size(); i++) {
+        setRecordTimeMillis(_history->timeMillis(i));
+        CHECK_CBOR_MULTI(appendAttribute(_history->value(i), "", encoder));
+      }
+      setRecordTimeMillis(0);
+      return CborNoError;
+    }
+    virtual void setAttributesFromCloud() {
+      setAttribute(_cloud_value, "");
+    }
+    virtual bool isEchoComplete() {
+      return _history == nullptr;
+    }
+#if AIOT_CONFIG_RULES_ENABLED
+    virtual bool getNumber(float & value) {
+      value = static_cast<float>(_value);
+      return true;
+    }
+    virtual bool setNumber(float const value) {
+      T const v = Policy::fromNumber(value);
+      if (v != _value)
+        operator=(v);
+      return true;
+    }
+#endif
+    /* Interrupt safe, see acceptUpdatesFromISR(). The deltas are added to
+     * the latest value set, e.g. to count events within the interrupt.
+     */
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Integral>
+    void setFromISR(T const v) {
+      postValueFromISR(static_cast<int32_t>(v));
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Integral>
+    void addFromISR(T const delta) {
+      postDeltaFromISR(static_cast<int32_t>(delta));
+    }
+    //modifiers
+    CloudNumber& operator=(T v) {
+      _value = v;
+#if AIOT_CONFIG_CONCURRENT_PROPERTIES_ENABLED
+      _shared.publish(v);
+#endif
+      if (_aggregator)
+        _aggregator->add(v);
+      if (_history)
+        addToHistory(v);
+      updateLocalTimestamp();
+      return *this;
+    }
+    CloudNumber& operator=(CloudNumber v) {
+      return operator=((T)v);
+    }
+    CloudNumber& operator+=(T v) {
+      return operator=(_value += v);
+    }
+    CloudNumber& operator-=(T v) {
+      return operator=(_value -= v);
+    }
+    CloudNumber& operator*=(T v) {
+      return operator=(_value *= v);
+    }
+    CloudNumber& operator/=(T v) {
+      return operator=(_value /= v);
+    }
+    CloudNumber& operator++() {
+      return operator=(static_cast<T>(_value + 1));
+    }
+    CloudNumber& operator--() {
+      return operator=(static_cast<T>(_value - 1));
+    }
+    CloudNumber operator++(int) {
+      operator=(static_cast<T>(_value + 1));
+      return CloudNumber(_value);
+    }
+    CloudNumber operator--(int) {
+      operator=(static_cast<T>(_value - 1));
+      return CloudNumber(_value);
+    }
+    //integer modifiers
+    CloudNumber& operator%=(T v) {
+      return operator=(_value %= v);
+    }
+    CloudNumber& operator&=(T v) {
+      return operator=(_value &= v);
+    }
+    CloudNumber& operator|=(T v) {
+      return operator=(_value |= v);
+    }
+    CloudNumber& operator^=(T v) {
+      return operator=(_value ^= v);
+    }
+    CloudNumber& operator<<=(T v) {
+      return operator=(_value <<= v);
+    }
+    CloudNumber& operator>>=(T v) {
+      return operator=(_value >>= v);
+    }
+    //integer accessors, a float is converted to float instead
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Integral>
+    CloudNumber operator+() const {
+      return CloudNumber(+_value);
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Integral>
+    CloudNumber operator-() const {
+      return CloudNumber(-_value);
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Integral>
+    CloudNumber operator!() const {
+      return CloudNumber(!_value);
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Integral>
+    CloudNumber operator~() const {
+      return CloudNumber(~_value);
+    }
+    //friends
+    friend CloudNumber operator+(CloudNumber iw, CloudNumber v) {
+      return iw += v;
+    }
+    friend CloudNumber operator+(CloudNumber iw, T v) {
+      return iw += v;
+    }
+    friend CloudNumber operator+(T v, CloudNumber iw) {
+      return CloudNumber(v) += iw;
+    }
+    friend CloudNumber operator-(CloudNumber iw, CloudNumber v) {
+      return iw -= v;
+    }
+    friend CloudNumber operator-(CloudNumber iw, T v) {
+      return iw -= v;
+    }
+    friend CloudNumber operator-(T v, CloudNumber iw) {
+      return CloudNumber(v) -= iw;
+    }
+    friend CloudNumber operator*(CloudNumber iw, CloudNumber v) {
+      return iw *= v;
+    }
+    friend CloudNumber operator*(CloudNumber iw, T v) {
+      return iw *= v;
+    }
+    friend CloudNumber operator*(T v, CloudNumber iw) {
+      return CloudNumber(v) *= iw;
+    }
+    friend CloudNumber operator/(CloudNumber iw, CloudNumber v) {
+      return iw /= v;
+    }
+    friend CloudNumber operator/(CloudNumber iw, T v) {
+      return iw /= v;
+    }
+    friend CloudNumber operator/(T v, CloudNumber iw) {
+      return CloudNumber(v) /= iw;
+    }
+    //mixed friends of float, which would otherwise be ambiguous with the built-in operators
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator+(CloudNumber iw, int v) {
+      return iw += (T)v;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator+(CloudNumber iw, double v) {
+      return iw += (T)v;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator+(int v, CloudNumber iw) {
+      return CloudNumber((T)v) += iw;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator+(double v, CloudNumber iw) {
+      return CloudNumber((T)v) += iw;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator-(CloudNumber iw, int v) {
+      return iw -= (T)v;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator-(CloudNumber iw, double v) {
+      return iw -= (T)v;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator-(int v, CloudNumber iw) {
+      return CloudNumber((T)v) -= iw;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator-(double v, CloudNumber iw) {
+      return CloudNumber((T)v) -= iw;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator*(CloudNumber iw, int v) {
+      return iw *= (T)v;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator*(CloudNumber iw, double v) {
+      return iw *= (T)v;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator*(int v, CloudNumber iw) {
+      return CloudNumber((T)v) *= iw;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator*(double v, CloudNumber iw) {
+      return CloudNumber((T)v) *= iw;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator/(CloudNumber iw, int v) {
+      return iw /= (T)v;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator/(CloudNumber iw, double v) {
+      return iw /= (T)v;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator/(int v, CloudNumber iw) {
+      return CloudNumber((T)v) /= iw;
+    }
+    template <typename U = T, typename = typename CloudNumberPolicy<U>::Floating>
+    friend CloudNumber operator/(double v, CloudNumber iw) {
+      return CloudNumber((T)v) /= iw;
+    }
+    //integer friends
+    friend CloudNumber operator%(CloudNumber iw, CloudNumber v) {
+      return iw %= v;
+    }
+    friend CloudNumber operator%(CloudNumber iw, T v) {
+      return iw %= v;
+    }
+    friend CloudNumber operator%(T v, CloudNumber iw) {
+      return CloudNumber(v) %= iw;
+    }
+    friend CloudNumber operator&(CloudNumber iw, CloudNumber v) {
+      return iw &= v;
+    }
+    friend CloudNumber operator&(CloudNumber iw, T v) {
+      return iw &= v;
+    }
+    friend CloudNumber operator&(T v, CloudNumber iw) {
+      return CloudNumber(v) &= iw;
+    }
+    friend CloudNumber operator|(CloudNumber iw, CloudNumber v) {
+      return iw |= v;
+    }
+    friend CloudNumber operator|(CloudNumber iw, T v) {
+      return iw |= v;
+    }
+    friend CloudNumber operator|(T v, CloudNumber iw) {
+      return CloudNumber(v) |= iw;
+    }
+    friend CloudNumber operator^(CloudNumber iw, CloudNumber v) {
+      return iw ^= v;
+    }
+    friend CloudNumber operator^(CloudNumber iw, T v) {
+      return iw ^= v;
+    }
+    friend CloudNumber operator^(T v, CloudNumber iw) {
+      return CloudNumber(v) ^= iw;
+    }
+    friend CloudNumber operator<<(CloudNumber iw, CloudNumber v) {
+      return iw <<= v;
+    }
+    friend CloudNumber operator<<(CloudNumber iw, T v) {
+      return iw <<= v;
+    }
+    friend CloudNumber operator<<(T v, CloudNumber iw) {
+      return CloudNumber(v) <<= iw;
+    }
+    friend CloudNumber operator>>(CloudNumber iw, CloudNumber v) {
+      return iw >>= v;
+    }
+    friend CloudNumber operator>>(CloudNumber iw, T v) {
+      return iw >>= v;
+    }
+    friend CloudNumber operator>>(T v, CloudNumber iw) {
+      return CloudNumber(v) >>= iw;
+    }
+};
+
+#endif /* CLOUDNUMBER_H_ */
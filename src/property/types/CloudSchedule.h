@@ -26,6 +26,7 @@
 #include "../Property.h"
 #include "../../AIoTC_Const.h"
 #include "utility/time/TimeService.h"
+#include "utility/time/ScheduleTimer.h"
 #include <time.h>
 
 /******************************************************************************
@@ -46,6 +47,9 @@
 
 #define SCHEDULE_ONE_SHOT     0xFFFFFFFF
 
+/* Beyond any ScheduleTimeType, marks a state that doesn't change anymore */
+#define SCHEDULE_FOREVER      0x100000000ULL
+
 /******************************************************************************
    ENUM
  ******************************************************************************/
@@ -111,29 +115,25 @@ typedef unsigned int ScheduleConfigurationType;
 class Schedule {
   public:
     ScheduleTimeType frm, to, len, msk;
-    Schedule(ScheduleTimeType s, ScheduleTimeType e, ScheduleTimeType d, ScheduleConfigurationType m): frm(s), to(e), len(d), msk(m) {}
+    Schedule(ScheduleTimeType s, ScheduleTimeType e, ScheduleTimeType d, ScheduleConfigurationType m): frm(s), to(e), len(d), msk(m), _cache_frm(0), _cache_to(0), _cache_len(0), _cache_msk(0), _cache_begin(0), _cache_end(0), _cache_state(false) {}
 
     bool isActive() {
+      return isActiveAt(TimeService.getLocalTime());
+    }
 
-      ScheduleTimeType now = TimeService.getLocalTime();
-
-      if(checkTimeValid(now)) {
-        /* We have to wait RTC configuration and Timezone setting from the cloud */
-
-        if(checkSchedulePeriod(now, frm, to)) {
-          /* We are in the schedule range */
-
-          if(checkScheduleMask(now, msk)) {
-
-            /* We can assume now that the schedule is always repeating with fixed delta */
-            ScheduleTimeType delta = getScheduleDelta(msk);
-            if ( ( (std::max(now , frm) - std::min(now , frm)) % delta ) <= len ) {
-              return true;
-            }
-          }
-        }
+    bool isActiveAt(ScheduleTimeType now) {
+      /* The state only changes at the next transition computed along with it,
+       * until then or until the schedule is modified it is served from the cache.
+       */
+      if(!isCacheValid(now)) {
+        updateCache(now);
       }
-      return false;
+      return _cache_state;
+    }
+
+    /* The instant the state last returned by isActiveAt() may change */
+    unsigned long long nextTransition() {
+      return _cache_end;
     }
 
     static ScheduleConfigurationType createOneShotScheduleConfiguration() {
@@ -185,7 +185,7 @@ class Schedule {
       return (temp_type << SCHEDULE_TYPE_SHIFT) | (temp_month << SCHEDULE_MONTH_SHIFT)| temp_day;
     }
 
-    Schedule& operator=(Schedule & aSchedule) {
+    Schedule& operator=(Schedule const & aSchedule) {
       frm = aSchedule.frm;
       to  = aSchedule.to;
       len = aSchedule.len;
@@ -202,6 +202,85 @@ class Schedule {
     }
   private:
 
+    ScheduleTimeType _cache_frm, _cache_to, _cache_len;
+    ScheduleConfigurationType _cache_msk;
+    unsigned long long _cache_begin, _cache_end;
+    bool _cache_state;
+
+    bool isCacheValid(ScheduleTimeType now) {
+      return now >= _cache_begin && now < _cache_end &&
+             frm == _cache_frm && to == _cache_to && len == _cache_len && msk == _cache_msk;
+    }
+
+    void updateCache(ScheduleTimeType now) {
+      _cache_frm = frm;
+      _cache_to = to;
+      _cache_len = len;
+      _cache_msk = msk;
+      _cache_begin = now;
+      _cache_state = checkScheduleActive(now);
+      _cache_end = getNextTransition(now);
+    }
+
+    /* The earliest instant after now at which checkScheduleActive(now) may change, an
+     * earlier one only costs an extra evaluation.
+     */
+    unsigned long long getNextTransition(ScheduleTimeType now) {
+      unsigned long long const t = now;
+
+      if(!checkTimeValid(now)) {
+        return t + 1;
+      }
+
+      if(now < frm) {
+        return frm;
+      }
+
+      if(to != 0 && now >= to) {
+        return SCHEDULE_FOREVER;
+      }
+
+      unsigned long long next = (to != 0) ? to : SCHEDULE_FOREVER;
+
+      /* The day based masks are evaluated per day */
+      if(isScheduleWeekly(msk) || isScheduleMonthly(msk) || isScheduleYearly(msk)) {
+        next = std::min(next, t - (t % DAYS) + DAYS);
+      }
+
+      if(!checkScheduleMask(now, msk)) {
+        return next;
+      }
+
+      /* Active during the first len seconds of each repetition */
+      ScheduleTimeType delta = getScheduleDelta(msk);
+      unsigned long long const k = (now - frm) % delta;
+      if(k <= len) {
+        return std::min(next, t + (len - k) + 1);
+      }
+      return std::min(next, t + (delta - k));
+    }
+
+    bool checkScheduleActive(ScheduleTimeType now) {
+
+      if(checkTimeValid(now)) {
+        /* We have to wait RTC configuration and Timezone setting from the cloud */
+
+        if(checkSchedulePeriod(now, frm, to)) {
+          /* We are in the schedule range */
+
+          if(checkScheduleMask(now, msk)) {
+
+            /* We can assume now that the schedule is always repeating with fixed delta */
+            ScheduleTimeType delta = getScheduleDelta(msk);
+            if ( ( (std::max(now , frm) - std::min(now , frm)) % delta ) <= len ) {
+              return true;
+            }
+          }
+        }
+      }
+      return false;
+    }
+
     ScheduleUnit getScheduleUnit(ScheduleConfigurationType msk) {
       return static_cast<ScheduleUnit>((msk & SCHEDULE_UNIT_MASK) >> SCHEDULE_UNIT_SHIFT);
     }
@@ -376,13 +455,73 @@ class Schedule {
     }
 };
 
+typedef void(*ScheduleCallbackFunc)(void);
+
+/* In the order of the attribute identifiers */
+static constexpr AttributeEntry<Schedule> SCHEDULE_ATTRIBUTES[] = {
+  AIOT_ATTRIBUTE(Schedule, frm),
+  AIOT_ATTRIBUTE(Schedule, to),
+  AIOT_ATTRIBUTE(Schedule, len),
+  AIOT_ATTRIBUTE(Schedule, msk),
+};
+static constexpr uint8_t SCHEDULE_ATTRIBUTES_BY_NAME[] = {0 /* frm */, 2 /* len */, 3 /* msk */, 1 /* to */};
+static_assert(isSortedByName(SCHEDULE_ATTRIBUTES, SCHEDULE_ATTRIBUTES_BY_NAME, 4), "SCHEDULE_ATTRIBUTES_BY_NAME must be sorted by name");
+
 class CloudSchedule : public Property {
   private:
+    friend class ScheduleTimerClass;
+
     Schedule _value,
              _cloud_value;
+    ScheduleCallbackFunc _on_activate,
+                         _on_deactivate;
+    /* Queue entry of the ScheduleTimer */
+    CloudSchedule * _timer_next;
+    unsigned long long _timer_edge;
+    bool _is_timer_queued;
+    bool _is_timer_state_known;
+    bool _is_timer_active;
+
+    void rescheduleTimer() {
+      if(_on_activate || _on_deactivate) {
+        ScheduleTimer.schedule(*this);
+      }
+    }
   public:
-    CloudSchedule() : _value(0, 0, 0, 0), _cloud_value(0, 0, 0, 0) {}
-    CloudSchedule(unsigned int frm, unsigned int to, unsigned int len, unsigned int msk) : _value(frm, to, len, msk), _cloud_value(frm, to, len, msk) {}
+    CloudSchedule() : CloudSchedule(0, 0, 0, 0) {}
+    CloudSchedule(unsigned int frm, unsigned int to, unsigned int len, unsigned int msk) : _value(frm, to, len, msk), _cloud_value(frm, to, len, msk), _on_activate(nullptr), _on_deactivate(nullptr), _timer_next(nullptr), _timer_edge(0), _is_timer_queued(false), _is_timer_state_known(false), _is_timer_active(false) {}
+    /* A copy has its own place in the queue of the ScheduleTimer */
+    CloudSchedule(CloudSchedule const & other) : Property(other), _value(other._value), _cloud_value(other._cloud_value), _on_activate(other._on_activate), _on_deactivate(other._on_deactivate), _timer_next(nullptr), _timer_edge(0), _is_timer_queued(false), _is_timer_state_known(false), _is_timer_active(false) {
+      rescheduleTimer();
+    }
+    CloudSchedule & operator=(CloudSchedule const & other) {
+      Property::operator=(other);
+      _value = other._value;
+      _cloud_value = other._cloud_value;
+      _on_activate = other._on_activate;
+      _on_deactivate = other._on_deactivate;
+      rescheduleTimer();
+      return *this;
+    }
+    virtual ~CloudSchedule() {
+      ScheduleTimer.cancel(*this);
+    }
+
+    /* Called from ArduinoCloud.update() when the schedule becomes active or
+     * inactive, instead of polling isActive(). A schedule which is already
+     * active when the time becomes known is reported as activated.
+     */
+    CloudSchedule & onActivate(ScheduleCallbackFunc func) {
+      _on_activate = func;
+      rescheduleTimer();
+      return *this;
+    }
+
+    CloudSchedule & onDeactivate(ScheduleCallbackFunc func) {
+      _on_deactivate = func;
+      rescheduleTimer();
+      return *this;
+    }
 
     virtual bool isDifferentFromCloud() {
 
@@ -395,6 +534,7 @@ class CloudSchedule : public Property {
       _value.len = aSchedule.len;
       _value.msk = aSchedule.msk;
       updateLocalTimestamp();
+      rescheduleTimer();
       return *this;
     }
 
@@ -412,22 +552,20 @@ class CloudSchedule : public Property {
 
     virtual void fromCloudToLocal() {
       _value = _cloud_value;
+      rescheduleTimer();
     }
     virtual void fromLocalToCloud() {
       _cloud_value = _value;
     }
     virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
-      CHECK_CBOR_MULTI(appendAttribute(_value.frm, "frm", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.to, "to", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.len, "len", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.msk, "msk", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.frm, _cloud_value.frm, "frm", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.to, _cloud_value.to, "to", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.len, _cloud_value.len, "len", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.msk, _cloud_value.msk, "msk", encoder));
       return CborNoError;
     }
     virtual void setAttributesFromCloud() {
-      setAttribute(_cloud_value.frm, "frm");
-      setAttribute(_cloud_value.to, "to");
-      setAttribute(_cloud_value.len, "len");
-      setAttribute(_cloud_value.msk, "msk");
+      setAttributesFromTable(SCHEDULE_ATTRIBUTES, SCHEDULE_ATTRIBUTES_BY_NAME, _cloud_value);
     }
 };
 
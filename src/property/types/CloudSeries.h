@@ -0,0 +1,206 @@
+//
+// This file is part of ArduinoCloudThing
+//
+// Copyright 2024 ARDUINO SA (http://www.arduino.cc/)
+//
+// This software is released under the GNU General Public License version 3,
+// which covers the main part of ArduinoCloudThing.
+// The terms of this license can be found at:
+// https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// You can be released from the requirements of the above licenses by purchasing
+// a commercial license. Buying such a license is mandatory if you want to modify or
+// otherwise use the software for commercial activities involving the Arduino
+// software without disclosing the source code of your own applications. To purchase
+// a commercial license, send an email to license@arduino.cc.
+//
+
+#ifndef CLOUDSERIES_H_
+#define CLOUDSERIES_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include "../Property.h"
+#include "../../utility/series/SeriesKernels.h"
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* A read-only property which collects a burst of up to N timestamped
+ * samples of type T (float, int or unsigned int) and sends them all
+ * within a single message, after which the series starts over. The
+ * oldest sample is overwritten once the series is full.
+ *
+ * By default every sample is encoded as a SenML record of its own, which
+ * share the base time when the message uses SenML base values. With
+ * encodeTypedArray() all samples are encoded as a single record holding
+ * a RFC 8746 typed array, timestamped with the oldest sample. The float
+ * samples can be sent as half precision floats with encodeHalfFloat(),
+ * which halves the size of the array at the cost of precision.
+ *
+ * Pick N so that the encoded series fits into a single message and use
+ * publishOnChange(0, ms) or publishEvery(s) to set the burst interval.
+ */
+template <typename T, size_t N>
+class CloudSeries : public Property {
+  private:
+    T             _sample[N];
+    /* Milliseconds since the epoch */
+    uint64_t      _time_ms[N];
+    size_t        _head,
+                  _count;
+    bool          _typed_array;
+    bool          _half_float;
+
+    static size_t sizeLog2(size_t const size) {
+      return (size == 1) ? 0 : (size == 2) ? 1 : (size == 4) ? 2 : 3;
+    }
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    static CborTag const LITTLE_ENDIAN_FLAG = 0;
+#else
+    static CborTag const LITTLE_ENDIAN_FLAG = 4;
+#endif
+    /* See https://www.rfc-editor.org/rfc/rfc8746#section-2.1 */
+    static CborTag typedArrayTag(float const *)        { return 64 + 16 + LITTLE_ENDIAN_FLAG + sizeLog2(sizeof(float)) - 1; }
+    static CborTag typedArrayTag(int const *)          { return 64 + 8 + LITTLE_ENDIAN_FLAG + sizeLog2(sizeof(int)); }
+    static CborTag typedArrayTag(unsigned int const *) { return 64 + LITTLE_ENDIAN_FLAG + sizeLog2(sizeof(unsigned int)); }
+    static CborTag halfFloatArrayTag()                 { return 64 + 16 + LITTLE_ENDIAN_FLAG + sizeLog2(sizeof(uint16_t)) - 1; }
+
+    /* Only a series of floats is ever converted */
+    static constexpr bool isFloat(float const *) { return true; }
+    template <typename U>
+    static constexpr bool isFloat(U const *) { return false; }
+    static void toHalf(float const * sample, uint16_t * half, size_t const cnt) { series_to_half(sample, half, cnt); }
+    template <typename U>
+    static void toHalf(U const *, uint16_t *, size_t const) { }
+
+    template <typename U>
+    static void reverse(U * first, U * last) {
+      for (; (first != last) && (first != --last); first++) {
+        U const tmp = *first;
+        *first = *last;
+        *last = tmp;
+      }
+    }
+
+    /* Rotates the ring so that the oldest sample is at the beginning */
+    void linearize() {
+      if (_head == 0)
+        return;
+      reverse(_sample, _sample + _head);
+      reverse(_sample + _head, _sample + N);
+      reverse(_sample, _sample + N);
+      reverse(_time_ms, _time_ms + _head);
+      reverse(_time_ms + _head, _time_ms + N);
+      reverse(_time_ms, _time_ms + N);
+      _head = 0;
+    }
+
+    CborError appendTypedArray(CborEncoder * encoder) {
+      linearize();
+      setRecordTimeMillis(_time_ms[0]);
+      CborError const error = appendAttributeName("", [this](CborEncoder & mapEncoder)
+      {
+        CHECK_CBOR(cbor_encode_int(&mapEncoder, static_cast<int>(CborIntegerMapKey::DataValue)));
+        if (_half_float) {
+          uint16_t half[N];
+          toHalf(_sample, half, _count);
+          CHECK_CBOR(cbor_encode_tag(&mapEncoder, halfFloatArrayTag()));
+          CHECK_CBOR(cbor_encode_byte_string(&mapEncoder, reinterpret_cast<uint8_t const *>(half), _count * sizeof(uint16_t)));
+          return CborNoError;
+        }
+        CHECK_CBOR(cbor_encode_tag(&mapEncoder, typedArrayTag(static_cast<T const *>(nullptr))));
+        CHECK_CBOR(cbor_encode_byte_string(&mapEncoder, reinterpret_cast<uint8_t const *>(_sample), _count * sizeof(T)));
+        return CborNoError;
+      }, encoder);
+      setRecordTimeMillis(0);
+      return error;
+    }
+
+  public:
+    CloudSeries() : _head(0), _count(0), _typed_array(false), _half_float(false) {}
+
+    /* Appends a sample taken now, at the given time in seconds or at the
+     * given time in milliseconds, all of them since the epoch. A sample
+     * taken within a second of another one is encoded with the fraction.
+     */
+    void add(T const sample) {
+      addMillis(sample, currentTimeMillis());
+    }
+    void add(T const sample, unsigned long const timestamp) {
+      addMillis(sample, timestamp * 1000ULL);
+    }
+    void addMillis(T const sample, uint64_t const time_ms) {
+      size_t const idx = (_head + _count) % N;
+      _sample[idx] = sample;
+      _time_ms[idx] = time_ms;
+      if (_count < N)
+        _count++;
+      else
+        _head = (_head + 1) % N;
+      updateLocalTimestamp();
+    }
+
+    inline size_t size() const {
+      return _count;
+    }
+    inline bool full() const {
+      return _count == N;
+    }
+    /* Returns the i-th oldest sample */
+    inline T operator[](size_t const i) const {
+      return _sample[(_head + i) % N];
+    }
+    inline void clear() {
+      _head = 0;
+      _count = 0;
+    }
+    /* Min, max and mean of the samples, to be taken before they are sent */
+    inline SeriesStats stats() const {
+      return (_count > 0) ? series_stats(_sample, _count) : SeriesStats{0.0f, 0.0f, 0.0f};
+    }
+
+    CloudSeries & encodeTypedArray() {
+      _typed_array = true;
+      return *this;
+    }
+    CloudSeries & encodeHalfFloat() {
+      static_assert(isFloat(static_cast<T const *>(nullptr)), "Only a series of floats can be sent as half precision floats");
+      _typed_array = true;
+      _half_float = true;
+      return *this;
+    }
+
+    virtual bool isDifferentFromCloud() {
+      return _count > 0;
+    }
+    virtual void fromCloudToLocal() {
+    }
+    virtual void fromLocalToCloud() {
+      clear();
+    }
+    virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
+      if (_count == 0)
+        return CborNoError;
+      if (_typed_array)
+        return appendTypedArray(encoder);
+      for (size_t i = 0; i < _count; i++) {
+        size_t const idx = (_head + i) % N;
+        setRecordTimeMillis(_time_ms[idx]);
+        CHECK_CBOR_MULTI(appendAttribute(_sample[idx], "", encoder));
+      }
+      setRecordTimeMillis(0);
+      return CborNoError;
+    }
+    virtual void setAttributesFromCloud() {
+    }
+    virtual bool isEchoComplete() {
+      return false;
+    }
+};
+
+#endif /* CLOUDSERIES_H_ */
@@ -22,6 +22,8 @@
    INCLUDE
  ******************************************************************************/
 
+#include <utility>
+
 #include <Arduino.h>
 #include "../Property.h"
 
@@ -35,38 +37,72 @@ class CloudString : public Property {
   private:
     String  _value,
             _cloud_value;
-  public:
-    CloudString()                                {
-      CloudString("");
+    /* While the local and the cloud value are equal _cloud_value is left
+     * empty and _value stands for both, publishing a value does not copy it.
+     * The shadow is taken back by the first change of the local value, which
+     * moves the old value over instead of copying it.
+     */
+    bool    _is_cloud_value_shared;
+    /* The result of the last comparison, kept until either value changes */
+    bool    _is_compared,
+            _is_different;
+
+    void shareCloudValue() {
+      _cloud_value = String();
+      _is_cloud_value_shared = true;
     }
-    CloudString(const char *v)                   {
-      CloudString(String(v));
+    void unshareCloudValue(bool const keep_local_value) {
+      if (_is_cloud_value_shared) {
+        if (keep_local_value) {
+          _cloud_value = _value;
+        } else {
+          _cloud_value = std::move(_value);
+        }
+        _is_cloud_value_shared = false;
+      }
+      _is_compared = false;
     }
-    CloudString(String v) : _value(v), _cloud_value(v) {}
+  public:
+    CloudString() : CloudString("") {}
+    CloudString(const char *v) : CloudString(String(v)) {}
+    CloudString(String v) : _value(std::move(v)), _is_cloud_value_shared(true), _is_compared(false), _is_different(false) {}
     operator String() const {
       return _value;
     }
     void clear() {
-      _value = PropertyActions::CLEAR;
+      operator=(PropertyActions::CLEAR);
     }
     virtual bool isDifferentFromCloud() {
-      return _value != _cloud_value;
+      if (_is_cloud_value_shared) {
+        return false;
+      }
+      if (!_is_compared) {
+        _is_different = (_value.length() != _cloud_value.length()) || (_value != _cloud_value);
+        _is_compared = true;
+      }
+      return _is_different;
     }
     virtual void fromCloudToLocal() {
-      _value = _cloud_value;
+      if (!_is_cloud_value_shared) {
+        _value = std::move(_cloud_value);
+        shareCloudValue();
+      }
     }
     virtual void fromLocalToCloud() {
-      _cloud_value = _value;
+      shareCloudValue();
     }
     virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
       return appendAttribute(_value, "", encoder);
     }
     virtual void setAttributesFromCloud() {
+      /* An attribute which is missing leaves the cloud value as it is */
+      unshareCloudValue(true);
       setAttribute(_cloud_value, "");
     }
     //modifiers
     CloudString& operator=(String v) {
-      _value = v;
+      unshareCloudValue(false);
+      _value = std::move(v);
       updateLocalTimestamp();
       return *this;
     }
@@ -74,7 +110,7 @@ class CloudString : public Property {
       return operator=(String(v));
     }
     CloudString& operator+=(String v) {
-      return operator=(_value += v);
+      return operator=(_value + v);
     }
     bool operator==(const char *c) const {
       return operator==(String(c));
@@ -0,0 +1,105 @@
+//
+// This file is part of ArduinoCloudThing
+//
+// Copyright 2019 ARDUINO SA (http://www.arduino.cc/)
+//
+// This software is released under the GNU General Public License version 3,
+// which covers the main part of ArduinoCloudThing.
+// The terms of this license can be found at:
+// https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// You can be released from the requirements of the above licenses by purchasing
+// a commercial license. Buying such a license is mandatory if you want to modify or
+// otherwise use the software for commercial activities involving the Arduino
+// software without disclosing the source code of your own applications. To purchase
+// a commercial license, send an email to license@arduino.cc.
+//
+
+#ifndef CLOUDWRAPPERARRAY_H_
+#define CLOUDWRAPPERARRAY_H_
+
+/******************************************************************************
+   INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+#include <string.h>
+#include "CloudWrapperBase.h"
+
+/******************************************************************************
+   FUNCTION DEFINITION
+ ******************************************************************************/
+
+/* Attribute names of the elements of a CloudWrapperArray, i.e. their indices */
+inline char const * cloudWrapperArrayIndex(size_t const idx) {
+  static char const * const INDEX[] = {
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15",
+    "16", "17", "18", "19", "20", "21", "22", "23", "24", "25", "26", "27", "28", "29", "30", "31",
+    "32", "33", "34", "35", "36", "37", "38", "39", "40", "41", "42", "43", "44", "45", "46", "47",
+    "48", "49", "50", "51", "52", "53", "54", "55", "56", "57", "58", "59", "60", "61", "62", "63"
+  };
+  return INDEX[idx];
+}
+
+/******************************************************************************
+   CLASS DECLARATION
+ ******************************************************************************/
+
+/* Binds a whole C array of primitives, e.g. float temps[16], to a single
+ * property. A local change is detected by a single memcmp() against a shadow
+ * copy of the array and only the changed elements are encoded, each as an
+ * attribute named after its index, e.g. "temps:3".
+ */
+template <typename T, size_t N>
+class CloudWrapperArray : public CloudWrapperBase {
+  static_assert((N > 0) && (N <= 64), "CloudWrapperArray supports 1 to 64 elements");
+
+  private:
+    T (&_primitive_value)[N];
+    T _cloud_value[N];
+    T _local_value[N];
+  public:
+    CloudWrapperArray(T (&v)[N]) : _primitive_value(v) {
+      memcpy(_cloud_value, v, sizeof(_cloud_value));
+      memcpy(_local_value, v, sizeof(_local_value));
+    }
+    virtual bool isDifferentFromCloud() {
+      for (size_t i = 0; i < N; i++) {
+        if (_primitive_value[i] != _cloud_value[i] && isBeyondMinDelta(_primitive_value[i], _cloud_value[i]))
+          return true;
+      }
+      return false;
+    }
+    virtual void fromCloudToLocal() {
+      memcpy(_primitive_value, _cloud_value, sizeof(_cloud_value));
+    }
+    virtual void fromLocalToCloud() {
+      memcpy(_cloud_value, _primitive_value, sizeof(_cloud_value));
+    }
+    virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
+      for (size_t i = 0; i < N; i++) {
+        CHECK_CBOR_MULTI(appendChangedAttribute(_primitive_value[i], _cloud_value[i], cloudWrapperArrayIndex(i), encoder));
+      }
+      return CborNoError;
+    }
+    virtual void setAttributesFromCloud() {
+      for (size_t i = 0; i < N; i++) {
+        setAttribute(_cloud_value[i], cloudWrapperArrayIndex(i));
+      }
+    }
+    virtual bool isPrimitive() {
+      return true;
+    }
+    /* The shadow copy follows the array, a change is reported only once */
+    virtual bool isChangedLocally() {
+      if (memcmp(_primitive_value, _local_value, sizeof(_local_value)) == 0)
+        return false;
+      memcpy(_local_value, _primitive_value, sizeof(_local_value));
+      return true;
+    }
+    virtual void const * primitive() const {
+      return &_primitive_value;
+    }
+};
+
+#endif /* CLOUDWRAPPERARRAY_H_ */
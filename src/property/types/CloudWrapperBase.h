@@ -32,6 +32,8 @@
 class CloudWrapperBase : public Property {
   public:
     virtual bool isChangedLocally() = 0;
+    /* Address of the wrapped variable */
+    virtual void const * primitive() const = 0;
 };
 
 
@@ -54,9 +54,23 @@ class CloudWrapperBool : public CloudWrapperBase {
     virtual bool isPrimitive() {
       return true;
     }
+#if AIOT_CONFIG_RULES_ENABLED
+    virtual bool getNumber(float & value) {
+      value = _primitive_value ? 1.0f : 0.0f;
+      return true;
+    }
+    virtual bool setNumber(float const value) {
+      /* Picked up by the change scan like a write of the sketch */
+      _primitive_value = value != 0;
+      return true;
+    }
+#endif
     virtual bool isChangedLocally() {
       return _primitive_value != _local_value;
     }
+    virtual void const * primitive() const {
+      return &_primitive_value;
+    }
 };
 
 
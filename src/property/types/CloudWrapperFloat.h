@@ -39,7 +39,7 @@ class CloudWrapperFloat : public CloudWrapperBase {
   public:
     CloudWrapperFloat(float& v) : _primitive_value(v), _cloud_value(v), _local_value(v) {}
     virtual bool isDifferentFromCloud() {
-      return _primitive_value != _cloud_value && (abs(_primitive_value - _cloud_value) >= Property::_min_delta_property);
+      return _primitive_value != _cloud_value && isBeyondMinDelta(_primitive_value, _cloud_value);
     }
     virtual void fromCloudToLocal() {
       _primitive_value = _cloud_value;
@@ -56,9 +56,23 @@ class CloudWrapperFloat : public CloudWrapperBase {
     virtual bool isPrimitive() {
       return true;
     }
+#if AIOT_CONFIG_RULES_ENABLED
+    virtual bool getNumber(float & value) {
+      value = _primitive_value;
+      return true;
+    }
+    virtual bool setNumber(float const value) {
+      /* Picked up by the change scan like a write of the sketch */
+      _primitive_value = value;
+      return true;
+    }
+#endif
     virtual bool isChangedLocally() {
       return _primitive_value != _local_value;
     }
+    virtual void const * primitive() const {
+      return &_primitive_value;
+    }
 };
 
 
@@ -37,7 +37,7 @@ class CloudWrapperInt : public CloudWrapperBase {
   public:
     CloudWrapperInt(int& v) : _primitive_value(v), _cloud_value(v), _local_value(v) {}
     virtual bool isDifferentFromCloud() {
-      return _primitive_value != _cloud_value && (abs(_primitive_value - _cloud_value) >= Property::_min_delta_property);
+      return _primitive_value != _cloud_value && isBeyondMinDelta(_primitive_value, _cloud_value);
     }
     virtual void fromCloudToLocal() {
       _primitive_value = _cloud_value;
@@ -54,9 +54,23 @@ class CloudWrapperInt : public CloudWrapperBase {
     virtual bool isPrimitive() {
       return true;
     }
+#if AIOT_CONFIG_RULES_ENABLED
+    virtual bool getNumber(float & value) {
+      value = static_cast<float>(_primitive_value);
+      return true;
+    }
+    virtual bool setNumber(float const value) {
+      /* Picked up by the change scan like a write of the sketch */
+      _primitive_value = static_cast<int>(value + ((value < 0) ? -0.5f : 0.5f));
+      return true;
+    }
+#endif
     virtual bool isChangedLocally() {
       return _primitive_value != _local_value;
     }
+    virtual void const * primitive() const {
+      return &_primitive_value;
+    }
 };
 
 
@@ -61,6 +61,9 @@ class CloudWrapperString : public CloudWrapperBase {
     virtual bool isChangedLocally() {
       return _primitive_value != _local_value;
     }
+    virtual void const * primitive() const {
+      return &_primitive_value;
+    }
 };
 
 
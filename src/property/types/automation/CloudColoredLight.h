@@ -46,6 +46,16 @@ class ColoredLight : public Color {
 
 };
 
+/* In the order of the attribute identifiers */
+static constexpr AttributeEntry<ColoredLight> COLORED_LIGHT_ATTRIBUTES[] = {
+  AIOT_ATTRIBUTE(ColoredLight, swi),
+  AIOT_ATTRIBUTE(ColoredLight, hue),
+  AIOT_ATTRIBUTE(ColoredLight, sat),
+  AIOT_ATTRIBUTE(ColoredLight, bri),
+};
+static constexpr uint8_t COLORED_LIGHT_ATTRIBUTES_BY_NAME[] = {3 /* bri */, 1 /* hue */, 2 /* sat */, 0 /* swi */};
+static_assert(isSortedByName(COLORED_LIGHT_ATTRIBUTES, COLORED_LIGHT_ATTRIBUTES_BY_NAME, 4), "COLORED_LIGHT_ATTRIBUTES_BY_NAME must be sorted by name");
+
 class CloudColoredLight : public CloudColor {
   private:
     ColoredLight _value,
@@ -119,17 +129,14 @@ class CloudColoredLight : public CloudColor {
       _cloud_value = _value;
     }
     virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
-      CHECK_CBOR_MULTI(appendAttribute(_value.swi, "swi", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.hue, "hue", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.sat, "sat", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.bri, "bri", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.swi, _cloud_value.swi, "swi", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.hue, _cloud_value.hue, "hue", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.sat, _cloud_value.sat, "sat", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.bri, _cloud_value.bri, "bri", encoder));
       return CborNoError;
     }
     virtual void setAttributesFromCloud() {
-      setAttribute(_cloud_value.swi, "swi");
-      setAttribute(_cloud_value.hue, "hue");
-      setAttribute(_cloud_value.sat, "sat");
-      setAttribute(_cloud_value.bri, "bri");
+      setAttributesFromTable(COLORED_LIGHT_ATTRIBUTES, COLORED_LIGHT_ATTRIBUTES_BY_NAME, _cloud_value);
     }
 };
 
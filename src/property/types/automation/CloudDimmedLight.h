@@ -46,6 +46,14 @@ class DimmedLight {
 
 };
 
+/* In the order of the attribute identifiers */
+static constexpr AttributeEntry<DimmedLight> DIMMED_LIGHT_ATTRIBUTES[] = {
+  AIOT_ATTRIBUTE(DimmedLight, swi),
+  AIOT_ATTRIBUTE(DimmedLight, bri),
+};
+static constexpr uint8_t DIMMED_LIGHT_ATTRIBUTES_BY_NAME[] = {1 /* bri */, 0 /* swi */};
+static_assert(isSortedByName(DIMMED_LIGHT_ATTRIBUTES, DIMMED_LIGHT_ATTRIBUTES_BY_NAME, 2), "DIMMED_LIGHT_ATTRIBUTES_BY_NAME must be sorted by name");
+
 class CloudDimmedLight : public Property {
   private:
     DimmedLight _value,
@@ -81,6 +89,7 @@ class CloudDimmedLight : public Property {
 
     void setBrightness(float const bri) {
       _value.bri = bri;
+      updateLocalTimestamp();
     }
 
     bool getSwitch() {
@@ -89,6 +98,7 @@ class CloudDimmedLight : public Property {
 
     void setSwitch(bool const swi) {
       _value.swi = swi;
+      updateLocalTimestamp();
     }
 
     virtual void fromCloudToLocal() {
@@ -99,14 +109,13 @@ class CloudDimmedLight : public Property {
     }
 
     virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
-      CHECK_CBOR_MULTI(appendAttribute(_value.swi, "swi", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.bri, "bri", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.swi, _cloud_value.swi, "swi", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.bri, _cloud_value.bri, "bri", encoder));
       return CborNoError;
     }
 
     virtual void setAttributesFromCloud() {
-      setAttribute(_cloud_value.swi, "swi");
-      setAttribute(_cloud_value.bri, "bri");
+      setAttributesFromTable(DIMMED_LIGHT_ATTRIBUTES, DIMMED_LIGHT_ATTRIBUTES_BY_NAME, _cloud_value);
     }
 };
 
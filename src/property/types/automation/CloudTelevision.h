@@ -136,6 +136,27 @@ class Television {
 
 };
 
+/* The enumerations are received as integers */
+inline void setAttributeValue(PlaybackCommands & value, CborMapData const & md) {
+  setAttributeValue(reinterpret_cast<int &>(value), md);
+}
+
+inline void setAttributeValue(InputValue & value, CborMapData const & md) {
+  setAttributeValue(reinterpret_cast<int &>(value), md);
+}
+
+/* In the order of the attribute identifiers */
+static constexpr AttributeEntry<Television> TELEVISION_ATTRIBUTES[] = {
+  AIOT_ATTRIBUTE(Television, swi),
+  AIOT_ATTRIBUTE(Television, vol),
+  AIOT_ATTRIBUTE(Television, mut),
+  AIOT_ATTRIBUTE(Television, pbc),
+  AIOT_ATTRIBUTE(Television, inp),
+  AIOT_ATTRIBUTE(Television, cha),
+};
+static constexpr uint8_t TELEVISION_ATTRIBUTES_BY_NAME[] = {5 /* cha */, 4 /* inp */, 2 /* mut */, 3 /* pbc */, 0 /* swi */, 1 /* vol */};
+static_assert(isSortedByName(TELEVISION_ATTRIBUTES, TELEVISION_ATTRIBUTES_BY_NAME, 6), "TELEVISION_ATTRIBUTES_BY_NAME must be sorted by name");
+
 class CloudTelevision : public Property {
   private:
     Television _value,
@@ -214,21 +235,16 @@ class CloudTelevision : public Property {
       _cloud_value = _value;
     }
     virtual CborError appendAttributesToCloud(CborEncoder *encoder) {
-      CHECK_CBOR_MULTI(appendAttribute(_value.swi, "swi", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.vol, "vol", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.mut, "mut", encoder));
-      CHECK_CBOR_MULTI(appendAttribute((int)_value.pbc, "pbc", encoder));
-      CHECK_CBOR_MULTI(appendAttribute((int)_value.inp, "inp", encoder));
-      CHECK_CBOR_MULTI(appendAttribute(_value.cha, "cha", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.swi, _cloud_value.swi, "swi", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.vol, _cloud_value.vol, "vol", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.mut, _cloud_value.mut, "mut", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute((int)_value.pbc, (int)_cloud_value.pbc, "pbc", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute((int)_value.inp, (int)_cloud_value.inp, "inp", encoder));
+      CHECK_CBOR_MULTI(appendChangedAttribute(_value.cha, _cloud_value.cha, "cha", encoder));
       return CborNoError;
     }
     virtual void setAttributesFromCloud() {
-      setAttribute(_cloud_value.swi, "swi");
-      setAttribute(_cloud_value.vol, "vol");
-      setAttribute(_cloud_value.mut, "mut");
-      setAttribute((int&)_cloud_value.pbc, "pbc");
-      setAttribute((int&)_cloud_value.inp, "inp");
-      setAttribute(_cloud_value.cha, "cha");
+      setAttributesFromTable(TELEVISION_ATTRIBUTES, TELEVISION_ATTRIBUTES_BY_NAME, _cloud_value);
     }
 };
 
@@ -31,13 +31,35 @@
 
 #include "BearSSLTrustAnchors.h"
 #include "utility/eccX08_asn1.h"
+#include "utility/DRBG.h"
 
 #include "BearSSLClient.h"
+#include "../utility/trace/Trace.h"
+#include "../utility/memory/MemoryPool.h"
 
 extern "C" void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_context *xc, const br_x509_trust_anchor *trust_anchors, size_t trust_anchors_num);
 
 
 bool BearSSLClient::_sslio_closing = false;
+BearSSLClient::SessionCache BearSSLClient::_session_cache BEAR_SSL_CLIENT_SESSION_ATTRIBUTE;
+
+static uint32_t const BEAR_SSL_CLIENT_SESSION_MAGIC = 0x53534C53;
+
+#if AIOT_CONFIG_TLS_KEY_PINNING_ENABLED
+BearSSLClient::PinnedKey BearSSLClient::_pinned_key BEAR_SSL_CLIENT_SESSION_ATTRIBUTE;
+
+static uint32_t const BEAR_SSL_CLIENT_PINNED_KEY_MAGIC = 0x504B4559;
+
+const br_x509_class BearSSLClient::_pinned_vtable = {
+  sizeof(BearSSLClient::PinnedX509Context),
+  BearSSLClient::pinnedStartChain,
+  BearSSLClient::pinnedStartCert,
+  BearSSLClient::pinnedAppend,
+  BearSSLClient::pinnedEndCert,
+  BearSSLClient::pinnedEndChain,
+  BearSSLClient::pinnedGetPkey
+};
+#endif
 
 
 BearSSLClient::BearSSLClient(Client* client, const br_x509_trust_anchor* myTAs, int myNumTAs, GetTimeCallbackFunc func) :
@@ -45,7 +67,13 @@ BearSSLClient::BearSSLClient(Client* client, const br_x509_trust_anchor* myTAs,
   _TAs(myTAs),
   _numTAs(myNumTAs),
   _noSNI(false),
-  _get_time_func(func)
+  _get_time_func(func),
+  _handshake_state(HandshakeState::Idle),
+  _eccX08Checked(false),
+  _eccX08Usable(false),
+  _cork_cnt(0),
+  _session_offered(false),
+  _session_resumed(false)
 {
   assert(_get_time_func != nullptr);
 
@@ -61,13 +89,15 @@ BearSSLClient::BearSSLClient(Client* client, const br_x509_trust_anchor* myTAs,
 BearSSLClient::~BearSSLClient()
 {
   if (_ecCertDynamic && _ecCert.data) {
-    free(_ecCert.data);
+    memoryFree(MemoryPool::Certificate, _ecCert.data);
     _ecCert.data = NULL;
   }
 }
 
 int BearSSLClient::connect(IPAddress ip, uint16_t port)
 {
+  _handshake_state = HandshakeState::Idle;
+
   if (!_client->connect(ip, port)) {
     return 0;
   }
@@ -77,6 +107,14 @@ int BearSSLClient::connect(IPAddress ip, uint16_t port)
 
 int BearSSLClient::connect(const char* host, uint16_t port)
 {
+  // adopt a session established through connectAsync()
+  bool const handshake_completed = (_handshake_state == HandshakeState::Completed);
+  _handshake_state = HandshakeState::Idle;
+
+  if (handshake_completed && connected()) {
+    return 1;
+  }
+
   if (!_client->connect(host, port)) {
     return 0;
   }
@@ -104,13 +142,45 @@ size_t BearSSLClient::write(const uint8_t *buf, size_t size)
     written += result;
   }
 
-  if (written == size && br_sslio_flush(&_ioc) < 0) {
+  if (written == size && _cork_cnt == 0 && br_sslio_flush(&_ioc) < 0) {
     return 0;
   }
 
+  AIOTC_TRACE(TlsWrite, written);
   return written;
 }
 
+unsigned char * BearSSLClient::appBuffer(size_t & len)
+{
+  len = 0;
+  if (!connected()) {
+    return nullptr;
+  }
+
+  return br_ssl_engine_sendapp_buf(&_sc.eng, &len);
+}
+
+size_t BearSSLClient::writeAppBuffer(size_t const len)
+{
+  br_ssl_engine_sendapp_ack(&_sc.eng, len);
+
+  if (_cork_cnt == 0 && br_sslio_flush(&_ioc) < 0) {
+    return 0;
+  }
+
+  AIOTC_TRACE(TlsWrite, len);
+  return len;
+}
+
+int BearSSLClient::uncork()
+{
+  if (_cork_cnt == 0 || --_cork_cnt > 0) {
+    return 1;
+  }
+
+  return (br_sslio_flush(&_ioc) < 0) ? 0 : 1;
+}
+
 int BearSSLClient::available()
 {
   int available = br_sslio_read_available(&_ioc);
@@ -126,6 +196,16 @@ int BearSSLClient::read()
 {
   byte b;
 
+  // take the byte straight from an already decrypted record if there is one
+  size_t len;
+  unsigned char* app = br_ssl_engine_recvapp_buf(&_sc.eng, &len);
+
+  if (app != NULL && len > 0) {
+    b = app[0];
+    br_ssl_engine_recvapp_ack(&_sc.eng, 1);
+    return b;
+  }
+
   if (read(&b, sizeof(b)) == sizeof(b)) {
     return b;
   }
@@ -135,7 +215,22 @@ int BearSSLClient::read()
 
 int BearSSLClient::read(uint8_t *buf, size_t size)
 {
-  return br_sslio_read(&_ioc, buf, size);
+  int result = br_sslio_read(&_ioc, buf, size);
+
+  // br_sslio_read stops at the record boundary, continue with the records
+  // which can be obtained without blocking
+  while (result > 0 && (size_t)result < size && br_sslio_read_available(&_ioc) > 0) {
+    int more = br_sslio_read(&_ioc, buf + result, size - result);
+
+    if (more <= 0) {
+      break;
+    }
+
+    result += more;
+  }
+
+  AIOTC_TRACE(TlsRead, result);
+  return result;
 }
 
 int BearSSLClient::peek()
@@ -158,6 +253,9 @@ void BearSSLClient::flush()
 
 void BearSSLClient::stop()
 {
+  _handshake_state = HandshakeState::Idle;
+  _cork_cnt = 0;
+
   if (_client->connected()) {
     if ((br_ssl_engine_current_state(&_sc.eng) & BR_SSL_CLOSED) == 0) {
       BearSSLClient::_sslio_closing = true;
@@ -170,6 +268,10 @@ void BearSSLClient::stop()
 
 uint8_t BearSSLClient::connected()
 {
+  if (_handshake_state != HandshakeState::Idle) {
+    return 0;
+  }
+
   if (!_client->connected()) {
     return 0;
   }
@@ -217,12 +319,12 @@ void BearSSLClient::setEccSlot(int ecc508KeySlot, const char cert[])
 
   // free old data
   if (_ecCertDynamic && _ecCert.data) {
-    free(_ecCert.data);
+    memoryFree(MemoryPool::Certificate, _ecCert.data);
     _ecCert.data = NULL;
   }
 
   // assume the decoded cert is 3/4 the length of the input
-  _ecCert.data = (unsigned char*)malloc(((certLen * 3) + 3) / 4);
+  _ecCert.data = (unsigned char*)memoryAlloc(MemoryPool::Certificate, ((certLen * 3) + 3) / 4);
   _ecCert.data_len = 0;
 
   br_pem_decoder_init(&pemDecoder);
@@ -249,7 +351,7 @@ void BearSSLClient::setEccSlot(int ecc508KeySlot, const char cert[])
 
       case BR_PEM_ERROR:
         // failure
-        free(_ecCert.data);
+        memoryFree(MemoryPool::Certificate, _ecCert.data);
         setEccSlot(ecc508KeySlot, NULL, 0);
         return;
     }
@@ -261,7 +363,134 @@ int BearSSLClient::errorCode()
   return br_ssl_engine_last_error(&_sc.eng);
 }
 
+int BearSSLClient::connectAsync(const char* host, uint16_t port)
+{
+  _handshake_state = HandshakeState::Idle;
+
+  if (!_client->connect(host, port)) {
+    return 0;
+  }
+
+  initSSL(_noSNI ? NULL : host);
+  _handshake_state = HandshakeState::InProgress;
+
+  return 1;
+}
+
+int BearSSLClient::connectAsync(IPAddress ip, uint16_t port, const char* host)
+{
+  _handshake_state = HandshakeState::Idle;
+
+  if (!_client->connect(ip, port)) {
+    return 0;
+  }
+
+  initSSL(_noSNI ? NULL : host);
+  _handshake_state = HandshakeState::InProgress;
+
+  return 1;
+}
+
+BearSSLClient::Handshake BearSSLClient::pollHandshake()
+{
+  switch (_handshake_state) {
+    case HandshakeState::Idle      : return Handshake::Failed;
+    case HandshakeState::Completed : return Handshake::Completed;
+    default: break;
+  }
+
+  unsigned state = br_ssl_engine_current_state(&_sc.eng);
+
+  if (state & BR_SSL_CLOSED) {
+    // the cached session may have been the reason
+    _session_cache.magic = 0;
+    return failHandshake();
+  }
+
+  // pending records are always sent first, same as br_sslio does
+  if (state & BR_SSL_SENDREC) {
+    size_t len;
+    unsigned char* buf = br_ssl_engine_sendrec_buf(&_sc.eng, &len);
+    int wlen = clientWrite(_client, buf, len);
+
+    if (wlen < 0) {
+      return failHandshake();
+    }
+    if (wlen > 0) {
+      br_ssl_engine_sendrec_ack(&_sc.eng, wlen);
+    }
+    return Handshake::InProgress;
+  }
+
+  if (state & BR_SSL_SENDAPP) {
+    saveSession();
+    _handshake_state = HandshakeState::Completed;
+    return Handshake::Completed;
+  }
+
+  // only read what has already been received in order not to block
+  if ((state & BR_SSL_RECVREC) && _client->available() > 0) {
+    size_t len;
+    unsigned char* buf = br_ssl_engine_recvrec_buf(&_sc.eng, &len);
+    int rlen = clientRead(_client, buf, len);
+
+    if (rlen < 0) {
+      return failHandshake();
+    }
+    if (rlen > 0) {
+      br_ssl_engine_recvrec_ack(&_sc.eng, rlen);
+    }
+  } else if (!_client->connected()) {
+    return failHandshake();
+  }
+
+  return Handshake::InProgress;
+}
+
+BearSSLClient::Handshake BearSSLClient::failHandshake()
+{
+  _handshake_state = HandshakeState::Idle;
+  _client->stop();
+
+  return Handshake::Failed;
+}
+
 int BearSSLClient::connectSSL(const char* host)
+{
+  initSSL(host);
+
+  br_sslio_flush(&_ioc);
+
+  while (1) {
+    unsigned state = br_ssl_engine_current_state(&_sc.eng);
+
+    if (state & BR_SSL_SENDAPP) {
+      break;
+    } else if (state & BR_SSL_CLOSED) {
+      _session_cache.magic = 0;
+      return 0;
+    }
+  }
+
+  saveSession();
+  return 1;
+}
+
+void BearSSLClient::saveSession()
+{
+  // the server echoes the id of the session offered if it resumes it
+  br_ssl_session_parameters params;
+  br_ssl_engine_get_session_parameters(&_sc.eng, &params);
+  _session_resumed = _session_offered &&
+                     (params.session_id_len > 0) &&
+                     (params.session_id_len == _session_cache.params.session_id_len) &&
+                     (memcmp(params.session_id, _session_cache.params.session_id, params.session_id_len) == 0);
+
+  _session_cache.params = params;
+  _session_cache.magic = BEAR_SSL_CLIENT_SESSION_MAGIC;
+}
+
+void BearSSLClient::initSSL(const char* host)
 {
   /* Ensure this flag is cleared so we don't terminate a just starting connection. */
   _sslio_closing = false;
@@ -269,15 +498,34 @@ int BearSSLClient::connectSSL(const char* host)
   // initialize client context with all necessary algorithms and hardcoded trust anchors.
   aiotc_client_profile_init(&_sc, &_xc, _TAs, _numTAs);
 
+#if AIOT_CONFIG_TLS_KEY_PINNING_ENABLED
+  // the chain is passed on to _xc unless the server presents the pinned certificate
+  _pxc.vtable = &_pinned_vtable;
+  _pxc.minimal = &_xc;
+  br_ssl_engine_set_x509(&_sc.eng, &_pxc.vtable);
+#endif
+
+#if AIOT_CONFIG_TLS_HALF_DUPLEX
+  br_ssl_engine_set_buffer(&_sc.eng, _ibuf, sizeof(_ibuf), 0);
+#else
   br_ssl_engine_set_buffers_bidi(&_sc.eng, _ibuf, sizeof(_ibuf), _obuf, sizeof(_obuf));
+#endif
 
   // inject entropy in engine
   unsigned char entropy[32];
 
-  if (ECCX08.begin() && ECCX08.locked() && ECCX08.random(entropy, sizeof(entropy))) {
-    // ECC508 random success, add custom ECDSA vfry and EC sign
+  // the ECCX08 configuration does not change, avoid waking it up for it on every connect
+  if (!_eccX08Checked) {
+    _eccX08Usable = ECCX08.begin() && ECCX08.locked();
+    _eccX08Checked = true;
+  }
+
+  if (_eccX08Usable && drbg_generate(entropy, sizeof(entropy))) {
+#if !AIOT_CONFIG_TLS_SOFTWARE_ECDSA_VERIFY
+    // DRBG seeded from the ECC508, add custom ECDSA vfry and EC sign
     br_ssl_engine_set_ecdsa(&_sc.eng, eccX08_vrfy_asn1);
     br_x509_minimal_set_ecdsa(&_xc, br_ssl_engine_get_ec(&_sc.eng), br_ssl_engine_get_ecdsa(&_sc.eng));
+#endif
     
     // enable client auth using the ECCX08
     if (_ecCert.data_len && _ecKey.xlen) {
@@ -291,8 +539,14 @@ int BearSSLClient::connectSSL(const char* host)
   }
   br_ssl_engine_inject_entropy(&_sc.eng, entropy, sizeof(entropy));
 
-  // set the hostname used for SNI
-  br_ssl_client_reset(&_sc, host, 0);
+  // set the hostname used for SNI and try to resume the last session
+  bool const resume_session = (_session_cache.magic == BEAR_SSL_CLIENT_SESSION_MAGIC);
+  _session_offered = resume_session;
+  _session_resumed = false;
+  if (resume_session) {
+    br_ssl_engine_set_session_parameters(&_sc.eng, &_session_cache.params);
+  }
+  br_ssl_client_reset(&_sc, host, resume_session ? 1 : 0);
 
   // get the current time and set it for X.509 validation
   uint32_t now = _get_time_func();
@@ -303,20 +557,6 @@ int BearSSLClient::connectSSL(const char* host)
 
   // use our own socket I/O operations
   br_sslio_init(&_ioc, &_sc.eng, BearSSLClient::clientRead, _client, BearSSLClient::clientWrite, _client);
-
-  br_sslio_flush(&_ioc);
-
-  while (1) {
-    unsigned state = br_ssl_engine_current_state(&_sc.eng);
-
-    if (state & BR_SSL_SENDAPP) {
-      break;
-    } else if (state & BR_SSL_CLOSED) {
-      return 0;
-    }
-  }
-
-  return 1;
 }
 
 // #define DEBUGSERIAL Serial
@@ -399,4 +639,128 @@ void BearSSLClient::clientAppendCert(void *ctx, const void *data, size_t len)
   c->_ecCert.data_len += len;
 }
 
+#if AIOT_CONFIG_TLS_KEY_PINNING_ENABLED
+void BearSSLClient::pinnedStartChain(const br_x509_class **ctx, const char *server_name)
+{
+  PinnedX509Context* pxc = (PinnedX509Context*)ctx;
+
+  pxc->cert_cnt = 0;
+  pxc->is_pinned = false;
+  pxc->server_name = server_name;
+  pxc->minimal->vtable->start_chain(&pxc->minimal->vtable, server_name);
+}
+
+void BearSSLClient::pinnedStartCert(const br_x509_class **ctx, uint32_t length)
+{
+  PinnedX509Context* pxc = (PinnedX509Context*)ctx;
+
+  if (pxc->cert_cnt == 0) {
+    br_sha256_init(&pxc->leaf_hash);
+    br_x509_decoder_init(&pxc->leaf, 0, 0);
+  }
+  if (!pxc->is_pinned) {
+    pxc->minimal->vtable->start_cert(&pxc->minimal->vtable, length);
+  }
+}
+
+void BearSSLClient::pinnedAppend(const br_x509_class **ctx, const unsigned char *buf, size_t len)
+{
+  PinnedX509Context* pxc = (PinnedX509Context*)ctx;
+
+  if (pxc->cert_cnt == 0) {
+    br_sha256_update(&pxc->leaf_hash, buf, len);
+    br_x509_decoder_push(&pxc->leaf, buf, len);
+  }
+  if (!pxc->is_pinned) {
+    pxc->minimal->vtable->append(&pxc->minimal->vtable, buf, len);
+  }
+}
+
+void BearSSLClient::pinnedEndCert(const br_x509_class **ctx)
+{
+  PinnedX509Context* pxc = (PinnedX509Context*)ctx;
+
+  // the leaf certificate comes first, nothing has been verified up to here
+  if (pxc->cert_cnt == 0) {
+    br_sha256_out(&pxc->leaf_hash, pxc->leaf_cert_hash);
+    pxc->is_pinned = isPinValid(pxc);
+  }
+  if (!pxc->is_pinned) {
+    pxc->minimal->vtable->end_cert(&pxc->minimal->vtable);
+  }
+  pxc->cert_cnt++;
+}
+
+unsigned BearSSLClient::pinnedEndChain(const br_x509_class **ctx)
+{
+  PinnedX509Context* pxc = (PinnedX509Context*)ctx;
+
+  if (pxc->is_pinned) {
+    pxc->key.curve = _pinned_key.curve;
+    pxc->key.q = _pinned_key.q;
+    pxc->key.qlen = _pinned_key.qlen;
+    br_x509_knownkey_init_ec(&pxc->known, &pxc->key, _pinned_key.usages);
+    return 0;
+  }
+
+  unsigned const err = pxc->minimal->vtable->end_chain(&pxc->minimal->vtable);
+  if (err != 0) {
+    return err;
+  }
+
+  // pin the key of the chain which has just been validated
+  unsigned usages = 0;
+  const br_x509_pkey* pkey = pxc->minimal->vtable->get_pkey(&pxc->minimal->vtable, &usages);
+  _pinned_key.magic = 0;
+  if (pkey && (pkey->key_type == BR_KEYTYPE_EC) && (pkey->key.ec.qlen <= sizeof(_pinned_key.q)) &&
+      pxc->server_name && (strlen(pxc->server_name) < sizeof(_pinned_key.server_name)) &&
+      (br_x509_decoder_last_error(&pxc->leaf) == 0)) {
+    memcpy(_pinned_key.cert_hash, pxc->leaf_cert_hash, sizeof(_pinned_key.cert_hash));
+    strcpy(_pinned_key.server_name, pxc->server_name);
+    _pinned_key.notbefore_days = pxc->leaf.notbefore_days;
+    _pinned_key.notbefore_seconds = pxc->leaf.notbefore_seconds;
+    _pinned_key.notafter_days = pxc->leaf.notafter_days;
+    _pinned_key.notafter_seconds = pxc->leaf.notafter_seconds;
+    _pinned_key.curve = pkey->key.ec.curve;
+    memcpy(_pinned_key.q, pkey->key.ec.q, pkey->key.ec.qlen);
+    _pinned_key.qlen = pkey->key.ec.qlen;
+    _pinned_key.usages = usages;
+    _pinned_key.magic = BEAR_SSL_CLIENT_PINNED_KEY_MAGIC;
+  }
+  return 0;
+}
+
+bool BearSSLClient::isPinValid(PinnedX509Context const * pxc)
+{
+  if ((_pinned_key.magic != BEAR_SSL_CLIENT_PINNED_KEY_MAGIC) ||
+      (memcmp(pxc->leaf_cert_hash, _pinned_key.cert_hash, sizeof(pxc->leaf_cert_hash)) != 0)) {
+    return false;
+  }
+
+  // the pin only stands for the server name it has been validated for
+  if (!pxc->server_name || (strcmp(pxc->server_name, _pinned_key.server_name) != 0)) {
+    return false;
+  }
+
+  // and only within the validity period of the certificate, at the time set for the minimal engine
+  uint32_t const days = pxc->minimal->days;
+  uint32_t const seconds = pxc->minimal->seconds;
+  bool const is_before = (days < _pinned_key.notbefore_days) ||
+                         ((days == _pinned_key.notbefore_days) && (seconds < _pinned_key.notbefore_seconds));
+  bool const is_after = (days > _pinned_key.notafter_days) ||
+                        ((days == _pinned_key.notafter_days) && (seconds > _pinned_key.notafter_seconds));
+  return !is_before && !is_after;
+}
+
+const br_x509_pkey * BearSSLClient::pinnedGetPkey(const br_x509_class *const *ctx, unsigned *usages)
+{
+  const PinnedX509Context* pxc = (const PinnedX509Context*)ctx;
+
+  if (pxc->is_pinned) {
+    return pxc->known.vtable->get_pkey(&pxc->known.vtable, usages);
+  }
+  return pxc->minimal->vtable->get_pkey(&pxc->minimal->vtable, usages);
+}
+#endif
+
 #endif /* #ifdef BOARD_HAS_ECCX08 */
@@ -28,6 +28,18 @@
 #include <AIoTC_Config.h>
 #ifdef BOARD_HAS_ECCX08
 
+/* BearSSL advertises the largest fragment length fitting into both buffers,
+ * the overheads are MAX_OUT_OVERHEAD and MAX_IN_OVERHEAD of ssl_engine.c
+ */
+#if AIOT_CONFIG_TLS_MAX_FRAGMENT_LENGTH
+#ifndef BEAR_SSL_CLIENT_OBUF_SIZE
+#define BEAR_SSL_CLIENT_OBUF_SIZE AIOT_CONFIG_TLS_MAX_FRAGMENT_LENGTH + 85
+#endif
+#ifndef BEAR_SSL_CLIENT_IBUF_SIZE
+#define BEAR_SSL_CLIENT_IBUF_SIZE AIOT_CONFIG_TLS_MAX_FRAGMENT_LENGTH + 325
+#endif
+#endif
+
 #ifndef BEAR_SSL_CLIENT_OBUF_SIZE
 #define BEAR_SSL_CLIENT_OBUF_SIZE 512 + 85
 #endif
@@ -36,6 +48,15 @@
 #define BEAR_SSL_CLIENT_IBUF_SIZE 8192 + 85 + 325 - BEAR_SSL_CLIENT_OBUF_SIZE
 #endif
 
+/* Define as e.g. ".noinit" to keep the cached TLS session and the pinned
+ * server key across a watchdog reset
+ */
+#ifdef BEAR_SSL_CLIENT_SESSION_SECTION
+#define BEAR_SSL_CLIENT_SESSION_ATTRIBUTE __attribute__((section(BEAR_SSL_CLIENT_SESSION_SECTION)))
+#else
+#define BEAR_SSL_CLIENT_SESSION_ATTRIBUTE
+#endif
+
 #include <Arduino.h>
 #include <Client.h>
 
@@ -80,11 +101,59 @@ public:
 
   int errorCode();
 
+  enum class Handshake {
+    InProgress,
+    Completed,
+    Failed
+  };
+
+  /* Non-blocking alternative to connect(): connectAsync() opens the socket
+   * and starts the TLS handshake, pollHandshake() advances it by at most one
+   * record per call. The completed session is handed over to the next call
+   * of connect(), until then the client does not report being connected.
+   * The socket may be opened to an address resolved beforehand, the host
+   * is then only used for SNI and the verification of the certificate.
+   */
+  int connectAsync(const char* host, uint16_t port);
+  int connectAsync(IPAddress ip, uint16_t port, const char* host);
+  Handshake pollHandshake();
+
+  /* Zero-copy alternative to write(): appBuffer() returns the plaintext
+   * buffer of the next record (nullptr if none is available), writeAppBuffer()
+   * seals its first len bytes into a single record and sends it.
+   */
+  unsigned char * appBuffer(size_t & len);
+  size_t writeAppBuffer(size_t const len);
+
+  /* Between cork() and the matching uncork() written data is not flushed,
+   * a record is only sealed once the output buffer is full. uncork()
+   * returns 0 if sending the pending data failed.
+   */
+  inline void cork() { _cork_cnt++; }
+  int uncork();
+
+  /* Whether the server resumed the cached session in the last handshake
+   * instead of running the full ECDHE+ECDSA one.
+   */
+  inline bool isSessionResumed() const { return _session_resumed; }
+
 private:
   int connectSSL(const char* host);
+  void initSSL(const char* host);
+  Handshake failHandshake();
+  void saveSession();
   static int clientRead(void *ctx, unsigned char *buf, size_t len);
   static int clientWrite(void *ctx, const unsigned char *buf, size_t len);
   static void clientAppendCert(void *ctx, const void *data, size_t len);
+#if AIOT_CONFIG_TLS_KEY_PINNING_ENABLED
+  static void pinnedStartChain(const br_x509_class **ctx, const char *server_name);
+  static void pinnedStartCert(const br_x509_class **ctx, uint32_t length);
+  static void pinnedAppend(const br_x509_class **ctx, const unsigned char *buf, size_t len);
+  static void pinnedEndCert(const br_x509_class **ctx);
+  static unsigned pinnedEndChain(const br_x509_class **ctx);
+  static const br_x509_pkey * pinnedGetPkey(const br_x509_class *const *ctx, unsigned *usages);
+  static const br_x509_class _pinned_vtable;
+#endif
 
 private:
   Client* _client;
@@ -93,15 +162,76 @@ private:
   bool _noSNI;
   GetTimeCallbackFunc _get_time_func;
 
+  enum class HandshakeState {
+    Idle,
+    InProgress,
+    Completed
+  };
+  HandshakeState _handshake_state;
+
+  /* ECCX08.begin() and locked() are only queried on the first connect */
+  bool _eccX08Checked;
+  bool _eccX08Usable;
+
+  unsigned int _cork_cnt;
+
+  bool _session_offered;
+  bool _session_resumed;
+
   br_ec_private_key _ecKey;
   br_x509_certificate _ecCert;
   bool _ecCertDynamic;
 
   static bool _sslio_closing;
+
+  /* Parameters of the last established session, offered to the server on
+   * the next connect in order to skip the full ECDHE+ECDSA handshake.
+   */
+  struct SessionCache {
+    uint32_t magic;
+    br_ssl_session_parameters params;
+  };
+  static SessionCache _session_cache;
+#if AIOT_CONFIG_TLS_KEY_PINNING_ENABLED
+  /* Server certificate and key of the last fully validated chain, the server
+   * name it was validated for and the validity period of the certificate.
+   * The X.509 engine below hashes and decodes the leaf certificate while
+   * passing the chain on to the minimal engine, and stops doing so once the
+   * hash, the server name and the current time match the pin.
+   */
+  struct PinnedKey {
+    uint32_t magic;
+    unsigned char cert_hash[br_sha256_SIZE];
+    char server_name[64];
+    uint32_t notbefore_days, notbefore_seconds;
+    uint32_t notafter_days, notafter_seconds;
+    int curve;
+    unsigned char q[BR_EC_KBUF_PUB_MAX_SIZE];
+    size_t qlen;
+    unsigned usages;
+  };
+  static PinnedKey _pinned_key;
+  struct PinnedX509Context {
+    const br_x509_class * vtable;
+    br_x509_minimal_context * minimal;
+    br_x509_knownkey_context known;
+    br_sha256_context leaf_hash;
+    unsigned char leaf_cert_hash[br_sha256_SIZE];
+    br_x509_decoder_context leaf;
+    const char * server_name;
+    br_ec_public_key key;
+    unsigned cert_cnt;
+    bool is_pinned;
+  };
+  static bool isPinValid(PinnedX509Context const * pxc);
+  PinnedX509Context _pxc;
+#endif
   br_ssl_client_context _sc;
   br_x509_minimal_context _xc;
   unsigned char _ibuf[BEAR_SSL_CLIENT_IBUF_SIZE];
+#if !AIOT_CONFIG_TLS_HALF_DUPLEX
   unsigned char _obuf[BEAR_SSL_CLIENT_OBUF_SIZE];
+#endif
   br_sslio_context _ioc;
 };
 
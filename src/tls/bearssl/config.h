@@ -51,8 +51,13 @@
 #define BR_LOMUL   1
  */
 #ifdef ARDUINO
+#if defined(__ARM_ARCH_7EM__)
+/* Cortex-M4/M7 (e.g. STM32H7) have a single cycle 32x32->64 multiplier */
+#define BR_LOMUL   0
+#else
 #define BR_LOMUL   1
 #endif
+#endif
 
 /*
  * When BR_SLOW_MUL is enabled, multiplications are assumed to be
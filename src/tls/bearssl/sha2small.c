@@ -68,6 +68,32 @@ static const uint32_t K[64] = {
 	0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
 };
 
+/*
+ * Decodes a block into big-endian words. A word-aligned block, e.g. an
+ * image hashed in place from flash, is loaded a word at a time and swapped,
+ * a single REV on ARMv6-M and later.
+ */
+static inline void
+sha2small_dec_block(uint32_t *w, const unsigned char *buf)
+{
+#if defined __GNUC__ && defined __BYTE_ORDER__ && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	if (((uintptr_t)buf & 3) == 0) {
+		const unsigned char *src;
+		int i;
+
+		src = __builtin_assume_aligned(buf, 4);
+		for (i = 0; i < 16; i ++) {
+			uint32_t x;
+
+			memcpy(&x, src + (i << 2), sizeof x);
+			w[i] = __builtin_bswap32(x);
+		}
+		return;
+	}
+#endif
+	br_range_dec32be(w, 16, buf);
+}
+
 /* see inner.h */
 void
 br_sha2small_round(const unsigned char *buf, uint32_t *val)
@@ -85,7 +111,7 @@ br_sha2small_round(const unsigned char *buf, uint32_t *val)
 	uint32_t a, b, c, d, e, f, g, h;
 	uint32_t w[64];
 
-	br_range_dec32be(w, 16, buf);
+	sha2small_dec_block(w, buf);
 	for (i = 16; i < 64; i ++) {
 		w[i] = SSG2_1(w[i - 2]) + w[i - 7]
 			+ SSG2_0(w[i - 15]) + w[i - 16];
@@ -214,6 +240,17 @@ sha2small_update(br_sha224_context *cc, const void *data, size_t len)
 	while (len > 0) {
 		size_t clen;
 
+		/*
+		 * Whole blocks are hashed where they are instead of being
+		 * copied into the context first.
+		 */
+		if (ptr == 0 && len >= 64) {
+			br_sha2small_round(buf, cc->val);
+			buf += 64;
+			len -= 64;
+			continue;
+		}
+
 		clen = 64 - ptr;
 		if (clen > len) {
 			clen = len;
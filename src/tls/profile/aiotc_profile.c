@@ -27,6 +27,24 @@
 
 #include "../bearssl/inner.h"
 
+/*
+ * Board specific (e.g. hardware accelerated) implementations can be
+ * plugged in by defining these macros to the name of a br_block_ctr_class
+ * for AES-CTR, a br_ghash function and a br_hash_class for SHA-256.
+ */
+#ifdef AIOT_CONFIG_TLS_AES_CTR_IMPL
+extern const br_block_ctr_class AIOT_CONFIG_TLS_AES_CTR_IMPL;
+#endif
+#ifdef AIOT_CONFIG_TLS_GHASH_IMPL
+extern void AIOT_CONFIG_TLS_GHASH_IMPL(void *y, const void *h, const void *data, size_t len);
+#endif
+#ifdef AIOT_CONFIG_TLS_SHA256_IMPL
+extern const br_hash_class AIOT_CONFIG_TLS_SHA256_IMPL;
+#define AIOTC_SHA256_VTABLE (&AIOT_CONFIG_TLS_SHA256_IMPL)
+#else
+#define AIOTC_SHA256_VTABLE (&br_sha256_vtable)
+#endif
+
 /* see bearssl_ssl.h */
 void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_context *xc, const br_x509_trust_anchor *trust_anchors, size_t trust_anchors_num)
 {
@@ -62,7 +80,7 @@ void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_contex
    * X.509 engine uses SHA-256 to hash certificate DN (for
    * comparisons).
    */
-  br_x509_minimal_init(xc, &br_sha256_vtable, trust_anchors, trust_anchors_num);
+  br_x509_minimal_init(xc, AIOTC_SHA256_VTABLE, trust_anchors, trust_anchors_num);
 
   /*
    * Set suites and asymmetric crypto implementations. We use the
@@ -71,15 +89,25 @@ void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_contex
    * TODO: change that when better implementations are made available.
    */
   br_ssl_engine_set_suites(&cc->eng, suites, (sizeof suites) / (sizeof suites[0]));
+#if AIOT_CONFIG_TLS_PROFILE_MINIMAL
+  /*
+   * Only P-256 is used for both ECDHE and the certificates, the "m15"
+   * and "i15" code performs best on cores without a fast 32x32->64
+   * multiplier such as the Cortex-M0+.
+   */
+  br_ssl_engine_set_ec(&cc->eng, &br_ec_p256_m15);
+  br_ssl_engine_set_ecdsa(&cc->eng, &br_ecdsa_i15_vrfy_asn1);
+#else
   br_ssl_engine_set_default_ecdsa(&cc->eng);
+#endif
   br_x509_minimal_set_ecdsa(xc, br_ssl_engine_get_ec(&cc->eng), br_ssl_engine_get_ecdsa(&cc->eng));
 
   /*
    * Set supported hash functions, for the SSL engine and for the
    * X.509 engine.
    */
-  br_ssl_engine_set_hash(&cc->eng, br_sha256_ID, &br_sha256_vtable);
-  br_x509_minimal_set_hash(xc, br_sha256_ID, &br_sha256_vtable);
+  br_ssl_engine_set_hash(&cc->eng, br_sha256_ID, AIOTC_SHA256_VTABLE);
+  br_x509_minimal_set_hash(xc, br_sha256_ID, AIOTC_SHA256_VTABLE);
 
   /*
    * Link the X.509 engine in the SSL engine.
@@ -91,11 +119,28 @@ void aiotc_client_profile_init(br_ssl_client_context *cc, br_x509_minimal_contex
    */
   br_ssl_engine_set_prf_sha256(&cc->eng, &br_tls12_sha256_prf);
 
+#if AIOT_CONFIG_TLS_PROFILE_MINIMAL
+  /*
+   * Symmetric encryption. The 32-bit constant-time implementations are
+   * set directly so that the hardware accelerated variants are not linked.
+   */
+  br_ssl_engine_set_gcm(&cc->eng, &br_sslrec_in_gcm_vtable, &br_sslrec_out_gcm_vtable);
+  br_ssl_engine_set_aes_ctr(&cc->eng, &br_aes_ct_ctr_vtable);
+  br_ssl_engine_set_ghash(&cc->eng, &br_ghash_ctmul32);
+#else
   /*
    * Symmetric encryption. We use the "default" implementations
    * (fastest among constant-time implementations).
    */
   br_ssl_engine_set_default_aes_gcm(&cc->eng);
+#endif
+
+#ifdef AIOT_CONFIG_TLS_AES_CTR_IMPL
+  br_ssl_engine_set_aes_ctr(&cc->eng, &AIOT_CONFIG_TLS_AES_CTR_IMPL);
+#endif
+#ifdef AIOT_CONFIG_TLS_GHASH_IMPL
+  br_ssl_engine_set_ghash(&cc->eng, &AIOT_CONFIG_TLS_GHASH_IMPL);
+#endif
 }
 
 #endif /* #ifdef BOARD_HAS_ECCX08 */
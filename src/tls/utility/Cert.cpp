@@ -26,6 +26,7 @@
 #if defined(BOARD_HAS_ECCX08) || defined(BOARD_HAS_OFFLOADED_ECCX08) || defined(BOARD_HAS_SE050)
 
 #include "Cert.h"
+#include "../../utility/memory/MemoryPool.h"
 
 /******************************************************************************
  * DEFINE
@@ -39,64 +40,226 @@
 #define ASN1_SEQUENCE          0x30
 #define ASN1_SET               0x31
 
+/* Upper bounds of the encoded lengths used to size the buffer, the names
+ * of issuer and subject excluded. Each name adds its length plus at most
+ * CERT_NAME_MAX_OVERHEAD bytes of headers and object identifier.
+ */
+#define CERT_HEADER_MAX_LENGTH          4
+#define CERT_INFO_MAX_LENGTH          212
+#define CSR_INFO_MAX_LENGTH           104
+#define CERT_NAME_MAX_OVERHEAD         17
+#define CERT_SIGNATURE_MAX_LENGTH      87
+
+/* The PEM body is written in lines of 76 characters plus a newline */
+#define PEM_LINE_LENGTH                76
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+static const byte CERT_VERSION_V3[]          = {0xA0, 0x03, ASN1_INTEGER, 0x01, 0x02};
+static const byte CSR_VERSION_V1[]           = {ASN1_INTEGER, 0x01, 0x00};
+static const byte CSR_ATTRIBUTES_EMPTY[]     = {0xA0, 0x00};
+static const byte CERT_EXTENSIONS_EMPTY[]    = {0xA3, 0x02, ASN1_SEQUENCE, 0x00};
+
+/* ECDSA with SHA256 */
+static const byte ECDSA_WITH_SHA256[]        = {ASN1_SEQUENCE, 0x0A, ASN1_OBJECT_IDENTIFIER, 0x08,
+                                                0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02};
+
+/* Subject public key info of an uncompressed PRIME 256 v1 EC public key */
+static const byte PUBLIC_KEY_HEADER[]        = {ASN1_SEQUENCE, 0x59, ASN1_SEQUENCE, 0x13,
+                                                ASN1_OBJECT_IDENTIFIER, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01,
+                                                ASN1_OBJECT_IDENTIFIER, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07,
+                                                ASN1_BIT_STRING, 0x42, 0x00, 0x04};
+
+/* [3] { { 2.5.29.35 authorityKeyIdentifier { [0] keyIdentifier } } } */
+static const byte AUTHORITY_KEY_ID_HEADER[]  = {0xA3, 0x23, ASN1_SEQUENCE, 0x21, ASN1_SEQUENCE, 0x1F,
+                                                ASN1_OBJECT_IDENTIFIER, 0x03, 0x55, 0x1D, 0x23,
+                                                0x04, 0x18, ASN1_SEQUENCE, 0x16, 0x80, 0x14};
+
+/******************************************************************************
+ * LOCAL MODULE CLASSES
+ ******************************************************************************/
+
+/* Writes the DER encoding back to front: the contents of an element are
+ * written before its header, so the length of each nested element is known
+ * when the header is written and nothing has to be measured in advance.
+ */
+class DERWriter
+{
+public:
+
+  DERWriter(byte buffer[], int end)
+  : _buffer(buffer)
+  , _pos(end)
+  { }
+
+  inline int    mark       () const { return _pos; }
+  inline int    lengthSince(int const mark) const { return mark - _pos; }
+  inline byte * data       () const { return _buffer + _pos; }
+  inline bool   overflow   () const { return _pos < 0; }
+
+  void prepend(byte const value)
+  {
+    if (--_pos >= 0) {
+      _buffer[_pos] = value;
+    }
+  }
+
+  void prepend(const byte data[], int const length)
+  {
+    _pos -= length;
+    if (_pos >= 0) {
+      memcpy(_buffer + _pos, data, length);
+    }
+  }
+
+  void prependHeader(byte const tag, int const length)
+  {
+    prepend(length & 0xff);
+    if (length > 255) {
+      prepend((length >> 8) & 0xff);
+      prepend(0x82);
+    } else if (length > 127) {
+      prepend(0x81);
+    }
+    prepend(tag);
+  }
+
+private:
+
+  byte * _buffer;
+  int    _pos;
+};
+
 /******************************************************************************
  * LOCAL MODULE FUNCTIONS
  ******************************************************************************/
 
-static String base64Encode(const byte in[], unsigned int length, const char* prefix, const char* suffix) {
+typedef void (*PEMWriteFuncPtr)(const char chunk[], void * arg);
+
+/* Emits the PEM encoding line by line, so neither the caller nor the encoder
+ * has to hold all of it.
+ */
+static void pemEncode(const byte in[], unsigned int length, const char* prefix, const char* suffix, PEMWriteFuncPtr write, void * arg) {
   static const char* CODES = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
 
+  char line[PEM_LINE_LENGTH + 2];
+  int n = 0;
   int b;
-  String out;
 
-  int reserveLength = 4 * ((length + 2) / 3) + ((length / 3 * 4) / 76) + strlen(prefix) + strlen(suffix);
-  out.reserve(reserveLength);
-
-  if (prefix) {
-    out += prefix;
-  }
+  write(prefix, arg);
 
   for (unsigned int i = 0; i < length; i += 3) {
-    if (i > 0 && (i / 3 * 4) % 76 == 0) {
-      out += '\n';
+    if (i > 0 && (i / 3 * 4) % PEM_LINE_LENGTH == 0) {
+      line[n++] = '\n';
+      line[n] = '\0';
+      write(line, arg);
+      n = 0;
     }
 
     b = (in[i] & 0xFC) >> 2;
-    out += CODES[b];
+    line[n++] = CODES[b];
 
     b = (in[i] & 0x03) << 4;
     if (i + 1 < length) {
       b |= (in[i + 1] & 0xF0) >> 4;
-      out += CODES[b];
+      line[n++] = CODES[b];
       b = (in[i + 1] & 0x0F) << 2;
       if (i + 2 < length) {
         b |= (in[i + 2] & 0xC0) >> 6;
-        out += CODES[b];
+        line[n++] = CODES[b];
         b = in[i + 2] & 0x3F;
-        out += CODES[b];
+        line[n++] = CODES[b];
       } else {
-        out += CODES[b];
-        out += '=';
+        line[n++] = CODES[b];
+        line[n++] = '=';
       }
     } else {
-      out += CODES[b];
-      out += "==";
+      line[n++] = CODES[b];
+      line[n++] = '=';
+      line[n++] = '=';
     }
   }
 
-  if (suffix) {
-    out += suffix;
-  }
+  line[n] = '\0';
+  write(line, arg);
+  write(suffix, arg);
+}
 
+static String pemEncode(const byte in[], unsigned int length, const char* prefix, const char* suffix) {
+  String out;
+  out.reserve(4 * ((length + 2) / 3) + ((length / 3 * 4) / PEM_LINE_LENGTH) + strlen(prefix) + strlen(suffix));
+  pemEncode(in, length, prefix, suffix, [](const char chunk[], void * arg) { *static_cast<String *>(arg) += chunk; }, &out);
   return out;
 }
 
+struct PEMPrintSink {
+  Print * out;
+  size_t  written;
+};
+
+static size_t pemEncode(const byte in[], unsigned int length, const char* prefix, const char* suffix, Print & out) {
+  PEMPrintSink sink = { &out, 0 };
+  pemEncode(in, length, prefix, suffix, [](const char chunk[], void * arg) {
+    PEMPrintSink * s = static_cast<PEMPrintSink *>(arg);
+    s->written += s->out->print(chunk);
+  }, &sink);
+  return sink.written;
+}
+
+static bool isSet(const byte data[], int length) {
+  for (int i = 0; i < length; i++) {
+    if (data[i] != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void prependInteger(DERWriter & der, const byte value[], int length) {
+  int const end = der.mark();
+
+  while (length && *value == 0) {
+    value++;
+    length--;
+  }
+
+  der.prepend(value, length);
+  if (length && (*value & 0x80)) {
+    der.prepend(0x00);
+  }
+  der.prependHeader(ASN1_INTEGER, der.lengthSince(end));
+}
+
+static void prependName(DERWriter & der, const String& name, byte type) {
+  if (name.length() == 0) {
+    return;
+  }
+
+  int const end = der.mark();
+  const byte oid[] = {ASN1_OBJECT_IDENTIFIER, 0x03, 0x55, 0x04, type};
+
+  der.prepend(reinterpret_cast<const byte *>(name.c_str()), name.length());
+  der.prependHeader(ASN1_PRINTABLE_STRING, name.length());
+  der.prepend(oid, sizeof(oid));
+  der.prependHeader(ASN1_SEQUENCE, der.lengthSince(end));
+  der.prependHeader(ASN1_SET, der.lengthSince(end));
+}
+
+static void prependPublicKey(DERWriter & der, const byte publicKey[]) {
+  der.prepend(publicKey, CERT_PUBLIC_KEY_LENGTH);
+  der.prepend(PUBLIC_KEY_HEADER, sizeof(PUBLIC_KEY_HEADER));
+}
+
 /******************************************************************************
  * CTOR/DTOR
  ******************************************************************************/
 
 ArduinoIoTCloudCertClass::ArduinoIoTCloudCertClass()
 : _certBuffer(nullptr)
+, _certBufferSize(0)
+, _certOffset(0)
 , _certBufferLen(0)
 , _publicKey(nullptr)
 {
@@ -106,7 +269,7 @@ ArduinoIoTCloudCertClass::ArduinoIoTCloudCertClass()
 ArduinoIoTCloudCertClass::~ArduinoIoTCloudCertClass() 
 {
   if (_certBuffer) {
-    free(_certBuffer);
+    memoryFree(MemoryPool::Certificate, _certBuffer);
     _certBuffer = nullptr;
   }
 }
@@ -123,195 +286,118 @@ int ArduinoIoTCloudCertClass::begin()
 
 int ArduinoIoTCloudCertClass::buildCSR()
 {
-  int csrInfoLen = CSRInfoLength();
-  int subjectLen = issuerOrSubjectLength(_subjectData);
-
-  _certBufferLen = getCSRSize();
-  _certBuffer = (byte*)malloc(_certBufferLen);
-
-  if (_certBuffer == nullptr) {
+  if (_publicKey == nullptr) {
     return 0;
   }
 
-  byte* out = _certBuffer;
-
-  // header
-  out += appendSequenceHeader(csrInfoLen, out);
-
-  // version
-  out += appendVersion(0x00, out);
-
-  // subject
-  out += appendSequenceHeader(subjectLen, out);
-  out += appendIssuerOrSubject(_subjectData, out);
-
-  // public key
-  if (_publicKey == nullptr) {
+  if (!allocBuffer(CSR_INFO_MAX_LENGTH + nameMaxLength(_subjectData))) {
     return 0;
   }
-  out += appendPublicKey(_publicKey, out);
-  
-  // terminator
-  *out++ = 0xa0;
-  *out++ = 0x00;
 
-  return 1;
-}
+  DERWriter der(_certBuffer, _certBufferSize - CERT_SIGNATURE_MAX_LENGTH);
+  int const end = der.mark();
 
-int ArduinoIoTCloudCertClass::signCSR(byte * signature)
-{
-  /* copy old certbuffer in a temp buffer */
-  byte* tempBuffer = (byte*)malloc(_certBufferLen);
+  // attributes
+  der.prepend(CSR_ATTRIBUTES_EMPTY, sizeof(CSR_ATTRIBUTES_EMPTY));
 
-  if (tempBuffer == nullptr) {
-    return 0;
-  }
-
-  memcpy(tempBuffer, _certBuffer, _certBufferLen);
-  
-  _certBufferLen = getCSRSignedSize(signature);
-  _certBuffer = (byte*)realloc(_certBuffer, _certBufferLen);
+  // public key
+  prependPublicKey(der, _publicKey);
 
-  if (_certBuffer == nullptr) {
-    return 0;
-  }
+  // subject
+  prependIssuerOrSubject(der, _subjectData);
 
-  byte* out = _certBuffer;
+  // version
+  der.prepend(CSR_VERSION_V1, sizeof(CSR_VERSION_V1));
 
   // header
-  out += appendSequenceHeader(getCSRSize() + signatureLength(signature), out);
-
-  // info
-  memcpy(out, tempBuffer, getCSRSize());
-  free(tempBuffer);
-  out += getCSRSize();
+  der.prependHeader(ASN1_SEQUENCE, der.lengthSince(end));
 
-  // signature
-  out += appendSignature(signature, out);
+  return commitInfo(der, end);
+}
 
-  return 1;
+int ArduinoIoTCloudCertClass::signCSR(byte * signature)
+{
+  return appendSignature(signature);
 }
 
 String ArduinoIoTCloudCertClass::getCSRPEM()
 {
-  return base64Encode(_certBuffer, _certBufferLen, "-----BEGIN CERTIFICATE REQUEST-----\n", "\n-----END CERTIFICATE REQUEST-----\n");
+  return pemEncode(bytes(), _certBufferLen, "-----BEGIN CERTIFICATE REQUEST-----\n", "\n-----END CERTIFICATE REQUEST-----\n");
 }
 
-int ArduinoIoTCloudCertClass::buildCert()
+size_t ArduinoIoTCloudCertClass::printCSRPEM(Print & out)
 {
-  _certBufferLen = getCertSize();
-  _certBuffer = (byte*)malloc(_certBufferLen);
+  return pemEncode(bytes(), _certBufferLen, "-----BEGIN CERTIFICATE REQUEST-----\n", "\n-----END CERTIFICATE REQUEST-----\n", out);
+}
 
-  if (_certBuffer == nullptr) {
+int ArduinoIoTCloudCertClass::buildCert()
+{
+  if (_publicKey == nullptr) {
     return 0;
   }
-  
-  uint8_t* out = _certBuffer;
-
-  int certInfoLen = certInfoLength();
 
-  // header
-  out += appendSequenceHeader(certInfoLen, out);
+  if (!allocBuffer(CERT_INFO_MAX_LENGTH + nameMaxLength(_issuerData) + nameMaxLength(_subjectData))) {
+    return 0;
+  }
 
-  // version
-  *out++ = 0xA0;
-  *out++ = 0x03;
-  *out++ = 0x02;
-  *out++ = 0x01;
-  *out++ = 0x02;
+  DERWriter der(_certBuffer, _certBufferSize - CERT_SIGNATURE_MAX_LENGTH);
+  int const end = der.mark();
 
-  // serial number
-  out += appendSerialNumber(_compressedCert.slot.two.values.serialNumber, CERT_SERIAL_NUMBER_LENGTH, out);
+  // extensions
+  if (isSet(_compressedCert.slot.two.values.authorityKeyId, CERT_AUTHORITY_KEY_ID_LENGTH)) {
+    der.prepend(_compressedCert.slot.two.values.authorityKeyId, CERT_AUTHORITY_KEY_ID_LENGTH);
+    der.prepend(AUTHORITY_KEY_ID_HEADER, sizeof(AUTHORITY_KEY_ID_HEADER));
+  } else {
+    der.prepend(CERT_EXTENSIONS_EMPTY, sizeof(CERT_EXTENSIONS_EMPTY));
+  }
 
-  // signature type
-  out += appendEcdsaWithSHA256(out);
+  // public key
+  prependPublicKey(der, _publicKey);
 
-  // issuer
-  int issuerDataLen = issuerOrSubjectLength(_issuerData);
-  out += appendSequenceHeader(issuerDataLen, out);
-  out += appendIssuerOrSubject(_issuerData, out);
+  // subject
+  prependIssuerOrSubject(der, _subjectData);
 
   // dates
   DateInfo dateData;
   getDateFromCompressedData(dateData);
 
-  *out++ = ASN1_SEQUENCE;
-  *out++ = 30 + ((dateData.issueYear > 2049) ? 2 : 0) + (((dateData.issueYear + dateData.expireYears) > 2049) ? 2 : 0);
-  out += appendDate(dateData.issueYear, dateData.issueMonth, dateData.issueDay, dateData.issueHour, 0, 0, out);
-  out += appendDate(dateData.issueYear + dateData.expireYears, dateData.issueMonth, dateData.issueDay, dateData.issueHour, 0, 0, out);
+  int const datesEnd = der.mark();
+  byte date[17];
+  der.prepend(date, appendDate(dateData.issueYear + dateData.expireYears, dateData.issueMonth, dateData.issueDay, dateData.issueHour, 0, 0, date));
+  der.prepend(date, appendDate(dateData.issueYear, dateData.issueMonth, dateData.issueDay, dateData.issueHour, 0, 0, date));
+  der.prependHeader(ASN1_SEQUENCE, der.lengthSince(datesEnd));
 
-  // subject
-  int subjectDataLen = issuerOrSubjectLength(_subjectData);
-  out += appendSequenceHeader(subjectDataLen, out);
-  out += appendIssuerOrSubject(_subjectData, out);
-
-  // public key
-  if (_publicKey == nullptr) {
-    return 0;
-  }
-  out += appendPublicKey(_publicKey, out);
-
-  int authorityKeyIdLen = authorityKeyIdLength(_compressedCert.slot.two.values.authorityKeyId, CERT_AUTHORITY_KEY_ID_LENGTH);
-  if (authorityKeyIdLen)
-  {
-    out += appendAuthorityKeyId(_compressedCert.slot.two.values.authorityKeyId, CERT_AUTHORITY_KEY_ID_LENGTH, out);
-  }
-  else
-  {
-    // null sequence
-    *out++ = 0xA3;
-    *out++ = 0x02;
-    *out++ = 0x30;
-    *out++ = 0x00;
-  }
-
-  return 1;
-}
-
-int ArduinoIoTCloudCertClass::signCert(const byte * signature)
-{
-  /* copy old certbuffer in a temp buffer */
-  byte* tempBuffer = (byte*)malloc(_certBufferLen);
+  // issuer
+  prependIssuerOrSubject(der, _issuerData);
 
-  if (tempBuffer == nullptr) {
-    return 0;
-  }
+  // signature type
+  der.prepend(ECDSA_WITH_SHA256, sizeof(ECDSA_WITH_SHA256));
 
-  memcpy(tempBuffer, _certBuffer, _certBufferLen);
-  
-  _certBufferLen = getCertSignedSize(signature);
-  _certBuffer = (byte*)realloc(_certBuffer, _certBufferLen);
+  // serial number
+  prependInteger(der, _compressedCert.slot.two.values.serialNumber, CERT_SERIAL_NUMBER_LENGTH);
 
-  if (_certBuffer == nullptr) {
-    return 0;
-  }
-  
-  byte* out = _certBuffer;
+  // version
+  der.prepend(CERT_VERSION_V3, sizeof(CERT_VERSION_V3));
 
   // header
-  out +=appendSequenceHeader(getCertSize() + signatureLength(signature), out);
-
-  // info
-  memcpy(out, tempBuffer, getCertSize());
-  free(tempBuffer);
-  out += getCertSize();
+  der.prependHeader(ASN1_SEQUENCE, der.lengthSince(end));
 
-  // signature
-  out += appendSignature(signature, out);
+  return commitInfo(der, end);
+}
 
-  return 1;
+int ArduinoIoTCloudCertClass::signCert(const byte * signature)
+{
+  return appendSignature(signature);
 }
 
 int ArduinoIoTCloudCertClass::importCert(const byte certDER[], size_t derLen)
 {
-  _certBufferLen = derLen;
-  _certBuffer = (byte*)malloc(_certBufferLen);
-
-  if (_certBuffer == nullptr) {
+  if (!allocBuffer(derLen)) {
     return 0;
   }
 
-  memcpy(_certBuffer, certDER, _certBufferLen);
+  memcpy(_certBuffer, certDER, derLen);
+  _certBufferLen = derLen;
 
   return 1;
 }
@@ -323,7 +409,12 @@ int ArduinoIoTCloudCertClass::signCert()
 
 String ArduinoIoTCloudCertClass::getCertPEM()
 {
-  return base64Encode(_certBuffer, _certBufferLen, "-----BEGIN CERTIFICATE-----\n", "\n-----END CERTIFICATE-----\n");
+  return pemEncode(bytes(), _certBufferLen, "-----BEGIN CERTIFICATE-----\n", "\n-----END CERTIFICATE-----\n");
+}
+
+size_t ArduinoIoTCloudCertClass::printCertPEM(Print & out)
+{
+  return pemEncode(bytes(), _certBufferLen, "-----BEGIN CERTIFICATE-----\n", "\n-----END CERTIFICATE-----\n", out);
 }
 
 void ArduinoIoTCloudCertClass::getDateFromCompressedData(DateInfo& date) {
@@ -401,430 +492,106 @@ int ArduinoIoTCloudCertClass::setSignature(const byte* signature, int signatureL
  * PRIVATE MEMBER FUNCTIONS
  ******************************************************************************/
 
-int ArduinoIoTCloudCertClass::versionLength()
-{
-  return 3;
-}
-
-int ArduinoIoTCloudCertClass::issuerOrSubjectLength(const CertInfo& issuerOrSubjectData)
-{
-  int length                       = 0;
-  int countryNameLength            = issuerOrSubjectData.countryName.length();
-  int stateProvinceNameLength      = issuerOrSubjectData.stateProvinceName.length();
-  int localityNameLength           = issuerOrSubjectData.localityName.length();
-  int organizationNameLength       = issuerOrSubjectData.organizationName.length();
-  int organizationalUnitNameLength = issuerOrSubjectData.organizationalUnitName.length();
-  int commonNameLength             = issuerOrSubjectData.commonName.length();
-
-  if (countryNameLength) {
-    length += (11 + countryNameLength);
-  }
-
-  if (stateProvinceNameLength) {
-    length += (11 + stateProvinceNameLength);
-  }
-
-  if (localityNameLength) {
-    length += (11 + localityNameLength);
-  }
-
-  if (organizationNameLength) {
-    length += (11 + organizationNameLength);
-  }
-
-  if (organizationalUnitNameLength) {
-    length += (11 + organizationalUnitNameLength);
-  }
-
-  if (commonNameLength) {
-    length += (11 + commonNameLength);
-  }
-
-  return length;
-}
-
-int ArduinoIoTCloudCertClass::sequenceHeaderLength(int length)
-{
-  if (length > 255) {
-    return 4;
-  } else if (length > 127) {
-    return 3;
-  } else {
-    return 2;
-  }
-}
-
-int ArduinoIoTCloudCertClass::publicKeyLength()
-{
-  return (2 + 2 + 9 + 10 + 4 + 64);
-}
-
-int ArduinoIoTCloudCertClass::signatureLength(const byte signature[])
-{
-  const byte* r = &signature[0];
-  const byte* s = &signature[32];
-
-  int rLength = 32;
-  int sLength = 32;
-
-  while (*r == 0x00 && rLength) {
-    r++;
-    rLength--;
-  }
-
-  if (*r & 0x80) {
-    rLength++;
-  }
-
-  while (*s == 0x00 && sLength) {
-    s++;
-    sLength--;
-  }
-
-  if (*s & 0x80) {
-    sLength++;
-  }
-
-  return (21 + rLength + sLength);
-}
-
-int ArduinoIoTCloudCertClass::serialNumberLength(const byte serialNumber[], int length)
-{
-  while (*serialNumber == 0 && length) {
-    serialNumber++;
-    length--;
-  }
-
-  if (*serialNumber & 0x80) {
-    length++;
-  }
-
-  return (2 + length);
-}
-
-int ArduinoIoTCloudCertClass::authorityKeyIdLength(const byte authorityKeyId[], int length) {
-  bool set = false;
-
-  // check if the authority key identifier is non-zero
-  for (int i = 0; i < length; i++) {
-    if (authorityKeyId[i] != 0) {
-      set = true;
-      break;
+int ArduinoIoTCloudCertClass::nameMaxLength(const CertInfo& issuerOrSubjectData)
+{
+  const String* names[] = {
+    &issuerOrSubjectData.countryName,
+    &issuerOrSubjectData.stateProvinceName,
+    &issuerOrSubjectData.localityName,
+    &issuerOrSubjectData.organizationName,
+    &issuerOrSubjectData.organizationalUnitName,
+    &issuerOrSubjectData.commonName
+  };
+
+  int length = 0;
+  for (const String* name : names) {
+    if (name->length()) {
+      length += (CERT_NAME_MAX_OVERHEAD + name->length());
     }
   }
-
-  return (set ? (length + 17) : 0);
-}
-
-int ArduinoIoTCloudCertClass::CSRInfoLength()
-{
-  int versionLen = versionLength();
-  int subjectLen = issuerOrSubjectLength(_subjectData);
-  int subjectHeaderLen = sequenceHeaderLength(subjectLen);
-  int publicKeyLen = publicKeyLength();
-
-  int csrInfoLen = versionLen + subjectHeaderLen + subjectLen + publicKeyLen + 2;
-
-  return csrInfoLen;
-}
-
-int ArduinoIoTCloudCertClass::getCSRSize()
-{
-  int csrInfoLen = CSRInfoLength();
-  int csrInfoHeaderLen = sequenceHeaderLength(csrInfoLen);
-
-  return (csrInfoLen + csrInfoHeaderLen);
-}
-
-int ArduinoIoTCloudCertClass::getCSRSignedSize(byte * signature)
-{
-  int signatureLen = signatureLength(signature);
-  int csrLen = getCSRSize() + signatureLen;
-  return sequenceHeaderLength(csrLen) + csrLen;
+  return length;
 }
 
-int ArduinoIoTCloudCertClass::certInfoLength()
+int ArduinoIoTCloudCertClass::allocBuffer(int infoMaxLength)
 {
-  int datesSizeLen = 30;
-  DateInfo dates;
-
-  getDateFromCompressedData(dates);
-
-  if (dates.issueYear > 2049) {
-    // two more bytes for GeneralizedTime
-    datesSizeLen += 2;
-  }
-
-  if ((dates.issueYear + dates.expireYears) > 2049) {
-    // two more bytes for GeneralizedTime
-    datesSizeLen += 2;
+  if (_certBuffer) {
+    memoryFree(MemoryPool::Certificate, _certBuffer);
   }
 
-  int serialNumberLen = serialNumberLength(_compressedCert.slot.two.values.serialNumber, CERT_SERIAL_NUMBER_LENGTH);
-
-  int issuerLen = issuerOrSubjectLength(_issuerData);
+  /* Leaves room for the header and signature added by the signing */
+  _certBufferSize = CERT_HEADER_MAX_LENGTH + infoMaxLength + CERT_SIGNATURE_MAX_LENGTH;
+  _certBuffer = (byte*)memoryAlloc(MemoryPool::Certificate, _certBufferSize);
+  _certOffset = 0;
+  _certBufferLen = 0;
 
-  int issuerHeaderLen = sequenceHeaderLength(issuerLen);
-
-  int subjectLen = issuerOrSubjectLength(_subjectData);
-
-  int subjectHeaderLen = sequenceHeaderLength(subjectLen);
-
-  int publicKeyLen = publicKeyLength();
-  
-  int certInfoLen = 5 + serialNumberLen + 12 + issuerHeaderLen + issuerLen + (datesSizeLen + 2) +
-                    subjectHeaderLen + subjectLen + publicKeyLen;
-
-  int authorityKeyIdLen = authorityKeyIdLength(_compressedCert.slot.two.values.authorityKeyId, CERT_AUTHORITY_KEY_ID_LENGTH);
-
-  if (authorityKeyIdLen)
-  {
-    certInfoLen += authorityKeyIdLen;
-  }
-  else
-  {
-    certInfoLen += 4;
+  if (_certBuffer == nullptr) {
+    _certBufferSize = 0;
+    return 0;
   }
-
-  return certInfoLen;
-}
-
-int ArduinoIoTCloudCertClass::getCertSize()
-{
-  int certInfoLen = certInfoLength();
-  int certInfoHeaderLen = sequenceHeaderLength(certInfoLen);
-
-  return (certInfoLen + certInfoHeaderLen);
-}
-
-int ArduinoIoTCloudCertClass::getCertSignedSize(const byte * signature)
-{
-  int signatureLen = signatureLength(signature);
-  int certLen = getCertSize() + signatureLen;
-  return sequenceHeaderLength(certLen) + certLen;
+  return 1;
 }
 
-int ArduinoIoTCloudCertClass::appendSequenceHeader(int length, byte out[])
+int ArduinoIoTCloudCertClass::commitInfo(const DERWriter& der, int end)
 {
-  *out++ = ASN1_SEQUENCE;
-  if (length > 255) {
-    *out++ = 0x82;
-    *out++ = (length >> 8) & 0xff;
-  } else if (length > 127) {
-    *out++ = 0x81;
-  }
-  *out++ = (length) & 0xff;
-
-  if (length > 255) {
-    return 4;
-  } else if (length > 127) {
-    return 3;
-  } else {
-    return 2;
+  /* Can only happen if the upper bounds above are wrong */
+  if (der.overflow() || der.mark() < CERT_HEADER_MAX_LENGTH) {
+    return 0;
   }
-}
-
-int ArduinoIoTCloudCertClass::appendVersion(int version, byte out[])
-{
-  out[0] = ASN1_INTEGER;
-  out[1] = 0x01;
-  out[2] = version;
-
-  return versionLength();
-}
-
-int ArduinoIoTCloudCertClass::appendName(const String& name, int type, byte out[])
-{
-  int nameLength = name.length();
-
-  *out++ = ASN1_SET;
-  *out++ = nameLength + 9;
-
-  *out++ = ASN1_SEQUENCE;
-  *out++ = nameLength + 7;
 
-  *out++ = ASN1_OBJECT_IDENTIFIER;
-  *out++ = 0x03;
-  *out++ = 0x55;
-  *out++ = 0x04;
-  *out++ = type;
-
-  *out++ = ASN1_PRINTABLE_STRING;
-  *out++ = nameLength;
-  memcpy(out, name.c_str(), nameLength);
-
-  return (nameLength + 11);
+  _certOffset = der.mark();
+  _certBufferLen = der.lengthSince(end);
+  return 1;
 }
 
-int ArduinoIoTCloudCertClass::appendIssuerOrSubject(const CertInfo& issuerOrSubjectData, byte out[])
+void ArduinoIoTCloudCertClass::prependIssuerOrSubject(DERWriter& der, const CertInfo& issuerOrSubjectData)
 {
-  if (issuerOrSubjectData.countryName.length() > 0) {
-    out += appendName(issuerOrSubjectData.countryName, 0x06, out);
-  }
+  int const end = der.mark();
 
-  if (issuerOrSubjectData.stateProvinceName.length() > 0) {
-    out += appendName(issuerOrSubjectData.stateProvinceName, 0x08, out);
-  }
-
-  if (issuerOrSubjectData.localityName.length() > 0) {
-    out += appendName(issuerOrSubjectData.localityName, 0x07, out);
-  }
-
-  if (issuerOrSubjectData.organizationName.length() > 0) {
-    out += appendName(issuerOrSubjectData.organizationName, 0x0a, out);
-  }
-
-  if (issuerOrSubjectData.organizationalUnitName.length() > 0) {
-    out += appendName(issuerOrSubjectData.organizationalUnitName, 0x0b, out);
-  }
-
-  if (issuerOrSubjectData.commonName.length() > 0) {
-    out += appendName(issuerOrSubjectData.commonName, 0x03, out);
-  }
+  prependName(der, issuerOrSubjectData.commonName, 0x03);
+  prependName(der, issuerOrSubjectData.organizationalUnitName, 0x0b);
+  prependName(der, issuerOrSubjectData.organizationName, 0x0a);
+  prependName(der, issuerOrSubjectData.localityName, 0x07);
+  prependName(der, issuerOrSubjectData.stateProvinceName, 0x08);
+  prependName(der, issuerOrSubjectData.countryName, 0x06);
 
-  return issuerOrSubjectLength(issuerOrSubjectData);
+  der.prependHeader(ASN1_SEQUENCE, der.lengthSince(end));
 }
 
-int  ArduinoIoTCloudCertClass::appendPublicKey(const byte publicKey[], byte out[])
+int ArduinoIoTCloudCertClass::appendSignature(const byte signature[])
 {
-  int subjectPublicKeyDataLength = 2 + 9 + 10 + 4 + 64;
-
-  // subject public key
-  *out++ = ASN1_SEQUENCE;
-  *out++ = (subjectPublicKeyDataLength) & 0xff;
-
-  *out++ = ASN1_SEQUENCE;
-  *out++ = 0x13;
-
-  // EC public key
-  *out++ = ASN1_OBJECT_IDENTIFIER;
-  *out++ = 0x07;
-  *out++ = 0x2a;
-  *out++ = 0x86;
-  *out++ = 0x48;
-  *out++ = 0xce;
-  *out++ = 0x3d;
-  *out++ = 0x02;
-  *out++ = 0x01;
-
-  // PRIME 256 v1
-  *out++ = ASN1_OBJECT_IDENTIFIER;
-  *out++ = 0x08;
-  *out++ = 0x2a;
-  *out++ = 0x86;
-  *out++ = 0x48;
-  *out++ = 0xce;
-  *out++ = 0x3d;
-  *out++ = 0x03;
-  *out++ = 0x01;
-  *out++ = 0x07;
-
-  *out++ = 0x03;
-  *out++ = 0x42;
-  *out++ = 0x00;
-  *out++ = 0x04;
-
-  memcpy(out, publicKey, 64);
-
-  return publicKeyLength();
-}
-
-int ArduinoIoTCloudCertClass::appendSignature(const byte signature[], byte out[])
-{
-  // signature algorithm
-  *out++ = ASN1_SEQUENCE;
-  *out++ = 0x0a;
-  *out++ = ASN1_OBJECT_IDENTIFIER;
-  *out++ = 0x08;
-
-  // ECDSA with SHA256
-  *out++ = 0x2a;
-  *out++ = 0x86;
-  *out++ = 0x48;
-  *out++ = 0xce;
-  *out++ = 0x3d;
-  *out++ = 0x04;
-  *out++ = 0x03;
-  *out++ = 0x02;
-
-  const byte* r = &signature[0];
-  const byte* s = &signature[32];
-
-  int rLength = 32;
-  int sLength = 32;
-
-  while (*r == 0 && rLength) {
-    r++;
-    rLength--;
-  }
-
-  while (*s == 0 && sLength) {
-    s++;
-    sLength--;
-  }
-
-  if (*r & 0x80) {
-    rLength++;
-  }
-
-  if (*s & 0x80) {
-    sLength++;
-  }
-
-  *out++ = ASN1_BIT_STRING;
-  *out++ = (rLength + sLength + 7);
-  *out++ = 0;
-
-  *out++ = ASN1_SEQUENCE;
-  *out++ = (rLength + sLength + 4);
-
-  *out++ = ASN1_INTEGER;
-  *out++ = rLength;
-  if ((*r & 0x80) && rLength) {
-    *out++ = 0;
-    rLength--;
-  }
-  memcpy(out, r, rLength);
-  out += rLength;
-
-  *out++ = ASN1_INTEGER;
-  *out++ = sLength;
-  if ((*s & 0x80) && sLength) {
-    *out++ = 0;
-    sLength--;
+  if (_certBuffer == nullptr) {
+    return 0;
   }
-  memcpy(out, s, sLength);
-  out += rLength;
 
-  return signatureLength(signature);
-}
+  byte buffer[CERT_SIGNATURE_MAX_LENGTH];
+  DERWriter sig(buffer, sizeof(buffer));
+  int const sigEnd = sig.mark();
 
-int ArduinoIoTCloudCertClass::appendSerialNumber(const byte serialNumber[], int length, byte out[])
-{
-  while (*serialNumber == 0 && length) {
-    serialNumber++;
-    length--;
-  }
+  prependInteger(sig, &signature[32], 32);
+  prependInteger(sig, &signature[0], 32);
+  sig.prependHeader(ASN1_SEQUENCE, sig.lengthSince(sigEnd));
+  sig.prepend(0x00);
+  sig.prependHeader(ASN1_BIT_STRING, sig.lengthSince(sigEnd));
+  sig.prepend(ECDSA_WITH_SHA256, sizeof(ECDSA_WITH_SHA256));
 
-  if (*serialNumber & 0x80) {
-    length++;  
+  int const sigLen = sig.lengthSince(sigEnd);
+  if ((_certOffset + _certBufferLen + sigLen) > _certBufferSize) {
+    return 0;
   }
 
-  *out++ = ASN1_INTEGER;
-  *out++ = length;
+  /* The signature goes right behind the info, the header in front of it */
+  memcpy(bytes() + _certBufferLen, sig.data(), sigLen);
+  int const end = _certOffset + _certBufferLen + sigLen;
 
-  if (*serialNumber & 0x80) {
-    *out++ = 0x00;
-    length--;
-  }
-
-  memcpy(out, serialNumber, length);
-  
-  if (*serialNumber & 0x80) {
-    length++;
+  DERWriter der(_certBuffer, _certOffset);
+  der.prependHeader(ASN1_SEQUENCE, _certBufferLen + sigLen);
+  if (der.overflow()) {
+    return 0;
   }
 
-  return (2 + length);
+  _certOffset = der.mark();
+  _certBufferLen = end - _certOffset;
+  return 1;
 }
 
 int ArduinoIoTCloudCertClass::appendDate(int year, int month, int day, int hour, int minute, int second, byte out[])
@@ -861,58 +628,4 @@ int ArduinoIoTCloudCertClass::appendDate(int year, int month, int day, int hour,
   return (useGeneralizedTime ? 17 : 15);
 }
 
-int ArduinoIoTCloudCertClass::appendEcdsaWithSHA256(byte out[])
-{
-  *out++ = ASN1_SEQUENCE;
-  *out++ = 0x0A;
-  *out++ = ASN1_OBJECT_IDENTIFIER;
-  *out++ = 0x08;
-  *out++ = 0x2A;
-  *out++ = 0x86;
-  *out++ = 0x48;
-  *out++ = 0xCE;
-  *out++ = 0x3D;
-  *out++ = 0x04;
-  *out++ = 0x03;
-  *out++ = 0x02;
-
-  return 12;
-}
-
-int ArduinoIoTCloudCertClass::appendAuthorityKeyId(const byte authorityKeyId[], int length, byte out[]) {
-  // [3]
-  *out++ = 0xa3;
-  *out++ = 0x23;
-
-  // sequence
-  *out++ = ASN1_SEQUENCE;
-  *out++ = 0x21;
-
-  // sequence
-  *out++ = ASN1_SEQUENCE;
-  *out++ = 0x1f;
-
-  // 2.5.29.35 authorityKeyIdentifier(X.509 extension)
-  *out++ = 0x06;
-  *out++ = 0x03;
-  *out++ = 0x55;
-  *out++ = 0x1d;
-  *out++ = 0x23;
-
-  // octet string
-  *out++ = 0x04;
-  *out++ = 0x18;
-
-  // sequence
-  *out++ = ASN1_SEQUENCE;
-  *out++ = 0x16;
-
-  *out++ = 0x80;
-  *out++ = 0x14;
-
-  memcpy(out, authorityKeyId, length);
-
-  return length + 17;
-}
-
 #endif /* (BOARD_HAS_ECCX08) || defined(BOARD_HAS_OFFLOADED_ECCX08) || defined(BOARD_HAS_SE050) */
@@ -40,6 +40,8 @@
 
 #include <Arduino.h>
 
+class DERWriter;
+
 class ArduinoIoTCloudCertClass {
 public:
            ArduinoIoTCloudCertClass();
@@ -76,7 +78,7 @@ public:
   int setSignature(const byte* signature, int signatureLen);
 
   /* Get Buffer */
-  inline byte* bytes() { return _certBuffer; }
+  inline byte* bytes() { return _certBuffer + _certOffset; }
   inline int length() { return _certBufferLen; }
 
 #if defined(BOARD_HAS_ECCX08) || defined(BOARD_HAS_OFFLOADED_ECCX08)
@@ -93,12 +95,14 @@ public:
   int buildCSR();
   int signCSR(byte signature[]);
   String getCSRPEM();
+  size_t printCSRPEM(Print & out);
 
   /* Build Certificate */
   int buildCert();
   int signCert(const byte signature[]);
   int signCert();
   String getCertPEM();
+  size_t printCertPEM(Print & out);
 
   /* Import DER buffer into CertClass*/
   int importCert(const byte certDER[], size_t derLen);
@@ -147,38 +151,26 @@ private:
     byte data[CERT_COMPRESSED_CERT_SLOT_LENGTH + CERT_SERIAL_NUMBER_LENGTH + CERT_AUTHORITY_KEY_ID_LENGTH];
   } _compressedCert;
 
+  /* The DER encoding is written back to front and starts at _certOffset,
+   * the space in front of it and behind it is kept for the signing.
+   */
   byte * _certBuffer;
+  int    _certBufferSize;
+  int    _certOffset;
   int    _certBufferLen;
 
   /* only raw EC X Y values 64 byte */
   const byte * _publicKey;
 
-  int versionLength();
-  int issuerOrSubjectLength(const CertInfo& issuerOrSubjectData);
-  int sequenceHeaderLength(int length);
-  int publicKeyLength();
-  int signatureLength(const byte signature[]);
-  int serialNumberLength(const byte serialNumber[], int length);
-  int authorityKeyIdLength(const byte authorityKeyId[], int length);
-  int CSRInfoLength();
-  int getCSRSize();
-  int getCSRSignedSize(byte signature[]);
-  int certInfoLength();
-  int getCertSize();
-  int getCertSignedSize(const byte signature[]);
+  static int nameMaxLength(const CertInfo& issuerOrSubjectData);
+  int allocBuffer(int infoMaxLength);
+  int commitInfo(const DERWriter& der, int end);
 
   void getDateFromCompressedData(DateInfo& date);
 
-  int appendSequenceHeader(int length, byte out[]);
-  int appendVersion(int version, byte out[]);
-  int appendName(const String& name, int type, byte out[]);
-  int appendIssuerOrSubject(const CertInfo& issuerOrSubjectData, byte out[]);
-  int appendPublicKey(const byte publicKey[], byte out[]);
-  int appendSignature(const byte signature[], byte out[]);
-  int appendSerialNumber(const byte serialNumber[], int length, byte out[]);
+  void prependIssuerOrSubject(DERWriter& der, const CertInfo& issuerOrSubjectData);
+  int appendSignature(const byte signature[]);
   int appendDate(int year, int month, int day, int hour, int minute, int second, byte out[]);
-  int appendEcdsaWithSHA256(byte out[]);
-  int appendAuthorityKeyId(const byte authorityKeyId[], int length, byte out[]);
 
 };
 
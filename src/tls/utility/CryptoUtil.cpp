@@ -31,6 +31,28 @@
  ******************************************************************************/
 #define CRYPTO_SHA256_BUFFER_LENGTH  32
 #define CRYPTO_CERT_BUFFER_LENGTH  1024
+#define CRYPTO_CERT_CACHE_MAGIC    0x43455254
+
+#ifdef AIOT_CONFIG_CERT_CACHE_SECTION
+#define CRYPTO_CERT_CACHE_ATTRIBUTE __attribute__((section(AIOT_CONFIG_CERT_CACHE_SECTION)))
+#else
+#define CRYPTO_CERT_CACHE_ATTRIBUTE
+#endif
+
+/******************************************************************************
+ * INTERNAL VARIABLES
+ ******************************************************************************/
+
+#if AIOT_CONFIG_CERT_CACHE_ENABLED && !defined(BOARD_HAS_SE050)
+/* DER of the last certificate built, keyed with the hash of its inputs */
+static struct
+{
+  uint32_t magic;
+  byte     hash[CRYPTO_SHA256_BUFFER_LENGTH];
+  size_t   length;
+  byte     der[CRYPTO_CERT_BUFFER_LENGTH];
+} _cert_cache CRYPTO_CERT_CACHE_ATTRIBUTE;
+#endif
 
 /**************************************************************************************
  * CTOR/DTOR
@@ -183,6 +205,25 @@ int CryptoUtil::readCert(ArduinoIoTCloudCertClass & cert, const CryptoSlot certS
     return 0;
   }
 
+#if AIOT_CONFIG_CERT_CACHE_ENABLED
+  /* The certificate only depends on the device id, the compressed slots and
+   * the public key of the locked key slot. The slow public key generation
+   * and the rebuild are skipped if the former did not change.
+   */
+  byte hash[CRYPTO_SHA256_BUFFER_LENGTH];
+  SHA256 sha256;
+  sha256.begin();
+  sha256.update(reinterpret_cast<uint8_t const *>(deviceId.c_str()), deviceId.length());
+  sha256.update(cert.compressedCertBytes(), cert.compressedCertLenght());
+  sha256.finalize(hash);
+
+  if ((_cert_cache.magic == CRYPTO_CERT_CACHE_MAGIC) && (_cert_cache.length <= CRYPTO_CERT_BUFFER_LENGTH) &&
+      (memcmp(_cert_cache.hash, hash, sizeof(hash)) == 0)) {
+    return cert.importCert(_cert_cache.der, _cert_cache.length);
+  }
+  _cert_cache.magic = 0;
+#endif
+
   if (!_crypto.generatePublicKey(static_cast<int>(CryptoSlot::Key), publicKey)) {
     return 0;
   }
@@ -204,6 +245,15 @@ int CryptoUtil::readCert(ArduinoIoTCloudCertClass & cert, const CryptoSlot certS
   if (!cert.signCert()) {
     return 0;
   }
+
+#if AIOT_CONFIG_CERT_CACHE_ENABLED
+  if (cert.length() <= CRYPTO_CERT_BUFFER_LENGTH) {
+    memcpy(_cert_cache.der, cert.bytes(), cert.length());
+    memcpy(_cert_cache.hash, hash, sizeof(hash));
+    _cert_cache.length = cert.length();
+    _cert_cache.magic = CRYPTO_CERT_CACHE_MAGIC;
+  }
+#endif
 #endif
   return 1;
 }
@@ -68,6 +68,7 @@ public:
   inline int locked() { return _crypto.locked(); }
   inline int writeConfiguration(const byte config[]) { return _crypto.writeConfiguration(config); }
   inline int lock() { return _crypto.lock(); }
+  inline int ecSign(const CryptoSlot keySlot, const byte hash[], byte signature[]) { return _crypto.ecSign(static_cast<int>(keySlot), hash, signature); }
 
   int buildCSR(ArduinoIoTCloudCertClass & cert, const CryptoSlot keySlot, bool newPrivateKey);
   int buildCert(ArduinoIoTCloudCertClass & cert, const CryptoSlot keySlot);
@@ -0,0 +1,91 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "DRBG.h"
+
+#ifdef BOARD_HAS_ECCX08
+
+#include <Arduino.h>
+#include <ArduinoECCX08.h>
+
+#include "../bearssl/bearssl_rand.h"
+
+/******************************************************************************
+ * LOCAL MODULE VARIABLES
+ ******************************************************************************/
+
+static br_hmac_drbg_context drbg_ctx;
+static bool drbg_is_seeded = false;
+static unsigned int drbg_generate_cnt = 0;
+
+/* ECCX08.begin() and locked() are only queried once, an unlocked ECCX08
+ * returns a fixed pattern instead of random numbers.
+ */
+static bool drbg_is_eccx08_checked = false;
+static bool drbg_is_eccx08_usable = false;
+
+/******************************************************************************
+ * LOCAL MODULE FUNCTIONS
+ ******************************************************************************/
+
+static bool drbg_seed()
+{
+  if (!drbg_is_eccx08_checked) {
+    drbg_is_eccx08_usable = ECCX08.begin() && ECCX08.locked();
+    drbg_is_eccx08_checked = true;
+  }
+
+  byte seed[32];
+  if (!drbg_is_eccx08_usable || !ECCX08.random(seed, sizeof(seed))) {
+    return false;
+  }
+
+  if (drbg_is_seeded) {
+    br_hmac_drbg_update(&drbg_ctx, seed, sizeof(seed));
+  } else {
+    br_hmac_drbg_init(&drbg_ctx, &br_sha256_vtable, seed, sizeof(seed));
+    drbg_is_seeded = true;
+  }
+  return true;
+}
+
+/******************************************************************************
+ * FUNCTION DEFINITION
+ ******************************************************************************/
+
+bool drbg_generate(void * out, size_t const len)
+{
+  /* A failed reseed keeps using the current state until the next interval */
+  if (!drbg_is_seeded || (drbg_generate_cnt >= AIOT_CONFIG_DRBG_RESEED_INTERVAL)) {
+    drbg_seed();
+    drbg_generate_cnt = 0;
+  }
+
+  if (!drbg_is_seeded) {
+    return false;
+  }
+
+  br_hmac_drbg_generate(&drbg_ctx, out, len);
+  drbg_generate_cnt++;
+  return true;
+}
+
+#endif /* BOARD_HAS_ECCX08 */
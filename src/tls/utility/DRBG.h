@@ -0,0 +1,45 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_TLS_UTILITY_DRBG_H_
+#define ARDUINO_TLS_UTILITY_DRBG_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#ifdef BOARD_HAS_ECCX08
+
+#include <stddef.h>
+
+/******************************************************************************
+ * FUNCTION DECLARATION
+ ******************************************************************************/
+
+/* Fills out with len bytes of a HMAC-DRBG (SHA-256) shared by the whole
+ * library. It is seeded from the ECCX08 on the first call and reseeded
+ * after AIOT_CONFIG_DRBG_RESEED_INTERVAL calls, in between no I2C transfer
+ * is needed. Returns false, leaving out untouched, as long as the ECCX08
+ * could not provide a seed, e.g. because its configuration is not locked.
+ */
+bool drbg_generate(void * out, size_t const len);
+
+#endif /* BOARD_HAS_ECCX08 */
+
+#endif /* ARDUINO_TLS_UTILITY_DRBG_H_ */
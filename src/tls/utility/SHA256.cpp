@@ -21,6 +21,10 @@
 
 #include "SHA256.h"
 
+#if defined(ARDUINO_ARCH_ESP32)
+#  include <mbedtls/version.h>
+#endif
+
 /******************************************************************************
  * STATIC MEMBER DECLARATION
  ******************************************************************************/
@@ -31,6 +35,31 @@ constexpr size_t SHA256::HASH_SIZE;
  * PUBLIC MEMBER FUNCTIONS
  ******************************************************************************/
 
+#if defined(ARDUINO_ARCH_ESP32)
+/* mbedTLS 3 dropped the _ret suffix of the functions returning an error */
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+#  define mbedtls_sha256_starts_ret mbedtls_sha256_starts
+#  define mbedtls_sha256_update_ret mbedtls_sha256_update
+#  define mbedtls_sha256_finish_ret mbedtls_sha256_finish
+#endif
+
+void SHA256::begin()
+{
+  mbedtls_sha256_init(&_ctx);
+  mbedtls_sha256_starts_ret(&_ctx, 0);
+}
+
+void SHA256::update(uint8_t const * data, size_t const len)
+{
+  mbedtls_sha256_update_ret(&_ctx, data, len);
+}
+
+void SHA256::finalize(uint8_t * hash)
+{
+  mbedtls_sha256_finish_ret(&_ctx, hash);
+  mbedtls_sha256_free(&_ctx);
+}
+#else
 void SHA256::begin()
 {
   br_sha256_init(&_ctx);
@@ -45,3 +74,4 @@ void SHA256::finalize(uint8_t * hash)
 {
   br_sha256_out(&_ctx, hash);
 }
+#endif
@@ -22,7 +22,12 @@
  * INCLUDE
  ******************************************************************************/
 
-#include "../bearssl/bearssl_hash.h"
+#if defined(ARDUINO_ARCH_ESP32)
+/* Backed by the SHA accelerator of the ESP32 */
+#  include <mbedtls/sha256.h>
+#else
+#  include "../bearssl/bearssl_hash.h"
+#endif
 
 /******************************************************************************
  * CLASS DECLARATION
@@ -41,7 +46,11 @@ public:
 
 private:
 
+#if defined(ARDUINO_ARCH_ESP32)
+  mbedtls_sha256_context _ctx;
+#else
   br_sha256_context _ctx;
+#endif
 
 };
 
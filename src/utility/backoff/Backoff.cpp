@@ -0,0 +1,64 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "Backoff.h"
+
+/******************************************************************************
+ * LOCAL MODULE VARIABLES
+ ******************************************************************************/
+
+static uint32_t backoff_state = 0x9E3779B9;
+
+/******************************************************************************
+ * LOCAL MODULE FUNCTIONS
+ ******************************************************************************/
+
+/* xorshift32, good enough for spreading retries and independent of random() */
+static uint32_t backoff_random()
+{
+  backoff_state ^= backoff_state << 13;
+  backoff_state ^= backoff_state >> 17;
+  backoff_state ^= backoff_state << 5;
+  return backoff_state;
+}
+
+/******************************************************************************
+ * FUNCTION DEFINITION
+ ******************************************************************************/
+
+void backoff_seed(uint32_t const seed)
+{
+  /* xorshift must not be seeded with 0 */
+  backoff_state = (seed != 0) ? seed : 0x9E3779B9;
+}
+
+unsigned long backoff_delay(unsigned int const attempt, unsigned long const base_ms, unsigned long const max_ms)
+{
+  if (base_ms >= max_ms)
+    return max_ms;
+
+  /* Double the bound without shifting, which could overflow */
+  unsigned long bound = base_ms;
+  for (unsigned int i = 0; (i < attempt) && (bound < max_ms); i++)
+    bound = (bound > (max_ms / 2)) ? max_ms : (bound * 2);
+
+  return base_ms + (backoff_random() % (bound - base_ms + 1));
+}
@@ -0,0 +1,43 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_BACKOFF_H_
+#define ARDUINO_AIOTC_UTILITY_BACKOFF_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stdint.h>
+
+/******************************************************************************
+ * FUNCTION DECLARATION
+ ******************************************************************************/
+
+/* Seeds the generator used for the jitter, the seed should differ between
+ * devices, e.g. derived from the device id or a hardware RNG.
+ */
+void backoff_seed(uint32_t const seed);
+
+/* Returns the delay before retry number 'attempt' (starting at 0). The upper
+ * bound grows exponentially from base_ms and is capped at max_ms, the delay
+ * itself is drawn uniformly between base_ms and that bound ("full jitter")
+ * so that devices failing at the same time do not retry in lockstep.
+ */
+unsigned long backoff_delay(unsigned int const attempt, unsigned long const base_ms, unsigned long const max_ms);
+
+#endif /* ARDUINO_AIOTC_UTILITY_BACKOFF_H_ */
@@ -0,0 +1,229 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "LZSSBlock.h"
+
+/******************************************************************************
+ * INTERNAL CLASS DEFINITION
+ ******************************************************************************/
+
+namespace
+{
+
+/* Bits are written and read most significant first, as lzss.c does */
+class BitWriter
+{
+public:
+  BitWriter(uint8_t * out, size_t const size) : _out(out), _size(size), _length(0), _mask(0), _is_full(false) { }
+
+  void put(unsigned int const value, size_t bits)
+  {
+    while ((bits-- > 0) && !_is_full)
+    {
+      if (_mask == 0)
+      {
+        if (_length >= _size)
+        {
+          _is_full = true;
+          return;
+        }
+        _out[_length++] = 0;
+        _mask = 0x80;
+      }
+      if (value & (1U << bits))
+        _out[_length - 1] |= _mask;
+      _mask >>= 1;
+    }
+  }
+  inline bool   isFull() const { return _is_full; }
+  inline size_t length() const { return _is_full ? 0 : _length; }
+
+private:
+  uint8_t * _out;
+  size_t _size;
+  size_t _length;
+  uint8_t _mask;
+  bool _is_full;
+};
+
+class BitReader
+{
+public:
+  BitReader(uint8_t const * data, size_t const length) : _data(data), _length(length), _bit(0) { }
+
+  /* Padding bits at the end do not make up another value */
+  bool get(size_t const bits, unsigned int & value)
+  {
+    if ((_bit + bits) > (_length * 8))
+      return false;
+    value = 0;
+    for (size_t i = 0; i < bits; i++, _bit++)
+      value = (value << 1) | ((_data[_bit / 8] >> (7 - (_bit % 8))) & 1);
+    return true;
+  }
+
+private:
+  uint8_t const * _data;
+  size_t _length;
+  size_t _bit;
+};
+
+/* The decompressed data is read back for the matches */
+class StringOutput
+{
+public:
+  StringOutput(String & str, size_t const max_length) : _str(str), _max_length(max_length) { _str = ""; }
+
+  bool append(char const c)
+  {
+    if (_str.length() >= _max_length)
+      return false;
+    _str += c;
+    return true;
+  }
+  inline char   at(size_t const pos) const { return _str[pos]; }
+  inline size_t length() const { return _str.length(); }
+
+private:
+  String & _str;
+  size_t _max_length;
+};
+
+class BufferOutput
+{
+public:
+  BufferOutput(uint8_t * buffer, size_t const size) : _buffer(buffer), _size(size), _length(0) { }
+
+  bool append(char const c)
+  {
+    if (_length >= _size)
+      return false;
+    _buffer[_length++] = static_cast<uint8_t>(c);
+    return true;
+  }
+  inline char   at(size_t const pos) const { return static_cast<char>(_buffer[pos]); }
+  inline size_t length() const { return _length; }
+
+private:
+  uint8_t * _buffer;
+  size_t _size;
+  size_t _length;
+};
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+size_t LZSSBlock::compress(uint8_t const * data, size_t const length, uint8_t * out, size_t const size)
+{
+  BitWriter writer(out, size);
+  size_t pos = 0;
+  while ((pos < length) && !writer.isFull())
+  {
+    size_t const max_len = ((length - pos) < F) ? (length - pos) : F;
+    size_t const start = (pos > SEARCH_WINDOW) ? (pos - SEARCH_WINDOW) : 0;
+    size_t match_len = 1;
+    size_t match_pos = 0;
+    /* The nearest of the longest matches, which may overlap the position */
+    for (size_t cand = pos; (cand-- > start) && (match_len < max_len); )
+    {
+      size_t len = 0;
+      while ((len < max_len) && (data[cand + len] == data[pos + len]))
+        len++;
+      if (len > match_len)
+      {
+        match_len = len;
+        match_pos = cand;
+      }
+    }
+
+    if (match_len <= P)
+    {
+      match_len = 1;
+      writer.put(1, 1);
+      writer.put(data[pos], 8);
+    }
+    else
+    {
+      /* The decoder has filled its window with N - F spaces before the data */
+      writer.put(0, 1);
+      writer.put((N - F + match_pos) & (N - 1), EI);
+      writer.put(match_len - (P + 1), EJ);
+    }
+    pos += match_len;
+  }
+  return writer.length();
+}
+
+bool LZSSBlock::decompress(uint8_t const * data, size_t const length, String & str, size_t const max_length)
+{
+  StringOutput out(str, max_length);
+  return decompress(data, length, out);
+}
+
+bool LZSSBlock::decompress(uint8_t const * data, size_t const length, uint8_t * out, size_t const size, size_t & out_length)
+{
+  BufferOutput buffer(out, size);
+  bool const is_complete = decompress(data, length, buffer);
+  out_length = buffer.length();
+  return is_complete;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+template <typename Output>
+bool LZSSBlock::decompress(uint8_t const * data, size_t const length, Output & out)
+{
+  BitReader reader(data, length);
+  unsigned int flag = 0;
+  while (reader.get(1, flag))
+  {
+    unsigned int value = 0;
+    if (flag)
+    {
+      if (!reader.get(8, value))
+        break;
+      if (!out.append(static_cast<char>(value)))
+        return false;
+      continue;
+    }
+
+    unsigned int offset = 0;
+    if (!reader.get(EI, offset) || !reader.get(EJ, value))
+      break;
+    /* Positions count from the start of the window, the data follows the spaces */
+    size_t const r = N - F + out.length();
+    size_t distance = (r - offset) & (N - 1);
+    if (distance == 0)
+      distance = N;
+    for (size_t k = 0; k < (value + P + 1); k++)
+    {
+      size_t const src = r + k - distance;
+      if (!out.append((src < (N - F)) ? ' ' : out.at(src - (N - F))))
+        return false;
+    }
+  }
+  return true;
+}
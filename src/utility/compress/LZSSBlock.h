@@ -0,0 +1,75 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_LZSS_BLOCK_H_
+#define ARDUINO_AIOTC_UTILITY_LZSS_BLOCK_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Arduino.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* LZSS of a value held in memory as a whole, in the format produced by
+ * extras/tools/lzss.c and read by LZSSDecoder. The encoder searches its
+ * matches within the value itself and only SEARCH_WINDOW bytes back, which
+ * needs no window of its own and bounds the time taken. The decoder copies
+ * the matches from the value decoded so far.
+ */
+class LZSSBlock
+{
+public:
+
+  static size_t const SEARCH_WINDOW = AIOT_CONFIG_COMPRESSION_SEARCH_WINDOW;
+
+  /* Returns the length of the compressed data, 0 if it exceeds size */
+  static size_t compress(uint8_t const * data, size_t const length, uint8_t * out, size_t const size);
+  /* Replaces the content of str, returns false if the decompressed data
+   * exceeds max_length.
+   */
+  static bool decompress(uint8_t const * data, size_t const length, String & str, size_t const max_length);
+  /* Returns false if the decompressed data exceeds size, which leaves the
+   * content of out undefined.
+   */
+  static bool decompress(uint8_t const * data, size_t const length, uint8_t * out, size_t const size, size_t & out_length);
+
+private:
+
+  /* As LZSSDecoder */
+  static size_t const EI = 11;
+  static size_t const EJ = 4;
+  static size_t const N  = (1 << EI);
+  static size_t const F  = (1 << EJ) + 1;
+  /* Matches up to this length are sent as literals */
+  static size_t const P  = 1;
+
+  template <typename Output>
+  static bool decompress(uint8_t const * data, size_t const length, Output & out);
+
+  static_assert(SEARCH_WINDOW <= (N - F), "AIOT_CONFIG_COMPRESSION_SEARCH_WINDOW exceeds the LZSS window");
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_LZSS_BLOCK_H_ */
@@ -0,0 +1,82 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "CloudThing.h"
+
+#include "../../property/types/CloudWrapperBool.h"
+#include "../../property/types/CloudWrapperFloat.h"
+#include "../../property/types/CloudWrapperInt.h"
+#include "../../property/types/CloudWrapperUnsignedInt.h"
+#include "../../property/types/CloudWrapperString.h"
+#include "../memory/StaticArena.h"
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+CloudThing::CloudThing(String const & thing_id)
+: _thing_id{thing_id}
+, _last_checked_property_index{0}
+, _state{State::Subscribe}
+, _last_sync_request_tick{0}
+, _on_sync{nullptr}
+, _shadow_topic_out{String("/a/t/") + thing_id + String("/shadow/o")}
+, _shadow_topic_in {String("/a/t/") + thing_id + String("/shadow/i")}
+, _data_topic_out  {String("/a/t/") + thing_id + String("/e/o")}
+, _data_topic_in   {String("/a/t/") + thing_id + String("/e/i")}
+{
+  _topic_router.add(static_cast<uint8_t>(Topic::Shadow), _shadow_topic_in);
+  _topic_router.add(static_cast<uint8_t>(Topic::Data), _data_topic_in);
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+Property & CloudThing::addPropertyReal(Property & property, char const * name, Permission const permission)
+{
+  return addPropertyToContainer(_property_container, property, name, permission);
+}
+
+Property & CloudThing::addPropertyReal(bool & property, char const * name, Permission const permission)
+{
+  return addPropertyReal(*arenaNew<CloudWrapperBool>(property), name, permission);
+}
+
+Property & CloudThing::addPropertyReal(float & property, char const * name, Permission const permission)
+{
+  return addPropertyReal(*arenaNew<CloudWrapperFloat>(property), name, permission);
+}
+
+Property & CloudThing::addPropertyReal(int & property, char const * name, Permission const permission)
+{
+  return addPropertyReal(*arenaNew<CloudWrapperInt>(property), name, permission);
+}
+
+Property & CloudThing::addPropertyReal(unsigned int & property, char const * name, Permission const permission)
+{
+  return addPropertyReal(*arenaNew<CloudWrapperUnsignedInt>(property), name, permission);
+}
+
+Property & CloudThing::addPropertyReal(String & property, char const * name, Permission const permission)
+{
+  return addPropertyReal(*arenaNew<CloudWrapperString>(property), name, permission);
+}
@@ -0,0 +1,114 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_CLOUD_THING_H_
+#define ARDUINO_AIOTC_UTILITY_CLOUD_THING_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <Arduino.h>
+
+#include "../../property/PropertyContainer.h"
+#include "../mqtt/TopicRouter.h"
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+class CloudThing;
+
+typedef void (*OnThingSyncCallback)(CloudThing & thing);
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* A thing of a sub-device behind a gateway, e.g. a sensor on RS-485, BLE or
+ * LoRa. It has properties and topics of its own but shares the connection
+ * and the outbound message queue of ArduinoCloud, see
+ * ArduinoCloud.addThing(). The thing is referenced and has to outlive the
+ * cloud connection, as do the variables of its properties.
+ *
+ * Its properties are added as those of the thing of the board, e.g.
+ * thing.addProperty(temperature, Permission::Read), and are only sent once
+ * the last values of the thing have been received after each connect.
+ */
+class CloudThing
+{
+public:
+
+  enum class Topic : uint8_t
+  {
+    None = TopicRouter::NONE,
+    Shadow,
+    Data
+  };
+
+  CloudThing(String const & thing_id);
+
+  inline String const & thingId() const { return _thing_id; }
+  inline PropertyContainer & properties() { return _property_container; }
+
+  /* Called each time the last values of the thing have been received */
+  inline void onSync(OnThingSyncCallback callback) { _on_sync = callback; }
+  inline bool isSynced() const { return _state == State::Synced; }
+
+  Property & addPropertyReal(Property & property, char const * name, Permission const permission);
+  Property & addPropertyReal(bool & property, char const * name, Permission const permission);
+  Property & addPropertyReal(float & property, char const * name, Permission const permission);
+  Property & addPropertyReal(int & property, char const * name, Permission const permission);
+  Property & addPropertyReal(unsigned int & property, char const * name, Permission const permission);
+  Property & addPropertyReal(String & property, char const * name, Permission const permission);
+
+  inline String const & shadowTopicOut() const { return _shadow_topic_out; }
+  inline String const & shadowTopicIn () const { return _shadow_topic_in; }
+  inline String const & dataTopicOut  () const { return _data_topic_out; }
+  inline String const & dataTopicIn   () const { return _data_topic_in; }
+
+  /* Which of the inbound topics of the thing the topic is, if any */
+  inline Topic match(char const * topic, size_t const len) const { return static_cast<Topic>(_topic_router.match(topic, len)); }
+
+private:
+
+  /* Advanced by ArduinoIoTCloudTCP on the connection it shares */
+  enum class State
+  {
+    Subscribe,
+    RequestLastValues,
+    Synced
+  };
+
+  String _thing_id;
+  PropertyContainer _property_container;
+  unsigned int _last_checked_property_index;
+  State _state;
+  unsigned long _last_sync_request_tick;
+  OnThingSyncCallback _on_sync;
+  String _shadow_topic_out;
+  String _shadow_topic_in;
+  String _data_topic_out;
+  String _data_topic_in;
+  TopicRouter _topic_router;
+
+  friend class ArduinoIoTCloudTCP;
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_CLOUD_THING_H_ */
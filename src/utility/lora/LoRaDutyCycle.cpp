@@ -0,0 +1,131 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include "LoRaDutyCycle.h"
+
+/**************************************************************************************
+ * CTOR/DTOR
+ **************************************************************************************/
+
+LoRaDutyCycle::LoRaDutyCycle()
+: _region{LoRaRegion::EU868}
+, _duty_cycle_per_mille{10}
+, _spreading_factor{7}
+, _bandwidth_kHz{125}
+, _max_payload{regionMaxPayload(LoRaRegion::EU868, 7)}
+, _max_dwell_ms{0}
+, _is_blocked{false}
+, _blocked_since_ms{0}
+, _blocked_for_ms{0}
+{
+
+}
+
+/**************************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void LoRaDutyCycle::setRegion(LoRaRegion const region)
+{
+  _region = region;
+  switch (region)
+  {
+  case LoRaRegion::EU868: _duty_cycle_per_mille = 10; _max_dwell_ms = 0;   setDataRate(7, 125); break;
+  case LoRaRegion::US915: _duty_cycle_per_mille = 0;  _max_dwell_ms = 400; setDataRate(7, 125); break;
+  }
+}
+
+void LoRaDutyCycle::setDataRate(uint8_t const spreading_factor, uint16_t const bandwidth_kHz)
+{
+  _spreading_factor = spreading_factor;
+  _bandwidth_kHz = bandwidth_kHz;
+  _max_payload = regionMaxPayload(_region, spreading_factor);
+}
+
+size_t LoRaDutyCycle::maxPayload() const
+{
+  size_t max_payload = _max_payload;
+  if (_max_dwell_ms > 0)
+  {
+    /* The time on air is monotonic in the payload size */
+    while ((max_payload > 0) && (airtime_us(max_payload, _spreading_factor, _bandwidth_kHz) > (_max_dwell_ms * 1000UL)))
+      max_payload--;
+  }
+  return max_payload;
+}
+
+bool LoRaDutyCycle::canTransmit(unsigned long const now_ms) const
+{
+  return waitTime(now_ms) == 0;
+}
+
+unsigned long LoRaDutyCycle::waitTime(unsigned long const now_ms) const
+{
+  if (!_is_blocked)
+    return 0;
+  unsigned long const elapsed_ms = now_ms - _blocked_since_ms;
+  return (elapsed_ms >= _blocked_for_ms) ? 0 : (_blocked_for_ms - elapsed_ms);
+}
+
+void LoRaDutyCycle::onTransmit(size_t const payload, unsigned long const now_ms)
+{
+  if (_duty_cycle_per_mille == 0)
+    return;
+  /* Round up so that the budget is never exceeded */
+  unsigned long const airtime_ms = (airtime_us(payload, _spreading_factor, _bandwidth_kHz) + 999UL) / 1000UL;
+  _is_blocked = true;
+  _blocked_since_ms = now_ms;
+  _blocked_for_ms = airtime_ms * ((1000UL / _duty_cycle_per_mille) - 1);
+}
+
+unsigned long LoRaDutyCycle::airtime_us(size_t const payload, uint8_t const spreading_factor, uint16_t const bandwidth_kHz)
+{
+  long const sf = spreading_factor;
+  /* Low data rate optimisation is mandated for symbols longer than 16 ms */
+  long const de = ((sf >= 11) && (bandwidth_kHz <= 125)) ? 1 : 0;
+  unsigned long const symbol_us = ((1UL << sf) * 1000UL) / bandwidth_kHz;
+
+  long const bits = 8L * static_cast<long>(payload + LORAWAN_FRAME_OVERHEAD) - 4L * sf + 28L + 16L;
+  long const bits_per_block = 4L * (sf - 2L * de);
+  long const payload_symbols = 8L + ((bits > 0) ? ((bits + bits_per_block - 1) / bits_per_block) * 5L : 0L);
+
+  /* 8 preamble symbols plus 4.25 symbols of sync word */
+  return (symbol_us * 49UL) / 4UL + static_cast<unsigned long>(payload_symbols) * symbol_us;
+}
+
+size_t LoRaDutyCycle::regionMaxPayload(LoRaRegion const region, uint8_t const spreading_factor)
+{
+  /* Maximum application payload N of the uplink data rates, see LoRaWAN
+   * Regional Parameters RP002: EU868 DR0 (SF12) to DR5 (SF7) and US915
+   * DR0 (SF10) to DR3 (SF7).
+   */
+  if (region == LoRaRegion::US915)
+  {
+    if (spreading_factor >= 10) return 11;
+    if (spreading_factor == 9)  return 53;
+    if (spreading_factor == 8)  return 125;
+    return 242;
+  }
+
+  if (spreading_factor >= 10) return 51;
+  if (spreading_factor == 9)  return 115;
+  return 222;
+}
@@ -0,0 +1,98 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_IOT_CLOUD_LORA_DUTY_CYCLE_H_
+#define ARDUINO_IOT_CLOUD_LORA_DUTY_CYCLE_H_
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**************************************************************************************
+ * TYPEDEF
+ **************************************************************************************/
+
+enum class LoRaRegion : uint8_t
+{
+  EU868, US915
+};
+
+/**************************************************************************************
+ * CLASS DECLARATION
+ **************************************************************************************/
+
+/* Paces LoRaWAN uplinks according to the regional duty cycle: after an uplink
+ * of a given time on air the band has to stay silent for the remainder of the
+ * duty cycle period, e.g. 99 times the time on air for 1% in EU868. It also
+ * bounds the payload size by the maximum of the data rate and, in regions
+ * with a dwell time limit such as US915, by the time on air.
+ *
+ * The defaults match EU868 at DR5 (SF7, 125 kHz) with a 1% duty cycle.
+ */
+class LoRaDutyCycle
+{
+
+public:
+
+  LoRaDutyCycle();
+
+  /* Applies the duty cycle, dwell time and payload limits of the region */
+  void setRegion(LoRaRegion const region);
+  /* A duty cycle of 0 disables the pacing, e.g. for US915 */
+  void setDutyCycle(uint16_t const per_mille) { _duty_cycle_per_mille = per_mille; }
+  /* Also resets the maximum payload size to the regional limit of that data rate */
+  void setDataRate(uint8_t const spreading_factor, uint16_t const bandwidth_kHz);
+  void setMaxPayload(size_t const max_payload) { _max_payload = max_payload; }
+  /* A dwell time of 0 does not limit the time on air of a single uplink */
+  void setMaxDwellTime(unsigned long const max_dwell_ms) { _max_dwell_ms = max_dwell_ms; }
+
+  /* Largest application payload which may be sent with the current settings */
+  size_t maxPayload() const;
+  bool   canTransmit(unsigned long const now_ms) const;
+  /* Milliseconds until the next uplink is allowed, 0 if it is allowed now */
+  unsigned long waitTime(unsigned long const now_ms) const;
+  /* Accounts a successful uplink of 'payload' application bytes */
+  void   onTransmit(size_t const payload, unsigned long const now_ms);
+
+  /* Time on air in microseconds of an uplink of 'payload' application bytes,
+   * see Semtech AN1200.13 (explicit header, CRC, coding rate 4/5, 8 symbol
+   * preamble) including the 13 byte LoRaWAN frame overhead.
+   */
+  static unsigned long airtime_us(size_t const payload, uint8_t const spreading_factor, uint16_t const bandwidth_kHz);
+  /* Maximum application payload of a data rate in the region */
+  static size_t regionMaxPayload(LoRaRegion const region, uint8_t const spreading_factor);
+
+private:
+
+  static size_t const LORAWAN_FRAME_OVERHEAD = 13;
+
+  LoRaRegion    _region;
+  uint16_t      _duty_cycle_per_mille;
+  uint8_t       _spreading_factor;
+  uint16_t      _bandwidth_kHz;
+  size_t        _max_payload;
+  unsigned long _max_dwell_ms;
+  bool          _is_blocked;
+  unsigned long _blocked_since_ms;
+  unsigned long _blocked_for_ms;
+
+};
+
+#endif /* ARDUINO_IOT_CLOUD_LORA_DUTY_CYCLE_H_ */
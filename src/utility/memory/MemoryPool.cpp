@@ -0,0 +1,56 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "MemoryPool.h"
+
+#include <stdlib.h>
+
+/******************************************************************************
+ * LOCAL MODULE VARIABLES
+ ******************************************************************************/
+
+static MemoryAllocator * memory_allocator[static_cast<size_t>(MemoryPool::Count)] = {nullptr};
+
+/******************************************************************************
+ * FUNCTION DEFINITION
+ ******************************************************************************/
+
+void setMemoryAllocator(MemoryPool const pool, MemoryAllocator * allocator)
+{
+  memory_allocator[static_cast<size_t>(pool)] = allocator;
+}
+
+void * memoryAlloc(MemoryPool const pool, size_t const size)
+{
+  MemoryAllocator * const allocator = memory_allocator[static_cast<size_t>(pool)];
+  return allocator ? allocator->allocate(size) : malloc(size);
+}
+
+void memoryFree(MemoryPool const pool, void * ptr)
+{
+  if (!ptr)
+    return;
+  MemoryAllocator * const allocator = memory_allocator[static_cast<size_t>(pool)];
+  if (allocator)
+    allocator->release(ptr);
+  else
+    free(ptr);
+}
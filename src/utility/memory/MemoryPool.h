@@ -0,0 +1,76 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_MEMORY_POOL_H_
+#define ARDUINO_AIOTC_UTILITY_MEMORY_POOL_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+/* The memory the library allocates by its use, so that each can be placed
+ * where it fits the board best, e.g. the rarely used buffers in external RAM.
+ */
+enum class MemoryPool : unsigned int
+{
+  /* Wrappers, copied names, aggregators and extra state of the properties,
+   * taken from the static arena first if enabled.
+   */
+  Property,
+  /* The certificate built or decoded for the TLS connection */
+  Certificate,
+  /* Scratch buffers of an OTA update */
+  Ota,
+  /* Scratch buffers which are taken while the scratch pool is leased */
+  Scratch,
+  Count
+};
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+class MemoryAllocator
+{
+public:
+  virtual ~MemoryAllocator() { }
+
+  /* Returns nullptr if there is no memory left, the allocation fails then */
+  virtual void * allocate(size_t const size) = 0;
+  virtual void   release(void * ptr) = 0;
+};
+
+/******************************************************************************
+ * FUNCTION DECLARATION
+ ******************************************************************************/
+
+/* Replaces the heap for the given pool, nullptr restores it. As the memory
+ * is released to the allocator of its pool, it is to be set before anything
+ * has been allocated from the pool, i.e. at the start of setup().
+ */
+void setMemoryAllocator(MemoryPool const pool, MemoryAllocator * allocator);
+
+void * memoryAlloc(MemoryPool const pool, size_t const size);
+void   memoryFree (MemoryPool const pool, void * ptr);
+
+#endif /* ARDUINO_AIOTC_UTILITY_MEMORY_POOL_H_ */
@@ -0,0 +1,129 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "ScratchPool.h"
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t const ScratchPool::SIZE;
+size_t const ScratchPool::ALIGNMENT;
+
+alignas(ScratchPool::ALIGNMENT) uint8_t ScratchPool::_storage[ScratchPool::SIZE];
+bool ScratchPool::_is_leased = false;
+size_t ScratchPool::_high_water = 0;
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool ScratchPool::isLeased()
+{
+  return _is_leased;
+}
+
+size_t ScratchPool::highWater()
+{
+  return _high_water;
+}
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+ScratchLease::ScratchLease()
+: _data{nullptr}
+, _size{0}
+, _fallback{MemoryPool::Count}
+{
+
+}
+
+ScratchLease::ScratchLease(size_t const size)
+: ScratchLease()
+{
+  acquire(size);
+}
+
+ScratchLease::ScratchLease(size_t const size, MemoryPool const fallback)
+: ScratchLease()
+{
+  acquire(size, fallback);
+}
+
+ScratchLease::~ScratchLease()
+{
+  release();
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool ScratchLease::acquire(size_t const size)
+{
+  return take(size, MemoryPool::Count, false);
+}
+
+bool ScratchLease::acquire(size_t const size, MemoryPool const fallback)
+{
+  return take(size, fallback, true);
+}
+
+void ScratchLease::release()
+{
+  if (isPooled())
+    ScratchPool::_is_leased = false;
+  else if (_data)
+    memoryFree(_fallback, _data);
+
+  _data = nullptr;
+  _size = 0;
+  _fallback = MemoryPool::Count;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool ScratchLease::take(size_t const size, MemoryPool const fallback, bool const has_fallback)
+{
+  release();
+
+  if (size > ScratchPool::_high_water)
+    ScratchPool::_high_water = size;
+
+  if (!ScratchPool::_is_leased && (size <= ScratchPool::SIZE))
+  {
+    ScratchPool::_is_leased = true;
+    _data = ScratchPool::_storage;
+  }
+  else if (has_fallback)
+  {
+    _data = static_cast<uint8_t *>(memoryAlloc(fallback, size));
+    _fallback = fallback;
+  }
+
+  _size = _data ? size : 0;
+  return (_data != nullptr);
+}
@@ -0,0 +1,101 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_SCRATCH_POOL_H_
+#define ARDUINO_AIOTC_UTILITY_SCRATCH_POOL_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "MemoryPool.h"
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* A single static buffer shared by the scratch buffers of phases which do
+ * not overlap, e.g. decoding a received message, compressing a value being
+ * encoded and hashing the application for an OTA update. It is leased to
+ * one user at a time, a lease which does not fit or is taken while the pool
+ * is leased is allocated from its fallback pool instead, see ScratchLease.
+ * Only leased by the thread which runs update().
+ */
+class ScratchPool
+{
+public:
+
+  static size_t const SIZE = AIOT_CONFIG_SCRATCH_POOL_SIZE;
+  static size_t const ALIGNMENT = 4;
+
+  static bool   isLeased();
+  /* Largest lease taken since the start, whether it was taken from the pool
+   * or not. The pool is large enough once it is not above SIZE.
+   */
+  static size_t highWater();
+
+private:
+
+  friend class ScratchLease;
+
+  alignas(ALIGNMENT) static uint8_t _storage[SIZE];
+  static bool _is_leased;
+  static size_t _high_water;
+};
+
+class ScratchLease
+{
+public:
+
+  ScratchLease();
+  /* Same as acquire() */
+  ScratchLease(size_t const size);
+  ScratchLease(size_t const size, MemoryPool const fallback);
+  ~ScratchLease();
+
+  ScratchLease(ScratchLease const &) = delete;
+  ScratchLease & operator = (ScratchLease const &) = delete;
+
+  /* Takes size bytes from the scratch pool if it is not leased and large
+   * enough, from the fallback pool otherwise. Without a fallback pool the
+   * lease fails then, the caller does without the buffer. Any buffer held
+   * by this lease is released before.
+   */
+  bool acquire(size_t const size);
+  bool acquire(size_t const size, MemoryPool const fallback);
+  void release();
+
+  inline uint8_t * data() const { return _data; }
+  inline size_t    size() const { return _size; }
+  inline bool isPooled() const { return _data == ScratchPool::_storage; }
+  inline explicit operator bool() const { return _data != nullptr; }
+
+private:
+
+  uint8_t * _data;
+  size_t _size;
+  MemoryPool _fallback;
+
+  bool take(size_t const size, MemoryPool const fallback, bool const has_fallback);
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_SCRATCH_POOL_H_ */
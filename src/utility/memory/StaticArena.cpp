@@ -0,0 +1,143 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "StaticArena.h"
+
+#if AIOT_CONFIG_STATIC_ALLOCATION_ENABLED
+
+#include <assert.h>
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t const StaticArena::SIZE;
+size_t const StaticArena::ALIGNMENT;
+size_t const StaticArena::HEADER_SIZE;
+
+alignas(StaticArena::ALIGNMENT) uint8_t StaticArena::_storage[StaticArena::SIZE];
+size_t StaticArena::_used = 0;
+StaticArena::FreeBlock * StaticArena::_free_list = nullptr;
+bool StaticArena::_is_heap_locked = false;
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void * StaticArena::allocate(size_t const size)
+{
+  size_t const block_size = blockSize(size);
+
+  /* A released block of the same size is taken first */
+  for (FreeBlock ** link = &_free_list; *link; link = &(*link)->next)
+  {
+    if (sizeOf(*link) == block_size)
+    {
+      FreeBlock * const block = *link;
+      *link = block->next;
+      return block;
+    }
+  }
+
+  if ((HEADER_SIZE + block_size) > (SIZE - _used))
+    return nullptr;
+
+  uint8_t * const block = _storage + _used + HEADER_SIZE;
+  _used += HEADER_SIZE + block_size;
+  sizeOf(block) = block_size;
+  return block;
+}
+
+void StaticArena::release(void * ptr)
+{
+  if (!ptr)
+    return;
+  FreeBlock * const block = static_cast<FreeBlock *>(ptr);
+  block->next = _free_list;
+  _free_list = block;
+}
+
+bool StaticArena::owns(void const * ptr)
+{
+  uint8_t const * const p = static_cast<uint8_t const *>(ptr);
+  return (p >= _storage) && (p < (_storage + SIZE));
+}
+
+size_t StaticArena::used()
+{
+  return _used;
+}
+
+void StaticArena::lockHeap()
+{
+  _is_heap_locked = true;
+}
+
+void StaticArena::unlockHeap()
+{
+  _is_heap_locked = false;
+}
+
+bool StaticArena::isHeapLocked()
+{
+  return _is_heap_locked;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+size_t StaticArena::blockSize(size_t const size)
+{
+  /* A released block holds the link to the next one */
+  size_t const min_size = (size < sizeof(FreeBlock)) ? sizeof(FreeBlock) : size;
+  return (min_size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+size_t & StaticArena::sizeOf(void * ptr)
+{
+  return *reinterpret_cast<size_t *>(static_cast<uint8_t *>(ptr) - HEADER_SIZE);
+}
+
+/******************************************************************************
+ * HEAP GUARD
+ ******************************************************************************/
+
+#if AIOT_CONFIG_HEAP_GUARD_ENABLED && defined(ARDUINO_ARCH_SAMD)
+/* newlib takes this lock around each malloc(), realloc() and free(). The
+ * default ones do nothing as there is no RTOS on these boards.
+ */
+extern "C" void __malloc_lock(struct _reent *)
+{
+  if (StaticArena::isHeapLocked())
+  {
+    /* Reporting the assertion may use the heap itself */
+    StaticArena::unlockHeap();
+    assert(!"heap used after the device has been connected");
+  }
+}
+
+extern "C" void __malloc_unlock(struct _reent *)
+{
+}
+#endif
+
+#endif /* AIOT_CONFIG_STATIC_ALLOCATION_ENABLED */
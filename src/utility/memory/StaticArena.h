@@ -0,0 +1,134 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_STATIC_ARENA_H_
+#define ARDUINO_AIOTC_UTILITY_STATIC_ARENA_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <new>
+#include <utility>
+
+#include "MemoryPool.h"
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+#if AIOT_CONFIG_STATIC_ALLOCATION_ENABLED
+/* The memory of the objects the library creates for the properties, most of
+ * them while the sketch adds them. Blocks are taken from a static buffer one
+ * after the other, a released block is kept for the next one of the same
+ * size. As the properties live as long as the sketch, and all the blocks
+ * released during runtime are of the same few sizes, the arena does not
+ * fragment. Once it is exhausted MemoryPool::Property is used instead.
+ */
+class StaticArena
+{
+public:
+
+  static size_t const SIZE = AIOT_CONFIG_STATIC_ARENA_SIZE;
+  static size_t const ALIGNMENT = 8;
+
+  /* Returns nullptr if there is no room left */
+  static void * allocate(size_t const size);
+  /* ptr must have been returned by allocate() */
+  static void   release(void * ptr);
+  static bool   owns(void const * ptr);
+  /* Bytes taken from the buffer so far, including the released blocks */
+  static size_t used();
+
+  /* Any use of the heap fails an assertion while the heap is locked, given
+   * AIOT_CONFIG_HEAP_GUARD_ENABLED on a board where malloc() can be hooked.
+   */
+  static void lockHeap();
+  static void unlockHeap();
+  static bool isHeapLocked();
+
+private:
+
+  struct FreeBlock
+  {
+    FreeBlock * next;
+  };
+
+  static size_t const HEADER_SIZE = ALIGNMENT;
+
+  alignas(ALIGNMENT) static uint8_t _storage[SIZE];
+  static size_t _used;
+  static FreeBlock * _free_list;
+  static bool _is_heap_locked;
+
+  static size_t blockSize(size_t const size);
+  static size_t & sizeOf(void * ptr);
+};
+#endif /* AIOT_CONFIG_STATIC_ALLOCATION_ENABLED */
+
+/******************************************************************************
+ * FUNCTION DEFINITION
+ ******************************************************************************/
+
+/* Allocate from the arena if enabled and not yet exhausted, from the pool
+ * of the properties otherwise. Whatever has been allocated by these is
+ * released by them.
+ */
+inline void * arenaAlloc(size_t const size)
+{
+#if AIOT_CONFIG_STATIC_ALLOCATION_ENABLED
+  void * const mem = StaticArena::allocate(size);
+  if (mem)
+    return mem;
+#endif
+  return memoryAlloc(MemoryPool::Property, size);
+}
+
+inline void arenaFree(void * ptr)
+{
+#if AIOT_CONFIG_STATIC_ALLOCATION_ENABLED
+  if (StaticArena::owns(ptr))
+  {
+    StaticArena::release(ptr);
+    return;
+  }
+#endif
+  memoryFree(MemoryPool::Property, ptr);
+}
+
+template <typename T, typename... Args>
+T * arenaNew(Args &&... args)
+{
+  void * const mem = arenaAlloc(sizeof(T));
+  return mem ? new (mem) T(std::forward<Args>(args)...) : nullptr;
+}
+
+template <typename T>
+void arenaDelete(T * obj)
+{
+  if (!obj)
+    return;
+  obj->~T();
+  arenaFree(obj);
+}
+
+#endif /* ARDUINO_AIOTC_UTILITY_STATIC_ARENA_H_ */
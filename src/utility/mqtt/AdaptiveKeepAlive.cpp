@@ -0,0 +1,161 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "AdaptiveKeepAlive.h"
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+unsigned int const AdaptiveKeepAlive::CONFIRMATION_CNT;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+AdaptiveKeepAlive::AdaptiveKeepAlive()
+: _limits{0, 0}
+, _interval_ms{0}
+, _safe_ms{0}
+, _unsafe_ms{0}
+, _confirmed_cnt{0}
+, _connected{false}
+, _last_tx_tick{0}
+, _pending_idle_ms{0}
+, _pending_tick{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void AdaptiveKeepAlive::begin(KeepAliveLimits const & limits)
+{
+  _limits = limits;
+  if (_limits.max_ms < _limits.min_ms)
+    _limits.max_ms = _limits.min_ms;
+  _interval_ms = _limits.min_ms;
+  _safe_ms = 0;
+  _unsafe_ms = 0;
+  _confirmed_cnt = 0;
+  _connected = false;
+  _pending_idle_ms = 0;
+}
+
+void AdaptiveKeepAlive::onConnected(unsigned long const now)
+{
+  _connected = true;
+  _confirmed_cnt = 0;
+  _pending_idle_ms = 0;
+  _last_tx_tick = now;
+}
+
+void AdaptiveKeepAlive::onTransmit(unsigned long const now)
+{
+  settle(now);
+  _last_tx_tick = now;
+}
+
+void AdaptiveKeepAlive::onPing(unsigned long const now)
+{
+  /* A loss would have been noticed before the next ping is sent */
+  if (_pending_idle_ms > 0)
+    confirm(_pending_idle_ms);
+  _pending_idle_ms = now - _last_tx_tick;
+  _pending_tick = now;
+  _last_tx_tick = now;
+}
+
+void AdaptiveKeepAlive::onDisconnected()
+{
+  if (!_connected)
+    return;
+
+  /* A loss noticed before the idle period ended by the last ping has been
+   * survived is blamed on it. The device may well notice the loss only when
+   * it wakes up for the next ping.
+   */
+  if (_pending_idle_ms > 0)
+    reject(_pending_idle_ms);
+  _pending_idle_ms = 0;
+  _connected = false;
+}
+
+bool AdaptiveKeepAlive::isPingDue(unsigned long const now) const
+{
+  return _connected && ((now - _last_tx_tick) >= _interval_ms);
+}
+
+unsigned long AdaptiveKeepAlive::nextPingIn(unsigned long const now) const
+{
+  unsigned long const idle_ms = now - _last_tx_tick;
+  return (idle_ms < _interval_ms) ? (_interval_ms - idle_ms) : 0;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void AdaptiveKeepAlive::settle(unsigned long const now)
+{
+  if ((_pending_idle_ms > 0) && ((now - _pending_tick) > _interval_ms))
+  {
+    confirm(_pending_idle_ms);
+    _pending_idle_ms = 0;
+  }
+}
+
+void AdaptiveKeepAlive::confirm(unsigned long const idle_ms)
+{
+  if (idle_ms > _safe_ms)
+    _safe_ms = idle_ms;
+  if (idle_ms < _interval_ms)
+    return;
+  if (++_confirmed_cnt < CONFIRMATION_CNT)
+    return;
+  _confirmed_cnt = 0;
+
+  /* Doubled until a loss is seen, then halfway towards it until the
+   * remaining distance is below an eighth of the interval.
+   */
+  unsigned long next_ms = 2 * _interval_ms;
+  if (_unsafe_ms > 0)
+  {
+    unsigned long const gap_ms = (_unsafe_ms > _interval_ms) ? (_unsafe_ms - _interval_ms) : 0;
+    next_ms = (gap_ms > _interval_ms / 8) ? (_interval_ms + gap_ms / 2) : _interval_ms;
+  }
+  _interval_ms = (next_ms < _limits.max_ms) ? next_ms : _limits.max_ms;
+}
+
+void AdaptiveKeepAlive::reject(unsigned long const idle_ms)
+{
+  if ((_unsafe_ms == 0) || (idle_ms < _unsafe_ms))
+    _unsafe_ms = idle_ms;
+
+  /* The network has changed if even the safe interval got lost */
+  if (_safe_ms >= _unsafe_ms)
+    _safe_ms = _unsafe_ms / 2;
+
+  _interval_ms = (_safe_ms > _limits.min_ms) ? _safe_ms : _limits.min_ms;
+  _confirmed_cnt = 0;
+}
@@ -0,0 +1,97 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_ADAPTIVE_KEEP_ALIVE_H_
+#define ARDUINO_AIOTC_UTILITY_ADAPTIVE_KEEP_ALIVE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stdint.h>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+struct KeepAliveLimits
+{
+  /* Idle time after which a ping is sent at least */
+  unsigned long min_ms;
+  /* Longest idle time probed, announced to the broker on connect */
+  unsigned long max_ms;
+};
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Finds the longest time a connection may stay idle before a NAT on the way
+ * forgets it. A ping is only due once nothing has been sent for the current
+ * interval, any other transmission counts as well. Each interval survived a
+ * few times is followed by a longer one, a connection lost right after an
+ * idle period marks that period as too long and the interval falls back to
+ * the longest one known to be safe.
+ */
+class AdaptiveKeepAlive
+{
+public:
+
+  /* Idle periods to be survived before probing a longer interval */
+  static unsigned int const CONFIRMATION_CNT = 2;
+
+  AdaptiveKeepAlive();
+
+  /* Starts over, e.g. for another network adapter */
+  void begin(KeepAliveLimits const & limits);
+
+  void onConnected(unsigned long const now);
+  void onTransmit(unsigned long const now);
+  /* To be called with the ping sent once isPingDue() */
+  void onPing(unsigned long const now);
+  void onDisconnected();
+
+  bool isPingDue(unsigned long const now) const;
+  unsigned long nextPingIn(unsigned long const now) const;
+
+  inline unsigned long interval() const { return _interval_ms; }
+  inline unsigned long maxInterval() const { return _limits.max_ms; }
+
+private:
+
+  KeepAliveLimits _limits;
+  unsigned long _interval_ms;
+  /* Longest idle period survived and shortest one after which the
+   * connection was lost, 0 while unknown.
+   */
+  unsigned long _safe_ms;
+  unsigned long _unsafe_ms;
+  unsigned int _confirmed_cnt;
+  bool _connected;
+  unsigned long _last_tx_tick;
+  /* Idle period ended by the last ping. It is survived once the connection
+   * is still up when the next ping is sent or an interval has passed.
+   */
+  unsigned long _pending_idle_ms;
+  unsigned long _pending_tick;
+
+  void settle(unsigned long const now);
+  void confirm(unsigned long const idle_ms);
+  void reject(unsigned long const idle_ms);
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_ADAPTIVE_KEEP_ALIVE_H_ */
@@ -0,0 +1,83 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "MessageDedup.h"
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t const MessageDedup::WINDOW_SIZE;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+MessageDedup::MessageDedup()
+{
+  clear();
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+uint32_t MessageDedup::begin(char const * topic, size_t const len)
+{
+  return update(2166136261UL, reinterpret_cast<uint8_t const *>(topic), len);
+}
+
+/* FNV-1a, which can be continued chunk by chunk as the payload is read */
+uint32_t MessageDedup::update(uint32_t digest, uint8_t const * buf, size_t const len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    digest ^= buf[i];
+    digest *= 16777619UL;
+  }
+  return digest;
+}
+
+bool MessageDedup::contains(uint32_t const digest) const
+{
+  for (size_t i = 0; i < _cnt; i++)
+  {
+    if (_digest[i] == digest)
+      return true;
+  }
+  return false;
+}
+
+void MessageDedup::add(uint32_t const digest)
+{
+  _digest[_next] = digest;
+  _next = (_next + 1) % WINDOW_SIZE;
+  if (_cnt < WINDOW_SIZE)
+    _cnt++;
+}
+
+void MessageDedup::clear()
+{
+  for (uint32_t & digest : _digest)
+    digest = 0;
+  _next = 0;
+  _cnt = 0;
+}
@@ -0,0 +1,65 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_MESSAGE_DEDUP_H_
+#define ARDUINO_AIOTC_UTILITY_MESSAGE_DEDUP_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Remembers the digests of the last messages applied from the QoS 1
+ * subscriptions. A message which the broker delivers again, because the
+ * PUBACK got lost, carries the DUP flag with the same topic and payload: its
+ * digest is found in the window and the message is not applied twice. The
+ * digest stands in for the packet identifier which the MQTT client does not
+ * expose, it acknowledges the messages on its own.
+ */
+class MessageDedup
+{
+public:
+
+  static size_t const WINDOW_SIZE = AIOT_CONFIG_MQTT_DEDUP_WINDOW;
+
+  MessageDedup();
+
+  /* The digest is built up over the topic and then the chunks of the payload */
+  static uint32_t begin(char const * topic, size_t const len);
+  static uint32_t update(uint32_t digest, uint8_t const * buf, size_t const len);
+
+  bool contains(uint32_t const digest) const;
+  /* Replaces the oldest digest once the window is full */
+  void add(uint32_t const digest);
+  void clear();
+
+private:
+
+  uint32_t _digest[WINDOW_SIZE];
+  size_t _next;
+  size_t _cnt;
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_MESSAGE_DEDUP_H_ */
@@ -0,0 +1,148 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "MqttPublish.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+static uint8_t const MQTT_PUBLISH_QOS0          = 0x30;
+static size_t  const MQTT_MAX_REMAINING_LENGTH  = 268435455;
+static size_t  const MQTT_MAX_TOPIC_LENGTH      = 65535;
+static uint8_t const MQTT5_PROP_TOPIC_ALIAS     = 0x23;
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+uint16_t const MqttTopicAliases::MAX_ALIASES;
+
+/******************************************************************************
+ * LOCAL FUNCTION DEFINITION
+ ******************************************************************************/
+
+/* The remaining length is encoded 7 bits at a time, least significant first */
+static size_t encode_remaining_length(uint8_t * bytes, size_t remaining_len)
+{
+  size_t cnt = 0;
+  do
+  {
+    uint8_t digit = remaining_len % 128;
+    remaining_len /= 128;
+    if (remaining_len > 0)
+      digit |= 0x80;
+    bytes[cnt++] = digit;
+  } while (remaining_len > 0);
+  return cnt;
+}
+
+/* Fixed header, topic and property section of length props_len (MQTT 5 only) */
+static size_t publish_header(uint8_t * buf, size_t const size, char const * topic, uint8_t const * props, size_t const props_len, bool const mqtt5, size_t const payload_len)
+{
+  size_t const topic_len = strlen(topic);
+  size_t const variable_len = 2 + topic_len + (mqtt5 ? 1 + props_len : 0);
+  if ((topic_len > MQTT_MAX_TOPIC_LENGTH) || (payload_len > MQTT_MAX_REMAINING_LENGTH - variable_len))
+    return 0;
+
+  uint8_t remaining_len_bytes[4];
+  size_t const remaining_len_cnt = encode_remaining_length(remaining_len_bytes, variable_len + payload_len);
+
+  size_t const header_len = 1 + remaining_len_cnt + variable_len;
+  if ((header_len > size) || (payload_len > size - header_len))
+    return 0;
+
+  uint8_t * p = buf;
+  *p++ = MQTT_PUBLISH_QOS0;
+  memcpy(p, remaining_len_bytes, remaining_len_cnt);
+  p += remaining_len_cnt;
+  *p++ = static_cast<uint8_t>(topic_len >> 8);
+  *p++ = static_cast<uint8_t>(topic_len & 0xFF);
+  memcpy(p, topic, topic_len);
+  p += topic_len;
+  if (mqtt5)
+  {
+    /* The property lengths used here are well below 128 */
+    *p++ = static_cast<uint8_t>(props_len);
+    memcpy(p, props, props_len);
+  }
+  return header_len;
+}
+
+/******************************************************************************
+ * FUNCTION DEFINITION
+ ******************************************************************************/
+
+size_t mqtt_publish_header(uint8_t * buf, size_t const size, char const * topic, size_t const payload_len)
+{
+  return publish_header(buf, size, topic, nullptr, 0, false, payload_len);
+}
+
+size_t mqtt5_publish_header(uint8_t * buf, size_t const size, char const * topic, uint16_t const alias, size_t const payload_len)
+{
+  uint8_t const props[] = {MQTT5_PROP_TOPIC_ALIAS, static_cast<uint8_t>(alias >> 8), static_cast<uint8_t>(alias & 0xFF)};
+  return publish_header(buf, size, topic, props, (alias != 0) ? sizeof(props) : 0, true, payload_len);
+}
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+MqttTopicAliases::MqttTopicAliases()
+: _max{0}
+, _established{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void MqttTopicAliases::reset(uint16_t const max)
+{
+  _max = (max < MAX_ALIASES) ? max : MAX_ALIASES;
+  _established = 0;
+}
+
+void MqttTopicAliases::forget(uint16_t const alias)
+{
+  if ((alias > 0) && (alias <= MAX_ALIASES))
+    _established &= ~(1U << (alias - 1));
+}
+
+size_t MqttTopicAliases::header(uint8_t * buf, size_t const size, char const * topic, uint16_t const alias, size_t const payload_len)
+{
+  /* Without room for the alias the topic is sent in full */
+  if ((alias == 0) || (alias > _max))
+    return mqtt5_publish_header(buf, size, topic, 0, payload_len);
+
+  uint16_t const bit = static_cast<uint16_t>(1U << (alias - 1));
+  if (_established & bit)
+    return mqtt5_publish_header(buf, size, "", alias, payload_len);
+
+  size_t const header_len = mqtt5_publish_header(buf, size, topic, alias, payload_len);
+  if (header_len > 0)
+    _established |= bit;
+  return header_len;
+}
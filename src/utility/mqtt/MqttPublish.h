@@ -0,0 +1,77 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_MQTT_PUBLISH_H_
+#define ARDUINO_AIOTC_UTILITY_MQTT_PUBLISH_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * FUNCTION DECLARATION
+ ******************************************************************************/
+
+/* Writes the fixed header and the topic of a QoS 0 MQTT PUBLISH packet
+ * carrying payload_len bytes, the payload is to follow right behind. Returns
+ * the length of the header or 0 if header and payload together do not fit
+ * into size bytes.
+ */
+size_t mqtt_publish_header(uint8_t * buf, size_t const size, char const * topic, size_t const payload_len);
+
+/* Same as above for MQTT 5, which adds a property section behind the topic.
+ * A non-zero alias is sent as Topic Alias property. An empty topic refers to
+ * the topic previously established for the alias.
+ */
+size_t mqtt5_publish_header(uint8_t * buf, size_t const size, char const * topic, uint16_t const alias, size_t const payload_len);
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Keeps track of the MQTT 5 topic aliases of a session. Each outgoing topic
+ * is given a fixed alias by the caller, the topic is sent once along with it
+ * and left empty in every later PUBLISH of the same session.
+ */
+class MqttTopicAliases
+{
+public:
+
+  static uint16_t const MAX_ALIASES = 8;
+
+  MqttTopicAliases();
+
+  /* To be called on connect with the Topic Alias Maximum of the CONNACK, 0
+   * if the broker did not send one and aliases must not be used.
+   */
+  void reset(uint16_t const max);
+  /* To be called once the topic of an alias has changed */
+  void forget(uint16_t const alias);
+
+  /* Writes the header of a PUBLISH of topic under alias, see mqtt5_publish_header */
+  size_t header(uint8_t * buf, size_t const size, char const * topic, uint16_t const alias, size_t const payload_len);
+
+private:
+
+  uint16_t _max;
+  uint16_t _established;
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_MQTT_PUBLISH_H_ */
@@ -0,0 +1,109 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "MqttTopics.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t const MqttTopics::MAX_ID_LENGTH;
+size_t const MqttTopics::MAX_TOPIC_LENGTH;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+MqttTopics::MqttTopics()
+{
+  for (size_t i = 0; i < SLOT_CNT; i++)
+    _topics[i][0] = '\0';
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool MqttTopics::setDeviceId(String const & device_id)
+{
+  bool is_formatted = format(_topics[DeviceOut], "/a/d/", device_id, "/e/o");
+  is_formatted = format(_topics[DeviceIn], "/a/d/", device_id, "/e/i") && is_formatted;
+  return is_formatted;
+}
+
+bool MqttTopics::setThingId(String const & thing_id)
+{
+  bool is_formatted = format(_topics[ShadowOut], "/a/t/", thing_id, "/shadow/o");
+  is_formatted = format(_topics[ShadowIn], "/a/t/", thing_id, "/shadow/i") && is_formatted;
+  is_formatted = format(_topics[DataOut],  "/a/t/", thing_id, "/e/o")      && is_formatted;
+  is_formatted = format(_topics[DataIn],   "/a/t/", thing_id, "/e/i")      && is_formatted;
+  return is_formatted;
+}
+
+bool MqttTopics::isThingId(String const & thing_id) const
+{
+  char const * const shadow_out = _topics[ShadowOut];
+  size_t const id_len = thing_id.length();
+  if (id_len == 0)
+    return shadow_out[0] == '\0';
+
+  /* The slot spans the longest id, none of these read past it */
+  return (id_len <= MAX_ID_LENGTH) &&
+         (strncmp(shadow_out, "/a/t/", 5) == 0) &&
+         (memcmp(shadow_out + 5, thing_id.c_str(), id_len) == 0) &&
+         (strcmp(shadow_out + 5 + id_len, "/shadow/o") == 0);
+}
+
+void MqttTopics::retireThing()
+{
+  memcpy(_topics[RetiredShadowIn], _topics[ShadowIn], sizeof(_topics[ShadowIn]));
+  memcpy(_topics[RetiredDataIn], _topics[DataIn], sizeof(_topics[DataIn]));
+}
+
+void MqttTopics::clearRetiredThing()
+{
+  _topics[RetiredShadowIn][0] = '\0';
+  _topics[RetiredDataIn][0] = '\0';
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool MqttTopics::format(char * topic, char const * prefix, String const & id, char const * suffix)
+{
+  size_t const prefix_len = strlen(prefix);
+  size_t const id_len = id.length();
+  size_t const suffix_len = strlen(suffix);
+
+  topic[0] = '\0';
+  if (id_len == 0)
+    return true;
+  if ((id_len > MAX_ID_LENGTH) || ((prefix_len + id_len + suffix_len) > MAX_TOPIC_LENGTH))
+    return false;
+
+  memcpy(topic, prefix, prefix_len);
+  memcpy(topic + prefix_len, id.c_str(), id_len);
+  memcpy(topic + prefix_len + id_len, suffix, suffix_len + 1);
+  return true;
+}
@@ -0,0 +1,85 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_MQTT_TOPICS_H_
+#define ARDUINO_AIOTC_UTILITY_MQTT_TOPICS_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* The topics of the device and of its thing, formatted into the fixed slots
+ * of a single buffer whenever one of the ids changes. A slot keeps its
+ * address, a message queued for a topic is therefore sent to the topic of
+ * the current thing.
+ */
+class MqttTopics
+{
+public:
+
+  /* The ids are UUIDs, which leaves room for a few more characters */
+  static size_t const MAX_ID_LENGTH = 39;
+
+  MqttTopics();
+
+  /* An id which does not fit clears the topics and returns false */
+  bool setDeviceId(String const & device_id);
+  /* The thing topics are empty as long as the thing id is */
+  bool setThingId(String const & thing_id);
+  bool isThingId(String const & thing_id) const;
+
+  /* Keeps the inbound topics of the current thing, which are to be
+   * unsubscribed once the device is attached to the next one.
+   */
+  void retireThing();
+  void clearRetiredThing();
+  inline bool hasRetiredThing() const { return _topics[RetiredShadowIn][0] != '\0'; }
+
+  inline char const * deviceOut() const { return _topics[DeviceOut]; }
+  inline char const * deviceIn () const { return _topics[DeviceIn];  }
+  inline char const * shadowOut() const { return _topics[ShadowOut]; }
+  inline char const * shadowIn () const { return _topics[ShadowIn];  }
+  inline char const * dataOut  () const { return _topics[DataOut];   }
+  inline char const * dataIn   () const { return _topics[DataIn];    }
+  inline char const * retiredShadowIn() const { return _topics[RetiredShadowIn]; }
+  inline char const * retiredDataIn  () const { return _topics[RetiredDataIn];   }
+
+private:
+
+  enum Slot : uint8_t
+  {
+    DeviceOut, DeviceIn, ShadowOut, ShadowIn, DataOut, DataIn, RetiredShadowIn, RetiredDataIn, SLOT_CNT
+  };
+
+  /* "/a/t/" + id + "/shadow/o" is the longest of them */
+  static size_t const MAX_TOPIC_LENGTH = 5 + MAX_ID_LENGTH + 9;
+
+  char _topics[SLOT_CNT][MAX_TOPIC_LENGTH + 1];
+
+  static bool format(char * topic, char const * prefix, String const & id, char const * suffix);
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_MQTT_TOPICS_H_ */
@@ -0,0 +1,105 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "TopicRouter.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+uint8_t const TopicRouter::NONE;
+size_t const TopicRouter::MAX_TOPICS;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+TopicRouter::TopicRouter()
+{
+  clear();
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool TopicRouter::add(uint8_t const id, char const * topic)
+{
+  if (id == NONE)
+    return false;
+
+  remove(id);
+  for (Route & route : _routes)
+  {
+    if (route.id != NONE)
+      continue;
+    route.id = id;
+    route.len = strlen(topic);
+    route.hash = hash(topic, route.len);
+    route.topic = topic;
+    return true;
+  }
+  return false;
+}
+
+void TopicRouter::remove(uint8_t const id)
+{
+  for (Route & route : _routes)
+  {
+    if (route.id == id)
+      route = Route{NONE, 0, 0, nullptr};
+  }
+}
+
+void TopicRouter::clear()
+{
+  for (Route & route : _routes)
+    route = Route{NONE, 0, 0, nullptr};
+}
+
+uint8_t TopicRouter::match(char const * topic, size_t const len) const
+{
+  uint32_t const topic_hash = hash(topic, len);
+  for (Route const & route : _routes)
+  {
+    if ((route.id != NONE) && (route.len == len) && (route.hash == topic_hash) && (memcmp(route.topic, topic, len) == 0))
+      return route.id;
+  }
+  return NONE;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+/* FNV-1a, the topics only differ in their ids which it spreads well */
+uint32_t TopicRouter::hash(char const * topic, size_t const len)
+{
+  uint32_t h = 2166136261UL;
+  for (size_t i = 0; i < len; i++)
+  {
+    h ^= static_cast<uint8_t>(topic[i]);
+    h *= 16777619UL;
+  }
+  return h;
+}
@@ -0,0 +1,73 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_TOPIC_ROUTER_H_
+#define ARDUINO_AIOTC_UTILITY_TOPIC_ROUTER_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Maps the subscribed topics to small identifiers. The length and the hash of
+ * each topic are computed once when it is added, an incoming topic is hashed
+ * in a single pass and compared in full with the matching candidate only.
+ */
+class TopicRouter
+{
+public:
+
+  static uint8_t const NONE = 0;
+  static size_t const MAX_TOPICS = 4;
+
+  TopicRouter();
+
+  /* Routes the topic to id, which replaces any topic routed to it before.
+   * The topic is referenced, it has to be added again once it changes.
+   */
+  bool add(uint8_t const id, char const * topic);
+  inline bool add(uint8_t const id, String const & topic) { return add(id, topic.c_str()); }
+  void remove(uint8_t const id);
+  void clear();
+
+  /* Returns the identifier of the topic, NONE if it is not routed */
+  uint8_t match(char const * topic, size_t const len) const;
+
+private:
+
+  struct Route
+  {
+    uint8_t id;
+    size_t len;
+    uint32_t hash;
+    char const * topic;
+  };
+
+  Route _routes[MAX_TOPICS];
+
+  static uint32_t hash(char const * topic, size_t const len);
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_TOPIC_ROUTER_H_ */
@@ -0,0 +1,120 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "BrokerEndpoints.h"
+
+#ifdef HAS_TCP
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t const BrokerEndpoints::MAX_ENDPOINTS;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+BrokerEndpoints::BrokerEndpoints()
+: _count{1}
+, _current{0}
+, _failed_cnt{0}
+, _resolver{nullptr}
+, _ttl_ms{0}
+{
+  set(_endpoints[0], "", 0);
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void BrokerEndpoints::begin(String const & host, uint16_t const port)
+{
+  set(_endpoints[0], host, port);
+  _current = 0;
+  _failed_cnt = 0;
+}
+
+bool BrokerEndpoints::add(String const & host, uint16_t const port)
+{
+  if (_count >= MAX_ENDPOINTS)
+    return false;
+  set(_endpoints[_count++], host, port);
+  return true;
+}
+
+void BrokerEndpoints::setResolver(Resolver resolver, unsigned long const ttl_ms)
+{
+  _resolver = resolver;
+  _ttl_ms = ttl_ms;
+  for (size_t i = 0; i < _count; i++)
+    _endpoints[i].is_cached = false;
+}
+
+bool BrokerEndpoints::address(IPAddress & ip, unsigned long const now)
+{
+  Endpoint & endpoint = _endpoints[_current];
+
+  if (endpoint.is_cached && ((now - endpoint.resolved_tick) >= _ttl_ms))
+    endpoint.is_cached = false;
+
+  if (!endpoint.is_cached && _resolver && (_ttl_ms > 0))
+  {
+    endpoint.is_cached = (_resolver(endpoint.host.c_str(), endpoint.ip) == 1);
+    endpoint.resolved_tick = now;
+  }
+
+  if (endpoint.is_cached)
+    ip = endpoint.ip;
+  return endpoint.is_cached;
+}
+
+void BrokerEndpoints::onConnected()
+{
+  _failed_cnt = 0;
+}
+
+bool BrokerEndpoints::onFailure()
+{
+  /* The POP may have moved to another address */
+  _endpoints[_current].is_cached = false;
+
+  _current = (_current + 1) % _count;
+  if (++_failed_cnt < _count)
+    return false;
+  _failed_cnt = 0;
+  return true;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void BrokerEndpoints::set(Endpoint & endpoint, String const & host, uint16_t const port)
+{
+  endpoint.host = host;
+  endpoint.port = port;
+  endpoint.is_cached = false;
+  endpoint.resolved_tick = 0;
+}
+
+#endif /* HAS_TCP */
@@ -0,0 +1,98 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_BROKER_ENDPOINTS_H_
+#define ARDUINO_AIOTC_UTILITY_BROKER_ENDPOINTS_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#ifdef HAS_TCP
+
+#include <Arduino.h>
+#include <Client.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* The endpoints the broker is reachable at, tried one after the other. A
+ * failed connection attempt moves on to the next endpoint right away and
+ * only once all of them failed the caller backs off. The endpoint which
+ * works is kept for the following reconnects.
+ *
+ * With a resolver given the address of an endpoint is cached for ttl_ms,
+ * so that a reconnect does not have to wait for the name to be resolved.
+ * The cached address is dropped once a connection to it fails.
+ */
+class BrokerEndpoints
+{
+public:
+
+  /* Returns 1 and the address of host, e.g. WiFi.hostByName() */
+  typedef int (*Resolver)(char const * host, IPAddress & ip);
+
+  static size_t const MAX_ENDPOINTS = AIOT_CONFIG_BROKER_ENDPOINT_CNT;
+
+  BrokerEndpoints();
+
+  /* Sets the endpoint passed to begin(), which is tried first */
+  void begin(String const & host, uint16_t const port);
+  /* Adds an alternative endpoint, false if there is no room for it */
+  bool add(String const & host, uint16_t const port);
+  void setResolver(Resolver resolver, unsigned long const ttl_ms);
+
+  inline String const & host() const { return _endpoints[_current].host; }
+  inline uint16_t       port() const { return _endpoints[_current].port; }
+  inline size_t        count() const { return _count; }
+
+  /* Address of the current endpoint, false if it has to be connected to by name */
+  bool address(IPAddress & ip, unsigned long const now);
+
+  void onConnected();
+  /* Moves on to the next endpoint. Returns true once every endpoint failed
+   * since the last connection, i.e. when it is time to back off.
+   */
+  bool onFailure();
+
+private:
+
+  struct Endpoint
+  {
+    String host;
+    uint16_t port;
+    IPAddress ip;
+    bool is_cached;
+    unsigned long resolved_tick;
+  };
+
+  Endpoint _endpoints[MAX_ENDPOINTS];
+  size_t _count;
+  size_t _current;
+  size_t _failed_cnt;
+  Resolver _resolver;
+  unsigned long _ttl_ms;
+
+  void set(Endpoint & endpoint, String const & host, uint16_t const port);
+};
+
+#endif /* HAS_TCP */
+
+#endif /* ARDUINO_AIOTC_UTILITY_BROKER_ENDPOINTS_H_ */
@@ -0,0 +1,159 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "CoalescingClient.h"
+
+#ifdef HAS_TCP
+
+#include <string.h>
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+CoalescingClient::CoalescingClient(uint8_t * buf, size_t const size)
+: _client{nullptr}
+, _buf{buf}
+, _size{size}
+, _len{0}
+, _cork_cnt{0}
+, _write_error{false}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+int CoalescingClient::uncork()
+{
+  if (_cork_cnt == 0 || --_cork_cnt > 0)
+    return 1;
+
+  bool const success = writeBuffered() && !_write_error;
+  _write_error = false;
+  return success ? 1 : 0;
+}
+
+int CoalescingClient::connect(IPAddress ip, uint16_t port)
+{
+  _len = 0;
+  return _client->connect(ip, port);
+}
+
+int CoalescingClient::connect(const char * host, uint16_t port)
+{
+  _len = 0;
+  return _client->connect(host, port);
+}
+
+size_t CoalescingClient::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t CoalescingClient::write(const uint8_t * buf, size_t size)
+{
+  if (_cork_cnt == 0)
+    return _client->write(buf, size);
+
+  /* Make room, larger data bypasses the buffer in order to keep the order */
+  if (_len + size > _size)
+  {
+    if (!writeBuffered())
+    {
+      _write_error = true;
+      return 0;
+    }
+  }
+  if (size > _size)
+  {
+    size_t const written = _client->write(buf, size);
+    if (written != size)
+      _write_error = true;
+    return written;
+  }
+
+  memcpy(_buf + _len, buf, size);
+  _len += size;
+  return size;
+}
+
+int CoalescingClient::available()
+{
+  return _client->available();
+}
+
+int CoalescingClient::read()
+{
+  return _client->read();
+}
+
+int CoalescingClient::read(uint8_t * buf, size_t size)
+{
+  return _client->read(buf, size);
+}
+
+int CoalescingClient::peek()
+{
+  return _client->peek();
+}
+
+void CoalescingClient::flush()
+{
+  writeBuffered();
+  _client->flush();
+}
+
+void CoalescingClient::stop()
+{
+  _len = 0;
+  _cork_cnt = 0;
+  _write_error = false;
+  _client->stop();
+}
+
+uint8_t CoalescingClient::connected()
+{
+  return _client->connected();
+}
+
+CoalescingClient::operator bool()
+{
+  return static_cast<bool>(*_client);
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool CoalescingClient::writeBuffered()
+{
+  if (_len == 0)
+    return true;
+
+  size_t const len = _len;
+  _len = 0;
+  return (_client->write(_buf, len) == len);
+}
+
+#endif /* HAS_TCP */
@@ -0,0 +1,82 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_COALESCING_CLIENT_H_
+#define ARDUINO_AIOTC_UTILITY_COALESCING_CLIENT_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#ifdef HAS_TCP
+
+#include <Client.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Passes everything through to the wrapped client, except for the data
+ * written between cork() and the matching uncork(). That is collected in
+ * the buffer and handed over with a single write(), so that back-to-back
+ * MQTT packets leave as one TLS record and, on WiFiNINA, one SPI transaction.
+ * Data not fitting into the buffer is written right away.
+ */
+class CoalescingClient : public Client
+{
+public:
+
+  CoalescingClient(uint8_t * buf, size_t const size);
+
+  inline void setClient(Client & client) { _client = &client; }
+
+  inline void cork() { _cork_cnt++; }
+  /* Returns 0 if writing the collected data failed */
+  int uncork();
+
+  virtual int connect(IPAddress ip, uint16_t port) override;
+  virtual int connect(const char * host, uint16_t port) override;
+  virtual size_t write(uint8_t b) override;
+  virtual size_t write(const uint8_t * buf, size_t size) override;
+  virtual int available() override;
+  virtual int read() override;
+  virtual int read(uint8_t * buf, size_t size) override;
+  virtual int peek() override;
+  virtual void flush() override;
+  virtual void stop() override;
+  virtual uint8_t connected() override;
+  virtual operator bool() override;
+
+  using Print::write;
+
+private:
+
+  Client * _client;
+  uint8_t * _buf;
+  size_t _size;
+  size_t _len;
+  unsigned int _cork_cnt;
+  bool _write_error;
+
+  bool writeBuffered();
+};
+
+#endif /* HAS_TCP */
+
+#endif /* ARDUINO_AIOTC_UTILITY_COALESCING_CLIENT_H_ */
@@ -0,0 +1,89 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "DataBudget.h"
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+DataBudget::DataBudget()
+: _bytes{0}
+, _window_ms{0}
+, _balance{0}
+, _balance_tick{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void DataBudget::begin(size_t const bytes, unsigned long const window_ms, unsigned long const now)
+{
+  _bytes = bytes;
+  _window_ms = window_ms;
+  _balance = static_cast<long>(bytes);
+  _balance_tick = now;
+}
+
+size_t DataBudget::available(unsigned long const now) const
+{
+  if (!isEnabled())
+    return SIZE_MAX;
+  long const left = balance(now);
+  return (left > 0) ? static_cast<size_t>(left) : 0;
+}
+
+unsigned long DataBudget::nextAvailableIn(size_t const bytes, unsigned long const now) const
+{
+  if (!isEnabled())
+    return 0;
+  long const wanted = static_cast<long>((bytes < _bytes) ? bytes : _bytes);
+  if (balance(now) >= wanted)
+    return 0;
+
+  /* The time since the last message at which the refill covers what is missing */
+  uint64_t const missing = static_cast<uint64_t>(wanted - _balance);
+  uint64_t const refill_ms = (missing * _window_ms + _bytes - 1) / _bytes;
+  unsigned long const elapsed = now - _balance_tick;
+  return (refill_ms > elapsed) ? static_cast<unsigned long>(refill_ms - elapsed) : 0;
+}
+
+void DataBudget::onSend(size_t const bytes, unsigned long const now)
+{
+  if (!isEnabled())
+    return;
+  _balance = balance(now) - static_cast<long>(bytes);
+  _balance_tick = now;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+long DataBudget::balance(unsigned long const now) const
+{
+  uint64_t const refill = static_cast<uint64_t>(now - _balance_tick) * _bytes / _window_ms;
+  int64_t const left = static_cast<int64_t>(_balance) + static_cast<int64_t>(refill);
+  return (left < static_cast<int64_t>(_bytes)) ? static_cast<long>(left) : static_cast<long>(_bytes);
+}
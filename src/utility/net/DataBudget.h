@@ -0,0 +1,67 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_DATA_BUDGET_H_
+#define ARDUINO_AIOTC_UTILITY_DATA_BUDGET_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* The bytes which may be sent per time window, e.g. to stay within the data
+ * plan of a SIM. The budget refills steadily over the window up to its full
+ * size, so that after a quiet while a burst of the full budget may leave at
+ * once. A message larger than what is left overdraws the budget, the
+ * following ones then wait until it has been paid back.
+ */
+class DataBudget
+{
+public:
+
+  DataBudget();
+
+  /* The budget starts out full, a window or budget of 0 lifts the limit */
+  void begin(size_t const bytes, unsigned long const window_ms, unsigned long const now);
+
+  inline bool isEnabled() const { return (_window_ms > 0) && (_bytes > 0); }
+  inline size_t bytes() const { return _bytes; }
+  inline unsigned long window() const { return _window_ms; }
+
+  size_t available(unsigned long const now) const;
+  /* 0 once 'bytes' are available, or the whole budget if it is smaller */
+  unsigned long nextAvailableIn(size_t const bytes, unsigned long const now) const;
+  void onSend(size_t const bytes, unsigned long const now);
+
+private:
+
+  size_t _bytes;
+  unsigned long _window_ms;
+  /* What was left after the last message, negative while overdrawn */
+  long _balance;
+  unsigned long _balance_tick;
+
+  long balance(unsigned long const now) const;
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_DATA_BUDGET_H_ */
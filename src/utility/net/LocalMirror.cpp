@@ -0,0 +1,299 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "LocalMirror.h"
+
+#include <string.h>
+
+#include "../../tls/utility/SHA256.h"
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+static uint8_t const FRAME_MAGIC[] = {'A', 'M'};
+static uint8_t const FRAME_VERSION = 3;
+/* Block size of SHA-256 and the HMAC pads */
+static size_t const HMAC_BLOCK_SIZE = 64;
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t const LocalMirror::HEADER_SIZE;
+size_t const LocalMirror::TAG_SIZE;
+size_t const LocalMirror::REPLY_SIZE;
+size_t const LocalMirror::MIN_KEY_SIZE;
+size_t const LocalMirror::MAX_KEY_SIZE;
+size_t const LocalMirror::MAX_PEERS;
+
+/******************************************************************************
+ * LOCAL MODULE FUNCTIONS
+ ******************************************************************************/
+
+static void write32(uint8_t * buf, uint32_t const val)
+{
+  buf[0] = static_cast<uint8_t>(val >> 24);
+  buf[1] = static_cast<uint8_t>(val >> 16);
+  buf[2] = static_cast<uint8_t>(val >> 8);
+  buf[3] = static_cast<uint8_t>(val);
+}
+
+static uint32_t read32(uint8_t const * buf)
+{
+  return (static_cast<uint32_t>(buf[0]) << 24) | (static_cast<uint32_t>(buf[1]) << 16) |
+         (static_cast<uint32_t>(buf[2]) << 8)  |  static_cast<uint32_t>(buf[3]);
+}
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+LocalMirror::LocalMirror()
+: _key{0}
+, _key_len{0}
+, _thing{0}
+, _sender{0}
+, _epoch{0}
+, _sequence{0}
+, _challenge_cnt{0}
+, _peer_cnt{0}
+, _heard{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool LocalMirror::begin(char const * device_id, uint8_t const * key, size_t const key_len)
+{
+  if ((key == nullptr) || (key_len < MIN_KEY_SIZE) || (key_len > MAX_KEY_SIZE))
+    return false;
+
+  memcpy(_key, key, key_len);
+  _key_len = key_len;
+  _sender = hash(device_id);
+  _thing = 0;
+  _peer_cnt = 0;
+  _heard = 0;
+  return true;
+}
+
+void LocalMirror::setThing(char const * thing_id, uint32_t const epoch)
+{
+  /* The state of the peers belongs to the thing before, the challenges
+   * pending are answered to the epoch before.
+   */
+  _thing = (*thing_id != '\0') ? hash(thing_id) : 0;
+  _epoch = (epoch != _epoch) ? epoch : (epoch + 1);
+  _sequence = 0;
+  _peer_cnt = 0;
+}
+
+void LocalMirror::header(uint8_t buf[HEADER_SIZE])
+{
+  /* The peers learn the next epoch by the handshake, none is left behind */
+  if (++_sequence == 0)
+  {
+    _epoch++;
+    _sequence = 1;
+  }
+  frame(buf, Type::Data, _sequence);
+}
+
+void LocalMirror::tag(uint8_t const header[HEADER_SIZE], uint8_t const * payload, size_t const length, uint8_t buf[TAG_SIZE]) const
+{
+  /* HMAC-SHA256 (RFC 2104), the key is never longer than a block */
+  uint8_t pad[HMAC_BLOCK_SIZE];
+  uint8_t hash[SHA256::HASH_SIZE];
+  SHA256 sha256;
+
+  for (size_t i = 0; i < HMAC_BLOCK_SIZE; i++)
+    pad[i] = ((i < _key_len) ? _key[i] : 0) ^ 0x36;
+  sha256.begin();
+  sha256.update(pad, sizeof(pad));
+  sha256.update(header, HEADER_SIZE);
+  sha256.update(payload, length);
+  sha256.finalize(hash);
+
+  for (size_t i = 0; i < HMAC_BLOCK_SIZE; i++)
+    pad[i] = ((i < _key_len) ? _key[i] : 0) ^ 0x5C;
+  sha256.begin();
+  sha256.update(pad, sizeof(pad));
+  sha256.update(hash, sizeof(hash));
+  sha256.finalize(hash);
+
+  memcpy(buf, hash, TAG_SIZE);
+}
+
+uint8_t const * LocalMirror::accept(uint8_t const * frame, size_t const length, size_t & message_length, uint8_t reply[REPLY_SIZE], size_t & reply_length)
+{
+  message_length = 0;
+  reply_length = 0;
+
+  if ((_key_len == 0) || !isAttached())
+    return nullptr;
+  if ((length <= HEADER_SIZE + TAG_SIZE) || (frame[0] != FRAME_MAGIC[0]) || (frame[1] != FRAME_MAGIC[1]) || (frame[2] != FRAME_VERSION))
+    return nullptr;
+
+  Type const type = static_cast<Type>(frame[3]);
+  uint32_t const thing = read32(frame + 4);
+  uint32_t const sender = read32(frame + 8);
+  uint32_t const epoch = read32(frame + 12);
+  uint32_t const sequence = read32(frame + 16);
+  if ((thing != _thing) || (sender == _sender))
+    return nullptr;
+
+  /* Compared in constant time, the tag must not be guessed byte by byte */
+  uint8_t const * payload = frame + HEADER_SIZE;
+  size_t const payload_length = length - HEADER_SIZE - TAG_SIZE;
+  uint8_t expected[TAG_SIZE];
+  tag(frame, payload, payload_length, expected);
+  uint8_t diff = 0;
+  for (size_t i = 0; i < TAG_SIZE; i++)
+    diff |= expected[i] ^ payload[payload_length + i];
+  if (diff != 0)
+    return nullptr;
+
+  if (type == Type::Challenge)
+  {
+    /* <challenged sender>, answered by <challenger> <its epoch> <its challenge number> */
+    if ((payload_length != 4) || (read32(payload) != _sender))
+      return nullptr;
+    uint32_t const sync[] = {sender, epoch, sequence};
+    reply_length = this->reply(reply, Type::Sync, _sequence, sync, 3);
+    return nullptr;
+  }
+
+  if (type == Type::Sync)
+  {
+    if ((payload_length != 12) || (read32(payload) != _sender) || (read32(payload + 4) != _epoch))
+      return nullptr;
+    Peer * p = peer(sender, false);
+    if ((p == nullptr) || (p->challenge == 0) || (read32(payload + 8) != p->challenge))
+      return nullptr;
+    /* Data frames sent after the sync may have overtaken it */
+    if (!p->is_synced || (p->epoch != epoch) || (sequence > p->sequence))
+    {
+      p->epoch = epoch;
+      p->sequence = sequence;
+    }
+    p->is_synced = true;
+    p->challenge = 0;
+    p->heard = ++_heard;
+    return nullptr;
+  }
+
+  if (type != Type::Data)
+    return nullptr;
+
+  Peer * p = peer(sender, true);
+  p->heard = ++_heard;
+  if (p->is_synced && (p->epoch == epoch))
+  {
+    if (sequence <= p->sequence)
+      return nullptr;
+    p->sequence = sequence;
+    message_length = payload_length;
+    return payload;
+  }
+
+  /* The same challenge is repeated until it is answered */
+  if (p->challenge == 0)
+  {
+    if (++_challenge_cnt == 0)
+      _challenge_cnt++;
+    p->challenge = _challenge_cnt;
+  }
+  uint32_t const challenge[] = {sender};
+  reply_length = this->reply(reply, Type::Challenge, p->challenge, challenge, 1);
+  return nullptr;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void LocalMirror::frame(uint8_t buf[HEADER_SIZE], Type const type, uint32_t const sequence) const
+{
+  buf[0] = FRAME_MAGIC[0];
+  buf[1] = FRAME_MAGIC[1];
+  buf[2] = FRAME_VERSION;
+  buf[3] = static_cast<uint8_t>(type);
+  write32(buf + 4, _thing);
+  write32(buf + 8, _sender);
+  write32(buf + 12, _epoch);
+  write32(buf + 16, sequence);
+}
+
+size_t LocalMirror::reply(uint8_t buf[REPLY_SIZE], Type const type, uint32_t const sequence, uint32_t const * payload, size_t const payload_cnt) const
+{
+  frame(buf, type, sequence);
+  for (size_t i = 0; i < payload_cnt; i++)
+    write32(buf + HEADER_SIZE + (i * 4), payload[i]);
+  size_t const payload_length = payload_cnt * 4;
+  tag(buf, buf + HEADER_SIZE, payload_length, buf + HEADER_SIZE + payload_length);
+  return HEADER_SIZE + payload_length + TAG_SIZE;
+}
+
+LocalMirror::Peer * LocalMirror::peer(uint32_t const sender, bool const is_added)
+{
+  for (size_t i = 0; i < _peer_cnt; i++)
+  {
+    if (_peers[i].sender == sender)
+      return &_peers[i];
+  }
+
+  if (!is_added)
+    return nullptr;
+
+  Peer * p = nullptr;
+  if (_peer_cnt < MAX_PEERS)
+  {
+    p = &_peers[_peer_cnt++];
+  }
+  else
+  {
+    p = &_peers[0];
+    for (size_t i = 1; i < _peer_cnt; i++)
+    {
+      if (static_cast<int32_t>(_peers[i].heard - p->heard) < 0)
+        p = &_peers[i];
+    }
+  }
+
+  *p = Peer{sender, 0, 0, 0, false, 0};
+  return p;
+}
+
+uint32_t LocalMirror::hash(char const * id)
+{
+  /* FNV-1a */
+  uint32_t h = 2166136261UL;
+  for (; *id != '\0'; id++)
+  {
+    h ^= static_cast<uint8_t>(*id);
+    h *= 16777619UL;
+  }
+  return h;
+}
@@ -0,0 +1,134 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_LOCAL_MIRROR_H_
+#define ARDUINO_AIOTC_UTILITY_LOCAL_MIRROR_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Frames the property updates mirrored to the peers on the LAN, each one a
+ * datagram holding the CBOR message sent to the cloud between a header and
+ * a tag:
+ *
+ *   'A' 'M' <version> <type> <thing, 4 bytes> <sender, 4 bytes>
+ *   <epoch, 4 bytes> <sequence, 4 bytes> <payload> <tag, 16 bytes>
+ *
+ * The thing is a hash of the thing id, only the frames of peers attached to
+ * the same thing are accepted. The tag is the HMAC-SHA256 of header and
+ * payload, truncated to 16 bytes, with the key provisioned for the thing,
+ * frames which do not carry a valid one are dropped before being decoded.
+ * The sender is a hash of the device id, it tells the own frames looped
+ * back by the multicast group apart.
+ *
+ * The epoch is drawn anew each time the mirror is attached to a thing, the
+ * sequence counts the frames sent within it. A data frame is only applied
+ * if it is ahead of the last one of its sender within the epoch learnt by
+ * a handshake: the frame of a sender not known, or of another epoch, is
+ * dropped and answered by a challenge, which the sender answers with a sync
+ * holding its current epoch and sequence. The challenge carries the epoch
+ * of the challenger and a number of its own, so that a sync recorded before
+ * is never taken again, hence neither is a data frame recorded before, also
+ * after a restart of either side. The first update of a peer is therefore
+ * only applied from the cloud.
+ *
+ * The state of up to MAX_PEERS senders is kept, the one heard of the longest
+ * time ago makes room for a new one, which is synchronized again once heard.
+ */
+class LocalMirror
+{
+public:
+
+  static size_t const HEADER_SIZE = 20;
+  static size_t const TAG_SIZE = 16;
+  /* The largest challenge or sync written in reply to a frame */
+  static size_t const REPLY_SIZE = HEADER_SIZE + 12 + TAG_SIZE;
+  static size_t const MIN_KEY_SIZE = 16;
+  static size_t const MAX_KEY_SIZE = 64;
+  static size_t const MAX_PEERS = AIOT_CONFIG_LOCAL_MIRROR_PEER_CNT;
+
+  LocalMirror();
+
+  /* Returns false if the key is shorter than MIN_KEY_SIZE or longer than MAX_KEY_SIZE */
+  bool begin(char const * device_id, uint8_t const * key, size_t const key_len);
+  /* Frames are only sent and accepted while attached to a thing. The epoch
+   * must not repeat one of an earlier attachment, e.g. random or the time.
+   */
+  void setThing(char const * thing_id, uint32_t const epoch);
+  inline bool isAttached() const { return _thing != 0; }
+
+  /* Writes the header of the next data frame to buf */
+  void header(uint8_t buf[HEADER_SIZE]);
+  /* Writes the tag of the frame with the given header and payload to buf */
+  void tag(uint8_t const header[HEADER_SIZE], uint8_t const * payload, size_t const length, uint8_t buf[TAG_SIZE]) const;
+  /* Returns the CBOR message of a frame to be applied, nullptr if the frame
+   * is malformed, of another thing, not authentic, our own, not ahead of
+   * the last one applied or part of the handshake. The frame to be sent to
+   * the peers in reply, if any, is written to reply, reply_length is 0
+   * otherwise.
+   */
+  uint8_t const * accept(uint8_t const * frame, size_t const length, size_t & message_length, uint8_t reply[REPLY_SIZE], size_t & reply_length);
+
+private:
+
+  enum class Type : uint8_t
+  {
+    Data      = 0,
+    Challenge = 1,
+    Sync      = 2
+  };
+
+  struct Peer
+  {
+    uint32_t sender;
+    uint32_t epoch;
+    uint32_t sequence;
+    /* The number of the challenge pending, 0 if none */
+    uint32_t challenge;
+    bool is_synced;
+    uint32_t heard;
+  };
+
+  uint8_t _key[MAX_KEY_SIZE];
+  size_t _key_len;
+  uint32_t _thing;
+  uint32_t _sender;
+  uint32_t _epoch;
+  uint32_t _sequence;
+  uint32_t _challenge_cnt;
+  Peer _peers[MAX_PEERS];
+  size_t _peer_cnt;
+  uint32_t _heard;
+
+  void frame(uint8_t buf[HEADER_SIZE], Type const type, uint32_t const sequence) const;
+  size_t reply(uint8_t buf[REPLY_SIZE], Type const type, uint32_t const sequence, uint32_t const * payload, size_t const payload_cnt) const;
+  /* Returns the state of the sender, a new one is only added if is_added */
+  Peer * peer(uint32_t const sender, bool const is_added);
+  static uint32_t hash(char const * id);
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_LOCAL_MIRROR_H_ */
@@ -0,0 +1,73 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "MessageFanout.h"
+
+#if AIOT_CONFIG_MESSAGE_SINK_CNT > 0
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t const MessageFanout::MAX_SINKS;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+MessageFanout::MessageFanout()
+: _sink{nullptr}
+, _retries{0}
+, _sink_cnt{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool MessageFanout::add(MessageSink & sink)
+{
+  if (_sink_cnt >= MAX_SINKS)
+    return false;
+
+  _sink[_sink_cnt++] = &sink;
+  return true;
+}
+
+MessageFanout::SinkMask MessageFanout::deliver(SinkMask const pending, uint8_t const * data, size_t const length, bool const is_timestamped)
+{
+  SinkMask left = 0;
+  for (size_t i = 0; i < _sink_cnt; i++)
+  {
+    SinkMask const bit = static_cast<SinkMask>(1UL << i);
+    if (!(pending & bit))
+      continue;
+    if (!_sink[i]->deliver(data, length, is_timestamped)) {
+      _retries[i]++;
+      left |= bit;
+    }
+  }
+  return left;
+}
+
+#endif /* AIOT_CONFIG_MESSAGE_SINK_CNT > 0 */
@@ -0,0 +1,90 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_MESSAGE_FANOUT_H_
+#define ARDUINO_AIOTC_UTILITY_MESSAGE_FANOUT_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if AIOT_CONFIG_MESSAGE_SINK_CNT > 0
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* A consumer of the thing updates encoded for the cloud, e.g. the peers on
+ * the LAN or a log in flash. The message is passed by reference to the slot
+ * of the outbound queue, a sink which needs it later on has to copy it.
+ */
+class MessageSink
+{
+public:
+
+  virtual ~MessageSink() { }
+
+  /* Returns false if the message can not be taken right now, it is offered
+   * again with the next flush for as long as it is queued. Samples recorded
+   * offline are timestamped, a sink which only wants live values skips them
+   * by returning true.
+   */
+  virtual bool deliver(uint8_t const * data, size_t const length, bool const is_timestamped) = 0;
+};
+
+/* Offers each message encoded once to up to MAX_SINKS sinks besides the
+ * cloud. Every queued message keeps a mask of the sinks which have not
+ * taken it yet, so a sink which is busy does not hold back the others.
+ */
+class MessageFanout
+{
+public:
+
+  typedef uint8_t SinkMask;
+
+  static size_t const MAX_SINKS = AIOT_CONFIG_MESSAGE_SINK_CNT;
+
+  MessageFanout();
+
+  /* Returns false if MAX_SINKS sinks have been added already */
+  bool add(MessageSink & sink);
+  inline size_t   size() const { return _sink_cnt; }
+  inline SinkMask all () const { return static_cast<SinkMask>((1UL << _sink_cnt) - 1); }
+
+  /* Offers the message to the sinks in 'pending' and returns those which did not take it */
+  SinkMask deliver(SinkMask const pending, uint8_t const * data, size_t const length, bool const is_timestamped);
+
+  /* Number of times a sink did not take a message when offered */
+  inline uint32_t retries(size_t const idx) const { return _retries[idx]; }
+
+private:
+
+  static_assert(MAX_SINKS <= 8 * sizeof(SinkMask), "AIOT_CONFIG_MESSAGE_SINK_CNT exceeds the sink mask");
+
+  MessageSink * _sink[MAX_SINKS];
+  uint32_t _retries[MAX_SINKS];
+  size_t _sink_cnt;
+};
+
+#endif /* AIOT_CONFIG_MESSAGE_SINK_CNT > 0 */
+
+#endif /* ARDUINO_AIOTC_UTILITY_MESSAGE_FANOUT_H_ */
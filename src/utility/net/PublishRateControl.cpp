@@ -0,0 +1,118 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "PublishRateControl.h"
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+PublishRateControl::PublishRateControl()
+: _limits{0, 0, 0, 0, 0}
+, _hold_ms{0}
+, _write_ms{0}
+, _is_signal_weak{false}
+, _has_published{false}
+, _last_publish_tick{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void PublishRateControl::begin(RateControlLimits const & limits)
+{
+  _limits = limits;
+  _hold_ms = 0;
+  _write_ms = 0;
+  _is_signal_weak = false;
+  _has_published = false;
+}
+
+void PublishRateControl::onWrite(unsigned long const duration_ms)
+{
+  _write_ms = _write_ms - (_write_ms / 8) + (duration_ms / 8);
+  if (duration_ms > _limits.slow_write_ms)
+    widen();
+  else if (_write_ms <= _limits.slow_write_ms)
+    narrow();
+}
+
+void PublishRateControl::onWriteFailed()
+{
+  widen();
+}
+
+void PublishRateControl::onRetransmit()
+{
+  widen();
+}
+
+void PublishRateControl::onSignalStrength(int const dbm)
+{
+  _is_signal_weak = (dbm < _limits.weak_signal_dbm);
+}
+
+void PublishRateControl::onPublish(unsigned long const now)
+{
+  _has_published = true;
+  _last_publish_tick = now;
+}
+
+unsigned long PublishRateControl::hold() const
+{
+  if (_is_signal_weak && (_limits.weak_signal_hold_ms > _hold_ms))
+    return _limits.weak_signal_hold_ms;
+  return _hold_ms;
+}
+
+bool PublishRateControl::isDue(unsigned long const now) const
+{
+  return nextDueIn(now) == 0;
+}
+
+unsigned long PublishRateControl::nextDueIn(unsigned long const now) const
+{
+  unsigned long const hold_ms = hold();
+  if (!_has_published || (hold_ms == 0))
+    return 0;
+  unsigned long const elapsed = now - _last_publish_tick;
+  return (elapsed < hold_ms) ? (hold_ms - elapsed) : 0;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void PublishRateControl::widen()
+{
+  unsigned long const hold_ms = (_hold_ms < _limits.min_hold_ms) ? _limits.min_hold_ms : (2 * _hold_ms);
+  _hold_ms = (hold_ms < _limits.max_hold_ms) ? hold_ms : _limits.max_hold_ms;
+}
+
+void PublishRateControl::narrow()
+{
+  _hold_ms /= 2;
+  if (_hold_ms < _limits.min_hold_ms)
+    _hold_ms = 0;
+}
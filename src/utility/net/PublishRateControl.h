@@ -0,0 +1,90 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_PUBLISH_RATE_CONTROL_H_
+#define ARDUINO_AIOTC_UTILITY_PUBLISH_RATE_CONTROL_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stdint.h>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+struct RateControlLimits
+{
+  /* A write taking longer is taken for a congested link */
+  unsigned long slow_write_ms;
+  /* First hold time after the link turned bad and the longest one */
+  unsigned long min_hold_ms;
+  unsigned long max_hold_ms;
+  /* A signal weaker keeps at least the weak signal hold time */
+  int weak_signal_dbm;
+  unsigned long weak_signal_hold_ms;
+};
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* How long to hold the thing updates after a message has been sent, so that
+ * the changes made meanwhile leave together. A slow or failing write and a
+ * message to be sent again double the hold time, as a sender backs off from
+ * a congested link. Each write which is fast again, while the smoothed write
+ * time is as well, halves it until the updates are sent right away again.
+ */
+class PublishRateControl
+{
+public:
+
+  PublishRateControl();
+
+  void begin(RateControlLimits const & limits);
+
+  /* Time taken to write messages to the connection */
+  void onWrite(unsigned long const duration_ms);
+  void onWriteFailed();
+  /* Messages sent before are replayed after the connection was lost */
+  void onRetransmit();
+  void onSignalStrength(int const dbm);
+  void onPublish(unsigned long const now);
+
+  unsigned long hold() const;
+  bool isDue(unsigned long const now) const;
+  /* 0 once the hold time has passed */
+  unsigned long nextDueIn(unsigned long const now) const;
+
+  inline unsigned long writeTime() const { return _write_ms; }
+
+private:
+
+  RateControlLimits _limits;
+  unsigned long _hold_ms;
+  /* Smoothed over the last writes, as TCP does with the round trip time */
+  unsigned long _write_ms;
+  bool _is_signal_weak;
+  bool _has_published;
+  unsigned long _last_publish_tick;
+
+  void widen();
+  void narrow();
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_PUBLISH_RATE_CONTROL_H_ */
@@ -0,0 +1,66 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "TransmitWindow.h"
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+TransmitWindow::TransmitWindow()
+: _cycle_ms{0}
+, _window_ms{0}
+, _start_tick{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void TransmitWindow::begin(unsigned long const cycle_ms, unsigned long const window_ms, unsigned long const now)
+{
+  _cycle_ms = cycle_ms;
+  _window_ms = (window_ms < cycle_ms) ? window_ms : cycle_ms;
+  _start_tick = now;
+}
+
+void TransmitWindow::align(unsigned long const now)
+{
+  if (isEnabled() && !isOpen(now))
+    _start_tick = now;
+}
+
+bool TransmitWindow::isOpen(unsigned long const now) const
+{
+  return !isEnabled() || (phase(now) < _window_ms);
+}
+
+unsigned long TransmitWindow::nextOpenIn(unsigned long const now) const
+{
+  return isOpen(now) ? 0 : nextCycleIn(now);
+}
+
+unsigned long TransmitWindow::nextCycleIn(unsigned long const now) const
+{
+  return isEnabled() ? (_cycle_ms - phase(now)) : 0;
+}
@@ -0,0 +1,65 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_TRANSMIT_WINDOW_H_
+#define ARDUINO_AIOTC_UTILITY_TRANSMIT_WINDOW_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* The windows in which a modem saving power in cycles is awake anyway, e.g.
+ * the paging time window of an eDRX cycle. A window opens every cycle and
+ * stays open for its length. Data received while the windows are thought
+ * to be closed shows the modem awake, the windows are aligned to it.
+ */
+class TransmitWindow
+{
+public:
+
+  TransmitWindow();
+
+  /* The first window opens at now, a cycle of 0 leaves the window open */
+  void begin(unsigned long const cycle_ms, unsigned long const window_ms, unsigned long const now);
+  void align(unsigned long const now);
+
+  inline bool isEnabled() const { return _cycle_ms > 0; }
+  inline unsigned long cycle() const { return _cycle_ms; }
+
+  bool isOpen(unsigned long const now) const;
+  /* 0 while the window is open */
+  unsigned long nextOpenIn(unsigned long const now) const;
+  /* Time until the following window opens, whether this one is open or not */
+  unsigned long nextCycleIn(unsigned long const now) const;
+
+private:
+
+  unsigned long _cycle_ms;
+  unsigned long _window_ms;
+  unsigned long _start_tick;
+
+  inline unsigned long phase(unsigned long const now) const { return (now - _start_tick) % _cycle_ms; }
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_TRANSMIT_WINDOW_H_ */
@@ -0,0 +1,154 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "DeltaPatcher.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+DeltaPatcher::DeltaPatcher(DeltaPatcherOutputFunc const output, void * ctx)
+: _output{output}
+, _ctx{ctx}
+{
+  reset(nullptr, 0);
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void DeltaPatcher::reset(uint8_t const * source, size_t const source_size)
+{
+  _source = source;
+  _source_size = source_size;
+  _state = State::Header;
+  memset(_header, 0, sizeof(_header));
+  _bytes_in_state = 0;
+  _target_size = 0;
+  _insert_len = 0;
+  _bytes_out = 0;
+}
+
+DeltaPatcher::Error DeltaPatcher::patch(uint8_t const * data, size_t const len)
+{
+  if (_state == State::Failed)
+    return Error::Operation;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    Error const err = onByte(data[i]);
+    if (err != Error::None)
+      return err;
+  }
+  return Error::None;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+DeltaPatcher::Error DeltaPatcher::onByte(uint8_t const c)
+{
+  switch (_state)
+  {
+    case State::Header:
+      _header[_bytes_in_state++] = c;
+      if (_bytes_in_state == sizeof(_header))
+      {
+        if (memcmp(_header, "ADLT", 4) != 0)
+          return fail(Error::Header);
+        _target_size = toUint32(_header + 4 + SHA256_SIZE);
+        _state = State::Operation;
+      }
+      break;
+
+    case State::Operation:
+      _bytes_in_state = 0;
+      if      (c == OP_COPY)   _state = State::CopyArgs;
+      else if (c == OP_INSERT) _state = State::InsertArgs;
+      else                     return fail(Error::Operation);
+      break;
+
+    case State::CopyArgs:
+      _args[_bytes_in_state++] = c;
+      if (_bytes_in_state == 8)
+      {
+        uint32_t const offset = toUint32(_args);
+        uint32_t const len    = toUint32(_args + 4);
+        if ((offset > _source_size) || (len > (_source_size - offset)))
+          return fail(Error::SourceRange);
+        for (uint32_t i = 0; i < len; i++)
+        {
+          Error const err = put(_source[offset + i]);
+          if (err != Error::None)
+            return err;
+        }
+        _state = State::Operation;
+      }
+      break;
+
+    case State::InsertArgs:
+      _args[_bytes_in_state++] = c;
+      if (_bytes_in_state == 4)
+      {
+        _insert_len = toUint32(_args);
+        _state = (_insert_len > 0) ? State::InsertData : State::Operation;
+      }
+      break;
+
+    case State::InsertData:
+      if (put(c) != Error::None)
+        return Error::TargetSize;
+      if (--_insert_len == 0)
+        _state = State::Operation;
+      break;
+
+    case State::Failed:
+      return Error::Operation;
+  }
+  return Error::None;
+}
+
+DeltaPatcher::Error DeltaPatcher::put(uint8_t const c)
+{
+  if (_bytes_out >= _target_size)
+    return fail(Error::TargetSize);
+  _output(c, _ctx);
+  _bytes_out++;
+  return Error::None;
+}
+
+DeltaPatcher::Error DeltaPatcher::fail(Error const err)
+{
+  _state = State::Failed;
+  return err;
+}
+
+uint32_t DeltaPatcher::toUint32(uint8_t const * data)
+{
+  return  static_cast<uint32_t>(data[0])        |
+         (static_cast<uint32_t>(data[1]) <<  8) |
+         (static_cast<uint32_t>(data[2]) << 16) |
+         (static_cast<uint32_t>(data[3]) << 24);
+}
@@ -0,0 +1,104 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_OTA_DELTA_PATCHER_H_
+#define ARDUINO_OTA_DELTA_PATCHER_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+typedef void(*DeltaPatcherOutputFunc)(uint8_t const c, void * ctx);
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Rebuilds an image from the image currently in flash and a delta produced
+ * by extras/tools/bin2delta.py. The delta consists of a header
+ *
+ *   "ADLT" | SHA256 of the source image (32 bytes) | target size (u32)
+ *
+ * followed by operations, all integers being little endian:
+ *
+ *   0x01 | offset (u32) | length (u32)   copy from the source image
+ *   0x02 | length (u32) | data           insert data
+ *
+ * The delta can be fed in pieces of any size, each byte of the rebuilt
+ * image is passed to the output function.
+ */
+class DeltaPatcher
+{
+
+public:
+
+  enum class Error
+  {
+    None, Header, Operation, SourceRange, TargetSize
+  };
+
+  static size_t const SHA256_SIZE = 32;
+
+  DeltaPatcher(DeltaPatcherOutputFunc const output, void * ctx);
+
+  void  reset(uint8_t const * source, size_t const source_size);
+  Error patch(uint8_t const * data, size_t const len);
+
+  bool            isHeaderComplete() const { return _state != State::Header; }
+  uint8_t const * sourceSHA256()     const { return _header + 4; }
+  uint32_t        targetSize()       const { return _target_size; }
+  /* To be called once the delta has been fed completely */
+  bool            isComplete()       const { return (_state == State::Operation) && (_bytes_out == _target_size); }
+
+private:
+
+  static uint8_t const OP_COPY   = 0x01;
+  static uint8_t const OP_INSERT = 0x02;
+  static size_t  const HEADER_SIZE = 4 + SHA256_SIZE + 4;
+
+  enum class State
+  {
+    Header, Operation, CopyArgs, InsertArgs, InsertData, Failed
+  };
+
+  DeltaPatcherOutputFunc const _output;
+  void * _ctx;
+  uint8_t const * _source;
+  size_t _source_size;
+  State _state;
+  uint8_t _header[HEADER_SIZE];
+  uint8_t _args[8];
+  size_t _bytes_in_state;
+  uint32_t _target_size;
+  uint32_t _insert_len;
+  uint32_t _bytes_out;
+
+  Error onByte(uint8_t const c);
+  Error put(uint8_t const c);
+  Error fail(Error const err);
+  static uint32_t toUint32(uint8_t const * data);
+
+};
+
+#endif /* ARDUINO_OTA_DELTA_PATCHER_H_ */
@@ -24,8 +24,6 @@
 
 #include "FlashSHA256.h"
 
-#include "../../tls/utility/SHA256.h"
-
 #include <Arduino_DebugUtils.h>
 
 #undef max
@@ -36,63 +34,62 @@
  * PUBLIC MEMBER FUNCTIONS
  ******************************************************************************/
 
-String FlashSHA256::calc(uint32_t const start_addr, uint32_t const max_flash_size)
+String FlashSHA256::calc(uint32_t const start_addr, uint32_t const max_flash_size, uint32_t * image_size)
 {
-  SHA256  sha256;
-  uint8_t chunk     [FLASH_READ_CHUNK_SIZE],
-          next_chunk[FLASH_READ_CHUNK_SIZE];
+  /* The flash is memory mapped, it is hashed in place without copying it. */
+  uint8_t const * const flash = reinterpret_cast<uint8_t const *>(start_addr);
+  uint32_t const bytes_read = imageSize(start_addr, max_flash_size);
+
+  FlashSHA256Task task(flash, bytes_read);
+  TaskRunner().run(task);
+
+  /* Do some debug printout. */
+  DEBUG_VERBOSE("SHA256: %d bytes read", bytes_read);
+  if (image_size)
+    *image_size = bytes_read;
+  return task.finalize();
+}
 
-  sha256.begin();
+uint32_t FlashSHA256::imageSize(uint32_t const start_addr, uint32_t const max_flash_size)
+{
+  uint8_t const * const flash = reinterpret_cast<uint8_t const *>(start_addr);
 
-  /* Read the first two chunks of flash. */
-  uint32_t flash_addr = start_addr;
+  /* Find the end of the firmware, that is the chunk preceding the first
+   * one containing only 0xFF (= flash erased), without its trailing 0xFF.
+   * Chunks still holding firmware are usually told apart by their first
+   * word already.
+   */
   uint32_t bytes_read = 0;
-  memcpy(chunk, reinterpret_cast<const void *>(flash_addr), FLASH_READ_CHUNK_SIZE);
-  flash_addr += FLASH_READ_CHUNK_SIZE;
+  for(uint32_t offset = 0; offset < max_flash_size; offset += FLASH_READ_CHUNK_SIZE)
+  {
+    if (isErased(flash + offset + FLASH_READ_CHUNK_SIZE, FLASH_READ_CHUNK_SIZE))
+      return offset + trimErased(flash + offset, FLASH_READ_CHUNK_SIZE);
+    bytes_read = offset + FLASH_READ_CHUNK_SIZE;
+  }
+  return bytes_read;
+}
 
-  for(; bytes_read < max_flash_size; flash_addr += FLASH_READ_CHUNK_SIZE)
+bool FlashSHA256::isErased(uint8_t const * data, size_t const len)
+{
+  /* data is word aligned and len a multiple of the word size */
+  uint32_t const * const words = reinterpret_cast<uint32_t const *>(data);
+  for (size_t i = 0; i < len / sizeof(uint32_t); i++)
   {
-    /* Read the next chunk of memory. */
-    memcpy(next_chunk, reinterpret_cast<const void *>(flash_addr), FLASH_READ_CHUNK_SIZE);
-
-    /* Check if the next segment is erased, that is if all bytes within
-     * a read segment are 0xFF -> then we've reached the end of the firmware.
-     */
-    bool const next_chunk_is_erased_flash = std::all_of(next_chunk,
-                                                        next_chunk+FLASH_READ_CHUNK_SIZE,
-                                                        [](uint8_t const elem) { return (elem == 0xFF); });
-    /* Determine how many bytes at the end of the current chunk are
-     * already set to 0xFF and therefore erased/non-written flash
-     * memory.
-     */
-    if (next_chunk_is_erased_flash)
-    {
-      /* Eliminate trailing 0xFF. */
-      size_t valid_bytes_in_chunk = 0;
-      for(valid_bytes_in_chunk = FLASH_READ_CHUNK_SIZE; valid_bytes_in_chunk > 0; valid_bytes_in_chunk--)
-      {
-        if (chunk[valid_bytes_in_chunk-1] != 0xFF)
-          break;
-      }
-      /* Update with the remaining bytes. */
-      sha256.update(chunk, valid_bytes_in_chunk);
-      bytes_read += valid_bytes_in_chunk;
-      break;
-    }
-
-    /* We've read a normal segment with the next segment not containing
-     * any erased elements, just update the SHA256 hash calcultion.
-     */
-    sha256.update(chunk, FLASH_READ_CHUNK_SIZE);
-    bytes_read += FLASH_READ_CHUNK_SIZE;
-
-    /* Copy next_chunk to chunk. */
-    memcpy(chunk, next_chunk, FLASH_READ_CHUNK_SIZE);
+    if (words[i] != 0xFFFFFFFF)
+      return false;
   }
+  return true;
+}
 
-  /* Retrieve the final hash string. */
-  uint8_t sha256_hash[SHA256::HASH_SIZE] = {0};
-  sha256.finalize(sha256_hash);
+size_t FlashSHA256::trimErased(uint8_t const * data, size_t len)
+{
+  for (; (len >= sizeof(uint32_t)) && isErased(data + len - sizeof(uint32_t), sizeof(uint32_t)); len -= sizeof(uint32_t)) { }
+  for (; (len > 0) && (data[len - 1] == 0xFF); len--) { }
+  return len;
+}
+
+String FlashSHA256::toString(uint8_t const * sha256_hash)
+{
   String sha256_str;
   std::for_each(sha256_hash,
                 sha256_hash + SHA256::HASH_SIZE,
@@ -102,9 +99,113 @@ String FlashSHA256::calc(uint32_t const start_addr, uint32_t const max_flash_siz
                   snprintf(buf, 4, "%02X", elem);
                   sha256_str += buf;
                 });
-  /* Do some debug printout. */
-  DEBUG_VERBOSE("SHA256: %d bytes read", bytes_read);
   return sha256_str;
 }
 
+constexpr uint32_t FlashSHA256Task::HASH_SLICE_SIZE;
+
+FlashSHA256Task::FlashSHA256Task()
+: _data{nullptr}
+, _len{0}
+, _offset{0}
+, _slice_size{HASH_SLICE_SIZE}
+{
+  _sha256.begin();
+}
+
+FlashSHA256Task::FlashSHA256Task(uint8_t const * data, uint32_t const len)
+{
+  begin(data, len);
+}
+
+void FlashSHA256Task::begin(uint8_t const * data, uint32_t const len, uint32_t const slice_size)
+{
+  _data = data;
+  _len = len;
+  _offset = 0;
+  _slice_size = slice_size;
+  _sha256.begin();
+}
+
+TaskStatus FlashSHA256Task::step()
+{
+  uint32_t const remaining = _len - _offset;
+  uint32_t const slice = (remaining < _slice_size) ? remaining : _slice_size;
+  _sha256.update(_data + _offset, slice);
+  _offset += slice;
+  return (_offset < _len) ? TaskStatus::InProgress : TaskStatus::Done;
+}
+
+String FlashSHA256Task::finalize()
+{
+  uint8_t sha256_hash[SHA256::HASH_SIZE] = {0};
+  _sha256.finalize(sha256_hash);
+  return FlashSHA256::toString(sha256_hash);
+}
+
+void FlashSHA256Stream::begin()
+{
+  _sha256.begin();
+  _next_chunk_len = 0;
+  _has_chunk = false;
+  _is_end_found = false;
+  _bytes_hashed = 0;
+}
+
+void FlashSHA256Stream::update(uint8_t const * data, size_t const len)
+{
+  for (size_t i = 0; (i < len) && !_is_end_found; i++)
+  {
+    _next_chunk[_next_chunk_len++] = data[i];
+    if (_next_chunk_len == sizeof(_next_chunk))
+      onNextChunk();
+  }
+}
+
+String FlashSHA256Stream::finalize()
+{
+  /* Once written the image is followed by erased flash */
+  if (_next_chunk_len > 0) {
+    memset(_next_chunk + _next_chunk_len, 0xFF, sizeof(_next_chunk) - _next_chunk_len);
+    _next_chunk_len = sizeof(_next_chunk);
+    onNextChunk();
+  }
+  if (!_is_end_found) {
+    memset(_next_chunk, 0xFF, sizeof(_next_chunk));
+    _next_chunk_len = sizeof(_next_chunk);
+    onNextChunk();
+  }
+
+  uint8_t sha256_hash[SHA256::HASH_SIZE] = {0};
+  _sha256.finalize(sha256_hash);
+  return FlashSHA256::toString(sha256_hash);
+}
+
+void FlashSHA256Stream::onNextChunk()
+{
+  _next_chunk_len = 0;
+
+  if (!_has_chunk) {
+    memcpy(_chunk, _next_chunk, sizeof(_chunk));
+    _has_chunk = true;
+    return;
+  }
+
+  /* Same as FlashSHA256::calc: the image ends with the chunk preceding
+   * the first erased one, without its trailing 0xFF.
+   */
+  if (FlashSHA256::isErased(_next_chunk, sizeof(_next_chunk)))
+  {
+    size_t const valid_bytes_in_chunk = FlashSHA256::trimErased(_chunk, sizeof(_chunk));
+    _sha256.update(_chunk, valid_bytes_in_chunk);
+    _bytes_hashed += valid_bytes_in_chunk;
+    _is_end_found = true;
+    return;
+  }
+
+  _sha256.update(_chunk, sizeof(_chunk));
+  _bytes_hashed += sizeof(_chunk);
+  memcpy(_chunk, _next_chunk, sizeof(_chunk));
+}
+
 #endif /* OTA_ENABLED */
@@ -27,6 +27,9 @@
 
 #include <Arduino.h>
 
+#include "../../tls/utility/SHA256.h"
+#include "../task/CooperativeTask.h"
+
 /******************************************************************************
  * CLASS DECLARATION
  ******************************************************************************/
@@ -35,14 +38,75 @@ class FlashSHA256
 {
 public:
 
-   static String calc(uint32_t const start_addr, uint32_t const max_flash_size);
+   static String calc(uint32_t const start_addr, uint32_t const max_flash_size, uint32_t * image_size = nullptr);
+   /* Size of the firmware hashed by calc, the flash up to the first erased chunk */
+   static uint32_t imageSize(uint32_t const start_addr, uint32_t const max_flash_size);
+   static String toString(uint8_t const * sha256_hash);
+
+   /* Helpers to detect erased flash (0xFF), data has to be word aligned */
+   static bool   isErased(uint8_t const * data, size_t const len);
+   static size_t trimErased(uint8_t const * data, size_t len);
+
+   static constexpr uint32_t FLASH_READ_CHUNK_SIZE = 64;
 
 private:
 
   FlashSHA256() { }
   FlashSHA256(FlashSHA256 const &) { }
 
-  static constexpr uint32_t FLASH_READ_CHUNK_SIZE = 64;
+};
+
+/* Hashes memory mapped flash in slices of HASH_SLICE_SIZE per step, e.g. for
+ * FlashSHA256::calc feeding the watchdog in between. Smaller slices keep
+ * each step short enough to hash between two calls to update().
+ */
+class FlashSHA256Task : public CooperativeTask
+{
+public:
+
+  FlashSHA256Task();
+  FlashSHA256Task(uint8_t const * data, uint32_t const len);
+
+  void begin(uint8_t const * data, uint32_t const len, uint32_t const slice_size = HASH_SLICE_SIZE);
+  virtual TaskStatus step() override;
+  String finalize();
+
+  static constexpr uint32_t HASH_SLICE_SIZE = 32 * 1024;
+
+private:
+
+  SHA256          _sha256;
+  uint8_t const * _data;
+  uint32_t        _len;
+  uint32_t        _offset;
+  uint32_t        _slice_size;
+
+};
+
+/* Computes the same hash as FlashSHA256::calc over an image while it is
+ * received, that is before it is written to flash. The image is assumed to
+ * be followed by erased flash once written.
+ */
+class FlashSHA256Stream
+{
+public:
+
+  void   begin();
+  void   update(uint8_t const * data, size_t const len);
+  String finalize();
+  uint32_t size() const { return _bytes_hashed; }
+
+private:
+
+  SHA256   _sha256;
+  alignas(4) uint8_t _chunk     [FlashSHA256::FLASH_READ_CHUNK_SIZE];
+  alignas(4) uint8_t _next_chunk[FlashSHA256::FLASH_READ_CHUNK_SIZE];
+  size_t   _next_chunk_len;
+  bool     _has_chunk;
+  bool     _is_end_found;
+  uint32_t _bytes_hashed;
+
+  void onNextChunk();
 
 };
 
@@ -0,0 +1,116 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "LZSSDecoder.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+LZSSDecoder::LZSSDecoder(LZSSDecoderOutputFunc const output, void * ctx)
+: _output{output}
+, _ctx{ctx}
+{
+  reset();
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void LZSSDecoder::reset()
+{
+  /* The encoder assumes the window to be filled with spaces initially */
+  memset(_window, ' ', N - F);
+  _r = N - F;
+  _state = State::Flag;
+  _value = 0;
+  _value_bit_cnt = 0;
+  _match_offset = 0;
+}
+
+void LZSSDecoder::decode(uint8_t const * data, size_t const len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    for (uint8_t mask = 0x80; mask != 0; mask >>= 1)
+    {
+      _value = (_value << 1) | ((data[i] & mask) ? 1 : 0);
+      if (++_value_bit_cnt < bitsFor(_state))
+        continue;
+
+      onValue(_value);
+      _value = 0;
+      _value_bit_cnt = 0;
+    }
+  }
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void LZSSDecoder::put(uint8_t const c)
+{
+  _output(c, _ctx);
+  _window[_r++] = c;
+  _r &= (N - 1);
+}
+
+void LZSSDecoder::onValue(int const value)
+{
+  switch (_state)
+  {
+    case State::Flag:
+      _state = value ? State::Literal : State::MatchOffset;
+      break;
+
+    case State::Literal:
+      put(static_cast<uint8_t>(value));
+      _state = State::Flag;
+      break;
+
+    case State::MatchOffset:
+      _match_offset = value;
+      _state = State::MatchLength;
+      break;
+
+    case State::MatchLength:
+      for (int k = 0; k <= value + 1; k++)
+        put(_window[(_match_offset + k) & (N - 1)]);
+      _state = State::Flag;
+      break;
+  }
+}
+
+int LZSSDecoder::bitsFor(State const state)
+{
+  switch (state)
+  {
+    case State::Literal:     return 8;
+    case State::MatchOffset: return EI;
+    case State::MatchLength: return EJ;
+    case State::Flag:
+    default:                 return 1;
+  }
+}
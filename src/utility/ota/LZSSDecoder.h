@@ -0,0 +1,79 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_OTA_LZSS_DECODER_H_
+#define ARDUINO_OTA_LZSS_DECODER_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+typedef void(*LZSSDecoderOutputFunc)(uint8_t const c, void * ctx);
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Streaming decoder for the LZSS format produced by extras/tools/lzss.c, the
+ * compressed data can be fed in pieces of any size as it is received, each
+ * decoded byte is passed to the output function.
+ */
+class LZSSDecoder
+{
+
+public:
+
+  LZSSDecoder(LZSSDecoderOutputFunc const output, void * ctx);
+
+  void reset();
+  void decode(uint8_t const * data, size_t const len);
+
+private:
+
+  static int const EI = 11;          /* Bits of a match offset */
+  static int const EJ = 4;           /* Bits of a match length */
+  static int const N  = (1 << EI);   /* Size of the sliding window */
+  static int const F  = (1 << EJ) + 1;
+
+  enum class State
+  {
+    Flag, Literal, MatchOffset, MatchLength
+  };
+
+  LZSSDecoderOutputFunc const _output;
+  void * _ctx;
+  uint8_t _window[N];
+  int _r;
+  State _state;
+  int _value;
+  int _value_bit_cnt;
+  int _match_offset;
+
+  void put(uint8_t const c);
+  void onValue(int const value);
+  static int bitsFor(State const state);
+
+};
+
+#endif /* ARDUINO_OTA_LZSS_DECODER_H_ */
@@ -27,9 +27,361 @@
 #include <Arduino_DebugUtils.h>
 #include <Arduino_ESP32_OTA.h>
 #include "tls/utility/SHA256.h"
+#include "../memory/ScratchPool.h"
 
 #include <esp_ota_ops.h>
 
+#ifdef HAS_ESP32_OTA_ASYNC
+#  include <WiFiClientSecure.h>
+#  include <Preferences.h>
+#  include <esp_idf_version.h>
+#  include "utility/ota/FlashSHA256.h"
+#  include "utility/ota/LZSSDecoder.h"
+#  include "utility/url/URLParser.h"
+#  include "tls/AIoTCOTACert.h"
+#  include "../watchdog/Watchdog.h"
+#  include <algorithm>
+#endif
+
+#ifdef HAS_ESP32_OTA_ASYNC
+
+/******************************************************************************
+ * LOCAL MODULE VARIABLES
+ ******************************************************************************/
+
+enum class OTADownloadState
+{
+  Idle,
+  ReceiveHeader,
+  ReceiveData
+};
+
+/* Header prepended to the image by extras/tools/bin2ota.py */
+union OTAHeader
+{
+  struct
+  {
+    uint32_t len;
+    uint32_t crc32;
+    uint32_t magic_number;
+    uint8_t  version[8];
+  } header;
+  uint8_t buf[20];
+};
+
+static uint8_t const OTA_VERSION_FLAG_COMPRESSED = 0x40;
+
+/* The SHA256 of an image installed by OTA, valid for the application whose
+ * ELF SHA256 it names. It spares reading the application back at boot.
+ */
+struct OTASHA256Cache
+{
+  uint32_t magic_number;
+  uint32_t image_size;
+  uint8_t  elf_sha256[32];
+  char     sha256[SHA256::HASH_SIZE * 2 + 1];
+};
+
+static uint32_t const OTA_SHA256_CACHE_MAGIC_NUMBER = 0x53484132;
+static char const OTA_SHA256_CACHE_NAMESPACE[] = "aiotc_ota";
+static char const OTA_SHA256_CACHE_KEY[]       = "sha256";
+
+static void esp32_onOTADecoded(uint8_t const c, void * ctx);
+
+static OTADownloadState ota_state = OTADownloadState::Idle;
+static WiFiClient * ota_client = nullptr;
+static String ota_http_header;
+static unsigned long ota_state_start_tick = 0;
+static uint32_t ota_content_length = 0;
+static uint32_t ota_bytes_received = 0;
+static OTAHeader ota_header;
+static size_t ota_header_len = 0;
+static uint32_t ota_crc32 = 0xFFFFFFFF;
+static LZSSDecoder ota_decoder(esp32_onOTADecoded, nullptr);
+static SHA256 ota_sha256;
+static uint32_t ota_image_size = 0;
+static esp_partition_t const * ota_partition = nullptr;
+static esp_ota_handle_t ota_handle = 0;
+/* The image is written a flash sector at a time, the sectors are erased
+ * right before they are written instead of the whole partition up front.
+ */
+static ScratchLease ota_write_buf;
+static size_t ota_write_buf_len = 0;
+static bool ota_is_write_error = false;
+static OTAMetrics ota_metrics = {0, 0, 0, 0, 0, 0, 0};
+static uint32_t ota_flash_write_us = 0;
+/* The roots the storage server is verified against, the one of the OTA
+ * storage followed by the one set for MQTT, if any.
+ */
+static String ota_ca_cert(AIoTOTACert);
+
+/******************************************************************************
+ * LOCAL MODULE FUNCTIONS
+ ******************************************************************************/
+
+static uint32_t esp32_crc32(uint32_t crc, uint8_t const * data, size_t const len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return crc;
+}
+
+static bool esp32_flushOTAWriteBuffer()
+{
+  if (ota_write_buf_len == 0)
+    return !ota_is_write_error;
+  unsigned long const start = micros();
+  if (esp_ota_write(ota_handle, ota_write_buf.data(), ota_write_buf_len) != ESP_OK)
+    ota_is_write_error = true;
+  ota_flash_write_us += micros() - start;
+  ota_write_buf_len = 0;
+  return !ota_is_write_error;
+}
+
+static void esp32_onOTADecoded(uint8_t const c, void * /* ctx */)
+{
+  ota_sha256.update(&c, 1);
+  ota_image_size++;
+  ota_write_buf.data()[ota_write_buf_len++] = c;
+  if (ota_write_buf_len == SPI_FLASH_SEC_SIZE)
+    esp32_flushOTAWriteBuffer();
+}
+
+static void esp32_closeOTAClient()
+{
+  if (ota_client) {
+    ota_client->stop();
+    delete ota_client;
+    ota_client = nullptr;
+  }
+}
+
+static int esp32_abortOTA(OTAError const err)
+{
+  if (ota_state == OTADownloadState::ReceiveHeader)
+    ota_metrics.header_ms += millis() - ota_state_start_tick;
+  else if (ota_state == OTADownloadState::ReceiveData)
+    ota_metrics.download_ms += millis() - ota_state_start_tick;
+
+  esp32_closeOTAClient();
+  /* The running application stays the boot partition */
+  if (ota_handle) {
+    esp_ota_abort(ota_handle);
+    ota_handle = 0;
+  }
+  ota_write_buf.release();
+  ota_state = OTADownloadState::Idle;
+  return static_cast<int>(err);
+}
+
+static uint8_t const * esp32_getRunningELFSHA256()
+{
+#if ESP_IDF_VERSION_MAJOR >= 5
+  return esp_app_get_description()->app_elf_sha256;
+#else
+  return esp_ota_get_app_description()->app_elf_sha256;
+#endif
+}
+
+static bool esp32_readOTASHA256Cache(String & sha256)
+{
+  OTASHA256Cache cache;
+  Preferences preferences;
+  if (!preferences.begin(OTA_SHA256_CACHE_NAMESPACE, true))
+    return false;
+  size_t const bytes_read = preferences.getBytes(OTA_SHA256_CACHE_KEY, &cache, sizeof(cache));
+  preferences.end();
+
+  if ((bytes_read != sizeof(cache)) ||
+      (cache.magic_number != OTA_SHA256_CACHE_MAGIC_NUMBER) ||
+      (cache.image_size != ESP.getSketchSize()) ||
+      (memcmp(cache.elf_sha256, esp32_getRunningELFSHA256(), sizeof(cache.elf_sha256)) != 0))
+    return false;
+
+  cache.sha256[sizeof(cache.sha256) - 1] = '\0';
+  sha256 = cache.sha256;
+  return true;
+}
+
+static bool esp32_writeOTASHA256Cache(esp_partition_t const * partition, uint32_t const image_size, String const & sha256)
+{
+  esp_app_desc_t desc;
+  if (esp_ota_get_partition_description(partition, &desc) != ESP_OK)
+    return false;
+
+  OTASHA256Cache cache;
+  cache.magic_number = OTA_SHA256_CACHE_MAGIC_NUMBER;
+  cache.image_size   = image_size;
+  memcpy(cache.elf_sha256, desc.app_elf_sha256, sizeof(cache.elf_sha256));
+  strncpy(cache.sha256, sha256.c_str(), sizeof(cache.sha256));
+  cache.sha256[sizeof(cache.sha256) - 1] = '\0';
+
+  Preferences preferences;
+  if (!preferences.begin(OTA_SHA256_CACHE_NAMESPACE, false))
+    return false;
+  size_t const bytes_written = preferences.putBytes(OTA_SHA256_CACHE_KEY, &cache, sizeof(cache));
+  preferences.end();
+  return bytes_written == sizeof(cache);
+}
+
+static int esp32_onOTAHeader()
+{
+  /* Receive HTTP header, at most one chunk per call. */
+  if ((millis() - ota_state_start_tick) > AIOT_CONFIG_ESP32_OTA_HTTP_HEADER_RECEIVE_TIMEOUT_ms)
+  {
+    DEBUG_ERROR("%s: Error receiving HTTP header (timeout)", __FUNCTION__);
+    return esp32_abortOTA(OTAError::ESP32_HttpHeaderError);
+  }
+
+  bool is_header_complete = false;
+  for (size_t i = 0; (i < AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE) && !is_header_complete && ota_client->available(); i++)
+  {
+    ota_http_header += static_cast<char>(ota_client->read());
+    is_header_complete = ota_http_header.endsWith("\r\n\r\n");
+  }
+
+  if (!is_header_complete)
+    return static_cast<int>(OTAError::None);
+
+  ota_metrics.header_ms += millis() - ota_state_start_tick;
+
+  /* The status line looks like "HTTP/1.1 200 OK" */
+  int http_status = 0;
+  char const * status_ptr = strchr(ota_http_header.c_str(), ' ');
+  if (status_ptr)
+    http_status = atoi(status_ptr + 1);
+  if (http_status != 200)
+  {
+    DEBUG_ERROR("%s: OTA storage server replied with HTTP %d", __FUNCTION__, http_status);
+    return esp32_abortOTA(OTAError::ESP32_HttpHeaderError);
+  }
+
+  /* A typical entry looks like "Content-Length: 123456" */
+  char const * ptr = strstr(ota_http_header.c_str(), "Content-Length");
+  if (!ptr)
+  {
+    DEBUG_ERROR("%s: Failure to extract content length from http header", __FUNCTION__);
+    return esp32_abortOTA(OTAError::ESP32_ErrorParseHttpHeader);
+  }
+  for (; (*ptr != '\0') && !isDigit(*ptr); ptr++) { }
+  ota_content_length = atoi(ptr);
+  DEBUG_VERBOSE("%s: Length of OTA binary according to HTTP header = %d bytes", __FUNCTION__, ota_content_length);
+
+  ota_http_header = "";
+  ota_state_start_tick = millis();
+  ota_state = OTADownloadState::ReceiveData;
+  return static_cast<int>(OTAError::None);
+}
+
+static int esp32_onOTAData()
+{
+  /* Receive up to AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE bytes per call, they
+   * are decompressed, hashed and written to the partition on the fly.
+   */
+  bool const is_http_data_timeout = (millis() - ota_state_start_tick) > AIOT_CONFIG_ESP32_OTA_HTTP_DATA_RECEIVE_TIMEOUT_ms;
+  bool const is_connection_lost   = !ota_client->connected() && !ota_client->available();
+  if (is_http_data_timeout || is_connection_lost)
+  {
+    DEBUG_ERROR("%s: Error receiving HTTP data %s (%d bytes received, %d expected)", __FUNCTION__, is_http_data_timeout ? "(timeout)":"", ota_bytes_received, ota_content_length);
+    return esp32_abortOTA(OTAError::ESP32_HttpDataError);
+  }
+
+  uint8_t buf[256];
+  for (size_t chunk = 0; (chunk < AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE) && (ota_bytes_received < ota_content_length);)
+  {
+    int const bytes_available = ota_client->available();
+    if (bytes_available <= 0)
+      break;
+
+    size_t const bytes_to_read = std::min(std::min(static_cast<size_t>(bytes_available), sizeof(buf)), static_cast<size_t>(ota_content_length - ota_bytes_received));
+    int const bytes_read = ota_client->read(buf, bytes_to_read);
+    if (bytes_read <= 0)
+      break;
+
+    /* The CRC covers everything following the length and CRC fields */
+    uint8_t const * data = buf;
+    size_t len = bytes_read;
+    for (; (len > 0) && (ota_header_len < sizeof(ota_header.buf)); data++, len--)
+    {
+      if (ota_header_len >= 8)
+        ota_crc32 = esp32_crc32(ota_crc32, data, 1);
+      ota_header.buf[ota_header_len++] = *data;
+    }
+    ota_crc32 = esp32_crc32(ota_crc32, data, len);
+
+    if (ota_header.header.version[7] & OTA_VERSION_FLAG_COMPRESSED)
+      ota_decoder.decode(data, len);
+    else
+      for (size_t i = 0; i < len; i++)
+        esp32_onOTADecoded(data[i], nullptr);
+
+    if (ota_is_write_error)
+    {
+      DEBUG_ERROR("%s: Writing of firmware image to flash failed", __FUNCTION__);
+      return esp32_abortOTA(OTAError::ESP32_ErrorWriteUpdate);
+    }
+
+    ota_bytes_received += bytes_read;
+    ota_metrics.bytes += bytes_read;
+    chunk += bytes_read;
+  }
+
+  if (ota_bytes_received < ota_content_length)
+    return static_cast<int>(OTAError::None);
+
+  ota_metrics.download_ms += millis() - ota_state_start_tick;
+  ota_metrics.flash_write_ms = ota_flash_write_us / 1000;
+  esp32_closeOTAClient();
+
+  if (!esp32_flushOTAWriteBuffer())
+  {
+    DEBUG_ERROR("%s: Writing of firmware image to flash failed", __FUNCTION__);
+    return esp32_abortOTA(OTAError::ESP32_ErrorWriteUpdate);
+  }
+
+  unsigned long const verify_start = millis();
+  if ((ota_header_len < sizeof(ota_header.buf)) || (ota_header.header.len != (ota_content_length - sizeof(ota_header.buf))))
+  {
+    DEBUG_ERROR("%s: OTA image length mismatch", __FUNCTION__);
+    return esp32_abortOTA(OTAError::ESP32_ErrorHeader);
+  }
+  if (~ota_crc32 != ota_header.header.crc32)
+  {
+    DEBUG_ERROR("%s: OTA image CRC mismatch", __FUNCTION__);
+    return esp32_abortOTA(OTAError::ESP32_ErrorCrc);
+  }
+
+  /* Checks the image header, segments and the appended SHA256 */
+  esp_ota_handle_t const handle = ota_handle;
+  ota_handle = 0;
+  ota_write_buf.release();
+  if ((esp_ota_end(handle) != ESP_OK) || (esp_ota_set_boot_partition(ota_partition) != ESP_OK))
+  {
+    DEBUG_ERROR("%s: OTA image rejected", __FUNCTION__);
+    return esp32_abortOTA(OTAError::ESP32_ErrorImage);
+  }
+  ota_metrics.verify_ms = millis() - verify_start;
+
+  uint8_t sha256_hash[SHA256::HASH_SIZE];
+  ota_sha256.finalize(sha256_hash);
+  String const sha256 = FlashSHA256::toString(sha256_hash);
+  if (!esp32_writeOTASHA256Cache(ota_partition, ota_image_size, sha256))
+    DEBUG_WARNING("%s: Failed to keep the SHA256 of the image", __FUNCTION__);
+  DEBUG_VERBOSE("%s: SHA256 %s of %d bytes", __FUNCTION__, sha256.c_str(), ota_image_size);
+
+  ota_state = OTADownloadState::Idle;
+
+  /* Perform the reset to reboot */
+  ESP.restart();
+  return static_cast<int>(OTAError::None);
+}
+
+#endif /* HAS_ESP32_OTA_ASYNC */
+
 /******************************************************************************
  * FUNCTION DEFINITION
  ******************************************************************************/
@@ -68,56 +420,208 @@ int esp32_onOTARequest(char const * ota_url)
   return static_cast<int>(OTAError::None);
 }
 
-String esp32_getOTAImageSHA256()
+#ifdef HAS_ESP32_OTA_ASYNC
+void esp32_setOTACACert(char const * ca_cert)
 {
-  const esp_partition_t *running = esp_ota_get_running_partition();
-  if (!running) {
-    DEBUG_ERROR("ESP32::SHA256 Running partition could not be found");
-    return String();
+  /* mbedTLS parses all the certificates of a PEM buffer */
+  ota_ca_cert = AIoTOTACert;
+  if (ca_cert)
+    ota_ca_cert += ca_cert;
+}
+
+int esp32_onOTAStart(char const * ota_url)
+{
+  watchdog_reset();
+
+  esp32_abortOTA(OTAError::None);
+  ota_content_length = 0;
+  ota_bytes_received = 0;
+  ota_header_len = 0;
+  ota_crc32 = 0xFFFFFFFF;
+  ota_decoder.reset();
+  ota_sha256.begin();
+  ota_image_size = 0;
+  ota_write_buf_len = 0;
+  ota_is_write_error = false;
+  ota_metrics = OTAMetrics{0, 0, 0, 0, 0, 0, 0};
+  ota_flash_write_us = 0;
+
+  URL url;
+  char host[256];
+  char host_header[sizeof(host) + 8];
+  if (!url_parse(ota_url, url) || !url_copy(url.host, host, sizeof(host)) ||
+      !url_host_header(url, host_header, sizeof(host_header))) {
+    DEBUG_ERROR("%s: Failed to parse OTA URL %s", __FUNCTION__, ota_url);
+    return static_cast<int>(OTAError::ESP32_UrlParseError);
+  }
+
+  ota_partition = esp_ota_get_next_update_partition(nullptr);
+  if (!ota_partition) {
+    DEBUG_ERROR("%s: No partition to update", __FUNCTION__);
+    return static_cast<int>(OTAError::ESP32_ErrorPartition);
+  }
+  if (!ota_write_buf.acquire(SPI_FLASH_SEC_SIZE, MemoryPool::Ota)) {
+    DEBUG_ERROR("%s: Not enough memory to allocate buffer", __FUNCTION__);
+    return static_cast<int>(OTAError::ESP32_ErrorNoMemory);
+  }
+  if (esp_ota_begin(ota_partition, OTA_WITH_SEQUENTIAL_WRITES, &ota_handle) != ESP_OK) {
+    DEBUG_ERROR("%s: Failed to begin update of partition %s", __FUNCTION__, ota_partition->label);
+    ota_handle = 0;
+    return esp32_abortOTA(OTAError::ESP32_ErrorPartition);
+  }
+
+  int port = 0;
+  WiFiClientSecure * tls_client = nullptr;
+  if (url_equals(url.scheme, "http")) {
+    ota_client = new WiFiClient();
+    port = 80;
+  } else if (url_equals(url.scheme, "https")) {
+    /* The handshake fails unless the server is verified */
+    tls_client = new WiFiClientSecure();
+    tls_client->setCACert(ota_ca_cert.c_str());
+    ota_client = tls_client;
+    port = 443;
+  } else {
+    DEBUG_ERROR("%s: Failed to parse OTA URL %s", __FUNCTION__, ota_url);
+    return esp32_abortOTA(OTAError::ESP32_UrlParseError);
+  }
+  if (url.port != 0)
+    port = url.port;
+
+  watchdog_reset();
+
+  unsigned long const connect_start = millis();
+  bool const is_connected = ota_client->connect(host, port);
+  ota_metrics.connect_ms = millis() - connect_start;
+  if (!is_connected)
+  {
+    char tls_error[64] = "";
+    if (tls_client)
+      tls_client->lastError(tls_error, sizeof(tls_error));
+    DEBUG_ERROR("%s: Connection failure with OTA storage server %s %s", __FUNCTION__, host, tls_error);
+    return esp32_abortOTA(OTAError::ESP32_ServerConnectError);
   }
 
-  uint8_t *b = (uint8_t*)malloc(SPI_FLASH_SEC_SIZE);
-  if(b == nullptr) {
-    DEBUG_ERROR("ESP32::SHA256 Not enough memory to allocate buffer");
-    return String();
+  watchdog_reset();
+
+  /* Send the request piece by piece instead of concatenating Strings */
+  ota_client->print("GET ");
+  if (url.path.len > 0)
+    ota_client->write(reinterpret_cast<uint8_t const *>(url.path.str), url.path.len);
+  else
+    ota_client->print("/");
+  if (url.query.len > 0) {
+    ota_client->print("?");
+    ota_client->write(reinterpret_cast<uint8_t const *>(url.query.str), url.query.len);
   }
+  ota_client->println(" HTTP/1.1");
+  ota_client->print("Host: ");
+  ota_client->println(host_header);
+  ota_client->println("Connection: close");
+  ota_client->println();
+
+  ota_http_header = "";
+  ota_state_start_tick = millis();
+  ota_state = OTADownloadState::ReceiveHeader;
+  return static_cast<int>(OTAError::None);
+}
+
+int esp32_onOTAPoll(bool & is_in_progress)
+{
+  watchdog_reset();
+
+  int err = static_cast<int>(OTAError::None);
+  if (ota_state == OTADownloadState::ReceiveHeader)
+    err = esp32_onOTAHeader();
+  else if (ota_state == OTADownloadState::ReceiveData)
+    err = esp32_onOTAData();
 
-  SHA256         sha256;
-  uint32_t const app_start = running->address;
-  uint32_t const app_size  = ESP.getSketchSize();
-  uint32_t       read_bytes = 0;
+  is_in_progress = (ota_state != OTADownloadState::Idle);
+  return err;
+}
+
+int esp32_getOTAProgress()
+{
+  if ((ota_state != OTADownloadState::ReceiveData) || (ota_content_length == 0))
+    return -1;
+  return static_cast<int>((static_cast<uint64_t>(ota_bytes_received) * 100) / ota_content_length);
+}
+
+OTAMetrics esp32_getOTAMetrics()
+{
+  return ota_metrics;
+}
+#endif /* HAS_ESP32_OTA_ASYNC */
+
+TaskStatus esp32_pollOTAImageSHA256(String & sha256)
+{
+  /* The flash is not memory mapped here, one sector is read per call */
+  static SHA256    sha256_ctx;
+  static ScratchLease b;
+  static uint32_t  app_start = 0;
+  static uint32_t  app_size = 0;
+  static uint32_t  read_bytes = 0;
+
+  if (!b)
+  {
+#ifdef HAS_ESP32_OTA_ASYNC
+    /* An image installed by OTA has been hashed while it was written */
+    if (esp32_readOTASHA256Cache(sha256))
+    {
+      DEBUG_VERBOSE("SHA256: taken from the OTA update");
+      return TaskStatus::Done;
+    }
+#endif
+
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    if (!running) {
+      DEBUG_ERROR("ESP32::SHA256 Running partition could not be found");
+      return TaskStatus::Error;
+    }
+
+    if (!b.acquire(SPI_FLASH_SEC_SIZE, MemoryPool::Ota)) {
+      DEBUG_ERROR("ESP32::SHA256 Not enough memory to allocate buffer");
+      return TaskStatus::Error;
+    }
+
+    app_start  = running->address;
+    app_size   = ESP.getSketchSize();
+    read_bytes = 0;
+    sha256_ctx.begin();
+  }
 
-  sha256.begin();
-  for(uint32_t a = app_start; read_bytes < app_size; )
+  if (read_bytes < app_size)
   {
     /* Check if we are reading last sector and compute used size */
     uint32_t const read_size = read_bytes + SPI_FLASH_SEC_SIZE < app_size ? SPI_FLASH_SEC_SIZE : app_size - read_bytes;
 
     /* Use always 4 bytes aligned reads */
-    if (!ESP.flashRead(a, reinterpret_cast<uint32_t*>(b), (read_size + 3) & ~3)) {
+    if (!ESP.flashRead(app_start + read_bytes, reinterpret_cast<uint32_t*>(b.data()), (read_size + 3) & ~3)) {
       DEBUG_ERROR("ESP32::SHA256 Could not read data from flash");
-      return String();
+      b.release();
+      return TaskStatus::Error;
     }
-    sha256.update(b, read_size);
-    a += read_size;
+    sha256_ctx.update(b.data(), read_size);
     read_bytes += read_size;
+    if (read_bytes < app_size)
+      return TaskStatus::InProgress;
   }
-  free(b);
+  b.release();
 
   /* Retrieve the final hash string. */
   uint8_t sha256_hash[SHA256::HASH_SIZE] = {0};
-  sha256.finalize(sha256_hash);
-  String sha256_str;
+  sha256_ctx.finalize(sha256_hash);
+  sha256 = "";
   std::for_each(sha256_hash,
                 sha256_hash + SHA256::HASH_SIZE,
-                [&sha256_str](uint8_t const elem)
+                [&sha256](uint8_t const elem)
                 {
                   char buf[4];
                   snprintf(buf, 4, "%02X", elem);
-                  sha256_str += buf;
+                  sha256 += buf;
                 });
   DEBUG_VERBOSE("SHA256: %d bytes (of %d) read", read_bytes, app_size);
-  return sha256_str;
+  return TaskStatus::Done;
 }
 
 bool esp32_isOTACapable()
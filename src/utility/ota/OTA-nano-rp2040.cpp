@@ -33,164 +33,696 @@
 #include "FATFileSystem.h"
 #include "FlashIAPBlockDevice.h"
 #include "utility/ota/FlashSHA256.h"
+#include "utility/ota/LZSSDecoder.h"
+#include "utility/ota/DeltaPatcher.h"
+#include "utility/url/URLParser.h"
+#include "utility/task/CooperativeTask.h"
+#include "utility/memory/ScratchPool.h"
+
+#include <algorithm>
+#include <utility>
 
 /******************************************************************************
- * FUNCTION DEFINITION
+ * CONSTANTS
  ******************************************************************************/
 
-/* Original code: http://stackoverflow.com/questions/2616011/easy-way-to-parse-a-url-in-c-cross-platform */
-#include <string>
-#include <algorithm>
-#include <cctype>
-#include <functional>
-#include <iostream>
-
-struct URI {
-  public:
-    URI(const std::string& url_s) {
-      this->parse(url_s);
-    }
-    std::string protocol_, host_, path_, query_;
-  private:
-    void parse(const std::string& url_s);
+#if AIOT_CONFIG_RP2040_OTA_STREAM_DECOMPRESSION
+/* The image is decompressed while it is received, SFU then flashes it as is */
+static char const OTA_UPDATE_FILE[]     = "/ota/UPDATE.BIN";
+#else
+static char const OTA_UPDATE_FILE[]     = "/ota/UPDATE.BIN.LZSS";
+#endif
+/* A prefetched image is kept under a name SFU ignores until it is applied */
+static char const OTA_STAGED_FILE[]     = "/ota/STAGED.BIN";
+/* Holds the url of a partially downloaded image, the file size is the offset to resume at */
+static char const OTA_CHECKPOINT_FILE[] = "/ota/UPDATE.URL";
+/* Holds the SHA256 of the application, see rp2040_connect_getOTAImageSHA256 */
+static char const OTA_SHA256_FILE[]     = "/ota/UPDATE.SHA";
+/* Holds the metrics of a completed download until reported by the new firmware */
+static char const OTA_METRICS_FILE[]    = "/ota/UPDATE.MET";
+
+/******************************************************************************
+ * LOCAL MODULE VARIABLES
+ ******************************************************************************/
+
+enum class OTADownloadState
+{
+  Idle,
+  ReceiveHeader,
+  ReceiveData
+};
+
+static OTADownloadState ota_state = OTADownloadState::Idle;
+static FlashIAPBlockDevice * ota_flash = nullptr;
+static mbed::FATFileSystem * ota_fs = nullptr;
+static FILE * ota_file = nullptr;
+static Client * ota_client = nullptr;
+static String ota_url;
+static String ota_http_header;
+static unsigned long ota_state_start_tick = 0;
+static int ota_content_length = 0;
+static int ota_bytes_received = 0;
+static unsigned int ota_resume_cnt = 0;
+/* Whether the device resets into the image once it is downloaded */
+static bool ota_is_apply = true;
+static char const * ota_file_name = OTA_UPDATE_FILE;
+static bool ota_is_staged = false;
+static String ota_staged_sha256;
+static uint32_t ota_staged_image_size = 0;
+/* The image is written in blocks matching the erase granularity of the flash.
+ * Writing stalls the whole chip, a full block is therefore set aside and
+ * written once no data is waiting to be received, meanwhile the next block
+ * is gathered in the other buffer. Both are only held during a download.
+ */
+static size_t const OTA_WRITE_BUF_SIZE = AIOT_CONFIG_RP2040_OTA_WRITE_BUFFER_SIZE;
+static size_t const OTA_FLASH_SECTOR_SIZE = 4096;
+static ScratchLease ota_write_bufs;
+static uint8_t * ota_write_buf = nullptr;
+static size_t ota_write_buf_len = 0;
+static uint8_t * ota_pending_buf = nullptr;
+static size_t ota_pending_buf_len = 0;
+
+/* Header prepended to the image by extras/tools/bin2ota.py */
+union OTAHeader
+{
+  struct
+  {
+    uint32_t len;
+    uint32_t crc32;
+    uint32_t magic_number;
+    uint8_t  version[8];
+  } header;
+  uint8_t buf[20];
+};
+
+static uint32_t const OTA_MAGIC_NUMBER           = 0x2341005E;
+static uint8_t  const OTA_VERSION_FLAG_COMPRESSED = 0x40;
+static uint8_t  const OTA_VERSION_FLAG_DELTA      = 0x20;
+
+static void rp2040_connect_onOTADecoded(uint8_t const c, void * ctx);
+static void rp2040_connect_onOTATarget(uint8_t const c, void * ctx);
+
+static OTAHeader ota_header;
+static size_t ota_header_len = 0;
+static uint32_t ota_crc32 = 0xFFFFFFFF;
+static bool ota_is_write_error = false;
+static LZSSDecoder ota_decoder(rp2040_connect_onOTADecoded, nullptr);
+/* A delta image is patched against the application in flash */
+static DeltaPatcher ota_delta(rp2040_connect_onOTATarget, nullptr);
+static bool ota_is_delta = false;
+static bool ota_is_delta_source_checked = false;
+static OTAError ota_delta_error = OTAError::None;
+/* The image is decoded while it is received in order to hash it, unless
+ * the download resumed a previous request and misses its beginning. It
+ * is then read back from the file once it is complete.
+ */
+static bool ota_is_image_tracked = false;
+static FlashSHA256Stream ota_sha256;
+/* The hash the application of the image has to match, e.g. one fetched
+ * from a mirror, none if empty.
+ */
+static String ota_expected_sha256;
+
+struct OTASHA256Cache
+{
+  uint32_t magic_number;
+  uint32_t image_size;
+  uint32_t fingerprint;
+  uint32_t is_pending;
+  char     sha256[SHA256::HASH_SIZE * 2 + 1];
 };
 
-using namespace std;
+static uint32_t const OTA_SHA256_CACHE_MAGIC_NUMBER = 0x53484132;
+
+struct OTAMetricsFile
+{
+  uint32_t   magic_number;
+  OTAMetrics metrics;
+};
+
+static uint32_t const OTA_METRICS_FILE_MAGIC_NUMBER = 0x4D455452;
+
+static OTAMetrics ota_metrics = {0, 0, 0, 0, 0, 0, 0};
+static bool ota_is_metrics_loaded = false;
+static bool ota_is_metrics_tracked = false;
+/* Phases interleaved with receiving the image are accumulated in microseconds */
+static uint32_t ota_flash_write_us = 0;
+static uint32_t ota_decode_us = 0;
+static uint32_t ota_verify_us = 0;
+
+/******************************************************************************
+ * LOCAL MODULE FUNCTIONS
+ ******************************************************************************/
+
+/* The file system erases each sector right before programming it, i.e. just
+ * ahead of the write cursor. The buffer is written one sector at a time with
+ * the watchdog fed in between, however large it has been configured.
+ */
+static bool rp2040_connect_writeOTABuffer(uint8_t const * buf, size_t const len)
+{
+  if (len == 0)
+    return true;
+  unsigned long const start = micros();
+  bool is_written = true;
+  for (size_t offset = 0; is_written && (offset < len); offset += OTA_FLASH_SECTOR_SIZE)
+  {
+    size_t const sector_len = std::min(len - offset, OTA_FLASH_SECTOR_SIZE);
+    is_written = (fwrite(buf + offset, 1, sector_len, ota_file) == sector_len);
+    watchdog_reset();
+  }
+  ota_flash_write_us += micros() - start;
+  return is_written;
+}
+
+/* Called whenever the client has no data waiting */
+static bool rp2040_connect_writePendingOTABuffer()
+{
+  size_t const len = ota_pending_buf_len;
+  ota_pending_buf_len = 0;
+  return rp2040_connect_writeOTABuffer(ota_pending_buf, len);
+}
+
+/* Sets the full write buffer aside, only if the previous one has not found
+ * a gap in the received data yet it is written right away.
+ */
+static bool rp2040_connect_swapOTAWriteBuffer()
+{
+  bool const is_written = rp2040_connect_writePendingOTABuffer();
+  std::swap(ota_write_buf, ota_pending_buf);
+  ota_pending_buf_len = ota_write_buf_len;
+  ota_write_buf_len = 0;
+  return is_written;
+}
+
+static bool rp2040_connect_flushOTAWriteBuffer()
+{
+  bool const is_pending_written = rp2040_connect_writePendingOTABuffer();
+  size_t const len = ota_write_buf_len;
+  ota_write_buf_len = 0;
+  return rp2040_connect_writeOTABuffer(ota_write_buf, len) && is_pending_written;
+}
+
+static bool rp2040_connect_acquireOTAWriteBuffers()
+{
+  if (!ota_write_bufs.acquire(2 * OTA_WRITE_BUF_SIZE, MemoryPool::Ota))
+    return false;
+  ota_write_buf = ota_write_bufs.data();
+  ota_pending_buf = ota_write_bufs.data() + OTA_WRITE_BUF_SIZE;
+  return true;
+}
+
+static void rp2040_connect_releaseOTAWriteBuffers()
+{
+  ota_write_bufs.release();
+  ota_write_buf = nullptr;
+  ota_pending_buf = nullptr;
+}
+
+static uint32_t rp2040_connect_crc32(uint32_t crc, uint8_t const * data, size_t const len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return crc;
+}
+
+static void rp2040_connect_resetOTAImage(bool const is_tracked)
+{
+  ota_header_len = 0;
+  ota_crc32 = 0xFFFFFFFF;
+  ota_is_write_error = false;
+  ota_decoder.reset();
+  ota_sha256.begin();
+  ota_is_image_tracked = is_tracked;
+  ota_delta.reset(reinterpret_cast<uint8_t const *>(XIP_BASE), 0x100000);
+  ota_is_delta = false;
+  ota_is_delta_source_checked = false;
+  ota_delta_error = OTAError::None;
+}
 
-// ctors, copy, equality, ...
-// TODO: change me into something embedded friendly (this function adds ~100KB to flash)
-void URI::parse(const string& url_s)
+static void rp2040_connect_onOTADecoded(uint8_t const c, void * /* ctx */)
 {
-  const string prot_end("://");
-  string::const_iterator prot_i = search(url_s.begin(), url_s.end(),
-      prot_end.begin(), prot_end.end());
-  protocol_.reserve(distance(url_s.begin(), prot_i));
-  transform(url_s.begin(), prot_i,
-      back_inserter(protocol_),
-      ptr_fun<int,int>(tolower)); // protocol is icase
-  if( prot_i == url_s.end() )
+  if (!ota_is_delta)
+  {
+    rp2040_connect_onOTATarget(c, nullptr);
+    return;
+  }
+
+  if (ota_delta_error != OTAError::None)
+    return;
+
+  if (ota_delta.patch(&c, 1) != DeltaPatcher::Error::None)
+  {
+    DEBUG_ERROR("%s: Invalid delta image", __FUNCTION__);
+    ota_delta_error = OTAError::RP2040_ErrorDelta;
     return;
-  advance(prot_i, prot_end.length());
-  string::const_iterator path_i = find(prot_i, url_s.end(), '/');
-  host_.reserve(distance(prot_i, path_i));
-  transform(prot_i, path_i,
-      back_inserter(host_),
-      ptr_fun<int,int>(tolower)); // host is icase
-  string::const_iterator query_i = find(path_i, url_s.end(), '?');
-  path_.assign(path_i, query_i);
-  if( query_i != url_s.end() )
-    ++query_i;
-  query_.assign(query_i, url_s.end());
+  }
+
+  /* The delta only applies to the application it was made against */
+  if (ota_delta.isHeaderComplete() && !ota_is_delta_source_checked)
+  {
+    ota_is_delta_source_checked = true;
+    unsigned long const start = micros();
+    String const source_sha256 = FlashSHA256::toString(ota_delta.sourceSHA256());
+    bool const is_source = (source_sha256 == FlashSHA256::calc(XIP_BASE, 0x100000));
+    ota_verify_us += micros() - start;
+    if (!is_source)
+    {
+      DEBUG_ERROR("%s: Delta image made against a different application %s", __FUNCTION__, source_sha256.c_str());
+      ota_delta_error = OTAError::RP2040_ErrorDeltaSource;
+    }
+  }
 }
 
-int rp2040_connect_onOTARequest(char const * ota_url)
+static void rp2040_connect_onOTATarget(uint8_t const c, void * /* ctx */)
 {
-  watchdog_reset();
+  ota_sha256.update(&c, 1);
+#if AIOT_CONFIG_RP2040_OTA_STREAM_DECOMPRESSION
+  ota_write_buf[ota_write_buf_len++] = c;
+  if (ota_write_buf_len == OTA_WRITE_BUF_SIZE)
+  {
+    if (!rp2040_connect_swapOTAWriteBuffer())
+      ota_is_write_error = true;
+  }
+#endif
+}
 
-  int err = -1;
-  FlashIAPBlockDevice flash(XIP_BASE + 0xF00000, 0x100000);
-  if ((err = flash.init()) < 0)
+static int rp2040_connect_decodeOTAData(uint8_t const * data, size_t len)
+{
+  /* The CRC covers everything following the length and CRC fields */
+  for (; (len > 0) && (ota_header_len < sizeof(ota_header.buf)); data++, len--)
   {
-    DEBUG_ERROR("%s: flash.init() failed with %d", __FUNCTION__, err);
-    return static_cast<int>(OTAError::RP2040_ErrorFlashInit);
+    if (ota_header_len >= 8)
+      ota_crc32 = rp2040_connect_crc32(ota_crc32, data, 1);
+    ota_header.buf[ota_header_len++] = *data;
+
+    if ((ota_header_len == sizeof(ota_header.buf)) && (ota_header.header.magic_number != OTA_MAGIC_NUMBER))
+    {
+      DEBUG_ERROR("%s: OTA image magic number mismatch 0x%08X", __FUNCTION__, ota_header.header.magic_number);
+      return static_cast<int>(OTAError::RP2040_ErrorHeader);
+    }
+
+    if (ota_header_len == sizeof(ota_header.buf))
+    {
+      ota_is_delta = (ota_header.header.version[7] & OTA_VERSION_FLAG_DELTA) != 0;
+#if !AIOT_CONFIG_RP2040_OTA_STREAM_DECOMPRESSION
+      /* SFU can't apply a delta, it has to be patched while downloading */
+      if (ota_is_delta)
+      {
+        DEBUG_ERROR("%s: Delta images require AIOT_CONFIG_RP2040_OTA_STREAM_DECOMPRESSION", __FUNCTION__);
+        return static_cast<int>(OTAError::RP2040_ErrorDelta);
+      }
+#endif
+    }
   }
 
-  watchdog_reset();
+  ota_crc32 = rp2040_connect_crc32(ota_crc32, data, len);
+
+  if (ota_header.header.version[7] & OTA_VERSION_FLAG_COMPRESSED)
+  {
+    ota_decoder.decode(data, len);
+  }
+  else
+  {
+    for (size_t i = 0; i < len; i++)
+      rp2040_connect_onOTADecoded(data[i], nullptr);
+  }
 
-  flash.erase(XIP_BASE + 0xF00000, 0x100000);
+  if (ota_is_write_error)
+  {
+    DEBUG_ERROR("%s: Writing of firmware image to flash failed", __FUNCTION__);
+    return static_cast<int>(OTAError::RP2040_ErrorWriteUpdateFile);
+  }
+  return static_cast<int>(ota_delta_error);
+}
 
-  watchdog_reset();
+static int rp2040_connect_processOTAData(uint8_t const * data, size_t const len)
+{
+  /* Writing and verifying may happen while decoding, they are accounted separately */
+  unsigned long const start = micros();
+  uint32_t const flash_write_us = ota_flash_write_us;
+  uint32_t const verify_us = ota_verify_us;
+  int const err = rp2040_connect_decodeOTAData(data, len);
+  ota_decode_us += (micros() - start) - (ota_flash_write_us - flash_write_us) - (ota_verify_us - verify_us);
+  return err;
+}
+
+static void rp2040_connect_updateOTAMetrics()
+{
+  ota_metrics.flash_write_ms = ota_flash_write_us / 1000;
+  ota_metrics.decode_ms      = ota_decode_us / 1000;
+  ota_metrics.verify_ms      = ota_verify_us / 1000;
+}
+
+static bool rp2040_connect_writeOTAMetrics()
+{
+  OTAMetricsFile metrics_file;
+  metrics_file.magic_number = OTA_METRICS_FILE_MAGIC_NUMBER;
+  metrics_file.metrics      = ota_metrics;
+
+  FILE * file = fopen(OTA_METRICS_FILE, "wb");
+  if (!file)
+    return false;
+  bool const is_written = (fwrite(&metrics_file, 1, sizeof(metrics_file), file) == sizeof(metrics_file));
+  fclose(file);
+  return is_written;
+}
 
+/* The metrics left behind by the download of the running firmware, reported once */
+static void rp2040_connect_readOTAMetrics()
+{
+  FlashIAPBlockDevice flash(XIP_BASE + 0xF00000, 0x100000);
   mbed::FATFileSystem fs("ota");
-  if ((err = fs.reformat(&flash)) != 0)
+  if ((flash.init() != 0) || (fs.mount(&flash) != 0))
+    return;
+
+  OTAMetricsFile metrics_file;
+  FILE * file = fopen(OTA_METRICS_FILE, "rb");
+  if (file)
   {
-     DEBUG_ERROR("%s: fs.reformat() failed with %d", __FUNCTION__, err);
-     return static_cast<int>(OTAError::RP2040_ErrorReformat);
+    bool const is_read = (fread(&metrics_file, 1, sizeof(metrics_file), file) == sizeof(metrics_file));
+    fclose(file);
+    remove(OTA_METRICS_FILE);
+    if (is_read && (metrics_file.magic_number == OTA_METRICS_FILE_MAGIC_NUMBER))
+      ota_metrics = metrics_file.metrics;
   }
+  fs.unmount();
+}
 
-  watchdog_reset();
+/* CRC32 over a few blocks spread over the application, cheap compared to hashing all of it */
+static uint32_t rp2040_connect_getImageFingerprint(uint32_t const image_size)
+{
+  uint32_t crc = rp2040_connect_crc32(0xFFFFFFFF, reinterpret_cast<uint8_t const *>(&image_size), sizeof(image_size));
+  for (uint32_t i = 0; i < 16; i++)
+  {
+    uint32_t const offset = (image_size / 16) * i;
+    uint32_t const len    = std::min(static_cast<uint32_t>(FlashSHA256::FLASH_READ_CHUNK_SIZE), image_size - offset);
+    crc = rp2040_connect_crc32(crc, reinterpret_cast<uint8_t const *>(XIP_BASE + offset), len);
+  }
+  return ~crc;
+}
+
+/* Same end of the application as found by FlashSHA256::calc */
+static bool rp2040_connect_isImageSize(uint32_t const image_size)
+{
+  if ((image_size == 0) || (image_size >= 0x100000))
+    return false;
 
-  FILE * file = fopen("/ota/UPDATE.BIN.LZSS", "wb");
+  uint8_t const * image = reinterpret_cast<uint8_t const *>(XIP_BASE);
+  if (image[image_size - 1] == 0xFF)
+    return false;
+
+  uint32_t const chunk_size = FlashSHA256::FLASH_READ_CHUNK_SIZE;
+  uint32_t const next_chunk = ((image_size + chunk_size - 1) / chunk_size) * chunk_size;
+  return FlashSHA256::isErased(image + next_chunk, chunk_size);
+}
+
+static bool rp2040_connect_writeSHA256Cache(String const & sha256, uint32_t const image_size, bool const is_pending)
+{
+  OTASHA256Cache cache;
+  memset(&cache, 0, sizeof(cache));
+  cache.magic_number = OTA_SHA256_CACHE_MAGIC_NUMBER;
+  cache.image_size   = image_size;
+  cache.fingerprint  = is_pending ? 0 : rp2040_connect_getImageFingerprint(image_size);
+  cache.is_pending   = is_pending ? 1 : 0;
+  strncpy(cache.sha256, sha256.c_str(), sizeof(cache.sha256) - 1);
+
+  FILE * file = fopen(OTA_SHA256_FILE, "wb");
   if (!file)
+    return false;
+  bool const is_written = (fwrite(&cache, 1, sizeof(cache), file) == sizeof(cache));
+  fclose(file);
+  return is_written;
+}
+
+static bool rp2040_connect_readSHA256Cache(String & sha256)
+{
+  OTASHA256Cache cache;
+  FILE * file = fopen(OTA_SHA256_FILE, "rb");
+  if (!file)
+    return false;
+  bool const is_read = (fread(&cache, 1, sizeof(cache), file) == sizeof(cache));
+  fclose(file);
+
+  if (!is_read || (cache.magic_number != OTA_SHA256_CACHE_MAGIC_NUMBER) || (cache.sha256[sizeof(cache.sha256) - 1] != '\0'))
+    return false;
+
+  if (cache.is_pending)
   {
-    DEBUG_ERROR("%s: fopen() failed", __FUNCTION__);
-    fclose(file);
-    return static_cast<int>(OTAError::RP2040_ErrorOpenUpdateFile);
+    /* Hashed while downloaded, make sure SFU has flashed it before the
+     * first use and bind it to the application from then on.
+     */
+    if (!rp2040_connect_isImageSize(cache.image_size))
+      return false;
+    sha256 = cache.sha256;
+    rp2040_connect_writeSHA256Cache(sha256, cache.image_size, false);
+    return true;
+  }
+
+  if (!rp2040_connect_isImageSize(cache.image_size) || (cache.fingerprint != rp2040_connect_getImageFingerprint(cache.image_size)))
+    return false;
+
+  sha256 = cache.sha256;
+  return true;
+}
+
+static void rp2040_connect_closeOTAClient()
+{
+  if (ota_client) {
+    ota_client->stop();
+    delete ota_client;
+    ota_client = nullptr;
+  }
+}
+
+static int rp2040_connect_abortOTA(OTAError const err)
+{
+  if (ota_state == OTADownloadState::ReceiveHeader)
+    ota_metrics.header_ms += millis() - ota_state_start_tick;
+  else if (ota_state == OTADownloadState::ReceiveData)
+    ota_metrics.download_ms += millis() - ota_state_start_tick;
+
+  /* Whatever has been received stays in the file so that the download
+   * can be resumed by a later request for the same image.
+   */
+  if (ota_file) {
+    rp2040_connect_flushOTAWriteBuffer();
+    fclose(ota_file);
+    ota_file = nullptr;
+#if AIOT_CONFIG_RP2040_OTA_STREAM_DECOMPRESSION
+    /* SFU would flash an incomplete image left behind */
+    remove(ota_file_name);
+#endif
   }
+  rp2040_connect_closeOTAClient();
+  if (ota_fs) {
+    ota_fs->unmount();
+    delete ota_fs;
+    ota_fs = nullptr;
+  }
+  delete ota_flash;
+  ota_flash = nullptr;
+  ota_http_header = "";
+  ota_write_buf_len = 0;
+  ota_pending_buf_len = 0;
+  rp2040_connect_releaseOTAWriteBuffers();
+  ota_state = OTADownloadState::Idle;
+  return static_cast<int>(err);
+}
+
+static bool rp2040_connect_isOTACheckpoint(char const * url)
+{
+  FILE * checkpoint = fopen(OTA_CHECKPOINT_FILE, "rb");
+  if (!checkpoint)
+    return false;
+
+  String checkpoint_url;
+  for (int c = fgetc(checkpoint); c != EOF; c = fgetc(checkpoint))
+    checkpoint_url += static_cast<char>(c);
+  fclose(checkpoint);
+
+  return checkpoint_url == url;
+}
+
+static bool rp2040_connect_writeOTACheckpoint(char const * url)
+{
+  FILE * checkpoint = fopen(OTA_CHECKPOINT_FILE, "wb");
+  if (!checkpoint)
+    return false;
 
+  size_t const len = strlen(url);
+  bool const is_written = (fwrite(url, 1, len, checkpoint) == len);
+  fclose(checkpoint);
+  return is_written;
+}
+
+static int rp2040_connect_requestOTA()
+{
   watchdog_reset();
 
-  URI url(ota_url);
-  Client * client = nullptr;
+  URL url;
+  char host[256];
+  char host_header[sizeof(host) + 8];
   int port = 0;
 
-  if (url.protocol_ == "http") {
-    client = new WiFiClient();
+  if (!url_parse(ota_url.c_str(), url) || !url_copy(url.host, host, sizeof(host)) ||
+      !url_host_header(url, host_header, sizeof(host_header))) {
+    DEBUG_ERROR("%s: Failed to parse OTA URL %s", __FUNCTION__, ota_url.c_str());
+    return rp2040_connect_abortOTA(OTAError::RP2040_UrlParseError);
+  }
+
+  if (url_equals(url.scheme, "http")) {
+    ota_client = new WiFiClient();
     port = 80;
-  } else if (url.protocol_ == "https") {
-    client = new WiFiSSLClient();
+  } else if (url_equals(url.scheme, "https")) {
+    ota_client = new WiFiSSLClient();
     port = 443;
   } else {
-    DEBUG_ERROR("%s: Failed to parse OTA URL %s", __FUNCTION__, ota_url);
-    fclose(file);
-    return static_cast<int>(OTAError::RP2040_UrlParseError);
+    DEBUG_ERROR("%s: Failed to parse OTA URL %s", __FUNCTION__, ota_url.c_str());
+    return rp2040_connect_abortOTA(OTAError::RP2040_UrlParseError);
   }
 
+  if (url.port != 0)
+    port = url.port;
+
   watchdog_reset();
 
-  if (!client->connect(url.host_.c_str(), port))
+  unsigned long const connect_start = millis();
+  bool const is_connected = ota_client->connect(host, port);
+  ota_metrics.connect_ms += millis() - connect_start;
+  if (!is_connected)
   {
-    DEBUG_ERROR("%s: Connection failure with OTA storage server %s", __FUNCTION__, url.host_.c_str());
-    fclose(file);
-    return static_cast<int>(OTAError::RP2040_ServerConnectError);
+    DEBUG_ERROR("%s: Connection failure with OTA storage server %s", __FUNCTION__, host);
+    return rp2040_connect_abortOTA(OTAError::RP2040_ServerConnectError);
   }
 
   watchdog_reset();
 
-  client->println(String("GET ") + url.path_.c_str() + " HTTP/1.1");
-  client->println(String("Host: ") + url.host_.c_str());
-  client->println("Connection: close");
-  client->println();
+  /* Send the request piece by piece instead of concatenating Strings */
+  ota_client->print("GET ");
+  if (url.path.len > 0)
+    ota_client->write(reinterpret_cast<uint8_t const *>(url.path.str), url.path.len);
+  else
+    ota_client->print("/");
+  if (url.query.len > 0) {
+    ota_client->print("?");
+    ota_client->write(reinterpret_cast<uint8_t const *>(url.query.str), url.query.len);
+  }
+  ota_client->println(" HTTP/1.1");
+  ota_client->print("Host: ");
+  ota_client->println(host_header);
+  if (ota_bytes_received > 0) {
+    ota_client->print("Range: bytes=");
+    ota_client->print(ota_bytes_received);
+    ota_client->println("-");
+  }
+  ota_client->println("Connection: close");
+  ota_client->println();
 
-  watchdog_reset();
+  ota_http_header = "";
+  ota_state_start_tick = millis();
+  ota_state = OTADownloadState::ReceiveHeader;
+  return static_cast<int>(OTAError::None);
+}
 
-  /* Receive HTTP header. */
-  String http_header;
-  bool is_header_complete     = false,
-       is_http_header_timeout = false;
-  for (unsigned long const start = millis(); !is_header_complete;)
+static int rp2040_connect_trackOTAFile()
+{
+  /* A resumed image misses its beginning, the whole file is read back and
+   * decoded once more so that it is verified like an uninterrupted one.
+   */
+  fclose(ota_file);
+  ota_file = fopen(ota_file_name, "rb");
+  if (!ota_file)
   {
-    is_http_header_timeout = (millis() - start) > AIOT_CONFIG_RP2040_OTA_HTTP_HEADER_RECEIVE_TIMEOUT_ms;
-    if (is_http_header_timeout) break;
+    DEBUG_ERROR("%s: fopen() failed", __FUNCTION__);
+    return static_cast<int>(OTAError::RP2040_ErrorOpenUpdateFile);
+  }
 
+  rp2040_connect_resetOTAImage(true);
+  uint8_t buf[256];
+  for (size_t bytes_read = fread(buf, 1, sizeof(buf), ota_file); bytes_read > 0; bytes_read = fread(buf, 1, sizeof(buf), ota_file))
+  {
     watchdog_reset();
+    int const err = rp2040_connect_processOTAData(buf, bytes_read);
+    if (err != static_cast<int>(OTAError::None))
+      return err;
+  }
+  return static_cast<int>(OTAError::None);
+}
 
-    if (client->available())
-    {
-      char const c = client->read();
+static int rp2040_connect_resumeOTA()
+{
+  /* Keep what has been received and request the remainder */
+  if (!rp2040_connect_flushOTAWriteBuffer())
+  {
+    DEBUG_ERROR("%s: Writing of firmware image to flash failed", __FUNCTION__);
+    return rp2040_connect_abortOTA(OTAError::RP2040_ErrorWriteUpdateFile);
+  }
+  rp2040_connect_closeOTAClient();
 
-      http_header += c;
-      if (http_header.endsWith("\r\n\r\n"))
-        is_header_complete = true;
-    }
+  ota_metrics.download_ms += millis() - ota_state_start_tick;
+  ota_state = OTADownloadState::Idle;
+  ota_resume_cnt++;
+  DEBUG_INFO("%s: resuming download at %d bytes (attempt %d)", __FUNCTION__, ota_bytes_received, ota_resume_cnt);
+  return rp2040_connect_requestOTA();
+}
+
+static int rp2040_connect_onOTAHeader()
+{
+  /* Receive HTTP header, at most one chunk per call. */
+  bool const is_http_header_timeout = (millis() - ota_state_start_tick) > AIOT_CONFIG_RP2040_OTA_HTTP_HEADER_RECEIVE_TIMEOUT_ms;
+  if (is_http_header_timeout)
+  {
+    DEBUG_ERROR("%s: Error receiving HTTP header (timeout)", __FUNCTION__);
+    return rp2040_connect_abortOTA(OTAError::RP2040_HttpHeaderError);
+  }
+
+  bool is_header_complete = false;
+  for (size_t i = 0; (i < AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE) && !is_header_complete && ota_client->available(); i++)
+  {
+    ota_http_header += static_cast<char>(ota_client->read());
+    is_header_complete = ota_http_header.endsWith("\r\n\r\n");
   }
 
   if (!is_header_complete)
+    return static_cast<int>(OTAError::None);
+
+  ota_metrics.header_ms += millis() - ota_state_start_tick;
+
+  /* The status line looks like "HTTP/1.1 206 Partial Content", a server
+   * ignoring the range request replies with the complete image instead.
+   */
+  int http_status = 0;
+  char const * status_ptr = strchr(ota_http_header.c_str(), ' ');
+  if (status_ptr)
+    http_status = atoi(status_ptr + 1);
+
+  if ((ota_bytes_received > 0) && (http_status != 206))
   {
-    DEBUG_ERROR("%s: Error receiving HTTP header %s", __FUNCTION__, is_http_header_timeout ? "(timeout)":"");
-    fclose(file);
-    return static_cast<int>(OTAError::RP2040_HttpHeaderError);
+    DEBUG_WARNING("%s: Range not satisfied (HTTP %d), restarting download", __FUNCTION__, http_status);
+    fclose(ota_file);
+    ota_file = fopen(ota_file_name, "wb");
+    if (!ota_file)
+    {
+      DEBUG_ERROR("%s: fopen() failed", __FUNCTION__);
+      return rp2040_connect_abortOTA(OTAError::RP2040_ErrorOpenUpdateFile);
+    }
+    setvbuf(ota_file, nullptr, _IONBF, 0);
+    ota_bytes_received = 0;
+    rp2040_connect_resetOTAImage(true);
   }
 
   /* Extract concent length from HTTP header. A typical entry looks like
    *   "Content-Length: 123456"
    */
-  char const * content_length_ptr = strstr(http_header.c_str(), "Content-Length");
+  char const * content_length_ptr = strstr(ota_http_header.c_str(), "Content-Length");
   if (!content_length_ptr)
   {
     DEBUG_ERROR("%s: Failure to extract content length from http header", __FUNCTION__);
-    fclose(file);
-    return static_cast<int>(OTAError::RP2040_ErrorParseHttpHeader);
+    return rp2040_connect_abortOTA(OTAError::RP2040_ErrorParseHttpHeader);
   }
   /* Find start of numerical value. */
   char * ptr = const_cast<char *>(content_length_ptr);
@@ -198,48 +730,395 @@ int rp2040_connect_onOTARequest(char const * ota_url)
   /* Extract numerical value. */
   String content_length_str;
   for (; isDigit(*ptr); ptr++) content_length_str += *ptr;
-  int const content_length_val = atoi(content_length_str.c_str());
-  DEBUG_VERBOSE("%s: Length of OTA binary according to HTTP header = %d bytes", __FUNCTION__, content_length_val);
+  /* A partial reply only holds the remainder of the image */
+  ota_content_length = ota_bytes_received + atoi(content_length_str.c_str());
+  DEBUG_VERBOSE("%s: Length of OTA binary according to HTTP header = %d bytes", __FUNCTION__, ota_content_length);
+
+  ota_http_header = "";
+  ota_state_start_tick = millis();
+  ota_state = OTADownloadState::ReceiveData;
+  return static_cast<int>(OTAError::None);
+}
 
-  /* Receive as many bytes as are indicated by the HTTP header - or die trying. */
-  int  bytes_received = 0;
-  bool is_http_data_timeout = false;
-  for(unsigned long const start = millis(); bytes_received < content_length_val;)
+static int rp2040_connect_onOTAData()
+{
+  /* Receive as many bytes as are indicated by the HTTP header - or die trying.
+   * The data is read and written in chunks of whatever is available, up to
+   * AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE bytes per call.
+   */
+  bool const is_http_data_timeout = (millis() - ota_state_start_tick) > AIOT_CONFIG_RP2040_OTA_HTTP_DATA_RECEIVE_TIMEOUT_ms;
+  bool const is_connection_lost   = !ota_client->connected() && !ota_client->available();
+  if (is_http_data_timeout || is_connection_lost)
   {
-    is_http_data_timeout = (millis() - start) > AIOT_CONFIG_RP2040_OTA_HTTP_DATA_RECEIVE_TIMEOUT_ms;
-    if (is_http_data_timeout) break;
+    if (ota_resume_cnt < AIOT_CONFIG_RP2040_OTA_MAX_RESUME_CNT)
+      return rp2040_connect_resumeOTA();
 
-    watchdog_reset();
+    DEBUG_ERROR("%s: Error receiving HTTP data %s (%d bytes received, %d expected)", __FUNCTION__, is_http_data_timeout ? "(timeout)":"", ota_bytes_received, ota_content_length);
+    return rp2040_connect_abortOTA(OTAError::RP2040_HttpDataError);
+  }
 
-    if (client->available())
+#if AIOT_CONFIG_RP2040_OTA_STREAM_DECOMPRESSION
+  uint8_t buf[256];
+  for (size_t chunk = 0; (chunk < AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE) && (ota_bytes_received < ota_content_length);)
+  {
+    int const bytes_available = ota_client->available();
+    if (bytes_available <= 0)
     {
-      char const c = client->read();
+      /* Use the gap to write a block set aside */
+      if (!rp2040_connect_writePendingOTABuffer())
+      {
+        DEBUG_ERROR("%s: Writing of firmware image to flash failed", __FUNCTION__);
+        return rp2040_connect_abortOTA(OTAError::RP2040_ErrorWriteUpdateFile);
+      }
+      break;
+    }
+
+    /* Decompress the data on the fly, the decoder fills the write buffer */
+    size_t const bytes_to_read = std::min(std::min(static_cast<size_t>(bytes_available), sizeof(buf)), static_cast<size_t>(ota_content_length - ota_bytes_received));
+    int const bytes_read = ota_client->read(buf, bytes_to_read);
+    if (bytes_read <= 0)
+      break;
+
+    int const err = rp2040_connect_processOTAData(buf, bytes_read);
+    if (err != static_cast<int>(OTAError::None))
+      return rp2040_connect_abortOTA(static_cast<OTAError>(err));
+
+    ota_bytes_received += bytes_read;
+    ota_metrics.bytes += bytes_read;
+    chunk += bytes_read;
+  }
+
+  if (ota_bytes_received < ota_content_length)
+    return static_cast<int>(OTAError::None);
+
+  if (!rp2040_connect_flushOTAWriteBuffer())
+  {
+    DEBUG_ERROR("%s: Writing of firmware image to flash failed", __FUNCTION__);
+    return rp2040_connect_abortOTA(OTAError::RP2040_ErrorWriteUpdateFile);
+  }
+
+#else
+  for (size_t chunk = 0; (chunk < AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE) && (ota_bytes_received < ota_content_length);)
+  {
+    int const bytes_available = ota_client->available();
+    if (bytes_available <= 0)
+    {
+      /* Use the gap to write a block set aside */
+      if (!rp2040_connect_writePendingOTABuffer())
+      {
+        DEBUG_ERROR("%s: Writing of firmware image to flash failed", __FUNCTION__);
+        return rp2040_connect_abortOTA(OTAError::RP2040_ErrorWriteUpdateFile);
+      }
+      break;
+    }
+
+    /* Read straight into the write buffer and write it once a full block is gathered */
+    size_t const bytes_to_read = std::min(std::min(static_cast<size_t>(bytes_available), OTA_WRITE_BUF_SIZE - ota_write_buf_len), static_cast<size_t>(ota_content_length - ota_bytes_received));
+    int const bytes_read = ota_client->read(ota_write_buf + ota_write_buf_len, bytes_to_read);
+    if (bytes_read <= 0)
+      break;
+
+    if (ota_is_image_tracked)
+    {
+      int const err = rp2040_connect_processOTAData(ota_write_buf + ota_write_buf_len, bytes_read);
+      if (err != static_cast<int>(OTAError::None))
+        return rp2040_connect_abortOTA(static_cast<OTAError>(err));
+    }
 
-      if (fwrite(&c, 1, sizeof(c), file) != sizeof(c))
+    ota_write_buf_len += bytes_read;
+    ota_bytes_received += bytes_read;
+    ota_metrics.bytes += bytes_read;
+    chunk += bytes_read;
+
+    bool const is_last_block = (ota_bytes_received == ota_content_length);
+    if (is_last_block || (ota_write_buf_len == OTA_WRITE_BUF_SIZE))
+    {
+      if (is_last_block ? !rp2040_connect_flushOTAWriteBuffer() : !rp2040_connect_swapOTAWriteBuffer())
       {
         DEBUG_ERROR("%s: Writing of firmware image to flash failed", __FUNCTION__);
-        fclose(file);
-        return static_cast<int>(OTAError::RP2040_ErrorWriteUpdateFile);
+        return rp2040_connect_abortOTA(OTAError::RP2040_ErrorWriteUpdateFile);
       }
+    }
+  }
+
+  if (ota_bytes_received < ota_content_length)
+    return static_cast<int>(OTAError::None);
+#endif
+
+  ota_metrics.download_ms += millis() - ota_state_start_tick;
+  ota_state = OTADownloadState::Idle;
+  rp2040_connect_releaseOTAWriteBuffers();
 
-      bytes_received++;
+  if (!ota_is_image_tracked)
+  {
+    int const err = rp2040_connect_trackOTAFile();
+    if (err != static_cast<int>(OTAError::None))
+    {
+      /* The parts don't belong to the same image, a later request starts over */
+      remove(OTA_CHECKPOINT_FILE);
+      remove(ota_file_name);
+      return rp2040_connect_abortOTA(static_cast<OTAError>(err));
     }
   }
 
-  if (bytes_received != content_length_val) {
-    DEBUG_ERROR("%s: Error receiving HTTP data %s (%d bytes received, %d expected)", __FUNCTION__, is_http_data_timeout ? "(timeout)":"", bytes_received, content_length_val);
-    fclose(file);
-    return static_cast<int>(OTAError::RP2040_HttpDataError);
+  unsigned long const verify_start = micros();
+
+  if (~ota_crc32 != ota_header.header.crc32)
+  {
+    DEBUG_ERROR("%s: OTA image CRC mismatch", __FUNCTION__);
+    /* Neither SFU nor a later request may pick it up */
+    remove(OTA_CHECKPOINT_FILE);
+    remove(ota_file_name);
+    return rp2040_connect_abortOTA(OTAError::RP2040_ErrorCrc);
   }
 
-  DEBUG_INFO("%s: %d bytes received", __FUNCTION__, ftell(file));
-  fclose(file);
+  if (ota_is_delta && !ota_delta.isComplete())
+  {
+    DEBUG_ERROR("%s: Delta image incomplete", __FUNCTION__);
+    return rp2040_connect_abortOTA(OTAError::RP2040_ErrorDelta);
+  }
+
+  DEBUG_INFO("%s: %d bytes received", __FUNCTION__, ftell(ota_file));
+  fclose(ota_file);
+  ota_file = nullptr;
+  rp2040_connect_closeOTAClient();
+
+  /* The image is complete, it must not be resumed once more. */
+  remove(OTA_CHECKPOINT_FILE);
+
+  /* Spare hashing the application once it is flashed */
+  String const sha256 = ota_sha256.finalize();
+  uint32_t const image_size = ota_sha256.size();
+  DEBUG_VERBOSE("%s: SHA256 of the received image = %s", __FUNCTION__, sha256.c_str());
+
+  if ((ota_expected_sha256.length() > 0) && !sha256.equalsIgnoreCase(ota_expected_sha256))
+  {
+    DEBUG_ERROR("%s: OTA image SHA256 mismatch, %s expected", __FUNCTION__, ota_expected_sha256.c_str());
+    /* Neither SFU nor a later request may pick it up */
+    remove(ota_file_name);
+    return rp2040_connect_abortOTA(OTAError::RP2040_ErrorSHA256);
+  }
+
+  ota_verify_us += micros() - verify_start;
+  rp2040_connect_updateOTAMetrics();
+  DEBUG_INFO("%s: %s", __FUNCTION__, OTA::toString(ota_metrics).c_str());
+
+  /* A prefetched image waits for rp2040_connect_onOTAApply() to store the
+   * cache and the metrics, a reset in between must not report them.
+   */
+  if (!ota_is_apply)
+  {
+    ota_staged_sha256 = sha256;
+    ota_staged_image_size = image_size;
+    ota_fs->unmount();
+    delete ota_fs;
+    ota_fs = nullptr;
+    delete ota_flash;
+    ota_flash = nullptr;
+    ota_is_staged = true;
+    DEBUG_INFO("%s: image staged", __FUNCTION__);
+    return static_cast<int>(OTAError::None);
+  }
+
+  rp2040_connect_writeSHA256Cache(sha256, image_size, true);
+  rp2040_connect_writeOTAMetrics();
 
   /* Unmount the filesystem. */
-  if ((err = fs.unmount()) != 0)
+  int err = -1;
+  if ((err = ota_fs->unmount()) != 0)
   {
      DEBUG_ERROR("%s: fs.unmount() failed with %d", __FUNCTION__, err);
-     return static_cast<int>(OTAError::RP2040_ErrorUnmount);
+     return rp2040_connect_abortOTA(OTAError::RP2040_ErrorUnmount);
+  }
+
+  /* Perform the reset to reboot to SFU. */
+  mbed_watchdog_trigger_reset();
+  /* If watchdog is enabled we should not reach this point */
+  NVIC_SystemReset();
+
+  return static_cast<int>(OTAError::None);
+}
+
+/******************************************************************************
+ * FUNCTION DEFINITION
+ ******************************************************************************/
+
+int rp2040_connect_onOTAStart(char const * url, bool const is_apply, char const * sha256)
+{
+  if (ota_state != OTADownloadState::Idle)
+    rp2040_connect_abortOTA(OTAError::None);
+
+  ota_is_apply = is_apply;
+  ota_file_name = is_apply ? OTA_UPDATE_FILE : OTA_STAGED_FILE;
+  ota_is_staged = false;
+  ota_staged_sha256 = "";
+  ota_staged_image_size = 0;
+
+  watchdog_reset();
+
+  int err = -1;
+  ota_flash = new FlashIAPBlockDevice(XIP_BASE + 0xF00000, 0x100000);
+  if ((err = ota_flash->init()) < 0)
+  {
+    DEBUG_ERROR("%s: flash.init() failed with %d", __FUNCTION__, err);
+    return rp2040_connect_abortOTA(OTAError::RP2040_ErrorFlashInit);
+  }
+
+  watchdog_reset();
+
+  ota_url = url;
+  ota_expected_sha256 = sha256;
+  ota_bytes_received = 0;
+  ota_content_length = 0;
+  ota_resume_cnt = 0;
+  ota_write_buf_len = 0;
+  ota_pending_buf_len = 0;
+  if (!rp2040_connect_acquireOTAWriteBuffers())
+  {
+    DEBUG_ERROR("%s: Not enough memory for the write buffers", __FUNCTION__);
+    return rp2040_connect_abortOTA(OTAError::RP2040_ErrorNoMemory);
+  }
+  memset(&ota_metrics, 0, sizeof(ota_metrics));
+  ota_is_metrics_tracked = true;
+  ota_flash_write_us = 0;
+  ota_decode_us = 0;
+  ota_verify_us = 0;
+
+  /* Resume a previous download of the same image if there is one. The
+   * state of the decompression can't be restored, a decompressed image
+   * is therefore only resumed within the same request. Neither can the
+   * hash, an image to be verified starts over as well.
+   */
+  ota_fs = new mbed::FATFileSystem("ota");
+  bool const is_resumable = !AIOT_CONFIG_RP2040_OTA_STREAM_DECOMPRESSION && (ota_expected_sha256.length() == 0);
+  if (is_resumable && (ota_fs->mount(ota_flash) == 0) && rp2040_connect_isOTACheckpoint(url))
+  {
+    /* The partial image may have been started by the other kind of request */
+    char const * const other_file_name = is_apply ? OTA_STAGED_FILE : OTA_UPDATE_FILE;
+    FILE * other_file = fopen(other_file_name, "rb");
+    if (other_file)
+    {
+      fclose(other_file);
+      rename(other_file_name, ota_file_name);
+    }
+    ota_file = fopen(ota_file_name, "ab");
+    if (ota_file && (fseek(ota_file, 0, SEEK_END) == 0))
+      ota_bytes_received = ftell(ota_file);
+  }
+
+  if (ota_file)
+  {
+    DEBUG_INFO("%s: resuming download at %d bytes", __FUNCTION__, ota_bytes_received);
+  }
+  else
+  {
+    /* Only the sectors written by the file system are erased, each one
+     * right before, instead of the whole 1 MB ahead of the download.
+     */
+    ota_fs->unmount();
+    if ((err = ota_fs->reformat(ota_flash)) != 0)
+    {
+       DEBUG_ERROR("%s: fs.reformat() failed with %d", __FUNCTION__, err);
+       return rp2040_connect_abortOTA(OTAError::RP2040_ErrorReformat);
+    }
+
+    watchdog_reset();
+
+    ota_file = fopen(ota_file_name, "wb");
+    if (!ota_file || (!AIOT_CONFIG_RP2040_OTA_STREAM_DECOMPRESSION && !rp2040_connect_writeOTACheckpoint(url)))
+    {
+      DEBUG_ERROR("%s: fopen() failed", __FUNCTION__);
+      return rp2040_connect_abortOTA(OTAError::RP2040_ErrorOpenUpdateFile);
+    }
+  }
+
+  /* The data is already gathered in blocks, no need for stdio to buffer it again */
+  setvbuf(ota_file, nullptr, _IONBF, 0);
+  rp2040_connect_resetOTAImage(ota_bytes_received == 0);
+
+  return rp2040_connect_requestOTA();
+}
+
+int rp2040_connect_onOTAPoll(bool & is_in_progress)
+{
+  watchdog_reset();
+
+  int err = static_cast<int>(OTAError::None);
+  switch (ota_state)
+  {
+    case OTADownloadState::ReceiveHeader: err = rp2040_connect_onOTAHeader(); break;
+    case OTADownloadState::ReceiveData:   err = rp2040_connect_onOTAData();   break;
+    case OTADownloadState::Idle:                                               break;
+  }
+
+  is_in_progress = (ota_state != OTADownloadState::Idle);
+  return err;
+}
+
+int rp2040_connect_getOTAProgress()
+{
+  if ((ota_state != OTADownloadState::ReceiveData) || (ota_content_length <= 0))
+    return -1;
+  return static_cast<int>((static_cast<int64_t>(ota_bytes_received) * 100) / ota_content_length);
+}
+
+OTAMetrics rp2040_connect_getOTAMetrics()
+{
+  if (ota_is_metrics_tracked)
+  {
+    rp2040_connect_updateOTAMetrics();
+  }
+  else if (!ota_is_metrics_loaded)
+  {
+    ota_is_metrics_loaded = true;
+    rp2040_connect_readOTAMetrics();
+  }
+  return ota_metrics;
+}
+
+bool rp2040_connect_isOTAStaged(char const * url)
+{
+  return ota_is_staged && (ota_url == url);
+}
+
+int rp2040_connect_onOTAApply()
+{
+  if (!ota_is_staged)
+    return static_cast<int>(OTAError::RP2040_ErrorOpenUpdateFile);
+
+  watchdog_reset();
+
+  FlashIAPBlockDevice flash(XIP_BASE + 0xF00000, 0x100000);
+  mbed::FATFileSystem fs("ota");
+  int err = -1;
+  if ((err = flash.init()) < 0)
+  {
+    DEBUG_ERROR("%s: flash.init() failed with %d", __FUNCTION__, err);
+    return static_cast<int>(OTAError::RP2040_ErrorFlashInit);
+  }
+  if ((err = fs.mount(&flash)) != 0)
+  {
+    DEBUG_ERROR("%s: fs.mount() failed with %d", __FUNCTION__, err);
+    return static_cast<int>(OTAError::RP2040_ErrorOpenUpdateFile);
+  }
+
+  remove(OTA_UPDATE_FILE);
+  if (rename(OTA_STAGED_FILE, OTA_UPDATE_FILE) != 0)
+  {
+    DEBUG_ERROR("%s: staged image not found", __FUNCTION__);
+    fs.unmount();
+    ota_is_staged = false;
+    return static_cast<int>(OTAError::RP2040_ErrorOpenUpdateFile);
+  }
+
+  if (ota_staged_image_size > 0)
+    rp2040_connect_writeSHA256Cache(ota_staged_sha256, ota_staged_image_size, true);
+  rp2040_connect_writeOTAMetrics();
+
+  if ((err = fs.unmount()) != 0)
+  {
+    DEBUG_ERROR("%s: fs.unmount() failed with %d", __FUNCTION__, err);
+    return static_cast<int>(OTAError::RP2040_ErrorUnmount);
   }
 
   /* Perform the reset to reboot to SFU. */
@@ -250,12 +1129,62 @@ int rp2040_connect_onOTARequest(char const * ota_url)
   return static_cast<int>(OTAError::None);
 }
 
-String rp2040_connect_getOTAImageSHA256()
+int rp2040_connect_onOTARequest(char const * url)
+{
+  int err = rp2040_connect_onOTAStart(url, true, "");
+
+  bool is_in_progress = (err == static_cast<int>(OTAError::None));
+  while (is_in_progress)
+    err = rp2040_connect_onOTAPoll(is_in_progress);
+
+  return err;
+}
+
+TaskStatus rp2040_connect_pollOTAImageSHA256(String & sha256)
 {
-  /* The maximum size of a RP2040 OTA update image is 1 MByte (that is 1024 *
-   * 1024 bytes or 0x100'000 bytes).
+  static FlashSHA256Task task;
+  static bool is_started = false;
+  static uint32_t image_size = 0;
+
+  /* The hash is kept on the OTA file system, either stored when the image
+   * was downloaded or when it was last calculated. It is only used if the
+   * application in flash still matches it.
    */
-  return FlashSHA256::calc(XIP_BASE, 0x100000);
+  if (!is_started)
+  {
+    FlashIAPBlockDevice flash(XIP_BASE + 0xF00000, 0x100000);
+    mbed::FATFileSystem fs("ota");
+    if ((flash.init() == 0) && (fs.mount(&flash) == 0))
+    {
+      bool const is_cached = rp2040_connect_readSHA256Cache(sha256);
+      fs.unmount();
+      if (is_cached)
+        return TaskStatus::Done;
+    }
+
+    /* The maximum size of a RP2040 OTA update image is 1 MByte (that is 1024 *
+     * 1024 bytes or 0x100'000 bytes).
+     */
+    image_size = FlashSHA256::imageSize(XIP_BASE, 0x100000);
+    task.begin(reinterpret_cast<uint8_t const *>(XIP_BASE), image_size, OTA::SHA256_SLICE_SIZE);
+    is_started = true;
+    DEBUG_VERBOSE("SHA256: %d bytes to read", image_size);
+  }
+
+  if (task.step() == TaskStatus::InProgress)
+    return TaskStatus::InProgress;
+
+  is_started = false;
+  sha256 = task.finalize();
+
+  FlashIAPBlockDevice flash(XIP_BASE + 0xF00000, 0x100000);
+  mbed::FATFileSystem fs("ota");
+  if ((flash.init() == 0) && (fs.mount(&flash) == 0))
+  {
+    rp2040_connect_writeSHA256Cache(sha256, image_size, false);
+    fs.unmount();
+  }
+  return TaskStatus::Done;
 }
 
 bool rp2040_connect_isOTACapable()
@@ -31,7 +31,19 @@
 
 #include <stm32h7xx_hal_rtc_ex.h>
 
-#include "tls/utility/SHA256.h"
+#include "utility/ota/FlashSHA256.h"
+
+#if AIOT_CONFIG_PORTENTA_OTA_STREAM_DECOMPRESSION
+  #include <WiFiSSLClient.h>
+  #if defined (BOARD_HAS_ETHERNET)
+    #include <EthernetSSLClient.h>
+  #endif
+  #include "utility/ota/LZSSDecoder.h"
+  #include "utility/url/URLParser.h"
+  #include "utility/memory/ScratchPool.h"
+
+  #include <algorithm>
+#endif
 
 #include "../watchdog/Watchdog.h"
 
@@ -41,6 +53,293 @@
 
 extern RTC_HandleTypeDef RTCHandle;
 
+#if AIOT_CONFIG_PORTENTA_OTA_STREAM_DECOMPRESSION
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+static char const OTA_UPDATE_FILE[] = "/fs/UPDATE.BIN";
+
+/******************************************************************************
+ * LOCAL MODULE VARIABLES
+ ******************************************************************************/
+
+/* Header prepended to the image by extras/tools/bin2ota.py */
+union OTAHeader
+{
+  struct
+  {
+    uint32_t len;
+    uint32_t crc32;
+    uint32_t magic_number;
+    uint8_t  version[8];
+  } header;
+  uint8_t buf[20];
+};
+
+static uint8_t const OTA_VERSION_FLAG_COMPRESSED = 0x40;
+
+/* The decoded image is gathered in a buffer of the size of a QSPI sector
+ * and written unbuffered, received data is decoded from the buffer it is
+ * read into.
+ */
+struct OTAStream
+{
+  FILE * file;
+  uint8_t * buf;
+  size_t buf_len;
+  uint32_t image_size;
+  bool is_write_error;
+};
+
+/******************************************************************************
+ * LOCAL MODULE FUNCTIONS
+ ******************************************************************************/
+
+static uint32_t portenta_h7_crc32(uint32_t crc, uint8_t const * data, size_t const len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return crc;
+}
+
+static bool portenta_h7_flushOTAStream(OTAStream & stream)
+{
+  size_t const len = stream.buf_len;
+  stream.buf_len = 0;
+  if (fwrite(stream.buf, 1, len, stream.file) != len)
+    stream.is_write_error = true;
+  return !stream.is_write_error;
+}
+
+static void portenta_h7_onOTADecoded(uint8_t const c, void * ctx)
+{
+  OTAStream & stream = *static_cast<OTAStream *>(ctx);
+  stream.buf[stream.buf_len++] = c;
+  stream.image_size++;
+  if (stream.buf_len == AIOT_CONFIG_PORTENTA_OTA_WRITE_BUFFER_SIZE)
+    portenta_h7_flushOTAStream(stream);
+}
+
+static int portenta_h7_receiveOTAHeader(Client & client, int & content_length)
+{
+  String http_header;
+  unsigned long const start = millis();
+  while (!http_header.endsWith("\r\n\r\n"))
+  {
+    watchdog_reset();
+    if ((millis() - start) > AIOT_CONFIG_PORTENTA_OTA_HTTP_HEADER_RECEIVE_TIMEOUT_ms)
+    {
+      DEBUG_ERROR("%s: Error receiving HTTP header (timeout)", __FUNCTION__);
+      return static_cast<int>(OTAError::Portenta_HttpHeaderError);
+    }
+    if (client.available())
+      http_header += static_cast<char>(client.read());
+    else
+      yield();
+  }
+
+  /* The status line looks like "HTTP/1.1 200 OK" */
+  int http_status = 0;
+  char const * status_ptr = strchr(http_header.c_str(), ' ');
+  if (status_ptr)
+    http_status = atoi(status_ptr + 1);
+  if (http_status != 200)
+  {
+    DEBUG_ERROR("%s: OTA storage server replied with HTTP %d", __FUNCTION__, http_status);
+    return static_cast<int>(OTAError::Portenta_HttpHeaderError);
+  }
+
+  /* A typical entry looks like "Content-Length: 123456" */
+  char const * ptr = strstr(http_header.c_str(), "Content-Length");
+  if (!ptr)
+  {
+    DEBUG_ERROR("%s: Failure to extract content length from http header", __FUNCTION__);
+    return static_cast<int>(OTAError::Portenta_ErrorParseHttpHeader);
+  }
+  for (; (*ptr != '\0') && !isDigit(*ptr); ptr++) { }
+  content_length = atoi(ptr);
+  DEBUG_VERBOSE("%s: Length of OTA binary according to HTTP header = %d bytes", __FUNCTION__, content_length);
+  return static_cast<int>(OTAError::None);
+}
+
+static int portenta_h7_receiveOTAData(Client & client, int const content_length, uint8_t * buf, OTAStream & stream)
+{
+  OTAHeader ota_header = {};
+  size_t ota_header_len = 0;
+  uint32_t crc32 = 0xFFFFFFFF;
+  LZSSDecoder decoder(portenta_h7_onOTADecoded, &stream);
+
+  int bytes_received = 0;
+  unsigned long const start = millis();
+  while (bytes_received < content_length)
+  {
+    watchdog_reset();
+    bool const is_http_data_timeout = (millis() - start) > AIOT_CONFIG_PORTENTA_OTA_HTTP_DATA_RECEIVE_TIMEOUT_ms;
+    bool const is_connection_lost   = !client.connected() && !client.available();
+    if (is_http_data_timeout || is_connection_lost)
+    {
+      DEBUG_ERROR("%s: Error receiving HTTP data %s (%d bytes received, %d expected)", __FUNCTION__, is_http_data_timeout ? "(timeout)":"", bytes_received, content_length);
+      return static_cast<int>(OTAError::Portenta_HttpDataError);
+    }
+
+    int const bytes_available = client.available();
+    if (bytes_available <= 0)
+    {
+      yield();
+      continue;
+    }
+    int const bytes_to_read = std::min(std::min(bytes_available, content_length - bytes_received), static_cast<int>(AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE));
+    int const bytes_read = client.read(buf, bytes_to_read);
+    if (bytes_read <= 0)
+      continue;
+    bytes_received += bytes_read;
+
+    /* The CRC covers everything following the length and CRC fields */
+    uint8_t const * data = buf;
+    size_t len = bytes_read;
+    for (; (len > 0) && (ota_header_len < sizeof(ota_header.buf)); data++, len--)
+    {
+      if (ota_header_len >= 8)
+        crc32 = portenta_h7_crc32(crc32, data, 1);
+      ota_header.buf[ota_header_len++] = *data;
+    }
+    crc32 = portenta_h7_crc32(crc32, data, len);
+
+    if (ota_header.header.version[7] & OTA_VERSION_FLAG_COMPRESSED)
+      decoder.decode(data, len);
+    else
+      for (size_t i = 0; i < len; i++)
+        portenta_h7_onOTADecoded(data[i], &stream);
+
+    if (stream.is_write_error)
+    {
+      DEBUG_ERROR("%s: Writing of firmware image to flash failed", __FUNCTION__);
+      return static_cast<int>(OTAError::Portenta_ErrorWriteUpdateFile);
+    }
+  }
+
+  if (!portenta_h7_flushOTAStream(stream))
+  {
+    DEBUG_ERROR("%s: Writing of firmware image to flash failed", __FUNCTION__);
+    return static_cast<int>(OTAError::Portenta_ErrorWriteUpdateFile);
+  }
+  if ((ota_header_len < sizeof(ota_header.buf)) || (ota_header.header.len != (content_length - sizeof(ota_header.buf))))
+  {
+    DEBUG_ERROR("%s: OTA image length mismatch", __FUNCTION__);
+    return static_cast<int>(OTAError::Portenta_ErrorHeader);
+  }
+  crc32 ^= 0xFFFFFFFF;
+  if (crc32 != ota_header.header.crc32)
+  {
+    DEBUG_ERROR("%s: CRC32 mismatch 0x%08X != 0x%08X", __FUNCTION__, crc32, ota_header.header.crc32);
+    return static_cast<int>(OTAError::Portenta_ErrorCrc);
+  }
+  return static_cast<int>(OTAError::None);
+}
+
+static int portenta_h7_streamOTA(Client & client, URL const & url, char const * host, char const * host_header, uint16_t const port, uint32_t & image_size)
+{
+  watchdog_reset();
+
+  if (!client.connect(host, port))
+  {
+    DEBUG_ERROR("%s: Connection failure with OTA storage server %s", __FUNCTION__, host);
+    return static_cast<int>(OTAError::Portenta_ServerConnectError);
+  }
+
+  watchdog_reset();
+
+  client.print("GET ");
+  if (url.path.len > 0)
+    client.write(reinterpret_cast<uint8_t const *>(url.path.str), url.path.len);
+  else
+    client.print("/");
+  if (url.query.len > 0) {
+    client.print("?");
+    client.write(reinterpret_cast<uint8_t const *>(url.query.str), url.query.len);
+  }
+  client.println(" HTTP/1.1");
+  client.print("Host: ");
+  client.println(host_header);
+  client.println("Connection: close");
+  client.println();
+
+  int content_length = 0;
+  int err = portenta_h7_receiveOTAHeader(client, content_length);
+  if (err != static_cast<int>(OTAError::None))
+    return err;
+
+  /* One buffer receives the data, the other gathers the decoded image */
+  ScratchLease bufs;
+  if (!bufs.acquire(AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE + AIOT_CONFIG_PORTENTA_OTA_WRITE_BUFFER_SIZE, MemoryPool::Ota))
+  {
+    DEBUG_ERROR("%s: Out of memory for the OTA buffers", __FUNCTION__);
+    return static_cast<int>(OTAError::Portenta_ErrorNoMemory);
+  }
+
+  OTAStream stream = {fopen(OTA_UPDATE_FILE, "wb"), bufs.data() + AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE, 0, 0, false};
+  if (!stream.file)
+  {
+    DEBUG_ERROR("%s: fopen() failed", __FUNCTION__);
+    return static_cast<int>(OTAError::Portenta_ErrorOpenUpdateFile);
+  }
+  setvbuf(stream.file, nullptr, _IONBF, 0);
+
+  err = portenta_h7_receiveOTAData(client, content_length, bufs.data(), stream);
+  fclose(stream.file);
+  if (err != static_cast<int>(OTAError::None))
+  {
+    remove(OTA_UPDATE_FILE);
+    return err;
+  }
+  image_size = stream.image_size;
+  return static_cast<int>(OTAError::None);
+}
+
+/* Replaces Arduino_Portenta_OTA_QSPI::download() and decompress() */
+static int portenta_h7_streamOTA(char const * ota_url, NetworkAdapter iface, uint32_t & image_size)
+{
+  URL url;
+  char host[256];
+  char host_header[sizeof(host) + 8];
+  if (!url_parse(ota_url, url) || !url_copy(url.host, host, sizeof(host)) ||
+      !url_host_header(url, host_header, sizeof(host_header)) ||
+      !(url_equals(url.scheme, "https") || url_equals(url.scheme, "http")))
+  {
+    DEBUG_ERROR("%s: Failed to parse OTA URL %s", __FUNCTION__, ota_url);
+    return static_cast<int>(OTAError::Portenta_UrlParseError);
+  }
+  bool const is_https = url_equals(url.scheme, "https");
+  uint16_t const port = (url.port != 0) ? url.port : (is_https ? 443 : 80);
+
+#if defined (BOARD_HAS_ETHERNET)
+  if(iface == NetworkAdapter::ETHERNET) {
+    if (is_https) {
+      EthernetSSLClient client;
+      return portenta_h7_streamOTA(client, url, host, host_header, port, image_size);
+    }
+    EthernetClient client;
+    return portenta_h7_streamOTA(client, url, host, host_header, port, image_size);
+  }
+#else
+  (void)iface;
+#endif
+  if (is_https) {
+    WiFiSSLClient client;
+    return portenta_h7_streamOTA(client, url, host, host_header, port, image_size);
+  }
+  WiFiClient client;
+  return portenta_h7_streamOTA(client, url, host, host_header, port, image_size);
+}
+
+#endif /* AIOT_CONFIG_PORTENTA_OTA_STREAM_DECOMPRESSION */
+
 /******************************************************************************
  * FUNCTION DEFINITION
  ******************************************************************************/
@@ -73,6 +372,14 @@ int portenta_h7_onOTARequest(char const * ota_url, NetworkAdapter iface)
 
   watchdog_reset();
 
+#if AIOT_CONFIG_PORTENTA_OTA_STREAM_DECOMPRESSION
+  /* Download and decompress the OTA file straight into UPDATE.BIN. */
+  uint32_t ota_image_size = 0;
+  int const ota_portenta_stream_ret_code = portenta_h7_streamOTA(ota_url, iface, ota_image_size);
+  DEBUG_VERBOSE("portenta_h7_streamOTA(%s) returns %d, %d bytes", ota_url, ota_portenta_stream_ret_code, ota_image_size);
+  if (ota_portenta_stream_ret_code < 0)
+    return ota_portenta_stream_ret_code;
+#else
   /* Download the OTA file from the web storage location. */
   MbedSocketClass * download_socket = static_cast<MbedSocketClass*>(&WiFi);
 #if defined (BOARD_HAS_ETHERNET)
@@ -93,6 +400,7 @@ int portenta_h7_onOTARequest(char const * ota_url, NetworkAdapter iface)
     DEBUG_ERROR("Arduino_Portenta_OTA_QSPI::decompress() failed with %d", ota_portenta_qspi_decompress_ret_code);
     return ota_portenta_qspi_decompress_ret_code;
   }
+#endif
 
   watchdog_reset();
 
@@ -101,46 +409,41 @@ int portenta_h7_onOTARequest(char const * ota_url, NetworkAdapter iface)
     DEBUG_ERROR("Arduino_Portenta_OTA_QSPI::update() failed with %d", static_cast<int>(ota_portenta_err));
     return static_cast<int>(ota_portenta_err);
   }
+#if AIOT_CONFIG_PORTENTA_OTA_STREAM_DECOMPRESSION
+  /* Passed by decompress() otherwise, the application SHA256 relies on it */
+  HAL_RTCEx_BKUPWrite(&RTCHandle, RTC_BKP_DR3, ota_image_size);
+#endif
 
   /* Perform the reset to reboot - then the bootloader performs the actual application update. */
   NVIC_SystemReset();
 }
 
-String portenta_h7_getOTAImageSHA256()
+TaskStatus portenta_h7_pollOTAImageSHA256(String & sha256)
 {
-  /* The length of the application can be retrieved the same way it was
-   * communicated to the bootloader, that is by writing to the non-volatile
-   * storage registers of the RTC.
-   */
-  SHA256         sha256;
-  uint32_t const app_start = 0x8040000;
-  uint32_t const app_size  = HAL_RTCEx_BKUPRead(&RTCHandle, RTC_BKP_DR3);
-
-  sha256.begin();
-  uint32_t b = 0;
-  uint32_t bytes_read = 0; for(uint32_t a = app_start;
-                               bytes_read < app_size;
-                               bytes_read += sizeof(b), a += sizeof(b))
-  {
-    /* Read the next chunk of memory. */
-    memcpy(&b, reinterpret_cast<const void *>(a), sizeof(b));
-    /* Feed it to SHA256. */
-    sha256.update(reinterpret_cast<uint8_t *>(&b), sizeof(b));
-  }
-  /* Retrieve the final hash string. */
-  uint8_t sha256_hash[SHA256::HASH_SIZE] = {0};
-  sha256.finalize(sha256_hash);
-  String sha256_str;
-  std::for_each(sha256_hash,
-                sha256_hash + SHA256::HASH_SIZE,
-                [&sha256_str](uint8_t const elem)
-                {
-                  char buf[4];
-                  snprintf(buf, 4, "%02X", elem);
-                  sha256_str += buf;
-                });
-  DEBUG_VERBOSE("SHA256: %d bytes (of %d) read", bytes_read, app_size);
-  return sha256_str;
+  static FlashSHA256Task task;
+  static bool is_started = false;
+
+  if (!is_started)
+  {
+    /* The length of the application can be retrieved the same way it was
+     * communicated to the bootloader, that is by writing to the non-volatile
+     * storage registers of the RTC. The flash is memory mapped and hashed in
+     * whole words, as it always has been.
+     */
+    uint32_t const app_start = 0x8040000;
+    uint32_t const app_size  = HAL_RTCEx_BKUPRead(&RTCHandle, RTC_BKP_DR3);
+    uint32_t const bytes_read = (app_size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+    task.begin(reinterpret_cast<uint8_t const *>(app_start), bytes_read, OTA::SHA256_SLICE_SIZE);
+    is_started = true;
+    DEBUG_VERBOSE("SHA256: %d bytes (of %d) to read", bytes_read, app_size);
+  }
+
+  if (task.step() == TaskStatus::InProgress)
+    return TaskStatus::InProgress;
+
+  is_started = false;
+  sha256 = task.finalize();
+  return TaskStatus::Done;
 }
 
 bool portenta_h7_isOTACapable()
@@ -33,6 +33,221 @@
 #  include <WiFiNINA.h> /* WiFiStorage */
 #endif
 
+#ifdef HAS_SAMD_OTA_ASYNC
+#  include "utility/url/URLParser.h"
+#  include <algorithm>
+#endif
+
+#ifdef HAS_SAMD_OTA_ASYNC
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+/* SNU flashes UPDATE.BIN.LZSS, it only gets that name once verified */
+static char const OTA_UPDATE_FILE[]     = "/fs/UPDATE.BIN.LZSS";
+static char const OTA_UPDATE_TMP_FILE[] = "/fs/UPDATE.BIN.LZSS.TMP";
+
+/******************************************************************************
+ * LOCAL MODULE VARIABLES
+ ******************************************************************************/
+
+enum class OTADownloadState
+{
+  Idle,
+  ReceiveHeader,
+  ReceiveData
+};
+
+/* Header prepended to the image by extras/tools/bin2ota.py */
+union OTAHeader
+{
+  struct
+  {
+    uint32_t len;
+    uint32_t crc32;
+    uint32_t magic_number;
+    uint8_t  version[8];
+  } header;
+  uint8_t buf[20];
+};
+
+static OTADownloadState ota_state = OTADownloadState::Idle;
+static WiFiClient * ota_client = nullptr;
+static String ota_http_header;
+static unsigned long ota_state_start_tick = 0;
+static uint32_t ota_content_length = 0;
+static uint32_t ota_bytes_received = 0;
+static OTAHeader ota_header;
+static size_t ota_header_len = 0;
+static uint32_t ota_crc32 = 0xFFFFFFFF;
+static OTAMetrics ota_metrics = {0, 0, 0, 0, 0, 0, 0};
+
+/******************************************************************************
+ * LOCAL MODULE FUNCTIONS
+ ******************************************************************************/
+
+static uint32_t samd_crc32(uint32_t crc, uint8_t const * data, size_t const len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return crc;
+}
+
+static void samd_closeOTAClient()
+{
+  if (ota_client) {
+    ota_client->stop();
+    delete ota_client;
+    ota_client = nullptr;
+  }
+}
+
+static int samd_abortOTA(OTAError const err)
+{
+  if (ota_state == OTADownloadState::ReceiveHeader)
+    ota_metrics.header_ms += millis() - ota_state_start_tick;
+  else if (ota_state == OTADownloadState::ReceiveData)
+    ota_metrics.download_ms += millis() - ota_state_start_tick;
+
+  samd_closeOTAClient();
+  WiFiStorage.remove(OTA_UPDATE_TMP_FILE);
+  ota_state = OTADownloadState::Idle;
+  return static_cast<int>(err);
+}
+
+static int samd_onOTAHeader()
+{
+  /* Receive HTTP header, at most one chunk per call. */
+  if ((millis() - ota_state_start_tick) > AIOT_CONFIG_SAMD_OTA_HTTP_HEADER_RECEIVE_TIMEOUT_ms)
+  {
+    DEBUG_ERROR("%s: Error receiving HTTP header (timeout)", __FUNCTION__);
+    return samd_abortOTA(OTAError::SAMD_HttpHeaderError);
+  }
+
+  bool is_header_complete = false;
+  for (size_t i = 0; (i < AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE) && !is_header_complete && ota_client->available(); i++)
+  {
+    ota_http_header += static_cast<char>(ota_client->read());
+    is_header_complete = ota_http_header.endsWith("\r\n\r\n");
+  }
+
+  if (!is_header_complete)
+    return static_cast<int>(OTAError::None);
+
+  ota_metrics.header_ms += millis() - ota_state_start_tick;
+
+  /* The status line looks like "HTTP/1.1 200 OK" */
+  int http_status = 0;
+  char const * status_ptr = strchr(ota_http_header.c_str(), ' ');
+  if (status_ptr)
+    http_status = atoi(status_ptr + 1);
+  if (http_status != 200)
+  {
+    DEBUG_ERROR("%s: OTA storage server replied with HTTP %d", __FUNCTION__, http_status);
+    return samd_abortOTA(OTAError::SAMD_HttpHeaderError);
+  }
+
+  /* A typical entry looks like "Content-Length: 123456" */
+  char const * ptr = strstr(ota_http_header.c_str(), "Content-Length");
+  if (!ptr)
+  {
+    DEBUG_ERROR("%s: Failure to extract content length from http header", __FUNCTION__);
+    return samd_abortOTA(OTAError::SAMD_ErrorParseHttpHeader);
+  }
+  for (; (*ptr != '\0') && !isDigit(*ptr); ptr++) { }
+  ota_content_length = atoi(ptr);
+  DEBUG_VERBOSE("%s: Length of OTA binary according to HTTP header = %d bytes", __FUNCTION__, ota_content_length);
+
+  ota_http_header = "";
+  ota_state_start_tick = millis();
+  ota_state = OTADownloadState::ReceiveData;
+  return static_cast<int>(OTAError::None);
+}
+
+static int samd_onOTAData()
+{
+  /* Receive up to AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE bytes per call and
+   * append them to the file on the NINA module piece by piece.
+   */
+  bool const is_http_data_timeout = (millis() - ota_state_start_tick) > AIOT_CONFIG_SAMD_OTA_HTTP_DATA_RECEIVE_TIMEOUT_ms;
+  bool const is_connection_lost   = !ota_client->connected() && !ota_client->available();
+  if (is_http_data_timeout || is_connection_lost)
+  {
+    DEBUG_ERROR("%s: Error receiving HTTP data %s (%d bytes received, %d expected)", __FUNCTION__, is_http_data_timeout ? "(timeout)":"", ota_bytes_received, ota_content_length);
+    return samd_abortOTA(OTAError::SAMD_HttpDataError);
+  }
+
+  uint8_t buf[256];
+  for (size_t chunk = 0; (chunk < AIOT_CONFIG_OTA_DOWNLOAD_CHUNK_SIZE) && (ota_bytes_received < ota_content_length);)
+  {
+    int const bytes_available = ota_client->available();
+    if (bytes_available <= 0)
+      break;
+
+    size_t const bytes_to_read = std::min(std::min(static_cast<size_t>(bytes_available), sizeof(buf)), static_cast<size_t>(ota_content_length - ota_bytes_received));
+    int const bytes_read = ota_client->read(buf, bytes_to_read);
+    if (bytes_read <= 0)
+      break;
+
+    /* The CRC covers everything following the length and CRC fields */
+    for (int i = 0; i < bytes_read; i++)
+    {
+      if (ota_header_len < sizeof(ota_header.buf))
+        ota_header.buf[ota_header_len++] = buf[i];
+      if ((ota_bytes_received + i) >= 8)
+        ota_crc32 = samd_crc32(ota_crc32, buf + i, 1);
+    }
+
+    if (!WiFiStorage.write(OTA_UPDATE_TMP_FILE, ota_bytes_received, buf, bytes_read))
+    {
+      DEBUG_ERROR("%s: Writing of firmware image to NINA failed", __FUNCTION__);
+      return samd_abortOTA(OTAError::SAMD_ErrorWriteUpdateFile);
+    }
+
+    ota_bytes_received += bytes_read;
+    ota_metrics.bytes += bytes_read;
+    chunk += bytes_read;
+  }
+
+  if (ota_bytes_received < ota_content_length)
+    return static_cast<int>(OTAError::None);
+
+  ota_metrics.download_ms += millis() - ota_state_start_tick;
+  samd_closeOTAClient();
+
+  unsigned long const verify_start = millis();
+  if ((ota_header_len < sizeof(ota_header.buf)) || (ota_header.header.len != (ota_content_length - sizeof(ota_header.buf))))
+  {
+    DEBUG_ERROR("%s: OTA image length mismatch", __FUNCTION__);
+    return samd_abortOTA(OTAError::SAMD_ErrorHeader);
+  }
+  if (~ota_crc32 != ota_header.header.crc32)
+  {
+    DEBUG_ERROR("%s: OTA image CRC mismatch", __FUNCTION__);
+    return samd_abortOTA(OTAError::SAMD_ErrorCrc);
+  }
+  ota_metrics.verify_ms = millis() - verify_start;
+
+  if (!WiFiStorage.rename(OTA_UPDATE_TMP_FILE, OTA_UPDATE_FILE))
+  {
+    DEBUG_ERROR("%s: Renaming of firmware image on NINA failed", __FUNCTION__);
+    return samd_abortOTA(OTAError::SAMD_ErrorRenameUpdateFile);
+  }
+
+  ota_state = OTADownloadState::Idle;
+
+  /* Perform the reset to reboot to SxU. */
+  NVIC_SystemReset();
+  return static_cast<int>(OTAError::None);
+}
+
+#endif /* HAS_SAMD_OTA_ASYNC */
+
 /******************************************************************************
  * FUNCTION DEFINITION
  ******************************************************************************/
@@ -66,8 +281,113 @@ int samd_onOTARequest(char const * ota_url)
   return static_cast<int>(OTAError::DownloadFailed);
 }
 
-String samd_getOTAImageSHA256()
+#ifdef HAS_SAMD_OTA_ASYNC
+int samd_onOTAStart(char const * ota_url)
 {
+  watchdog_reset();
+
+  /* Just to be safe delete any remains from previous updates. */
+  samd_closeOTAClient();
+  WiFiStorage.remove(OTA_UPDATE_FILE);
+  WiFiStorage.remove(OTA_UPDATE_TMP_FILE);
+
+  ota_state = OTADownloadState::Idle;
+  ota_content_length = 0;
+  ota_bytes_received = 0;
+  ota_header_len = 0;
+  ota_crc32 = 0xFFFFFFFF;
+  ota_metrics = OTAMetrics{0, 0, 0, 0, 0, 0, 0};
+
+  URL url;
+  char host[256];
+  char host_header[sizeof(host) + 8];
+  if (!url_parse(ota_url, url) || !url_copy(url.host, host, sizeof(host)) ||
+      !url_host_header(url, host_header, sizeof(host_header))) {
+    DEBUG_ERROR("%s: Failed to parse OTA URL %s", __FUNCTION__, ota_url);
+    return static_cast<int>(OTAError::SAMD_UrlParseError);
+  }
+
+  int port = 0;
+  if (url_equals(url.scheme, "http")) {
+    ota_client = new WiFiClient();
+    port = 80;
+  } else if (url_equals(url.scheme, "https")) {
+    ota_client = new WiFiSSLClient();
+    port = 443;
+  } else {
+    DEBUG_ERROR("%s: Failed to parse OTA URL %s", __FUNCTION__, ota_url);
+    return static_cast<int>(OTAError::SAMD_UrlParseError);
+  }
+  if (url.port != 0)
+    port = url.port;
+
+  watchdog_reset();
+
+  unsigned long const connect_start = millis();
+  bool const is_connected = ota_client->connect(host, port);
+  ota_metrics.connect_ms = millis() - connect_start;
+  if (!is_connected)
+  {
+    DEBUG_ERROR("%s: Connection failure with OTA storage server %s", __FUNCTION__, host);
+    return samd_abortOTA(OTAError::SAMD_ServerConnectError);
+  }
+
+  watchdog_reset();
+
+  /* Send the request piece by piece instead of concatenating Strings */
+  ota_client->print("GET ");
+  if (url.path.len > 0)
+    ota_client->write(reinterpret_cast<uint8_t const *>(url.path.str), url.path.len);
+  else
+    ota_client->print("/");
+  if (url.query.len > 0) {
+    ota_client->print("?");
+    ota_client->write(reinterpret_cast<uint8_t const *>(url.query.str), url.query.len);
+  }
+  ota_client->println(" HTTP/1.1");
+  ota_client->print("Host: ");
+  ota_client->println(host_header);
+  ota_client->println("Connection: close");
+  ota_client->println();
+
+  ota_http_header = "";
+  ota_state_start_tick = millis();
+  ota_state = OTADownloadState::ReceiveHeader;
+  return static_cast<int>(OTAError::None);
+}
+
+int samd_onOTAPoll(bool & is_in_progress)
+{
+  watchdog_reset();
+
+  int err = static_cast<int>(OTAError::None);
+  if (ota_state == OTADownloadState::ReceiveHeader)
+    err = samd_onOTAHeader();
+  else if (ota_state == OTADownloadState::ReceiveData)
+    err = samd_onOTAData();
+
+  is_in_progress = (ota_state != OTADownloadState::Idle);
+  return err;
+}
+
+int samd_getOTAProgress()
+{
+  if ((ota_state != OTADownloadState::ReceiveData) || (ota_content_length == 0))
+    return -1;
+  return static_cast<int>((static_cast<uint64_t>(ota_bytes_received) * 100) / ota_content_length);
+}
+
+OTAMetrics samd_getOTAMetrics()
+{
+  return ota_metrics;
+}
+#endif /* HAS_SAMD_OTA_ASYNC */
+
+TaskStatus samd_pollOTAImageSHA256(String & sha256)
+{
+  static FlashSHA256Task task;
+  static bool is_started = false;
+
   /* Calculate the SHA256 checksum over the firmware stored in the flash of the
    * MCU. Note: As we don't know the length per-se we read chunks of the flash
    * until we detect one containing only 0xFF (= flash erased). This only works
@@ -78,7 +398,20 @@ String samd_getOTAImageSHA256()
    * The bootloader is excluded from the calculation and occupies flash address
    * range 0 to 0x2000, total flash size of 0x40000 bytes (256 kByte).
    */
-  return FlashSHA256::calc(0x2000, 0x40000 - 0x2000);
+  if (!is_started)
+  {
+    uint32_t const image_size = FlashSHA256::imageSize(0x2000, 0x40000 - 0x2000);
+    task.begin(reinterpret_cast<uint8_t const *>(0x2000), image_size, OTA::SHA256_SLICE_SIZE);
+    is_started = true;
+    DEBUG_VERBOSE("SHA256: %d bytes to read", image_size);
+  }
+
+  if (task.step() == TaskStatus::InProgress)
+    return TaskStatus::InProgress;
+
+  is_started = false;
+  sha256 = task.finalize();
+  return TaskStatus::Done;
 }
 
 bool samd_isOTACapable()
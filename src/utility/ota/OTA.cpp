@@ -32,29 +32,74 @@
 
 #ifdef ARDUINO_ARCH_SAMD
 int samd_onOTARequest(char const * url);
-String samd_getOTAImageSHA256();
+TaskStatus samd_pollOTAImageSHA256(String & sha256);
 bool samd_isOTACapable();
+#ifdef HAS_SAMD_OTA_ASYNC
+int samd_onOTAStart(char const * url);
+int samd_onOTAPoll(bool & is_in_progress);
+int samd_getOTAProgress();
+OTAMetrics samd_getOTAMetrics();
+#endif
 #endif
 
 #ifdef ARDUINO_NANO_RP2040_CONNECT
 int rp2040_connect_onOTARequest(char const * url);
-String rp2040_connect_getOTAImageSHA256();
+int rp2040_connect_onOTAStart(char const * url, bool const is_apply, char const * sha256);
+bool rp2040_connect_isOTAStaged(char const * url);
+int rp2040_connect_onOTAApply();
+int rp2040_connect_onOTAPoll(bool & is_in_progress);
+int rp2040_connect_getOTAProgress();
+OTAMetrics rp2040_connect_getOTAMetrics();
+TaskStatus rp2040_connect_pollOTAImageSHA256(String & sha256);
 bool rp2040_connect_isOTACapable();
 #endif
 
 #ifdef BOARD_STM32H7
 int portenta_h7_onOTARequest(char const * url, NetworkAdapter iface);
-String portenta_h7_getOTAImageSHA256();
+TaskStatus portenta_h7_pollOTAImageSHA256(String & sha256);
 void portenta_h7_setNetworkAdapter(NetworkAdapter iface);
 bool portenta_h7_isOTACapable();
 #endif
 
 #ifdef ARDUINO_ARCH_ESP32
 int esp32_onOTARequest(char const * url);
-String esp32_getOTAImageSHA256();
+TaskStatus esp32_pollOTAImageSHA256(String & sha256);
 bool esp32_isOTACapable();
+#ifdef HAS_ESP32_OTA_ASYNC
+void esp32_setOTACACert(char const * ca_cert);
+int esp32_onOTAStart(char const * url);
+int esp32_onOTAPoll(bool & is_in_progress);
+int esp32_getOTAProgress();
+OTAMetrics esp32_getOTAMetrics();
+#endif
 #endif
 
+/******************************************************************************
+ * INTERNAL CLASS
+ ******************************************************************************/
+
+/* Runs OTA::pollImageSHA256 to completion, feeding the watchdog in between */
+class ImageSHA256Task : public CooperativeTask
+{
+public:
+
+  virtual TaskStatus step() override { return OTA::pollImageSHA256(sha256); }
+
+  String sha256;
+
+};
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+constexpr uint32_t OTA::SHA256_SLICE_SIZE;
+
+bool OTA::_is_in_progress = false;
+String OTA::_url;
+NetworkAdapter OTA::_iface;
+OTAMetrics OTA::_metrics = {0, 0, 0, 0, 0, 0, 0};
+
 /******************************************************************************
  * PUBLIC MEMBER FUNCTIONS
  ******************************************************************************/
@@ -80,15 +125,22 @@ int OTA::onRequest(String url, NetworkAdapter iface)
 }
 
 String OTA::getImageSHA256()
+{
+  ImageSHA256Task task;
+  TaskRunner().run(task);
+  return task.sha256;
+}
+
+TaskStatus OTA::pollImageSHA256(String & sha256)
 {
 #if defined (ARDUINO_ARCH_SAMD)
-  return samd_getOTAImageSHA256();
+  return samd_pollOTAImageSHA256(sha256);
 #elif defined (ARDUINO_NANO_RP2040_CONNECT)
-  return rp2040_connect_getOTAImageSHA256();
+  return rp2040_connect_pollOTAImageSHA256(sha256);
 #elif defined (BOARD_STM32H7)
-  return portenta_h7_getOTAImageSHA256();
+  return portenta_h7_pollOTAImageSHA256(sha256);
 #elif defined (ARDUINO_ARCH_ESP32)
-  return esp32_getOTAImageSHA256();
+  return esp32_pollOTAImageSHA256(sha256);
 #else
   #error "No method for SHA256 checksum calculation over application image defined for this architecture."
 #endif
@@ -109,4 +161,149 @@ bool OTA::isCapable()
 #endif
 }
 
+bool OTA::isSHA256Verifiable()
+{
+  /* The other backends flash the image while they download it */
+#if defined (ARDUINO_NANO_RP2040_CONNECT)
+  return true;
+#else
+  return false;
+#endif
+}
+
+int OTA::start(String url, NetworkAdapter iface, String const & sha256)
+{
+  DEBUG_INFO("ArduinoIoTCloudTCP::%s _ota_url = %s", __FUNCTION__, url.c_str());
+
+  if ((sha256.length() > 0) && !isSHA256Verifiable())
+  {
+    DEBUG_ERROR("ArduinoIoTCloudTCP::%s the image can't be verified against its SHA256", __FUNCTION__);
+    return static_cast<int>(OTAError::DownloadFailed);
+  }
+
+#if defined (ARDUINO_NANO_RP2040_CONNECT)
+  (void)iface;
+  int const err = rp2040_connect_onOTAStart(url.c_str(), true, sha256.c_str());
+  _is_in_progress = (err == static_cast<int>(OTAError::None));
+  return err;
+#elif defined (HAS_SAMD_OTA_ASYNC)
+  (void)iface;
+  int const err = samd_onOTAStart(url.c_str());
+  _is_in_progress = (err == static_cast<int>(OTAError::None));
+  return err;
+#elif defined (HAS_ESP32_OTA_ASYNC)
+  (void)iface;
+  int const err = esp32_onOTAStart(url.c_str());
+  _is_in_progress = (err == static_cast<int>(OTAError::None));
+  return err;
+#else
+  /* The download is performed at once by the first call to poll() */
+  _url = url;
+  _iface = iface;
+  _is_in_progress = true;
+  return static_cast<int>(OTAError::None);
+#endif
+}
+
+int OTA::poll()
+{
+  if (!_is_in_progress)
+    return static_cast<int>(OTAError::None);
+
+#if defined (ARDUINO_NANO_RP2040_CONNECT)
+  return rp2040_connect_onOTAPoll(_is_in_progress);
+#elif defined (HAS_SAMD_OTA_ASYNC)
+  return samd_onOTAPoll(_is_in_progress);
+#elif defined (HAS_ESP32_OTA_ASYNC)
+  return esp32_onOTAPoll(_is_in_progress);
+#else
+  _is_in_progress = false;
+  String const url = _url;
+  _url = "";
+  /* Only the duration of the whole download is known */
+  unsigned long const start = millis();
+  int const err = onRequest(url, _iface);
+  _metrics.download_ms = millis() - start;
+  return err;
+#endif
+}
+
+#ifdef HAS_OTA_PREFETCH
+int OTA::prefetch(String url, NetworkAdapter iface, String const & sha256)
+{
+  DEBUG_INFO("ArduinoIoTCloudTCP::%s _ota_url = %s", __FUNCTION__, url.c_str());
+  (void)iface;
+  int const err = rp2040_connect_onOTAStart(url.c_str(), false, sha256.c_str());
+  _is_in_progress = (err == static_cast<int>(OTAError::None));
+  return err;
+}
+
+bool OTA::isStaged(String const & url)
+{
+  return rp2040_connect_isOTAStaged(url.c_str());
+}
+
+int OTA::apply()
+{
+  return rp2040_connect_onOTAApply();
+}
+#endif
+
+#ifdef HAS_ESP32_OTA_ASYNC
+void OTA::setCACert(char const * ca_cert)
+{
+  esp32_setOTACACert(ca_cert);
+}
+#endif
+
+bool OTA::isInProgress()
+{
+  return _is_in_progress;
+}
+
+int OTA::progress()
+{
+#if defined (ARDUINO_NANO_RP2040_CONNECT)
+  return _is_in_progress ? rp2040_connect_getOTAProgress() : -1;
+#elif defined (HAS_SAMD_OTA_ASYNC)
+  return _is_in_progress ? samd_getOTAProgress() : -1;
+#elif defined (HAS_ESP32_OTA_ASYNC)
+  return _is_in_progress ? esp32_getOTAProgress() : -1;
+#else
+  return -1;
+#endif
+}
+
+OTAMetrics OTA::metrics()
+{
+#if defined (ARDUINO_NANO_RP2040_CONNECT)
+  return rp2040_connect_getOTAMetrics();
+#elif defined (HAS_SAMD_OTA_ASYNC)
+  return samd_getOTAMetrics();
+#elif defined (HAS_ESP32_OTA_ASYNC)
+  return esp32_getOTAMetrics();
+#else
+  return _metrics;
+#endif
+}
+
+String OTA::toString(OTAMetrics const & metrics)
+{
+  if (!metrics.connect_ms && !metrics.header_ms && !metrics.download_ms && !metrics.bytes)
+    return String("");
+
+  unsigned long const bytes_per_sec = metrics.download_ms ? static_cast<unsigned long>((static_cast<uint64_t>(metrics.bytes) * 1000) / metrics.download_ms) : 0;
+  char buf[160];
+  snprintf(buf, sizeof(buf), "connect_ms=%lu;header_ms=%lu;download_ms=%lu;bytes=%lu;bytes_per_sec=%lu;flash_write_ms=%lu;decode_ms=%lu;verify_ms=%lu",
+    static_cast<unsigned long>(metrics.connect_ms),
+    static_cast<unsigned long>(metrics.header_ms),
+    static_cast<unsigned long>(metrics.download_ms),
+    static_cast<unsigned long>(metrics.bytes),
+    bytes_per_sec,
+    static_cast<unsigned long>(metrics.flash_write_ms),
+    static_cast<unsigned long>(metrics.decode_ms),
+    static_cast<unsigned long>(metrics.verify_ms));
+  return String(buf);
+}
+
 #endif /* OTA_ENABLED */
@@ -28,11 +28,16 @@
 #include <Arduino.h>
 #include <Arduino_ConnectionHandler.h>
 
+#include "../task/CooperativeTask.h"
+
 /******************************************************************************
  * DEFINES
  ******************************************************************************/
 
 #define RP2040_OTA_ERROR_BASE (-100)
+#define PORTENTA_OTA_ERROR_BASE (-200)
+#define SAMD_OTA_ERROR_BASE (-300)
+#define ESP32_OTA_ERROR_BASE (-400)
 
 /******************************************************************************
  * TYPEDEF
@@ -52,6 +57,54 @@ enum class OTAError : int
   RP2040_ErrorFlashInit       = RP2040_OTA_ERROR_BASE - 7,
   RP2040_ErrorReformat        = RP2040_OTA_ERROR_BASE - 8,
   RP2040_ErrorUnmount         = RP2040_OTA_ERROR_BASE - 9,
+  RP2040_ErrorHeader          = RP2040_OTA_ERROR_BASE - 10,
+  RP2040_ErrorCrc             = RP2040_OTA_ERROR_BASE - 11,
+  RP2040_ErrorDelta           = RP2040_OTA_ERROR_BASE - 12,
+  RP2040_ErrorDeltaSource     = RP2040_OTA_ERROR_BASE - 13,
+  RP2040_ErrorNoMemory        = RP2040_OTA_ERROR_BASE - 14,
+  RP2040_ErrorSHA256          = RP2040_OTA_ERROR_BASE - 15,
+  Portenta_UrlParseError        = PORTENTA_OTA_ERROR_BASE - 0,
+  Portenta_ServerConnectError   = PORTENTA_OTA_ERROR_BASE - 1,
+  Portenta_HttpHeaderError      = PORTENTA_OTA_ERROR_BASE - 2,
+  Portenta_HttpDataError        = PORTENTA_OTA_ERROR_BASE - 3,
+  Portenta_ErrorOpenUpdateFile  = PORTENTA_OTA_ERROR_BASE - 4,
+  Portenta_ErrorWriteUpdateFile = PORTENTA_OTA_ERROR_BASE - 5,
+  Portenta_ErrorParseHttpHeader = PORTENTA_OTA_ERROR_BASE - 6,
+  Portenta_ErrorHeader          = PORTENTA_OTA_ERROR_BASE - 7,
+  Portenta_ErrorCrc             = PORTENTA_OTA_ERROR_BASE - 8,
+  Portenta_ErrorNoMemory        = PORTENTA_OTA_ERROR_BASE - 9,
+  SAMD_UrlParseError            = SAMD_OTA_ERROR_BASE - 0,
+  SAMD_ServerConnectError       = SAMD_OTA_ERROR_BASE - 1,
+  SAMD_HttpHeaderError          = SAMD_OTA_ERROR_BASE - 2,
+  SAMD_HttpDataError            = SAMD_OTA_ERROR_BASE - 3,
+  SAMD_ErrorWriteUpdateFile     = SAMD_OTA_ERROR_BASE - 4,
+  SAMD_ErrorParseHttpHeader     = SAMD_OTA_ERROR_BASE - 5,
+  SAMD_ErrorHeader              = SAMD_OTA_ERROR_BASE - 6,
+  SAMD_ErrorCrc                 = SAMD_OTA_ERROR_BASE - 7,
+  SAMD_ErrorRenameUpdateFile    = SAMD_OTA_ERROR_BASE - 8,
+  ESP32_UrlParseError           = ESP32_OTA_ERROR_BASE - 0,
+  ESP32_ServerConnectError      = ESP32_OTA_ERROR_BASE - 1,
+  ESP32_HttpHeaderError         = ESP32_OTA_ERROR_BASE - 2,
+  ESP32_HttpDataError           = ESP32_OTA_ERROR_BASE - 3,
+  ESP32_ErrorPartition          = ESP32_OTA_ERROR_BASE - 4,
+  ESP32_ErrorWriteUpdate        = ESP32_OTA_ERROR_BASE - 5,
+  ESP32_ErrorParseHttpHeader    = ESP32_OTA_ERROR_BASE - 6,
+  ESP32_ErrorHeader             = ESP32_OTA_ERROR_BASE - 7,
+  ESP32_ErrorCrc                = ESP32_OTA_ERROR_BASE - 8,
+  ESP32_ErrorImage              = ESP32_OTA_ERROR_BASE - 9,
+  ESP32_ErrorNoMemory           = ESP32_OTA_ERROR_BASE - 10,
+};
+
+/* Durations of the phases of the last OTA download, 0 if not known */
+struct OTAMetrics
+{
+  uint32_t connect_ms;     /* Connecting to the storage server */
+  uint32_t header_ms;      /* Waiting for and receiving the HTTP header */
+  uint32_t download_ms;    /* Receiving the image, including writing and decoding it */
+  uint32_t bytes;          /* Bytes received */
+  uint32_t flash_write_ms; /* Writing the image to flash */
+  uint32_t decode_ms;      /* Decompressing, patching and hashing the image */
+  uint32_t verify_ms;      /* Checking the image against its CRC32 and source */
 };
 
 /******************************************************************************
@@ -66,6 +119,60 @@ public:
   static String getImageSHA256();
   static bool isCapable();
 
+  /* Non-blocking variant of getImageSHA256: each call hashes up to
+   * SHA256_SLICE_SIZE bytes of the running image. It returns Done once the
+   * hash is in sha256 and Error if it can't be computed, the next call
+   * starts over.
+   */
+  static TaskStatus pollImageSHA256(String & sha256);
+  static constexpr uint32_t SHA256_SLICE_SIZE = 4 * 1024;
+
+  /* Non-blocking variant of onRequest: start() prepares the download and
+   * poll() advances it by a bounded chunk each time it is called, both
+   * return an error code != OTAError::None on failure. Once the download
+   * completes the board is reset. Backends whose download can't be split
+   * perform it entirely within the first call to poll().
+   *
+   * If sha256 is not empty the image is dropped instead of being applied
+   * unless its application hashes to it, in the format of getImageSHA256().
+   * Only backends for which isSHA256Verifiable() holds accept one.
+   */
+  static int start(String url, NetworkAdapter iface, String const & sha256 = String(""));
+  static bool isSHA256Verifiable();
+  static int poll();
+  static bool isInProgress();
+  /* Download progress in percent, -1 if the size is not known (yet) */
+  static int progress();
+  /* Metrics of the last download, a successful one is reported after the
+   * reset into the new firmware if the backend is able to keep them.
+   */
+  static OTAMetrics metrics();
+  static String toString(OTAMetrics const & metrics);
+
+#ifdef HAS_OTA_PREFETCH
+  /* Downloads and verifies the image like start() and poll(), but keeps it
+   * staged instead of resetting into it. apply() then only resets into the
+   * staged image, it returns an error if there is none.
+   */
+  static int prefetch(String url, NetworkAdapter iface, String const & sha256 = String(""));
+  static bool isStaged(String const & url);
+  static int apply();
+#endif
+
+#ifdef HAS_ESP32_OTA_ASYNC
+  /* The root the server of an image is verified against besides the one of
+   * the OTA storage, e.g. the one set for MQTT. nullptr trusts only the latter.
+   */
+  static void setCACert(char const * ca_cert);
+#endif
+
+private:
+
+  static bool _is_in_progress;
+  static String _url;
+  static NetworkAdapter _iface;
+  static OTAMetrics _metrics;
+
 };
 
 #endif /* OTA_ENABLED */
@@ -0,0 +1,59 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "OTAUrlSHA256.h"
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+OTAUrlSHA256::OTAUrlSHA256()
+: _sha256{""}
+, _url{""}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void OTAUrlSHA256::onMessage(String const & sha256, String const & url)
+{
+  /* The same hash sent again with another url is not told apart from a
+   * message without one, it is not taken for the new url then.
+   */
+  if (_sha256 != sha256)
+    _url = url;
+}
+
+String OTAUrlSHA256::get(String const & url) const
+{
+  if ((_sha256.length() == 0) || (_url != url))
+    return String("");
+  return _sha256;
+}
+
+void OTAUrlSHA256::consume()
+{
+  _sha256 = "";
+  _url = "";
+}
@@ -0,0 +1,61 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_OTA_URL_SHA256_H_
+#define ARDUINO_OTA_URL_SHA256_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* The SHA256 the cloud sends as OTA_URL_SHA256 along with an OTA_URL. It only
+ * holds for the url which is current once the message writing it has been
+ * decoded, a later url received without a hash of its own has none, and it
+ * is consumed by the request it is handed on to.
+ */
+class OTAUrlSHA256
+{
+
+public:
+
+  OTAUrlSHA256();
+
+  /* The value written by the cloud, wrapped by the property */
+  inline String & value() { return _sha256; }
+
+  /* To be called after each message of the device topic, sha256 is the
+   * value before the message was decoded and url the current OTA_URL.
+   */
+  void onMessage(String const & sha256, String const & url);
+  /* The hash of the image at url, empty if none was received along with it */
+  String get(String const & url) const;
+  void consume();
+
+private:
+
+  String _sha256;
+  String _url;
+
+};
+
+#endif /* ARDUINO_OTA_URL_SHA256_H_ */
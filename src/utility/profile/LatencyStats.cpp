@@ -0,0 +1,64 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "LatencyStats.h"
+
+#include <string.h>
+
+#undef max
+#undef min
+#include <algorithm>
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+LatencyStats::LatencyStats()
+: _next{0}
+, _cnt{0}
+{
+  memset(_sample, 0, sizeof(_sample));
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void LatencyStats::add(uint32_t const sample)
+{
+  _sample[_next] = sample;
+  _next = (_next + 1) % SAMPLE_CNT;
+  if (_cnt < SAMPLE_CNT)
+    _cnt++;
+}
+
+uint32_t LatencyStats::percentile(uint8_t const p) const
+{
+  if ((_cnt == 0) || (p == 0))
+    return 0;
+
+  uint32_t sorted[SAMPLE_CNT];
+  memcpy(sorted, _sample, _cnt * sizeof(uint32_t));
+  std::sort(sorted, sorted + _cnt);
+
+  size_t const rank = (static_cast<size_t>(std::min<uint8_t>(p, 100)) * _cnt + 99) / 100;
+  return sorted[rank - 1];
+}
@@ -0,0 +1,59 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_LATENCY_STATS_H_
+#define ARDUINO_AIOTC_UTILITY_LATENCY_STATS_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Rolling percentiles of the most recent latency samples. The samples are
+ * only sorted when a percentile is asked for, i.e. when they are reported.
+ */
+class LatencyStats
+{
+public:
+
+  static size_t const SAMPLE_CNT = AIOT_CONFIG_LATENCY_SAMPLES;
+
+  LatencyStats();
+
+  /* Replaces the oldest sample once SAMPLE_CNT samples have been taken */
+  void add(uint32_t const sample);
+  /* Nearest-rank percentile 1..100 of the recent samples, 0 if there are none */
+  uint32_t percentile(uint8_t const p) const;
+
+  inline size_t size() const { return _cnt; }
+
+private:
+
+  uint32_t _sample[SAMPLE_CNT];
+  size_t _next;
+  size_t _cnt;
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_LATENCY_STATS_H_ */
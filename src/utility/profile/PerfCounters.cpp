@@ -0,0 +1,139 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "PerfCounters.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+PerfCounters::PerfCounters()
+: _msg_tx{0}
+, _msg_rx{0}
+, _bytes_tx{0}
+, _bytes_rx{0}
+, _encode_us{0}
+, _decode_us{0}
+, _retransmits{0}
+, _reconnects{0}
+, _connect_ms{0}
+, _update_max_us{0}
+, _state{0}
+, _state_tick{0}
+, _is_state_tick_valid{false}
+, _cloud_to_device_ms{}
+, _callback_us{}
+{
+  memset(_state_ms, 0, sizeof(_state_ms));
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void PerfCounters::onSend(size_t const bytes)
+{
+  _msg_tx++;
+  _bytes_tx += bytes;
+}
+
+void PerfCounters::onReceive(size_t const bytes, unsigned long const decode_us)
+{
+  _msg_rx++;
+  _bytes_rx += bytes;
+  _decode_us += decode_us;
+}
+
+void PerfCounters::onEncode(unsigned long const encode_us)
+{
+  _encode_us += encode_us;
+}
+
+void PerfCounters::onRetransmit()
+{
+  _retransmits++;
+}
+
+void PerfCounters::onReconnect()
+{
+  _reconnects++;
+}
+
+void PerfCounters::onConnect(unsigned long const connect_ms)
+{
+  _connect_ms = connect_ms;
+}
+
+void PerfCounters::onUpdate(uint8_t const state, unsigned long const now_ms)
+{
+  if (_is_state_tick_valid && (_state < STATE_CNT))
+    _state_ms[_state] += now_ms - _state_tick;
+  _state = state;
+  _state_tick = now_ms;
+  _is_state_tick_valid = true;
+}
+
+void PerfCounters::onUpdateDone(unsigned long const duration_us)
+{
+  if (duration_us > _update_max_us)
+    _update_max_us = duration_us;
+}
+
+void PerfCounters::onCommand(unsigned long const cloud_to_device_ms, unsigned long const callback_us)
+{
+  if (cloud_to_device_ms != ULONG_MAX)
+    _cloud_to_device_ms.add(static_cast<uint32_t>(cloud_to_device_ms));
+  _callback_us.add(static_cast<uint32_t>(callback_us));
+}
+
+String PerfCounters::toString() const
+{
+  char buf[416];
+  int len = snprintf(buf, sizeof(buf), "msg_tx=%lu;msg_rx=%lu;bytes_tx=%lu;bytes_rx=%lu;encode_us=%lu;decode_us=%lu;retransmits=%lu;reconnects=%lu;connect_ms=%lu;update_max_us=%lu;state_ms=",
+    static_cast<unsigned long>(_msg_tx),
+    static_cast<unsigned long>(_msg_rx),
+    static_cast<unsigned long>(_bytes_tx),
+    static_cast<unsigned long>(_bytes_rx),
+    static_cast<unsigned long>(_encode_us),
+    static_cast<unsigned long>(_decode_us),
+    static_cast<unsigned long>(_retransmits),
+    static_cast<unsigned long>(_reconnects),
+    static_cast<unsigned long>(_connect_ms),
+    static_cast<unsigned long>(_update_max_us));
+
+  for (size_t s = 0; (s < STATE_CNT) && (len > 0) && (static_cast<size_t>(len) < sizeof(buf)); s++)
+    len += snprintf(buf + len, sizeof(buf) - len, (s == 0) ? "%lu" : "/%lu", static_cast<unsigned long>(_state_ms[s]));
+
+  if ((len > 0) && (static_cast<size_t>(len) < sizeof(buf)))
+    snprintf(buf + len, sizeof(buf) - len, ";c2d_ms=%lu/%lu/%lu;callback_us=%lu/%lu/%lu",
+      static_cast<unsigned long>(_cloud_to_device_ms.percentile(50)),
+      static_cast<unsigned long>(_cloud_to_device_ms.percentile(95)),
+      static_cast<unsigned long>(_cloud_to_device_ms.percentile(99)),
+      static_cast<unsigned long>(_callback_us.percentile(50)),
+      static_cast<unsigned long>(_callback_us.percentile(95)),
+      static_cast<unsigned long>(_callback_us.percentile(99)));
+
+  return String(buf);
+}
@@ -0,0 +1,99 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_PERF_COUNTERS_H_
+#define ARDUINO_AIOTC_UTILITY_PERF_COUNTERS_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+#include "LatencyStats.h"
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Cheap running totals of the traffic and the timing of the connection,
+ * reported to the cloud as a hidden device property.
+ */
+class PerfCounters
+{
+public:
+
+  static size_t const STATE_CNT = 12;
+
+  PerfCounters();
+
+  void onSend      (size_t const bytes);
+  void onReceive   (size_t const bytes, unsigned long const decode_us);
+  void onEncode    (unsigned long const encode_us);
+  void onRetransmit();
+  void onReconnect ();
+  /* Duration of a successful connection to the broker, including the TLS handshake */
+  void onConnect   (unsigned long const connect_ms);
+  /* Called at the start of each update(), the time since the previous one
+   * is accounted to the state the previous update() ended in.
+   */
+  void onUpdate    (uint8_t const state, unsigned long const now_ms);
+  /* Duration of an update() which has returned */
+  void onUpdateDone(unsigned long const duration_us);
+  /* A change received from the cloud whose callback ran, the latency from the
+   * cloud is ULONG_MAX if the change has not been timestamped by the cloud.
+   */
+  void onCommand   (unsigned long const cloud_to_device_ms, unsigned long const callback_us);
+
+  inline uint32_t messagesSent    () const { return _msg_tx; }
+  inline uint32_t messagesReceived() const { return _msg_rx; }
+  inline uint32_t bytesSent       () const { return _bytes_tx; }
+  inline uint32_t bytesReceived   () const { return _bytes_rx; }
+  inline uint32_t retransmits     () const { return _retransmits; }
+  inline uint32_t reconnects      () const { return _reconnects; }
+  inline uint32_t updateMaxMicros () const { return _update_max_us; }
+  inline uint32_t stateMillis     (uint8_t const state) const { return state < STATE_CNT ? _state_ms[state] : 0; }
+  inline LatencyStats const & cloudToDeviceMillis() const { return _cloud_to_device_ms; }
+  inline LatencyStats const & callbackMicros     () const { return _callback_us; }
+
+  /* "msg_tx=..;msg_rx=..;bytes_tx=..;bytes_rx=..;encode_us=..;decode_us=..;
+   *  retransmits=..;reconnects=..;connect_ms=..;update_max_us=..;state_ms=<s0>/../<s11>;
+   *  c2d_ms=<p50>/<p95>/<p99>;callback_us=<p50>/<p95>/<p99>"
+   */
+  String toString() const;
+
+private:
+
+  uint32_t _msg_tx;
+  uint32_t _msg_rx;
+  uint32_t _bytes_tx;
+  uint32_t _bytes_rx;
+  uint32_t _encode_us;
+  uint32_t _decode_us;
+  uint32_t _retransmits;
+  uint32_t _reconnects;
+  uint32_t _connect_ms;
+  uint32_t _update_max_us;
+  uint32_t _state_ms[STATE_CNT];
+  uint8_t  _state;
+  unsigned long _state_tick;
+  bool _is_state_tick_valid;
+  LatencyStats _cloud_to_device_ms;
+  LatencyStats _callback_us;
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_PERF_COUNTERS_H_ */
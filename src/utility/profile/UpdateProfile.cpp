@@ -0,0 +1,75 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "UpdateProfile.h"
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+ProfileCounter::ProfileCounter()
+: _count{0}
+, _total_us{0}
+, _max_us{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void ProfileCounter::add(unsigned long const duration_us)
+{
+  _count++;
+  _total_us += duration_us;
+  if (duration_us > _max_us)
+    _max_us = duration_us;
+}
+
+void ProfileCounter::reset()
+{
+  _count = 0;
+  _total_us = 0;
+  _max_us = 0;
+}
+
+void UpdateProfile::reset()
+{
+  for (ProfileCounter & counter : _state)
+    counter.reset();
+  for (ProfileCounter & counter : _section)
+    counter.reset();
+}
+
+char const * UpdateProfile::sectionName(ProfileSection const section)
+{
+  switch (section)
+  {
+    case ProfileSection::Encode:     return "Encode";
+    case ProfileSection::Decode:     return "Decode";
+    case ProfileSection::Send:       return "Send";
+    case ProfileSection::TlsConnect: return "TlsConnect";
+    case ProfileSection::NtpSync:    return "NtpSync";
+    case ProfileSection::OtaHash:    return "OtaHash";
+  }
+  return "";
+}
@@ -0,0 +1,114 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_UPDATE_PROFILE_H_
+#define ARDUINO_AIOTC_UTILITY_UPDATE_PROFILE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+/* Parts of the connection which are timed on their own */
+enum class ProfileSection : uint8_t
+{
+  Encode,     /* Encoding properties into a message */
+  Decode,     /* Reading and decoding a received message */
+  Send,       /* Handing a message over to the MQTT client */
+  TlsConnect, /* Attempts to connect to the broker, including the TLS handshake */
+  NtpSync,    /* Synchronising the time service */
+  OtaHash     /* Hashing the firmware image, a slice per update() */
+};
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Number of samples, total and longest duration of something being timed */
+class ProfileCounter
+{
+public:
+
+  ProfileCounter();
+
+  void add(unsigned long const duration_us);
+  void reset();
+
+  inline uint32_t      count        () const { return _count; }
+  inline unsigned long totalMicros  () const { return _total_us; }
+  inline unsigned long maxMicros    () const { return _max_us; }
+  inline unsigned long averageMicros() const { return _count ? (_total_us / _count) : 0; }
+
+private:
+
+  uint32_t _count;
+  unsigned long _total_us;
+  unsigned long _max_us;
+};
+
+/* Durations of update() per state of the state machine and of the sections
+ * of the connection, measured with micros().
+ */
+class UpdateProfile
+{
+public:
+
+  static size_t const STATE_CNT   = 12;
+  static size_t const SECTION_CNT = 6;
+
+  inline ProfileCounter & state(uint8_t const state) { return _state[state < STATE_CNT ? state : STATE_CNT - 1]; }
+  inline ProfileCounter const & state(uint8_t const state) const { return _state[state < STATE_CNT ? state : STATE_CNT - 1]; }
+  inline ProfileCounter & section(ProfileSection const section) { return _section[static_cast<size_t>(section)]; }
+  inline ProfileCounter const & section(ProfileSection const section) const { return _section[static_cast<size_t>(section)]; }
+
+  void reset();
+
+  static char const * sectionName(ProfileSection const section);
+
+private:
+
+  ProfileCounter _state[STATE_CNT];
+  ProfileCounter _section[SECTION_CNT];
+};
+
+/* Adds the time from its construction to its destruction to a counter */
+class ProfileScope
+{
+public:
+
+  ProfileScope(ProfileCounter & counter)
+  : _counter(counter)
+  , _start_us(micros())
+  { }
+
+  ~ProfileScope()
+  {
+    _counter.add(micros() - _start_us);
+  }
+
+private:
+
+  ProfileCounter & _counter;
+  unsigned long const _start_us;
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_UPDATE_PROFILE_H_ */
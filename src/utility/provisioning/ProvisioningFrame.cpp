@@ -0,0 +1,163 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "ProvisioningFrame.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+ProvisioningFrame::ProvisioningFrame()
+{
+  reset();
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void ProvisioningFrame::reset()
+{
+  _state = State::Start;
+  _type = 0;
+  _length = 0;
+  _pos = 0;
+  _crc = 0xFFFFFFFF;
+  _received_crc = 0;
+}
+
+ProvisioningFrame::Status ProvisioningFrame::feed(uint8_t const c)
+{
+  if (_state != State::Start && _state != State::Crc)
+    _crc = crc32(_crc, &c, 1);
+
+  switch (_state)
+  {
+  case State::Start:
+    if (c == START)
+    {
+      reset();
+      _state = State::Type;
+    }
+    return Status::Incomplete;
+
+  case State::Type:
+    _type = c;
+    _state = State::LengthLow;
+    return Status::Incomplete;
+
+  case State::LengthLow:
+    _length = c;
+    _state = State::LengthHigh;
+    return Status::Incomplete;
+
+  case State::LengthHigh:
+    _length |= static_cast<size_t>(c) << 8;
+    if (_length > MAX_PAYLOAD_SIZE)
+    {
+      _state = State::Start;
+      return Status::Error;
+    }
+    _state = (_length > 0) ? State::Payload : State::Crc;
+    return Status::Incomplete;
+
+  case State::Payload:
+    _payload[_pos++] = c;
+    if (_pos == _length)
+    {
+      _pos = 0;
+      _state = State::Crc;
+    }
+    return Status::Incomplete;
+
+  case State::Crc:
+    _received_crc |= static_cast<uint32_t>(c) << (8 * _pos++);
+    if (_pos < CRC_SIZE)
+      return Status::Incomplete;
+    _state = State::Start;
+    return ((_crc ^ 0xFFFFFFFF) == _received_crc) ? Status::Complete : Status::Error;
+  }
+
+  return Status::Error;
+}
+
+bool ProvisioningFrame::field(ProvisioningField const id, uint8_t const * & value, size_t & len) const
+{
+  for (size_t pos = 0; (pos + FIELD_HEADER_SIZE) <= _length;)
+  {
+    size_t const field_len = _payload[pos + 1] | (static_cast<size_t>(_payload[pos + 2]) << 8);
+    if ((pos + FIELD_HEADER_SIZE + field_len) > _length)
+      return false;
+    if (_payload[pos] == static_cast<uint8_t>(id))
+    {
+      value = _payload + pos + FIELD_HEADER_SIZE;
+      len = field_len;
+      return true;
+    }
+    pos += FIELD_HEADER_SIZE + field_len;
+  }
+  return false;
+}
+
+size_t ProvisioningFrame::encode(ProvisioningFrameType const type, uint8_t const * payload, size_t const len, uint8_t * out, size_t const size)
+{
+  size_t const frame_size = HEADER_SIZE + len + CRC_SIZE;
+  if ((len > MAX_PAYLOAD_SIZE) || (frame_size > size))
+    return 0;
+
+  out[0] = START;
+  out[1] = static_cast<uint8_t>(type);
+  out[2] = static_cast<uint8_t>(len);
+  out[3] = static_cast<uint8_t>(len >> 8);
+  if (len > 0)
+    memcpy(out + HEADER_SIZE, payload, len);
+
+  uint32_t const crc = crc32(0xFFFFFFFF, out + 1, HEADER_SIZE - 1 + len) ^ 0xFFFFFFFF;
+  for (size_t i = 0; i < CRC_SIZE; i++)
+    out[HEADER_SIZE + len + i] = static_cast<uint8_t>(crc >> (8 * i));
+  return frame_size;
+}
+
+bool ProvisioningFrame::appendField(uint8_t * payload, size_t const size, size_t & pos, ProvisioningField const id, uint8_t const * value, size_t const len)
+{
+  if ((pos + FIELD_HEADER_SIZE + len) > size)
+    return false;
+  payload[pos++] = static_cast<uint8_t>(id);
+  payload[pos++] = static_cast<uint8_t>(len);
+  payload[pos++] = static_cast<uint8_t>(len >> 8);
+  if (len > 0)
+    memcpy(payload + pos, value, len);
+  pos += len;
+  return true;
+}
+
+uint32_t ProvisioningFrame::crc32(uint32_t crc, uint8_t const * data, size_t const len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return crc;
+}
@@ -0,0 +1,136 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_PROVISIONING_FRAME_H_
+#define ARDUINO_AIOTC_UTILITY_PROVISIONING_FRAME_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+/* Messages of the batch provisioning protocol, see
+ * examples/utility/BatchProvisioning and extras/tools/provision.py:
+ *
+ *   host -> Begin   {DeviceId}
+ *   host <- Csr     {Csr}
+ *   host -> Cert    {DeviceId, Issue*, ExpireYears, SerialNumber, AuthorityKeyId, Signature, Nonce}
+ *   host <- Confirm {Signature}, the device key over SHA256(Nonce | compressed certificate)
+ *   host <- Error   {Error}, in place of any reply
+ */
+enum class ProvisioningFrameType : uint8_t
+{
+  Begin   = 1,
+  Csr     = 2,
+  Cert    = 3,
+  Confirm = 4,
+  Error   = 5
+};
+
+enum class ProvisioningField : uint8_t
+{
+  DeviceId       = 1,
+  IssueYear      = 2,
+  IssueMonth     = 3,
+  IssueDay       = 4,
+  IssueHour      = 5,
+  ExpireYears    = 6,
+  SerialNumber   = 7,
+  AuthorityKeyId = 8,
+  Signature      = 9,
+  Csr            = 10,
+  Nonce          = 11,
+  Error          = 12
+};
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* A frame is
+ *
+ *   0xA5 | type | payload length (16 bit LE) | payload | CRC32 (LE)
+ *
+ * with the CRC32 over type, length and payload. The payload is a sequence of
+ * fields, each field id | length (16 bit LE) | value. The issue date and
+ * the validity are 16 bit LE integers, the device id is a string without
+ * terminating zero and all other fields are binary. The receiver is fed
+ * byte by byte and resynchronises on the next start byte after a broken
+ * frame.
+ */
+class ProvisioningFrame
+{
+public:
+
+  static uint8_t const START = 0xA5;
+  static size_t  const HEADER_SIZE = 4;
+  static size_t  const CRC_SIZE = 4;
+  static size_t  const MAX_PAYLOAD_SIZE = 512;
+  static size_t  const MAX_FRAME_SIZE = HEADER_SIZE + MAX_PAYLOAD_SIZE + CRC_SIZE;
+  static size_t  const FIELD_HEADER_SIZE = 3;
+
+  enum class Status
+  {
+    Incomplete, Complete, Error
+  };
+
+  ProvisioningFrame();
+
+  void reset();
+  /* Complete once a whole frame has been received, it stays available until
+   * the next byte is fed. Error if the CRC or the length is wrong.
+   */
+  Status feed(uint8_t const c);
+
+  inline ProvisioningFrameType type() const { return static_cast<ProvisioningFrameType>(_type); }
+  inline uint8_t const * payload() const { return _payload; }
+  inline size_t length() const { return _length; }
+
+  /* Finds a field in the payload of the received frame */
+  bool field(ProvisioningField const id, uint8_t const * & value, size_t & len) const;
+
+  /* Builds a frame from the payload, returns its size or 0 if out is too small */
+  static size_t encode(ProvisioningFrameType const type, uint8_t const * payload, size_t const len, uint8_t * out, size_t const size);
+  /* Appends a field to the payload at pos, returns false if it doesn't fit */
+  static bool appendField(uint8_t * payload, size_t const size, size_t & pos, ProvisioningField const id, uint8_t const * value, size_t const len);
+
+  static uint32_t crc32(uint32_t crc, uint8_t const * data, size_t const len);
+
+private:
+
+  enum class State
+  {
+    Start, Type, LengthLow, LengthHigh, Payload, Crc
+  };
+
+  State _state;
+  uint8_t _type;
+  size_t _length;
+  size_t _pos;
+  uint32_t _crc;
+  uint32_t _received_crc;
+  uint8_t _payload[MAX_PAYLOAD_SIZE];
+
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_PROVISIONING_FRAME_H_ */
@@ -0,0 +1,326 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "RuleEngine.h"
+
+#if AIOT_CONFIG_RULES_ENABLED
+
+#include <string.h>
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t const RuleEngine::MAX_REFERENCES;
+size_t const RuleEngine::MAX_RULES;
+size_t const RuleEngine::STACK_DEPTH;
+uint8_t const RuleEngine::VERSION;
+
+/******************************************************************************
+ * LOCAL MODULE FUNCTIONS
+ ******************************************************************************/
+
+static float readFloat(uint8_t const * buf)
+{
+  uint32_t const bits = static_cast<uint32_t>(buf[0])         |
+                        (static_cast<uint32_t>(buf[1]) << 8)  |
+                        (static_cast<uint32_t>(buf[2]) << 16) |
+                        (static_cast<uint32_t>(buf[3]) << 24);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+/* Number of operand bytes following the opcode, -1 if the opcode is unknown */
+static int operandSize(uint8_t const op)
+{
+  switch (static_cast<RuleEngine::Op>(op))
+  {
+    case RuleEngine::Op::End:
+    case RuleEngine::Op::Gt:
+    case RuleEngine::Op::Lt:
+    case RuleEngine::Op::Ge:
+    case RuleEngine::Op::Le:
+    case RuleEngine::Op::Eq:
+    case RuleEngine::Op::Ne:
+    case RuleEngine::Op::And:
+    case RuleEngine::Op::Or:
+    case RuleEngine::Op::Not:
+    case RuleEngine::Op::Add:
+    case RuleEngine::Op::Sub:
+    case RuleEngine::Op::Mul:
+    case RuleEngine::Op::Div:       return 0;
+    case RuleEngine::Op::PushProp:
+    case RuleEngine::Op::Jz:
+    case RuleEngine::Op::SetProp:   return 1;
+    case RuleEngine::Op::PushConst: return 4;
+  }
+  return -1;
+}
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+RuleEngine::RuleEngine()
+: _container{nullptr}
+, _property{nullptr}
+, _last_value{0}
+, _primitive{0}
+, _property_cnt{0}
+, _rule_cnt{0}
+, _is_initial{false}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+RuleEngine::Error RuleEngine::load(PropertyContainer & prop_cont, uint8_t const * program, size_t const length)
+{
+  clear();
+
+  if ((length < 3) || (program[0] != 'R'))
+    return Error::Format;
+  if (program[1] != VERSION)
+    return Error::Version;
+  if (program[2] > MAX_REFERENCES)
+    return Error::TooManyReferences;
+
+  size_t pos = 3;
+  size_t const property_cnt = program[2];
+  for (size_t i = 0; i < property_cnt; i++)
+  {
+    if (pos >= length || (pos + 1 + program[pos]) > length)
+      return Error::Format;
+    Property * p = prop_cont.find(CborStringView(reinterpret_cast<char const *>(program + pos + 1), program[pos]));
+    if (p == nullptr)
+      return Error::UnknownProperty;
+    if (!p->getNumber(_last_value[i]))
+      return Error::UnsupportedType;
+    if (p->isPrimitive())
+      _primitive |= (1U << i);
+    _property[i] = p;
+    pos += 1 + program[pos];
+  }
+  _property_cnt = property_cnt;
+
+  size_t rule_cnt = 0;
+  while (pos < length)
+  {
+    if (rule_cnt >= MAX_RULES)
+      return Error::TooManyRules;
+    if ((pos + 1 + program[pos]) > length)
+      return Error::Format;
+    Rule & rule = _rule[rule_cnt];
+    rule.code = program + pos + 1;
+    rule.length = program[pos];
+    Error const err = validate(rule.code, rule.length, rule.reads);
+    if (err != Error::None)
+      return err;
+    rule_cnt++;
+    pos += 1 + program[pos];
+  }
+
+  /* Changes made before the program has been loaded are covered by running all rules once */
+  for (size_t i = 0; i < _property_cnt; i++)
+    prop_cont.takeChanged(_property[i]->getContainerPosition());
+
+  _container = &prop_cont;
+  _rule_cnt = rule_cnt;
+  _is_initial = true;
+  return Error::None;
+}
+
+void RuleEngine::clear()
+{
+  _container = nullptr;
+  _primitive = 0;
+  _property_cnt = 0;
+  _rule_cnt = 0;
+  _is_initial = false;
+}
+
+size_t RuleEngine::evaluate()
+{
+  if (!isLoaded())
+    return 0;
+
+  uint16_t changed = 0;
+  for (size_t i = 0; i < _property_cnt; i++)
+  {
+    bool is_changed = _container->takeChanged(_property[i]->getContainerPosition());
+    if (_primitive & (1U << i))
+    {
+      float value;
+      _property[i]->getNumber(value);
+      is_changed = is_changed || (value != _last_value[i]);
+      _last_value[i] = value;
+    }
+    if (is_changed)
+      changed |= (1U << i);
+  }
+
+  size_t run_cnt = 0;
+  for (size_t r = 0; r < _rule_cnt; r++)
+  {
+    if (_is_initial || (_rule[r].reads & changed))
+    {
+      run(_rule[r]);
+      run_cnt++;
+    }
+  }
+  _is_initial = false;
+  return run_cnt;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+RuleEngine::Error RuleEngine::validate(uint8_t const * code, size_t const length, uint16_t & reads) const
+{
+  /* Start of each instruction, a jump has to land on one or at the end */
+  uint32_t is_start[(UINT8_MAX + 32) / 32] = {0};
+  uint32_t is_target[(UINT8_MAX + 32) / 32] = {0};
+
+  reads = 0;
+  for (size_t pc = 0; pc < length; )
+  {
+    uint8_t const op = code[pc];
+    int const operand_size = operandSize(op);
+    if ((operand_size < 0) || ((pc + 1 + operand_size) > length))
+      return Error::InvalidInstruction;
+    is_start[pc / 32] |= (1UL << (pc % 32));
+
+    switch (static_cast<Op>(op))
+    {
+      case Op::PushProp:
+        if (code[pc + 1] >= _property_cnt)
+          return Error::InvalidInstruction;
+        reads |= (1U << code[pc + 1]);
+        break;
+      case Op::SetProp:
+        if (code[pc + 1] >= _property_cnt)
+          return Error::InvalidInstruction;
+        break;
+      case Op::Jz:
+      {
+        /* Only forward jumps, hence every rule terminates */
+        size_t const target = pc + 2 + code[pc + 1];
+        if (target > length)
+          return Error::InvalidInstruction;
+        if (target < length)
+          is_target[target / 32] |= (1UL << (target % 32));
+        break;
+      }
+      default:
+        break;
+    }
+    pc += 1 + operand_size;
+  }
+
+  for (size_t i = 0; i < sizeof(is_target) / sizeof(is_target[0]); i++)
+  {
+    if (is_target[i] & ~is_start[i])
+      return Error::InvalidInstruction;
+  }
+  return Error::None;
+}
+
+bool RuleEngine::run(Rule const & rule)
+{
+  float stack[STACK_DEPTH];
+  size_t sp = 0;
+
+  for (size_t pc = 0; pc < rule.length; )
+  {
+    Op const op = static_cast<Op>(rule.code[pc++]);
+
+    if (op == Op::End)
+      break;
+
+    if (op == Op::PushProp || op == Op::PushConst)
+    {
+      if (sp >= STACK_DEPTH)
+        return false;
+      if (op == Op::PushProp) {
+        _property[rule.code[pc++]]->getNumber(stack[sp++]);
+      } else {
+        stack[sp++] = readFloat(rule.code + pc);
+        pc += 4;
+      }
+      continue;
+    }
+
+    if (sp < 1)
+      return false;
+
+    if (op == Op::Not) {
+      stack[sp - 1] = (stack[sp - 1] == 0) ? 1.0f : 0.0f;
+      continue;
+    }
+    if (op == Op::Jz) {
+      uint8_t const offset = rule.code[pc++];
+      if (stack[--sp] == 0)
+        pc += offset;
+      continue;
+    }
+    if (op == Op::SetProp) {
+      _property[rule.code[pc++]]->setNumber(stack[--sp]);
+      continue;
+    }
+
+    /* All remaining operations take two operands */
+    if (sp < 2)
+      return false;
+    float const rhs = stack[--sp];
+    float const lhs = stack[sp - 1];
+    float result = 0;
+    switch (op)
+    {
+      case Op::Gt:  result = (lhs >  rhs) ? 1.0f : 0.0f; break;
+      case Op::Lt:  result = (lhs <  rhs) ? 1.0f : 0.0f; break;
+      case Op::Ge:  result = (lhs >= rhs) ? 1.0f : 0.0f; break;
+      case Op::Le:  result = (lhs <= rhs) ? 1.0f : 0.0f; break;
+      case Op::Eq:  result = (lhs == rhs) ? 1.0f : 0.0f; break;
+      case Op::Ne:  result = (lhs != rhs) ? 1.0f : 0.0f; break;
+      case Op::And: result = ((lhs != 0) && (rhs != 0)) ? 1.0f : 0.0f; break;
+      case Op::Or:  result = ((lhs != 0) || (rhs != 0)) ? 1.0f : 0.0f; break;
+      case Op::Add: result = lhs + rhs; break;
+      case Op::Sub: result = lhs - rhs; break;
+      case Op::Mul: result = lhs * rhs; break;
+      case Op::Div:
+        if (rhs == 0)
+          return false;
+        result = lhs / rhs;
+        break;
+      default:
+        return false;
+    }
+    stack[sp - 1] = result;
+  }
+  return true;
+}
+
+#endif /* AIOT_CONFIG_RULES_ENABLED */
@@ -0,0 +1,138 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_RULE_ENGINE_H_
+#define ARDUINO_AIOTC_UTILITY_RULE_ENGINE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#if AIOT_CONFIG_RULES_ENABLED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../property/PropertyContainer.h"
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Evaluates rules on the properties of the thing, e.g. to switch on a fan
+ * once the temperature exceeds a threshold, without a round trip via the
+ * cloud. A program names the properties it refers to and holds the rules,
+ * each one bytecode for a small stack machine working on floats:
+ *
+ *   'R' <version> <n> { <length> <property name> }[n] { <length> <code> }...
+ *
+ * A rule runs once after the program has been loaded and then whenever one
+ * of the properties it reads has been changed, locally or by the cloud. The
+ * changes are taken from the container, only the wrapped primitives which
+ * do not report them are compared against the value seen last. A property
+ * written by a rule runs the rules reading it on the next call of evaluate(),
+ * hence rules which trigger each other run once per call.
+ */
+class RuleEngine
+{
+public:
+
+  static size_t const MAX_REFERENCES = 16;
+  static size_t const MAX_RULES = 16;
+  static size_t const STACK_DEPTH = 8;
+
+  static uint8_t const VERSION = 1;
+
+  enum class Op : uint8_t
+  {
+    End       = 0x00,
+    PushProp  = 0x01, /* <reference>, pushes the value of the property */
+    PushConst = 0x02, /* <float, little endian> */
+    Gt        = 0x10, /* Comparisons and logic push 1 if true, 0 otherwise */
+    Lt        = 0x11,
+    Ge        = 0x12,
+    Le        = 0x13,
+    Eq        = 0x14,
+    Ne        = 0x15,
+    And       = 0x18,
+    Or        = 0x19,
+    Not       = 0x1A,
+    Add       = 0x20,
+    Sub       = 0x21,
+    Mul       = 0x22,
+    Div       = 0x23,
+    Jz        = 0x30, /* <offset>, pops and skips offset bytes if 0 */
+    SetProp   = 0x40  /* <reference>, pops and writes the property */
+  };
+
+  enum class Error : int
+  {
+    None               =  0,
+    Format             = -1,
+    Version            = -2,
+    UnknownProperty    = -3,
+    UnsupportedType    = -4,
+    TooManyReferences  = -5,
+    TooManyRules       = -6,
+    InvalidInstruction = -7
+  };
+
+  RuleEngine();
+
+  /* The program is referenced, not copied, and has to be kept unchanged
+   * until the next call of load() or clear(). A program which is refused
+   * leaves the engine without any rule.
+   */
+  Error load(PropertyContainer & prop_cont, uint8_t const * program, size_t const length);
+  void clear();
+
+  inline bool isLoaded() const { return _rule_cnt > 0; }
+
+  /* Runs the rules reading a property changed since the previous call and
+   * returns their number.
+   */
+  size_t evaluate();
+
+private:
+
+  struct Rule
+  {
+    uint8_t const * code;
+    uint8_t length;
+    /* Bit i is set if the rule reads the property referenced as i */
+    uint16_t reads;
+  };
+
+  PropertyContainer * _container;
+  Property * _property[MAX_REFERENCES];
+  float _last_value[MAX_REFERENCES];
+  uint16_t _primitive;
+  size_t _property_cnt;
+  Rule _rule[MAX_RULES];
+  size_t _rule_cnt;
+  bool _is_initial;
+
+  Error validate(uint8_t const * code, size_t const length, uint16_t & reads) const;
+  /* Returns false if the rule has been aborted, e.g. on a stack overflow */
+  bool run(Rule const & rule);
+};
+
+#endif /* AIOT_CONFIG_RULES_ENABLED */
+
+#endif /* ARDUINO_AIOTC_UTILITY_RULE_ENGINE_H_ */
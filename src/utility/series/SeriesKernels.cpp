@@ -0,0 +1,129 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "SeriesKernels.h"
+
+#include <string.h>
+
+#ifdef HAS_CMSIS_DSP
+  #include <arm_math.h>
+#endif
+
+/******************************************************************************
+ * FUNCTION DEFINITION
+ ******************************************************************************/
+
+SeriesStats series_stats(float const * sample, size_t const cnt)
+{
+#ifdef HAS_CMSIS_DSP
+  /* The loops of CMSIS-DSP are unrolled and keep the FPU pipeline busy */
+  SeriesStats stats;
+  uint32_t idx;
+  arm_min_f32(sample, cnt, &stats.min, &idx);
+  arm_max_f32(sample, cnt, &stats.max, &idx);
+  arm_mean_f32(sample, cnt, &stats.mean);
+  return stats;
+#else
+  /* Four independent accumulators, which the compiler can keep in registers
+   * and vectorise where the target has float SIMD.
+   */
+  float min[4] = {sample[0], sample[0], sample[0], sample[0]};
+  float max[4] = {sample[0], sample[0], sample[0], sample[0]};
+  float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  size_t i = 0;
+  for (; (i + 4) <= cnt; i += 4)
+  {
+    for (size_t k = 0; k < 4; k++)
+    {
+      float const s = sample[i + k];
+      min[k] = (s < min[k]) ? s : min[k];
+      max[k] = (s > max[k]) ? s : max[k];
+      sum[k] += s;
+    }
+  }
+  for (; i < cnt; i++)
+  {
+    min[0] = (sample[i] < min[0]) ? sample[i] : min[0];
+    max[0] = (sample[i] > max[0]) ? sample[i] : max[0];
+    sum[0] += sample[i];
+  }
+  for (size_t k = 1; k < 4; k++)
+  {
+    min[0] = (min[k] < min[0]) ? min[k] : min[0];
+    max[0] = (max[k] > max[0]) ? max[k] : max[0];
+  }
+  return SeriesStats{min[0], max[0], ((sum[0] + sum[1]) + (sum[2] + sum[3])) / cnt};
+#endif
+}
+
+uint16_t float_to_half(float const value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  uint16_t const sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  int32_t const exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+  uint32_t mantissa = bits & 0x7FFFFF;
+
+  /* Infinity and NaN, which stays a quiet NaN */
+  if (((bits >> 23) & 0xFF) == 0xFF)
+    return sign | 0x7C00 | ((mantissa != 0) ? 0x0200 : 0);
+
+  if (exponent >= 0x1F)
+    return sign | 0x7C00;
+
+  if (exponent <= 0)
+  {
+    /* Subnormal, or zero once shifted out completely */
+    if (exponent < -10)
+      return sign;
+    mantissa |= 0x800000;
+    uint32_t const shift = static_cast<uint32_t>(14 - exponent);
+    uint32_t half = mantissa >> shift;
+    uint32_t const rest = mantissa & ((1UL << shift) - 1);
+    uint32_t const halfway = 1UL << (shift - 1);
+    if ((rest > halfway) || ((rest == halfway) && (half & 1)))
+      half++;
+    return sign | static_cast<uint16_t>(half);
+  }
+
+  /* Rounding may carry into the exponent, up to infinity */
+  uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+  uint32_t const rest = mantissa & 0x1FFF;
+  if ((rest > 0x1000) || ((rest == 0x1000) && (half & 1)))
+    half++;
+  return sign | static_cast<uint16_t>(half);
+}
+
+void series_to_half(float const * sample, uint16_t * half, size_t const cnt)
+{
+#if defined(__ARM_FP16_FORMAT_IEEE)
+  /* Converted by VCVTB.F16.F32 of the FPU */
+  for (size_t i = 0; i < cnt; i++)
+  {
+    __fp16 const h = sample[i];
+    memcpy(&half[i], &h, sizeof(uint16_t));
+  }
+#else
+  for (size_t i = 0; i < cnt; i++)
+    half[i] = float_to_half(sample[i]);
+#endif
+}
@@ -0,0 +1,74 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_SERIES_KERNELS_H_
+#define ARDUINO_AIOTC_UTILITY_SERIES_KERNELS_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+struct SeriesStats
+{
+  float min;
+  float max;
+  float mean;
+};
+
+/******************************************************************************
+ * FUNCTION DECLARATION
+ ******************************************************************************/
+
+/* Min, max and mean of cnt > 0 samples. The float samples are processed with
+ * CMSIS-DSP where it is available, the others with a portable loop.
+ */
+SeriesStats series_stats(float const * sample, size_t const cnt);
+
+template <typename T>
+SeriesStats series_stats(T const * sample, size_t const cnt)
+{
+  T min = sample[0];
+  T max = sample[0];
+  double sum = 0.0;
+  for (size_t i = 0; i < cnt; i++)
+  {
+    if (sample[i] < min) min = sample[i];
+    if (sample[i] > max) max = sample[i];
+    sum += sample[i];
+  }
+  return SeriesStats{static_cast<float>(min), static_cast<float>(max), static_cast<float>(sum / cnt)};
+}
+
+/* IEEE 754 half precision, rounded to the nearest even value. Values beyond
+ * the range become infinite, those too small for it zero.
+ */
+uint16_t float_to_half(float const value);
+/* Converts cnt samples, with the converting instruction of the FPU where the
+ * compiler provides it.
+ */
+void series_to_half(float const * sample, uint16_t * half, size_t const cnt);
+
+#endif /* ARDUINO_AIOTC_UTILITY_SERIES_KERNELS_H_ */
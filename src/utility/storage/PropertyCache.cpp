@@ -0,0 +1,140 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "PropertyCache.h"
+
+#include "../../cbor/CBORDecoder.h"
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+static uint8_t const RECORD_MAGIC[] = {'P', 'C'};
+static uint8_t const RECORD_VERSION = 1;
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t const PropertyCache::HEADER_SIZE;
+size_t const PropertyCache::SIZE;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+PropertyCache::PropertyCache()
+: _storage{nullptr}
+, _hash{0}
+, _last_save_tick{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void PropertyCache::begin(PropertyCacheStorage & storage)
+{
+  _storage = &storage;
+}
+
+bool PropertyCache::restore(PropertyContainer & prop_cont)
+{
+  if (!_storage)
+    return false;
+
+  size_t const length = _storage->read(_buf, sizeof(_buf));
+  if ((length <= HEADER_SIZE) || (_buf[0] != RECORD_MAGIC[0]) || (_buf[1] != RECORD_MAGIC[1]) || (_buf[2] != RECORD_VERSION))
+    return false;
+
+  /* Applied without echo and cloud timestamp, the cloud is still authoritative */
+  CBORDecoder::decode(prop_cont, _buf + HEADER_SIZE, length - HEADER_SIZE, false, true);
+
+  /* The values just restored need not be written back */
+  size_t const restored_length = encode(prop_cont);
+  _hash = hash(_buf, restored_length);
+  return true;
+}
+
+bool PropertyCache::save(PropertyContainer & prop_cont)
+{
+  if (!_storage)
+    return false;
+
+  /* Values exceeding AIOT_CONFIG_PROPERTY_CACHE_SIZE are not stored at all */
+  size_t const length = encode(prop_cont);
+  if (length == 0)
+    return false;
+
+  uint32_t const h = hash(_buf, length);
+  if ((h == _hash) || !_storage->write(_buf, length))
+    return false;
+  _hash = h;
+  return true;
+}
+
+void PropertyCache::poll(PropertyContainer & prop_cont, unsigned long const now, unsigned long const interval_ms)
+{
+  if (!_storage || ((now - _last_save_tick) < interval_ms))
+    return;
+
+  _last_save_tick = now;
+  save(prop_cont);
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+size_t PropertyCache::encode(PropertyContainer & prop_cont)
+{
+  _buf[0] = RECORD_MAGIC[0];
+  _buf[1] = RECORD_MAGIC[1];
+  _buf[2] = RECORD_VERSION;
+  _buf[3] = 0;
+
+  CborEncoder encoder, array;
+  cbor_encoder_init(&encoder, _buf + HEADER_SIZE, SIZE, 0);
+  if (cbor_encoder_create_array(&encoder, &array, CborIndefiniteLength) != CborNoError)
+    return 0;
+  for (Property * p : prop_cont)
+  {
+    if (p->isWriteableByCloud() && (p->appendSnapshot(&array) != CborNoError))
+      return 0;
+  }
+  if (cbor_encoder_close_container(&encoder, &array) != CborNoError)
+    return 0;
+  return HEADER_SIZE + cbor_encoder_get_buffer_size(&encoder, _buf + HEADER_SIZE);
+}
+
+uint32_t PropertyCache::hash(uint8_t const * data, size_t const length)
+{
+  /* FNV-1a, the records are only compared against the one stored last */
+  uint32_t h = 2166136261UL;
+  for (size_t i = 0; i < length; i++)
+  {
+    h ^= data[i];
+    h *= 16777619UL;
+  }
+  return h;
+}
@@ -0,0 +1,92 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_PROPERTY_CACHE_H_
+#define ARDUINO_AIOTC_UTILITY_PROPERTY_CACHE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../property/PropertyContainer.h"
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Non-volatile storage of a single record, e.g. a key of a wear levelled key
+ * value store. See PropertyCacheStorage.h for those of the boards.
+ */
+class PropertyCacheStorage
+{
+public:
+
+  virtual ~PropertyCacheStorage() { }
+
+  /* Returns the length of the record, 0 if there is none or it does not fit into buf */
+  virtual size_t read(uint8_t * buf, size_t const size) = 0;
+  virtual bool write(uint8_t const * buf, size_t const length) = 0;
+};
+
+/* Keeps the values of the properties writeable by the cloud across restarts,
+ * so that e.g. an actuator resumes its state before the last values have been
+ * received. The record holds a CBOR message like one of the cloud:
+ *
+ *   'P' 'C' <version> 0 <CBOR array of the values>
+ *
+ * The restored values are applied like values received from a peer, i.e.
+ * their callbacks run but they are not echoed and the time of the last cloud
+ * change is kept. The values are stored again at most once per interval and
+ * only if they differ from those stored last, which keeps the flash wear low.
+ */
+class PropertyCache
+{
+public:
+
+  static size_t const HEADER_SIZE = 4;
+  static size_t const SIZE = AIOT_CONFIG_PROPERTY_CACHE_SIZE;
+
+  PropertyCache();
+
+  void begin(PropertyCacheStorage & storage);
+  inline bool isEnabled() const { return _storage != nullptr; }
+
+  /* Returns false if no values have been stored before */
+  bool restore(PropertyContainer & prop_cont);
+  /* Returns true if the values have been written to the storage */
+  bool save(PropertyContainer & prop_cont);
+  /* Calls save() once interval_ms have passed since the previous call */
+  void poll(PropertyContainer & prop_cont, unsigned long const now, unsigned long const interval_ms);
+
+private:
+
+  PropertyCacheStorage * _storage;
+  uint32_t _hash;
+  unsigned long _last_save_tick;
+  uint8_t _buf[HEADER_SIZE + SIZE];
+
+  /* Returns the length of the record within _buf, 0 if the values do not fit */
+  size_t encode(PropertyContainer & prop_cont);
+  static uint32_t hash(uint8_t const * data, size_t const length);
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_PROPERTY_CACHE_H_ */
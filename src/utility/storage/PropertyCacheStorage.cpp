@@ -0,0 +1,71 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "PropertyCacheStorage.h"
+
+#if defined(ARDUINO_ARCH_MBED)
+  #include <kvstore_global_api.h>
+  #include <mbed_error.h>
+#endif
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+#if defined(ARDUINO_ARCH_MBED)
+size_t KVStorePropertyCacheStorage::read(uint8_t * buf, size_t const size)
+{
+  kv_info_t info;
+  if ((kv_get_info(_key, &info) != MBED_SUCCESS) || (info.size > size))
+    return 0;
+
+  size_t length = 0;
+  if (kv_get(_key, buf, size, &length) != MBED_SUCCESS)
+    return 0;
+  return length;
+}
+
+bool KVStorePropertyCacheStorage::write(uint8_t const * buf, size_t const length)
+{
+  return kv_set(_key, buf, length, 0) == MBED_SUCCESS;
+}
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+size_t PreferencesPropertyCacheStorage::read(uint8_t * buf, size_t const size)
+{
+  if (!_preferences.begin(_name, true))
+    return 0;
+  size_t const length = _preferences.getBytesLength(_key);
+  size_t const bytes_read = ((length > 0) && (length <= size)) ? _preferences.getBytes(_key, buf, size) : 0;
+  _preferences.end();
+  return bytes_read;
+}
+
+bool PreferencesPropertyCacheStorage::write(uint8_t const * buf, size_t const length)
+{
+  if (!_preferences.begin(_name, false))
+    return false;
+  size_t const bytes_written = _preferences.putBytes(_key, buf, length);
+  _preferences.end();
+  return bytes_written == length;
+}
+#endif
@@ -0,0 +1,67 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_PROPERTY_CACHE_STORAGE_H_
+#define ARDUINO_AIOTC_UTILITY_PROPERTY_CACHE_STORAGE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "PropertyCache.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <Preferences.h>
+#endif
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+#if defined(ARDUINO_ARCH_MBED)
+/* A key of the global KVStore, which levels the wear across its area */
+class KVStorePropertyCacheStorage : public PropertyCacheStorage
+{
+public:
+  KVStorePropertyCacheStorage(char const * key = "/kv/aiotc_props") : _key(key) { }
+
+  virtual size_t read(uint8_t * buf, size_t const size) override;
+  virtual bool write(uint8_t const * buf, size_t const length) override;
+
+private:
+  char const * _key;
+};
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+/* A key of the NVS partition, which levels the wear across its pages */
+class PreferencesPropertyCacheStorage : public PropertyCacheStorage
+{
+public:
+  PreferencesPropertyCacheStorage(char const * name = "aiotc", char const * key = "props") : _name(name), _key(key) { }
+
+  virtual size_t read(uint8_t * buf, size_t const size) override;
+  virtual bool write(uint8_t const * buf, size_t const length) override;
+
+private:
+  Preferences _preferences;
+  char const * _name;
+  char const * _key;
+};
+#endif
+
+#endif /* ARDUINO_AIOTC_UTILITY_PROPERTY_CACHE_STORAGE_H_ */
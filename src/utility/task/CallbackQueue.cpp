@@ -0,0 +1,83 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "CallbackQueue.h"
+
+#include <Arduino.h>
+
+/******************************************************************************
+ * STATIC MEMBER DEFINITION
+ ******************************************************************************/
+
+size_t const CallbackQueue::CAPACITY;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+CallbackQueue::CallbackQueue()
+: _head{0}
+, _size{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool CallbackQueue::push(Property & property, bool const is_sync)
+{
+  for (size_t i = 0; i < _size; i++)
+  {
+    Entry const & entry = _entry[(_head + i) % CAPACITY];
+    if ((entry.property == &property) && (entry.is_sync == is_sync))
+      return true;
+  }
+
+  if (_size >= CAPACITY)
+    return false;
+
+  Entry & entry = _entry[(_head + _size) % CAPACITY];
+  entry.property = &property;
+  entry.is_sync = is_sync;
+  _size++;
+  return true;
+}
+
+size_t CallbackQueue::drain(unsigned long const budget_us)
+{
+  unsigned long const start_us = micros();
+  size_t run_cnt = 0;
+  while (!empty())
+  {
+    /* Taken off before it runs, it may be queued again meanwhile */
+    Entry const entry = _entry[_head];
+    _head = (_head + 1) % CAPACITY;
+    _size--;
+    entry.property->execDeferredCallback(entry.is_sync);
+    run_cnt++;
+
+    if ((micros() - start_us) >= budget_us)
+      break;
+  }
+  return run_cnt;
+}
@@ -0,0 +1,70 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_CALLBACK_QUEUE_H_
+#define ARDUINO_AIOTC_UTILITY_CALLBACK_QUEUE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+
+#include "../../property/Property.h"
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* The callbacks of the properties written by the cloud, taken out of the
+ * decoder so that a slow callback does not hold up the MQTT client. They
+ * are run in the order received within a time budget per call of drain().
+ * A property written again before its callback has run is not queued a
+ * second time, the callback sees the latest value once.
+ */
+class CallbackQueue
+{
+public:
+
+  static size_t const CAPACITY = AIOT_CONFIG_CALLBACK_QUEUE_SIZE;
+
+  CallbackQueue();
+
+  /* Returns false if the queue is full, the callback is run right away then */
+  bool push(Property & property, bool const is_sync);
+  /* Runs callbacks until budget_us has elapsed, but at least one. Returns the number run */
+  size_t drain(unsigned long const budget_us);
+
+  inline bool   empty() const { return _size == 0; }
+  inline size_t size () const { return _size; }
+
+private:
+
+  struct Entry
+  {
+    Property * property;
+    bool is_sync;
+  };
+
+  Entry _entry[CAPACITY];
+  size_t _head;
+  size_t _size;
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_CALLBACK_QUEUE_H_ */
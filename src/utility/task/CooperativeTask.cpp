@@ -0,0 +1,101 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "CooperativeTask.h"
+
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_MBED)
+#  include <Arduino_DebugUtils.h>
+#  include "../watchdog/Watchdog.h"
+#endif
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+#if defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_MBED)
+TaskRunner::TaskRunner()
+: TaskRunner(watchdog_reset)
+{
+
+}
+#else
+TaskRunner::TaskRunner()
+: TaskRunner(nullptr)
+{
+
+}
+#endif
+
+TaskRunner::TaskRunner(FeedWatchdogFunc const feed_watchdog)
+: _feed_watchdog{feed_watchdog}
+, _longest_step_ms{0}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+TaskStatus TaskRunner::run(CooperativeTask & task)
+{
+  TaskStatus status = TaskStatus::InProgress;
+  while (status == TaskStatus::InProgress)
+    status = step(task);
+  return status;
+}
+
+TaskStatus TaskRunner::run(CooperativeTask & task, unsigned long const budget_ms)
+{
+  unsigned long const start = millis();
+  TaskStatus status = TaskStatus::InProgress;
+  do {
+    status = step(task);
+  } while ((status == TaskStatus::InProgress) && ((millis() - start) < budget_ms));
+  return status;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+TaskStatus TaskRunner::step(CooperativeTask & task)
+{
+  unsigned long const start = millis();
+  TaskStatus const status = task.step();
+  unsigned long const step_ms = millis() - start;
+
+  if (_feed_watchdog)
+    _feed_watchdog();
+
+  if (step_ms > _longest_step_ms)
+  {
+    _longest_step_ms = step_ms;
+#if defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_MBED)
+    /* A step this long leaves little margin, it should be split further */
+    if ((watchdog_timeout() > 0) && (step_ms > (watchdog_timeout() / 2)))
+      DEBUG_WARNING("%s: step took %lu ms of a %lu ms watchdog timeout", __FUNCTION__, step_ms, watchdog_timeout());
+#endif
+  }
+  return status;
+}
@@ -0,0 +1,82 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_COOPERATIVE_TASK_H_
+#define ARDUINO_AIOTC_UTILITY_COOPERATIVE_TASK_H_
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+enum class TaskStatus
+{
+  InProgress,
+  Done,
+  Error
+};
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* A long operation split into resumable steps, e.g. erasing one flash block
+ * or hashing one slice of an image per step. Each step has to complete well
+ * within the watchdog timeout, the task keeps its state between the steps.
+ */
+class CooperativeTask
+{
+public:
+
+  virtual ~CooperativeTask() { }
+
+  virtual TaskStatus step() = 0;
+
+};
+
+/* Runs the steps of a task and feeds the watchdog each time one completes,
+ * so no step has to feed it from within. The longest step seen tells how
+ * tight the watchdog window may be.
+ */
+class TaskRunner
+{
+public:
+
+  typedef void(*FeedWatchdogFunc)();
+
+  /* Feeds the watchdog enabled by the library, if any */
+  TaskRunner();
+  TaskRunner(FeedWatchdogFunc const feed_watchdog);
+
+  /* Steps the task until it is done or has failed */
+  TaskStatus run(CooperativeTask & task);
+  /* Steps the task for up to budget_ms, returns InProgress if that was not
+   * enough, so the task can be resumed e.g. from the next update().
+   */
+  TaskStatus run(CooperativeTask & task, unsigned long const budget_ms);
+
+  inline unsigned long longestStepMillis() const { return _longest_step_ms; }
+
+private:
+
+  FeedWatchdogFunc _feed_watchdog;
+  unsigned long _longest_step_ms;
+
+  TaskStatus step(CooperativeTask & task);
+
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_COOPERATIVE_TASK_H_ */
@@ -0,0 +1,150 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include "CloudThread.h"
+
+#ifdef HAS_CLOUD_THREAD
+
+/**************************************************************************************
+ * CONSTANTS
+ **************************************************************************************/
+
+static uint32_t const CLOUD_THREAD_WAKE_FLAG = 0x01;
+
+/**************************************************************************************
+ * CTOR/DTOR
+ **************************************************************************************/
+
+CloudThread::CloudThread()
+: _is_running{false}
+#if defined(ARDUINO_ARCH_MBED)
+, _thread{nullptr}
+#elif defined(ARDUINO_ARCH_ESP32)
+, _task{nullptr}
+, _mutex{nullptr}
+, _flags{nullptr}
+#endif
+{
+
+}
+
+/**************************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+#if defined(ARDUINO_ARCH_MBED)
+
+bool CloudThread::start(void (*entry)(void *), void * arg)
+{
+  if (_is_running)
+    return false;
+
+  _thread = new rtos::Thread(osPriorityNormal, AIOT_CONFIG_CLOUD_THREAD_STACK_SIZE, nullptr, "ArduinoCloud");
+  if (_thread->start(mbed::callback(entry, arg)) != osOK)
+  {
+    delete _thread;
+    _thread = nullptr;
+    return false;
+  }
+  _is_running = true;
+  return true;
+}
+
+bool CloudThread::isCurrent() const
+{
+  return _is_running && (rtos::ThisThread::get_id() == _thread->get_id());
+}
+
+void CloudThread::lock()
+{
+  _mutex.lock();
+}
+
+void CloudThread::unlock()
+{
+  _mutex.unlock();
+}
+
+void CloudThread::wake()
+{
+  _flags.set(CLOUD_THREAD_WAKE_FLAG);
+}
+
+void CloudThread::wait(unsigned long const timeout_ms)
+{
+  _flags.wait_any_for(CLOUD_THREAD_WAKE_FLAG, std::chrono::milliseconds(timeout_ms));
+}
+
+#elif defined(ARDUINO_ARCH_ESP32)
+
+bool CloudThread::start(void (*entry)(void *), void * arg)
+{
+  if (_is_running)
+    return false;
+
+  _mutex = xSemaphoreCreateRecursiveMutex();
+  _flags = xEventGroupCreate();
+  if ((_mutex == nullptr) || (_flags == nullptr))
+    return false;
+
+#if (AIOT_CONFIG_CLOUD_THREAD_CORE >= 0) && (portNUM_PROCESSORS > 1)
+  BaseType_t const created = xTaskCreatePinnedToCore(entry, "ArduinoCloud", AIOT_CONFIG_CLOUD_THREAD_STACK_SIZE, arg, tskIDLE_PRIORITY + 1, &_task, AIOT_CONFIG_CLOUD_THREAD_CORE);
+#else
+  BaseType_t const created = xTaskCreate(entry, "ArduinoCloud", AIOT_CONFIG_CLOUD_THREAD_STACK_SIZE, arg, tskIDLE_PRIORITY + 1, &_task);
+#endif
+  if (created != pdPASS)
+    return false;
+
+  _is_running = true;
+  return true;
+}
+
+bool CloudThread::isCurrent() const
+{
+  return _is_running && (xTaskGetCurrentTaskHandle() == _task);
+}
+
+void CloudThread::lock()
+{
+  if (_mutex)
+    xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+}
+
+void CloudThread::unlock()
+{
+  if (_mutex)
+    xSemaphoreGiveRecursive(_mutex);
+}
+
+void CloudThread::wake()
+{
+  if (_flags)
+    xEventGroupSetBits(_flags, CLOUD_THREAD_WAKE_FLAG);
+}
+
+void CloudThread::wait(unsigned long const timeout_ms)
+{
+  xEventGroupWaitBits(_flags, CLOUD_THREAD_WAKE_FLAG, pdTRUE, pdFALSE, pdMS_TO_TICKS(timeout_ms));
+}
+
+#endif
+
+#endif /* HAS_CLOUD_THREAD */
@@ -0,0 +1,83 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_IOT_CLOUD_CLOUD_THREAD_H_
+#define ARDUINO_IOT_CLOUD_CLOUD_THREAD_H_
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#ifdef HAS_CLOUD_THREAD
+
+#if defined(ARDUINO_ARCH_MBED)
+#  include <mbed.h>
+#  include <rtos.h>
+#elif defined(ARDUINO_ARCH_ESP32)
+#  include <freertos/FreeRTOS.h>
+#  include <freertos/task.h>
+#  include <freertos/semphr.h>
+#  include <freertos/event_groups.h>
+#endif
+
+/**************************************************************************************
+ * CLASS DECLARATION
+ **************************************************************************************/
+
+/* Thin wrapper around the RTOS primitives needed to run the cloud in a
+ * thread of its own: the thread itself, a recursive mutex guarding the
+ * properties and an event flag to wake the thread before its timeout.
+ */
+class CloudThread
+{
+
+public:
+
+  CloudThread();
+
+  bool start(void (*entry)(void *), void * arg);
+  inline bool isRunning() const { return _is_running; }
+  bool isCurrent() const;
+
+  void lock();
+  void unlock();
+
+  /* May be called from any thread */
+  void wake();
+  /* Called from the cloud thread, returns early once woken */
+  void wait(unsigned long const timeout_ms);
+
+private:
+
+  bool _is_running;
+#if defined(ARDUINO_ARCH_MBED)
+  rtos::Thread * _thread;
+  rtos::Mutex _mutex;
+  rtos::EventFlags _flags;
+#elif defined(ARDUINO_ARCH_ESP32)
+  TaskHandle_t _task;
+  SemaphoreHandle_t _mutex;
+  EventGroupHandle_t _flags;
+#endif
+
+};
+
+#endif /* HAS_CLOUD_THREAD */
+
+#endif /* ARDUINO_IOT_CLOUD_CLOUD_THREAD_H_ */
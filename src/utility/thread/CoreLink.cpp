@@ -0,0 +1,106 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include "CoreLink.h"
+
+#include <string.h>
+
+/**************************************************************************************
+ * CTOR/DTOR
+ **************************************************************************************/
+
+CoreLink::CoreLink()
+: _side{Side::Application}
+, _reserved{nullptr}
+{
+
+}
+
+/**************************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+bool CoreLink::begin(Side const side, void * memory, size_t const size)
+{
+  /* The ring towards the network side comes first, each one starts on a cache line */
+  size_t const half = (size / 2) & ~(SharedRing::CACHE_LINE - 1);
+  uint8_t * const to_network = reinterpret_cast<uint8_t *>(memory);
+  uint8_t * const to_application = to_network + half;
+
+  _side = side;
+  if (side == Side::Application)
+    return _tx.init(to_network, half) && _rx.init(to_application, half);
+  else
+    return _rx.attach(to_network, half) && _tx.attach(to_application, half);
+}
+
+uint8_t * CoreLink::reserve(size_t const length)
+{
+  /* The kind of the message precedes its payload */
+  uint8_t * const buf = _tx.reserve(1 + length);
+  _reserved = buf;
+  return buf ? (buf + 1) : nullptr;
+}
+
+void CoreLink::commit(Kind const kind, size_t const length)
+{
+  if (!_reserved)
+    return;
+  _reserved[0] = static_cast<uint8_t>(kind);
+  _tx.commit(1 + length);
+  _reserved = nullptr;
+}
+
+bool CoreLink::send(Kind const kind, uint8_t const * data, size_t const length)
+{
+  uint8_t * const buf = reserve(length);
+  if (!buf)
+    return false;
+  if (length > 0)
+    memcpy(buf, data, length);
+  commit(kind, length);
+  return true;
+}
+
+bool CoreLink::peek(Kind & kind, uint8_t const * & data, size_t & length)
+{
+  size_t message_length = 0;
+  uint8_t const * const message = _rx.peek(message_length);
+  if (!message)
+    return false;
+
+  /* A message without its kind can only be dropped */
+  if (message_length == 0)
+  {
+    _rx.pop();
+    return peek(kind, data, length);
+  }
+
+  kind = static_cast<Kind>(message[0]);
+  data = message + 1;
+  length = message_length - 1;
+  return true;
+}
+
+void CoreLink::pop()
+{
+  _rx.pop();
+}
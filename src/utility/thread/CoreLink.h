@@ -0,0 +1,85 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_IOT_CLOUD_CORE_LINK_H_
+#define ARDUINO_IOT_CLOUD_CORE_LINK_H_
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include "SharedRing.h"
+
+/**************************************************************************************
+ * CLASS DECLARATION
+ **************************************************************************************/
+
+/* Link between the core which owns the thing properties and the one which
+ * runs the connection to the cloud, e.g. the M7 and the M4 core of the
+ * Portenta H7. It consists of a SharedRing in each direction, both laid out
+ * within one block of memory which both cores reach, e.g. SRAM4. The
+ * application side lays the rings out, the network side attaches to them.
+ *
+ * The messages of the thing are passed as the CBOR payloads received from and
+ * sent to the cloud, so that only the application side encodes and decodes.
+ */
+class CoreLink
+{
+
+public:
+
+  enum class Side : uint8_t
+  {
+    Application,
+    Network
+  };
+
+  enum class Kind : uint8_t
+  {
+    Data,         /* Thing update, from the cloud or to be sent to it */
+    Sync,         /* Last values of the thing */
+    Connected,    /* The thing has been synchronised with the cloud */
+    Disconnected, /* The connection to the cloud has been lost */
+  };
+
+  CoreLink();
+
+  /* The network side returns false until the application side has begun */
+  bool begin(Side const side, void * memory, size_t const size);
+  inline bool isReady() const { return _tx.isReady() && _rx.isReady(); }
+  inline Side side() const { return _side; }
+
+  /* Sends a message to the other core, it is reserved in the ring so that
+   * it can be encoded or received into place and then committed.
+   */
+  uint8_t * reserve(size_t const length);
+  void      commit(Kind const kind, size_t const length);
+  bool      send(Kind const kind, uint8_t const * data = nullptr, size_t const length = 0);
+
+  /* Receives the next message of the other core, it stays in the ring until popped */
+  bool peek(Kind & kind, uint8_t const * & data, size_t & length);
+  void pop();
+
+private:
+
+  Side _side;
+  SharedRing _tx;
+  SharedRing _rx;
+  uint8_t * _reserved;
+};
+
+#endif /* ARDUINO_IOT_CLOUD_CORE_LINK_H_ */
@@ -0,0 +1,105 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_IOT_CLOUD_SEQ_LOCK_H_
+#define ARDUINO_IOT_CLOUD_SEQ_LOCK_H_
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+
+/**************************************************************************************
+ * CLASS DECLARATION
+ **************************************************************************************/
+
+/* Sequence lock around a small plain value, shared between exactly one writer
+ * and any number of readers on other cores. The writer never waits, i.e. it
+ * may be an interrupt. The sequence is odd while a write is in progress and a
+ * reader retries until it has copied the value between two identical even
+ * sequences, hence it must not interrupt the writer on the same core. The
+ * value is kept in 32 bit atomics so a concurrent copy is well defined.
+ */
+template <typename T>
+class SeqLock
+{
+
+public:
+
+  SeqLock(T const & value) : _seq{0}
+  {
+    write(value);
+  }
+
+  SeqLock(SeqLock const & other) : _seq{0}
+  {
+    uint32_t words[WORDS];
+    other.readWords(words);
+    writeWords(words);
+  }
+
+  void write(T const & value)
+  {
+    uint32_t words[WORDS] = {0};
+    memcpy(words, &value, sizeof(T));
+    writeWords(words);
+  }
+
+  void read(T & value) const
+  {
+    uint32_t words[WORDS];
+    readWords(words);
+    memcpy(static_cast<void *>(&value), words, sizeof(T));
+  }
+
+private:
+
+  static size_t const WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  std::atomic<uint32_t> _seq;
+  std::atomic<uint32_t> _word[WORDS];
+
+  void writeWords(uint32_t const * words)
+  {
+    uint32_t const seq = _seq.load(std::memory_order_relaxed);
+    _seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; i++)
+      _word[i].store(words[i], std::memory_order_relaxed);
+    _seq.store(seq + 2, std::memory_order_release);
+  }
+
+  void readWords(uint32_t * words) const
+  {
+    uint32_t seq_begin = 0, seq_end = 0;
+    do
+    {
+      seq_begin = _seq.load(std::memory_order_acquire);
+      for (size_t i = 0; i < WORDS; i++)
+        words[i] = _word[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      seq_end = _seq.load(std::memory_order_relaxed);
+    } while ((seq_begin & 1) || (seq_begin != seq_end));
+  }
+};
+
+#endif /* ARDUINO_IOT_CLOUD_SEQ_LOCK_H_ */
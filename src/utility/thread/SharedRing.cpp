@@ -0,0 +1,255 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include "SharedRing.h"
+
+#include <string.h>
+
+#include <new>
+
+#if defined(ARDUINO_ARCH_MBED)
+#  include <Arduino.h>
+#endif
+
+/**************************************************************************************
+ * STATIC MEMBER DEFINITION
+ **************************************************************************************/
+
+size_t const SharedRing::CACHE_LINE;
+size_t const SharedRing::OVERHEAD;
+
+/**************************************************************************************
+ * CTOR/DTOR
+ **************************************************************************************/
+
+SharedRing::SharedRing()
+: _header{nullptr}
+, _data{nullptr}
+, _size{0}
+, _is_reserved{false}
+, _is_reserved_wrapped{false}
+, _reserved_offset{0}
+, _reserved_length{0}
+, _is_peeked{false}
+, _peeked_length{0}
+{
+
+}
+
+/**************************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+bool SharedRing::init(void * memory, size_t const size)
+{
+  static_assert(sizeof(Header) == OVERHEAD, "The header takes a cache line per index");
+
+  /* A cache line must not be shared with anything else */
+  if (!memory || (reinterpret_cast<uintptr_t>(memory) % CACHE_LINE) || (size < OVERHEAD + CACHE_LINE))
+    return false;
+
+  Header * const header = new (memory) Header;
+  header->size = static_cast<uint32_t>((size - OVERHEAD) & ~(CACHE_LINE - 1));
+  header->head.store(0, std::memory_order_relaxed);
+  header->tail.store(0, std::memory_order_relaxed);
+  header->magic = MAGIC;
+  clean(header, OVERHEAD);
+
+  view(memory);
+  return true;
+}
+
+bool SharedRing::attach(void * memory, size_t const size)
+{
+  if (!memory || (reinterpret_cast<uintptr_t>(memory) % CACHE_LINE) || (size < OVERHEAD + CACHE_LINE))
+    return false;
+
+  invalidate(memory, OVERHEAD);
+  Header const * const header = reinterpret_cast<Header const *>(memory);
+  if ((header->magic != MAGIC) || (header->size > size - OVERHEAD))
+    return false;
+
+  view(memory);
+  return true;
+}
+
+uint8_t * SharedRing::reserve(size_t const length)
+{
+  _is_reserved = false;
+  if (!_header || (length > capacity()))
+    return nullptr;
+
+  uint32_t const block = blockSize(length);
+  invalidate(&_header->head, sizeof(_header->head));
+  uint32_t const head = _header->head.load(std::memory_order_acquire);
+  uint32_t const tail = _header->tail.load(std::memory_order_relaxed);
+
+  /* The tail never catches up with the head, the ring would look empty */
+  uint32_t offset = tail;
+  bool is_wrapped = false;
+  if (tail >= head)
+  {
+    uint32_t const end = _size - tail;
+    if ((block < end) || ((block == end) && (head != 0)))
+      offset = tail;
+    else if (block < head)
+    {
+      offset = 0;
+      is_wrapped = true;
+    }
+    else
+      return nullptr;
+  }
+  else if (block >= head - tail)
+    return nullptr;
+
+  _is_reserved = true;
+  _is_reserved_wrapped = is_wrapped;
+  _reserved_offset = offset;
+  _reserved_length = static_cast<uint32_t>(length);
+  return _data + offset + LENGTH_SIZE;
+}
+
+void SharedRing::commit(size_t const length)
+{
+  if (!_is_reserved || (length > _reserved_length))
+    return;
+  _is_reserved = false;
+
+  if (_is_reserved_wrapped)
+  {
+    uint32_t const tail = _header->tail.load(std::memory_order_relaxed);
+    uint32_t const wrap = WRAP;
+    memcpy(_data + tail, &wrap, LENGTH_SIZE);
+    clean(_data + tail, LENGTH_SIZE);
+  }
+
+  uint32_t const block = blockSize(length);
+  uint32_t const message_length = static_cast<uint32_t>(length);
+  memcpy(_data + _reserved_offset, &message_length, LENGTH_SIZE);
+  clean(_data + _reserved_offset, block);
+
+  uint32_t const tail = (_reserved_offset + block) % _size;
+  _header->tail.store(tail, std::memory_order_release);
+  clean(&_header->tail, sizeof(_header->tail));
+}
+
+bool SharedRing::push(uint8_t const * data, size_t const length)
+{
+  uint8_t * const buf = reserve(length);
+  if (!buf)
+    return false;
+  memcpy(buf, data, length);
+  commit(length);
+  return true;
+}
+
+uint8_t const * SharedRing::peek(size_t & length)
+{
+  _is_peeked = false;
+  if (!_header)
+    return nullptr;
+
+  invalidate(&_header->tail, sizeof(_header->tail));
+  uint32_t const tail = _header->tail.load(std::memory_order_acquire);
+  uint32_t head = _header->head.load(std::memory_order_relaxed);
+  if (head == tail)
+    return nullptr;
+
+  uint32_t message_length = 0;
+  invalidate(_data + head, LENGTH_SIZE);
+  memcpy(&message_length, _data + head, LENGTH_SIZE);
+  if (message_length == WRAP)
+  {
+    head = 0;
+    _header->head.store(head, std::memory_order_release);
+    clean(&_header->head, sizeof(_header->head));
+    if (head == tail)
+      return nullptr;
+    invalidate(_data, LENGTH_SIZE);
+    memcpy(&message_length, _data, LENGTH_SIZE);
+  }
+
+  invalidate(_data + head, blockSize(message_length));
+  _is_peeked = true;
+  _peeked_length = message_length;
+  length = message_length;
+  return _data + head + LENGTH_SIZE;
+}
+
+void SharedRing::pop()
+{
+  if (!_is_peeked)
+    return;
+  _is_peeked = false;
+
+  uint32_t const head = _header->head.load(std::memory_order_relaxed);
+  _header->head.store((head + blockSize(_peeked_length)) % _size, std::memory_order_release);
+  clean(&_header->head, sizeof(_header->head));
+}
+
+size_t SharedRing::capacity() const
+{
+  /* A message must leave one length word free */
+  return (_size > 2 * LENGTH_SIZE) ? (_size - 2 * LENGTH_SIZE) : 0;
+}
+
+/**************************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void SharedRing::view(void * memory)
+{
+  _header = reinterpret_cast<Header *>(memory);
+  _data = reinterpret_cast<uint8_t *>(memory) + OVERHEAD;
+  _size = _header->size;
+  _is_reserved = false;
+  _is_peeked = false;
+}
+
+uint32_t SharedRing::blockSize(size_t const length)
+{
+  return static_cast<uint32_t>(LENGTH_SIZE + ((length + 3) & ~static_cast<size_t>(3)));
+}
+
+void SharedRing::clean(void const * ptr, size_t const size)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  uintptr_t const start = reinterpret_cast<uintptr_t>(ptr) & ~(CACHE_LINE - 1);
+  uintptr_t const end = reinterpret_cast<uintptr_t>(ptr) + size;
+  SCB_CleanDCache_by_Addr(reinterpret_cast<uint32_t *>(start), static_cast<int32_t>(end - start));
+#else
+  (void)ptr;
+  (void)size;
+#endif
+}
+
+void SharedRing::invalidate(void const * ptr, size_t const size)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+  uintptr_t const start = reinterpret_cast<uintptr_t>(ptr) & ~(CACHE_LINE - 1);
+  uintptr_t const end = reinterpret_cast<uintptr_t>(ptr) + size;
+  SCB_InvalidateDCache_by_Addr(reinterpret_cast<uint32_t *>(start), static_cast<int32_t>(end - start));
+#else
+  (void)ptr;
+  (void)size;
+#endif
+}
@@ -0,0 +1,111 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_IOT_CLOUD_SHARED_RING_H_
+#define ARDUINO_IOT_CLOUD_SHARED_RING_H_
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/**************************************************************************************
+ * CLASS DECLARATION
+ **************************************************************************************/
+
+/* Lock-free ring of variable sized messages between exactly one producer and
+ * one consumer on different cores, e.g. the M7 and the M4 core of the
+ * Portenta H7. The ring lives within memory both cores can reach, each core
+ * keeps a view of its own onto it. A message is reserved as one contiguous
+ * block, so that it can be encoded or received right into the ring. As in
+ * SpscQueue each index is written by one side only, on a core with a data
+ * cache the lines written are cleaned and those read are invalidated.
+ */
+class SharedRing
+{
+
+public:
+
+  static size_t const CACHE_LINE = 32;
+
+  SharedRing();
+
+  /* Lays the ring out within memory, before the other core attaches */
+  bool init(void * memory, size_t const size);
+  /* Attaches to the ring laid out by the other core, false as long as
+   * it has not done so yet.
+   */
+  bool attach(void * memory, size_t const size);
+  inline bool isReady() const { return _header != nullptr; }
+
+  /* Producer side, the message reserved last is committed with at most
+   * the length reserved. Returns nullptr if there is no room for it.
+   */
+  uint8_t * reserve(size_t const length);
+  void      commit(size_t const length);
+  bool      push(uint8_t const * data, size_t const length);
+
+  /* Consumer side, the message returned by peek() stays in the ring until
+   * it is popped. Returns nullptr if the ring is empty.
+   */
+  uint8_t const * peek(size_t & length);
+  void            pop();
+
+  /* Longest message which fits into the empty ring */
+  size_t capacity() const;
+  /* Bytes taken by the layout besides the messages, a cache line per index */
+  static size_t const OVERHEAD = 3 * CACHE_LINE;
+
+private:
+
+  /* Each index has a cache line of its own, it is cleaned by its writer
+   * and invalidated by its reader.
+   */
+  struct Header
+  {
+    alignas(CACHE_LINE) uint32_t magic;
+    uint32_t size;
+    alignas(CACHE_LINE) std::atomic<uint32_t> head;
+    alignas(CACHE_LINE) std::atomic<uint32_t> tail;
+  };
+
+  static uint32_t const MAGIC = 0x52494E47; /* "RING" */
+  static uint32_t const WRAP  = 0xFFFFFFFF; /* The next message starts at the beginning */
+  static size_t const LENGTH_SIZE = sizeof(uint32_t);
+
+  Header * _header;
+  uint8_t * _data;
+  uint32_t _size;
+  bool _is_reserved;
+  bool _is_reserved_wrapped;
+  uint32_t _reserved_offset;
+  uint32_t _reserved_length;
+  bool _is_peeked;
+  uint32_t _peeked_length;
+
+  void view(void * memory);
+
+  static uint32_t blockSize(size_t const length);
+  static void clean(void const * ptr, size_t const size);
+  static void invalidate(void const * ptr, size_t const size);
+};
+
+#endif /* ARDUINO_IOT_CLOUD_SHARED_RING_H_ */
@@ -0,0 +1,84 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_IOT_CLOUD_SPSC_QUEUE_H_
+#define ARDUINO_IOT_CLOUD_SPSC_QUEUE_H_
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include <stddef.h>
+
+#include <atomic>
+
+/**************************************************************************************
+ * CLASS DECLARATION
+ **************************************************************************************/
+
+/* Lock-free queue between exactly one producer and one consumer thread, e.g.
+ * the cloud thread and the sketch. Each index is written by one side only,
+ * so acquire/release ordering of the indices is all the synchronisation
+ * needed. One slot is kept free to tell a full queue from an empty one.
+ */
+template <typename T, size_t N>
+class SpscQueue
+{
+
+public:
+
+  SpscQueue() : _head{0}, _tail{0} { }
+
+  /* Producer side, returns false if the queue is full */
+  bool push(T const & item)
+  {
+    size_t const tail = _tail.load(std::memory_order_relaxed);
+    size_t const next = (tail + 1) % (N + 1);
+    if (next == _head.load(std::memory_order_acquire))
+      return false;
+    _item[tail] = item;
+    _tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /* Consumer side, returns false if the queue is empty */
+  bool pop(T & item)
+  {
+    size_t const head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire))
+      return false;
+    item = _item[head];
+    _head.store((head + 1) % (N + 1), std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const
+  {
+    return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+  }
+
+  static constexpr size_t capacity() { return N; }
+
+private:
+
+  T _item[N + 1];
+  std::atomic<size_t> _head;
+  std::atomic<size_t> _tail;
+
+};
+
+#endif /* ARDUINO_IOT_CLOUD_SPSC_QUEUE_H_ */
@@ -0,0 +1,95 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include "ClockDiscipline.h"
+
+/**************************************************************************************
+ * CTOR/DTOR
+ **************************************************************************************/
+
+ClockDiscipline::ClockDiscipline()
+: _sample{0}
+, _sample_cnt(0)
+, _skew_ppb(0)
+, _restart_tick(0)
+{
+
+}
+
+/**************************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void ClockDiscipline::restart(unsigned long const tick)
+{
+  _restart_tick = tick;
+}
+
+long ClockDiscipline::correction(unsigned long const tick) const
+{
+  int64_t const elapsed_ms = static_cast<int64_t>(tick - _restart_tick);
+  return static_cast<long>((elapsed_ms * _skew_ppb) / 1000000000000LL);
+}
+
+void ClockDiscipline::clearSamples()
+{
+  _sample_cnt = 0;
+}
+
+void ClockDiscipline::addSample(long const offset)
+{
+  if (_sample_cnt >= MAX_SAMPLES)
+    return;
+
+  /* Keep the samples sorted, there are only a few of them */
+  size_t i = _sample_cnt++;
+  for (; (i > 0) && (_sample[i - 1] > offset); i--)
+    _sample[i] = _sample[i - 1];
+  _sample[i] = offset;
+}
+
+long ClockDiscipline::offset() const
+{
+  if (_sample_cnt == 0)
+    return 0;
+  return _sample[_sample_cnt / 2];
+}
+
+void ClockDiscipline::updateSkew(long const offset, unsigned long const tick)
+{
+  unsigned long const elapsed_ms = tick - _restart_tick;
+  if (elapsed_ms < MIN_SKEW_INTERVAL_ms)
+    return;
+
+  /* An offset this large is a step of the time, e.g. set by the user, not a drift */
+  if ((offset > MAX_SKEW_OFFSET_s) || (offset < -MAX_SKEW_OFFSET_s))
+    return;
+
+  /* The residual offset is what the current estimate failed to correct,
+   * apply half of it to smooth out the one second resolution of NTP.
+   */
+  int64_t const residual_ppb = (static_cast<int64_t>(offset) * 1000000000000LL) / static_cast<int64_t>(elapsed_ms);
+  int64_t skew_ppb = _skew_ppb + residual_ppb / 2;
+
+  if (skew_ppb >  MAX_SKEW_ppb) skew_ppb =  MAX_SKEW_ppb;
+  if (skew_ppb < -MAX_SKEW_ppb) skew_ppb = -MAX_SKEW_ppb;
+  _skew_ppb = static_cast<int32_t>(skew_ppb);
+}
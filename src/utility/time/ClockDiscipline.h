@@ -0,0 +1,81 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_IOT_CLOUD_CLOCK_DISCIPLINE_H_
+#define ARDUINO_IOT_CLOUD_CLOCK_DISCIPLINE_H_
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**************************************************************************************
+ * CLASS DECLARATION
+ **************************************************************************************/
+
+/* Keeps track of the skew of the RTC oscillator: the offsets measured against
+ * NTP are collected, the median of which rejects outliers caused e.g. by a
+ * delayed reply. The residual offset left after a sync interval is used to
+ * refine the skew estimate, the RTC time is then corrected by the skew
+ * accumulated since it was last set.
+ */
+class ClockDiscipline
+{
+
+public:
+
+  ClockDiscipline();
+
+  /* Restarts the accumulation of the correction, to be called whenever the RTC is set */
+  void restart(unsigned long const tick);
+  /* Correction in seconds to apply to the RTC time at a given tick */
+  long correction(unsigned long const tick) const;
+
+  void clearSamples();
+  void addSample(long const offset);
+  size_t samples() const { return _sample_cnt; }
+  bool   isComplete() const { return _sample_cnt >= MAX_SAMPLES; }
+  /* Median of the collected offsets, to be called with at least one sample */
+  long   offset() const;
+
+  /* Refines the skew estimate from the offset left after the RTC ran
+   * corrected since the last restart.
+   */
+  void updateSkew(long const offset, unsigned long const tick);
+
+  int32_t skew_ppb() const { return _skew_ppb; }
+
+private:
+
+  static size_t   const MAX_SAMPLES           = AIOT_CONFIG_TIME_SYNC_SAMPLES;
+  /* A shorter interval does not give a meaningful estimate using one second resolution */
+  static unsigned long const MIN_SKEW_INTERVAL_ms = 60UL * 60UL * 1000UL;
+  static int32_t  const MAX_SKEW_ppb          = 2000000L;
+  static long     const MAX_SKEW_OFFSET_s     = 60L * 60L;
+
+  long _sample[MAX_SAMPLES];
+  size_t _sample_cnt;
+  int32_t _skew_ppb;
+  unsigned long _restart_tick;
+
+};
+
+#endif /* ARDUINO_IOT_CLOUD_CLOCK_DISCIPLINE_H_ */
@@ -27,6 +27,7 @@
 #include <Arduino.h>
 #ifdef BOARD_HAS_ECCX08
   #include <ArduinoECCX08.h>
+  #include "../../tls/utility/DRBG.h"
 #endif
 
 /**************************************************************************************
@@ -34,6 +35,24 @@
  **************************************************************************************/
 
 unsigned long NTPUtils::getTime(UDP & udp)
+{
+  requestTime(udp);
+
+  unsigned long epoch = 0;
+  unsigned long const start = millis();
+  do
+  {
+    epoch = pollTime(udp);
+  } while(!epoch && (millis() - start) < NTP_TIMEOUT_MS);
+
+  if(!epoch) {
+    stop(udp);
+  }
+
+  return epoch;
+}
+
+void NTPUtils::requestTime(UDP & udp)
 {
 #ifdef NTP_USE_RANDOM_PORT
   udp.begin(NTPUtils::getRandomPort(MIN_NTP_PORT, MAX_NTP_PORT));
@@ -42,19 +61,14 @@ unsigned long NTPUtils::getTime(UDP & udp)
 #endif
 
   sendNTPpacket(udp);
+}
 
-  bool is_timeout = false;
-  unsigned long const start = millis();
-  do
-  {
-    is_timeout = (millis() - start) >= NTP_TIMEOUT_MS;
-  } while(!is_timeout && !udp.parsePacket());
-
-  if(is_timeout) {
-    udp.stop();
+unsigned long NTPUtils::pollTime(UDP & udp)
+{
+  if(!udp.parsePacket()) {
     return 0;
   }
-  
+
   uint8_t ntp_packet_buf[NTP_PACKET_SIZE];
   udp.read(ntp_packet_buf, NTP_PACKET_SIZE);
   udp.stop();
@@ -68,6 +82,11 @@ unsigned long NTPUtils::getTime(UDP & udp)
   return epoch;
 }
 
+void NTPUtils::stop(UDP & udp)
+{
+  udp.stop();
+}
+
 /**************************************************************************************
  * PRIVATE MEMBER FUNCTIONS
  **************************************************************************************/
@@ -93,6 +112,10 @@ void NTPUtils::sendNTPpacket(UDP & udp)
 int NTPUtils::getRandomPort(int const min_port, int const max_port)
 {
 #if defined (BOARD_HAS_ECCX08)
+  uint32_t port_random = 0;
+  if (drbg_generate(&port_random, sizeof(port_random))) {
+    return min_port + static_cast<int>(port_random % static_cast<uint32_t>(max_port - min_port));
+  }
   return ECCX08.random(min_port, max_port);
 #elif defined (ARDUINO_ARCH_ESP8266) || (ARDUINO_ARCH_ESP32)
   /* Uses HW Random Number Generator */
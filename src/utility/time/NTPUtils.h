@@ -44,6 +44,17 @@ public:
   static unsigned long getTime(UDP & udp);
   static int getRandomPort(int const min_port, int const max_port);
 
+  /* Non-blocking variant of getTime: requestTime sends the NTP request,
+   * pollTime returns 0 until the reply has been received and parsed.
+   * The caller is responsible for the timeout and has to call stop()
+   * if it gives up on the reply.
+   */
+  static void requestTime(UDP & udp);
+  static unsigned long pollTime(UDP & udp);
+  static void stop(UDP & udp);
+
+  static unsigned long const NTP_TIMEOUT_MS       = 1000;
+
 private:
 
   static size_t        const NTP_PACKET_SIZE      = 48;
@@ -53,7 +64,6 @@ private:
   static int           const MIN_NTP_PORT         = 49152;
   static int           const MAX_NTP_PORT         = 65535;
 #endif
-  static unsigned long const NTP_TIMEOUT_MS       = 1000;
   static constexpr const char * NTP_TIME_SERVER   = "time.arduino.cc";
 
   static void sendNTPpacket(UDP & udp);
@@ -15,7 +15,7 @@
    a commercial license, send an email to license@arduino.cc.
 */
 
-#ifdef ARDUINO_ARCH_ESP8266
+#if defined(ARDUINO_ARCH_ESP8266) || defined(HOST)
 
 /**************************************************************************************
  * INCLUDE
@@ -60,4 +60,4 @@ unsigned long RTCMillis::get()
   return _last_rtc_update_value;
 }
 
-#endif /* ARDUINO_ARCH_ESP8266 */
+#endif /* ARDUINO_ARCH_ESP8266 || HOST */
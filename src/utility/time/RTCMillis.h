@@ -18,7 +18,7 @@
 #ifndef ARDUINO_IOT_CLOUD_RTC_MILLIS_H_
 #define ARDUINO_IOT_CLOUD_RTC_MILLIS_H_
 
-#ifdef ARDUINO_ARCH_ESP8266
+#if defined(ARDUINO_ARCH_ESP8266) || defined(HOST)
 
 /**************************************************************************************
  * INCLUDE
@@ -45,6 +45,6 @@ private:
 
 };
 
-#endif /* ARDUINO_ARCH_ESP8266 */
+#endif /* ARDUINO_ARCH_ESP8266 || HOST */
 
 #endif /* ARDUINO_IOT_CLOUD_RTC_MILLIS_H_ */
@@ -0,0 +1,68 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include "RTCReadSync.h"
+
+/**************************************************************************************
+ * CTOR/DTOR
+ **************************************************************************************/
+
+RTCReadSync::RTCReadSync()
+: _sync_tick(0)
+{
+
+}
+
+/**************************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void RTCReadSync::restart(unsigned long const tick)
+{
+  _sync_tick = tick;
+}
+
+unsigned long RTCReadSync::take(unsigned long const synced_time, unsigned long const tick)
+{
+  unsigned long const elapsed_s = (tick - _sync_tick) / 1000;
+  _sync_tick = tick;
+  return synced_time + elapsed_s;
+}
+
+unsigned long RTCReadSync::calendarToEpoch(unsigned int const year,
+                                           unsigned int const month,
+                                           unsigned int const day,
+                                           unsigned int const hour,
+                                           unsigned int const minute,
+                                           unsigned int const second)
+{
+  /* Days from 1970-01-01 of the proleptic Gregorian calendar, the year is
+   * counted from March so that the leap day comes last.
+   */
+  unsigned long const y   = (month <= 2) ? (year - 1) : year;
+  unsigned long const era = y / 400;
+  unsigned long const yoe = y - era * 400;
+  unsigned long const doy = (153 * ((month > 2) ? (month - 3) : (month + 9)) + 2) / 5 + day - 1;
+  unsigned long const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  unsigned long const days = era * 146097 + doe - 719468;
+
+  return days * 86400UL + hour * 3600UL + minute * 60UL + second;
+}
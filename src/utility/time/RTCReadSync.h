@@ -0,0 +1,63 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_IOT_CLOUD_RTC_READ_SYNC_H_
+#define ARDUINO_IOT_CLOUD_RTC_READ_SYNC_H_
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include <stdint.h>
+
+/**************************************************************************************
+ * CLASS DECLARATION
+ **************************************************************************************/
+
+/* Keeps track of an RTC read in continuous read synchronization mode, e.g. the
+ * RCONT mode of the SAMD RTC. Every read of the clock register returns the
+ * value synchronized at the previous read and starts the next synchronization,
+ * so no read has to wait for the bus. The value is advanced by the whole
+ * seconds elapsed since then, which makes it lag by a second at most.
+ */
+class RTCReadSync
+{
+
+public:
+
+  RTCReadSync();
+
+  /* To be called once a synchronization has completed at 'tick' */
+  void          restart(unsigned long const tick);
+  /* Returns the RTC seconds at 'tick' given those synchronized at the previous read */
+  unsigned long take(unsigned long const synced_time, unsigned long const tick);
+
+  /* Seconds since the epoch of a calendar date in UTC, 'month' and 'day' start at 1 */
+  static unsigned long calendarToEpoch(unsigned int const year,
+                                       unsigned int const month,
+                                       unsigned int const day,
+                                       unsigned int const hour,
+                                       unsigned int const minute,
+                                       unsigned int const second);
+
+private:
+
+  unsigned long _sync_tick;
+
+};
+
+#endif /* ARDUINO_IOT_CLOUD_RTC_READ_SYNC_H_ */
@@ -0,0 +1,142 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/**************************************************************************************
+ * INCLUDE
+ **************************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#if AIOT_CONFIG_SCHEDULE_ENABLED
+
+#include "ScheduleTimer.h"
+
+#include "property/types/CloudSchedule.h"
+
+/**************************************************************************************
+ * CTOR/DTOR
+ **************************************************************************************/
+
+ScheduleTimerClass::ScheduleTimerClass()
+: _head(nullptr)
+, _last_now(0)
+{
+
+}
+
+/**************************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void ScheduleTimerClass::schedule(CloudSchedule & s)
+{
+  unlink(s);
+  s._timer_edge = 0;
+  insert(s);
+}
+
+void ScheduleTimerClass::cancel(CloudSchedule & s)
+{
+  unlink(s);
+}
+
+void ScheduleTimerClass::poll(unsigned long const now)
+{
+  if (now == 0)
+    return;
+
+  /* The queued transitions are meaningless once the time went backwards */
+  if (now < _last_now)
+  {
+    for (CloudSchedule * s = _head; s != nullptr; s = s->_timer_next)
+      s->_timer_edge = 0;
+  }
+  _last_now = now;
+
+  while ((_head != nullptr) && (_head->_timer_edge <= now))
+  {
+    CloudSchedule & s = *_head;
+    unlink(s);
+
+    bool const is_active = s._value.isActiveAt(now);
+    bool const was_known = s._is_timer_state_known;
+    bool const was_active = s._is_timer_active;
+    s._is_timer_state_known = true;
+    s._is_timer_active = is_active;
+
+    /* A schedule inactive right from the start has nothing to deactivate */
+    if (is_active && (!was_known || !was_active) && s._on_activate)
+      s._on_activate();
+    else if (!is_active && was_known && was_active && s._on_deactivate)
+      s._on_deactivate();
+
+    /* Unless the callback has rescheduled it already */
+    if (!s._is_timer_queued)
+    {
+      s._timer_edge = s._value.nextTransition();
+      if (s._timer_edge < SCHEDULE_FOREVER)
+        insert(s);
+    }
+  }
+}
+
+bool ScheduleTimerClass::nextEdge(unsigned long long & edge) const
+{
+  if (_head == nullptr)
+    return false;
+
+  edge = _head->_timer_edge;
+  return true;
+}
+
+/**************************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ **************************************************************************************/
+
+void ScheduleTimerClass::insert(CloudSchedule & s)
+{
+  CloudSchedule ** pos = &_head;
+  while ((*pos != nullptr) && ((*pos)->_timer_edge <= s._timer_edge))
+    pos = &((*pos)->_timer_next);
+
+  s._timer_next = *pos;
+  *pos = &s;
+  s._is_timer_queued = true;
+}
+
+void ScheduleTimerClass::unlink(CloudSchedule & s)
+{
+  if (!s._is_timer_queued)
+    return;
+
+  CloudSchedule ** pos = &_head;
+  while ((*pos != nullptr) && (*pos != &s))
+    pos = &((*pos)->_timer_next);
+
+  if (*pos != nullptr)
+    *pos = s._timer_next;
+  s._timer_next = nullptr;
+  s._is_timer_queued = false;
+}
+
+/**************************************************************************************
+ * EXTERN DEFINITION
+ **************************************************************************************/
+
+ScheduleTimerClass ScheduleTimer;
+
+#endif /* AIOT_CONFIG_SCHEDULE_ENABLED */
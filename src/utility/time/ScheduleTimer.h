@@ -0,0 +1,65 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_IOT_CLOUD_SCHEDULE_TIMER_H_
+#define ARDUINO_IOT_CLOUD_SCHEDULE_TIMER_H_
+
+/**************************************************************************************
+ * CLASS DECLARATION
+ **************************************************************************************/
+
+class CloudSchedule;
+
+/* Fires the onActivate/onDeactivate callbacks of the CloudSchedule properties.
+ * Each schedule with a callback is queued, ordered by the time of its next
+ * transition, so that poll() only evaluates the schedules which are due.
+ */
+class ScheduleTimerClass
+{
+
+public:
+
+  ScheduleTimerClass();
+
+  /* Evaluates the schedule on the next call to poll(), e.g. after it has
+   * been modified.
+   */
+  void schedule(CloudSchedule & s);
+  void cancel  (CloudSchedule & s);
+
+  /* Called from ArduinoCloud.update() with the local time, 0 if unknown */
+  void poll(unsigned long const now);
+  inline bool isPending() const { return _head != nullptr; }
+  /* Returns false if no schedule is pending, otherwise the local time of the next transition */
+  bool nextEdge(unsigned long long & edge) const;
+
+private:
+
+  CloudSchedule * _head;
+  unsigned long _last_now;
+
+  void insert(CloudSchedule & s);
+  void unlink(CloudSchedule & s);
+};
+
+/**************************************************************************************
+ * EXTERN DECLARATION
+ **************************************************************************************/
+
+extern ScheduleTimerClass ScheduleTimer;
+
+#endif /* ARDUINO_IOT_CLOUD_SCHEDULE_TIMER_H_ */
@@ -28,13 +28,14 @@
 
 #ifdef ARDUINO_ARCH_SAMD
   #include <RTCZero.h>
+  #include "RTCReadSync.h"
 #endif
 
 #ifdef ARDUINO_ARCH_MBED
   #include <mbed_rtc_time.h>
 #endif
 
-#ifdef ARDUINO_ARCH_ESP8266
+#if defined(ARDUINO_ARCH_ESP8266) || defined(HOST)
   #include "RTCMillis.h"
 #endif
 
@@ -44,9 +45,10 @@
 
 #ifdef ARDUINO_ARCH_SAMD
 RTCZero rtc;
+RTCReadSync rtc_read_sync;
 #endif
 
-#ifdef ARDUINO_ARCH_ESP8266
+#if defined(ARDUINO_ARCH_ESP8266) || defined(HOST)
 RTCMillis rtc;
 #endif
 
@@ -60,6 +62,7 @@ time_t cvt_time(char const * time);
 void samd_initRTC();
 void samd_setRTC(unsigned long time);
 unsigned long samd_getRTC();
+void samd_beginContinuousRead();
 #endif
 
 #ifdef ARDUINO_NANO_RP2040_CONNECT
@@ -86,12 +89,20 @@ void esp8266_setRTC(unsigned long time);
 unsigned long esp8266_getRTC();
 #endif
 
+#ifdef HOST
+void host_initRTC();
+void host_setRTC(unsigned long time);
+unsigned long host_getRTC();
+#endif
+
 /**************************************************************************************
  * CONSTANTS
  **************************************************************************************/
 
 /* Default NTP synch is scheduled each 24 hours from startup */
 static time_t const TIMESERVICE_NTP_SYNC_TIMEOUT_ms = DAYS * 1000;
+/* The RTC is read at most once per second, in between the time is extrapolated via millis() */
+static unsigned long const TIMESERVICE_RTC_READ_INTERVAL_ms = 1000;
 static time_t const EPOCH_AT_COMPILE_TIME = cvt_time(__DATE__);
 static time_t const EPOCH = 0;
 
@@ -108,6 +119,16 @@ TimeServiceClass::TimeServiceClass()
 , _last_sync_tick(0)
 , _sync_interval_ms(TIMESERVICE_NTP_SYNC_TIMEOUT_ms)
 , _sync_func(nullptr)
+, _discipline()
+, _is_cached_time_valid(false)
+, _cached_time(0)
+, _cached_time_tick(0)
+, _anchor_time(0)
+, _anchor_tick(0)
+#if defined(HAS_TCP) && !defined(__AVR__)
+, _is_ntp_request_pending(false)
+, _ntp_request_tick(0)
+#endif
 {
 
 }
@@ -130,15 +151,56 @@ unsigned long TimeServiceClass::getTime()
   /* Check if it's time to sync */
   unsigned long const current_tick = millis();
   bool const is_ntp_sync_timeout = (current_tick - _last_sync_tick) > _sync_interval_ms;
-  if(!_is_rtc_configured || is_ntp_sync_timeout) {
+  if(!_is_rtc_configured) {
+#if defined(HAS_TCP) && !defined(__AVR__)
+    /* Finish the request sent by beginSync() if there is one */
+    if(!completeSync()) {
+      sync();
+    }
+#else
+    sync();
+#endif
+  } else if(is_ntp_sync_timeout) {
+#if defined(HAS_TCP) && !defined(__AVR__)
+    /* The RTC already holds a valid time: resync via NTP without
+     * blocking and keep serving the RTC time until the reply arrives.
+     */
+    if(_sync_func) {
+      sync();
+    } else {
+      asyncSync();
+    }
+#else
     sync();
+#endif
+  }
+
+  /* Reading the RTC can be slow, e.g. the register synchronization of
+   * RTCZero, so the time read is cached and extrapolated for a while.
+   */
+  unsigned long elapsed_ms = millis() - _cached_time_tick;
+  if(!_is_cached_time_valid || elapsed_ms >= TIMESERVICE_RTC_READ_INTERVAL_ms) {
+    _cached_time = getRTC();
+    _cached_time_tick = millis();
+    _is_cached_time_valid = true;
+    elapsed_ms = 0;
   }
 
-  /* Read time from RTC */
-  unsigned long utc = getRTC();
+  advanceAnchor();
+
+  unsigned long const utc = _cached_time + (elapsed_ms / 1000);
   return isTimeValid(utc) ? utc : EPOCH_AT_COMPILE_TIME;
 }
 
+uint64_t TimeServiceClass::getTimeMillis()
+{
+  unsigned long const utc = getTime();
+  if(!_is_rtc_configured || !isTimeValid(_anchor_time)) {
+    return static_cast<uint64_t>(utc) * 1000ULL;
+  }
+  return static_cast<uint64_t>(_anchor_time) * 1000ULL + (millis() - _anchor_tick);
+}
+
 void TimeServiceClass::setTime(unsigned long time)
 {
   setRTC(time);
@@ -146,8 +208,17 @@ void TimeServiceClass::setTime(unsigned long time)
 
 bool TimeServiceClass::sync()
 {
+  bool const was_rtc_configured = _is_rtc_configured;
   _is_rtc_configured = false;
 
+#if defined(HAS_TCP) && !defined(__AVR__)
+  /* A blocking sync supersedes any pending asynchronous request */
+  if(_is_ntp_request_pending) {
+    NTPUtils::stop(_con_hdl->getUDP());
+    _is_ntp_request_pending = false;
+  }
+#endif
+
   unsigned long utc = EPOCH_AT_COMPILE_TIME;
   if(_sync_func) {
     utc = _sync_func();
@@ -163,6 +234,9 @@ bool TimeServiceClass::sync()
 
   if(isTimeValid(utc)) {
     DEBUG_DEBUG("TimeServiceClass::%s  Drift: %d RTC value: %u", __FUNCTION__, getRTC() - utc, utc);
+    if(was_rtc_configured) {
+      _discipline.updateSkew(static_cast<long>(utc - getRTC()), millis());
+    }
     setRTC(utc);
     _last_sync_tick = millis();
     _is_rtc_configured = true;
@@ -170,6 +244,28 @@ bool TimeServiceClass::sync()
   return _is_rtc_configured;
 }
 
+void TimeServiceClass::beginSync()
+{
+#if defined(HAS_TCP) && !defined(__AVR__)
+  /* Only sends the NTP request, so that the reply arrives while the
+   * connection to the broker is set up. The first getTime() waits for
+   * it only if it has not been received by poll() until then.
+   */
+  if(!_is_rtc_configured && !_sync_func && !_is_ntp_request_pending) {
+    asyncSync();
+  }
+#endif
+}
+
+void TimeServiceClass::poll()
+{
+#if defined(HAS_TCP) && !defined(__AVR__)
+  if(_is_ntp_request_pending) {
+    asyncSync();
+  }
+#endif
+}
+
 void TimeServiceClass::setSyncInterval(unsigned long seconds)
 {
   _sync_interval_ms = seconds * 1000;
@@ -225,7 +321,7 @@ unsigned long TimeServiceClass::getTimeFromString(const String& input)
   static const int expected_length = 20;
   static const int expected_parameters = 6;
 
-  if(input == nullptr || input.length() != expected_length) {
+  if(input.length() != expected_length) {
     DEBUG_ERROR("TimeServiceClass::%s invalid input length", __FUNCTION__);
     return 0;
   }
@@ -237,7 +333,7 @@ unsigned long TimeServiceClass::getTimeFromString(const String& input)
     return 0;
   }
 
-  char * s_month_position = strstr(month_names, s_month);
+  char const * s_month_position = strstr(month_names, s_month);
 
   if(s_month_position == nullptr || strlen(s_month) != 3) {
     DEBUG_ERROR("TimeServiceClass::%s invalid month name, use %s", __FUNCTION__, month_names);
@@ -307,6 +403,88 @@ unsigned long TimeServiceClass::getRemoteTime()
   return EPOCH_AT_COMPILE_TIME;
 }
 
+#ifndef __AVR__
+void TimeServiceClass::asyncSync()
+{
+  if(!_is_ntp_request_pending) {
+    if(connected()) {
+      _discipline.clearSamples();
+      NTPUtils::requestTime(_con_hdl->getUDP());
+      _ntp_request_tick = millis();
+      _is_ntp_request_pending = true;
+    }
+    return;
+  }
+
+  unsigned long const ntp_time = NTPUtils::pollTime(_con_hdl->getUDP());
+  if(!_is_rtc_configured) {
+    /* First sync requested by beginSync(): there is no RTC time yet to
+     * take an offset against, so the reply is used as it is.
+     */
+    unsigned long utc = ntp_time;
+    if(!isTimeValid(ntp_time)) {
+      if((millis() - _ntp_request_tick) < NTPUtils::NTP_TIMEOUT_MS) {
+        return;
+      }
+      NTPUtils::stop(_con_hdl->getUDP());
+      utc = _con_hdl->getTime();
+    }
+    _is_ntp_request_pending = false;
+    if(isTimeValid(utc)) {
+      DEBUG_DEBUG("TimeServiceClass::%s RTC value: %u", __FUNCTION__, utc);
+      setRTC(utc);
+      _last_sync_tick = millis();
+      _is_rtc_configured = true;
+    }
+    return;
+  }
+
+  if(isTimeValid(ntp_time)) {
+    _discipline.addSample(static_cast<long>(ntp_time - getRTC()));
+    if(!_discipline.isComplete()) {
+      /* Take the next sample right away */
+      NTPUtils::requestTime(_con_hdl->getUDP());
+      _ntp_request_tick = millis();
+      return;
+    }
+  } else if((millis() - _ntp_request_tick) < NTPUtils::NTP_TIMEOUT_MS) {
+    return;
+  } else {
+    NTPUtils::stop(_con_hdl->getUDP());
+  }
+  _is_ntp_request_pending = false;
+
+  long offset = 0;
+  if(_discipline.samples() > 0) {
+    offset = _discipline.offset();
+  } else {
+    /* No NTP reply, fall back on the connection handler time */
+    unsigned long const connection_time = _con_hdl->getTime();
+    if(!isTimeValid(connection_time)) {
+      return;
+    }
+    offset = static_cast<long>(connection_time - getRTC());
+  }
+
+  _discipline.updateSkew(offset, millis());
+  DEBUG_DEBUG("TimeServiceClass::%s  Drift: %d Skew: %d ppb", __FUNCTION__, -offset, _discipline.skew_ppb());
+  setRTC(getRTC() + offset);
+  _last_sync_tick = millis();
+}
+
+bool TimeServiceClass::completeSync()
+{
+  if(!_is_ntp_request_pending) {
+    return false;
+  }
+  /* Busy waits for the reply like the blocking NTPUtils::getTime() */
+  while(_is_ntp_request_pending) {
+    asyncSync();
+  }
+  return true;
+}
+#endif
+
 #endif  /* HAS_TCP */
 
 bool TimeServiceClass::isTimeValid(unsigned long const time)
@@ -332,6 +510,8 @@ void TimeServiceClass::initRTC()
   esp32_initRTC();
 #elif ARDUINO_ARCH_ESP8266
   esp8266_initRTC();
+#elif defined (HOST)
+  host_initRTC();
 #else
   #error "RTC not available for this architecture"
 #endif
@@ -339,6 +519,10 @@ void TimeServiceClass::initRTC()
 
 void TimeServiceClass::setRTC(unsigned long time)
 {
+  _discipline.restart(millis());
+  _is_cached_time_valid = false;
+  _anchor_time = time;
+  _anchor_tick = millis();
 #if defined (ARDUINO_ARCH_SAMD)
   samd_setRTC(time);
 #elif defined (ARDUINO_NANO_RP2040_CONNECT)
@@ -349,26 +533,45 @@ void TimeServiceClass::setRTC(unsigned long time)
   esp32_setRTC(time);
 #elif ARDUINO_ARCH_ESP8266
   esp8266_setRTC(time);
+#elif defined (HOST)
+  host_setRTC(time);
 #else
   #error "RTC not available for this architecture"
 #endif
 }
 
+/* Moves the anchor of getTimeMillis() forward by whole seconds once a day,
+ * long before millis() wraps around.
+ */
+void TimeServiceClass::advanceAnchor()
+{
+  unsigned long const elapsed_ms = millis() - _anchor_tick;
+  if(elapsed_ms >= (24UL * 60UL * 60UL * 1000UL)) {
+    unsigned long const elapsed_s = elapsed_ms / 1000;
+    _anchor_time += elapsed_s;
+    _anchor_tick += elapsed_s * 1000;
+  }
+}
+
 unsigned long TimeServiceClass::getRTC()
 {
 #if defined (ARDUINO_ARCH_SAMD)
-  return samd_getRTC();
+  unsigned long const rtc = samd_getRTC();
 #elif defined (ARDUINO_NANO_RP2040_CONNECT)
-  return rp2040_connect_getRTC();
+  unsigned long const rtc = rp2040_connect_getRTC();
 #elif defined (BOARD_STM32H7)
-  return stm32h7_getRTC();
+  unsigned long const rtc = stm32h7_getRTC();
 #elif defined (ARDUINO_ARCH_ESP32)
-  return esp32_getRTC();
+  unsigned long const rtc = esp32_getRTC();
 #elif ARDUINO_ARCH_ESP8266
-  return esp8266_getRTC();
+  unsigned long const rtc = esp8266_getRTC();
+#elif defined (HOST)
+  unsigned long const rtc = host_getRTC();
 #else
   #error "RTC not available for this architecture"
 #endif
+  /* Compensate the skew of the RTC accumulated since it was last set */
+  return rtc + _discipline.correction(millis());
 }
 
 /**************************************************************************************
@@ -409,16 +612,42 @@ time_t cvt_time(char const * time)
 void samd_initRTC()
 {
   rtc.begin();
+  samd_beginContinuousRead();
 }
 
 void samd_setRTC(unsigned long time)
 {
   rtc.setEpoch(time);
+  samd_beginContinuousRead();
 }
 
 unsigned long samd_getRTC()
 {
-  return rtc.getEpoch();
+  /* Any RTCZero getter issues a single read request, which ends the continuous mode */
+  if (!RTC->MODE2.READREQ.bit.RCONT) {
+    samd_beginContinuousRead();
+  }
+
+  /* A plain load, the calendar fields are converted without mktime() */
+  RTC_MODE2_CLOCK_Type clock;
+  clock.reg = RTC->MODE2.CLOCK.reg;
+  unsigned long const synced_time = RTCReadSync::calendarToEpoch(clock.bit.YEAR + 2000,
+                                                                 clock.bit.MONTH,
+                                                                 clock.bit.DAY,
+                                                                 clock.bit.HOUR,
+                                                                 clock.bit.MINUTE,
+                                                                 clock.bit.SECOND);
+  return rtc_read_sync.take(synced_time, millis());
+}
+
+void samd_beginContinuousRead()
+{
+  /* Only the first synchronization has to be waited for, every read of
+   * CLOCK starts the next one from then on.
+   */
+  RTC->MODE2.READREQ.reg = RTC_READREQ_RREQ | RTC_READREQ_RCONT | RTC_READREQ_ADDR(0x10);
+  while (RTC->MODE2.STATUS.bit.SYNCBUSY) { }
+  rtc_read_sync.restart(millis());
 }
 #endif
 
@@ -491,6 +720,23 @@ unsigned long esp8266_getRTC()
 }
 #endif
 
+#ifdef HOST
+void host_initRTC()
+{
+  rtc.begin();
+}
+
+void host_setRTC(unsigned long time)
+{
+  rtc.set(time);
+}
+
+unsigned long host_getRTC()
+{
+  return rtc.get();
+}
+#endif
+
 /******************************************************************************
  * EXTERN DEFINITION
  ******************************************************************************/
@@ -25,6 +25,8 @@
 #include <AIoTC_Config.h>
 #include <Arduino_ConnectionHandler.h>
 
+#include "ClockDiscipline.h"
+
 /******************************************************************************
  * TYPEDEF
  ******************************************************************************/
@@ -44,10 +46,17 @@ public:
 
   void          begin  (ConnectionHandler * con_hdl);
   unsigned long getTime();
+  /* Milliseconds since the epoch. They advance with millis() from the last
+   * time the RTC has been set, i.e. they are ordered but may be off by up to
+   * a second against getTime(), whose seconds the RTC counts on its own.
+   */
+  uint64_t      getTimeMillis();
   void          setTime(unsigned long time);
   unsigned long getLocalTime();
   void          setTimeZoneData(long offset, unsigned long valid_until);
   bool          sync();
+  void          beginSync();
+  void          poll();
   void          setSyncInterval(unsigned long seconds);
   void          setSyncFunction(syncTimeFunctionPtr sync_func);
 
@@ -66,14 +75,29 @@ private:
   unsigned long _last_sync_tick;
   unsigned long _sync_interval_ms;
   syncTimeFunctionPtr _sync_func;
+  ClockDiscipline _discipline;
+  bool _is_cached_time_valid;
+  unsigned long _cached_time;
+  unsigned long _cached_time_tick;
+  unsigned long _anchor_time;
+  unsigned long _anchor_tick;
+#if defined(HAS_TCP) && !defined(__AVR__)
+  bool _is_ntp_request_pending;
+  unsigned long _ntp_request_tick;
+#endif
 
 #ifdef HAS_TCP
   unsigned long getRemoteTime();
   bool connected();
+#endif
+#if defined(HAS_TCP) && !defined(__AVR__)
+  void asyncSync();
+  bool completeSync();
 #endif
   void initRTC();
   void setRTC(unsigned long time);
   unsigned long getRTC();
+  void advanceAnchor();
   static bool isTimeValid(unsigned long const time);
   static bool isTimeZoneOffsetValid(long const offset);
 
@@ -0,0 +1,87 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "Trace.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+size_t const TraceBuffer::SIZE;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+TraceBuffer::TraceBuffer()
+: _cnt{0}
+, _enabled{true}
+{
+  memset(_record, 0, sizeof(_record));
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+size_t TraceBuffer::copy(TraceRecord * records, size_t const max_cnt) const
+{
+  uint32_t const kept = (_cnt > SIZE) ? SIZE : _cnt;
+  size_t const cnt = (kept < max_cnt) ? kept : max_cnt;
+  uint32_t const first = _cnt - kept;
+  for (size_t i = 0; i < cnt; i++)
+    records[i] = _record[(first + i) % SIZE];
+  return cnt;
+}
+
+void TraceBuffer::clear()
+{
+  _cnt = 0;
+}
+
+char const * TraceBuffer::eventName(TraceEvent const event)
+{
+  switch (event)
+  {
+    case TraceEvent::State:       return "State";
+    case TraceEvent::EncodeBegin: return "EncodeBegin";
+    case TraceEvent::EncodeEnd:   return "EncodeEnd";
+    case TraceEvent::DecodeBegin: return "DecodeBegin";
+    case TraceEvent::DecodeEnd:   return "DecodeEnd";
+    case TraceEvent::MqttWrite:   return "MqttWrite";
+    case TraceEvent::MqttPoll:    return "MqttPoll";
+    case TraceEvent::TlsRead:     return "TlsRead";
+    case TraceEvent::TlsWrite:    return "TlsWrite";
+  }
+  return "?";
+}
+
+/******************************************************************************
+ * FUNCTION DEFINITION
+ ******************************************************************************/
+
+TraceBuffer & trace_buffer()
+{
+  static TraceBuffer buffer;
+  return buffer;
+}
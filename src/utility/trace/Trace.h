@@ -0,0 +1,139 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_TRACE_H_
+#define ARDUINO_AIOTC_UTILITY_TRACE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <AIoTC_Config.h>
+
+#include <Arduino.h>
+
+/******************************************************************************
+ * DEFINES
+ ******************************************************************************/
+
+/* Records a trace point, e.g. AIOTC_TRACE(MqttWrite, length). Without
+ * AIOT_CONFIG_TRACE_ENABLED the argument is not even evaluated.
+ */
+#if AIOT_CONFIG_TRACE_ENABLED
+  #define AIOTC_TRACE(event, arg) trace_buffer().record(TraceEvent::event, static_cast<uint32_t>(arg))
+#else
+  #define AIOTC_TRACE(event, arg) do { } while (0)
+#endif
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+enum class TraceEvent : uint8_t
+{
+  State,       /* arg: state entered by the state machine */
+  EncodeBegin, /* arg: index of the first property */
+  EncodeEnd,   /* arg: bytes encoded */
+  DecodeBegin, /* arg: bytes available */
+  DecodeEnd,   /* arg: state of the decoder */
+  MqttWrite,   /* arg: bytes handed over to the MQTT client */
+  MqttPoll,    /* arg: 1 before and 0 after polling */
+  TlsRead,     /* arg: bytes read or negative error */
+  TlsWrite     /* arg: bytes written */
+};
+
+/* Fixed size binary record, dumped as is */
+struct TraceRecord
+{
+  uint32_t time_us;
+  uint16_t arg;  /* Only the lower 16 bits are kept */
+  uint8_t  event;
+  uint8_t  seq;  /* Lower 8 bits of the record number, to spot lost records */
+};
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Ring buffer of the most recent trace records. Only meant to be used from
+ * the thread running update(), not from interrupts.
+ */
+class TraceBuffer
+{
+public:
+
+  static size_t const SIZE = AIOT_CONFIG_TRACE_BUFFER_SIZE;
+  /* Keeps the index continuous when the record count wraps around */
+  static_assert((SIZE > 0) && ((SIZE & (SIZE - 1)) == 0), "AIOT_CONFIG_TRACE_BUFFER_SIZE must be a power of two");
+
+  TraceBuffer();
+
+  inline void record(TraceEvent const event, uint32_t const arg)
+  {
+    if (!_enabled)
+      return;
+    TraceRecord & r = _record[_cnt % SIZE];
+    r.time_us = micros();
+    r.arg = static_cast<uint16_t>(arg);
+    r.event = static_cast<uint8_t>(event);
+    r.seq = static_cast<uint8_t>(_cnt);
+    _cnt++;
+  }
+
+  /* Copies up to max_cnt of the kept records, oldest first */
+  size_t copy(TraceRecord * records, size_t const max_cnt) const;
+  void clear();
+
+  /* While disabled the trace points are passed without recording them */
+  inline void setEnabled(bool const enabled) { _enabled = enabled; }
+  inline bool isEnabled() const { return _enabled; }
+
+  /* Number of records since the last clear(), including overwritten ones */
+  inline uint32_t recordCount() const { return _cnt; }
+
+  static char const * eventName(TraceEvent const event);
+
+  /* Prints one "<time_us> <event> <arg>" line per record, e.g. to Serial */
+  template <typename Output>
+  void dump(Output & out) const
+  {
+    uint32_t const first = (_cnt > SIZE) ? (_cnt - SIZE) : 0;
+    for (uint32_t i = first; i < _cnt; i++)
+    {
+      TraceRecord const & r = _record[i % SIZE];
+      out.print(static_cast<unsigned long>(r.time_us));
+      out.print(' ');
+      out.print(eventName(static_cast<TraceEvent>(r.event)));
+      out.print(' ');
+      out.println(static_cast<unsigned int>(r.arg));
+    }
+  }
+
+private:
+
+  TraceRecord _record[SIZE];
+  uint32_t _cnt;
+  bool _enabled;
+};
+
+/******************************************************************************
+ * FUNCTION DECLARATION
+ ******************************************************************************/
+
+TraceBuffer & trace_buffer();
+
+#endif /* ARDUINO_AIOTC_UTILITY_TRACE_H_ */
@@ -0,0 +1,106 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "TraceCapture.h"
+
+#include <string.h>
+
+/******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+size_t const TraceCapture::CHUNK_HEADER_SIZE;
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+TraceCapture::TraceCapture(TraceBuffer & trace)
+: _trace(trace)
+, _cnt{0}
+, _next{0}
+, _state{State::Idle}
+, _start_tick{0}
+, _duration_ms{0}
+{
+  memset(_record, 0, sizeof(_record));
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+void TraceCapture::start(unsigned long const duration_ms, unsigned long const now)
+{
+  _cnt = 0;
+  _next = 0;
+  _trace.clear();
+
+  if (duration_ms == 0)
+  {
+    _trace.setEnabled(false);
+    _state = State::Idle;
+    return;
+  }
+
+  _start_tick = now;
+  _duration_ms = duration_ms;
+  _trace.setEnabled(true);
+  _state = State::Recording;
+}
+
+void TraceCapture::update(unsigned long const now)
+{
+  if ((_state != State::Recording) || ((now - _start_tick) < _duration_ms))
+    return;
+
+  _trace.setEnabled(false);
+  _cnt = _trace.copy(_record, TraceBuffer::SIZE);
+  _next = 0;
+  _state = State::Uploading;
+}
+
+unsigned long TraceCapture::endsIn(unsigned long const now) const
+{
+  unsigned long const elapsed = now - _start_tick;
+  return (elapsed < _duration_ms) ? (_duration_ms - elapsed) : 0;
+}
+
+size_t TraceCapture::nextChunk(uint8_t * buf, size_t const max_len)
+{
+  if ((_state != State::Uploading) || (max_len < (CHUNK_HEADER_SIZE + sizeof(TraceRecord))))
+    return 0;
+
+  size_t const max_records = (max_len - CHUNK_HEADER_SIZE) / sizeof(TraceRecord);
+  size_t const records = ((_cnt - _next) < max_records) ? (_cnt - _next) : max_records;
+
+  buf[0] = static_cast<uint8_t>(_next);
+  buf[1] = static_cast<uint8_t>(_next >> 8);
+  buf[2] = static_cast<uint8_t>(_cnt);
+  buf[3] = static_cast<uint8_t>(_cnt >> 8);
+  memcpy(buf + CHUNK_HEADER_SIZE, _record + _next, records * sizeof(TraceRecord));
+
+  /* A capture without any record is still reported by a chunk of its header */
+  _next += records;
+  if (_next == _cnt)
+    _state = State::Idle;
+  return CHUNK_HEADER_SIZE + records * sizeof(TraceRecord);
+}
@@ -0,0 +1,80 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_TRACE_CAPTURE_H_
+#define ARDUINO_AIOTC_UTILITY_TRACE_CAPTURE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "Trace.h"
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* A capture of the trace requested by the cloud. The trace buffer records
+ * only while a capture is running. Once the capture ends, the records kept
+ * by the ring are copied so that they can be uploaded chunk by chunk while
+ * tracing goes on. Each chunk starts with the index of its first record and
+ * the number of records captured, both 16 bit little endian, followed by
+ * the records as they are.
+ */
+class TraceCapture
+{
+public:
+
+  enum class State
+  {
+    Idle,
+    Recording,
+    Uploading
+  };
+
+  static size_t const CHUNK_HEADER_SIZE = 4;
+
+  TraceCapture(TraceBuffer & trace);
+
+  /* Clears the trace and records it for duration_ms, 0 aborts a capture */
+  void start(unsigned long const duration_ms, unsigned long const now);
+  /* Takes the records once the duration has passed */
+  void update(unsigned long const now);
+
+  /* Copies the next chunk into buf, as many records as fit into max_len.
+   * Returns the length of the chunk, 0 once all of them have been taken.
+   */
+  size_t nextChunk(uint8_t * buf, size_t const max_len);
+
+  /* Time left until the running capture ends */
+  unsigned long endsIn(unsigned long const now) const;
+
+  inline State state() const { return _state; }
+  inline size_t recordCount() const { return _cnt; }
+
+private:
+
+  TraceBuffer & _trace;
+  TraceRecord _record[TraceBuffer::SIZE];
+  size_t _cnt;
+  size_t _next;
+  State _state;
+  unsigned long _start_tick;
+  unsigned long _duration_ms;
+};
+
+#endif /* ARDUINO_AIOTC_UTILITY_TRACE_CAPTURE_H_ */
@@ -0,0 +1,158 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "URLParser.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/******************************************************************************
+ * LOCAL MODULE FUNCTIONS
+ ******************************************************************************/
+
+static char url_tolower(char const c)
+{
+  return ((c >= 'A') && (c <= 'Z')) ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static URLSpan url_span(char const * begin, char const * end)
+{
+  URLSpan span;
+  span.str = begin;
+  span.len = static_cast<size_t>(end - begin);
+  return span;
+}
+
+/* First occurrence of any of the characters in set, end if there is none */
+static char const * url_find(char const * begin, char const * end, char const * set)
+{
+  for (; begin != end; begin++)
+    if (strchr(set, *begin))
+      return begin;
+  return end;
+}
+
+/******************************************************************************
+ * FUNCTION DEFINITION
+ ******************************************************************************/
+
+bool url_parse(char const * url, URL & parsed)
+{
+  memset(&parsed, 0, sizeof(parsed));
+  if (!url)
+    return false;
+
+  char const * const end = url + strlen(url);
+
+  /* The scheme ends with the first ':', which precedes any '/', '?' or '#' */
+  char const * const scheme_end = url_find(url, end, ":/?#");
+  if ((scheme_end == end) || (scheme_end == url) || (strncmp(scheme_end, "://", 3) != 0))
+    return false;
+  parsed.scheme = url_span(url, scheme_end);
+
+  /* The authority ends with the path, the query or the fragment */
+  char const * authority = scheme_end + 3;
+  char const * const authority_end = url_find(authority, end, "/?#");
+
+  /* Skip user information, whatever precedes the last '@' */
+  for (char const * c = authority; c != authority_end; c++)
+    if (*c == '@')
+      authority = c + 1;
+
+  char const * host_end = nullptr;
+  char const * port = authority_end;
+  if ((authority != authority_end) && (*authority == '['))
+  {
+    /* IPv6 address, e.g. [::1]:8080 */
+    host_end = url_find(authority, authority_end, "]");
+    if (host_end == authority_end)
+      return false;
+    parsed.host = url_span(authority + 1, host_end);
+    port = host_end + 1;
+    if ((port != authority_end) && (*port != ':'))
+      return false;
+  }
+  else
+  {
+    host_end = url_find(authority, authority_end, ":");
+    parsed.host = url_span(authority, host_end);
+    port = host_end;
+  }
+
+  if (parsed.host.len == 0)
+    return false;
+
+  if (port != authority_end)
+  {
+    /* Skip the ':', an empty port is allowed and means the default one */
+    uint32_t value = 0;
+    for (port++; port != authority_end; port++)
+    {
+      if ((*port < '0') || (*port > '9'))
+        return false;
+      value = value * 10 + static_cast<uint32_t>(*port - '0');
+      if (value > 0xFFFF)
+        return false;
+    }
+    parsed.port = static_cast<uint16_t>(value);
+  }
+
+  char const * const path_end = url_find(authority_end, end, "?#");
+  parsed.path = url_span(authority_end, path_end);
+
+  if ((path_end != end) && (*path_end == '?'))
+    parsed.query = url_span(path_end + 1, url_find(path_end + 1, end, "#"));
+  else
+    parsed.query = url_span(path_end, path_end);
+
+  return true;
+}
+
+bool url_equals(URLSpan const & span, char const * str)
+{
+  for (size_t i = 0; i < span.len; i++, str++)
+    if ((*str == '\0') || (url_tolower(span.str[i]) != url_tolower(*str)))
+      return false;
+  return *str == '\0';
+}
+
+bool url_copy(URLSpan const & span, char * buf, size_t const size)
+{
+  if (span.len >= size)
+    return false;
+  if (span.len > 0)
+    memcpy(buf, span.str, span.len);
+  buf[span.len] = '\0';
+  return true;
+}
+
+bool url_host_header(URL const & url, char * buf, size_t const size)
+{
+  /* Only an IPv6 address contains a ':' once the brackets are dropped */
+  bool const is_ipv6 = (url_find(url.host.str, url.host.str + url.host.len, ":") != url.host.str + url.host.len);
+
+  char port[7] = "";
+  if (url.port != 0)
+    snprintf(port, sizeof(port), ":%u", static_cast<unsigned int>(url.port));
+
+  int const len = snprintf(buf, size, is_ipv6 ? "[%.*s]%s" : "%.*s%s", static_cast<int>(url.host.len), url.host.str, port);
+  return (len >= 0) && (static_cast<size_t>(len) < size);
+}
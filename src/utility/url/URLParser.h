@@ -0,0 +1,79 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_URL_PARSER_H_
+#define ARDUINO_AIOTC_UTILITY_URL_PARSER_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+/* A part of the parsed url, pointing into the original string which must
+ * therefore outlive it. It is not null terminated.
+ */
+struct URLSpan
+{
+  char const * str;
+  size_t       len;
+};
+
+/* scheme://[user@]host[:port][/path][?query][#fragment]
+ *
+ * The path includes its leading '/', query excludes the '?'. The port is
+ * 0 if the url doesn't specify one. The brackets around an IPv6 address
+ * are not part of the host.
+ */
+struct URL
+{
+  URLSpan  scheme;
+  URLSpan  host;
+  uint16_t port;
+  URLSpan  path;
+  URLSpan  query;
+};
+
+/******************************************************************************
+ * FUNCTION DECLARATION
+ ******************************************************************************/
+
+/* Splits url without copying or allocating, returns false if it lacks a
+ * scheme or host or has an invalid port.
+ */
+bool url_parse(char const * url, URL & parsed);
+
+/* Case insensitive comparison, as used for schemes and hosts */
+bool url_equals(URLSpan const & span, char const * str);
+
+/* Copies span into buf as a null terminated string, returns false if it
+ * doesn't fit.
+ */
+bool url_copy(URLSpan const & span, char * buf, size_t const size);
+
+/* Copies the value of the Host header for url into buf, i.e. the host with
+ * an IPv6 address enclosed in brackets again, followed by the port if the
+ * url specifies one. Returns false if it doesn't fit.
+ */
+bool url_host_header(URL const & url, char * buf, size_t const size);
+
+#endif /* ARDUINO_AIOTC_UTILITY_URL_PARSER_H_ */
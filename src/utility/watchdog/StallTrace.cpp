@@ -0,0 +1,140 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include "StallTrace.h"
+
+#include <string.h>
+
+#include <AIoTC_Config.h>
+
+/******************************************************************************
+ * DEFINE
+ ******************************************************************************/
+
+#ifdef AIOT_CONFIG_STALL_TRACE_SECTION
+#define STALL_TRACE_ATTRIBUTE __attribute__((section(AIOT_CONFIG_STALL_TRACE_SECTION)))
+#else
+#define STALL_TRACE_ATTRIBUTE
+#endif
+
+/******************************************************************************
+ * CTOR/DTOR
+ ******************************************************************************/
+
+StallTrace::StallTrace(StallTraceRecord & record)
+: _record(record)
+, _report{""}
+{
+
+}
+
+/******************************************************************************
+ * PUBLIC MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool StallTrace::begin(bool const is_watchdog_reset)
+{
+  _report = "";
+  if (is_watchdog_reset && isValid() && _record.is_in_update)
+  {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "state:%u,phase:%u,at:%lu,hist:", _record.state, _record.phase, static_cast<unsigned long>(_record.enter_ms));
+    _report = buf;
+    bool is_first_row = true;
+    for (size_t s = 0; s < StallTraceRecord::STATE_CNT; s++)
+    {
+      uint16_t const * const row = _record.histogram[s];
+      bool is_empty = true;
+      for (size_t b = 0; b < StallTraceRecord::BUCKET_CNT; b++)
+        is_empty = is_empty && (row[b] == 0);
+      if (is_empty)
+        continue;
+
+      snprintf(buf, sizeof(buf), "%s%u=", is_first_row ? "" : ";", static_cast<unsigned int>(s));
+      _report += buf;
+      for (size_t b = 0; b < StallTraceRecord::BUCKET_CNT; b++)
+      {
+        snprintf(buf, sizeof(buf), "%s%u", (b == 0) ? "" : "/", static_cast<unsigned int>(row[b]));
+        _report += buf;
+      }
+      is_first_row = false;
+    }
+  }
+  reset();
+  return _report.length() > 0;
+}
+
+void StallTrace::enter(uint8_t const state)
+{
+  _record.state = state;
+  _record.phase = static_cast<uint8_t>(StallPhase::StateMachine);
+  _record.enter_ms = millis();
+  _record.is_in_update = 1;
+}
+
+void StallTrace::leave()
+{
+  _record.is_in_update = 0;
+  if (_record.state >= StallTraceRecord::STATE_CNT)
+    return;
+
+  uint16_t & cnt = _record.histogram[_record.state][bucket(millis() - _record.enter_ms)];
+  if (cnt < 0xFFFF)
+    cnt++;
+}
+
+size_t StallTrace::bucket(unsigned long const duration_ms)
+{
+  size_t b = 0;
+  for (unsigned long bound = 1; (b < (StallTraceRecord::BUCKET_CNT - 1)) && (duration_ms >= bound); bound *= 4)
+    b++;
+  return b;
+}
+
+/******************************************************************************
+ * PRIVATE MEMBER FUNCTIONS
+ ******************************************************************************/
+
+bool StallTrace::isValid() const
+{
+  return (_record.magic_number == MAGIC_NUMBER) && (_record.state < StallTraceRecord::STATE_CNT);
+}
+
+void StallTrace::reset()
+{
+  memset(&_record, 0, sizeof(_record));
+  _record.magic_number = MAGIC_NUMBER;
+}
+
+/******************************************************************************
+ * FUNCTION DEFINITION
+ ******************************************************************************/
+
+/* Not zeroed by the startup code within AIOT_CONFIG_STALL_TRACE_SECTION,
+ * the record is validated via the magic number instead.
+ */
+static StallTraceRecord stall_trace_record STALL_TRACE_ATTRIBUTE;
+
+StallTrace & stall_trace()
+{
+  static StallTrace trace(stall_trace_record);
+  return trace;
+}
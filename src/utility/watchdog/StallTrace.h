@@ -0,0 +1,109 @@
+/*
+   This file is part of ArduinoIoTCloud.
+
+   Copyright 2020 ARDUINO SA (http://www.arduino.cc/)
+
+   This software is released under the GNU General Public License version 3,
+   which covers the main part of arduino-cli.
+   The terms of this license can be found at:
+   https://www.gnu.org/licenses/gpl-3.0.en.html
+
+   You can be released from the requirements of the above licenses by purchasing
+   a commercial license. Buying such a license is mandatory if you want to modify or
+   otherwise use the software for commercial activities involving the Arduino
+   software without disclosing the source code of your own applications. To purchase
+   a commercial license, send an email to license@arduino.cc.
+*/
+
+#ifndef ARDUINO_AIOTC_UTILITY_STALL_TRACE_H_
+#define ARDUINO_AIOTC_UTILITY_STALL_TRACE_H_
+
+/******************************************************************************
+ * INCLUDE
+ ******************************************************************************/
+
+#include <Arduino.h>
+
+/******************************************************************************
+ * TYPEDEF
+ ******************************************************************************/
+
+/* Part of update() which is running, reported along with the state */
+enum class StallPhase : uint8_t
+{
+  StateMachine,
+  ScheduleTimer,
+  OfflineSamples,
+  MqttPoll,
+  OTAStart,
+  OTAPoll,
+  OTAHash
+};
+
+/* Kept in RAM which is not initialised at startup, so it survives a reset
+ * by the watchdog. Only valid if the magic number matches.
+ */
+struct StallTraceRecord
+{
+  static size_t const STATE_CNT  = 12;
+  static size_t const BUCKET_CNT = 8;
+
+  uint32_t magic_number;
+  uint8_t  state;
+  uint8_t  phase;
+  uint8_t  is_in_update;
+  uint32_t enter_ms;
+  /* Number of updates per state by duration, bucket i >= 4^(i-1) ms */
+  uint16_t histogram[STATE_CNT][BUCKET_CNT];
+};
+
+/******************************************************************************
+ * CLASS DECLARATION
+ ******************************************************************************/
+
+/* Leaves a breadcrumb of the state and the phase at each step of update().
+ * After a watchdog reset the record of the previous boot tells where it
+ * stalled and how long the updates in each state took until then.
+ */
+class StallTrace
+{
+public:
+
+  StallTrace(StallTraceRecord & record);
+
+  /* Takes over the record of the previous boot if it ended by a watchdog
+   * reset within update(), then starts a new one. Returns true if so.
+   */
+  bool begin(bool const is_watchdog_reset);
+  /* Report of the stall of the previous boot, empty if there was none:
+   * "state:<s>,phase:<p>,at:<ms since boot>,hist:<s>=<b0>/../<b7>;..."
+   */
+  inline String const & report() const { return _report; }
+
+  void enter(uint8_t const state);
+  inline void phase(StallPhase const phase) { _record.phase = static_cast<uint8_t>(phase); }
+  void leave();
+  /* An intended reset, e.g. to apply an update, is no stall */
+  inline void clear() { _record.is_in_update = 0; }
+
+  static size_t bucket(unsigned long const duration_ms);
+
+private:
+
+  static uint32_t const MAGIC_NUMBER = 0x53544C4C;
+
+  StallTraceRecord & _record;
+  String _report;
+
+  bool isValid() const;
+  void reset();
+};
+
+/******************************************************************************
+ * FUNCTION DECLARATION
+ ******************************************************************************/
+
+/* The instance kept in the RAM surviving a reset */
+StallTrace & stall_trace();
+
+#endif /* ARDUINO_AIOTC_UTILITY_STALL_TRACE_H_ */
@@ -34,12 +34,15 @@
 
 #ifdef ARDUINO_ARCH_MBED
 #  include <watchdog_api.h>
+#  include <reset_reason_api.h>
 #  define PORTENTA_H7_WATCHDOG_MAX_TIMEOUT_ms (32760)
 #  define NANO_RP2040_WATCHDOG_MAX_TIMEOUT_ms (8389)
 #endif /* ARDUINO_ARCH_MBED */
 
 #include <Arduino_ConnectionHandler.h>
 
+#include "StallTrace.h"
+
 /******************************************************************************
  * GLOBAL VARIABLES
  ******************************************************************************/
@@ -131,6 +134,11 @@ static void mbed_watchdog_enable_network_feed(const bool use_ethernet)
 
 void mbed_watchdog_trigger_reset()
 {
+#ifdef HAS_STALL_TRACE
+  /* This reset is intended, e.g. to apply an update */
+  stall_trace().clear();
+#endif
+
   watchdog_config_t cfg;
 #if defined(BOARD_STM32H7)
   cfg.timeout_ms = 1;
@@ -170,6 +178,30 @@ void watchdog_reset()
 #endif
 }
 
+unsigned long watchdog_timeout()
+{
+  if (!is_watchdog_enabled)
+    return 0;
+#ifdef ARDUINO_ARCH_SAMD
+  return SAMD_WATCHDOG_MAX_TIME_ms;
+#elif defined(BOARD_STM32H7)
+  return PORTENTA_H7_WATCHDOG_MAX_TIMEOUT_ms;
+#else
+  return NANO_RP2040_WATCHDOG_MAX_TIMEOUT_ms;
+#endif
+}
+
+bool watchdog_caused_reset()
+{
+#ifdef ARDUINO_ARCH_SAMD
+  return (PM->RCAUSE.reg & PM_RCAUSE_WDT) != 0;
+#elif DEVICE_RESET_REASON
+  return hal_reset_reason_get() == RESET_REASON_WATCHDOG;
+#else
+  return false;
+#endif
+}
+
 void watchdog_enable_network_feed(const bool use_ethernet)
 {
 #ifdef WIFI_HAS_FEED_WATCHDOG_FUNC
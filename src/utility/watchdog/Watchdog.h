@@ -25,6 +25,10 @@
 #if defined (ARDUINO_ARCH_SAMD) || defined (ARDUINO_ARCH_MBED)
 void watchdog_enable();
 void watchdog_reset();
+/* Timeout in ms within which the watchdog has to be fed, 0 if it is not enabled */
+unsigned long watchdog_timeout();
+/* Returns true if the last reset has been caused by the watchdog */
+bool watchdog_caused_reset();
 void watchdog_enable_network_feed(const bool use_ethernet);
 #endif /* (ARDUINO_ARCH_SAMD) || (ARDUINO_ARCH_MBED) */
 